@@ -57,6 +57,7 @@
 #include <rte_atomic.h>
 #include <rte_branch_prediction.h>
 #include <rte_string_fns.h>
+#include <rte_metrics.h>
 
 /* Maximum long option length for option parsing. */
 #define MAX_LONG_OPT_SZ 64
@@ -74,6 +75,10 @@ static uint32_t reset_stats;
 static uint32_t reset_xstats;
 /**< Enable memory info. */
 static uint32_t mem_info;
+/**< Enable metrics. */
+static uint32_t enable_metrics;
+/**< Display metrics as JSON. */
+static uint32_t metrics_json;
 
 /**< display usage */
 static void
@@ -86,7 +91,9 @@ proc_info_usage(const char *prgname)
 		"  --xstats: to display extended port statistics, disabled by "
 			"default\n"
 		"  --stats-reset: to reset port statistics\n"
-		"  --xstats-reset: to reset port extended statistics\n",
+		"  --xstats-reset: to reset port extended statistics\n"
+		"  --metrics: to display the metrics of the primary process\n"
+		"  --metrics-json: to display the metrics as a JSON object\n",
 		prgname);
 }
 
@@ -128,6 +135,8 @@ proc_info_parse_args(int argc, char **argv)
 		{"stats-reset", 0, NULL, 0},
 		{"xstats", 0, NULL, 0},
 		{"xstats-reset", 0, NULL, 0},
+		{"metrics", 0, NULL, 0},
+		{"metrics-json", 0, NULL, 0},
 		{NULL, 0, 0, 0}
 	};
 
@@ -167,6 +176,16 @@ proc_info_parse_args(int argc, char **argv)
 			else if (!strncmp(long_option[option_index].name, "xstats-reset",
 					MAX_LONG_OPT_SZ))
 				reset_xstats = 1;
+			/* Print metrics */
+			if (!strncmp(long_option[option_index].name, "metrics",
+					MAX_LONG_OPT_SZ))
+				enable_metrics = 1;
+			/* Print metrics as JSON */
+			else if (!strncmp(long_option[option_index].name,
+					"metrics-json", MAX_LONG_OPT_SZ)) {
+				enable_metrics = 1;
+				metrics_json = 1;
+			}
 			break;
 
 		default:
@@ -301,6 +320,50 @@ nic_xstats_clear(uint8_t port_id)
 	printf("\n  NIC extended statistics for port %d cleared\n", port_id);
 }
 
+static void
+metrics_display(void)
+{
+	struct rte_metric_name *names;
+	struct rte_metric_value *values;
+	int len, ret, i;
+	static const char *nic_stats_border = "########################";
+
+	ret = rte_metrics_init(rte_socket_id());
+	if (ret < 0) {
+		printf("Cannot get metrics: %s\n", strerror(-ret));
+		return;
+	}
+
+	if (metrics_json) {
+		rte_metrics_json_write(stdout);
+		return;
+	}
+
+	names = malloc(sizeof(names[0]) * RTE_METRICS_MAX_METRICS);
+	values = malloc(sizeof(values[0]) * RTE_METRICS_MAX_METRICS);
+	if (names == NULL || values == NULL) {
+		printf("Cannot allocate memory for metrics\n");
+		goto err;
+	}
+
+	/* the values are read last, there may be more than names */
+	len = rte_metrics_get_names(names, RTE_METRICS_MAX_METRICS);
+	ret = rte_metrics_get_values(values, RTE_METRICS_MAX_METRICS);
+	if (len < 0 || ret < len) {
+		printf("Cannot get metrics\n");
+		goto err;
+	}
+
+	printf("###### Metrics of the primary process ########\n");
+	printf("%s######################\n", nic_stats_border);
+	for (i = 0; i < len; i++)
+		printf("%s: %"PRIu64"\n", names[i].name, values[i].value);
+	printf("%s######################\n", nic_stats_border);
+err:
+	free(names);
+	free(values);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -342,6 +405,11 @@ main(int argc, char **argv)
 		return 0;
 	}
 
+	if (enable_metrics) {
+		metrics_display();
+		return 0;
+	}
+
 	nb_ports = rte_eth_dev_count();
 	if (nb_ports == 0)
 		rte_exit(EXIT_FAILURE, "No Ethernet ports - bye\n");
@@ -118,6 +118,27 @@ app_parse_port_mask(const char *arg)
 	return 0;
 }
 
+static int
+app_parse_iface_list(char *arg)
+{
+	char *iface, *save = NULL;
+
+	app.n_ports = 0;
+	for (iface = strtok_r(arg, ",", &save); iface != NULL;
+		iface = strtok_r(NULL, ",", &save)) {
+		if (app.n_ports >= APP_MAX_PORTS)
+			return -1;
+
+		app.ifaces[app.n_ports] = iface;
+		app.n_ports++;
+	}
+
+	if ((app.n_ports == 0) || !rte_is_power_of_2(app.n_ports))
+		return -2;
+
+	return 0;
+}
+
 struct {
 	const char *name;
 	uint32_t value;
@@ -148,6 +169,8 @@ struct {
 	{"hash-cuckoo-96", e_APP_PIPELINE_HASH_CUCKOO_KEY96},
 	{"hash-cuckoo-112", e_APP_PIPELINE_HASH_CUCKOO_KEY112},
 	{"hash-cuckoo-128", e_APP_PIPELINE_HASH_CUCKOO_KEY128},
+	{"port-af-packet", e_APP_PIPELINE_PORT_AF_PACKET},
+	{"port-shm", e_APP_PIPELINE_PORT_SHM},
 };
 
 int
@@ -184,6 +207,8 @@ app_parse_args(int argc, char **argv)
 		{"hash-cuckoo-96", 0, 0, 0},
 		{"hash-cuckoo-112", 0, 0, 0},
 		{"hash-cuckoo-128", 0, 0, 0},
+		{"port-af-packet", 0, 0, 0},
+		{"port-shm", 0, 0, 0},
 		{NULL, 0, 0, 0}
 	};
 	uint32_t lcores[3], n_lcores, lcore_id, pipeline_type_provided;
@@ -220,7 +245,7 @@ app_parse_args(int argc, char **argv)
 	app.pipeline_type = e_APP_PIPELINE_HASH_KEY16_LRU;
 	pipeline_type_provided = 0;
 
-	while ((opt = getopt_long(argc, argvopt, "p:",
+	while ((opt = getopt_long(argc, argvopt, "p:i:",
 			lgopts, &option_index)) != EOF) {
 		switch (opt) {
 		case 'p':
@@ -230,6 +255,13 @@ app_parse_args(int argc, char **argv)
 			}
 			break;
 
+		case 'i':
+			if (app_parse_iface_list(optarg) < 0) {
+				app_print_usage();
+				return -1;
+			}
+			break;
+
 		case 0: /* long options */
 			if (!pipeline_type_provided) {
 				uint32_t i;
@@ -255,6 +287,13 @@ app_parse_args(int argc, char **argv)
 		}
 	}
 
+	if ((app.pipeline_type == e_APP_PIPELINE_PORT_AF_PACKET) &&
+		(app.ifaces[0] == NULL)) {
+		RTE_LOG(ERR, USER1, "port-af-packet requires -i IFACE_LIST\n");
+		app_print_usage();
+		return -1;
+	}
+
 	if (optind >= 0)
 		argv[optind - 1] = prgname;
 
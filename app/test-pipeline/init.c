@@ -41,6 +41,7 @@
 #include <stdarg.h>
 #include <errno.h>
 #include <getopt.h>
+#include <fcntl.h>
 
 #include <rte_common.h>
 #include <rte_byteorder.h>
@@ -71,6 +72,7 @@
 #include <rte_tcp.h>
 #include <rte_lpm.h>
 #include <rte_lpm6.h>
+#include <rte_port_shm.h>
 
 #include "main.h"
 
@@ -80,6 +82,10 @@ struct app_params app = {
 	.port_rx_ring_size = 128,
 	.port_tx_ring_size = 512,
 
+	/* Shared memory files */
+	.shm_n_slots = 1024,
+	.shm_slot_size = 2048,
+
 	/* Rings */
 	.ring_rx_size = 128,
 	.ring_tx_size = 128,
@@ -269,12 +275,48 @@ app_init_ports(void)
 	app_ports_check_link();
 }
 
+static void
+app_init_shm(void)
+{
+	uint32_t i;
+
+	for (i = 0; i < app.n_ports; i++) {
+		struct rte_port_shm_writer_params params = {
+			.n_slots = app.shm_n_slots,
+			.slot_size = app.shm_slot_size,
+			.tx_burst_sz = app.burst_size_rx_write,
+		};
+		char name[64];
+		void *port;
+
+		snprintf(name, sizeof(name), "/dev/shm/app_shm_rx_%u", i);
+
+		app.shm_fd[i] = open(name, O_RDWR | O_CREAT | O_TRUNC, 0600);
+		if (app.shm_fd[i] < 0)
+			rte_panic("Cannot open %s (%s)\n", name, strerror(errno));
+
+		/* Initialize the ring before both of its ends start up */
+		params.fd = app.shm_fd[i];
+		port = rte_port_shm_writer_ops.f_create(&params,
+			rte_socket_id());
+		if (port == NULL)
+			rte_panic("Cannot initialize shared memory ring %u\n", i);
+		rte_port_shm_writer_ops.f_free(port);
+	}
+}
+
 void
 app_init(void)
 {
 	app_init_mbuf_pools();
 	app_init_rings();
-	app_init_ports();
+
+	/* The AF_PACKET ports use kernel interfaces instead of NIC ports */
+	if (app.pipeline_type != e_APP_PIPELINE_PORT_AF_PACKET)
+		app_init_ports();
+
+	if (app.pipeline_type == e_APP_PIPELINE_PORT_SHM)
+		app_init_shm();
 
 	RTE_LOG(INFO, USER1, "Initialization completed\n");
 }
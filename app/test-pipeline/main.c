@@ -119,6 +119,14 @@ app_lcore_main_loop(__attribute__((unused)) void *arg)
 			app_main_loop_rx();
 			return 0;
 
+		case e_APP_PIPELINE_PORT_AF_PACKET:
+			app_main_loop_rx_af_packet();
+			return 0;
+
+		case e_APP_PIPELINE_PORT_SHM:
+			app_main_loop_rx_shm();
+			return 0;
+
 		default:
 			app_main_loop_rx_metadata();
 			return 0;
@@ -128,6 +136,8 @@ app_lcore_main_loop(__attribute__((unused)) void *arg)
 	if (lcore == app.core_worker) {
 		switch (app.pipeline_type) {
 		case e_APP_PIPELINE_STUB:
+		case e_APP_PIPELINE_PORT_AF_PACKET:
+		case e_APP_PIPELINE_PORT_SHM:
 			app_main_loop_worker_pipeline_stub();
 			return 0;
 
@@ -180,8 +190,15 @@ app_lcore_main_loop(__attribute__((unused)) void *arg)
 	}
 
 	if (lcore == app.core_tx) {
-		app_main_loop_tx();
-		return 0;
+		switch (app.pipeline_type) {
+		case e_APP_PIPELINE_PORT_AF_PACKET:
+			app_main_loop_tx_af_packet();
+			return 0;
+
+		default:
+			app_main_loop_tx();
+			return 0;
+		}
 	}
 
 	return 0;
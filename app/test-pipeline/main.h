@@ -59,6 +59,14 @@ struct app_params {
 	uint32_t port_rx_ring_size;
 	uint32_t port_tx_ring_size;
 
+	/* Kernel interfaces (port-af-packet) */
+	const char *ifaces[APP_MAX_PORTS];
+
+	/* Shared memory files (port-shm) */
+	int shm_fd[APP_MAX_PORTS];
+	uint32_t shm_n_slots;
+	uint32_t shm_slot_size;
+
 	/* Rings */
 	struct rte_ring *rings_rx[APP_MAX_PORTS];
 	struct rte_ring *rings_tx[APP_MAX_PORTS];
@@ -126,11 +134,16 @@ enum {
 	e_APP_PIPELINE_HASH_CUCKOO_KEY96,
 	e_APP_PIPELINE_HASH_CUCKOO_KEY112,
 	e_APP_PIPELINE_HASH_CUCKOO_KEY128,
+
+	e_APP_PIPELINE_PORT_AF_PACKET,
+	e_APP_PIPELINE_PORT_SHM,
 	e_APP_PIPELINES
 };
 
 void app_main_loop_rx(void);
 void app_main_loop_rx_metadata(void);
+void app_main_loop_rx_af_packet(void);
+void app_main_loop_rx_shm(void);
 uint64_t test_hash(void *key, uint32_t key_size, uint64_t seed);
 
 void app_main_loop_worker(void);
@@ -141,6 +154,7 @@ void app_main_loop_worker_pipeline_lpm(void);
 void app_main_loop_worker_pipeline_lpm_ipv6(void);
 
 void app_main_loop_tx(void);
+void app_main_loop_tx_af_packet(void);
 
 #define APP_FLUSH 0
 #ifndef APP_FLUSH
@@ -37,6 +37,7 @@
 
 #include <rte_log.h>
 #include <rte_port_ring.h>
+#include <rte_port_shm.h>
 #include <rte_table_stub.h>
 #include <rte_pipeline.h>
 
@@ -69,6 +70,13 @@ app_main_loop_worker_pipeline_stub(void) {
 			.ring = app.rings_rx[i],
 		};
 
+		struct rte_port_shm_reader_params port_shm_params = {
+			.fd = app.shm_fd[i],
+			.n_slots = app.shm_n_slots,
+			.slot_size = app.shm_slot_size,
+			.mempool = app.pool,
+		};
+
 		struct rte_pipeline_port_in_params port_params = {
 			.ops = &rte_port_ring_reader_ops,
 			.arg_create = (void *) &port_ring_params,
@@ -77,6 +85,11 @@ app_main_loop_worker_pipeline_stub(void) {
 			.burst_size = app.burst_size_worker_read,
 		};
 
+		if (app.pipeline_type == e_APP_PIPELINE_PORT_SHM) {
+			port_params.ops = &rte_port_shm_reader_ops;
+			port_params.arg_create = (void *) &port_shm_params;
+		}
+
 		if (rte_pipeline_port_in_create(p, &port_params,
 			&port_in_id[i]))
 			rte_panic("Unable to configure input port for "
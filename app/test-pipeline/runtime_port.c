@@ -0,0 +1,198 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include <rte_log.h>
+#include <rte_debug.h>
+#include <rte_lcore.h>
+#include <rte_ethdev.h>
+#include <rte_ring.h>
+#include <rte_mbuf.h>
+#include <rte_port_shm.h>
+#ifdef RTE_EXEC_ENV_LINUXAPP
+#include <rte_port_af_packet.h>
+#endif
+
+#include "main.h"
+
+#define APP_AF_PACKET_BLOCK_SIZE                           (1 << 16)
+#define APP_AF_PACKET_N_BLOCKS                             64
+#define APP_AF_PACKET_FRAME_SIZE                           2048
+#define APP_AF_PACKET_N_FRAMES                             1024
+
+#ifdef RTE_EXEC_ENV_LINUXAPP
+
+void
+app_main_loop_rx_af_packet(void) {
+	void *ports[APP_MAX_PORTS];
+	uint32_t i;
+	int ret;
+
+	RTE_LOG(INFO, USER1, "Core %u is doing RX (AF_PACKET)\n",
+		rte_lcore_id());
+
+	for (i = 0; i < app.n_ports; i++) {
+		struct rte_port_af_packet_reader_params params = {
+			.iface = app.ifaces[i],
+			.block_size = APP_AF_PACKET_BLOCK_SIZE,
+			.n_blocks = APP_AF_PACKET_N_BLOCKS,
+			.frame_size = APP_AF_PACKET_FRAME_SIZE,
+			.block_timeout = 1,
+			.mempool = app.pool,
+		};
+
+		ports[i] = rte_port_af_packet_reader_ops.f_create(&params,
+			rte_socket_id());
+		if (ports[i] == NULL)
+			rte_panic("Cannot create AF_PACKET reader for %s\n",
+				app.ifaces[i]);
+	}
+
+	for (i = 0; ; i = ((i + 1) & (app.n_ports - 1))) {
+		int n_mbufs;
+
+		n_mbufs = rte_port_af_packet_reader_ops.f_rx(
+			ports[i],
+			app.mbuf_rx.array,
+			app.burst_size_rx_read);
+
+		if (n_mbufs <= 0)
+			continue;
+
+		do {
+			ret = rte_ring_sp_enqueue_bulk(
+				app.rings_rx[i],
+				(void **) app.mbuf_rx.array,
+				n_mbufs);
+		} while (ret < 0);
+	}
+}
+
+void
+app_main_loop_tx_af_packet(void) {
+	void *ports[APP_MAX_PORTS];
+	uint64_t pkts_mask;
+	uint32_t i;
+
+	RTE_LOG(INFO, USER1, "Core %u is doing TX (AF_PACKET)\n",
+		rte_lcore_id());
+
+	for (i = 0; i < app.n_ports; i++) {
+		struct rte_port_af_packet_writer_params params = {
+			.iface = app.ifaces[i],
+			.frame_size = APP_AF_PACKET_FRAME_SIZE,
+			.n_frames = APP_AF_PACKET_N_FRAMES,
+			.tx_burst_sz = app.burst_size_tx_write,
+		};
+
+		ports[i] = rte_port_af_packet_writer_ops.f_create(&params,
+			rte_socket_id());
+		if (ports[i] == NULL)
+			rte_panic("Cannot create AF_PACKET writer for %s\n",
+				app.ifaces[i]);
+	}
+
+	pkts_mask = RTE_LEN2MASK(app.burst_size_tx_read, uint64_t);
+
+	for (i = 0; ; i = ((i + 1) & (app.n_ports - 1))) {
+		int ret;
+
+		ret = rte_ring_sc_dequeue_bulk(
+			app.rings_tx[i],
+			(void **) app.mbuf_tx[i].array,
+			app.burst_size_tx_read);
+
+		if (ret == -ENOENT)
+			continue;
+
+		rte_port_af_packet_writer_ops.f_tx_bulk(ports[i],
+			app.mbuf_tx[i].array, pkts_mask);
+	}
+}
+
+#else
+
+void
+app_main_loop_rx_af_packet(void) {
+	rte_exit(EXIT_FAILURE, "AF_PACKET ports not present in build\n");
+}
+
+void
+app_main_loop_tx_af_packet(void) {
+	rte_exit(EXIT_FAILURE, "AF_PACKET ports not present in build\n");
+}
+
+#endif
+
+void
+app_main_loop_rx_shm(void) {
+	void *ports[APP_MAX_PORTS];
+	uint32_t i;
+
+	RTE_LOG(INFO, USER1, "Core %u is doing RX (shared memory)\n",
+		rte_lcore_id());
+
+	for (i = 0; i < app.n_ports; i++) {
+		struct rte_port_shm_writer_params params = {
+			.fd = app.shm_fd[i],
+			.n_slots = app.shm_n_slots,
+			.slot_size = app.shm_slot_size,
+			.tx_burst_sz = app.burst_size_rx_write,
+		};
+
+		ports[i] = rte_port_shm_writer_ops.f_create(&params,
+			rte_socket_id());
+		if (ports[i] == NULL)
+			rte_panic("Cannot create shared memory writer %u\n", i);
+	}
+
+	for (i = 0; ; i = ((i + 1) & (app.n_ports - 1))) {
+		uint16_t n_mbufs;
+
+		n_mbufs = rte_eth_rx_burst(
+			app.ports[i],
+			0,
+			app.mbuf_rx.array,
+			app.burst_size_rx_read);
+
+		if (n_mbufs == 0)
+			continue;
+
+		rte_port_shm_writer_ops.f_tx_bulk(ports[i], app.mbuf_rx.array,
+			RTE_LEN2MASK(n_mbufs, uint64_t));
+	}
+}
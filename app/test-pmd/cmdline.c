@@ -396,6 +396,22 @@ static void cmd_help_long_parsed(void *parsed_result,
 			"tso show (portid)"
 			"    Display the status of TCP Segmentation Offload.\n\n"
 
+#ifdef RTE_LIBRTE_GRO
+			"gro (on|off) (port_id)\n"
+			"    Enable or disable Generic Receive Offload on the"
+			" RX queues of a port.\n\n"
+
+			"gro set (max_flow_num) (max_item_per_flow) (port_id)\n"
+			"    Set the size of the GRO contexts.\n\n"
+
+			"gro flush (timeout_us) (port_id)\n"
+			"    Keep the merged packets in a per queue context"
+			" for timeout_us, or merge each burst only with 0.\n\n"
+
+			"gro show (port_id)\n"
+			"    Display the GRO configuration.\n\n"
+#endif
+
 			"set fwd (%s)\n"
 			"    Set packet forwarding mode.\n\n"
 
@@ -3781,6 +3797,148 @@ cmdline_parse_inst_t cmd_tunnel_tso_show = {
 	},
 };
 
+#ifdef RTE_LIBRTE_GRO
+/* *** ENABLE/DISABLE GENERIC RECEIVE OFFLOAD *** */
+struct cmd_gro_result {
+	cmdline_fixed_string_t gro;
+	cmdline_fixed_string_t mode;
+	uint8_t port_id;
+};
+
+static void
+cmd_gro_parsed(void *parsed_result,
+	       __attribute__((unused)) struct cmdline *cl,
+	       __attribute__((unused)) void *data)
+{
+	struct cmd_gro_result *res = parsed_result;
+
+	if (!strcmp(res->mode, "show"))
+		show_gro(res->port_id);
+	else
+		setup_gro(res->mode, res->port_id);
+}
+
+cmdline_parse_token_string_t cmd_gro_gro =
+	TOKEN_STRING_INITIALIZER(struct cmd_gro_result,
+				gro, "gro");
+cmdline_parse_token_string_t cmd_gro_mode =
+	TOKEN_STRING_INITIALIZER(struct cmd_gro_result,
+				mode, "on#off#show");
+cmdline_parse_token_num_t cmd_gro_portid =
+	TOKEN_NUM_INITIALIZER(struct cmd_gro_result,
+				port_id, UINT8);
+
+cmdline_parse_inst_t cmd_gro = {
+	.f = cmd_gro_parsed,
+	.data = NULL,
+	.help_str = "gro on|off|show <port_id>: "
+		"Enable, disable or show GRO on the RX queues of a port",
+	.tokens = {
+		(void *)&cmd_gro_gro,
+		(void *)&cmd_gro_mode,
+		(void *)&cmd_gro_portid,
+		NULL,
+	},
+};
+
+/* *** SET GRO CONTEXT SIZE *** */
+struct cmd_gro_set_result {
+	cmdline_fixed_string_t gro;
+	cmdline_fixed_string_t mode;
+	uint16_t max_flow_num;
+	uint16_t max_item_per_flow;
+	uint8_t port_id;
+};
+
+static void
+cmd_gro_set_parsed(void *parsed_result,
+		   __attribute__((unused)) struct cmdline *cl,
+		   __attribute__((unused)) void *data)
+{
+	struct cmd_gro_set_result *res = parsed_result;
+
+	setup_gro_param(res->max_flow_num, res->max_item_per_flow,
+			res->port_id);
+}
+
+cmdline_parse_token_string_t cmd_gro_set_gro =
+	TOKEN_STRING_INITIALIZER(struct cmd_gro_set_result,
+				gro, "gro");
+cmdline_parse_token_string_t cmd_gro_set_mode =
+	TOKEN_STRING_INITIALIZER(struct cmd_gro_set_result,
+				mode, "set");
+cmdline_parse_token_num_t cmd_gro_set_max_flow_num =
+	TOKEN_NUM_INITIALIZER(struct cmd_gro_set_result,
+				max_flow_num, UINT16);
+cmdline_parse_token_num_t cmd_gro_set_max_item_per_flow =
+	TOKEN_NUM_INITIALIZER(struct cmd_gro_set_result,
+				max_item_per_flow, UINT16);
+cmdline_parse_token_num_t cmd_gro_set_portid =
+	TOKEN_NUM_INITIALIZER(struct cmd_gro_set_result,
+				port_id, UINT8);
+
+cmdline_parse_inst_t cmd_gro_set = {
+	.f = cmd_gro_set_parsed,
+	.data = NULL,
+	.help_str = "gro set <max_flow_num> <max_item_per_flow> <port_id>: "
+		"Set the size of the GRO contexts of a port",
+	.tokens = {
+		(void *)&cmd_gro_set_gro,
+		(void *)&cmd_gro_set_mode,
+		(void *)&cmd_gro_set_max_flow_num,
+		(void *)&cmd_gro_set_max_item_per_flow,
+		(void *)&cmd_gro_set_portid,
+		NULL,
+	},
+};
+
+/* *** SET GRO FLUSH TIMEOUT *** */
+struct cmd_gro_flush_result {
+	cmdline_fixed_string_t gro;
+	cmdline_fixed_string_t mode;
+	uint32_t timeout_us;
+	uint8_t port_id;
+};
+
+static void
+cmd_gro_flush_parsed(void *parsed_result,
+		     __attribute__((unused)) struct cmdline *cl,
+		     __attribute__((unused)) void *data)
+{
+	struct cmd_gro_flush_result *res = parsed_result;
+
+	setup_gro_flush(res->timeout_us, res->port_id);
+}
+
+cmdline_parse_token_string_t cmd_gro_flush_gro =
+	TOKEN_STRING_INITIALIZER(struct cmd_gro_flush_result,
+				gro, "gro");
+cmdline_parse_token_string_t cmd_gro_flush_mode =
+	TOKEN_STRING_INITIALIZER(struct cmd_gro_flush_result,
+				mode, "flush");
+cmdline_parse_token_num_t cmd_gro_flush_timeout_us =
+	TOKEN_NUM_INITIALIZER(struct cmd_gro_flush_result,
+				timeout_us, UINT32);
+cmdline_parse_token_num_t cmd_gro_flush_portid =
+	TOKEN_NUM_INITIALIZER(struct cmd_gro_flush_result,
+				port_id, UINT8);
+
+cmdline_parse_inst_t cmd_gro_flush = {
+	.f = cmd_gro_flush_parsed,
+	.data = NULL,
+	.help_str = "gro flush <timeout_us> <port_id>: "
+		"Hold the merged packets for timeout_us in per queue contexts "
+		"(0 to merge each burst only)",
+	.tokens = {
+		(void *)&cmd_gro_flush_gro,
+		(void *)&cmd_gro_flush_mode,
+		(void *)&cmd_gro_flush_timeout_us,
+		(void *)&cmd_gro_flush_portid,
+		NULL,
+	},
+};
+#endif /* RTE_LIBRTE_GRO */
+
 /* *** ENABLE/DISABLE FLUSH ON RX STREAMS *** */
 struct cmd_set_flush_rx {
 	cmdline_fixed_string_t set;
@@ -12451,6 +12609,11 @@ cmdline_parse_ctx_t main_ctx[] = {
 	(cmdline_parse_inst_t *)&cmd_tso_show,
 	(cmdline_parse_inst_t *)&cmd_tunnel_tso_set,
 	(cmdline_parse_inst_t *)&cmd_tunnel_tso_show,
+#ifdef RTE_LIBRTE_GRO
+	(cmdline_parse_inst_t *)&cmd_gro,
+	(cmdline_parse_inst_t *)&cmd_gro_set,
+	(cmdline_parse_inst_t *)&cmd_gro_flush,
+#endif
 	(cmdline_parse_inst_t *)&cmd_link_flow_control_set,
 	(cmdline_parse_inst_t *)&cmd_link_flow_control_set_rx,
 	(cmdline_parse_inst_t *)&cmd_link_flow_control_set_tx,
@@ -85,6 +85,7 @@
 #include <rte_atomic.h>
 #include <rte_branch_prediction.h>
 #include <rte_mempool.h>
+#include <rte_malloc.h>
 #include <rte_mbuf.h>
 #include <rte_interrupts.h>
 #include <rte_pci.h>
@@ -97,6 +98,9 @@
 #ifdef RTE_LIBRTE_IXGBE_PMD
 #include <rte_pmd_ixgbe.h>
 #endif
+#ifdef RTE_LIBRTE_GRO
+#include <rte_gro.h>
+#endif
 
 #include "testpmd.h"
 
@@ -2504,6 +2508,181 @@ tx_vlan_pvid_set(portid_t port_id, uint16_t vlan_id, int on)
 	rte_eth_dev_set_vlan_pvid(port_id, vlan_id, on);
 }
 
+#ifdef RTE_LIBRTE_GRO
+#define GRO_DEFAULT_FLOW_NUM 64
+#define GRO_DEFAULT_ITEM_PER_FLOW 32
+
+/* GRO state of a port, run from RX callbacks on each of its queues */
+struct gro_status {
+	struct rte_gro_param param;
+	uint32_t flush_us; /**< Heavyweight mode timeout, 0 for per-burst. */
+	uint16_t nb_queues; /**< Queues with a callback, 0 if disabled. */
+	struct rte_eth_rxtx_callback **cbs;
+	struct rte_gro_ctx **ctxs;
+};
+
+static struct gro_status gro_ports[RTE_MAX_ETHPORTS];
+
+static struct gro_status *
+gro_status_get(portid_t port_id)
+{
+	struct gro_status *gro = &gro_ports[port_id];
+
+	if (gro->param.gro_types == 0) {
+		gro->param.gro_types = RTE_GRO_TCP_IPV4 |
+			RTE_GRO_IPV4_VXLAN_TCP_IPV4;
+		gro->param.max_flow_num = GRO_DEFAULT_FLOW_NUM;
+		gro->param.max_item_per_flow = GRO_DEFAULT_ITEM_PER_FLOW;
+	}
+	return gro;
+}
+
+static void
+gro_disable(portid_t port_id, struct gro_status *gro)
+{
+	uint16_t q;
+
+	for (q = 0; q < gro->nb_queues; q++) {
+		if (gro->cbs[q] != NULL &&
+		    rte_eth_remove_rx_callback(port_id, q, gro->cbs[q]) == 0)
+			rte_free(gro->cbs[q]);
+		/* packets still held are freed */
+		rte_gro_ctx_destroy(gro->ctxs[q]);
+	}
+	rte_free(gro->cbs);
+	rte_free(gro->ctxs);
+	gro->cbs = NULL;
+	gro->ctxs = NULL;
+	gro->nb_queues = 0;
+}
+
+static int
+gro_enable(portid_t port_id, struct gro_status *gro)
+{
+	uint16_t q;
+
+	gro->cbs = rte_zmalloc("testpmd: gro", nb_rxq * sizeof(*gro->cbs), 0);
+	gro->ctxs = rte_zmalloc("testpmd: gro", nb_rxq * sizeof(*gro->ctxs), 0);
+	if (gro->cbs == NULL || gro->ctxs == NULL) {
+		printf("Cannot allocate GRO state of port %u\n", port_id);
+		gro_disable(port_id, gro);
+		return -1;
+	}
+
+	gro->nb_queues = nb_rxq;
+	gro->param.socket_id = ports[port_id].socket_id;
+	gro->param.timeout_cycles = (uint64_t)gro->flush_us *
+		rte_get_tsc_hz() / US_PER_S;
+	for (q = 0; q < nb_rxq; q++) {
+		if (gro->flush_us == 0) {
+			gro->cbs[q] = rte_eth_add_rx_callback(port_id, q,
+				rte_gro_rx_burst_cb, &gro->param);
+		} else {
+			gro->ctxs[q] = rte_gro_ctx_create(&gro->param);
+			if (gro->ctxs[q] == NULL) {
+				printf("Cannot create GRO context of port %u "
+				       "queue %u: %s\n", port_id, q,
+				       rte_strerror(rte_errno));
+				gro_disable(port_id, gro);
+				return -1;
+			}
+			gro->cbs[q] = rte_eth_add_rx_callback(port_id, q,
+				rte_gro_rx_ctx_cb, gro->ctxs[q]);
+		}
+		if (gro->cbs[q] == NULL) {
+			printf("Cannot add GRO callback to port %u queue %u\n",
+			       port_id, q);
+			gro_disable(port_id, gro);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+void
+setup_gro(const char *onoff, portid_t port_id)
+{
+	struct gro_status *gro;
+
+	if (port_id_is_invalid(port_id, ENABLED_WARN))
+		return;
+	if (test_done == 0) {
+		printf("Please stop forwarding first\n");
+		return;
+	}
+
+	gro = gro_status_get(port_id);
+	if (strcmp(onoff, "on") == 0) {
+		if (gro->nb_queues != 0) {
+			printf("GRO is already enabled on port %u\n", port_id);
+			return;
+		}
+		if (gro_enable(port_id, gro) == 0)
+			show_gro(port_id);
+	} else if (gro->nb_queues != 0) {
+		gro_disable(port_id, gro);
+		printf("GRO is disabled on port %u\n", port_id);
+	}
+}
+
+void
+setup_gro_param(uint16_t max_flow_num, uint16_t max_item_per_flow,
+		portid_t port_id)
+{
+	struct gro_status *gro;
+
+	if (port_id_is_invalid(port_id, ENABLED_WARN))
+		return;
+	if (max_flow_num == 0 || max_item_per_flow == 0) {
+		printf("Invalid GRO flow or item number\n");
+		return;
+	}
+
+	gro = gro_status_get(port_id);
+	if (gro->nb_queues != 0) {
+		printf("Please disable GRO on port %u first\n", port_id);
+		return;
+	}
+	gro->param.max_flow_num = max_flow_num;
+	gro->param.max_item_per_flow = max_item_per_flow;
+}
+
+void
+setup_gro_flush(uint32_t timeout_us, portid_t port_id)
+{
+	struct gro_status *gro;
+
+	if (port_id_is_invalid(port_id, ENABLED_WARN))
+		return;
+
+	gro = gro_status_get(port_id);
+	if (gro->nb_queues != 0) {
+		printf("Please disable GRO on port %u first\n", port_id);
+		return;
+	}
+	gro->flush_us = timeout_us;
+}
+
+void
+show_gro(portid_t port_id)
+{
+	struct gro_status *gro;
+
+	if (port_id_is_invalid(port_id, ENABLED_WARN))
+		return;
+
+	gro = gro_status_get(port_id);
+	printf("GRO on port %u: %s\n", port_id,
+	       gro->nb_queues != 0 ? "enabled" : "disabled");
+	if (gro->flush_us == 0)
+		printf("  mode: per burst\n");
+	else
+		printf("  mode: per queue context, flushed after %u us, "
+		       "max %u flows, %u packets per flow\n", gro->flush_us,
+		       gro->param.max_flow_num, gro->param.max_item_per_flow);
+}
+#endif /* RTE_LIBRTE_GRO */
+
 void
 set_qmap(portid_t port_id, uint8_t is_rx, uint16_t queue_id, uint8_t map_value)
 {
@@ -562,6 +562,12 @@ void tx_vlan_pvid_set(portid_t port_id, uint16_t vlan_id, int on);
 
 void set_qmap(portid_t port_id, uint8_t is_rx, uint16_t queue_id, uint8_t map_value);
 
+void setup_gro(const char *onoff, portid_t port_id);
+void setup_gro_param(uint16_t max_flow_num, uint16_t max_item_per_flow,
+		     portid_t port_id);
+void setup_gro_flush(uint32_t timeout_us, portid_t port_id);
+void show_gro(portid_t port_id);
+
 void set_verbose_level(uint16_t vb_level);
 void set_tx_pkt_segments(unsigned *seg_lengths, unsigned nb_segs);
 void show_tx_pkt_segments(void);
@@ -123,6 +123,30 @@ def per_sockets(num):
                 "Func":    logs_autotest,
                 "Report":  None,
             },
+            {
+                "Name":    "Service cores autotest",
+                "Command": "service_autotest",
+                "Func":    default_autotest,
+                "Report":  None,
+            },
+            {
+                "Name":    "Trace autotest",
+                "Command": "trace_autotest",
+                "Func":    default_autotest,
+                "Report":  None,
+            },
+            {
+                "Name":    "Metrics autotest",
+                "Command": "metrics_autotest",
+                "Func":    default_autotest,
+                "Report":  None,
+            },
+            {
+                "Name":    "GRO autotest",
+                "Command": "gro_autotest",
+                "Func":    default_autotest,
+                "Report":  None,
+            },
             {
                 "Name":    "CPU flags autotest",
                 "Command": "cpuflags_autotest",
@@ -673,6 +673,49 @@ test_master_lcore_flag(void)
 	return 0;
 }
 
+/*
+ * Test -s option, giving the service cores
+ */
+static int
+test_service_coremask_flag(void)
+{
+#ifdef RTE_EXEC_ENV_BSDAPP
+	/* BSD target doesn't support prefixes at this point */
+	const char *prefix = "";
+#else
+	char prefix[PATH_MAX], tmp[PATH_MAX];
+	if (get_current_prefix(tmp, sizeof(tmp)) == NULL) {
+		printf("Error - unable to get current prefix!\n");
+		return -1;
+	}
+	snprintf(prefix, sizeof(prefix), "--file-prefix=%s", tmp);
+#endif
+
+	/* -s flag but no value */
+	const char *argv1[] = { prgname, prefix, mp_flag, "-n", "1", "-c", "3", "-s"};
+	/* -s flag with invalid value */
+	const char *argv2[] = { prgname, prefix, mp_flag, "-n", "1", "-c", "3", "-s", "X"};
+	/* master lcore as service core */
+	const char *argv3[] = { prgname, prefix, mp_flag, "-n", "1", "-c", "3", "--master-lcore", "0", "-s", "1"};
+	/* valid value */
+	const char *argv4[] = { prgname, prefix, mp_flag, "-n", "1", "-c", "3", "-s", "2"};
+	/* valid value, service core not in coremask */
+	const char *argv5[] = { prgname, prefix, mp_flag, "-n", "1", "-c", "1", "-s", "2"};
+
+	if (launch_proc(argv1) == 0
+			|| launch_proc(argv2) == 0
+			|| launch_proc(argv3) == 0) {
+		printf("Error - process ran without error with wrong -s\n");
+		return -1;
+	}
+	if (launch_proc(argv4) != 0
+			|| launch_proc(argv5) != 0) {
+		printf("Error - process did not run ok with valid -s\n");
+		return -1;
+	}
+	return 0;
+}
+
 /*
  * Test that the app doesn't run with invalid -n flag option.
  * Final test ensures it does run with valid options as sanity check
@@ -758,8 +801,8 @@ test_no_hpet_flag(void)
 }
 
 /*
- * Test that the app runs with --no-huge and doesn't run when --socket-mem are
- * specified with --no-huge.
+ * Test that the app runs with --no-huge, also with --socket-mem, and doesn't
+ * run when -m and --socket-mem are both specified with --no-huge.
  */
 static int
 test_no_huge_flag(void)
@@ -797,9 +840,9 @@ test_no_huge_flag(void)
 	return 0;
 #endif
 
-	if (launch_proc(argv3) == 0) {
-		printf("Error - process run ok with --no-huge and --socket-mem "
-				"flags\n");
+	if (launch_proc(argv3) != 0) {
+		printf("Error - process did not run ok with --no-huge and "
+				"--socket-mem flags\n");
 		return -1;
 	}
 	if (launch_proc(argv4) == 0) {
@@ -988,6 +1031,14 @@ test_misc_flags(void)
 	const char *argv15[] = {prgname, "--file-prefix=intr",
 			"-c", "1", "-n", "2", "--vfio-intr=invalid"};
 
+	/* try running with --iova-mode PA flag */
+	const char *argv16[] = {prgname, "--file-prefix=iova",
+			"-c", "1", "-n", "2", "--iova-mode=pa"};
+
+	/* try running with --iova-mode invalid flag */
+	const char *argv17[] = {prgname, "--file-prefix=iova",
+			"-c", "1", "-n", "2", "--iova-mode=invalid"};
+
 
 	if (launch_proc(argv0) == 0) {
 		printf("Error - process ran ok with invalid flag\n");
@@ -1060,6 +1111,16 @@ test_misc_flags(void)
 				"--vfio-intr invalid parameter\n");
 		return -1;
 	}
+	if (launch_proc(argv16) != 0) {
+		printf("Error - process did not run ok with "
+				"--iova-mode PA parameter\n");
+		return -1;
+	}
+	if (launch_proc(argv17) == 0) {
+		printf("Error - process run ok with "
+				"--iova-mode invalid parameter\n");
+		return -1;
+	}
 	return 0;
 }
 #endif
@@ -1373,6 +1434,12 @@ test_eal_flags(void)
 		return ret;
 	}
 
+	ret = test_service_coremask_flag();
+	if (ret < 0) {
+		printf("Error in test_service_coremask_flag()\n");
+		return ret;
+	}
+
 	ret = test_invalid_n_flag();
 	if (ret < 0) {
 		printf("Error in test_invalid_n_flag()\n");
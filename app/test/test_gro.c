@@ -0,0 +1,390 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_lcore.h>
+#include <rte_mbuf.h>
+#include <rte_ether.h>
+#include <rte_ip.h>
+#include <rte_tcp.h>
+#include <rte_udp.h>
+#include <rte_gro.h>
+
+#include "test.h"
+
+#define GRO_NB_MBUFS 1023
+#define GRO_PAYLOAD_LEN 100
+#define GRO_NB_SEGS 8
+#define GRO_VXLAN_HDR_LEN (sizeof(struct ipv4_hdr) + \
+	sizeof(struct udp_hdr) + sizeof(struct vxlan_hdr) + \
+	sizeof(struct ether_hdr))
+
+#define TCP_ACK_FLAG 0x10
+#define TCP_PSH_FLAG 0x08
+#define TCP_SYN_FLAG 0x02
+
+static struct rte_mempool *pkt_pool;
+
+static const struct rte_gro_param burst_param = {
+	.gro_types = RTE_GRO_TCP_IPV4 | RTE_GRO_IPV4_VXLAN_TCP_IPV4,
+};
+
+static int
+testsuite_setup(void)
+{
+	pkt_pool = rte_pktmbuf_pool_create("GRO_TEST_POOL", GRO_NB_MBUFS, 0,
+		0, RTE_MBUF_DEFAULT_BUF_SIZE, rte_socket_id());
+	return pkt_pool == NULL ? TEST_FAILED : TEST_SUCCESS;
+}
+
+static void
+testsuite_teardown(void)
+{
+	rte_mempool_free(pkt_pool);
+	pkt_pool = NULL;
+}
+
+static void
+fill_ipv4(struct ipv4_hdr *ip, uint16_t len, uint16_t id, uint8_t proto)
+{
+	memset(ip, 0, sizeof(*ip));
+	ip->version_ihl = 0x45;
+	ip->total_length = rte_cpu_to_be_16(len);
+	ip->packet_id = rte_cpu_to_be_16(id);
+	ip->time_to_live = 64;
+	ip->next_proto_id = proto;
+	ip->src_addr = rte_cpu_to_be_32(IPv4(10, 0, 0, 1));
+	ip->dst_addr = rte_cpu_to_be_32(IPv4(10, 0, 0, 2));
+	ip->hdr_checksum = rte_ipv4_cksum(ip);
+}
+
+/*
+ * Build the i-th TCP segment of a flow, with its payload bytes numbered
+ * from the sequence number, in VXLAN if vxlan is set.
+ */
+static struct rte_mbuf *
+build_seg(uint16_t i, uint8_t tcp_flags, uint16_t src_port, int vxlan)
+{
+	uint32_t seq = 1000 + i * GRO_PAYLOAD_LEN;
+	struct rte_mbuf *m;
+	struct ether_hdr *eth;
+	struct ipv4_hdr *ip;
+	struct udp_hdr *udp;
+	struct vxlan_hdr *vx;
+	struct tcp_hdr *tcp;
+	uint16_t inner_len;
+	uint8_t *p;
+	char *data;
+	unsigned int k;
+
+	m = rte_pktmbuf_alloc(pkt_pool);
+	if (m == NULL)
+		return NULL;
+	inner_len = sizeof(*ip) + sizeof(*tcp) + GRO_PAYLOAD_LEN;
+	data = rte_pktmbuf_append(m, sizeof(*eth) + inner_len +
+		(vxlan ? GRO_VXLAN_HDR_LEN : 0));
+	if (data == NULL) {
+		rte_pktmbuf_free(m);
+		return NULL;
+	}
+
+	eth = (struct ether_hdr *)data;
+	memset(eth, 0, sizeof(*eth));
+	eth->d_addr.addr_bytes[0] = 2;
+	eth->ether_type = rte_cpu_to_be_16(ETHER_TYPE_IPv4);
+	ip = (struct ipv4_hdr *)(eth + 1);
+
+	if (vxlan) {
+		fill_ipv4(ip, GRO_VXLAN_HDR_LEN + inner_len, 500 + i,
+			IPPROTO_UDP);
+		udp = (struct udp_hdr *)(data + sizeof(*eth) + sizeof(*ip));
+		udp->src_port = rte_cpu_to_be_16(src_port);
+		udp->dst_port = rte_cpu_to_be_16(RTE_GRO_VXLAN_DEFAULT_PORT);
+		udp->dgram_len = rte_cpu_to_be_16(GRO_VXLAN_HDR_LEN -
+			sizeof(*ip) + inner_len);
+		udp->dgram_cksum = 0;
+		vx = (struct vxlan_hdr *)((char *)udp + sizeof(*udp));
+		vx->vx_flags = rte_cpu_to_be_32(0x08000000);
+		vx->vx_vni = rte_cpu_to_be_32(42 << 8);
+		data += GRO_VXLAN_HDR_LEN;
+		eth = (struct ether_hdr *)data;
+		memset(eth, 0, sizeof(*eth));
+		eth->ether_type = rte_cpu_to_be_16(ETHER_TYPE_IPv4);
+		ip = (struct ipv4_hdr *)(data + sizeof(*eth));
+		src_port = 80;
+	}
+
+	fill_ipv4(ip, inner_len, 100 + i, IPPROTO_TCP);
+	tcp = (struct tcp_hdr *)(ip + 1);
+	memset(tcp, 0, sizeof(*tcp));
+	tcp->src_port = rte_cpu_to_be_16(src_port);
+	tcp->dst_port = rte_cpu_to_be_16(5000);
+	tcp->sent_seq = rte_cpu_to_be_32(seq);
+	tcp->recv_ack = rte_cpu_to_be_32(1);
+	tcp->data_off = sizeof(*tcp) << 2;
+	tcp->tcp_flags = tcp_flags;
+
+	p = (uint8_t *)(tcp + 1);
+	for (k = 0; k < GRO_PAYLOAD_LEN; k++)
+		p[k] = (uint8_t)(seq + k);
+
+	return m;
+}
+
+static void
+free_pkts(struct rte_mbuf **pkts, uint16_t nb)
+{
+	uint16_t i;
+
+	for (i = 0; i < nb; i++)
+		rte_pktmbuf_free(pkts[i]);
+}
+
+/* Check a merged packet of nb_segs segments starting with segment first */
+static int
+check_merged(struct rte_mbuf *m, uint16_t first, uint16_t nb_segs, int vxlan)
+{
+	uint32_t hdr_len, off, seq = 1000 + first * GRO_PAYLOAD_LEN;
+	struct ipv4_hdr *ip;
+	struct rte_mbuf *seg;
+	uint8_t *p;
+	uint32_t k = 0, j;
+
+	hdr_len = sizeof(struct ether_hdr) + sizeof(struct ipv4_hdr) +
+		sizeof(struct tcp_hdr) + (vxlan ? GRO_VXLAN_HDR_LEN : 0);
+	TEST_ASSERT_EQUAL(m->nb_segs, nb_segs, "wrong number of segments");
+	TEST_ASSERT_EQUAL(m->pkt_len, hdr_len + nb_segs * GRO_PAYLOAD_LEN,
+		"wrong packet length");
+	TEST_ASSERT_EQUAL(m->l4_len, sizeof(struct tcp_hdr),
+		"wrong l4_len");
+
+	ip = rte_pktmbuf_mtod_offset(m, struct ipv4_hdr *,
+		sizeof(struct ether_hdr));
+	TEST_ASSERT_EQUAL(rte_be_to_cpu_16(ip->total_length),
+		m->pkt_len - sizeof(struct ether_hdr),
+		"wrong IPv4 total length");
+	TEST_ASSERT_EQUAL(rte_raw_cksum(ip, sizeof(*ip)), 0xffff,
+		"wrong IPv4 checksum");
+	if (vxlan) {
+		TEST_ASSERT_EQUAL(m->outer_l3_len, sizeof(struct ipv4_hdr),
+			"wrong outer_l3_len");
+		ip = rte_pktmbuf_mtod_offset(m, struct ipv4_hdr *,
+			sizeof(struct ether_hdr) + GRO_VXLAN_HDR_LEN);
+		TEST_ASSERT_EQUAL(rte_be_to_cpu_16(ip->total_length),
+			m->pkt_len - sizeof(struct ether_hdr) -
+			GRO_VXLAN_HDR_LEN, "wrong inner IPv4 total length");
+		TEST_ASSERT_EQUAL(rte_raw_cksum(ip, sizeof(*ip)), 0xffff,
+			"wrong inner IPv4 checksum");
+	}
+
+	/* the payload must be in sequence */
+	off = hdr_len;
+	for (seg = m; seg != NULL; seg = seg->next, off = 0) {
+		p = rte_pktmbuf_mtod(seg, uint8_t *);
+		for (j = off; j < seg->data_len; j++, k++)
+			TEST_ASSERT_EQUAL(p[j], (uint8_t)(seq + k),
+				"wrong payload byte %u", k);
+	}
+
+	return TEST_SUCCESS;
+}
+
+static int
+gro_burst_tcp4(void)
+{
+	struct rte_mbuf *pkts[GRO_NB_SEGS + 2];
+	uint16_t i, nb;
+
+	/* a flow in order, then one segment of another flow */
+	for (i = 0; i < GRO_NB_SEGS; i++)
+		pkts[i] = build_seg(i, TCP_ACK_FLAG, 80, 0);
+	pkts[GRO_NB_SEGS] = build_seg(GRO_NB_SEGS, TCP_ACK_FLAG, 81, 0);
+	for (i = 0; i <= GRO_NB_SEGS; i++)
+		TEST_ASSERT_NOT_NULL(pkts[i], "cannot build packet");
+
+	nb = rte_gro_reassemble_burst(pkts, GRO_NB_SEGS + 1, &burst_param);
+	TEST_ASSERT_EQUAL(nb, 2, "wrong number of packets: %u", nb);
+	if (check_merged(pkts[0], 0, GRO_NB_SEGS, 0) != TEST_SUCCESS ||
+	    check_merged(pkts[1], GRO_NB_SEGS, 1, 0) != TEST_SUCCESS) {
+		free_pkts(pkts, nb);
+		return TEST_FAILED;
+	}
+	free_pkts(pkts, nb);
+
+	/* segments in reverse order are merged too */
+	for (i = 0; i < GRO_NB_SEGS; i++)
+		pkts[i] = build_seg(GRO_NB_SEGS - 1 - i, TCP_ACK_FLAG, 80, 0);
+	nb = rte_gro_reassemble_burst(pkts, GRO_NB_SEGS, &burst_param);
+	TEST_ASSERT_EQUAL(nb, 1, "wrong number of packets: %u", nb);
+	if (check_merged(pkts[0], 0, GRO_NB_SEGS, 0) != TEST_SUCCESS) {
+		free_pkts(pkts, nb);
+		return TEST_FAILED;
+	}
+	free_pkts(pkts, nb);
+
+	return TEST_SUCCESS;
+}
+
+static int
+gro_burst_no_merge(void)
+{
+	struct rte_mbuf *pkts[6];
+	struct rte_gro_param param = burst_param;
+	uint16_t nb;
+
+	/* gap in the sequence */
+	pkts[0] = build_seg(0, TCP_ACK_FLAG, 80, 0);
+	pkts[1] = build_seg(2, TCP_ACK_FLAG, 80, 0);
+	/* SYN */
+	pkts[2] = build_seg(3, TCP_ACK_FLAG | TCP_SYN_FLAG, 80, 0);
+	/* after a PSH */
+	pkts[3] = build_seg(5, TCP_ACK_FLAG | TCP_PSH_FLAG, 80, 0);
+	pkts[4] = build_seg(6, TCP_ACK_FLAG, 80, 0);
+	/* PSH ends a merged packet */
+	pkts[5] = build_seg(1, TCP_ACK_FLAG | TCP_PSH_FLAG, 80, 0);
+
+	nb = rte_gro_reassemble_burst(pkts, RTE_DIM(pkts), &param);
+	TEST_ASSERT_EQUAL(nb, 5, "wrong number of packets: %u", nb);
+	TEST_ASSERT_EQUAL(pkts[0]->nb_segs, 2, "PSH segment not appended");
+	TEST_ASSERT_EQUAL(pkts[1]->nb_segs, 1, "merged after a gap");
+	TEST_ASSERT_EQUAL(pkts[2]->nb_segs, 1, "SYN merged");
+	TEST_ASSERT_EQUAL(pkts[3]->nb_segs, 1, "merged after PSH");
+	free_pkts(pkts, nb);
+
+	/* GRO type not requested */
+	param.gro_types = RTE_GRO_IPV4_VXLAN_TCP_IPV4;
+	pkts[0] = build_seg(0, TCP_ACK_FLAG, 80, 0);
+	pkts[1] = build_seg(1, TCP_ACK_FLAG, 80, 0);
+	nb = rte_gro_reassemble_burst(pkts, 2, &param);
+	TEST_ASSERT_EQUAL(nb, 2, "merged a disabled GRO type");
+	free_pkts(pkts, nb);
+
+	return TEST_SUCCESS;
+}
+
+static int
+gro_burst_vxlan(void)
+{
+	struct rte_mbuf *pkts[GRO_NB_SEGS + 1];
+	uint16_t i, nb;
+	int ret;
+
+	for (i = 0; i < GRO_NB_SEGS; i++)
+		pkts[i] = build_seg(i, TCP_ACK_FLAG, 4000, 1);
+	/* another outer UDP source port is another flow */
+	pkts[GRO_NB_SEGS] = build_seg(GRO_NB_SEGS, TCP_ACK_FLAG, 4001, 1);
+
+	nb = rte_gro_reassemble_burst(pkts, GRO_NB_SEGS + 1, &burst_param);
+	TEST_ASSERT_EQUAL(nb, 2, "wrong number of packets: %u", nb);
+	ret = check_merged(pkts[0], 0, GRO_NB_SEGS, 1);
+	free_pkts(pkts, nb);
+
+	return ret;
+}
+
+static int
+gro_ctx(void)
+{
+	struct rte_gro_param param = burst_param;
+	struct rte_mbuf *pkts[GRO_NB_SEGS];
+	struct rte_gro_ctx *ctx;
+	uint16_t i, nb;
+	int ret;
+
+	TEST_ASSERT_NULL(rte_gro_ctx_create(&param), "created empty context");
+
+	param.max_flow_num = 4;
+	param.max_item_per_flow = 2;
+	param.socket_id = rte_socket_id();
+	ctx = rte_gro_ctx_create(&param);
+	TEST_ASSERT_NOT_NULL(ctx, "cannot create context");
+
+	/* the segments are held across bursts */
+	for (i = 0; i < GRO_NB_SEGS; i++)
+		pkts[i] = build_seg(i, TCP_ACK_FLAG, 80, 0);
+	nb = rte_gro_reassemble(pkts, GRO_NB_SEGS / 2, ctx);
+	TEST_ASSERT_EQUAL(nb, 0, "packets not held");
+	nb = rte_gro_reassemble(pkts + GRO_NB_SEGS / 2, GRO_NB_SEGS / 2, ctx);
+	TEST_ASSERT_EQUAL(nb, 0, "packets not held");
+	TEST_ASSERT_EQUAL(rte_gro_get_pkt_count(ctx), 1,
+		"wrong number of held packets");
+
+	/* not old enough */
+	nb = rte_gro_timeout_flush(ctx, rte_get_tsc_hz(), RTE_GRO_TCP_IPV4,
+		pkts, RTE_DIM(pkts));
+	TEST_ASSERT_EQUAL(nb, 0, "packets flushed too early");
+
+	nb = rte_gro_timeout_flush(ctx, 0, RTE_GRO_TCP_IPV4, pkts,
+		RTE_DIM(pkts));
+	TEST_ASSERT_EQUAL(nb, 1, "wrong number of flushed packets");
+	ret = check_merged(pkts[0], 0, GRO_NB_SEGS, 0);
+	free_pkts(pkts, nb);
+	TEST_ASSERT_EQUAL(rte_gro_get_pkt_count(ctx), 0,
+		"packets left in context");
+
+	/* segments beyond the context size are returned */
+	for (i = 0; i < 3; i++)
+		pkts[i] = build_seg(2 * i, TCP_ACK_FLAG, 80, 0);
+	nb = rte_gro_reassemble(pkts, 3, ctx);
+	TEST_ASSERT_EQUAL(nb, 1, "packet held beyond max_item_per_flow");
+	free_pkts(pkts, nb);
+
+	/* held packets are freed with the context */
+	rte_gro_ctx_destroy(ctx);
+
+	return ret;
+}
+
+static struct unit_test_suite gro_tests = {
+	.suite_name = "GRO test suite",
+	.setup = testsuite_setup,
+	.teardown = testsuite_teardown,
+	.unit_test_cases = {
+		TEST_CASE(gro_burst_tcp4),
+		TEST_CASE(gro_burst_no_merge),
+		TEST_CASE(gro_burst_vxlan),
+		TEST_CASE(gro_ctx),
+		TEST_CASES_END()
+	}
+};
+
+static int
+test_gro(void)
+{
+	return unit_test_suite_runner(&gro_tests);
+}
+
+REGISTER_TEST_COMMAND(gro_autotest, test_gro);
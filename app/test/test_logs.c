@@ -56,8 +56,64 @@
  * - Enable log types.
  * - Set log level.
  * - Send logs with different types and levels, some should not be displayed.
+ * - Register dynamic log types and set their level, directly or with a
+ *   regular expression.
  */
 
+static int
+test_dynamic_logs(void)
+{
+	int logtype1, logtype2, logtype3;
+
+	logtype1 = rte_log_register("test.logs.type1");
+	logtype2 = rte_log_register("test.logs.type2");
+	if (logtype1 < RTE_LOGTYPE_FIRST_EXT_ID || logtype2 <= logtype1) {
+		printf("Error - cannot register log types\n");
+		return -1;
+	}
+	if (rte_log_register("test.logs.type1") != logtype1) {
+		printf("Error - log type registered twice\n");
+		return -1;
+	}
+	if (rte_log_register("eal") != RTE_LOGTYPE_EAL) {
+		printf("Error - static log type not found by name\n");
+		return -1;
+	}
+
+	rte_set_log_level(RTE_LOG_DEBUG);
+	rte_log_set_level(logtype1, RTE_LOG_ERR);
+	rte_log_set_level(logtype2, RTE_LOG_DEBUG);
+	rte_log(RTE_LOG_ERR, logtype1, "dynamic error message\n");
+	rte_log(RTE_LOG_INFO, logtype1, "dynamic info message "
+		"(not displayed)\n");
+	rte_log(RTE_LOG_INFO, logtype2, "dynamic info message\n");
+
+	/* the pattern applies to the types registered after it too */
+	if (rte_log_set_level_regexp("^test\\.logs\\.", RTE_LOG_CRIT) < 0) {
+		printf("Error - cannot set level with a regexp\n");
+		return -1;
+	}
+	logtype3 = rte_log_register("test.logs.type3");
+	if (rte_log_get_level(logtype2) != (int)RTE_LOG_CRIT ||
+			rte_log_get_level(logtype3) != (int)RTE_LOG_CRIT) {
+		printf("Error - regexp level not applied\n");
+		return -1;
+	}
+	rte_log(RTE_LOG_ERR, logtype3, "dynamic error message "
+		"(not displayed)\n");
+	rte_log(RTE_LOG_CRIT, logtype3, "dynamic critical message\n");
+
+	if (rte_log_set_level(logtype3 + 1000, RTE_LOG_ERR) == 0) {
+		printf("Error - level set for an invalid log type\n");
+		return -1;
+	}
+
+	rte_log_async_flush();
+	rte_log_dump(stdout);
+
+	return 0;
+}
+
 static int
 test_logs(void)
 {
@@ -83,6 +139,9 @@ test_logs(void)
 	RTE_LOG(ERR, TESTAPP1, "error message\n");
 	RTE_LOG(ERR, TESTAPP2, "error message (not displayed)\n");
 
+	if (test_dynamic_logs() < 0)
+		return -1;
+
 	return 0;
 }
 
@@ -37,6 +37,7 @@
 #include <stdarg.h>
 #include <errno.h>
 #include <stdlib.h>
+#include <inttypes.h>
 #include <sys/queue.h>
 
 #include <rte_common.h>
@@ -45,11 +46,13 @@
 #include <rte_per_lcore.h>
 #include <rte_launch.h>
 #include <rte_eal.h>
+#include <rte_eal_memconfig.h>
 #include <rte_per_lcore.h>
 #include <rte_lcore.h>
 #include <rte_malloc.h>
 #include <rte_cycles.h>
 #include <rte_random.h>
+#include <rte_atomic.h>
 #include <rte_string_fns.h>
 
 #include "test.h"
@@ -384,6 +387,161 @@ test_multi_alloc_statistics(void)
 	return 0;
 }
 
+#define MALLOC_PERF_ITERATIONS 2000
+#define MALLOC_PERF_BURST 64
+
+static rte_atomic32_t malloc_perf_errors;
+
+/*
+ * Allocate and free bursts of small objects, as done by control threads
+ * setting up sessions or flows, and report the cycles per alloc/free pair.
+ */
+static int
+test_alloc_free_perf_per_lcore(__attribute__((unused)) void *arg)
+{
+	static const size_t sizes[] = {24, 64, 200, 500};
+	void *objs[MALLOC_PERF_BURST];
+	uint64_t start, cycles;
+	unsigned i, j, k;
+
+	start = rte_rdtsc();
+	for (i = 0; i < MALLOC_PERF_ITERATIONS; i++) {
+		for (j = 0; j < MALLOC_PERF_BURST; j++) {
+			size_t size = sizes[(i + j) % RTE_DIM(sizes)];
+			uint8_t *obj = rte_zmalloc(NULL, size, 0);
+
+			if (obj == NULL) {
+				rte_atomic32_inc(&malloc_perf_errors);
+				for (k = 0; k < j; k++)
+					rte_free(objs[k]);
+				return -1;
+			}
+			for (k = 0; k < size; k++)
+				if (obj[k] != 0)
+					break;
+			if (k != size)
+				rte_atomic32_inc(&malloc_perf_errors);
+			memset(obj, 0xa5, size);
+			objs[j] = obj;
+		}
+		for (j = 0; j < MALLOC_PERF_BURST; j++)
+			rte_free(objs[j]);
+	}
+	cycles = rte_rdtsc() - start;
+
+	printf("Lcore %u: %"PRIu64" cycles per alloc/free pair\n",
+		rte_lcore_id(),
+		cycles / (MALLOC_PERF_ITERATIONS * MALLOC_PERF_BURST));
+	return 0;
+}
+
+static void
+malloc_stats_sum(struct rte_malloc_socket_stats *sum)
+{
+	struct rte_malloc_socket_stats stats;
+	int socket;
+
+	memset(sum, 0, sizeof(*sum));
+	for (socket = 0; socket < RTE_MAX_NUMA_NODES; socket++) {
+		if (rte_malloc_get_socket_stats(socket, &stats) < 0)
+			continue;
+
+		sum->alloc_count += stats.alloc_count;
+		sum->contention_count += stats.contention_count;
+		sum->cache_hit_count += stats.cache_hit_count;
+		sum->cache_miss_count += stats.cache_miss_count;
+		sum->cache_count += stats.cache_count;
+	}
+}
+
+static int
+test_multi_lcore_alloc_free(void)
+{
+	struct rte_malloc_socket_stats pre_stats, post_stats;
+	unsigned lcore_id;
+	int ret = 0;
+
+	rte_atomic32_init(&malloc_perf_errors);
+	malloc_stats_sum(&pre_stats);
+
+	rte_eal_mp_remote_launch(test_alloc_free_perf_per_lcore, NULL,
+		CALL_MASTER);
+	RTE_LCORE_FOREACH_SLAVE(lcore_id) {
+		if (rte_eal_wait_lcore(lcore_id) < 0)
+			ret = -1;
+	}
+	if (ret < 0 || rte_atomic32_read(&malloc_perf_errors) != 0) {
+		printf("Allocation failed or returned non-zeroed memory\n");
+		return -1;
+	}
+
+	malloc_stats_sum(&post_stats);
+	printf("Heap lock contention: %"PRIu64", lcore cache hits: %"PRIu64
+		", misses: %"PRIu64"\n",
+		post_stats.contention_count - pre_stats.contention_count,
+		post_stats.cache_hit_count - pre_stats.cache_hit_count,
+		post_stats.cache_miss_count - pre_stats.cache_miss_count);
+
+	/* Everything was freed, only the lcore caches may still hold objects */
+	if (post_stats.alloc_count - post_stats.cache_count !=
+			pre_stats.alloc_count - pre_stats.cache_count) {
+		printf("Incorrect heap statistics: Allocated count\n");
+		return -1;
+	}
+	if (RTE_MALLOC_CACHE_SIZE > 0 &&
+			post_stats.cache_hit_count == pre_stats.cache_hit_count) {
+		printf("Incorrect heap statistics: No lcore cache hits\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * In dynamic memory mode (--dynamic-mem), allocate more than the EAL memory
+ * and check the hugepages are mapped, then given back on free.
+ */
+static int
+test_dynamic_mem(void)
+{
+	const struct rte_mem_config *mcfg =
+		rte_eal_get_configuration()->mem_config;
+	uint64_t mem_size, grown_size;
+	size_t len;
+	char *p;
+
+	if (mcfg->dynmem_first == 0) {
+		printf("Not in dynamic memory mode, skipping\n");
+		return 0;
+	}
+
+	mem_size = rte_eal_get_physmem_size();
+	len = mem_size + 4 * 1024 * 1024;
+
+	p = rte_malloc_socket(NULL, len, 0, rte_socket_id());
+	if (p == NULL) {
+		printf("Cannot allocate %zu bytes\n", len);
+		return -1;
+	}
+	memset(p, 0xa5, len);
+
+	grown_size = rte_eal_get_physmem_size();
+	if (grown_size < mem_size + len) {
+		printf("Memory did not grow: %"PRIu64" bytes\n", grown_size);
+		rte_free(p);
+		return -1;
+	}
+
+	rte_free(p);
+	if (rte_eal_get_physmem_size() != mem_size) {
+		printf("Memory did not shrink back to %"PRIu64" bytes\n",
+			mem_size);
+		return -1;
+	}
+
+	return 0;
+}
+
 static int
 test_rte_malloc_type_limits(void)
 {
@@ -956,6 +1114,22 @@ test_malloc(void)
 	else
 		printf("test_multi_alloc_statistics() passed\n");
 
+	ret = test_multi_lcore_alloc_free();
+	if (ret < 0) {
+		printf("test_multi_lcore_alloc_free() failed\n");
+		return ret;
+	}
+	else
+		printf("test_multi_lcore_alloc_free() passed\n");
+
+	ret = test_dynamic_mem();
+	if (ret < 0) {
+		printf("test_dynamic_mem() failed\n");
+		return ret;
+	}
+	else
+		printf("test_dynamic_mem() passed\n");
+
 	return 0;
 }
 
@@ -73,7 +73,8 @@ static size_t buf_sizes[TEST_VALUE_RANGE];
  * changed.
  */
 static int
-test_single_memcpy(unsigned int off_src, unsigned int off_dst, size_t size)
+test_single_memcpy(unsigned int off_src, unsigned int off_dst, size_t size,
+		   int nt)
 {
 	unsigned int i;
 	uint8_t dest[SMALL_BUFFER_SIZE + ALIGNMENT_UNIT];
@@ -87,7 +88,10 @@ test_single_memcpy(unsigned int off_src, unsigned int off_dst, size_t size)
 	}
 
 	/* Do the copy */
-	ret = rte_memcpy(dest + off_dst, src + off_src, size);
+	if (nt)
+		ret = rte_memcpy_nt(dest + off_dst, src + off_src, size);
+	else
+		ret = rte_memcpy(dest + off_dst, src + off_src, size);
 	if (ret != (dest + off_dst)) {
 		printf("rte_memcpy() returned %p, not %p\n",
 		       ret, dest + off_dst);
@@ -129,7 +133,7 @@ test_single_memcpy(unsigned int off_src, unsigned int off_dst, size_t size)
  * Check functionality for various buffer sizes and data offsets/alignments.
  */
 static int
-func_test(void)
+func_test(int nt)
 {
 	unsigned int off_src, off_dst, i;
 	unsigned int num_buf_sizes = sizeof(buf_sizes) / sizeof(buf_sizes[0]);
@@ -139,7 +143,7 @@ func_test(void)
 		for (off_dst = 0; off_dst < ALIGNMENT_UNIT; off_dst++) {
 			for (i = 0; i < num_buf_sizes; i++) {
 				ret = test_single_memcpy(off_src, off_dst,
-				                         buf_sizes[i]);
+				                         buf_sizes[i], nt);
 				if (ret != 0)
 					return -1;
 			}
@@ -148,15 +152,38 @@ func_test(void)
 	return 0;
 }
 
+#ifdef RTE_ARCH_X86
+static const char * const isa_names[] = {
+	[RTE_MEMCPY_ISA_SSE] = "SSE",
+	[RTE_MEMCPY_ISA_AVX2] = "AVX2",
+	[RTE_MEMCPY_ISA_AVX512F] = "AVX512F",
+};
+#endif
+
 static int
 test_memcpy(void)
 {
-	int ret;
-
-	ret = func_test();
-	if (ret != 0)
+#ifdef RTE_ARCH_X86
+	enum rte_memcpy_isa isa, default_isa = rte_memcpy_isa_get();
+	int ret = 0;
+
+	/* check each variant supported by the CPU */
+	for (isa = RTE_MEMCPY_ISA_SSE; isa <= RTE_MEMCPY_ISA_AVX512F; isa++) {
+		if (rte_memcpy_isa_set(isa) != 0)
+			continue;
+		printf("Testing %s rte_memcpy\n", isa_names[isa]);
+		if (func_test(0) != 0 || func_test(1) != 0) {
+			ret = -1;
+			break;
+		}
+	}
+	rte_memcpy_isa_set(default_isa);
+	return ret;
+#else
+	if (func_test(0) != 0 || func_test(1) != 0)
 		return -1;
 	return 0;
+#endif
 }
 
 REGISTER_TEST_COMMAND(memcpy_autotest, test_memcpy);
@@ -79,7 +79,7 @@ static size_t buf_sizes[TEST_VALUE_RANGE];
 #define TEST_BATCH_SIZE         100
 
 /* Data is aligned on this many bytes (power of 2) */
-#ifdef RTE_MACHINE_CPUFLAG_AVX512F
+#if defined RTE_MACHINE_CPUFLAG_AVX512F || defined RTE_MEMCPY_RUNTIME_DISPATCH
 #define ALIGNMENT_UNIT          64
 #elif defined RTE_MACHINE_CPUFLAG_AVX2
 #define ALIGNMENT_UNIT          32
@@ -221,6 +221,47 @@ do {                                                                        \
     printf("%5.0f",  (double)total_time2 / TEST_ITERATIONS);                \
 } while (0)
 
+/*
+ * Run a single non-temporal memcpy performance test, compared to
+ * rte_memcpy().
+ */
+#define SINGLE_NT_PERF_TEST(dst, is_dst_cached, dst_uoffset,                \
+                            src, is_src_cached, src_uoffset, size)          \
+do {                                                                        \
+    unsigned int iter, t;                                                   \
+    size_t dst_addrs[TEST_BATCH_SIZE], src_addrs[TEST_BATCH_SIZE];          \
+    uint64_t start_time, total_time = 0;                                    \
+    uint64_t total_time2 = 0;                                               \
+    for (iter = 0; iter < (TEST_ITERATIONS / TEST_BATCH_SIZE); iter++) {    \
+        fill_addr_arrays(dst_addrs, is_dst_cached, dst_uoffset,             \
+                         src_addrs, is_src_cached, src_uoffset);            \
+        start_time = rte_rdtsc();                                           \
+        for (t = 0; t < TEST_BATCH_SIZE; t++)                               \
+            rte_memcpy_nt(dst+dst_addrs[t], src+src_addrs[t], size);        \
+        total_time += rte_rdtsc() - start_time;                             \
+    }                                                                       \
+    for (iter = 0; iter < (TEST_ITERATIONS / TEST_BATCH_SIZE); iter++) {    \
+        fill_addr_arrays(dst_addrs, is_dst_cached, dst_uoffset,             \
+                         src_addrs, is_src_cached, src_uoffset);            \
+        start_time = rte_rdtsc();                                           \
+        for (t = 0; t < TEST_BATCH_SIZE; t++)                               \
+            rte_memcpy(dst+dst_addrs[t], src+src_addrs[t], size);           \
+        total_time2 += rte_rdtsc() - start_time;                            \
+    }                                                                       \
+    printf("%8.0f -",  (double)total_time /TEST_ITERATIONS);                \
+    printf("%5.0f",  (double)total_time2 / TEST_ITERATIONS);                \
+} while (0)
+
+/* Run non-temporal memcpy tests for each cached/uncached permutation */
+#define ALL_NT_PERF_TESTS_FOR_SIZE(n, dst_uoffset, src_uoffset)                       \
+do {                                                                                  \
+    printf("\n%7u", (unsigned)n);                                                     \
+    SINGLE_NT_PERF_TEST(small_buf_write, 1, dst_uoffset, small_buf_read, 1, src_uoffset, n); \
+    SINGLE_NT_PERF_TEST(large_buf_write, 0, dst_uoffset, small_buf_read, 1, src_uoffset, n); \
+    SINGLE_NT_PERF_TEST(small_buf_write, 1, dst_uoffset, large_buf_read, 0, src_uoffset, n); \
+    SINGLE_NT_PERF_TEST(large_buf_write, 0, dst_uoffset, large_buf_read, 0, src_uoffset, n); \
+} while (0)
+
 /* Run aligned memcpy tests for each cached/uncached permutation */
 #define ALL_PERF_TESTS_FOR_SIZE(n)                                       \
 do {                                                                     \
@@ -295,32 +336,40 @@ perf_test_variable_unaligned(void)
 	}
 }
 
-/* Run all memcpy tests */
-static int
-perf_test(void)
+/* Run the non-temporal memcpy tests for the sizes worth it */
+static inline void
+perf_test_nt(void)
 {
-	int ret;
-
-	ret = init_buffers();
-	if (ret != 0)
-		return ret;
-
-#if TEST_VALUE_RANGE != 0
-	/* Set up buf_sizes array, if required */
+	unsigned n = sizeof(buf_sizes) / sizeof(buf_sizes[0]);
 	unsigned i;
-	for (i = 0; i < TEST_VALUE_RANGE; i++)
-		buf_sizes[i] = i;
-#endif
-
-	/* See function comment */
-	do_uncached_write(large_buf_write, 0, small_buf_read, 1, SMALL_BUFFER_SIZE);
 
-	printf("\n** rte_memcpy() - memcpy perf. tests (C = compile-time constant) **\n"
+	printf("\n** rte_memcpy_nt() - rte_memcpy() perf. tests **\n"
 		   "======= ============== ============== ============== ==============\n"
 		   "   Size Cache to cache   Cache to mem   Mem to cache     Mem to mem\n"
 		   "(bytes)        (ticks)        (ticks)        (ticks)        (ticks)\n"
 		   "------- -------------- -------------- -------------- --------------");
 
+	printf("\n========================== %2dB aligned ============================", ALIGNMENT_UNIT);
+	for (i = 0; i < n; i++)
+		if (buf_sizes[i] >= 256)
+			ALL_NT_PERF_TESTS_FOR_SIZE((size_t)buf_sizes[i], 0, 0);
+	printf("\n=========================== Unaligned =============================");
+	for (i = 0; i < n; i++)
+		if (buf_sizes[i] >= 256)
+			ALL_NT_PERF_TESTS_FOR_SIZE((size_t)buf_sizes[i], 1, 5);
+	printf("\n======= ============== ============== ============== ==============\n\n");
+}
+
+/* Run all memcpy tests of the selected variant */
+static void
+perf_test_variant(const char *name)
+{
+	printf("\n** %s rte_memcpy() - memcpy perf. tests (C = compile-time constant) **\n"
+		   "======= ============== ============== ============== ==============\n"
+		   "   Size Cache to cache   Cache to mem   Mem to cache     Mem to mem\n"
+		   "(bytes)        (ticks)        (ticks)        (ticks)        (ticks)\n"
+		   "------- -------------- -------------- -------------- --------------", name);
+
 	printf("\n========================== %2dB aligned ============================", ALIGNMENT_UNIT);
 	/* Do aligned tests where size is a variable */
 	perf_test_variable_aligned();
@@ -335,6 +384,50 @@ perf_test(void)
 	perf_test_constant_unaligned();
 	printf("\n======= ============== ============== ============== ==============\n\n");
 
+	perf_test_nt();
+}
+
+#ifdef RTE_ARCH_X86
+static const char * const isa_names[] = {
+	[RTE_MEMCPY_ISA_SSE] = "SSE",
+	[RTE_MEMCPY_ISA_AVX2] = "AVX2",
+	[RTE_MEMCPY_ISA_AVX512F] = "AVX512F",
+};
+#endif
+
+/* Run all memcpy tests */
+static int
+perf_test(void)
+{
+	int ret;
+#ifdef RTE_ARCH_X86
+	enum rte_memcpy_isa isa, default_isa = rte_memcpy_isa_get();
+#endif
+
+	ret = init_buffers();
+	if (ret != 0)
+		return ret;
+
+#if TEST_VALUE_RANGE != 0
+	/* Set up buf_sizes array, if required */
+	unsigned i;
+	for (i = 0; i < TEST_VALUE_RANGE; i++)
+		buf_sizes[i] = i;
+#endif
+
+	/* See function comment */
+	do_uncached_write(large_buf_write, 0, small_buf_read, 1, SMALL_BUFFER_SIZE);
+
+#ifdef RTE_ARCH_X86
+	/* compare the variants supported by the CPU */
+	for (isa = RTE_MEMCPY_ISA_SSE; isa <= RTE_MEMCPY_ISA_AVX512F; isa++)
+		if (rte_memcpy_isa_set(isa) == 0)
+			perf_test_variant(isa_names[isa]);
+	rte_memcpy_isa_set(default_isa);
+#else
+	perf_test_variant("native");
+#endif
+
 	free_buffers();
 
 	return 0;
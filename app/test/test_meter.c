@@ -466,6 +466,175 @@ tm_test_trtcm_color_aware_check(void)
 	return 0;
 }
 
+/**
+ * functional test for rte_meter_srtcm_profile_config and
+ * rte_meter_trtcm_profile_config
+ */
+static inline int
+tm_test_profile_config(void)
+{
+#define PROFILE_CFG_MSG "profile_config"
+	struct rte_meter_srtcm_profile sp;
+	struct rte_meter_trtcm_profile tp;
+	struct rte_meter_srtcm_rt srt;
+	struct rte_meter_trtcm_rt trt;
+	struct rte_meter_srtcm_params sparams1;
+	struct rte_meter_trtcm_params tparams1;
+
+	/* invalid parameter test */
+	if (rte_meter_srtcm_profile_config(NULL, &sparams) == 0)
+		melog(PROFILE_CFG_MSG);
+	if (rte_meter_srtcm_profile_config(&sp, NULL) == 0)
+		melog(PROFILE_CFG_MSG);
+	if (rte_meter_trtcm_profile_config(NULL, &tparams) == 0)
+		melog(PROFILE_CFG_MSG);
+	if (rte_meter_trtcm_profile_config(&tp, NULL) == 0)
+		melog(PROFILE_CFG_MSG);
+	if (rte_meter_srtcm_rt_config(&srt, NULL) == 0)
+		melog(PROFILE_CFG_MSG);
+	if (rte_meter_trtcm_rt_config(&trt, NULL) == 0)
+		melog(PROFILE_CFG_MSG);
+
+	sparams1 = sparams;
+	sparams1.cir = 0;
+	if (rte_meter_srtcm_profile_config(&sp, &sparams1) == 0)
+		melog(PROFILE_CFG_MSG);
+
+	tparams1 = tparams;
+	tparams1.pir = tparams1.cir - 1;
+	if (rte_meter_trtcm_profile_config(&tp, &tparams1) == 0)
+		melog(PROFILE_CFG_MSG);
+
+	/* usual parameters, should be successful */
+	if (rte_meter_srtcm_profile_config(&sp, &sparams) != 0)
+		melog(PROFILE_CFG_MSG);
+	if (rte_meter_trtcm_profile_config(&tp, &tparams) != 0)
+		melog(PROFILE_CFG_MSG);
+	if (rte_meter_srtcm_rt_config(&srt, &sp) != 0)
+		melog(PROFILE_CFG_MSG);
+	if (rte_meter_trtcm_rt_config(&trt, &tp) != 0)
+		melog(PROFILE_CFG_MSG);
+
+	if ((srt.tc != sp.cbs) || (srt.te != sp.ebs) ||
+		(trt.tc != tp.cbs) || (trt.tp != tp.pbs))
+		melog(PROFILE_CFG_MSG" buckets");
+
+	return 0;
+}
+
+#define TM_TEST_BULK_FLOWS 7
+#define TM_TEST_BULK_BURST 32
+#define TM_TEST_BULK_ROUNDS 64
+
+/**
+ * The bulk methods must assign the same colors as the self-contained per
+ * packet methods, including when one flow shows up several times in a burst.
+ */
+static inline int
+tm_test_bulk_check(void)
+{
+#define BULK_CHECK_MSG "bulk_check"
+	struct rte_meter_srtcm sm[TM_TEST_BULK_FLOWS];
+	struct rte_meter_trtcm tm[TM_TEST_BULK_FLOWS];
+	struct rte_meter_srtcm_rt srt[TM_TEST_BULK_FLOWS];
+	struct rte_meter_trtcm_rt trt[TM_TEST_BULK_FLOWS];
+	struct rte_meter_srtcm_profile sp;
+	struct rte_meter_trtcm_profile tp;
+	struct rte_meter_srtcm_rt *srt_burst[TM_TEST_BULK_BURST];
+	struct rte_meter_trtcm_rt *trt_burst[TM_TEST_BULK_BURST];
+	struct rte_meter_srtcm_profile *sp_burst[TM_TEST_BULK_BURST];
+	struct rte_meter_trtcm_profile *tp_burst[TM_TEST_BULK_BURST];
+	uint32_t pkt_len[TM_TEST_BULK_BURST];
+	enum rte_meter_color in[TM_TEST_BULK_BURST];
+	enum rte_meter_color scolor[TM_TEST_BULK_BURST];
+	enum rte_meter_color tcolor[TM_TEST_BULK_BURST];
+	uint64_t time, hz = rte_get_tsc_hz();
+	uint32_t round, i, flow;
+	int aware;
+
+	for (aware = 0; aware <= 1; aware++) {
+		if ((rte_meter_srtcm_profile_config(&sp, &sparams) != 0) ||
+			(rte_meter_trtcm_profile_config(&tp, &tparams) != 0))
+			melog(BULK_CHECK_MSG);
+
+		for (i = 0; i < TM_TEST_BULK_FLOWS; i++) {
+			if ((rte_meter_srtcm_config(&sm[i], &sparams) != 0) ||
+				(rte_meter_trtcm_config(&tm[i], &tparams) != 0) ||
+				(rte_meter_srtcm_rt_config(&srt[i], &sp) != 0) ||
+				(rte_meter_trtcm_rt_config(&trt[i], &tp) != 0))
+				melog(BULK_CHECK_MSG);
+
+			/* Align the time stamps of both flavours */
+			srt[i].time = sm[i].time;
+			trt[i].time_tc = tm[i].time_tc;
+			trt[i].time_tp = tm[i].time_tp;
+		}
+
+		time = sm[0].time;
+		for (round = 0; round < TM_TEST_BULK_ROUNDS; round++) {
+			time += hz / 100000;
+
+			for (i = 0; i < TM_TEST_BULK_BURST; i++) {
+				flow = (i * 3 + round) % TM_TEST_BULK_FLOWS;
+				srt_burst[i] = &srt[flow];
+				trt_burst[i] = &trt[flow];
+				sp_burst[i] = &sp;
+				tp_burst[i] = &tp;
+				pkt_len[i] = 64 + ((i * 131 + round * 17) % 1455);
+				in[i] = (enum rte_meter_color)
+					((i + round) % e_RTE_METER_COLORS);
+				scolor[i] = in[i];
+				tcolor[i] = in[i];
+			}
+
+			if (aware) {
+				rte_meter_srtcm_color_aware_check_bulk(srt_burst,
+					sp_burst, time, pkt_len, scolor,
+					TM_TEST_BULK_BURST);
+				rte_meter_trtcm_color_aware_check_bulk(trt_burst,
+					tp_burst, time, pkt_len, tcolor,
+					TM_TEST_BULK_BURST);
+			} else {
+				rte_meter_srtcm_color_blind_check_bulk(srt_burst,
+					sp_burst, time, pkt_len, scolor,
+					TM_TEST_BULK_BURST);
+				rte_meter_trtcm_color_blind_check_bulk(trt_burst,
+					tp_burst, time, pkt_len, tcolor,
+					TM_TEST_BULK_BURST);
+			}
+
+			for (i = 0; i < TM_TEST_BULK_BURST; i++) {
+				enum rte_meter_color sref, tref;
+
+				flow = (i * 3 + round) % TM_TEST_BULK_FLOWS;
+				if (aware) {
+					sref = rte_meter_srtcm_color_aware_check(
+						&sm[flow], time, pkt_len[i], in[i]);
+					tref = rte_meter_trtcm_color_aware_check(
+						&tm[flow], time, pkt_len[i], in[i]);
+				} else {
+					sref = rte_meter_srtcm_color_blind_check(
+						&sm[flow], time, pkt_len[i]);
+					tref = rte_meter_trtcm_color_blind_check(
+						&tm[flow], time, pkt_len[i]);
+				}
+
+				if (scolor[i] != sref)
+					melog(BULK_CHECK_MSG" srTCM color");
+				if (tcolor[i] != tref)
+					melog(BULK_CHECK_MSG" trTCM color");
+			}
+		}
+
+		for (i = 0; i < TM_TEST_BULK_FLOWS; i++)
+			if ((srt[i].tc != sm[i].tc) || (srt[i].te != sm[i].te) ||
+				(trt[i].tc != tm[i].tc) || (trt[i].tp != tm[i].tp))
+				melog(BULK_CHECK_MSG" buckets");
+	}
+
+	return 0;
+}
+
 /**
  * test main entrance for library meter
  */
@@ -490,6 +659,12 @@ test_meter(void)
 	if(tm_test_trtcm_color_aware_check()!= 0)
 		return -1;
 
+	if (tm_test_profile_config() != 0)
+		return -1;
+
+	if (tm_test_bulk_check() != 0)
+		return -1;
+
 	return 0;
 
 }
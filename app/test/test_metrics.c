@@ -0,0 +1,284 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <rte_common.h>
+#include <rte_lcore.h>
+#include <rte_launch.h>
+#include <rte_metrics.h>
+
+#include "test.h"
+
+#define METRICS_SOCK_PATH "/tmp/metrics_autotest.sock"
+#define METRICS_LOOPS 1000
+
+static const char * const counter_names[] = {
+	"test.counter0", "test.counter1", "test.counter2",
+};
+
+static int counter_key;
+static int gauge_key;
+
+static int
+testsuite_setup(void)
+{
+	int ret;
+
+	if (rte_metrics_init(rte_socket_id()) < 0)
+		return TEST_FAILED;
+
+	/* the metrics are kept from a previous run of the suite */
+	ret = rte_metrics_reg_names(counter_names, RTE_DIM(counter_names),
+		RTE_METRIC_COUNTER);
+	if (ret == -EINVAL)
+		ret = rte_metrics_reg_name(counter_names[0],
+			RTE_METRIC_COUNTER);
+	counter_key = ret;
+	gauge_key = rte_metrics_reg_name("test.gauge", RTE_METRIC_GAUGE);
+	if (counter_key < 0 || gauge_key < 0)
+		return TEST_FAILED;
+	return TEST_SUCCESS;
+}
+
+static uint64_t
+metric_value(int key)
+{
+	struct rte_metric_value values[RTE_METRICS_MAX_METRICS];
+	int cnt;
+
+	cnt = rte_metrics_get_values(values, RTE_DIM(values));
+	if (key >= cnt)
+		return UINT64_MAX;
+	return values[key].value;
+}
+
+static int
+count_loop(void *arg)
+{
+	uint16_t key = (uintptr_t)arg;
+	unsigned int i;
+
+	for (i = 0; i < METRICS_LOOPS; i++)
+		rte_metrics_counter_add(key, 1);
+	return 0;
+}
+
+static void *
+count_thread(void *arg)
+{
+	count_loop(arg);
+	return NULL;
+}
+
+static int
+metrics_register(void)
+{
+	struct rte_metric_name names[RTE_METRICS_MAX_METRICS];
+	int cnt;
+	unsigned int i;
+
+	TEST_ASSERT_EQUAL(rte_metrics_init(rte_socket_id()), 0,
+		"cannot init twice");
+	TEST_ASSERT_EQUAL(rte_metrics_reg_name("", RTE_METRIC_GAUGE),
+		-EINVAL, "empty name registered");
+	TEST_ASSERT_EQUAL(rte_metrics_reg_name("test.\"quoted\"",
+		RTE_METRIC_GAUGE), -EINVAL, "quoted name registered");
+	TEST_ASSERT_EQUAL(rte_metrics_reg_name(counter_names[1],
+		RTE_METRIC_COUNTER), counter_key + 1,
+		"wrong key of registered name");
+	TEST_ASSERT_EQUAL(rte_metrics_reg_name(counter_names[1],
+		RTE_METRIC_GAUGE), -EINVAL, "name registered twice");
+	TEST_ASSERT_EQUAL(rte_metrics_reg_names(counter_names, 2,
+		RTE_METRIC_COUNTER), -EINVAL, "names registered twice");
+
+	cnt = rte_metrics_get_names(NULL, 0);
+	TEST_ASSERT(cnt >= counter_key + (int)RTE_DIM(counter_names),
+		"wrong number of metrics");
+	TEST_ASSERT_EQUAL(rte_metrics_get_names(names, cnt - 1), cnt,
+		"names returned in a small array");
+	TEST_ASSERT_EQUAL(rte_metrics_get_names(names, RTE_DIM(names)), cnt,
+		"cannot get names");
+	for (i = 0; i < RTE_DIM(counter_names); i++)
+		TEST_ASSERT(strcmp(names[counter_key + i].name,
+			counter_names[i]) == 0, "wrong name %u", i);
+
+	return TEST_SUCCESS;
+}
+
+static int
+metrics_counter(void)
+{
+	uint16_t key = counter_key + 2;
+	uint64_t start, expected;
+	unsigned int lcore_id;
+	pthread_t thread;
+
+	start = metric_value(key);
+	expected = start + METRICS_LOOPS;
+	count_loop((void *)(uintptr_t)key);
+
+	RTE_LCORE_FOREACH_SLAVE(lcore_id) {
+		rte_eal_remote_launch(count_loop, (void *)(uintptr_t)key,
+			lcore_id);
+		expected += METRICS_LOOPS;
+	}
+	rte_eal_mp_wait_lcore();
+
+	/* a non-EAL thread updates the shared copy */
+	TEST_ASSERT_SUCCESS(pthread_create(&thread, NULL, count_thread,
+		(void *)(uintptr_t)key), "cannot create thread");
+	pthread_join(thread, NULL);
+	expected += METRICS_LOOPS;
+
+	TEST_ASSERT_EQUAL(metric_value(key), expected, "wrong counter value");
+	TEST_ASSERT_EQUAL(rte_metrics_gauge_set(key, 1), -EINVAL,
+		"counter set as a gauge");
+
+	return TEST_SUCCESS;
+}
+
+static int
+metrics_gauge(void)
+{
+	TEST_ASSERT_SUCCESS(rte_metrics_gauge_set(gauge_key, 42),
+		"cannot set gauge");
+	TEST_ASSERT_EQUAL(metric_value(gauge_key), 42, "wrong gauge value");
+	TEST_ASSERT_SUCCESS(rte_metrics_gauge_set(gauge_key, 7),
+		"cannot set gauge");
+	TEST_ASSERT_EQUAL(metric_value(gauge_key), 7, "wrong gauge value");
+	TEST_ASSERT_EQUAL(rte_metrics_gauge_set(RTE_METRICS_MAX_METRICS, 1),
+		-EINVAL, "invalid key set");
+
+	return TEST_SUCCESS;
+}
+
+static int
+metrics_json(void)
+{
+	char *buf = NULL;
+	char expected[64];
+	size_t len = 0;
+	FILE *f;
+	int ret;
+
+	TEST_ASSERT_SUCCESS(rte_metrics_gauge_set(gauge_key, 1234),
+		"cannot set gauge");
+
+	f = open_memstream(&buf, &len);
+	TEST_ASSERT_NOT_NULL(f, "cannot open stream");
+	ret = rte_metrics_json_write(f);
+	fclose(f);
+	if (ret != 0)
+		free(buf);
+	TEST_ASSERT_SUCCESS(ret, "cannot write JSON");
+
+	snprintf(expected, sizeof(expected), "\"test.gauge\":1234");
+	ret = buf[0] == '{' && strstr(buf, expected) != NULL &&
+		strstr(buf, "\"test.counter0\":") != NULL;
+	free(buf);
+	TEST_ASSERT(ret, "wrong JSON object");
+
+	return TEST_SUCCESS;
+}
+
+static int
+metrics_socket(void)
+{
+	struct sockaddr_un addr;
+	char buf[4096];
+	ssize_t len = 0, ret;
+	int fd;
+
+	TEST_ASSERT_SUCCESS(rte_metrics_gauge_set(gauge_key, 5678),
+		"cannot set gauge");
+	TEST_ASSERT_SUCCESS(rte_metrics_socket_start(METRICS_SOCK_PATH),
+		"cannot start socket");
+	TEST_ASSERT_EQUAL(rte_metrics_socket_start(METRICS_SOCK_PATH),
+		-EBUSY, "socket started twice");
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	snprintf(addr.sun_path, sizeof(addr.sun_path), METRICS_SOCK_PATH);
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd >= 0 && connect(fd, (struct sockaddr *)&addr,
+			sizeof(addr)) == 0) {
+		while ((ret = read(fd, buf + len,
+				sizeof(buf) - 1 - len)) > 0)
+			len += ret;
+	}
+	if (fd >= 0)
+		close(fd);
+	buf[len] = '\0';
+
+	rte_metrics_socket_stop();
+	TEST_ASSERT(access(METRICS_SOCK_PATH, F_OK) != 0,
+		"socket not removed");
+	TEST_ASSERT_NOT_NULL(strstr(buf, "\"test.gauge\":5678"),
+		"wrong JSON object on socket");
+
+	/* the thread exited, the socket can be served again */
+	TEST_ASSERT_SUCCESS(rte_metrics_socket_start(METRICS_SOCK_PATH),
+		"cannot restart socket");
+	rte_metrics_socket_stop();
+
+	return TEST_SUCCESS;
+}
+
+static struct unit_test_suite metrics_tests = {
+	.suite_name = "metrics test suite",
+	.setup = testsuite_setup,
+	.unit_test_cases = {
+		TEST_CASE(metrics_register),
+		TEST_CASE(metrics_counter),
+		TEST_CASE(metrics_gauge),
+		TEST_CASE(metrics_json),
+		TEST_CASE(metrics_socket),
+		TEST_CASES_END()
+	}
+};
+
+static int
+test_metrics(void)
+{
+	return unit_test_suite_runner(&metrics_tests);
+}
+
+REGISTER_TEST_COMMAND(metrics_autotest, test_metrics);
@@ -0,0 +1,411 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <stdint.h>
+#include <string.h>
+
+#include <rte_common.h>
+#include <rte_lcore.h>
+#include <rte_mbuf.h>
+#include <rte_ether.h>
+#include <rte_ip.h>
+#include <rte_tcp.h>
+#include <rte_udp.h>
+#include <rte_net.h>
+
+#include "test.h"
+
+#define SW_OFFLOAD_NB_MBUFS 511
+#define SW_OFFLOAD_L2_LEN sizeof(struct ether_hdr)
+#define SW_OFFLOAD_SEQ 1000
+
+#define TCP_FIN_FLAG 0x01
+#define TCP_PSH_FLAG 0x08
+#define TCP_ACK_FLAG 0x10
+#define TCP_CWR_FLAG 0x80
+
+static struct rte_mempool *pkt_pool;
+
+static int
+testsuite_setup(void)
+{
+	pkt_pool = rte_pktmbuf_pool_create("SW_OFFLOAD_TEST_POOL",
+		SW_OFFLOAD_NB_MBUFS, 0, 0, RTE_MBUF_DEFAULT_BUF_SIZE,
+		rte_socket_id());
+	return pkt_pool == NULL ? TEST_FAILED : TEST_SUCCESS;
+}
+
+static void
+testsuite_teardown(void)
+{
+	rte_mempool_free(pkt_pool);
+	pkt_pool = NULL;
+}
+
+/*
+ * Build an Ethernet, IPv4 or IPv6, TCP or UDP packet with a payload of
+ * len bytes, and request the checksums of its headers. The addresses are
+ * all ones, for the largest pseudo-header sum.
+ */
+static struct rte_mbuf *
+build_pkt(int ipv6, uint8_t proto, uint16_t len)
+{
+	uint16_t l3_len = ipv6 ? sizeof(struct ipv6_hdr) :
+		sizeof(struct ipv4_hdr);
+	uint16_t l4_len = (proto == IPPROTO_TCP) ? sizeof(struct tcp_hdr) :
+		sizeof(struct udp_hdr);
+	struct ether_hdr *eth;
+	struct ipv4_hdr *ip4;
+	struct ipv6_hdr *ip6;
+	struct tcp_hdr *tcp;
+	struct udp_hdr *udp;
+	struct rte_mbuf *m;
+	uint8_t *payload;
+	char *data;
+	uint16_t i;
+
+	m = rte_pktmbuf_alloc(pkt_pool);
+	if (m == NULL)
+		return NULL;
+	data = rte_pktmbuf_append(m, SW_OFFLOAD_L2_LEN + l3_len + l4_len + len);
+	if (data == NULL) {
+		rte_pktmbuf_free(m);
+		return NULL;
+	}
+	memset(data, 0, SW_OFFLOAD_L2_LEN + l3_len + l4_len);
+
+	eth = (struct ether_hdr *)data;
+	eth->d_addr.addr_bytes[0] = 2;
+	if (ipv6) {
+		eth->ether_type = rte_cpu_to_be_16(ETHER_TYPE_IPv6);
+		ip6 = (struct ipv6_hdr *)(eth + 1);
+		ip6->vtc_flow = rte_cpu_to_be_32(6 << 28);
+		ip6->payload_len = rte_cpu_to_be_16(l4_len + len);
+		ip6->proto = proto;
+		ip6->hop_limits = 64;
+		memset(ip6->src_addr, 0xff, sizeof(ip6->src_addr));
+		memset(ip6->dst_addr, 0xff, sizeof(ip6->dst_addr));
+		m->ol_flags = PKT_TX_IPV6;
+	} else {
+		eth->ether_type = rte_cpu_to_be_16(ETHER_TYPE_IPv4);
+		ip4 = (struct ipv4_hdr *)(eth + 1);
+		ip4->version_ihl = 0x45;
+		ip4->total_length = rte_cpu_to_be_16(l3_len + l4_len + len);
+		ip4->packet_id = rte_cpu_to_be_16(7);
+		ip4->time_to_live = 64;
+		ip4->next_proto_id = proto;
+		ip4->src_addr = 0xffffffff;
+		ip4->dst_addr = 0xffffffff;
+		m->ol_flags = PKT_TX_IPV4 | PKT_TX_IP_CKSUM;
+	}
+
+	if (proto == IPPROTO_TCP) {
+		tcp = (struct tcp_hdr *)(data + SW_OFFLOAD_L2_LEN + l3_len);
+		tcp->src_port = rte_cpu_to_be_16(1000);
+		tcp->dst_port = rte_cpu_to_be_16(80);
+		tcp->sent_seq = rte_cpu_to_be_32(SW_OFFLOAD_SEQ);
+		tcp->data_off = (sizeof(*tcp) / 4) << 4;
+		tcp->tcp_flags = TCP_ACK_FLAG;
+		m->ol_flags |= PKT_TX_TCP_CKSUM;
+	} else {
+		udp = (struct udp_hdr *)(data + SW_OFFLOAD_L2_LEN + l3_len);
+		udp->src_port = rte_cpu_to_be_16(1000);
+		udp->dst_port = rte_cpu_to_be_16(53);
+		udp->dgram_len = rte_cpu_to_be_16(l4_len + len);
+		m->ol_flags |= PKT_TX_UDP_CKSUM;
+	}
+
+	payload = (uint8_t *)data + SW_OFFLOAD_L2_LEN + l3_len + l4_len;
+	for (i = 0; i < len; i++)
+		payload[i] = i * 7 + 0xf0;
+
+	m->l2_len = SW_OFFLOAD_L2_LEN;
+	m->l3_len = l3_len;
+	m->l4_len = l4_len;
+	return m;
+}
+
+/*
+ * Check the IPv4 header checksum and the L4 checksum of a packet, whose
+ * L4 part may be spread over several segments.
+ */
+static int
+check_cksum(struct rte_mbuf *m)
+{
+	uint32_t l4_off = m->l2_len + m->l3_len;
+	struct ipv4_hdr *ip4;
+	struct ipv6_hdr *ip6;
+	uint16_t raw, phdr;
+	uint32_t sum;
+
+	ip4 = rte_pktmbuf_mtod_offset(m, struct ipv4_hdr *, m->l2_len);
+	ip6 = (struct ipv6_hdr *)ip4;
+	if ((ip4->version_ihl >> 4) == 4) {
+		TEST_ASSERT_EQUAL(rte_raw_cksum(ip4, m->l3_len), 0xffff,
+			"bad IPv4 header checksum");
+		phdr = rte_ipv4_phdr_cksum(ip4, 0);
+	} else {
+		phdr = rte_ipv6_phdr_cksum(ip6, 0);
+	}
+
+	TEST_ASSERT_SUCCESS(rte_raw_cksum_mbuf(m, l4_off,
+		rte_pktmbuf_pkt_len(m) - l4_off, &raw), "bad L4 length");
+	sum = (uint32_t)raw + phdr;
+	sum = (sum & 0xffff) + (sum >> 16);
+	TEST_ASSERT_EQUAL(sum, 0xffff, "bad L4 checksum");
+
+	return TEST_SUCCESS;
+}
+
+/* The checksums computed in place match the rte_ip.h functions */
+static int
+sw_offload_cksum(void)
+{
+	static const struct {
+		int ipv6;
+		uint8_t proto;
+		uint16_t len;
+	} cases[] = {
+		{ 0, IPPROTO_TCP, 100 }, { 0, IPPROTO_UDP, 101 },
+		{ 1, IPPROTO_TCP, 1 }, { 1, IPPROTO_UDP, 1400 },
+		{ 0, IPPROTO_TCP, 0 }, { 0, IPPROTO_UDP, 0 },
+	};
+	struct rte_mbuf *m, *pkts[RTE_NET_SW_TX_MAX_PKTS];
+	uint16_t *cksum, expected;
+	struct ipv4_hdr *ip4;
+	char *l4;
+	unsigned int i;
+	int nb;
+
+	for (i = 0; i < RTE_DIM(cases); i++) {
+		m = build_pkt(cases[i].ipv6, cases[i].proto, cases[i].len);
+		TEST_ASSERT_NOT_NULL(m, "cannot build packet");
+		ip4 = rte_pktmbuf_mtod_offset(m, struct ipv4_hdr *,
+			m->l2_len);
+		l4 = (char *)ip4 + m->l3_len;
+		cksum = (uint16_t *)(l4 + ((cases[i].proto == IPPROTO_TCP) ?
+			offsetof(struct tcp_hdr, cksum) :
+			offsetof(struct udp_hdr, dgram_cksum)));
+		if (cases[i].ipv6)
+			expected = rte_ipv6_udptcp_cksum(
+				(struct ipv6_hdr *)ip4, l4);
+		else
+			expected = rte_ipv4_udptcp_cksum(ip4, l4);
+
+		nb = rte_net_sw_tx_offload(m, pkts, RTE_DIM(pkts));
+		TEST_ASSERT_EQUAL(nb, 1, "case %u: returned %d", i, nb);
+		TEST_ASSERT(pkts[0] == m, "case %u: packet replaced", i);
+		TEST_ASSERT_EQUAL(*cksum, expected,
+			"case %u: L4 checksum 0x%x, expected 0x%x",
+			i, *cksum, expected);
+		TEST_ASSERT_SUCCESS(check_cksum(m), "case %u", i);
+		TEST_ASSERT((m->ol_flags & RTE_NET_SW_TX_OFFLOAD_MASK) == 0,
+			"case %u: offload flags left", i);
+		rte_pktmbuf_free(m);
+	}
+
+	return TEST_SUCCESS;
+}
+
+/* A TSO packet is cut into segments with updated headers */
+static int
+sw_offload_tso(void)
+{
+	struct rte_mbuf *m, *pkts[RTE_NET_SW_TX_MAX_PKTS];
+	uint16_t segsz = 300, len = 1000, id;
+	struct ipv4_hdr *ip4;
+	struct tcp_hdr *tcp;
+	uint32_t payload;
+	int i, nb;
+
+	m = build_pkt(0, IPPROTO_TCP, len);
+	TEST_ASSERT_NOT_NULL(m, "cannot build packet");
+	tcp = rte_pktmbuf_mtod_offset(m, struct tcp_hdr *,
+		m->l2_len + m->l3_len);
+	tcp->tcp_flags |= TCP_FIN_FLAG | TCP_PSH_FLAG | TCP_CWR_FLAG;
+	m->ol_flags = PKT_TX_IPV4 | PKT_TX_TCP_SEG;
+	m->tso_segsz = segsz;
+
+	nb = rte_net_sw_tx_offload(m, pkts, RTE_DIM(pkts));
+	TEST_ASSERT_EQUAL(nb, 4, "%d segments, expected 4", nb);
+
+	for (i = 0; i < nb; i++) {
+		payload = RTE_MIN(segsz, len - i * segsz);
+		ip4 = rte_pktmbuf_mtod_offset(pkts[i], struct ipv4_hdr *,
+			pkts[i]->l2_len);
+		tcp = rte_pktmbuf_mtod_offset(pkts[i], struct tcp_hdr *,
+			pkts[i]->l2_len + pkts[i]->l3_len);
+		id = rte_be_to_cpu_16(ip4->packet_id);
+
+		TEST_ASSERT_EQUAL(rte_pktmbuf_pkt_len(pkts[i]),
+			SW_OFFLOAD_L2_LEN + sizeof(*ip4) + sizeof(*tcp) +
+			payload, "segment %d: bad length", i);
+		TEST_ASSERT_EQUAL(rte_be_to_cpu_16(ip4->total_length),
+			sizeof(*ip4) + sizeof(*tcp) + payload,
+			"segment %d: bad IP length", i);
+		TEST_ASSERT_EQUAL(id, 7 + i, "segment %d: IP id %u", i, id);
+		TEST_ASSERT_EQUAL(rte_be_to_cpu_32(tcp->sent_seq),
+			SW_OFFLOAD_SEQ + i * segsz,
+			"segment %d: bad sequence number", i);
+		TEST_ASSERT_EQUAL(!!(tcp->tcp_flags & TCP_FIN_FLAG),
+			(i == nb - 1), "segment %d: bad FIN", i);
+		TEST_ASSERT_EQUAL(!!(tcp->tcp_flags & TCP_PSH_FLAG),
+			(i == nb - 1), "segment %d: bad PSH", i);
+		TEST_ASSERT_EQUAL(!!(tcp->tcp_flags & TCP_CWR_FLAG),
+			(i == 0), "segment %d: bad CWR", i);
+		TEST_ASSERT(tcp->tcp_flags & TCP_ACK_FLAG,
+			"segment %d: ACK lost", i);
+		TEST_ASSERT_SUCCESS(check_cksum(pkts[i]), "segment %d", i);
+		rte_pktmbuf_free(pkts[i]);
+	}
+
+	/* not enough room for the segments */
+	m = build_pkt(0, IPPROTO_TCP, len);
+	TEST_ASSERT_NOT_NULL(m, "cannot build packet");
+	m->ol_flags = PKT_TX_IPV4 | PKT_TX_TCP_SEG;
+	m->tso_segsz = segsz;
+	nb = rte_net_sw_tx_offload(m, pkts, 2);
+	TEST_ASSERT_EQUAL(nb, -ENOSPC, "returned %d, expected -ENOSPC", nb);
+	rte_pktmbuf_free(m);
+
+	return TEST_SUCCESS;
+}
+
+/* The VLAN tag is inserted after the checksums */
+static int
+sw_offload_vlan(void)
+{
+	struct rte_mbuf *m, *pkts[RTE_NET_SW_TX_MAX_PKTS];
+	struct vlan_hdr *vh;
+	struct ether_hdr *eth;
+	int nb;
+
+	m = build_pkt(0, IPPROTO_UDP, 50);
+	TEST_ASSERT_NOT_NULL(m, "cannot build packet");
+	m->ol_flags |= PKT_TX_VLAN_PKT;
+	m->vlan_tci = 0x123;
+
+	nb = rte_net_sw_tx_offload(m, pkts, RTE_DIM(pkts));
+	TEST_ASSERT_EQUAL(nb, 1, "returned %d", nb);
+	m = pkts[0];
+	eth = rte_pktmbuf_mtod(m, struct ether_hdr *);
+	vh = (struct vlan_hdr *)(eth + 1);
+	TEST_ASSERT_EQUAL(rte_be_to_cpu_16(eth->ether_type), ETHER_TYPE_VLAN,
+		"no VLAN header");
+	TEST_ASSERT_EQUAL(rte_be_to_cpu_16(vh->vlan_tci), 0x123,
+		"bad VLAN TCI");
+	TEST_ASSERT_EQUAL(rte_be_to_cpu_16(vh->eth_proto), ETHER_TYPE_IPv4,
+		"bad encapsulated type");
+
+	/* check the checksums past the tag */
+	m->l2_len += sizeof(*vh);
+	TEST_ASSERT_SUCCESS(check_cksum(m), "checksums with VLAN");
+	rte_pktmbuf_free(m);
+
+	return TEST_SUCCESS;
+}
+
+/*
+ * The headers of a shared or indirect packet are rewritten in a new mbuf,
+ * including when it has no payload, and the original data is untouched.
+ */
+static int
+sw_offload_shared(void)
+{
+	struct rte_mbuf *m, *mi, *pkts[RTE_NET_SW_TX_MAX_PKTS];
+	struct ipv4_hdr *ip4;
+	uint16_t lens[] = { 100, 0 };
+	uint8_t protos[] = { IPPROTO_TCP, IPPROTO_UDP };
+	unsigned int i, j;
+	int nb;
+
+	for (i = 0; i < RTE_DIM(lens); i++) {
+		for (j = 0; j < RTE_DIM(protos); j++) {
+			/* shared */
+			m = build_pkt(0, protos[j], lens[i]);
+			TEST_ASSERT_NOT_NULL(m, "cannot build packet");
+			rte_mbuf_refcnt_update(m, 1);
+			nb = rte_net_sw_tx_offload(m, pkts, RTE_DIM(pkts));
+			TEST_ASSERT_EQUAL(nb, 1, "shared: returned %d", nb);
+			TEST_ASSERT(pkts[0] != m, "shared packet modified");
+			ip4 = rte_pktmbuf_mtod_offset(m, struct ipv4_hdr *,
+				m->l2_len);
+			TEST_ASSERT_EQUAL(ip4->hdr_checksum, 0,
+				"shared packet data modified");
+			TEST_ASSERT_EQUAL(rte_pktmbuf_pkt_len(pkts[0]),
+				rte_pktmbuf_pkt_len(m), "bad length");
+			TEST_ASSERT_SUCCESS(check_cksum(pkts[0]), "shared");
+			rte_pktmbuf_free(pkts[0]);
+			TEST_ASSERT_EQUAL(rte_mbuf_refcnt_read(m), 1,
+				"shared packet reference not released");
+
+			/* indirect */
+			mi = rte_pktmbuf_alloc(pkt_pool);
+			TEST_ASSERT_NOT_NULL(mi, "cannot allocate mbuf");
+			rte_pktmbuf_attach(mi, m);
+			nb = rte_net_sw_tx_offload(mi, pkts, RTE_DIM(pkts));
+			TEST_ASSERT_EQUAL(nb, 1, "indirect: returned %d", nb);
+			TEST_ASSERT(pkts[0] != mi, "indirect packet modified");
+			TEST_ASSERT_EQUAL(ip4->hdr_checksum, 0,
+				"indirect packet data modified");
+			TEST_ASSERT_SUCCESS(check_cksum(pkts[0]), "indirect");
+			rte_pktmbuf_free(pkts[0]);
+			TEST_ASSERT_EQUAL(rte_mbuf_refcnt_read(m), 1,
+				"indirect packet not released");
+			rte_pktmbuf_free(m);
+		}
+	}
+
+	return TEST_SUCCESS;
+}
+
+static struct unit_test_suite sw_offload_tests = {
+	.suite_name = "software TX offload test suite",
+	.setup = testsuite_setup,
+	.teardown = testsuite_teardown,
+	.unit_test_cases = {
+		TEST_CASE(sw_offload_cksum),
+		TEST_CASE(sw_offload_tso),
+		TEST_CASE(sw_offload_vlan),
+		TEST_CASE(sw_offload_shared),
+		TEST_CASES_END()
+	}
+};
+
+static int
+test_net_sw_offload(void)
+{
+	return unit_test_suite_runner(&sw_offload_tests);
+}
+
+REGISTER_TEST_COMMAND(net_sw_offload_autotest, test_net_sw_offload);
@@ -0,0 +1,281 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include <rte_cycles.h>
+#include <rte_dev.h>
+#include <rte_ether.h>
+#include <rte_ethdev.h>
+#include <rte_mbuf.h>
+
+#define AF_PACKET_NAME "net_af_packet_test"
+#define AF_PACKET_ARGS "iface=lo,tpacket_v3=1,blocktmo=1,zerocopy=1"
+#define AF_PACKET_ETHER_TYPE 0x88b5 /* local experimental */
+#define NB_MBUF 511
+#define RING_SIZE 256
+#define BURST_SIZE 32
+#define RX_TRIES 100
+#define RX_WAIT_POLLS 4096 /* most empty polls before rte_eth_rx_wait() sleeps */
+
+static struct rte_mempool *mp;
+
+static int
+af_packet_port_start(uint8_t port)
+{
+	struct rte_eth_conf null_conf;
+
+	memset(&null_conf, 0, sizeof(struct rte_eth_conf));
+
+	if (rte_eth_dev_configure(port, 1, 1, &null_conf) < 0) {
+		printf("Configure failed for port %u\n", port);
+		return -1;
+	}
+	if (rte_eth_tx_queue_setup(port, 0, RING_SIZE, SOCKET_ID_ANY,
+			NULL) < 0) {
+		printf("TX queue setup failed port %u\n", port);
+		return -1;
+	}
+	if (rte_eth_rx_queue_setup(port, 0, RING_SIZE, SOCKET_ID_ANY,
+			NULL, mp) < 0) {
+		printf("RX queue setup failed port %u\n", port);
+		return -1;
+	}
+	if (rte_eth_dev_start(port) < 0) {
+		printf("Error starting port %u\n", port);
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Send a frame on the loopback interface */
+static int
+af_packet_send_frame(uint8_t port)
+{
+	struct ether_hdr *eth;
+	struct rte_mbuf *m;
+
+	m = rte_pktmbuf_alloc(mp);
+	if (m == NULL)
+		return -1;
+	eth = (struct ether_hdr *)rte_pktmbuf_append(m, ETHER_MIN_LEN);
+	if (eth == NULL) {
+		rte_pktmbuf_free(m);
+		return -1;
+	}
+	memset(eth, 0, ETHER_MIN_LEN);
+	memset(&eth->d_addr, 0xff, sizeof(eth->d_addr));
+	eth->ether_type = rte_cpu_to_be_16(AF_PACKET_ETHER_TYPE);
+	if (rte_eth_tx_burst(port, 0, &m, 1) != 1) {
+		rte_pktmbuf_free(m);
+		return -1;
+	}
+
+	return 0;
+}
+
+/* Receive a frame sent by af_packet_send_frame() */
+static struct rte_mbuf *
+af_packet_recv_frame(uint8_t port)
+{
+	struct rte_mbuf *bufs[BURST_SIZE], *rx = NULL;
+	struct ether_hdr *eth;
+	int i, j, nb;
+
+	/* other frames may be seen on the interface, skip them */
+	for (i = 0; i < RX_TRIES && rx == NULL; i++) {
+		nb = rte_eth_rx_burst(port, 0, bufs, BURST_SIZE);
+		for (j = 0; j < nb; j++) {
+			eth = rte_pktmbuf_mtod(bufs[j], struct ether_hdr *);
+			if (rx == NULL && eth->ether_type ==
+			    rte_cpu_to_be_16(AF_PACKET_ETHER_TYPE))
+				rx = bufs[j];
+			else
+				rte_pktmbuf_free(bufs[j]);
+		}
+		if (rx == NULL)
+			rte_delay_ms(10);
+	}
+
+	return rx;
+}
+
+/* Poll as an idle lcore does, until rte_eth_rx_wait() sleeps once */
+static int
+af_packet_rx_wait_sleep(int timeout)
+{
+	struct rte_eth_rx_wait_stats stats;
+	uint64_t sleeps;
+	int i, n;
+
+	rte_eth_rx_wait_stats_get(rte_lcore_id(), &stats);
+	sleeps = stats.sleeps;
+	for (i = 0; i < RX_WAIT_POLLS; i++) {
+		n = rte_eth_rx_wait(0, timeout);
+		rte_eth_rx_wait_stats_get(rte_lcore_id(), &stats);
+		if (stats.sleeps != sleeps)
+			return n;
+	}
+
+	return -1;
+}
+
+/*
+ * The lcore sleeps on the socket of the queue until a frame is received,
+ * and the next frame wakes it up again, even if the socket was not read
+ * in between.
+ */
+static int
+test_af_packet_rx_wait(uint8_t port)
+{
+	struct rte_mbuf *bufs[BURST_SIZE];
+	struct ether_hdr *eth;
+	int i, j, nb, ret, count = 0;
+
+	ret = rte_eth_rx_wait_queue_add(port, 0);
+	TEST_ASSERT_SUCCESS(ret, "cannot wait for port %u: %d", port, ret);
+	ret = rte_eth_rx_wait_queue_add(port, 0);
+	TEST_ASSERT_EQUAL(ret, -EEXIST, "queue added twice: %d", ret);
+
+	ret = af_packet_rx_wait_sleep(10);
+	TEST_ASSERT_EQUAL(ret, 0, "woken up without traffic: %d", ret);
+
+	for (i = 0; i < 2; i++) {
+		TEST_ASSERT_SUCCESS(af_packet_send_frame(port),
+			"cannot send frame %d", i);
+		ret = af_packet_rx_wait_sleep(1000);
+		TEST_ASSERT(ret > 0, "frame %d did not wake up: %d", i, ret);
+	}
+
+	for (i = 0; i < RX_TRIES && count < 2; i++) {
+		nb = rte_eth_rx_burst(port, 0, bufs, BURST_SIZE);
+		for (j = 0; j < nb; j++) {
+			eth = rte_pktmbuf_mtod(bufs[j], struct ether_hdr *);
+			if (eth->ether_type ==
+			    rte_cpu_to_be_16(AF_PACKET_ETHER_TYPE))
+				count++;
+			rte_pktmbuf_free(bufs[j]);
+		}
+	}
+	TEST_ASSERT_EQUAL(count, 2, "%d frames received", count);
+
+	ret = rte_eth_rx_wait_queue_del(port, 0);
+	TEST_ASSERT_SUCCESS(ret, "cannot remove queue: %d", ret);
+
+	return TEST_SUCCESS;
+}
+
+/*
+ * The device cannot be detached while a zero-copy mbuf points into its
+ * ring, and the mbuf goes back to its pool once given back, without the
+ * segment the application chained to it and still references.
+ */
+static int
+test_af_packet_zerocopy_detach(uint8_t port)
+{
+	struct rte_mbuf *m, *seg;
+	char *own_buf;
+	int ret;
+
+	TEST_ASSERT_SUCCESS(af_packet_send_frame(port), "cannot send frame");
+	m = af_packet_recv_frame(port);
+	TEST_ASSERT_NOT_NULL(m, "no frame received on port %u", port);
+	own_buf = (char *)m + sizeof(struct rte_mbuf) +
+		rte_pktmbuf_priv_size(mp);
+	TEST_ASSERT(m->buf_addr != own_buf, "frame was copied");
+
+	seg = rte_pktmbuf_alloc(mp);
+	TEST_ASSERT_NOT_NULL(seg, "cannot allocate mbuf");
+	TEST_ASSERT_SUCCESS(rte_pktmbuf_chain(m, seg), "cannot chain mbuf");
+	rte_mbuf_refcnt_update(seg, 1);
+
+	rte_eth_dev_stop(port);
+	ret = rte_eal_vdev_uninit(AF_PACKET_NAME);
+	TEST_ASSERT_EQUAL(ret, -EBUSY,
+		"detached with a zero-copy mbuf held: %d", ret);
+
+	rte_pktmbuf_free(m);
+	ret = rte_eal_vdev_uninit(AF_PACKET_NAME);
+	TEST_ASSERT_SUCCESS(ret, "cannot detach: %d", ret);
+
+	TEST_ASSERT_EQUAL(rte_mbuf_refcnt_read(seg), 1,
+		"chained segment released");
+	TEST_ASSERT_EQUAL(rte_mempool_avail_count(mp), NB_MBUF - 1,
+		"%u mbufs in the pool, expected %u",
+		rte_mempool_avail_count(mp), NB_MBUF - 1);
+	rte_pktmbuf_free(seg);
+
+	return TEST_SUCCESS;
+}
+
+static int
+test_pmd_af_packet(void)
+{
+	uint8_t port;
+	int ret;
+
+	mp = rte_mempool_lookup("af_packet_test_pool");
+	if (mp == NULL)
+		mp = rte_pktmbuf_pool_create("af_packet_test_pool", NB_MBUF,
+			0, 0, RTE_MBUF_DEFAULT_BUF_SIZE, SOCKET_ID_ANY);
+	if (mp == NULL) {
+		printf("Cannot create mbuf pool\n");
+		return -1;
+	}
+
+	/* needs CAP_NET_RAW */
+	if (rte_eal_vdev_init(AF_PACKET_NAME, AF_PACKET_ARGS) < 0) {
+		printf("Cannot create %s, skipping test\n", AF_PACKET_NAME);
+		return 0;
+	}
+	if (rte_eth_dev_get_port_by_name(AF_PACKET_NAME, &port) != 0 ||
+	    af_packet_port_start(port) < 0) {
+		rte_eal_vdev_uninit(AF_PACKET_NAME);
+		return -1;
+	}
+
+	ret = test_af_packet_rx_wait(port);
+	if (ret == TEST_SUCCESS)
+		ret = test_af_packet_zerocopy_detach(port);
+	if (ret != TEST_SUCCESS) {
+		rte_eth_dev_stop(port);
+		rte_eal_vdev_uninit(AF_PACKET_NAME);
+	}
+
+	return ret;
+}
+
+REGISTER_TEST_COMMAND(af_packet_pmd_autotest, test_pmd_af_packet);
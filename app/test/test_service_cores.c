@@ -0,0 +1,351 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include <rte_common.h>
+#include <rte_memory.h>
+#include <rte_lcore.h>
+#include <rte_cycles.h>
+#include <rte_atomic.h>
+#include <rte_service.h>
+
+#include "test.h"
+
+#define SERVICE_DELAY_MS 100
+
+static uint32_t service_id = UINT32_MAX;
+static rte_atomic32_t service_running;
+static volatile int service_overlap;
+static volatile uint8_t service_lcore_seen[RTE_MAX_LCORE];
+
+/* a service detecting the other cores running it at the same time */
+static int32_t
+dummy_service(void *args)
+{
+	RTE_SET_USED(args);
+
+	if (rte_atomic32_add_return(&service_running, 1) > 1)
+		service_overlap = 1;
+	rte_delay_us(5);
+	if (rte_lcore_id() < RTE_MAX_LCORE)
+		service_lcore_seen[rte_lcore_id()] = 1;
+	rte_atomic32_dec(&service_running);
+	return 0;
+}
+
+static int
+dummy_register(uint32_t capabilities)
+{
+	struct rte_service_spec spec;
+
+	memset(&spec, 0, sizeof(spec));
+	snprintf(spec.name, sizeof(spec.name), "service_autotest");
+	spec.callback = dummy_service;
+	spec.capabilities = capabilities;
+	spec.socket_id = SOCKET_ID_ANY;
+
+	return rte_service_register(&spec, &service_id);
+}
+
+static int
+testsuite_setup(void)
+{
+	/* the service cores are taken from the slave lcores */
+	if (rte_lcore_count() < 3) {
+		printf("Not enough lcores for service cores tests\n");
+		return -1;
+	}
+	return 0;
+}
+
+static int
+ut_setup(void)
+{
+	rte_atomic32_init(&service_running);
+	service_overlap = 0;
+	memset((void *)(uintptr_t)service_lcore_seen, 0,
+		sizeof(service_lcore_seen));
+	return 0;
+}
+
+static void
+ut_teardown(void)
+{
+	rte_service_lcore_reset_all();
+	if (service_id != UINT32_MAX) {
+		rte_service_runstate_set(service_id, 0);
+		rte_service_unregister(service_id);
+		service_id = UINT32_MAX;
+	}
+}
+
+static int
+service_register(void)
+{
+	struct rte_service_spec spec;
+	uint32_t id, count = rte_service_get_count();
+
+	TEST_ASSERT_SUCCESS(dummy_register(0), "cannot register service");
+	TEST_ASSERT_EQUAL(rte_service_get_count(), count + 1,
+		"wrong service count");
+	TEST_ASSERT_EQUAL(dummy_register(0), -EINVAL,
+		"service registered twice");
+
+	TEST_ASSERT_SUCCESS(rte_service_get_by_name("service_autotest", &id),
+		"service not found by name");
+	TEST_ASSERT_EQUAL(id, service_id, "wrong service found by name");
+	TEST_ASSERT_EQUAL(rte_service_get_by_name("no_service", &id),
+		-ENODEV, "unknown service found by name");
+	TEST_ASSERT(strcmp(rte_service_get_name(service_id),
+		"service_autotest") == 0, "wrong service name");
+	TEST_ASSERT_EQUAL(rte_service_probe_capability(service_id,
+		RTE_SERVICE_CAP_MT_SAFE), 0, "wrong service capabilities");
+
+	memset(&spec, 0, sizeof(spec));
+	snprintf(spec.name, sizeof(spec.name), "no_callback");
+	TEST_ASSERT_EQUAL(rte_service_register(&spec, &id), -EINVAL,
+		"service registered without callback");
+
+	rte_service_runstate_set(service_id, 1);
+	TEST_ASSERT_EQUAL(rte_service_unregister(service_id), -EBUSY,
+		"running service unregistered");
+	rte_service_runstate_set(service_id, 0);
+	TEST_ASSERT_SUCCESS(rte_service_unregister(service_id),
+		"cannot unregister service");
+	TEST_ASSERT_EQUAL(rte_service_get_count(), count,
+		"wrong service count");
+	TEST_ASSERT(rte_service_get_name(service_id) == NULL,
+		"unregistered service still valid");
+	service_id = UINT32_MAX;
+
+	return TEST_SUCCESS;
+}
+
+static int
+service_lcore_add_del(void)
+{
+	uint32_t master = rte_get_master_lcore();
+	uint32_t slave = rte_get_next_lcore(-1, 1, 0);
+	unsigned lcore_count = rte_lcore_count();
+	int32_t service_count = rte_service_lcore_count();
+	uint32_t list[RTE_MAX_LCORE];
+	int32_t i, n;
+
+	TEST_ASSERT_EQUAL(rte_service_lcore_add(master), -EINVAL,
+		"master lcore turned into a service core");
+	TEST_ASSERT_SUCCESS(rte_service_lcore_add(slave),
+		"cannot add service core");
+	TEST_ASSERT_EQUAL(rte_service_lcore_add(slave), -EALREADY,
+		"service core added twice");
+	TEST_ASSERT_EQUAL(rte_lcore_count(), lcore_count - 1,
+		"service core still counted as lcore");
+	TEST_ASSERT(!rte_lcore_is_enabled(slave),
+		"service core still enabled as lcore");
+	TEST_ASSERT_EQUAL(rte_service_lcore_count(), service_count + 1,
+		"wrong service core count");
+	n = rte_service_lcore_list(list, RTE_DIM(list));
+	TEST_ASSERT_EQUAL(n, service_count + 1, "wrong service core list");
+	for (i = 0; i < n && list[i] != slave; i++)
+		;
+	TEST_ASSERT(i < n, "service core not in list");
+
+	TEST_ASSERT_SUCCESS(rte_service_lcore_del(slave),
+		"cannot delete service core");
+	TEST_ASSERT_EQUAL(rte_lcore_count(), lcore_count,
+		"lcore not given back");
+	TEST_ASSERT_EQUAL(rte_service_lcore_del(slave), -EINVAL,
+		"service core deleted twice");
+
+	return TEST_SUCCESS;
+}
+
+static int
+service_lcore_run(void)
+{
+	uint32_t slave = rte_get_next_lcore(-1, 1, 0);
+	struct rte_service_stats stats;
+
+	TEST_ASSERT_SUCCESS(dummy_register(0), "cannot register service");
+	TEST_ASSERT_SUCCESS(rte_service_set_stats_enable(service_id, 1),
+		"cannot enable stats");
+	TEST_ASSERT_SUCCESS(rte_service_lcore_add(slave),
+		"cannot add service core");
+	TEST_ASSERT_SUCCESS(rte_service_map_lcore_set(service_id, slave, 1),
+		"cannot map service");
+	TEST_ASSERT_EQUAL(rte_service_map_lcore_get(service_id, slave), 1,
+		"service not mapped");
+	TEST_ASSERT_SUCCESS(rte_service_lcore_start(slave),
+		"cannot start service core");
+	TEST_ASSERT_EQUAL(rte_service_lcore_start(slave), -EALREADY,
+		"service core started twice");
+
+	/* the service is stopped: not run */
+	rte_delay_ms(SERVICE_DELAY_MS);
+	rte_service_stats_get(service_id, &stats);
+	TEST_ASSERT_EQUAL(stats.calls, 0, "stopped service was run");
+
+	rte_service_runstate_set(service_id, 1);
+	TEST_ASSERT_EQUAL(rte_service_runstate_get(service_id), 1,
+		"service not started");
+	rte_delay_ms(SERVICE_DELAY_MS);
+	rte_service_stats_get(service_id, &stats);
+	TEST_ASSERT(stats.calls > 0, "service not run");
+	TEST_ASSERT(stats.cycles > 0, "service cycles not counted");
+	TEST_ASSERT(service_lcore_seen[slave], "service run on wrong lcore");
+
+	TEST_ASSERT_EQUAL(rte_service_lcore_del(slave), -EBUSY,
+		"running service core deleted");
+	TEST_ASSERT_SUCCESS(rte_service_lcore_stop(slave),
+		"cannot stop service core");
+	rte_service_dump(stdout, UINT32_MAX);
+
+	TEST_ASSERT_SUCCESS(rte_service_stats_reset(service_id),
+		"cannot reset stats");
+	rte_service_stats_get(service_id, &stats);
+	TEST_ASSERT_EQUAL(stats.calls, 0, "stats not reset");
+
+	return TEST_SUCCESS;
+}
+
+/* run a service on two service cores, with or without MT safety */
+static int
+service_mt(uint32_t capabilities)
+{
+	uint32_t lcore1 = rte_get_next_lcore(-1, 1, 0);
+	uint32_t lcore2 = rte_get_next_lcore(lcore1, 1, 0);
+	struct rte_service_stats stats;
+
+	TEST_ASSERT_SUCCESS(dummy_register(capabilities),
+		"cannot register service");
+	TEST_ASSERT_SUCCESS(rte_service_lcore_add(lcore1),
+		"cannot add service core");
+	TEST_ASSERT_SUCCESS(rte_service_lcore_add(lcore2),
+		"cannot add service core");
+	rte_service_map_lcore_set(service_id, lcore1, 1);
+	rte_service_map_lcore_set(service_id, lcore2, 1);
+	rte_service_runstate_set(service_id, 1);
+	rte_service_lcore_start(lcore1);
+	rte_service_lcore_start(lcore2);
+
+	rte_delay_ms(SERVICE_DELAY_MS * 5);
+	rte_service_lcore_stop(lcore1);
+	rte_service_lcore_stop(lcore2);
+
+	rte_service_stats_get(service_id, &stats);
+	TEST_ASSERT(stats.calls > 0, "service not run");
+	TEST_ASSERT(service_lcore_seen[lcore1] && service_lcore_seen[lcore2],
+		"service not run on both service cores");
+	if (!(capabilities & RTE_SERVICE_CAP_MT_SAFE))
+		TEST_ASSERT(!service_overlap,
+			"MT unsafe service run by two cores at once");
+
+	return TEST_SUCCESS;
+}
+
+static int
+service_mt_unsafe(void)
+{
+	return service_mt(0);
+}
+
+static int
+service_mt_safe(void)
+{
+	return service_mt(RTE_SERVICE_CAP_MT_SAFE);
+}
+
+static int
+service_app_lcore(void)
+{
+	struct rte_service_stats stats;
+
+	TEST_ASSERT_SUCCESS(dummy_register(0), "cannot register service");
+	TEST_ASSERT_EQUAL(rte_service_run_iter_on_app_lcore(service_id),
+		-ENOEXEC, "stopped service run on app lcore");
+	rte_service_runstate_set(service_id, 1);
+	TEST_ASSERT_SUCCESS(rte_service_run_iter_on_app_lcore(service_id),
+		"cannot run service on app lcore");
+	rte_service_stats_get(service_id, &stats);
+	TEST_ASSERT_EQUAL(stats.calls, 1, "wrong service call count");
+
+	return TEST_SUCCESS;
+}
+
+static int
+service_start_with_defaults(void)
+{
+	uint32_t slave = rte_get_next_lcore(-1, 1, 0);
+	struct rte_service_stats stats;
+
+	TEST_ASSERT_EQUAL(rte_service_start_with_defaults(), -ENOTSUP,
+		"services started without service core");
+	TEST_ASSERT_SUCCESS(dummy_register(0), "cannot register service");
+	TEST_ASSERT_SUCCESS(rte_service_lcore_add(slave),
+		"cannot add service core");
+	TEST_ASSERT_SUCCESS(rte_service_start_with_defaults(),
+		"cannot start services");
+	TEST_ASSERT_EQUAL(rte_service_map_lcore_get(service_id, slave), 1,
+		"service not mapped");
+
+	rte_delay_ms(SERVICE_DELAY_MS);
+	rte_service_stats_get(service_id, &stats);
+	TEST_ASSERT(stats.calls > 0, "service not run");
+
+	return TEST_SUCCESS;
+}
+
+static struct unit_test_suite service_tests = {
+	.suite_name = "service core test suite",
+	.setup = testsuite_setup,
+	.unit_test_cases = {
+		TEST_CASE_ST(ut_setup, ut_teardown, service_register),
+		TEST_CASE_ST(ut_setup, ut_teardown, service_lcore_add_del),
+		TEST_CASE_ST(ut_setup, ut_teardown, service_lcore_run),
+		TEST_CASE_ST(ut_setup, ut_teardown, service_mt_unsafe),
+		TEST_CASE_ST(ut_setup, ut_teardown, service_mt_safe),
+		TEST_CASE_ST(ut_setup, ut_teardown, service_app_lcore),
+		TEST_CASE_ST(ut_setup, ut_teardown,
+			service_start_with_defaults),
+		TEST_CASES_END()
+	}
+};
+
+static int
+test_service_common(void)
+{
+	return unit_test_suite_runner(&service_tests);
+}
+
+REGISTER_TEST_COMMAND(service_autotest, test_service_common);
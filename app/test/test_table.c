@@ -59,6 +59,7 @@ uint64_t non_reserved_actions_hit = 0;
 uint64_t non_reserved_actions_miss = 0;
 uint8_t connect_miss_action_to_port_out = 0;
 uint8_t connect_miss_action_to_table = 0;
+uint8_t table_lookahead = 0;
 uint32_t table_entry_default_action = RTE_PIPELINE_ACTION_DROP;
 uint32_t table_entry_hit_action = RTE_PIPELINE_ACTION_PORT;
 uint32_t table_entry_miss_action = RTE_PIPELINE_ACTION_DROP;
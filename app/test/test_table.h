@@ -149,6 +149,7 @@ extern uint64_t non_reserved_actions_hit;
 extern uint64_t non_reserved_actions_miss;
 extern uint8_t connect_miss_action_to_port_out;
 extern uint8_t connect_miss_action_to_table;
+extern uint8_t table_lookahead;
 extern uint32_t table_entry_default_action;
 extern uint32_t table_entry_hit_action;
 extern uint32_t table_entry_miss_action;
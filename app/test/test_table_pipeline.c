@@ -334,6 +334,7 @@ setup_pipeline(int test_type)
 				.f_action_hit = action_handler_hit,
 				.f_action_miss = action_handler_miss,
 				.action_data_size = 0,
+				.lookahead = table_lookahead,
 		};
 
 		if (rte_pipeline_table_create(p, &table_params, &table_id[i])) {
@@ -527,6 +528,170 @@ test_pipeline_single_filter(int test_type, int expected_count)
 
 }
 
+/*
+ * Table 0 sends its hits to an output port and its misses to table 1, which
+ * is looked up ahead and sends them to the other output port. Each packet
+ * carries the input port it was sent to, so a hit sent to the output port of
+ * another burst or table is detected.
+ */
+#define LOOKAHEAD_KEY_HIT 0xadadadad
+#define LOOKAHEAD_KEY_MISS 0xfefefefe
+#define LOOKAHEAD_PORT_IN_OFFSET APP_METADATA_OFFSET(64)
+
+static int
+test_pipeline_lookahead_hit(void)
+{
+	struct rte_pipeline_params pipeline_params = {
+		.name = "PIPELINE",
+		.socket_id = 0,
+	};
+	struct rte_table_hash_key8_lru_params key8lru_params = {
+		.n_entries = 1 << 10,
+		.f_hash = pipeline_test_hash,
+		.signature_offset = APP_METADATA_OFFSET(0),
+		.key_offset = APP_METADATA_OFFSET(32),
+		.key_mask = NULL,
+	};
+	uint32_t hash_table_id[N_PORTS], next_table_id[N_PORTS];
+	uint64_t key = LOOKAHEAD_KEY_HIT;
+	int i, j, k, ret, n, tx_count = 0;
+
+	p = rte_pipeline_create(&pipeline_params);
+	if (p == NULL)
+		return -1;
+
+	for (i = 0; i < N_PORTS; i++) {
+		struct rte_port_ring_reader_params port_in_params = {
+			.ring = rings_rx[i],
+		};
+		struct rte_pipeline_port_in_params port_params = {
+			.ops = &rte_port_ring_reader_ops,
+			.arg_create = (void *) &port_in_params,
+			.burst_size = BURST_SIZE,
+		};
+		struct rte_port_ring_writer_params port_out_params = {
+			.ring = rings_tx[i],
+			.tx_burst_sz = BURST_SIZE,
+		};
+		struct rte_pipeline_port_out_params port_out = {
+			.ops = &rte_port_ring_writer_ops,
+			.arg_create = (void *) &port_out_params,
+		};
+
+		if (rte_pipeline_port_in_create(p, &port_params,
+				&port_in_id[i]) ||
+		    rte_pipeline_port_out_create(p, &port_out,
+				&port_out_id[i]))
+			goto fail;
+	}
+
+	for (i = 0; i < N_PORTS; i++) {
+		struct rte_pipeline_table_params hash_params = {
+			.ops = &rte_table_hash_key8_lru_dosig_ops,
+			.arg_create = &key8lru_params,
+		};
+		struct rte_pipeline_table_params next_params = {
+			.ops = &rte_table_stub_ops,
+			.lookahead = 1,
+		};
+		struct rte_pipeline_table_entry hit_entry = {
+			.action = RTE_PIPELINE_ACTION_PORT,
+			{.port_id = port_out_id[i]},
+		};
+		struct rte_pipeline_table_entry miss_entry = {
+			.action = RTE_PIPELINE_ACTION_TABLE,
+		};
+		struct rte_pipeline_table_entry next_entry = {
+			.action = RTE_PIPELINE_ACTION_PORT,
+			{.port_id = port_out_id[i ^ 1]},
+		};
+		struct rte_pipeline_table_entry *entry_ptr;
+		int key_found;
+
+		if (rte_pipeline_table_create(p, &hash_params,
+				&hash_table_id[i]) ||
+		    rte_pipeline_table_create(p, &next_params,
+				&next_table_id[i]))
+			goto fail;
+
+		miss_entry.table_id = next_table_id[i];
+		if (rte_pipeline_table_entry_add(p, hash_table_id[i], &key,
+				&hit_entry, &key_found, &entry_ptr) ||
+		    rte_pipeline_table_default_entry_add(p, hash_table_id[i],
+				&miss_entry, &entry_ptr) ||
+		    rte_pipeline_table_default_entry_add(p, next_table_id[i],
+				&next_entry, &entry_ptr) ||
+		    rte_pipeline_port_in_connect_to_table(p, port_in_id[i],
+				hash_table_id[i]) ||
+		    rte_pipeline_port_in_enable(p, port_in_id[i]))
+			goto fail;
+	}
+
+	if (rte_pipeline_check(p) < 0)
+		goto fail;
+
+	/* Hits and misses interleaved, over several bursts */
+	for (k = 0; k < 2; k++) {
+		for (i = 0; i < N_PORTS; i++)
+			for (j = 0; j < BURST_SIZE; j++) {
+				struct rte_mbuf *m = rte_pktmbuf_alloc(pool);
+				uint64_t *k64;
+
+				if (m == NULL)
+					goto fail;
+				k64 = RTE_MBUF_METADATA_UINT64_PTR(m,
+					APP_METADATA_OFFSET(32));
+				*k64 = (j % 3) ? LOOKAHEAD_KEY_MISS :
+					LOOKAHEAD_KEY_HIT;
+				*RTE_MBUF_METADATA_UINT32_PTR(m,
+					LOOKAHEAD_PORT_IN_OFFSET) = i;
+				rte_ring_enqueue(rings_rx[i], m);
+			}
+
+		for (i = 0; i < N_PORTS; i++)
+			rte_pipeline_run(p);
+	}
+	rte_pipeline_flush(p);
+
+	ret = 0;
+	for (i = 0; i < N_PORTS; i++) {
+		void *objs[RING_TX_SIZE];
+
+		n = rte_ring_sc_dequeue_burst(rings_tx[i], objs,
+			RING_TX_SIZE);
+		for (j = 0; j < n; j++) {
+			struct rte_mbuf *m = objs[j];
+			uint64_t k64 = *RTE_MBUF_METADATA_UINT64_PTR(m,
+				APP_METADATA_OFFSET(32));
+			uint32_t in = *RTE_MBUF_METADATA_UINT32_PTR(m,
+				LOOKAHEAD_PORT_IN_OFFSET);
+
+			if (in != (uint32_t)((k64 == LOOKAHEAD_KEY_HIT) ?
+					i : i ^ 1)) {
+				printf("Packet from port %u with key 0x%"
+					PRIx64" sent to port %d\n",
+					in, k64, i);
+				ret = -1;
+			}
+			rte_pktmbuf_free(m);
+		}
+		tx_count += n;
+	}
+
+	if (tx_count != 2 * N_PORTS * BURST_SIZE) {
+		printf("Expected %d packets out, got %d\n",
+			2 * N_PORTS * BURST_SIZE, tx_count);
+		ret = -1;
+	}
+
+	cleanup_pipeline();
+	return ret;
+
+fail:
+	cleanup_pipeline();
+	return -1;
+}
+
 int
 test_table_pipeline(void)
 {
@@ -590,6 +755,29 @@ test_table_pipeline(void)
 		return -1;
 	connect_miss_action_to_table = 0;
 
+	printf("TEST - two tables, second table looked up ahead\n");
+	connect_miss_action_to_table = 1;
+	table_lookahead = 1;
+	action_handler_miss = NULL;
+	setup_pipeline(e_TEST_STUB);
+	if (test_pipeline_single_filter(e_TEST_STUB, 4) < 0)
+		return -1;
+
+	printf("TEST - two tables, second table looked up ahead, "
+		"hitmask override to 0x01\n");
+	action_handler_miss =
+		(rte_pipeline_table_action_handler_miss)table_action_stub_miss;
+	override_miss_mask = 0x01;
+	setup_pipeline(e_TEST_STUB);
+	if (test_pipeline_single_filter(e_TEST_STUB, 2) < 0)
+		return -1;
+	connect_miss_action_to_table = 0;
+	table_lookahead = 0;
+
+	printf("TEST - hits sent to port, misses to a table looked up ahead\n");
+	if (test_pipeline_lookahead_hit() < 0)
+		return -1;
+
 	if (check_pipeline_invalid_params()) {
 		RTE_LOG(INFO, PIPELINE, "%s: Check pipeline invalid params "
 			"failed.\n", __func__);
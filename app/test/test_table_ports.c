@@ -31,12 +31,19 @@
  *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <rte_port_shm.h>
+
 #include "test_table_ports.h"
 #include "test_table.h"
 
 port_test port_tests[] = {
 	test_port_ring_reader,
 	test_port_ring_writer,
+	test_port_shm,
 };
 
 unsigned n_port_tests = RTE_DIM(port_tests);
@@ -218,3 +225,123 @@ test_port_ring_writer(void)
 
 	return 0;
 }
+
+int
+test_port_shm(void)
+{
+	struct rte_port_shm_reader_params reader_params;
+	struct rte_port_shm_writer_params writer_params;
+	struct rte_mbuf *mbuf[RTE_PORT_IN_BURST_SIZE_MAX];
+	struct rte_mbuf *res_mbuf[RTE_PORT_IN_BURST_SIZE_MAX];
+	char file_name[] = "/tmp/test_port_shm_XXXXXX";
+	void *reader, *writer;
+	int fd, status, received_pkts, i;
+
+	fd = mkstemp(file_name);
+	if (fd < 0)
+		return -1;
+	unlink(file_name);
+
+	/* Invalid params */
+	writer_params.fd = fd;
+	writer_params.n_slots = 100;
+	writer_params.slot_size = 2048;
+	writer_params.tx_burst_sz = RTE_PORT_IN_BURST_SIZE_MAX;
+
+	writer = rte_port_shm_writer_ops.f_create(&writer_params, 0);
+	if (writer != NULL)
+		return -2;
+
+	writer_params.n_slots = 2 * RTE_PORT_IN_BURST_SIZE_MAX;
+	writer_params.slot_size = 2000;
+
+	writer = rte_port_shm_writer_ops.f_create(&writer_params, 0);
+	if (writer != NULL)
+		return -3;
+
+	/* Create */
+	writer_params.slot_size = 2048;
+	writer = rte_port_shm_writer_ops.f_create(&writer_params, 0);
+	if (writer == NULL)
+		return -4;
+
+	/* Ring geometry mismatch */
+	reader_params.fd = fd;
+	reader_params.n_slots = RTE_PORT_IN_BURST_SIZE_MAX;
+	reader_params.slot_size = 2048;
+	reader_params.mempool = pool;
+
+	reader = rte_port_shm_reader_ops.f_create(&reader_params, 0);
+	if (reader != NULL)
+		return -5;
+
+	reader_params.n_slots = 2 * RTE_PORT_IN_BURST_SIZE_MAX;
+	reader = rte_port_shm_reader_ops.f_create(&reader_params, 0);
+	if (reader == NULL)
+		return -6;
+
+	/* -- Traffic -- */
+	received_pkts = rte_port_shm_reader_ops.f_rx(reader, res_mbuf,
+		RTE_PORT_IN_BURST_SIZE_MAX);
+	if (received_pkts != 0)
+		return -7;
+
+	for (i = 0; i < RTE_PORT_IN_BURST_SIZE_MAX; i++) {
+		mbuf[i] = rte_pktmbuf_alloc(pool);
+		memset(rte_pktmbuf_append(mbuf[i], 60 + i), i, 60 + i);
+	}
+
+	rte_port_shm_writer_ops.f_tx(writer, mbuf[0]);
+	rte_port_shm_writer_ops.f_tx_bulk(writer, mbuf, (uint64_t)-2);
+
+	received_pkts = rte_port_shm_reader_ops.f_rx(reader, res_mbuf,
+		RTE_PORT_IN_BURST_SIZE_MAX);
+	if (received_pkts != RTE_PORT_IN_BURST_SIZE_MAX)
+		return -8;
+
+	for (i = 0; i < RTE_PORT_IN_BURST_SIZE_MAX; i++) {
+		uint8_t *data = rte_pktmbuf_mtod(res_mbuf[i], uint8_t *);
+
+		if ((res_mbuf[i]->pkt_len != (uint32_t) (60 + i)) ||
+			(data[0] != i) || (data[59 + i] != i))
+			return -9;
+
+		rte_pktmbuf_free(res_mbuf[i]);
+	}
+
+	/* Ring full: the writer drops what does not fit */
+	for (i = 0; i < 3; i++) {
+		int j;
+
+		for (j = 0; j < RTE_PORT_IN_BURST_SIZE_MAX; j++) {
+			mbuf[j] = rte_pktmbuf_alloc(pool);
+			rte_pktmbuf_append(mbuf[j], 64);
+		}
+		rte_port_shm_writer_ops.f_tx_bulk(writer, mbuf, (uint64_t)-1);
+	}
+
+	for (i = 0; i < 3; i++) {
+		int j;
+
+		received_pkts = rte_port_shm_reader_ops.f_rx(reader, res_mbuf,
+			RTE_PORT_IN_BURST_SIZE_MAX);
+		if (received_pkts != ((i < 2) ? RTE_PORT_IN_BURST_SIZE_MAX : 0))
+			return -10;
+
+		for (j = 0; j < received_pkts; j++)
+			rte_pktmbuf_free(res_mbuf[j]);
+	}
+
+	/* Free */
+	status = rte_port_shm_writer_ops.f_free(writer);
+	if (status != 0)
+		return -11;
+
+	status = rte_port_shm_reader_ops.f_free(reader);
+	if (status != 0)
+		return -12;
+
+	close(fd);
+
+	return 0;
+}
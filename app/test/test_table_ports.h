@@ -34,6 +34,7 @@
 /* Test prototypes */
 int test_port_ring_reader(void);
 int test_port_ring_writer(void);
+int test_port_shm(void);
 
 /* Extern variables */
 typedef int (*port_test)(void);
@@ -46,6 +46,7 @@ table_test table_tests[] = {
 	test_table_lpm_ipv6,
 	test_table_hash_lru,
 	test_table_hash_ext,
+	test_table_hash_key,
 	test_table_hash_cuckoo,
 };
 
@@ -70,6 +71,9 @@ static int
 test_table_hash_lru_generic(struct rte_table_ops *ops);
 static int
 test_table_hash_ext_generic(struct rte_table_ops *ops);
+static int
+test_table_hash_key_traffic(struct rte_table_ops *ops, void *table,
+	uint32_t key_size, uint32_t n_keys);
 
 struct rte_bucket_4_8 {
 	/* Cache line 0 */
@@ -945,6 +949,148 @@ test_table_hash_ext(void)
 }
 
 
+static int
+test_table_hash_key_traffic(struct rte_table_ops *ops, void *table,
+	uint32_t key_size, uint32_t n_keys)
+{
+	int status, key_found;
+	uint32_t i;
+	uint64_t expected_mask = 0, result_mask;
+	struct rte_mbuf *mbufs[RTE_PORT_IN_BURST_SIZE_MAX];
+	char *entries[RTE_PORT_IN_BURST_SIZE_MAX];
+	uint8_t key[RTE_TABLE_HASH_KEY_SIZE_MAX];
+	uint32_t *k32 = (uint32_t *) key;
+	void *entry_ptr;
+	char entry;
+
+	/* All the keys share the same signature and only differ in their
+	 * last byte, so they all land in the same bucket chain. */
+	memset(key, 0, sizeof(key));
+	k32[0] = rte_be_to_cpu_32(0xadadadad);
+
+	for (i = 0; i < n_keys; i++) {
+		key[key_size - 1] = i + 1;
+		entry = 'A' + i;
+		status = ops->f_add(table, key, &entry, &key_found, &entry_ptr);
+		if ((status != 0) || (key_found != 0))
+			return -1;
+	}
+
+	for (i = 0; i < RTE_PORT_IN_BURST_SIZE_MAX; i++) {
+		uint32_t *signature;
+		uint8_t *pkt_key;
+
+		mbufs[i] = rte_pktmbuf_alloc(pool);
+		if (mbufs[i] == NULL)
+			return -2;
+
+		signature = RTE_MBUF_METADATA_UINT32_PTR(mbufs[i],
+			APP_METADATA_OFFSET(0));
+		pkt_key = RTE_MBUF_METADATA_UINT8_PTR(mbufs[i],
+			APP_METADATA_OFFSET(32));
+
+		memcpy(pkt_key, key, key_size);
+		if (i % 2 == 0) {
+			expected_mask |= (uint64_t)1 << i;
+			pkt_key[key_size - 1] = (i / 2) % n_keys + 1;
+		} else
+			pkt_key[key_size - 1] = 0x80;
+		*signature = pipeline_test_hash(pkt_key, 0, 0);
+	}
+
+	ops->f_lookup(table, mbufs, -1, &result_mask, (void **)entries);
+	if (result_mask != expected_mask)
+		return -3;
+
+	for (i = 0; i < RTE_PORT_IN_BURST_SIZE_MAX; i += 2)
+		if (*entries[i] != (char) ('A' + (i / 2) % n_keys))
+			return -4;
+
+	/* Lookup with less packets than the pipeline depth */
+	ops->f_lookup(table, mbufs, 0x7, &result_mask, (void **)entries);
+	if (result_mask != (expected_mask & 0x7))
+		return -5;
+
+	for (i = 0; i < RTE_PORT_IN_BURST_SIZE_MAX; i++)
+		rte_pktmbuf_free(mbufs[i]);
+
+	/* Delete */
+	for (i = 0; i < n_keys; i++) {
+		key[key_size - 1] = i + 1;
+		status = ops->f_delete(table, key, &key_found, &entry);
+		if ((status != 0) || (key_found != 1) ||
+			(entry != (char) ('A' + i)))
+			return -6;
+	}
+
+	return 0;
+}
+
+int
+test_table_hash_key(void)
+{
+	uint32_t key_size;
+	void *table;
+	int status;
+
+	struct rte_table_hash_key_lru_params lru_params = {
+		.key_size = 20,
+		.n_entries = 1 << 10,
+		.f_hash = pipeline_test_hash,
+		.seed = 0,
+		.signature_offset = APP_METADATA_OFFSET(0),
+		.key_offset = APP_METADATA_OFFSET(32),
+	};
+
+	struct rte_table_hash_key_ext_params ext_params = {
+		.key_size = RTE_TABLE_HASH_KEY_SIZE_MAX + 8,
+		.n_entries = 1 << 10,
+		.n_entries_ext = 1 << 4,
+		.f_hash = pipeline_test_hash,
+		.seed = 0,
+		.signature_offset = APP_METADATA_OFFSET(0),
+		.key_offset = APP_METADATA_OFFSET(32),
+	};
+
+	/* Invalid key size */
+	table = rte_table_hash_key_lru_ops.f_create(&lru_params, 0, 1);
+	if (table != NULL)
+		return -1;
+
+	table = rte_table_hash_key_ext_ops.f_create(&ext_params, 0, 1);
+	if (table != NULL)
+		return -2;
+
+	for (key_size = 8; key_size <= RTE_TABLE_HASH_KEY_SIZE_MAX;
+		key_size += 8) {
+		/* LRU: up to 4 keys per bucket */
+		lru_params.key_size = key_size;
+		table = rte_table_hash_key_lru_ops.f_create(&lru_params, 0, 1);
+		if (table == NULL)
+			return -3;
+
+		status = test_table_hash_key_traffic(&rte_table_hash_key_lru_ops,
+			table, key_size, 4);
+		rte_table_hash_key_lru_ops.f_free(table);
+		if (status < 0)
+			return status - 10;
+
+		/* Extendible bucket: force a bucket extension */
+		ext_params.key_size = key_size;
+		table = rte_table_hash_key_ext_ops.f_create(&ext_params, 0, 1);
+		if (table == NULL)
+			return -4;
+
+		status = test_table_hash_key_traffic(&rte_table_hash_key_ext_ops,
+			table, key_size, 6);
+		rte_table_hash_key_ext_ops.f_free(table);
+		if (status < 0)
+			return status - 20;
+	}
+
+	return 0;
+}
+
 int
 test_table_hash_cuckoo(void)
 {
@@ -0,0 +1,322 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <rte_common.h>
+#include <rte_lcore.h>
+#include <rte_ring.h>
+#include <rte_trace.h>
+
+#include "test.h"
+
+#define TRACE_NB_EVENTS 5
+
+/* size of the CTF packet header and of the events */
+#define TRACE_HEADER_SIZE (2 * sizeof(uint32_t))
+#define TRACE_EVENT_SIZE(nb_fields) \
+	(sizeof(uint64_t) + sizeof(uint16_t) + (nb_fields) * sizeof(uint64_t))
+
+RTE_TRACE_POINT_DEFINE(test_trace_tp, "app.test.trace", "a", "b")
+RTE_TRACE_POINT_DEFINE(test_trace_tp_other, "app.test.other", "c")
+
+static char trace_dir[64];
+
+static void
+trace_dir_clean(void)
+{
+	char path[PATH_MAX];
+	unsigned int lcore_id;
+
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		snprintf(path, sizeof(path), "%s/channel0_%u",
+			trace_dir, lcore_id);
+		unlink(path);
+	}
+	snprintf(path, sizeof(path), "%s/metadata", trace_dir);
+	unlink(path);
+}
+
+static int
+testsuite_setup(void)
+{
+	snprintf(trace_dir, sizeof(trace_dir), "/tmp/dpdk-trace-XXXXXX");
+	if (mkdtemp(trace_dir) == NULL) {
+		printf("Cannot create the trace directory\n");
+		return TEST_FAILED;
+	}
+	return TEST_SUCCESS;
+}
+
+static void
+testsuite_teardown(void)
+{
+	rmdir(trace_dir);
+}
+
+static int
+ut_setup(void)
+{
+	rte_trace_pattern("*", 0);
+	rte_trace_reset();
+	return TEST_SUCCESS;
+}
+
+static void
+ut_teardown(void)
+{
+	rte_trace_pattern("*", 0);
+	rte_trace_reset();
+	trace_dir_clean();
+}
+
+/* read the stream of the current lcore, return its size or -1 */
+static long
+trace_stream_read(void *data, size_t size)
+{
+	char path[PATH_MAX];
+	struct stat st;
+	FILE *f;
+	size_t len;
+
+	snprintf(path, sizeof(path), "%s/channel0_%u",
+		trace_dir, rte_lcore_id());
+	if (stat(path, &st) < 0)
+		return -1;
+	if (data == NULL)
+		return st.st_size;
+
+	f = fopen(path, "r");
+	if (f == NULL)
+		return -1;
+	len = fread(data, 1, size, f);
+	fclose(f);
+	return len;
+}
+
+static int
+trace_registration(void)
+{
+	static const char * const lib_tp[] = {
+		"lib.ethdev.rx_burst", "lib.ethdev.tx_burst",
+		"lib.mempool.get", "lib.mempool.put",
+		"lib.ring.enqueue", "lib.ring.dequeue",
+		"lib.cryptodev.enqueue_burst", "lib.cryptodev.dequeue_burst",
+	};
+	unsigned int i;
+
+	TEST_ASSERT_EQUAL(rte_trace_point_lookup("app.test.trace"),
+		&test_trace_tp, "tracepoint not found");
+	TEST_ASSERT_EQUAL(test_trace_tp.nb_fields, 2, "wrong field count");
+	TEST_ASSERT_NULL(rte_trace_point_lookup("app.test.none"),
+		"unknown tracepoint found");
+	TEST_ASSERT_EQUAL(rte_trace_point_register(&test_trace_tp), -EEXIST,
+		"tracepoint registered twice");
+
+	for (i = 0; i < RTE_DIM(lib_tp); i++)
+		TEST_ASSERT_NOT_NULL(rte_trace_point_lookup(lib_tp[i]),
+			"tracepoint %s not found", lib_tp[i]);
+
+	return TEST_SUCCESS;
+}
+
+static int
+trace_enable_pattern(void)
+{
+	TEST_ASSERT(!rte_trace_point_is_enabled(&test_trace_tp),
+		"tracepoint enabled by default");
+
+	rte_trace_point_enable(&test_trace_tp);
+	TEST_ASSERT(rte_trace_point_is_enabled(&test_trace_tp),
+		"tracepoint not enabled");
+	rte_trace_point_disable(&test_trace_tp);
+	TEST_ASSERT(!rte_trace_point_is_enabled(&test_trace_tp),
+		"tracepoint not disabled");
+
+	TEST_ASSERT_EQUAL(rte_trace_pattern("app.test.*", 1), 2,
+		"wrong number of matching tracepoints");
+	TEST_ASSERT(rte_trace_point_is_enabled(&test_trace_tp_other),
+		"tracepoint not enabled by pattern");
+	TEST_ASSERT_EQUAL(rte_trace_pattern("app.test.o*", 0), 1,
+		"wrong number of matching tracepoints");
+	TEST_ASSERT(!rte_trace_point_is_enabled(&test_trace_tp_other),
+		"tracepoint not disabled by pattern");
+	TEST_ASSERT(rte_trace_point_is_enabled(&test_trace_tp),
+		"tracepoint disabled by a non-matching pattern");
+	TEST_ASSERT_EQUAL(rte_trace_pattern("lib.ring.*", 1), 2,
+		"wrong number of ring tracepoints");
+
+	return TEST_SUCCESS;
+}
+
+static int
+trace_save(void)
+{
+	uint8_t data[TRACE_HEADER_SIZE + TRACE_NB_EVENTS * TRACE_EVENT_SIZE(2)];
+	char metadata[8192];
+	char path[PATH_MAX];
+	uint32_t header[2];
+	uint64_t args[2];
+	uint16_t id;
+	uint8_t *ev;
+	FILE *f;
+	size_t len;
+	unsigned int i;
+
+	/* disabled tracepoints record nothing */
+	for (i = 0; i < TRACE_NB_EVENTS; i++)
+		rte_trace_point_emit(test_trace_tp, i, 0);
+
+	rte_trace_point_enable(&test_trace_tp);
+	for (i = 0; i < TRACE_NB_EVENTS - 1; i++)
+		rte_trace_point_emit(test_trace_tp, i, 2 * i);
+	/* the missing fields are recorded as zero */
+	rte_trace_point_emit(test_trace_tp, i);
+
+	TEST_ASSERT_SUCCESS(rte_trace_save(trace_dir), "cannot save trace");
+	TEST_ASSERT_EQUAL(trace_stream_read(NULL, 0),
+		(long)sizeof(data), "wrong stream size");
+	TEST_ASSERT_EQUAL(trace_stream_read(data, sizeof(data)),
+		(long)sizeof(data), "cannot read stream");
+
+	memcpy(header, data, sizeof(header));
+	TEST_ASSERT_EQUAL(header[0], 0xC1FC1FC1, "wrong CTF magic");
+	TEST_ASSERT_EQUAL(header[1], rte_lcore_id(), "wrong lcore");
+	for (i = 0; i < TRACE_NB_EVENTS; i++) {
+		ev = data + TRACE_HEADER_SIZE + i * TRACE_EVENT_SIZE(2);
+		memcpy(&id, ev + sizeof(uint64_t), sizeof(id));
+		memcpy(args, ev + sizeof(uint64_t) + sizeof(id), sizeof(args));
+		TEST_ASSERT_EQUAL(id, test_trace_tp.id, "wrong event id");
+		TEST_ASSERT_EQUAL(args[0], i, "wrong first field");
+		TEST_ASSERT_EQUAL(args[1],
+			(i < TRACE_NB_EVENTS - 1 ? 2 * i : 0),
+			"wrong second field");
+	}
+
+	snprintf(path, sizeof(path), "%s/metadata", trace_dir);
+	f = fopen(path, "r");
+	TEST_ASSERT_NOT_NULL(f, "cannot open metadata");
+	len = fread(metadata, 1, sizeof(metadata) - 1, f);
+	fclose(f);
+	metadata[len] = '\0';
+	TEST_ASSERT(strncmp(metadata, "/* CTF 1.8 */", 13) == 0,
+		"wrong metadata signature");
+	TEST_ASSERT_NOT_NULL(strstr(metadata, "name = \"app.test.trace\";"),
+		"event missing in metadata");
+	TEST_ASSERT_NOT_NULL(strstr(metadata, "uint64_t b;"),
+		"field missing in metadata");
+
+	return TEST_SUCCESS;
+}
+
+static int
+trace_overwrite(void)
+{
+	unsigned int i;
+
+	rte_trace_point_enable(&test_trace_tp_other);
+	for (i = 0; i < RTE_TRACE_BUF_SIZE + 10; i++)
+		rte_trace_point_emit(test_trace_tp_other, i);
+
+	TEST_ASSERT_SUCCESS(rte_trace_save(trace_dir), "cannot save trace");
+	TEST_ASSERT_EQUAL(trace_stream_read(NULL, 0),
+		(long)(TRACE_HEADER_SIZE +
+			RTE_TRACE_BUF_SIZE * TRACE_EVENT_SIZE(1)),
+		"wrong stream size");
+
+	return TEST_SUCCESS;
+}
+
+static int
+trace_ring(void)
+{
+	uint8_t data[TRACE_HEADER_SIZE + 2 * TRACE_EVENT_SIZE(2)];
+	struct rte_ring *r;
+	void *obj = NULL;
+	uint64_t args[2];
+	uint16_t id;
+	int ret;
+
+	r = rte_ring_create("trace_autotest", 16, SOCKET_ID_ANY, 0);
+	TEST_ASSERT_NOT_NULL(r, "cannot create ring");
+
+	TEST_ASSERT_EQUAL(rte_trace_pattern("lib.ring.*", 1), 2,
+		"wrong number of ring tracepoints");
+	ret = rte_ring_enqueue(r, obj);
+	if (ret == 0)
+		ret = rte_ring_dequeue(r, &obj);
+	rte_trace_pattern("lib.ring.*", 0);
+	rte_ring_free(r);
+	TEST_ASSERT_SUCCESS(ret, "ring enqueue/dequeue failed");
+
+	TEST_ASSERT_SUCCESS(rte_trace_save(trace_dir), "cannot save trace");
+	TEST_ASSERT_EQUAL(trace_stream_read(data, sizeof(data)),
+		(long)sizeof(data), "wrong stream size");
+
+	memcpy(&id, data + TRACE_HEADER_SIZE + sizeof(uint64_t), sizeof(id));
+	memcpy(args, data + TRACE_HEADER_SIZE + sizeof(uint64_t) + sizeof(id),
+		sizeof(args));
+	TEST_ASSERT_EQUAL(id, rte_ring_trace_enqueue.id, "wrong event id");
+	TEST_ASSERT_EQUAL(args[0], (uintptr_t)r, "wrong ring");
+	TEST_ASSERT_EQUAL(args[1], 1, "wrong object count");
+
+	return TEST_SUCCESS;
+}
+
+static struct unit_test_suite trace_tests = {
+	.suite_name = "trace test suite",
+	.setup = testsuite_setup,
+	.teardown = testsuite_teardown,
+	.unit_test_cases = {
+		TEST_CASE_ST(ut_setup, ut_teardown, trace_registration),
+		TEST_CASE_ST(ut_setup, ut_teardown, trace_enable_pattern),
+		TEST_CASE_ST(ut_setup, ut_teardown, trace_save),
+		TEST_CASE_ST(ut_setup, ut_teardown, trace_overwrite),
+		TEST_CASE_ST(ut_setup, ut_teardown, trace_ring),
+		TEST_CASES_END()
+	}
+};
+
+static int
+test_trace(void)
+{
+	return unit_test_suite_runner(&trace_tests);
+}
+
+REGISTER_TEST_COMMAND(trace_autotest, test_trace);
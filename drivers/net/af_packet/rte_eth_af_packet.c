@@ -40,6 +40,7 @@
 #include <rte_ethdev.h>
 #include <rte_malloc.h>
 #include <rte_kvargs.h>
+#include <rte_net.h>
 #include <rte_vdev.h>
 
 #include <linux/if_ether.h>
@@ -58,6 +59,11 @@
 #define ETH_AF_PACKET_BLOCKSIZE_ARG	"blocksz"
 #define ETH_AF_PACKET_FRAMESIZE_ARG	"framesz"
 #define ETH_AF_PACKET_FRAMECOUNT_ARG	"framecnt"
+#define ETH_AF_PACKET_TPACKET_V3_ARG	"tpacket_v3"
+#define ETH_AF_PACKET_BLOCKTMO_ARG	"blocktmo"
+#define ETH_AF_PACKET_QDISC_BYPASS_ARG	"qdisc_bypass"
+#define ETH_AF_PACKET_FANOUT_MODE_ARG	"fanout_mode"
+#define ETH_AF_PACKET_ZEROCOPY_ARG	"zerocopy"
 
 #define DFLT_BLOCK_SIZE		(1 << 12)
 #define DFLT_FRAME_SIZE		(1 << 11)
@@ -65,14 +71,46 @@
 
 #define RTE_PMD_AF_PACKET_MAX_RINGS 16
 
+/*
+ * Zero-copy receive never holds more than half of the TPACKET_V3 blocks,
+ * so that the kernel always has room to keep receiving.
+ */
+#define AF_PACKET_ZCOPY_MAX_BLOCKS(q) ((q)->blockcount / 2)
+
+struct pkt_rx_block {
+	uint32_t nb_zmbufs;	/* zero-copy mbufs still referencing the block */
+	int consumed;		/* all packets of the block were received */
+};
+
+struct pkt_zmbuf {
+	struct rte_mbuf *mbuf;
+	unsigned int block;
+};
+
 struct pkt_rx_queue {
 	int sockfd;
 
 	struct iovec *rd;
 	uint8_t *map;
+	unsigned int map_size;
 	unsigned int framecount;
 	unsigned int framenum;
 
+	/* TPACKET_V3 block ring */
+	unsigned int blocksize;
+	unsigned int blockcount;
+	unsigned int blocknum;
+	unsigned int block_pkts;
+	uint8_t *next_pkt;
+
+	/* zero-copy receive, TPACKET_V3 only */
+	int zero_copy;
+	struct pkt_rx_block *blocks;
+	struct pkt_zmbuf *zmbufs;
+	unsigned int nr_zmbufs;
+	unsigned int max_zmbufs;
+	unsigned int blocks_held;
+
 	struct rte_mempool *mb_pool;
 	uint8_t in_port;
 
@@ -87,6 +125,7 @@ struct pkt_tx_queue {
 
 	struct iovec *rd;
 	uint8_t *map;
+	unsigned int map_size;	/* 0 when the ring is mapped with the Rx one */
 	unsigned int framecount;
 	unsigned int framenum;
 
@@ -103,6 +142,7 @@ struct pmd_internals {
 	struct ether_addr eth_addr;
 
 	struct tpacket_req req;
+	int tpacket_v3;
 
 	struct pkt_rx_queue rx_queue[RTE_PMD_AF_PACKET_MAX_RINGS];
 	struct pkt_tx_queue tx_queue[RTE_PMD_AF_PACKET_MAX_RINGS];
@@ -114,9 +154,34 @@ static const char *valid_arguments[] = {
 	ETH_AF_PACKET_BLOCKSIZE_ARG,
 	ETH_AF_PACKET_FRAMESIZE_ARG,
 	ETH_AF_PACKET_FRAMECOUNT_ARG,
+	ETH_AF_PACKET_TPACKET_V3_ARG,
+	ETH_AF_PACKET_BLOCKTMO_ARG,
+	ETH_AF_PACKET_QDISC_BYPASS_ARG,
+	ETH_AF_PACKET_FANOUT_MODE_ARG,
+	ETH_AF_PACKET_ZEROCOPY_ARG,
 	NULL
 };
 
+#if defined(PACKET_FANOUT)
+static const struct {
+	const char *name;
+	int mode;
+} fanout_modes[] = {
+	{ "hash", PACKET_FANOUT_HASH },
+	{ "lb", PACKET_FANOUT_LB },
+	{ "cpu", PACKET_FANOUT_CPU },
+#if defined(PACKET_FANOUT_ROLLOVER)
+	{ "rollover", PACKET_FANOUT_ROLLOVER },
+#endif
+#if defined(PACKET_FANOUT_RND)
+	{ "rnd", PACKET_FANOUT_RND },
+#endif
+#if defined(PACKET_FANOUT_QM)
+	{ "qm", PACKET_FANOUT_QM },
+#endif
+};
+#endif
+
 static struct rte_eth_link pmd_link = {
 	.link_speed = ETH_SPEED_NUM_10G,
 	.link_duplex = ETH_LINK_FULL_DUPLEX,
@@ -184,21 +249,264 @@ eth_af_packet_rx(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 	return num_rx;
 }
 
+static inline struct tpacket_block_desc *
+rx_block(struct pkt_rx_queue *pkt_q, unsigned int blocknum)
+{
+	return (struct tpacket_block_desc *)
+		(pkt_q->map + blocknum * pkt_q->blocksize);
+}
+
+/* hand a fully received block back to the kernel */
+static inline void
+rx_block_release(struct pkt_rx_queue *pkt_q, unsigned int blocknum)
+{
+	rte_smp_wmb();
+	rx_block(pkt_q, blocknum)->hdr.bh1.block_status = TP_STATUS_KERNEL;
+}
+
+/*
+ * Restore the mbuf's own data buffer once a zero-copy mbuf is given back,
+ * so that it can be freed to its pool. The segments the application may
+ * have chained to it were freed along with its reference.
+ */
+static inline void
+zmbuf_restore(struct rte_mbuf *m)
+{
+	struct rte_mempool *mp = m->pool;
+	uint32_t mbuf_size;
+
+	mbuf_size = sizeof(struct rte_mbuf) + rte_pktmbuf_priv_size(mp);
+	m->buf_addr = (char *)m + mbuf_size;
+	m->buf_physaddr = rte_mempool_virt2phy(mp, m) + mbuf_size;
+	m->buf_len = (uint16_t)rte_pktmbuf_data_room_size(mp);
+	m->next = NULL;
+	m->nb_segs = 1;
+}
+
+/*
+ * Free the zero-copy mbufs the application is done with, and give their
+ * blocks back to the kernel when nothing references them any more.
+ */
+static void
+eth_af_packet_rx_zmbufs_free(struct pkt_rx_queue *pkt_q)
+{
+	struct pkt_zmbuf *zmbuf;
+	struct pkt_rx_block *blk;
+	unsigned int i, n = 0;
+
+	for (i = 0; i < pkt_q->nr_zmbufs; i++) {
+		zmbuf = &pkt_q->zmbufs[i];
+		if (rte_mbuf_refcnt_read(zmbuf->mbuf) > 1) {
+			pkt_q->zmbufs[n++] = *zmbuf;
+			continue;
+		}
+
+		zmbuf_restore(zmbuf->mbuf);
+		rte_pktmbuf_free_seg(zmbuf->mbuf);
+
+		blk = &pkt_q->blocks[zmbuf->block];
+		if (--blk->nb_zmbufs == 0 && blk->consumed) {
+			blk->consumed = 0;
+			pkt_q->blocks_held--;
+			rx_block_release(pkt_q, zmbuf->block);
+		}
+	}
+	pkt_q->nr_zmbufs = n;
+}
+
+/*
+ * The rings cannot be unmapped while the application holds zero-copy
+ * mbufs pointing into them: reclaim the released ones, and tell whether
+ * some are still outstanding.
+ */
+static int
+eth_af_packet_zmbufs_busy(struct pmd_internals *internals)
+{
+	struct pkt_rx_queue *pkt_q;
+	unsigned int q;
+	int busy = 0;
+
+	for (q = 0; q < internals->nb_queues; q++) {
+		pkt_q = &internals->rx_queue[q];
+		if (pkt_q->nr_zmbufs != 0)
+			eth_af_packet_rx_zmbufs_free(pkt_q);
+		if (pkt_q->nr_zmbufs != 0)
+			busy = 1;
+	}
+
+	return busy;
+}
+
+/*
+ * TPACKET_V3 receive: the kernel fills whole blocks of variable sized
+ * frames and hands them over at once, either when full or when the block
+ * timeout expires.
+ */
+static uint16_t
+eth_af_packet_rx_v3(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
+{
+	struct pkt_rx_queue *pkt_q = queue;
+	struct tpacket_block_desc *pbd;
+	struct tpacket3_hdr *ppd;
+	struct pkt_rx_block *blk;
+	struct rte_mbuf *mbuf;
+	uint16_t num_rx = 0;
+	unsigned long num_rx_bytes = 0;
+	int zero_copy;
+
+	if (unlikely(nb_pkts == 0))
+		return 0;
+
+	if (pkt_q->nr_zmbufs != 0)
+		eth_af_packet_rx_zmbufs_free(pkt_q);
+
+	while (num_rx < nb_pkts) {
+		/* move to the next block once the current one is drained */
+		if (pkt_q->block_pkts == 0) {
+			pbd = rx_block(pkt_q, pkt_q->blocknum);
+			if ((pbd->hdr.bh1.block_status & TP_STATUS_USER) == 0)
+				break;
+			rte_smp_rmb();
+
+			pkt_q->block_pkts = pbd->hdr.bh1.num_pkts;
+			pkt_q->next_pkt = (uint8_t *)pbd +
+				pbd->hdr.bh1.offset_to_first_pkt;
+			if (unlikely(pkt_q->block_pkts == 0)) {
+				rx_block_release(pkt_q, pkt_q->blocknum);
+				if (++pkt_q->blocknum >= pkt_q->blockcount)
+					pkt_q->blocknum = 0;
+				continue;
+			}
+		}
+
+		mbuf = rte_pktmbuf_alloc(pkt_q->mb_pool);
+		if (unlikely(mbuf == NULL))
+			break;
+
+		ppd = (struct tpacket3_hdr *)pkt_q->next_pkt;
+		blk = &pkt_q->blocks[pkt_q->blocknum];
+		zero_copy = pkt_q->zero_copy &&
+			pkt_q->nr_zmbufs < pkt_q->max_zmbufs &&
+			pkt_q->blocks_held < AF_PACKET_ZCOPY_MAX_BLOCKS(pkt_q);
+
+		if (zero_copy) {
+			/*
+			 * Point the mbuf at the frame in the ring; the kernel
+			 * header in front of it serves as headroom.
+			 */
+			mbuf->buf_addr = ppd;
+			mbuf->buf_physaddr = RTE_BAD_PHYS_ADDR;
+			mbuf->buf_len = ppd->tp_mac + ppd->tp_snaplen;
+			mbuf->data_off = ppd->tp_mac;
+			rte_mbuf_refcnt_update(mbuf, 1);
+
+			pkt_q->zmbufs[pkt_q->nr_zmbufs].mbuf = mbuf;
+			pkt_q->zmbufs[pkt_q->nr_zmbufs].block = pkt_q->blocknum;
+			pkt_q->nr_zmbufs++;
+			blk->nb_zmbufs++;
+		} else if (unlikely(ppd->tp_snaplen >
+				    rte_pktmbuf_tailroom(mbuf))) {
+			/* frame is larger than the mbuf, drop it */
+			rte_pktmbuf_free(mbuf);
+			mbuf = NULL;
+			pkt_q->err_pkts++;
+		} else {
+			memcpy(rte_pktmbuf_mtod(mbuf, void *),
+			       (uint8_t *)ppd + ppd->tp_mac, ppd->tp_snaplen);
+		}
+
+		if (likely(mbuf != NULL)) {
+			rte_pktmbuf_pkt_len(mbuf) = rte_pktmbuf_data_len(mbuf) =
+				ppd->tp_snaplen;
+
+			/* check for vlan info */
+			if (ppd->tp_status & TP_STATUS_VLAN_VALID) {
+				mbuf->vlan_tci = ppd->hv1.tp_vlan_tci;
+				mbuf->ol_flags |= (PKT_RX_VLAN_PKT |
+						   PKT_RX_VLAN_STRIPPED);
+			}
+			mbuf->hash.rss = ppd->hv1.tp_rxhash;
+			mbuf->ol_flags |= PKT_RX_RSS_HASH;
+			mbuf->port = pkt_q->in_port;
+
+			bufs[num_rx++] = mbuf;
+			num_rx_bytes += mbuf->pkt_len;
+		}
+
+		/* advance, and give the block back once fully received */
+		pkt_q->next_pkt += ppd->tp_next_offset;
+		if (--pkt_q->block_pkts == 0) {
+			if (blk->nb_zmbufs == 0) {
+				rx_block_release(pkt_q, pkt_q->blocknum);
+			} else {
+				blk->consumed = 1;
+				pkt_q->blocks_held++;
+			}
+			if (++pkt_q->blocknum >= pkt_q->blockcount)
+				pkt_q->blocknum = 0;
+		}
+	}
+
+	pkt_q->rx_pkts += num_rx;
+	pkt_q->rx_bytes += num_rx_bytes;
+	return num_rx;
+}
+
+/*
+ * Copy one packet into the next free TX frame and hand the frame over to
+ * the kernel. Returns 0 on success, -1 if the packet was too large and -2
+ * if no frame could be obtained.
+ */
+static int
+eth_af_packet_tx_frame(struct pkt_tx_queue *pkt_q, struct pollfd *pfd,
+		       unsigned int *framenum, struct rte_mbuf *mbuf)
+{
+	struct tpacket2_hdr *ppd;
+	struct rte_mbuf *seg;
+	uint8_t *pbuf;
+
+	/* drop oversized packets */
+	if (rte_pktmbuf_pkt_len(mbuf) > pkt_q->frame_data_size)
+		return -1;
+
+	/* point at the next incoming frame */
+	ppd = (struct tpacket2_hdr *) pkt_q->rd[*framenum].iov_base;
+	if ((ppd->tp_status != TP_STATUS_AVAILABLE) &&
+	    (poll(pfd, 1, -1) < 0))
+		return -2;
+
+	/* copy the tx frame data */
+	pbuf = (uint8_t *) ppd + TPACKET2_HDRLEN -
+		sizeof(struct sockaddr_ll);
+	for (seg = mbuf; seg != NULL; seg = seg->next) {
+		memcpy(pbuf, rte_pktmbuf_mtod(seg, void *),
+		       rte_pktmbuf_data_len(seg));
+		pbuf += rte_pktmbuf_data_len(seg);
+	}
+	ppd->tp_len = ppd->tp_snaplen = rte_pktmbuf_pkt_len(mbuf);
+
+	/* release incoming frame and advance ring buffer */
+	ppd->tp_status = TP_STATUS_SEND_REQUEST;
+	if (++*framenum >= pkt_q->framecount)
+		*framenum = 0;
+
+	return 0;
+}
+
 /*
  * Callback to handle sending packets through a real NIC.
  */
 static uint16_t
 eth_af_packet_tx(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 {
-	struct tpacket2_hdr *ppd;
+	struct rte_mbuf *pkts[RTE_NET_SW_TX_MAX_PKTS];
 	struct rte_mbuf *mbuf;
-	uint8_t *pbuf;
-	unsigned int framecount, framenum;
+	unsigned int framenum;
 	struct pollfd pfd;
 	struct pkt_tx_queue *pkt_q = queue;
-	uint16_t num_tx = 0;
+	uint16_t num_tx = 0, num_err = 0;
 	unsigned long num_tx_bytes = 0;
-	int i;
+	int i, j, nb, ret = 0;
 
 	if (unlikely(nb_pkts == 0))
 		return 0;
@@ -208,55 +516,64 @@ eth_af_packet_tx(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 	pfd.events = POLLOUT;
 	pfd.revents = 0;
 
-	framecount = pkt_q->framecount;
 	framenum = pkt_q->framenum;
-	ppd = (struct tpacket2_hdr *) pkt_q->rd[framenum].iov_base;
 	for (i = 0; i < nb_pkts; i++) {
 		mbuf = *bufs++;
 
-		/* drop oversized packets */
-		if (rte_pktmbuf_data_len(mbuf) > pkt_q->frame_data_size) {
+		if (likely(!(mbuf->ol_flags & RTE_NET_SW_TX_OFFLOAD_MASK))) {
+			ret = eth_af_packet_tx_frame(pkt_q, &pfd, &framenum,
+						     mbuf);
+			/* keep the packet for the caller if out of frames */
+			if (unlikely(ret == -2))
+				break;
+			if (likely(ret == 0)) {
+				num_tx++;
+				num_tx_bytes += mbuf->pkt_len;
+			} else {
+				num_err++;
+			}
 			rte_pktmbuf_free(mbuf);
 			continue;
 		}
 
-		/* insert vlan info if necessary */
-		if (mbuf->ol_flags & PKT_TX_VLAN_PKT) {
-			if (rte_vlan_insert(&mbuf)) {
-				rte_pktmbuf_free(mbuf);
-				continue;
+		/* vlan insertion, checksums and TSO are done in software */
+		nb = rte_net_sw_tx_offload(mbuf, pkts, RTE_DIM(pkts));
+		if (unlikely(nb < 0)) {
+			rte_pktmbuf_free(mbuf);
+			num_err++;
+			continue;
+		}
+		for (j = 0; j < nb; j++) {
+			if (likely(ret != -2))
+				ret = eth_af_packet_tx_frame(pkt_q, &pfd,
+							     &framenum,
+							     pkts[j]);
+			if (likely(ret == 0)) {
+				num_tx++;
+				num_tx_bytes += pkts[j]->pkt_len;
+			} else {
+				num_err++;
 			}
+			rte_pktmbuf_free(pkts[j]);
 		}
-
-		/* point at the next incoming frame */
-		if ((ppd->tp_status != TP_STATUS_AVAILABLE) &&
-		    (poll(&pfd, 1, -1) < 0))
+		if (unlikely(ret == -2)) {
+			i++;
 			break;
-
-		/* copy the tx frame data */
-		pbuf = (uint8_t *) ppd + TPACKET2_HDRLEN -
-			sizeof(struct sockaddr_ll);
-		memcpy(pbuf, rte_pktmbuf_mtod(mbuf, void*), rte_pktmbuf_data_len(mbuf));
-		ppd->tp_len = ppd->tp_snaplen = rte_pktmbuf_data_len(mbuf);
-
-		/* release incoming frame and advance ring buffer */
-		ppd->tp_status = TP_STATUS_SEND_REQUEST;
-		if (++framenum >= framecount)
-			framenum = 0;
-		ppd = (struct tpacket2_hdr *) pkt_q->rd[framenum].iov_base;
-
-		num_tx++;
-		num_tx_bytes += mbuf->pkt_len;
-		rte_pktmbuf_free(mbuf);
+		}
 	}
 
 	/* kick-off transmits */
-	if (sendto(pkt_q->sockfd, NULL, 0, MSG_DONTWAIT, NULL, 0) == -1)
-		num_tx = 0; /* error sending -- no packets transmitted */
+	if (num_tx != 0 &&
+	    sendto(pkt_q->sockfd, NULL, 0, MSG_DONTWAIT, NULL, 0) == -1) {
+		/* error sending -- no packets transmitted */
+		num_err += num_tx;
+		num_tx = 0;
+		num_tx_bytes = 0;
+	}
 
 	pkt_q->framenum = framenum;
 	pkt_q->tx_pkts += num_tx;
-	pkt_q->err_pkts += i - num_tx;
+	pkt_q->err_pkts += num_err;
 	pkt_q->tx_bytes += num_tx_bytes;
 	return i;
 }
@@ -314,6 +631,7 @@ eth_dev_info(struct rte_eth_dev *dev, struct rte_eth_dev_info *dev_info)
 	dev_info->max_rx_queues = (uint16_t)internals->nb_queues;
 	dev_info->max_tx_queues = (uint16_t)internals->nb_queues;
 	dev_info->min_rx_bufsize = 0;
+	dev_info->tx_offload_capa = RTE_NET_SW_TX_OFFLOAD_CAPA;
 }
 
 static void
@@ -379,6 +697,14 @@ eth_queue_release(void *q __rte_unused)
 {
 }
 
+static int
+eth_rx_queue_fd_get(struct rte_eth_dev *dev, uint16_t rx_queue_id)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+
+	return internals->rx_queue[rx_queue_id].sockfd;
+}
+
 static int
 eth_link_update(struct rte_eth_dev *dev __rte_unused,
                 int wait_to_complete __rte_unused)
@@ -406,7 +732,8 @@ eth_rx_queue_setup(struct rte_eth_dev *dev,
 	data_size = internals->req.tp_frame_size;
 	data_size -= TPACKET2_HDRLEN - sizeof(struct sockaddr_ll);
 
-	if (data_size > buf_size) {
+	/* TPACKET_V3 frames do not have a fixed size, they are checked on Rx */
+	if (!internals->tpacket_v3 && data_size > buf_size) {
 		RTE_LOG(ERR, PMD,
 			"%s: %d bytes will not fit in mbuf (%d bytes)\n",
 			dev->data->name, data_size, buf_size);
@@ -511,6 +838,7 @@ static const struct eth_dev_ops ops = {
 	.tx_queue_setup = eth_tx_queue_setup,
 	.rx_queue_release = eth_queue_release,
 	.tx_queue_release = eth_queue_release,
+	.rx_queue_fd_get = eth_rx_queue_fd_get,
 	.link_update = eth_link_update,
 	.stats_get = eth_stats_get,
 	.stats_reset = eth_stats_reset,
@@ -546,6 +874,11 @@ rte_pmd_init_internals(const char *name,
                        unsigned int blockcnt,
                        unsigned int framesize,
                        unsigned int framecnt,
+                       int tpacket_v3,
+                       unsigned int blocktmo,
+                       int qdisc_bypass,
+                       int fanout_mode,
+                       int zero_copy,
                        const unsigned numa_node,
                        struct pmd_internals **internals,
                        struct rte_eth_dev **eth_dev,
@@ -557,11 +890,13 @@ rte_pmd_init_internals(const char *name,
 	size_t ifnamelen;
 	unsigned k_idx;
 	struct sockaddr_ll sockaddr;
+	struct sockaddr_ll tx_sockaddr;
 	struct tpacket_req *req;
+	struct tpacket_req3 req3;
 	struct pkt_rx_queue *rx_queue;
 	struct pkt_tx_queue *tx_queue;
 	int rc, tpver, discard;
-	int qsockfd = -1;
+	int qsockfd, txsockfd;
 	unsigned int i, q, rdsize;
 	int fanout_arg __rte_unused, bypass __rte_unused;
 
@@ -597,6 +932,8 @@ rte_pmd_init_internals(const char *name,
 	for (q = 0; q < nb_queues; q++) {
 		(*internals)->rx_queue[q].map = MAP_FAILED;
 		(*internals)->tx_queue[q].map = MAP_FAILED;
+		(*internals)->rx_queue[q].sockfd = -1;
+		(*internals)->tx_queue[q].sockfd = -1;
 	}
 
 	req = &((*internals)->req);
@@ -638,25 +975,59 @@ rte_pmd_init_internals(const char *name,
 	sockaddr.sll_protocol = htons(ETH_P_ALL);
 	sockaddr.sll_ifindex = (*internals)->if_index;
 
+	/* the TPACKET_V3 transmit socket does not receive anything */
+	tx_sockaddr = sockaddr;
+	tx_sockaddr.sll_protocol = 0;
+
+	memset(&req3, 0, sizeof(req3));
+	req3.tp_block_size = blocksize;
+	req3.tp_block_nr = blockcnt;
+	req3.tp_frame_size = framesize;
+	req3.tp_frame_nr = framecnt;
+	req3.tp_retire_blk_tov = blocktmo;
+	req3.tp_feature_req_word = TP_FT_REQ_FILL_RXHASH;
+
 #if defined(PACKET_FANOUT)
 	fanout_arg = (getpid() ^ (*internals)->if_index) & 0xffff;
-	fanout_arg |= (PACKET_FANOUT_HASH | PACKET_FANOUT_FLAG_DEFRAG) << 16;
+	fanout_arg |= fanout_mode << 16;
+	if (fanout_mode == PACKET_FANOUT_HASH)
+		fanout_arg |= PACKET_FANOUT_FLAG_DEFRAG << 16;
 #if defined(PACKET_FANOUT_FLAG_ROLLOVER)
 	fanout_arg |= PACKET_FANOUT_FLAG_ROLLOVER << 16;
 #endif
 #endif
 
 	for (q = 0; q < nb_queues; q++) {
+		rx_queue = &((*internals)->rx_queue[q]);
+		tx_queue = &((*internals)->tx_queue[q]);
+
 		/* Open an AF_PACKET socket for this queue... */
 		qsockfd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
 		if (qsockfd == -1) {
 			RTE_LOG(ERR, PMD,
 			        "%s: could not open AF_PACKET socket\n",
 			        name);
-			return -1;
+			goto error;
+		}
+		rx_queue->sockfd = qsockfd;
+
+		/*
+		 * TPACKET_V3 block mode only helps receiving, so transmit
+		 * through a second socket using a TPACKET_V2 ring.
+		 */
+		txsockfd = qsockfd;
+		if (tpacket_v3) {
+			txsockfd = socket(AF_PACKET, SOCK_RAW, 0);
+			if (txsockfd == -1) {
+				RTE_LOG(ERR, PMD,
+					"%s: could not open AF_PACKET socket\n",
+					name);
+				goto error;
+			}
 		}
+		tx_queue->sockfd = txsockfd;
 
-		tpver = TPACKET_V2;
+		tpver = tpacket_v3 ? TPACKET_V3 : TPACKET_V2;
 		rc = setsockopt(qsockfd, SOL_PACKET, PACKET_VERSION,
 				&tpver, sizeof(tpver));
 		if (rc == -1) {
@@ -666,8 +1037,21 @@ rte_pmd_init_internals(const char *name,
 			goto error;
 		}
 
+		if (tpacket_v3) {
+			tpver = TPACKET_V2;
+			rc = setsockopt(txsockfd, SOL_PACKET, PACKET_VERSION,
+					&tpver, sizeof(tpver));
+			if (rc == -1) {
+				RTE_LOG(ERR, PMD,
+					"%s: could not set PACKET_VERSION on "
+					"AF_PACKET socket for %s\n", name,
+					pair->value);
+				goto error;
+			}
+		}
+
 		discard = 1;
-		rc = setsockopt(qsockfd, SOL_PACKET, PACKET_LOSS,
+		rc = setsockopt(txsockfd, SOL_PACKET, PACKET_LOSS,
 				&discard, sizeof(discard));
 		if (rc == -1) {
 			RTE_LOG(ERR, PMD,
@@ -677,8 +1061,8 @@ rte_pmd_init_internals(const char *name,
 		}
 
 #if defined(PACKET_QDISC_BYPASS)
-		bypass = 1;
-		rc = setsockopt(qsockfd, SOL_PACKET, PACKET_QDISC_BYPASS,
+		bypass = qdisc_bypass;
+		rc = setsockopt(txsockfd, SOL_PACKET, PACKET_QDISC_BYPASS,
 				&bypass, sizeof(bypass));
 		if (rc == -1) {
 			RTE_LOG(ERR, PMD,
@@ -689,7 +1073,12 @@ rte_pmd_init_internals(const char *name,
 		}
 #endif
 
-		rc = setsockopt(qsockfd, SOL_PACKET, PACKET_RX_RING, req, sizeof(*req));
+		if (tpacket_v3)
+			rc = setsockopt(qsockfd, SOL_PACKET, PACKET_RX_RING,
+					&req3, sizeof(req3));
+		else
+			rc = setsockopt(qsockfd, SOL_PACKET, PACKET_RX_RING,
+					req, sizeof(*req));
 		if (rc == -1) {
 			RTE_LOG(ERR, PMD,
 				"%s: could not set PACKET_RX_RING on AF_PACKET "
@@ -697,7 +1086,7 @@ rte_pmd_init_internals(const char *name,
 			goto error;
 		}
 
-		rc = setsockopt(qsockfd, SOL_PACKET, PACKET_TX_RING, req, sizeof(*req));
+		rc = setsockopt(txsockfd, SOL_PACKET, PACKET_TX_RING, req, sizeof(*req));
 		if (rc == -1) {
 			RTE_LOG(ERR, PMD,
 				"%s: could not set PACKET_TX_RING on AF_PACKET "
@@ -705,10 +1094,13 @@ rte_pmd_init_internals(const char *name,
 			goto error;
 		}
 
-		rx_queue = &((*internals)->rx_queue[q]);
 		rx_queue->framecount = req->tp_frame_nr;
 
-		rx_queue->map = mmap(NULL, 2 * req->tp_block_size * req->tp_block_nr,
+		/* with a single socket, the Tx ring is mapped after the Rx one */
+		rx_queue->map_size = req->tp_block_size * req->tp_block_nr;
+		if (!tpacket_v3)
+			rx_queue->map_size *= 2;
+		rx_queue->map = mmap(NULL, rx_queue->map_size,
 				    PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED,
 				    qsockfd, 0);
 		if (rx_queue->map == MAP_FAILED) {
@@ -721,22 +1113,59 @@ rte_pmd_init_internals(const char *name,
 		/* rdsize is same for both Tx and Rx */
 		rdsize = req->tp_frame_nr * sizeof(*(rx_queue->rd));
 
-		rx_queue->rd = rte_zmalloc_socket(name, rdsize, 0, numa_node);
-		if (rx_queue->rd == NULL)
-			goto error;
-		for (i = 0; i < req->tp_frame_nr; ++i) {
-			rx_queue->rd[i].iov_base = rx_queue->map + (i * framesize);
-			rx_queue->rd[i].iov_len = req->tp_frame_size;
+		if (tpacket_v3) {
+			rx_queue->blocksize = req->tp_block_size;
+			rx_queue->blockcount = req->tp_block_nr;
+			rx_queue->blocks = rte_zmalloc_socket(name,
+				req->tp_block_nr * sizeof(*rx_queue->blocks),
+				0, numa_node);
+			if (rx_queue->blocks == NULL)
+				goto error;
+
+			if (zero_copy) {
+				rx_queue->zero_copy = 1;
+				rx_queue->max_zmbufs = req->tp_frame_nr;
+				rx_queue->zmbufs = rte_zmalloc_socket(name,
+					req->tp_frame_nr *
+					sizeof(*rx_queue->zmbufs),
+					0, numa_node);
+				if (rx_queue->zmbufs == NULL)
+					goto error;
+			}
+		} else {
+			rx_queue->rd = rte_zmalloc_socket(name, rdsize, 0,
+							  numa_node);
+			if (rx_queue->rd == NULL)
+				goto error;
+			for (i = 0; i < req->tp_frame_nr; ++i) {
+				rx_queue->rd[i].iov_base = rx_queue->map +
+					(i * framesize);
+				rx_queue->rd[i].iov_len = req->tp_frame_size;
+			}
 		}
-		rx_queue->sockfd = qsockfd;
 
-		tx_queue = &((*internals)->tx_queue[q]);
 		tx_queue->framecount = req->tp_frame_nr;
 		tx_queue->frame_data_size = req->tp_frame_size;
 		tx_queue->frame_data_size -= TPACKET2_HDRLEN -
 			sizeof(struct sockaddr_ll);
 
-		tx_queue->map = rx_queue->map + req->tp_block_size * req->tp_block_nr;
+		if (tpacket_v3) {
+			tx_queue->map_size = req->tp_block_size *
+				req->tp_block_nr;
+			tx_queue->map = mmap(NULL, tx_queue->map_size,
+					     PROT_READ | PROT_WRITE,
+					     MAP_SHARED | MAP_LOCKED,
+					     txsockfd, 0);
+			if (tx_queue->map == MAP_FAILED) {
+				RTE_LOG(ERR, PMD,
+					"%s: call to mmap failed on AF_PACKET "
+					"socket for %s\n", name, pair->value);
+				goto error;
+			}
+		} else {
+			tx_queue->map = rx_queue->map +
+				req->tp_block_size * req->tp_block_nr;
+		}
 
 		tx_queue->rd = rte_zmalloc_socket(name, rdsize, 0, numa_node);
 		if (tx_queue->rd == NULL)
@@ -745,7 +1174,6 @@ rte_pmd_init_internals(const char *name,
 			tx_queue->rd[i].iov_base = tx_queue->map + (i * framesize);
 			tx_queue->rd[i].iov_len = req->tp_frame_size;
 		}
-		tx_queue->sockfd = qsockfd;
 
 		rc = bind(qsockfd, (const struct sockaddr*)&sockaddr, sizeof(sockaddr));
 		if (rc == -1) {
@@ -755,6 +1183,17 @@ rte_pmd_init_internals(const char *name,
 			goto error;
 		}
 
+		if (tpacket_v3) {
+			rc = bind(txsockfd, (const struct sockaddr *)&tx_sockaddr,
+				  sizeof(tx_sockaddr));
+			if (rc == -1) {
+				RTE_LOG(ERR, PMD,
+					"%s: could not bind AF_PACKET socket to %s\n",
+					name, pair->value);
+				goto error;
+			}
+		}
+
 #if defined(PACKET_FANOUT)
 		rc = setsockopt(qsockfd, SOL_PACKET, PACKET_FANOUT,
 				&fanout_arg, sizeof(fanout_arg));
@@ -781,6 +1220,7 @@ rte_pmd_init_internals(const char *name,
 	 */
 
 	(*internals)->nb_queues = nb_queues;
+	(*internals)->tpacket_v3 = tpacket_v3;
 
 	data->dev_private = *internals;
 	data->port_id = (*eth_dev)->data->port_id;
@@ -802,17 +1242,25 @@ rte_pmd_init_internals(const char *name,
 	return 0;
 
 error:
-	if (qsockfd != -1)
-		close(qsockfd);
+	/* nothing was received yet, no zero-copy mbuf points into the rings */
 	for (q = 0; q < nb_queues; q++) {
-		munmap((*internals)->rx_queue[q].map,
-		       2 * req->tp_block_size * req->tp_block_nr);
-
-		rte_free((*internals)->rx_queue[q].rd);
-		rte_free((*internals)->tx_queue[q].rd);
-		if (((*internals)->rx_queue[q].sockfd != 0) &&
-			((*internals)->rx_queue[q].sockfd != qsockfd))
-			close((*internals)->rx_queue[q].sockfd);
+		rx_queue = &((*internals)->rx_queue[q]);
+		tx_queue = &((*internals)->tx_queue[q]);
+
+		if (rx_queue->map != MAP_FAILED)
+			munmap(rx_queue->map, rx_queue->map_size);
+		if (tx_queue->map_size != 0 && tx_queue->map != MAP_FAILED)
+			munmap(tx_queue->map, tx_queue->map_size);
+
+		rte_free(rx_queue->rd);
+		rte_free(rx_queue->blocks);
+		rte_free(rx_queue->zmbufs);
+		rte_free(tx_queue->rd);
+		if (tx_queue->sockfd != -1 &&
+		    tx_queue->sockfd != rx_queue->sockfd)
+			close(tx_queue->sockfd);
+		if (rx_queue->sockfd != -1)
+			close(rx_queue->sockfd);
 	}
 	free((*internals)->if_name);
 	rte_free(*internals);
@@ -836,6 +1284,16 @@ rte_eth_from_packet(const char *name,
 	unsigned int framesize = DFLT_FRAME_SIZE;
 	unsigned int framecount = DFLT_FRAME_COUNT;
 	unsigned int qpairs = 1;
+	unsigned int blocktmo = 0;
+	int tpacket_v3 = 0;
+	int qdisc_bypass = 1;
+	int fanout_mode = 0;
+	int zero_copy = 0;
+	unsigned int i;
+
+#if defined(PACKET_FANOUT)
+	fanout_mode = PACKET_FANOUT_HASH;
+#endif
 
 	/* do some parameter checking */
 	if (*sockfd < 0)
@@ -887,6 +1345,45 @@ rte_eth_from_packet(const char *name,
 			}
 			continue;
 		}
+		if (strstr(pair->key, ETH_AF_PACKET_TPACKET_V3_ARG) != NULL) {
+			tpacket_v3 = !!atoi(pair->value);
+			continue;
+		}
+		if (strstr(pair->key, ETH_AF_PACKET_BLOCKTMO_ARG) != NULL) {
+			blocktmo = atoi(pair->value);
+			continue;
+		}
+		if (strstr(pair->key, ETH_AF_PACKET_QDISC_BYPASS_ARG) != NULL) {
+			qdisc_bypass = !!atoi(pair->value);
+			continue;
+		}
+		if (strstr(pair->key, ETH_AF_PACKET_FANOUT_MODE_ARG) != NULL) {
+#if defined(PACKET_FANOUT)
+			for (i = 0; i < RTE_DIM(fanout_modes); i++) {
+				if (strcmp(pair->value, fanout_modes[i].name) == 0)
+					break;
+			}
+			if (i < RTE_DIM(fanout_modes)) {
+				fanout_mode = fanout_modes[i].mode;
+				continue;
+			}
+#endif
+			RTE_LOG(ERR, PMD,
+				"%s: invalid fanout_mode value\n",
+			        name);
+			return -1;
+		}
+		if (strstr(pair->key, ETH_AF_PACKET_ZEROCOPY_ARG) != NULL) {
+			zero_copy = !!atoi(pair->value);
+			continue;
+		}
+	}
+
+	if (zero_copy && !tpacket_v3) {
+		RTE_LOG(ERR, PMD,
+			"%s: zero-copy receive requires TPACKET_V3\n",
+		        name);
+		return -1;
 	}
 
 	if (framesize > blocksize) {
@@ -908,15 +1405,24 @@ rte_eth_from_packet(const char *name,
 	RTE_LOG(INFO, PMD, "%s:\tblock count %d\n", name, blockcount);
 	RTE_LOG(INFO, PMD, "%s:\tframe size %d\n", name, framesize);
 	RTE_LOG(INFO, PMD, "%s:\tframe count %d\n", name, framecount);
+	if (tpacket_v3) {
+		RTE_LOG(INFO, PMD, "%s:\tTPACKET_V3 Rx, block timeout %u ms%s\n",
+			name, blocktmo, zero_copy ? ", zero copy" : "");
+	}
 
 	if (rte_pmd_init_internals(name, *sockfd, qpairs,
 	                           blocksize, blockcount,
 	                           framesize, framecount,
+	                           tpacket_v3, blocktmo, qdisc_bypass,
+	                           fanout_mode, zero_copy,
 	                           numa_node, &internals, &eth_dev,
 	                           kvlist) < 0)
 		return -1;
 
-	eth_dev->rx_pkt_burst = eth_af_packet_rx;
+	if (tpacket_v3)
+		eth_dev->rx_pkt_burst = eth_af_packet_rx_v3;
+	else
+		eth_dev->rx_pkt_burst = eth_af_packet_rx;
 	eth_dev->tx_pkt_burst = eth_af_packet_tx;
 
 	return 0;
@@ -979,8 +1485,22 @@ rte_pmd_af_packet_remove(const char *name)
 		return -1;
 
 	internals = eth_dev->data->dev_private;
+	if (eth_af_packet_zmbufs_busy(internals)) {
+		RTE_LOG(ERR, PMD,
+			"%s: zero-copy mbufs are still held, cannot close\n",
+			name);
+		return -EBUSY;
+	}
+
 	for (q = 0; q < internals->nb_queues; q++) {
+		munmap(internals->rx_queue[q].map,
+		       internals->rx_queue[q].map_size);
+		if (internals->tx_queue[q].map_size != 0)
+			munmap(internals->tx_queue[q].map,
+			       internals->tx_queue[q].map_size);
 		rte_free(internals->rx_queue[q].rd);
+		rte_free(internals->rx_queue[q].blocks);
+		rte_free(internals->rx_queue[q].zmbufs);
 		rte_free(internals->tx_queue[q].rd);
 	}
 	free(internals->if_name);
@@ -1005,4 +1525,9 @@ RTE_PMD_REGISTER_PARAM_STRING(net_af_packet,
 	"qpairs=<int> "
 	"blocksz=<int> "
 	"framesz=<int> "
-	"framecnt=<int>");
+	"framecnt=<int> "
+	"tpacket_v3=<0|1> "
+	"blocktmo=<int> "
+	"qdisc_bypass=<0|1> "
+	"fanout_mode=<hash|lb|cpu|rollover|rnd|qm> "
+	"zerocopy=<0|1>");
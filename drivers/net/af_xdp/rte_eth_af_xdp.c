@@ -0,0 +1,1448 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include <rte_mbuf.h>
+#include <rte_memcpy.h>
+#include <rte_ethdev.h>
+#include <rte_malloc.h>
+#include <rte_memzone.h>
+#include <rte_kvargs.h>
+#include <rte_vdev.h>
+
+#include <linux/if_ether.h>
+#include <linux/if_xdp.h>
+#include <linux/bpf.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <net/if.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef SOL_XDP
+#define SOL_XDP 283
+#endif
+
+#ifndef AF_XDP
+#define AF_XDP 44
+#endif
+
+#ifndef SO_PREFER_BUSY_POLL
+#define SO_PREFER_BUSY_POLL 69
+#endif
+
+#ifndef SO_BUSY_POLL_BUDGET
+#define SO_BUSY_POLL_BUDGET 70
+#endif
+
+#define ETH_AF_XDP_IFACE_ARG		"iface"
+#define ETH_AF_XDP_START_QUEUE_ARG	"start_queue"
+#define ETH_AF_XDP_QUEUE_COUNT_ARG	"queue_count"
+#define ETH_AF_XDP_BUSY_BUDGET_ARG	"busy_budget"
+
+#define RTE_PMD_AF_XDP_MAX_QUEUES	16
+
+/* UMEM frame, holding a whole mbuf along with its mempool header */
+#define AF_XDP_FRAME_SIZE		4096
+#define AF_XDP_FILL_BATCH		64
+#define AF_XDP_BUSY_POLL_TIMEOUT	20 /* us */
+
+struct xsk_ring {
+	uint32_t cached_prod;
+	uint32_t cached_cons;
+	uint32_t mask;
+	uint32_t size;
+	uint32_t *producer;
+	uint32_t *consumer;
+	uint32_t *flags;
+	void *ring;
+	void *map;
+	size_t map_size;
+};
+
+/*
+ * An AF_XDP socket bound to one queue of the interface, with its own UMEM.
+ * The UMEM is the memory of an mbuf pool laid out so that every mbuf sits
+ * in its own frame: the kernel writes received packets straight into the
+ * mbuf data room, and mbufs of the pool are sent without a copy.
+ */
+struct xsk_socket {
+	int fd;
+	unsigned int if_queue;
+
+	const struct rte_memzone *mz;
+	struct rte_mempool *mb_pool;
+	uint8_t *umem;
+	uint32_t mbuf_offset;	/* from the frame start to the mbuf */
+	uint32_t buf_offset;	/* from the frame start to the mbuf buffer */
+	uint32_t nb_fill;	/* frames given to the kernel for Rx */
+	uint32_t nb_tx;		/* frames given to the kernel for Tx */
+
+	struct xsk_ring fill;
+	struct xsk_ring comp;
+	struct xsk_ring rx;
+	struct xsk_ring tx;
+
+	struct xdp_statistics stats_base;
+};
+
+struct pkt_rx_queue {
+	struct xsk_socket *xsk;
+	uint16_t nb_desc;
+	uint8_t in_port;
+	int busy_poll;
+	uint32_t fill_deficit;
+
+	volatile unsigned long rx_pkts;
+	volatile unsigned long rx_bytes;
+	volatile unsigned long rx_nombuf;
+};
+
+struct pkt_tx_queue {
+	struct xsk_socket *xsk;
+	uint16_t nb_desc;
+
+	volatile unsigned long tx_pkts;
+	volatile unsigned long tx_bytes;
+	volatile unsigned long err_pkts;
+	volatile unsigned long tx_copied;
+};
+
+struct pmd_internals {
+	unsigned int nb_queues;
+	unsigned int start_queue;
+	unsigned int busy_budget;
+
+	int if_index;
+	char if_name[IFNAMSIZ];
+	struct ether_addr eth_addr;
+
+	int map_fd;
+	int prog_fd;
+	uint32_t xdp_flags;
+
+	struct xsk_socket xsks[RTE_PMD_AF_XDP_MAX_QUEUES];
+	struct pkt_rx_queue rx_queue[RTE_PMD_AF_XDP_MAX_QUEUES];
+	struct pkt_tx_queue tx_queue[RTE_PMD_AF_XDP_MAX_QUEUES];
+};
+
+static const char *valid_arguments[] = {
+	ETH_AF_XDP_IFACE_ARG,
+	ETH_AF_XDP_START_QUEUE_ARG,
+	ETH_AF_XDP_QUEUE_COUNT_ARG,
+	ETH_AF_XDP_BUSY_BUDGET_ARG,
+	NULL
+};
+
+static struct rte_eth_link pmd_link = {
+	.link_speed = ETH_SPEED_NUM_10G,
+	.link_duplex = ETH_LINK_FULL_DUPLEX,
+	.link_status = ETH_LINK_DOWN,
+	.link_autoneg = ETH_LINK_SPEED_AUTONEG
+};
+
+struct af_xdp_xstats_name_off {
+	const char *name;
+	uint64_t offset;
+};
+
+static const struct af_xdp_xstats_name_off af_xdp_xstats_strings[] = {
+	{"rx_dropped",
+	 offsetof(struct xdp_statistics, rx_dropped)},
+	{"rx_invalid_descs",
+	 offsetof(struct xdp_statistics, rx_invalid_descs)},
+	{"tx_invalid_descs",
+	 offsetof(struct xdp_statistics, tx_invalid_descs)},
+	{"rx_ring_full",
+	 offsetof(struct xdp_statistics, rx_ring_full)},
+	{"rx_fill_ring_empty_descs",
+	 offsetof(struct xdp_statistics, rx_fill_ring_empty_descs)},
+	{"tx_ring_empty_descs",
+	 offsetof(struct xdp_statistics, tx_ring_empty_descs)},
+};
+
+#define AF_XDP_NB_KERNEL_XSTATS RTE_DIM(af_xdp_xstats_strings)
+/* the kernel counters, followed by the packets copied on Tx */
+#define AF_XDP_NB_XSTATS (AF_XDP_NB_KERNEL_XSTATS + 1)
+
+/* largest packet fitting in a frame, after the kernel XDP headroom */
+static uint32_t
+af_xdp_max_pktlen(void)
+{
+	struct rte_mempool_objsz objsz;
+
+	rte_mempool_calc_obj_size(0, MEMPOOL_F_NO_SPREAD, &objsz);
+	return AF_XDP_FRAME_SIZE - objsz.header_size -
+		sizeof(struct rte_mbuf) - XDP_PACKET_HEADROOM;
+}
+
+/*
+ * Rings shared with the kernel. The producer publishes entries by moving
+ * its index, the consumer gives them back the same way.
+ */
+static inline uint32_t
+xsk_prod_nb_free(struct xsk_ring *r, uint32_t nb)
+{
+	uint32_t nb_free = r->size - (r->cached_prod - r->cached_cons);
+
+	if (nb_free >= nb)
+		return nb_free;
+
+	r->cached_cons = __atomic_load_n(r->consumer, __ATOMIC_ACQUIRE);
+	return r->size - (r->cached_prod - r->cached_cons);
+}
+
+static inline void
+xsk_prod_submit(struct xsk_ring *r, uint32_t nb)
+{
+	r->cached_prod += nb;
+	__atomic_store_n(r->producer, r->cached_prod, __ATOMIC_RELEASE);
+}
+
+static inline uint32_t
+xsk_cons_nb_avail(struct xsk_ring *r, uint32_t nb)
+{
+	uint32_t entries = r->cached_prod - r->cached_cons;
+
+	if (entries == 0) {
+		r->cached_prod = __atomic_load_n(r->producer,
+						 __ATOMIC_ACQUIRE);
+		entries = r->cached_prod - r->cached_cons;
+	}
+
+	return RTE_MIN(entries, nb);
+}
+
+static inline void
+xsk_cons_release(struct xsk_ring *r, uint32_t nb)
+{
+	r->cached_cons += nb;
+	__atomic_store_n(r->consumer, r->cached_cons, __ATOMIC_RELEASE);
+}
+
+static inline int
+xsk_ring_needs_wakeup(const struct xsk_ring *r)
+{
+	return *r->flags & XDP_RING_NEED_WAKEUP;
+}
+
+static inline uint64_t *
+xsk_ring_addr(struct xsk_ring *r, uint32_t idx)
+{
+	return &((uint64_t *)r->ring)[idx & r->mask];
+}
+
+static inline struct xdp_desc *
+xsk_ring_desc(struct xsk_ring *r, uint32_t idx)
+{
+	return &((struct xdp_desc *)r->ring)[idx & r->mask];
+}
+
+static inline struct rte_mbuf *
+xsk_addr_to_mbuf(const struct xsk_socket *xsk, uint64_t addr)
+{
+	uint64_t frame = addr & ~((uint64_t)AF_XDP_FRAME_SIZE - 1);
+
+	return (struct rte_mbuf *)(xsk->umem + frame + xsk->mbuf_offset);
+}
+
+static inline uint64_t
+xsk_mbuf_to_frame(const struct xsk_socket *xsk, const struct rte_mbuf *m)
+{
+	return (const uint8_t *)m - xsk->mbuf_offset - xsk->umem;
+}
+
+/*
+ * Give up to nb free frames to the kernel for receiving. Returns the
+ * number of frames which could not be allocated.
+ */
+static uint32_t
+xsk_fill(struct xsk_socket *xsk, uint32_t nb)
+{
+	struct rte_mbuf *mbufs[AF_XDP_FILL_BATCH];
+	uint32_t i, n;
+
+	while (nb != 0) {
+		n = RTE_MIN(nb, (uint32_t)AF_XDP_FILL_BATCH);
+		n = RTE_MIN(n, xsk_prod_nb_free(&xsk->fill, n));
+		if (n == 0)
+			return 0;
+
+		if (rte_pktmbuf_alloc_bulk(xsk->mb_pool, mbufs, n) != 0)
+			return nb;
+
+		for (i = 0; i < n; i++)
+			*xsk_ring_addr(&xsk->fill, xsk->fill.cached_prod + i) =
+				xsk_mbuf_to_frame(xsk, mbufs[i]);
+		xsk_prod_submit(&xsk->fill, n);
+		xsk->nb_fill += n;
+		nb -= n;
+	}
+
+	return 0;
+}
+
+static uint16_t
+eth_af_xdp_rx(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
+{
+	struct pkt_rx_queue *rxq = queue;
+	struct xsk_socket *xsk = rxq->xsk;
+	const struct xdp_desc *desc;
+	struct rte_mbuf *mbuf;
+	unsigned long num_rx_bytes = 0;
+	uint32_t i, nb_rx;
+
+	/* drive the driver napi from here when busy polling, or if asked */
+	if (rxq->busy_poll || xsk_ring_needs_wakeup(&xsk->fill))
+		recvfrom(xsk->fd, NULL, 0, MSG_DONTWAIT, NULL, NULL);
+
+	nb_rx = xsk_cons_nb_avail(&xsk->rx, nb_pkts);
+	for (i = 0; i < nb_rx; i++) {
+		desc = xsk_ring_desc(&xsk->rx, xsk->rx.cached_cons + i);
+		mbuf = xsk_addr_to_mbuf(xsk, desc->addr);
+
+		/* the frame was taken from the pool when given to the kernel */
+		mbuf->data_off = (desc->addr & (AF_XDP_FRAME_SIZE - 1)) -
+			xsk->buf_offset;
+		rte_pktmbuf_pkt_len(mbuf) = rte_pktmbuf_data_len(mbuf) =
+			desc->len;
+		mbuf->port = rxq->in_port;
+
+		bufs[i] = mbuf;
+		num_rx_bytes += desc->len;
+	}
+	if (nb_rx != 0) {
+		xsk_cons_release(&xsk->rx, nb_rx);
+		xsk->nb_fill -= nb_rx;
+	}
+
+	/* replace the received frames, and the ones missing from before */
+	if (nb_rx != 0 || rxq->fill_deficit != 0) {
+		rxq->fill_deficit = xsk_fill(xsk, nb_rx + rxq->fill_deficit);
+		if (unlikely(rxq->fill_deficit != 0))
+			rxq->rx_nombuf++;
+	}
+
+	rxq->rx_pkts += nb_rx;
+	rxq->rx_bytes += num_rx_bytes;
+	return nb_rx;
+}
+
+/* free the mbufs the kernel is done sending */
+static void
+xsk_tx_complete(struct xsk_socket *xsk)
+{
+	uint32_t i, n;
+
+	n = xsk_cons_nb_avail(&xsk->comp, xsk->comp.size);
+	for (i = 0; i < n; i++)
+		rte_pktmbuf_free(xsk_addr_to_mbuf(xsk,
+			*xsk_ring_addr(&xsk->comp, xsk->comp.cached_cons + i)));
+	if (n != 0) {
+		xsk_cons_release(&xsk->comp, n);
+		xsk->nb_tx -= n;
+	}
+}
+
+/* copy a packet which is not in the UMEM into a frame */
+static struct rte_mbuf *
+xsk_tx_copy(struct xsk_socket *xsk, struct rte_mbuf *mbuf)
+{
+	struct rte_mbuf *m, *seg;
+	uint8_t *dst;
+
+	m = rte_pktmbuf_alloc(xsk->mb_pool);
+	if (unlikely(m == NULL))
+		return NULL;
+
+	dst = (uint8_t *)rte_pktmbuf_append(m, rte_pktmbuf_pkt_len(mbuf));
+	if (unlikely(dst == NULL)) {
+		rte_pktmbuf_free(m);
+		return NULL;
+	}
+
+	for (seg = mbuf; seg != NULL; seg = seg->next) {
+		rte_memcpy(dst, rte_pktmbuf_mtod(seg, void *),
+			   rte_pktmbuf_data_len(seg));
+		dst += rte_pktmbuf_data_len(seg);
+	}
+
+	return m;
+}
+
+static uint16_t
+eth_af_xdp_tx(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
+{
+	struct pkt_tx_queue *txq = queue;
+	struct xsk_socket *xsk = txq->xsk;
+	struct xdp_desc *desc;
+	struct rte_mbuf *mbuf, *m;
+	unsigned long num_tx_bytes = 0;
+	uint32_t i, nb_tx = 0, nb_free;
+
+	xsk_tx_complete(xsk);
+
+	nb_free = xsk_prod_nb_free(&xsk->tx, nb_pkts);
+	for (i = 0; i < nb_pkts && nb_tx < nb_free; i++) {
+		mbuf = bufs[i];
+
+		/* mbufs of the UMEM pool are sent in place */
+		if (mbuf->pool == xsk->mb_pool && RTE_MBUF_DIRECT(mbuf) &&
+		    mbuf->nb_segs == 1) {
+			m = mbuf;
+		} else {
+			m = xsk_tx_copy(xsk, mbuf);
+			if (unlikely(m == NULL)) {
+				if (rte_pktmbuf_pkt_len(mbuf) >
+				    af_xdp_max_pktlen()) {
+					/* drop packets too large for a frame */
+					rte_pktmbuf_free(mbuf);
+					txq->err_pkts++;
+					continue;
+				}
+				break;
+			}
+			rte_pktmbuf_free(mbuf);
+			txq->tx_copied++;
+		}
+
+		desc = xsk_ring_desc(&xsk->tx, xsk->tx.cached_prod + nb_tx);
+		desc->addr = rte_pktmbuf_mtod(m, uint8_t *) - xsk->umem;
+		desc->len = rte_pktmbuf_data_len(m);
+		desc->options = 0;
+		num_tx_bytes += desc->len;
+		nb_tx++;
+	}
+
+	if (nb_tx != 0) {
+		xsk_prod_submit(&xsk->tx, nb_tx);
+		xsk->nb_tx += nb_tx;
+		if (xsk_ring_needs_wakeup(&xsk->tx))
+			sendto(xsk->fd, NULL, 0, MSG_DONTWAIT, NULL, 0);
+	}
+
+	txq->tx_pkts += nb_tx;
+	txq->tx_bytes += num_tx_bytes;
+	return i;
+}
+
+static int
+af_xdp_bpf(int cmd, union bpf_attr *attr)
+{
+	return syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+}
+
+/*
+ * Attach (fd >= 0) or detach (fd == -1) an XDP program through an
+ * RTM_SETLINK request.
+ */
+static int
+xdp_link_set_fd(int if_index, int fd, uint32_t flags)
+{
+	struct {
+		struct nlmsghdr nh;
+		struct ifinfomsg ifi;
+		char attrs[64];
+	} req;
+	struct sockaddr_nl sa;
+	struct nlattr *nla, *attr;
+	struct nlmsghdr *nh;
+	struct nlmsgerr *err;
+	char buf[512];
+	int sock, len, ret = -1;
+
+	sock = socket(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE);
+	if (sock < 0)
+		return -1;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.nl_family = AF_NETLINK;
+	if (bind(sock, (struct sockaddr *)&sa, sizeof(sa)) < 0)
+		goto out;
+
+	memset(&req, 0, sizeof(req));
+	req.nh.nlmsg_len = NLMSG_LENGTH(sizeof(req.ifi));
+	req.nh.nlmsg_type = RTM_SETLINK;
+	req.nh.nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK;
+	req.ifi.ifi_family = AF_UNSPEC;
+	req.ifi.ifi_index = if_index;
+
+	/* IFLA_XDP, nesting IFLA_XDP_FD and IFLA_XDP_FLAGS */
+	nla = (struct nlattr *)((char *)&req + NLMSG_ALIGN(req.nh.nlmsg_len));
+	nla->nla_type = NLA_F_NESTED | IFLA_XDP;
+	nla->nla_len = NLA_HDRLEN;
+
+	attr = (struct nlattr *)((char *)nla + nla->nla_len);
+	attr->nla_type = IFLA_XDP_FD;
+	attr->nla_len = NLA_HDRLEN + sizeof(fd);
+	memcpy((char *)attr + NLA_HDRLEN, &fd, sizeof(fd));
+	nla->nla_len += NLA_ALIGN(attr->nla_len);
+
+	attr = (struct nlattr *)((char *)nla + nla->nla_len);
+	attr->nla_type = IFLA_XDP_FLAGS;
+	attr->nla_len = NLA_HDRLEN + sizeof(flags);
+	memcpy((char *)attr + NLA_HDRLEN, &flags, sizeof(flags));
+	nla->nla_len += NLA_ALIGN(attr->nla_len);
+
+	req.nh.nlmsg_len += NLA_ALIGN(nla->nla_len);
+
+	if (send(sock, &req, req.nh.nlmsg_len, 0) < 0)
+		goto out;
+
+	len = recv(sock, buf, sizeof(buf), 0);
+	for (nh = (struct nlmsghdr *)buf; len > 0 && NLMSG_OK(nh, (unsigned)len);
+	     nh = NLMSG_NEXT(nh, len)) {
+		if (nh->nlmsg_type == NLMSG_ERROR) {
+			err = NLMSG_DATA(nh);
+			ret = err->error;
+			break;
+		}
+	}
+out:
+	close(sock);
+	return ret;
+}
+
+/*
+ * Load the XDP program redirecting the packets of every queue to the
+ * socket in the XSKMAP slot of that queue. Queues without a socket fall
+ * back to the kernel stack.
+ */
+static int
+xdp_prog_attach(struct pmd_internals *internals)
+{
+	static const char license[] = "Dual BSD/GPL";
+	struct bpf_insn prog[] = {
+		/* r2 = ctx->rx_queue_index */
+		{ .code = BPF_LDX | BPF_MEM | BPF_W,
+		  .dst_reg = BPF_REG_2, .src_reg = BPF_REG_1,
+		  .off = offsetof(struct xdp_md, rx_queue_index) },
+		/* r1 = xskmap */
+		{ .code = BPF_LD | BPF_DW | BPF_IMM,
+		  .dst_reg = BPF_REG_1, .src_reg = BPF_PSEUDO_MAP_FD,
+		  .imm = 0 },
+		{ .code = 0 },
+		/* r3 = XDP_PASS, the action when the slot is empty */
+		{ .code = BPF_ALU64 | BPF_MOV | BPF_K,
+		  .dst_reg = BPF_REG_3, .imm = XDP_PASS },
+		/* return bpf_redirect_map(r1, r2, r3) */
+		{ .code = BPF_JMP | BPF_CALL, .imm = BPF_FUNC_redirect_map },
+		{ .code = BPF_JMP | BPF_EXIT },
+	};
+	union bpf_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.map_type = BPF_MAP_TYPE_XSKMAP;
+	attr.key_size = sizeof(uint32_t);
+	attr.value_size = sizeof(int);
+	attr.max_entries = internals->start_queue + internals->nb_queues;
+	internals->map_fd = af_xdp_bpf(BPF_MAP_CREATE, &attr);
+	if (internals->map_fd < 0) {
+		RTE_LOG(ERR, PMD, "%s: could not create XSKMAP: %s\n",
+			internals->if_name, strerror(errno));
+		return -1;
+	}
+
+	prog[1].imm = internals->map_fd;
+	memset(&attr, 0, sizeof(attr));
+	attr.prog_type = BPF_PROG_TYPE_XDP;
+	attr.insn_cnt = RTE_DIM(prog);
+	attr.insns = (uintptr_t)prog;
+	attr.license = (uintptr_t)license;
+	internals->prog_fd = af_xdp_bpf(BPF_PROG_LOAD, &attr);
+	if (internals->prog_fd < 0) {
+		RTE_LOG(ERR, PMD, "%s: could not load XDP program: %s\n",
+			internals->if_name, strerror(errno));
+		goto error;
+	}
+
+	/* prefer the driver XDP hook, fall back to the generic one */
+	internals->xdp_flags = XDP_FLAGS_UPDATE_IF_NOEXIST | XDP_FLAGS_DRV_MODE;
+	if (xdp_link_set_fd(internals->if_index, internals->prog_fd,
+			    internals->xdp_flags) != 0) {
+		internals->xdp_flags = XDP_FLAGS_UPDATE_IF_NOEXIST |
+			XDP_FLAGS_SKB_MODE;
+		if (xdp_link_set_fd(internals->if_index, internals->prog_fd,
+				    internals->xdp_flags) != 0) {
+			RTE_LOG(ERR, PMD,
+				"%s: could not attach XDP program\n",
+				internals->if_name);
+			goto error;
+		}
+	}
+
+	return 0;
+
+error:
+	if (internals->prog_fd >= 0)
+		close(internals->prog_fd);
+	close(internals->map_fd);
+	internals->prog_fd = -1;
+	internals->map_fd = -1;
+	return -1;
+}
+
+static void
+xdp_prog_detach(struct pmd_internals *internals)
+{
+	if (internals->prog_fd < 0)
+		return;
+
+	xdp_link_set_fd(internals->if_index, -1,
+			internals->xdp_flags & XDP_FLAGS_MODES);
+	close(internals->prog_fd);
+	close(internals->map_fd);
+	internals->prog_fd = -1;
+	internals->map_fd = -1;
+}
+
+static int
+xsk_ring_map(int fd, struct xsk_ring *r, const struct xdp_ring_offset *off,
+	     uint32_t size, size_t desc_size, off_t pgoff)
+{
+	uint8_t *map;
+
+	r->map_size = off->desc + size * desc_size;
+	r->map = mmap(NULL, r->map_size, PROT_READ | PROT_WRITE,
+		      MAP_SHARED | MAP_POPULATE, fd, pgoff);
+	if (r->map == MAP_FAILED) {
+		r->map = NULL;
+		return -1;
+	}
+
+	map = r->map;
+	r->producer = (uint32_t *)(map + off->producer);
+	r->consumer = (uint32_t *)(map + off->consumer);
+	r->flags = (uint32_t *)(map + off->flags);
+	r->ring = map + off->desc;
+	r->size = size;
+	r->mask = size - 1;
+	r->cached_prod = *r->producer;
+	r->cached_cons = *r->consumer;
+
+	return 0;
+}
+
+static void
+xsk_ring_unmap(struct xsk_ring *r)
+{
+	if (r->map != NULL)
+		munmap(r->map, r->map_size);
+	r->map = NULL;
+}
+
+/*
+ * Create the mbuf pool backing the UMEM: one physically contiguous zone,
+ * cut in frames of AF_XDP_FRAME_SIZE bytes, each starting with the
+ * mempool object header followed by the mbuf.
+ */
+static int
+xsk_umem_create(struct xsk_socket *xsk, const char *name, unsigned int nb,
+		int socket_id)
+{
+	struct rte_pktmbuf_pool_private mbp_priv;
+	struct rte_mempool_objsz objsz;
+	uint32_t elt_size;
+	unsigned int cache_size;
+	int ret;
+
+	rte_mempool_calc_obj_size(0, MEMPOOL_F_NO_SPREAD, &objsz);
+	elt_size = AF_XDP_FRAME_SIZE - objsz.header_size;
+	while (rte_mempool_calc_obj_size(elt_size, MEMPOOL_F_NO_SPREAD,
+					 &objsz) > AF_XDP_FRAME_SIZE)
+		elt_size -= RTE_MEMPOOL_ALIGN;
+	if (objsz.total_size != AF_XDP_FRAME_SIZE) {
+		RTE_LOG(ERR, PMD, "%s: cannot fit mbufs in UMEM frames\n",
+			name);
+		return -1;
+	}
+
+	xsk->mz = rte_memzone_reserve_aligned(name,
+		(size_t)nb * AF_XDP_FRAME_SIZE, socket_id, 0,
+		AF_XDP_FRAME_SIZE);
+	if (xsk->mz == NULL) {
+		RTE_LOG(ERR, PMD, "%s: cannot reserve UMEM\n", name);
+		return -1;
+	}
+
+	cache_size = RTE_MIN((unsigned int)RTE_MEMPOOL_CACHE_MAX_SIZE, nb / 8);
+	xsk->mb_pool = rte_mempool_create_empty(name, nb, elt_size, cache_size,
+		sizeof(struct rte_pktmbuf_pool_private), socket_id,
+		MEMPOOL_F_NO_SPREAD);
+	if (xsk->mb_pool == NULL)
+		goto error;
+
+	ret = rte_mempool_set_ops_byname(xsk->mb_pool,
+		RTE_MBUF_DEFAULT_MEMPOOL_OPS, NULL);
+	if (ret != 0)
+		goto error;
+
+	mbp_priv.mbuf_data_room_size = elt_size - sizeof(struct rte_mbuf);
+	mbp_priv.mbuf_priv_size = 0;
+	rte_pktmbuf_pool_init(xsk->mb_pool, &mbp_priv);
+
+	ret = rte_mempool_populate_phys(xsk->mb_pool, xsk->mz->addr,
+		xsk->mz->phys_addr, xsk->mz->len, NULL, NULL);
+	if (ret < 0 || (unsigned int)ret != nb)
+		goto error;
+
+	rte_mempool_obj_iter(xsk->mb_pool, rte_pktmbuf_init, NULL);
+
+	xsk->umem = xsk->mz->addr;
+	xsk->mbuf_offset = objsz.header_size;
+	xsk->buf_offset = objsz.header_size + sizeof(struct rte_mbuf);
+
+	return 0;
+
+error:
+	RTE_LOG(ERR, PMD, "%s: cannot create UMEM mbuf pool\n", name);
+	rte_mempool_free(xsk->mb_pool);
+	rte_memzone_free(xsk->mz);
+	xsk->mb_pool = NULL;
+	xsk->mz = NULL;
+	return -1;
+}
+
+/*
+ * Close the socket, and free its UMEM unless the application still holds
+ * mbufs of it: the frames given to the kernel are the only ones expected
+ * out of the pool. Otherwise the UMEM is left allocated, so that these
+ * mbufs stay valid and can still be freed.
+ */
+static void
+xsk_socket_destroy(struct xsk_socket *xsk)
+{
+	unsigned int in_use = 0;
+
+	xsk_ring_unmap(&xsk->rx);
+	xsk_ring_unmap(&xsk->tx);
+	xsk_ring_unmap(&xsk->fill);
+	xsk_ring_unmap(&xsk->comp);
+	if (xsk->fd >= 0)
+		close(xsk->fd);
+	xsk->fd = -1;
+
+	if (xsk->mb_pool != NULL)
+		in_use = rte_mempool_in_use_count(xsk->mb_pool) -
+			xsk->nb_fill - xsk->nb_tx;
+	if (in_use != 0) {
+		RTE_LOG(WARNING, PMD,
+			"%s: %u mbufs still in use, UMEM not freed\n",
+			xsk->mb_pool->name, in_use);
+	} else {
+		rte_mempool_free(xsk->mb_pool);
+		rte_memzone_free(xsk->mz);
+	}
+	xsk->mb_pool = NULL;
+	xsk->mz = NULL;
+	xsk->nb_fill = 0;
+	xsk->nb_tx = 0;
+}
+
+static int
+xsk_socket_create(struct rte_eth_dev *dev, uint16_t qid)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+	struct xsk_socket *xsk = &internals->xsks[qid];
+	struct pkt_rx_queue *rxq = &internals->rx_queue[qid];
+	struct pkt_tx_queue *txq = &internals->tx_queue[qid];
+	char name[RTE_MEMZONE_NAMESIZE];
+	struct xdp_mmap_offsets off;
+	struct xdp_umem_reg reg;
+	struct sockaddr_xdp sxdp;
+	socklen_t optlen;
+	uint32_t rx_size, tx_size;
+	unsigned int nb_frames;
+	int opt;
+
+	rx_size = rte_align32pow2(rxq->nb_desc);
+	tx_size = rte_align32pow2(txq->nb_desc);
+
+	/*
+	 * Frames are held by the fill and Rx rings, by the Tx and completion
+	 * rings, and by the application in between; leave as many again.
+	 */
+	nb_frames = 2 * 2 * (rx_size + tx_size);
+
+	snprintf(name, sizeof(name), "af_xdp_%u_%u", dev->data->port_id, qid);
+	if (xsk_umem_create(xsk, name, nb_frames, dev->data->numa_node) < 0)
+		return -1;
+
+	xsk->fd = socket(AF_XDP, SOCK_RAW, 0);
+	if (xsk->fd < 0) {
+		RTE_LOG(ERR, PMD, "%s: could not open AF_XDP socket\n",
+			internals->if_name);
+		goto error;
+	}
+
+	memset(&reg, 0, sizeof(reg));
+	reg.addr = (uintptr_t)xsk->umem;
+	reg.len = (uint64_t)nb_frames * AF_XDP_FRAME_SIZE;
+	reg.chunk_size = AF_XDP_FRAME_SIZE;
+	reg.headroom = xsk->buf_offset;
+	if (setsockopt(xsk->fd, SOL_XDP, XDP_UMEM_REG, &reg, sizeof(reg)) < 0 ||
+	    setsockopt(xsk->fd, SOL_XDP, XDP_UMEM_FILL_RING,
+		       &rx_size, sizeof(rx_size)) < 0 ||
+	    setsockopt(xsk->fd, SOL_XDP, XDP_UMEM_COMPLETION_RING,
+		       &tx_size, sizeof(tx_size)) < 0 ||
+	    setsockopt(xsk->fd, SOL_XDP, XDP_RX_RING,
+		       &rx_size, sizeof(rx_size)) < 0 ||
+	    setsockopt(xsk->fd, SOL_XDP, XDP_TX_RING,
+		       &tx_size, sizeof(tx_size)) < 0) {
+		RTE_LOG(ERR, PMD, "%s: could not set up AF_XDP rings: %s\n",
+			internals->if_name, strerror(errno));
+		goto error;
+	}
+
+	optlen = sizeof(off);
+	if (getsockopt(xsk->fd, SOL_XDP, XDP_MMAP_OFFSETS, &off, &optlen) < 0)
+		goto error;
+
+	if (xsk_ring_map(xsk->fd, &xsk->fill, &off.fr, rx_size,
+			 sizeof(uint64_t), XDP_UMEM_PGOFF_FILL_RING) < 0 ||
+	    xsk_ring_map(xsk->fd, &xsk->comp, &off.cr, tx_size,
+			 sizeof(uint64_t), XDP_UMEM_PGOFF_COMPLETION_RING) < 0 ||
+	    xsk_ring_map(xsk->fd, &xsk->rx, &off.rx, rx_size,
+			 sizeof(struct xdp_desc), XDP_PGOFF_RX_RING) < 0 ||
+	    xsk_ring_map(xsk->fd, &xsk->tx, &off.tx, tx_size,
+			 sizeof(struct xdp_desc), XDP_PGOFF_TX_RING) < 0) {
+		RTE_LOG(ERR, PMD, "%s: could not map AF_XDP rings\n",
+			internals->if_name);
+		goto error;
+	}
+
+	if (internals->busy_budget != 0) {
+		opt = 1;
+		if (setsockopt(xsk->fd, SOL_SOCKET, SO_PREFER_BUSY_POLL,
+			       &opt, sizeof(opt)) < 0)
+			goto busy_error;
+		opt = AF_XDP_BUSY_POLL_TIMEOUT;
+		if (setsockopt(xsk->fd, SOL_SOCKET, SO_BUSY_POLL,
+			       &opt, sizeof(opt)) < 0)
+			goto busy_error;
+		opt = internals->busy_budget;
+		if (setsockopt(xsk->fd, SOL_SOCKET, SO_BUSY_POLL_BUDGET,
+			       &opt, sizeof(opt)) < 0)
+			goto busy_error;
+		rxq->busy_poll = 1;
+	}
+
+	memset(&sxdp, 0, sizeof(sxdp));
+	sxdp.sxdp_family = AF_XDP;
+	sxdp.sxdp_ifindex = internals->if_index;
+	sxdp.sxdp_queue_id = xsk->if_queue;
+	sxdp.sxdp_flags = XDP_USE_NEED_WAKEUP;
+	if (bind(xsk->fd, (struct sockaddr *)&sxdp, sizeof(sxdp)) < 0) {
+		RTE_LOG(ERR, PMD, "%s: could not bind AF_XDP socket to queue %u: %s\n",
+			internals->if_name, xsk->if_queue, strerror(errno));
+		goto error;
+	}
+
+	if (xsk_fill(xsk, rx_size) != 0) {
+		RTE_LOG(ERR, PMD, "%s: could not fill UMEM fill ring\n",
+			internals->if_name);
+		goto error;
+	}
+
+	rxq->xsk = xsk;
+	txq->xsk = xsk;
+	return 0;
+
+busy_error:
+	RTE_LOG(ERR, PMD, "%s: could not enable busy polling: %s\n",
+		internals->if_name, strerror(errno));
+error:
+	xsk_socket_destroy(xsk);
+	return -1;
+}
+
+static int
+eth_dev_start(struct rte_eth_dev *dev)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+	union bpf_attr attr;
+	uint32_t key;
+	unsigned int i;
+
+	/* sockets and program stay set up until the port is closed */
+	if (internals->prog_fd >= 0)
+		goto out;
+
+	if (xdp_prog_attach(internals) < 0)
+		return -1;
+
+	for (i = 0; i < internals->nb_queues; i++) {
+		if (xsk_socket_create(dev, i) < 0)
+			goto error;
+
+		key = internals->xsks[i].if_queue;
+		memset(&attr, 0, sizeof(attr));
+		attr.map_fd = internals->map_fd;
+		attr.key = (uintptr_t)&key;
+		attr.value = (uintptr_t)&internals->xsks[i].fd;
+		if (af_xdp_bpf(BPF_MAP_UPDATE_ELEM, &attr) < 0) {
+			RTE_LOG(ERR, PMD, "%s: could not update XSKMAP: %s\n",
+				internals->if_name, strerror(errno));
+			i++;
+			goto error;
+		}
+	}
+
+out:
+	dev->data->dev_link.link_status = ETH_LINK_UP;
+	return 0;
+
+error:
+	while (i-- > 0)
+		xsk_socket_destroy(&internals->xsks[i]);
+	xdp_prog_detach(internals);
+	return -1;
+}
+
+static void
+eth_dev_stop(struct rte_eth_dev *dev)
+{
+	dev->data->dev_link.link_status = ETH_LINK_DOWN;
+}
+
+static void
+eth_dev_close(struct rte_eth_dev *dev)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+	unsigned int i;
+
+	if (internals->prog_fd < 0)
+		return;
+
+	xdp_prog_detach(internals);
+	for (i = 0; i < internals->nb_queues; i++)
+		xsk_socket_destroy(&internals->xsks[i]);
+}
+
+static int
+eth_dev_configure(struct rte_eth_dev *dev __rte_unused)
+{
+	return 0;
+}
+
+static void
+eth_dev_info(struct rte_eth_dev *dev, struct rte_eth_dev_info *dev_info)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+
+	dev_info->if_index = internals->if_index;
+	dev_info->max_mac_addrs = 1;
+	dev_info->max_rx_pktlen = af_xdp_max_pktlen();
+	dev_info->max_rx_queues = (uint16_t)internals->nb_queues;
+	dev_info->max_tx_queues = (uint16_t)internals->nb_queues;
+	dev_info->min_rx_bufsize = 0;
+}
+
+static void
+eth_stats_get(struct rte_eth_dev *dev, struct rte_eth_stats *stats)
+{
+	const struct pmd_internals *internals = dev->data->dev_private;
+	const struct pkt_rx_queue *rxq;
+	const struct pkt_tx_queue *txq;
+	unsigned int i;
+
+	for (i = 0; i < internals->nb_queues; i++) {
+		rxq = &internals->rx_queue[i];
+		txq = &internals->tx_queue[i];
+		if (i < RTE_ETHDEV_QUEUE_STAT_CNTRS) {
+			stats->q_ipackets[i] = rxq->rx_pkts;
+			stats->q_ibytes[i] = rxq->rx_bytes;
+			stats->q_opackets[i] = txq->tx_pkts;
+			stats->q_obytes[i] = txq->tx_bytes;
+			stats->q_errors[i] = txq->err_pkts;
+		}
+		stats->ipackets += rxq->rx_pkts;
+		stats->ibytes += rxq->rx_bytes;
+		stats->rx_nombuf += rxq->rx_nombuf;
+		stats->opackets += txq->tx_pkts;
+		stats->obytes += txq->tx_bytes;
+		stats->oerrors += txq->err_pkts;
+	}
+}
+
+static void
+eth_stats_reset(struct rte_eth_dev *dev)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+	unsigned int i;
+
+	for (i = 0; i < internals->nb_queues; i++) {
+		internals->rx_queue[i].rx_pkts = 0;
+		internals->rx_queue[i].rx_bytes = 0;
+		internals->rx_queue[i].rx_nombuf = 0;
+		internals->tx_queue[i].tx_pkts = 0;
+		internals->tx_queue[i].tx_bytes = 0;
+		internals->tx_queue[i].err_pkts = 0;
+	}
+}
+
+static int
+xsk_get_stats(const struct xsk_socket *xsk, struct xdp_statistics *stats)
+{
+	socklen_t optlen = sizeof(*stats);
+
+	memset(stats, 0, sizeof(*stats));
+	if (xsk->fd < 0)
+		return -1;
+
+	return getsockopt(xsk->fd, SOL_XDP, XDP_STATISTICS, stats, &optlen);
+}
+
+static int
+eth_xstats_get_names(struct rte_eth_dev *dev __rte_unused,
+		     struct rte_eth_xstat_name *xstats_names,
+		     unsigned int limit __rte_unused)
+{
+	unsigned int i;
+
+	if (xstats_names == NULL)
+		return AF_XDP_NB_XSTATS;
+
+	for (i = 0; i < AF_XDP_NB_KERNEL_XSTATS; i++)
+		snprintf(xstats_names[i].name, sizeof(xstats_names[i].name),
+			 "%s", af_xdp_xstats_strings[i].name);
+	snprintf(xstats_names[i].name, sizeof(xstats_names[i].name),
+		 "tx_copied_packets");
+
+	return AF_XDP_NB_XSTATS;
+}
+
+static int
+eth_xstats_get(struct rte_eth_dev *dev, struct rte_eth_xstat *xstats,
+	       unsigned int n)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+	const struct xsk_socket *xsk;
+	struct xdp_statistics stats;
+	uint64_t cur, base;
+	unsigned int i, q;
+
+	if (n < AF_XDP_NB_XSTATS)
+		return AF_XDP_NB_XSTATS;
+
+	for (i = 0; i < AF_XDP_NB_XSTATS; i++) {
+		xstats[i].id = i;
+		xstats[i].value = 0;
+	}
+
+	for (q = 0; q < internals->nb_queues; q++) {
+		xsk = &internals->xsks[q];
+		if (xsk_get_stats(xsk, &stats) < 0)
+			continue;
+		for (i = 0; i < AF_XDP_NB_KERNEL_XSTATS; i++) {
+			cur = *(const uint64_t *)((const char *)&stats +
+				af_xdp_xstats_strings[i].offset);
+			base = *(const uint64_t *)((const char *)
+				&xsk->stats_base +
+				af_xdp_xstats_strings[i].offset);
+			xstats[i].value += cur - base;
+		}
+	}
+	for (q = 0; q < internals->nb_queues; q++)
+		xstats[AF_XDP_NB_KERNEL_XSTATS].value +=
+			internals->tx_queue[q].tx_copied;
+
+	return AF_XDP_NB_XSTATS;
+}
+
+static void
+eth_xstats_reset(struct rte_eth_dev *dev)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+	unsigned int q;
+
+	for (q = 0; q < internals->nb_queues; q++) {
+		xsk_get_stats(&internals->xsks[q],
+			      &internals->xsks[q].stats_base);
+		internals->tx_queue[q].tx_copied = 0;
+	}
+}
+
+static void
+eth_queue_release(void *q __rte_unused)
+{
+}
+
+static int
+eth_rx_queue_fd_get(struct rte_eth_dev *dev, uint16_t rx_queue_id)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+
+	return internals->xsks[rx_queue_id].fd;
+}
+
+static int
+eth_link_update(struct rte_eth_dev *dev __rte_unused,
+		int wait_to_complete __rte_unused)
+{
+	return 0;
+}
+
+static int
+eth_rx_queue_setup(struct rte_eth_dev *dev,
+		   uint16_t rx_queue_id,
+		   uint16_t nb_rx_desc,
+		   unsigned int socket_id __rte_unused,
+		   const struct rte_eth_rxconf *rx_conf __rte_unused,
+		   struct rte_mempool *mb_pool __rte_unused)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+	struct pkt_rx_queue *rxq = &internals->rx_queue[rx_queue_id];
+
+	/* Rx mbufs come from the pool backing the UMEM of the queue */
+	rxq->nb_desc = nb_rx_desc;
+	rxq->in_port = dev->data->port_id;
+	dev->data->rx_queues[rx_queue_id] = rxq;
+
+	return 0;
+}
+
+static int
+eth_tx_queue_setup(struct rte_eth_dev *dev,
+		   uint16_t tx_queue_id,
+		   uint16_t nb_tx_desc,
+		   unsigned int socket_id __rte_unused,
+		   const struct rte_eth_txconf *tx_conf __rte_unused)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+	struct pkt_tx_queue *txq = &internals->tx_queue[tx_queue_id];
+
+	txq->nb_desc = nb_tx_desc;
+	dev->data->tx_queues[tx_queue_id] = txq;
+
+	return 0;
+}
+
+static int
+eth_dev_mtu_set(struct rte_eth_dev *dev, uint16_t mtu)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+	struct ifreq ifr = { .ifr_mtu = mtu };
+	struct rte_eth_dev_info dev_info;
+	int ret;
+	int s;
+
+	eth_dev_info(dev, &dev_info);
+	if ((uint32_t)mtu + ETHER_HDR_LEN > dev_info.max_rx_pktlen)
+		return -EINVAL;
+
+	s = socket(PF_INET, SOCK_DGRAM, 0);
+	if (s < 0)
+		return -EINVAL;
+
+	snprintf(ifr.ifr_name, IFNAMSIZ, "%s", internals->if_name);
+	ret = ioctl(s, SIOCSIFMTU, &ifr);
+	close(s);
+
+	if (ret < 0)
+		return -EINVAL;
+
+	return 0;
+}
+
+static void
+eth_dev_change_flags(char *if_name, uint32_t flags, uint32_t mask)
+{
+	struct ifreq ifr;
+	int s;
+
+	s = socket(PF_INET, SOCK_DGRAM, 0);
+	if (s < 0)
+		return;
+
+	snprintf(ifr.ifr_name, IFNAMSIZ, "%s", if_name);
+	if (ioctl(s, SIOCGIFFLAGS, &ifr) < 0)
+		goto out;
+	ifr.ifr_flags &= mask;
+	ifr.ifr_flags |= flags;
+	if (ioctl(s, SIOCSIFFLAGS, &ifr) < 0)
+		goto out;
+out:
+	close(s);
+}
+
+static void
+eth_dev_promiscuous_enable(struct rte_eth_dev *dev)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+
+	eth_dev_change_flags(internals->if_name, IFF_PROMISC, ~0);
+}
+
+static void
+eth_dev_promiscuous_disable(struct rte_eth_dev *dev)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+
+	eth_dev_change_flags(internals->if_name, 0, ~IFF_PROMISC);
+}
+
+static const struct eth_dev_ops ops = {
+	.dev_start = eth_dev_start,
+	.dev_stop = eth_dev_stop,
+	.dev_close = eth_dev_close,
+	.dev_configure = eth_dev_configure,
+	.dev_infos_get = eth_dev_info,
+	.mtu_set = eth_dev_mtu_set,
+	.promiscuous_enable = eth_dev_promiscuous_enable,
+	.promiscuous_disable = eth_dev_promiscuous_disable,
+	.rx_queue_setup = eth_rx_queue_setup,
+	.tx_queue_setup = eth_tx_queue_setup,
+	.rx_queue_release = eth_queue_release,
+	.tx_queue_release = eth_queue_release,
+	.rx_queue_fd_get = eth_rx_queue_fd_get,
+	.link_update = eth_link_update,
+	.stats_get = eth_stats_get,
+	.stats_reset = eth_stats_reset,
+	.xstats_get = eth_xstats_get,
+	.xstats_reset = eth_xstats_reset,
+	.xstats_get_names = eth_xstats_get_names,
+};
+
+static struct rte_vdev_driver pmd_af_xdp_drv;
+
+static int
+get_if_info(const char *name, struct pmd_internals *internals)
+{
+	struct ifreq ifr;
+	int s, ret = -1;
+
+	s = socket(PF_INET, SOCK_DGRAM, 0);
+	if (s < 0)
+		return -1;
+
+	snprintf(ifr.ifr_name, IFNAMSIZ, "%s", internals->if_name);
+	if (ioctl(s, SIOCGIFINDEX, &ifr) < 0) {
+		RTE_LOG(ERR, PMD, "%s: ioctl failed (SIOCGIFINDEX)\n", name);
+		goto out;
+	}
+	internals->if_index = ifr.ifr_ifindex;
+
+	if (ioctl(s, SIOCGIFHWADDR, &ifr) < 0) {
+		RTE_LOG(ERR, PMD, "%s: ioctl failed (SIOCGIFHWADDR)\n", name);
+		goto out;
+	}
+	memcpy(&internals->eth_addr, ifr.ifr_hwaddr.sa_data, ETHER_ADDR_LEN);
+	ret = 0;
+out:
+	close(s);
+	return ret;
+}
+
+static int
+eth_dev_af_xdp_create(const char *name, const char *if_name,
+		      unsigned int start_queue, unsigned int nb_queues,
+		      unsigned int busy_budget, const unsigned int numa_node)
+{
+	struct rte_eth_dev_data *data = NULL;
+	struct pmd_internals *internals = NULL;
+	struct rte_eth_dev *eth_dev = NULL;
+	unsigned int q;
+
+	RTE_LOG(INFO, PMD,
+		"%s: creating AF_XDP ethdev on %s queues %u-%u\n",
+		name, if_name, start_queue, start_queue + nb_queues - 1);
+
+	data = rte_zmalloc_socket(name, sizeof(*data), 0, numa_node);
+	if (data == NULL)
+		goto error;
+
+	internals = rte_zmalloc_socket(name, sizeof(*internals), 0, numa_node);
+	if (internals == NULL)
+		goto error;
+
+	snprintf(internals->if_name, sizeof(internals->if_name), "%s",
+		 if_name);
+	internals->start_queue = start_queue;
+	internals->nb_queues = nb_queues;
+	internals->busy_budget = busy_budget;
+	internals->map_fd = -1;
+	internals->prog_fd = -1;
+	for (q = 0; q < nb_queues; q++) {
+		internals->xsks[q].fd = -1;
+		internals->xsks[q].if_queue = start_queue + q;
+	}
+
+	if (get_if_info(name, internals) < 0)
+		goto error;
+
+	eth_dev = rte_eth_dev_allocate(name);
+	if (eth_dev == NULL)
+		goto error;
+
+	data->dev_private = internals;
+	data->port_id = eth_dev->data->port_id;
+	data->nb_rx_queues = (uint16_t)nb_queues;
+	data->nb_tx_queues = (uint16_t)nb_queues;
+	data->dev_link = pmd_link;
+	data->mac_addrs = &internals->eth_addr;
+	snprintf(data->name, sizeof(data->name), "%s", eth_dev->data->name);
+
+	eth_dev->data = data;
+	eth_dev->dev_ops = &ops;
+	eth_dev->driver = NULL;
+	eth_dev->data->dev_flags = RTE_ETH_DEV_DETACHABLE;
+	eth_dev->data->drv_name = pmd_af_xdp_drv.driver.name;
+	eth_dev->data->kdrv = RTE_KDRV_NONE;
+	eth_dev->data->numa_node = numa_node;
+
+	eth_dev->rx_pkt_burst = eth_af_xdp_rx;
+	eth_dev->tx_pkt_burst = eth_af_xdp_tx;
+
+	return 0;
+
+error:
+	rte_free(internals);
+	rte_free(data);
+	return -1;
+}
+
+static int
+get_string_arg(const char *key __rte_unused, const char *value,
+	       void *extra_args)
+{
+	if (strlen(value) >= IFNAMSIZ)
+		return -1;
+
+	*(const char **)extra_args = value;
+	return 0;
+}
+
+static int
+get_uint_arg(const char *key __rte_unused, const char *value,
+	     void *extra_args)
+{
+	char *end;
+	unsigned long v;
+
+	errno = 0;
+	v = strtoul(value, &end, 0);
+	if (errno != 0 || *end != '\0' || v > UINT16_MAX)
+		return -1;
+
+	*(unsigned int *)extra_args = v;
+	return 0;
+}
+
+static int
+rte_pmd_af_xdp_probe(const char *name, const char *params)
+{
+	struct rte_kvargs *kvlist;
+	const char *if_name = NULL;
+	unsigned int start_queue = 0;
+	unsigned int nb_queues = 1;
+	unsigned int busy_budget = 0;
+	int ret = -1;
+
+	RTE_LOG(INFO, PMD, "Initializing pmd_af_xdp for %s\n", name);
+
+	kvlist = rte_kvargs_parse(params, valid_arguments);
+	if (kvlist == NULL)
+		return -1;
+
+	if (rte_kvargs_count(kvlist, ETH_AF_XDP_IFACE_ARG) != 1) {
+		RTE_LOG(ERR, PMD, "%s: no interface specified\n", name);
+		goto exit;
+	}
+
+	if (rte_kvargs_process(kvlist, ETH_AF_XDP_IFACE_ARG,
+			       &get_string_arg, &if_name) < 0 ||
+	    rte_kvargs_process(kvlist, ETH_AF_XDP_START_QUEUE_ARG,
+			       &get_uint_arg, &start_queue) < 0 ||
+	    rte_kvargs_process(kvlist, ETH_AF_XDP_QUEUE_COUNT_ARG,
+			       &get_uint_arg, &nb_queues) < 0 ||
+	    rte_kvargs_process(kvlist, ETH_AF_XDP_BUSY_BUDGET_ARG,
+			       &get_uint_arg, &busy_budget) < 0) {
+		RTE_LOG(ERR, PMD, "%s: invalid parameter\n", name);
+		goto exit;
+	}
+
+	if (nb_queues < 1 || nb_queues > RTE_PMD_AF_XDP_MAX_QUEUES) {
+		RTE_LOG(ERR, PMD, "%s: invalid queue_count value\n", name);
+		goto exit;
+	}
+
+	ret = eth_dev_af_xdp_create(name, if_name, start_queue, nb_queues,
+				    busy_budget, rte_socket_id());
+
+exit:
+	rte_kvargs_free(kvlist);
+	return ret;
+}
+
+static int
+rte_pmd_af_xdp_remove(const char *name)
+{
+	struct rte_eth_dev *eth_dev;
+
+	RTE_LOG(INFO, PMD, "Closing AF_XDP ethdev on numa socket %u\n",
+		rte_socket_id());
+
+	if (name == NULL)
+		return -1;
+
+	eth_dev = rte_eth_dev_allocated(name);
+	if (eth_dev == NULL)
+		return -1;
+
+	eth_dev_close(eth_dev);
+
+	rte_free(eth_dev->data->dev_private);
+	rte_free(eth_dev->data);
+
+	rte_eth_dev_release_port(eth_dev);
+
+	return 0;
+}
+
+static struct rte_vdev_driver pmd_af_xdp_drv = {
+	.probe = rte_pmd_af_xdp_probe,
+	.remove = rte_pmd_af_xdp_remove,
+};
+
+RTE_PMD_REGISTER_VDEV(net_af_xdp, pmd_af_xdp_drv);
+RTE_PMD_REGISTER_PARAM_STRING(net_af_xdp,
+	"iface=<string> "
+	"start_queue=<int> "
+	"queue_count=<int> "
+	"busy_budget=<int>");
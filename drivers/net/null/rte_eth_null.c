@@ -38,6 +38,7 @@
 #include <rte_vdev.h>
 #include <rte_kvargs.h>
 #include <rte_spinlock.h>
+#include <rte_net.h>
 
 #include "rte_eth_null.h"
 
@@ -151,6 +152,25 @@ eth_null_copy_rx(void *q, struct rte_mbuf **bufs, uint16_t nb_bufs)
 	return i;
 }
 
+/*
+ * Apply the TX offloads of a packet in software before dropping it, which
+ * gives their real cost.
+ */
+static void
+eth_null_tx_offload_free(struct rte_mbuf *m)
+{
+	struct rte_mbuf *pkts[RTE_NET_SW_TX_MAX_PKTS];
+	int i, nb;
+
+	nb = rte_net_sw_tx_offload(m, pkts, RTE_DIM(pkts));
+	if (nb < 0) {
+		rte_pktmbuf_free(m);
+		return;
+	}
+	for (i = 0; i < nb; i++)
+		rte_pktmbuf_free(pkts[i]);
+}
+
 static uint16_t
 eth_null_tx(void *q, struct rte_mbuf **bufs, uint16_t nb_bufs)
 {
@@ -160,8 +180,12 @@ eth_null_tx(void *q, struct rte_mbuf **bufs, uint16_t nb_bufs)
 	if ((q == NULL) || (bufs == NULL))
 		return 0;
 
-	for (i = 0; i < nb_bufs; i++)
-		rte_pktmbuf_free(bufs[i]);
+	for (i = 0; i < nb_bufs; i++) {
+		if (unlikely(bufs[i]->ol_flags & RTE_NET_SW_TX_OFFLOAD_MASK))
+			eth_null_tx_offload_free(bufs[i]);
+		else
+			rte_pktmbuf_free(bufs[i]);
+	}
 
 	rte_atomic64_add(&(h->tx_pkts), i);
 
@@ -182,7 +206,10 @@ eth_null_copy_tx(void *q, struct rte_mbuf **bufs, uint16_t nb_bufs)
 	for (i = 0; i < nb_bufs; i++) {
 		rte_memcpy(h->dummy_packet, rte_pktmbuf_mtod(bufs[i], void *),
 					packet_size);
-		rte_pktmbuf_free(bufs[i]);
+		if (unlikely(bufs[i]->ol_flags & RTE_NET_SW_TX_OFFLOAD_MASK))
+			eth_null_tx_offload_free(bufs[i]);
+		else
+			rte_pktmbuf_free(bufs[i]);
 	}
 
 	rte_atomic64_add(&(h->tx_pkts), i);
@@ -299,6 +326,7 @@ eth_dev_info(struct rte_eth_dev *dev,
 	dev_info->max_rx_queues = RTE_DIM(internals->rx_null_queues);
 	dev_info->max_tx_queues = RTE_DIM(internals->tx_null_queues);
 	dev_info->min_rx_bufsize = 0;
+	dev_info->tx_offload_capa = RTE_NET_SW_TX_OFFLOAD_CAPA;
 	dev_info->reta_size = internals->reta_size;
 	dev_info->flow_type_rss_offloads = internals->flow_type_rss_offloads;
 }
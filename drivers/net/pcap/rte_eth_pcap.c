@@ -33,6 +33,8 @@
  */
 
 #include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
 
 #include <net/if.h>
 
@@ -43,6 +45,7 @@
 #include <rte_kvargs.h>
 #include <rte_malloc.h>
 #include <rte_mbuf.h>
+#include <rte_net.h>
 #include <rte_vdev.h>
 
 #define RTE_ETH_PCAP_SNAPSHOT_LEN 65535
@@ -55,14 +58,24 @@
 #define ETH_PCAP_RX_IFACE_ARG "rx_iface"
 #define ETH_PCAP_TX_IFACE_ARG "tx_iface"
 #define ETH_PCAP_IFACE_ARG    "iface"
+#define ETH_PCAP_PRELOAD_ARG  "preload"
+#define ETH_PCAP_LOOP_ARG     "loop"
+#define ETH_PCAP_PACE_ARG     "pace"
+#define ETH_PCAP_PACE_TS      "ts"
 
 #define ETH_PCAP_ARG_MAXLEN	64
 
 #define RTE_PMD_PCAP_MAX_QUEUES 16
 
+/* stdio buffer of the pcap dumpers and how often it is pushed to the file */
+#define RTE_ETH_PCAP_DUMP_BUFSIZE (1 << 20)
+#define RTE_ETH_PCAP_DUMP_FLUSH_MS 100
+
+#define NSEC_PER_SEC 1000000000ULL
+
 static char errbuf[PCAP_ERRBUF_SIZE];
 static unsigned char tx_pcap_data[RTE_ETH_PCAP_SNAPLEN];
-static struct timeval start_time;
+static struct timespec start_time;
 static uint64_t start_cycles;
 static uint64_t hz;
 
@@ -70,6 +83,30 @@ struct queue_stat {
 	volatile unsigned long pkts;
 	volatile unsigned long bytes;
 	volatile unsigned long err_pkts;
+	volatile unsigned long rx_nombuf;
+};
+
+/* How a preloaded rx_pcap file is replayed */
+struct pcap_replay_conf {
+	unsigned int preload;	/* load the file in memory at start */
+	uint64_t loops;		/* number of passes over the file, 0 = forever */
+	unsigned int pace_ts;	/* pace by the capture timestamps */
+	uint64_t rate;		/* pace at this many packets/s, 0 = no rate */
+};
+
+/* A pcap file loaded in hugepage memory, one mbuf per packet */
+struct pcap_replay {
+	struct pcap_replay_conf conf;
+	struct rte_mempool *pool;	/* holds the packets of the file */
+	struct rte_mbuf **pkts;		/* packets in file order */
+	uint64_t *pkt_tsc;		/* capture time relative to the first */
+	uint32_t nb_pkts;
+	uint32_t next;			/* next packet to replay */
+	uint64_t loop;			/* passes completed */
+	uint64_t loop_cycles;		/* duration of one pass */
+	uint64_t sent;			/* packets replayed so far */
+	uint64_t start;			/* TSC of the first replayed packet */
+	double cycles_per_pkt;		/* interval at the configured rate */
 };
 
 struct pcap_rx_queue {
@@ -77,12 +114,15 @@ struct pcap_rx_queue {
 	uint8_t in_port;
 	struct rte_mempool *mb_pool;
 	struct queue_stat rx_stat;
+	struct pcap_replay replay;
 	char name[PATH_MAX];
 	char type[ETH_PCAP_ARG_MAXLEN];
 };
 
 struct pcap_tx_queue {
 	pcap_dumper_t *dumper;
+	char *dumper_buf;
+	uint64_t next_flush;
 	pcap_t *pcap;
 	struct queue_stat tx_stat;
 	char name[PATH_MAX];
@@ -100,6 +140,7 @@ struct pmd_devargs {
 	unsigned int num_of_queue;
 	struct devargs_queue {
 		pcap_dumper_t *dumper;
+		char *dumper_buf;
 		pcap_t *pcap;
 		const char *name;
 		const char *type;
@@ -112,6 +153,9 @@ static const char *valid_arguments[] = {
 	ETH_PCAP_RX_IFACE_ARG,
 	ETH_PCAP_TX_IFACE_ARG,
 	ETH_PCAP_IFACE_ARG,
+	ETH_PCAP_PRELOAD_ARG,
+	ETH_PCAP_LOOP_ARG,
+	ETH_PCAP_PACE_ARG,
 	NULL
 };
 
@@ -239,15 +283,185 @@ eth_pcap_rx(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 	return num_rx;
 }
 
+/*
+ * Replays a preloaded pcap file. Each packet is handed out as an indirect
+ * mbuf attached to its copy in memory, so nothing is copied per packet and
+ * the packet data must be treated as read-only.
+ */
+static uint16_t
+eth_pcap_rx_replay(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
+{
+	struct pcap_rx_queue *pcap_q = queue;
+	struct pcap_replay *r = &pcap_q->replay;
+	struct rte_mbuf *pkts[nb_pkts];
+	uint64_t loop = r->loop, sent = r->sent, now = 0;
+	uint32_t next = r->next;
+	uint32_t rx_bytes = 0;
+	uint16_t i, num_rx;
+
+	if (unlikely(r->nb_pkts == 0 || nb_pkts == 0))
+		return 0;
+
+	if (r->conf.pace_ts || r->conf.rate) {
+		now = rte_rdtsc();
+		if (unlikely(r->start == 0))
+			r->start = now;
+	}
+
+	/* Pick the packets which are due, without touching the queue state
+	 * until their mbufs are allocated.
+	 */
+	for (num_rx = 0; num_rx < nb_pkts; num_rx++) {
+		if (r->conf.loops != 0 && loop >= r->conf.loops)
+			break;
+		if (r->conf.pace_ts && r->start + loop * r->loop_cycles +
+				r->pkt_tsc[next] > now)
+			break;
+		if (r->conf.rate && r->start +
+				(uint64_t)(sent * r->cycles_per_pkt) > now)
+			break;
+
+		pkts[num_rx] = r->pkts[next];
+		sent++;
+		if (++next == r->nb_pkts) {
+			next = 0;
+			loop++;
+		}
+	}
+
+	if (num_rx == 0)
+		return 0;
+	if (unlikely(rte_pktmbuf_alloc_bulk(pcap_q->mb_pool, bufs,
+					    num_rx) != 0)) {
+		pcap_q->rx_stat.rx_nombuf++;
+		return 0;
+	}
+
+	for (i = 0; i < num_rx; i++) {
+		rte_pktmbuf_attach(bufs[i], pkts[i]);
+		bufs[i]->port = pcap_q->in_port;
+		rx_bytes += pkts[i]->pkt_len;
+	}
+
+	r->next = next;
+	r->loop = loop;
+	r->sent = sent;
+	pcap_q->rx_stat.pkts += num_rx;
+	pcap_q->rx_stat.bytes += rx_bytes;
+
+	return num_rx;
+}
+
+/*
+ * The dumpers write nanosecond pcap files, in which tv_usec holds
+ * nanoseconds.
+ */
 static inline void
 calculate_timestamp(struct timeval *ts) {
-	uint64_t cycles;
-	struct timeval cur_time;
+	uint64_t cycles, nsec;
 
 	cycles = rte_get_timer_cycles() - start_cycles;
-	cur_time.tv_sec = cycles / hz;
-	cur_time.tv_usec = (cycles % hz) * 1e6 / hz;
-	timeradd(&start_time, &cur_time, ts);
+	nsec = start_time.tv_nsec + (cycles % hz) * NSEC_PER_SEC / hz;
+	ts->tv_sec = start_time.tv_sec + cycles / hz + nsec / NSEC_PER_SEC;
+	ts->tv_usec = nsec % NSEC_PER_SEC;
+}
+
+/*
+ * Write one packet to a pcap file. Returns its length, or 0 if it is too
+ * large.
+ */
+static uint32_t
+eth_pcap_dump(struct pcap_tx_queue *dumper_q, struct rte_mbuf *mbuf)
+{
+	struct pcap_pkthdr header;
+
+	calculate_timestamp(&header.ts);
+	header.len = mbuf->pkt_len;
+	header.caplen = header.len;
+
+	if (likely(mbuf->nb_segs == 1)) {
+		pcap_dump((u_char *)dumper_q->dumper, &header,
+			  rte_pktmbuf_mtod(mbuf, void*));
+	} else {
+		if (mbuf->pkt_len <= ETHER_MAX_JUMBO_FRAME_LEN) {
+			eth_pcap_gather_data(tx_pcap_data, mbuf);
+			pcap_dump((u_char *)dumper_q->dumper, &header,
+				  tx_pcap_data);
+		} else {
+			RTE_LOG(ERR, PMD,
+				"Dropping PCAP packet. Size (%d) > max jumbo size (%d).\n",
+				mbuf->pkt_len,
+				ETHER_MAX_JUMBO_FRAME_LEN);
+			return 0;
+		}
+	}
+
+	return mbuf->pkt_len;
+}
+
+/*
+ * Send one packet through a real NIC. Returns its length, or 0 if it could
+ * not be sent.
+ */
+static uint32_t
+eth_pcap_send(struct pcap_tx_queue *tx_queue, struct rte_mbuf *mbuf)
+{
+	int ret;
+
+	if (likely(mbuf->nb_segs == 1)) {
+		ret = pcap_sendpacket(tx_queue->pcap,
+				rte_pktmbuf_mtod(mbuf, u_char *),
+				mbuf->pkt_len);
+	} else {
+		if (mbuf->pkt_len <= ETHER_MAX_JUMBO_FRAME_LEN) {
+			eth_pcap_gather_data(tx_pcap_data, mbuf);
+			ret = pcap_sendpacket(tx_queue->pcap,
+					tx_pcap_data, mbuf->pkt_len);
+		} else {
+			RTE_LOG(ERR, PMD,
+				"Dropping PCAP packet. Size (%d) > max jumbo size (%d).\n",
+				mbuf->pkt_len,
+				ETHER_MAX_JUMBO_FRAME_LEN);
+			return 0;
+		}
+	}
+
+	return (ret == 0) ? mbuf->pkt_len : 0;
+}
+
+typedef uint32_t (*eth_pcap_xmit_t)(struct pcap_tx_queue *q,
+		struct rte_mbuf *mbuf);
+
+/*
+ * Apply the TX offloads of a packet in software and hand over the
+ * resulting packets. The packet is always consumed, failures are counted
+ * as errors.
+ */
+static void
+eth_pcap_tx_offload(struct pcap_tx_queue *q, struct rte_mbuf *mbuf,
+		eth_pcap_xmit_t xmit)
+{
+	struct rte_mbuf *pkts[RTE_NET_SW_TX_MAX_PKTS];
+	uint32_t len;
+	int i, nb;
+
+	nb = rte_net_sw_tx_offload(mbuf, pkts, RTE_DIM(pkts));
+	if (unlikely(nb < 0)) {
+		rte_pktmbuf_free(mbuf);
+		q->tx_stat.err_pkts++;
+		return;
+	}
+
+	for (i = 0; i < nb; i++) {
+		len = xmit(q, pkts[i]);
+		if (likely(len != 0)) {
+			q->tx_stat.pkts++;
+			q->tx_stat.bytes += len;
+		} else {
+			q->tx_stat.err_pkts++;
+		}
+		rte_pktmbuf_free(pkts[i]);
+	}
 }
 
 /*
@@ -259,9 +473,8 @@ eth_pcap_tx_dumper(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 	unsigned int i;
 	struct rte_mbuf *mbuf;
 	struct pcap_tx_queue *dumper_q = queue;
-	uint16_t num_tx = 0;
-	uint32_t tx_bytes = 0;
-	struct pcap_pkthdr header;
+	uint16_t num_tx = 0, num_offload = 0;
+	uint32_t tx_bytes = 0, len;
 
 	if (dumper_q->dumper == NULL || nb_pkts == 0)
 		return 0;
@@ -270,45 +483,37 @@ eth_pcap_tx_dumper(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 	 * dumper */
 	for (i = 0; i < nb_pkts; i++) {
 		mbuf = bufs[i];
-		calculate_timestamp(&header.ts);
-		header.len = mbuf->pkt_len;
-		header.caplen = header.len;
-
-		if (likely(mbuf->nb_segs == 1)) {
-			pcap_dump((u_char *)dumper_q->dumper, &header,
-				  rte_pktmbuf_mtod(mbuf, void*));
-		} else {
-			if (mbuf->pkt_len <= ETHER_MAX_JUMBO_FRAME_LEN) {
-				eth_pcap_gather_data(tx_pcap_data, mbuf);
-				pcap_dump((u_char *)dumper_q->dumper, &header,
-					  tx_pcap_data);
-			} else {
-				RTE_LOG(ERR, PMD,
-					"Dropping PCAP packet. Size (%d) > max jumbo size (%d).\n",
-					mbuf->pkt_len,
-					ETHER_MAX_JUMBO_FRAME_LEN);
 
-				rte_pktmbuf_free(mbuf);
-				break;
-			}
+		if (unlikely(mbuf->ol_flags & RTE_NET_SW_TX_OFFLOAD_MASK)) {
+			eth_pcap_tx_offload(dumper_q, mbuf, eth_pcap_dump);
+			num_offload++;
+			continue;
 		}
 
+		len = eth_pcap_dump(dumper_q, mbuf);
 		rte_pktmbuf_free(mbuf);
+		if (unlikely(len == 0))
+			break;
+
 		num_tx++;
-		tx_bytes += mbuf->pkt_len;
+		tx_bytes += len;
 	}
 
 	/*
 	 * Since there's no place to hook a callback when the forwarding
 	 * process stops and to make sure the pcap file is actually written,
-	 * we flush the pcap dumper within each burst.
+	 * the large dumper buffer is pushed to the file periodically.
 	 */
-	pcap_dump_flush(dumper_q->dumper);
+	if (unlikely(rte_get_timer_cycles() >= dumper_q->next_flush)) {
+		pcap_dump_flush(dumper_q->dumper);
+		dumper_q->next_flush = rte_get_timer_cycles() +
+			hz * RTE_ETH_PCAP_DUMP_FLUSH_MS / 1000;
+	}
 	dumper_q->tx_stat.pkts += num_tx;
 	dumper_q->tx_stat.bytes += tx_bytes;
-	dumper_q->tx_stat.err_pkts += nb_pkts - num_tx;
+	dumper_q->tx_stat.err_pkts += nb_pkts - num_tx - num_offload;
 
-	return num_tx;
+	return num_tx + num_offload;
 }
 
 /*
@@ -318,11 +523,10 @@ static uint16_t
 eth_pcap_tx(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 {
 	unsigned int i;
-	int ret;
 	struct rte_mbuf *mbuf;
 	struct pcap_tx_queue *tx_queue = queue;
-	uint16_t num_tx = 0;
-	uint32_t tx_bytes = 0;
+	uint16_t num_tx = 0, num_offload = 0;
+	uint32_t tx_bytes = 0, len;
 
 	if (unlikely(nb_pkts == 0 || tx_queue->pcap == NULL))
 		return 0;
@@ -330,38 +534,29 @@ eth_pcap_tx(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 	for (i = 0; i < nb_pkts; i++) {
 		mbuf = bufs[i];
 
-		if (likely(mbuf->nb_segs == 1)) {
-			ret = pcap_sendpacket(tx_queue->pcap,
-					rte_pktmbuf_mtod(mbuf, u_char *),
-					mbuf->pkt_len);
-		} else {
-			if (mbuf->pkt_len <= ETHER_MAX_JUMBO_FRAME_LEN) {
-				eth_pcap_gather_data(tx_pcap_data, mbuf);
-				ret = pcap_sendpacket(tx_queue->pcap,
-						tx_pcap_data, mbuf->pkt_len);
-			} else {
-				RTE_LOG(ERR, PMD,
-					"Dropping PCAP packet. Size (%d) > max jumbo size (%d).\n",
-					mbuf->pkt_len,
-					ETHER_MAX_JUMBO_FRAME_LEN);
-
-				rte_pktmbuf_free(mbuf);
-				break;
-			}
+		if (unlikely(mbuf->ol_flags & RTE_NET_SW_TX_OFFLOAD_MASK)) {
+			eth_pcap_tx_offload(tx_queue, mbuf, eth_pcap_send);
+			num_offload++;
+			continue;
 		}
 
-		if (unlikely(ret != 0))
+		len = eth_pcap_send(tx_queue, mbuf);
+		if (unlikely(len == 0)) {
+			/* oversized packets are dropped, as before */
+			if (mbuf->pkt_len > ETHER_MAX_JUMBO_FRAME_LEN)
+				rte_pktmbuf_free(mbuf);
 			break;
+		}
 		num_tx++;
-		tx_bytes += mbuf->pkt_len;
+		tx_bytes += len;
 		rte_pktmbuf_free(mbuf);
 	}
 
 	tx_queue->tx_stat.pkts += num_tx;
 	tx_queue->tx_stat.bytes += tx_bytes;
-	tx_queue->tx_stat.err_pkts += nb_pkts - num_tx;
+	tx_queue->tx_stat.err_pkts += nb_pkts - num_tx - num_offload;
 
-	return num_tx;
+	return num_tx + num_offload;
 }
 
 /*
@@ -392,30 +587,55 @@ open_single_iface(const char *iface, pcap_t **pcap)
 }
 
 static int
-open_single_tx_pcap(const char *pcap_filename, pcap_dumper_t **dumper)
+open_single_tx_pcap(const char *pcap_filename, pcap_dumper_t **dumper,
+		char **dumper_buf)
 {
 	pcap_t *tx_pcap;
+	FILE *f;
 
 	/*
 	 * We need to create a dummy empty pcap_t to use it
-	 * with pcap_dump_open(). We create big enough an Ethernet
-	 * pcap holder.
+	 * with pcap_dump_fopen(). We create big enough an Ethernet
+	 * pcap holder, with nanosecond timestamps.
 	 */
-	tx_pcap = pcap_open_dead(DLT_EN10MB, RTE_ETH_PCAP_SNAPSHOT_LEN);
+	tx_pcap = pcap_open_dead_with_tstamp_precision(DLT_EN10MB,
+			RTE_ETH_PCAP_SNAPSHOT_LEN, PCAP_TSTAMP_PRECISION_NANO);
 	if (tx_pcap == NULL) {
 		RTE_LOG(ERR, PMD, "Couldn't create dead pcap\n");
 		return -1;
 	}
 
+	/* Give the file a large buffer before the dumper writes to it */
+	*dumper_buf = malloc(RTE_ETH_PCAP_DUMP_BUFSIZE);
+	f = fopen(pcap_filename, "w");
+	if (*dumper_buf == NULL || f == NULL ||
+	    setvbuf(f, *dumper_buf, _IOFBF, RTE_ETH_PCAP_DUMP_BUFSIZE) != 0)
+		goto error;
+
 	/* The dumper is created using the previous pcap_t reference */
-	*dumper = pcap_dump_open(tx_pcap, pcap_filename);
-	if (*dumper == NULL) {
-		RTE_LOG(ERR, PMD, "Couldn't open %s for writing.\n",
-			pcap_filename);
-		return -1;
-	}
+	*dumper = pcap_dump_fopen(tx_pcap, f);
+	if (*dumper == NULL)
+		goto error;
 
 	return 0;
+
+error:
+	RTE_LOG(ERR, PMD, "Couldn't open %s for writing.\n", pcap_filename);
+	if (f != NULL)
+		fclose(f);
+	free(*dumper_buf);
+	*dumper_buf = NULL;
+	pcap_close(tx_pcap);
+	return -1;
+}
+
+static void
+close_single_tx_pcap(pcap_dumper_t **dumper, char **dumper_buf)
+{
+	pcap_dump_close(*dumper);
+	free(*dumper_buf);
+	*dumper = NULL;
+	*dumper_buf = NULL;
 }
 
 static int
@@ -431,6 +651,163 @@ open_single_rx_pcap(const char *pcap_filename, pcap_t **pcap)
 	return 0;
 }
 
+/* Restarts the replay of a preloaded file from its first packet */
+static void
+eth_pcap_rx_rewind(struct pcap_replay *r)
+{
+	r->next = 0;
+	r->loop = 0;
+	r->sent = 0;
+	r->start = 0;
+}
+
+/*
+ * Loads the rx_pcap file of a queue into a mempool of its own, once, so it
+ * can be replayed without going through libpcap again.
+ */
+static int
+eth_pcap_rx_preload(struct rte_eth_dev *dev, struct pcap_rx_queue *rx,
+		uint16_t rx_queue_id)
+{
+	struct pcap_replay *r = &rx->replay;
+	char pool_name[RTE_MEMPOOL_NAMESIZE];
+	struct pcap_pkthdr *header;
+	const u_char *packet;
+	struct rte_mbuf *m;
+	uint64_t first_ns = 0, ns, tsc_hz;
+	uint32_t nb_pkts = 0, max_len = 0;
+	uint16_t len;
+	pcap_t *pcap;
+
+	/* First pass to size the pool */
+	pcap = pcap_open_offline_with_tstamp_precision(rx->name,
+			PCAP_TSTAMP_PRECISION_NANO, errbuf);
+	if (pcap == NULL) {
+		RTE_LOG(ERR, PMD, "Couldn't open %s: %s\n", rx->name, errbuf);
+		return -1;
+	}
+	while (pcap_next_ex(pcap, &header, &packet) == 1) {
+		nb_pkts++;
+		max_len = RTE_MAX(max_len, header->caplen);
+	}
+	pcap_close(pcap);
+
+	if (nb_pkts == 0) {
+		RTE_LOG(WARNING, PMD, "%s: nothing to replay in %s\n",
+			dev->data->name, rx->name);
+		return 0;
+	}
+
+	snprintf(pool_name, sizeof(pool_name), "pcap_replay_%u_%u",
+		 dev->data->port_id, rx_queue_id);
+	r->pool = rte_pktmbuf_pool_create(pool_name, nb_pkts, 0, 0,
+			RTE_MIN(max_len + RTE_PKTMBUF_HEADROOM,
+				(uint32_t)UINT16_MAX),
+			dev->data->numa_node);
+	r->pkts = rte_zmalloc_socket(pool_name, nb_pkts * sizeof(*r->pkts),
+			0, dev->data->numa_node);
+	if (r->conf.pace_ts)
+		r->pkt_tsc = rte_zmalloc_socket(pool_name,
+				nb_pkts * sizeof(*r->pkt_tsc), 0,
+				dev->data->numa_node);
+	if (r->pool == NULL || r->pkts == NULL ||
+	    (r->conf.pace_ts && r->pkt_tsc == NULL)) {
+		RTE_LOG(ERR, PMD, "%s: not enough memory to preload %u packets\n",
+			dev->data->name, nb_pkts);
+		goto error;
+	}
+
+	/* Second pass to copy the packets in */
+	pcap = pcap_open_offline_with_tstamp_precision(rx->name,
+			PCAP_TSTAMP_PRECISION_NANO, errbuf);
+	if (pcap == NULL) {
+		RTE_LOG(ERR, PMD, "Couldn't open %s: %s\n", rx->name, errbuf);
+		goto error;
+	}
+
+	tsc_hz = rte_get_tsc_hz();
+	while (r->nb_pkts < nb_pkts &&
+	       pcap_next_ex(pcap, &header, &packet) == 1) {
+		m = rte_pktmbuf_alloc(r->pool);
+		if (m == NULL)
+			break;
+
+		/* snapshots beyond the mbuf limit are truncated */
+		len = RTE_MIN(header->caplen, rte_pktmbuf_tailroom(m));
+		rte_memcpy(rte_pktmbuf_append(m, len), packet, len);
+		m->port = dev->data->port_id;
+
+		if (r->pkt_tsc != NULL) {
+			ns = header->ts.tv_sec * NSEC_PER_SEC +
+				header->ts.tv_usec;
+			if (r->nb_pkts == 0)
+				first_ns = ns;
+			r->pkt_tsc[r->nb_pkts] = (ns < first_ns) ? 0 :
+				(uint64_t)((double)(ns - first_ns) * tsc_hz /
+					   NSEC_PER_SEC);
+			/* never go back in time */
+			if (r->nb_pkts > 0 && r->pkt_tsc[r->nb_pkts] <
+					r->pkt_tsc[r->nb_pkts - 1])
+				r->pkt_tsc[r->nb_pkts] =
+					r->pkt_tsc[r->nb_pkts - 1];
+		}
+		r->pkts[r->nb_pkts++] = m;
+	}
+	pcap_close(pcap);
+
+	/* a pass lasts as long as the capture plus one average gap */
+	if (r->pkt_tsc != NULL && r->nb_pkts > 1)
+		r->loop_cycles = r->pkt_tsc[r->nb_pkts - 1] +
+			r->pkt_tsc[r->nb_pkts - 1] / (r->nb_pkts - 1);
+	if (r->conf.rate)
+		r->cycles_per_pkt = (double)tsc_hz / r->conf.rate;
+	eth_pcap_rx_rewind(r);
+
+	RTE_LOG(INFO, PMD, "%s: preloaded %u packets from %s\n",
+		dev->data->name, r->nb_pkts, rx->name);
+
+	return 0;
+
+error:
+	rte_free(r->pkt_tsc);
+	rte_free(r->pkts);
+	rte_mempool_free(r->pool);
+	r->pkt_tsc = NULL;
+	r->pkts = NULL;
+	r->pool = NULL;
+	return -1;
+}
+
+/*
+ * Drops a preloaded file. The packets handed out are attached to it, so it
+ * is kept, and leaked, if the application did not free them all.
+ */
+static void
+eth_pcap_rx_unload(struct pcap_rx_queue *rx)
+{
+	struct pcap_replay *r = &rx->replay;
+	uint32_t i;
+
+	for (i = 0; i < r->nb_pkts; i++) {
+		if (rte_mbuf_refcnt_read(r->pkts[i]) > 1) {
+			RTE_LOG(ERR, PMD,
+				"%s: replayed packets still in use, kept\n",
+				rx->name);
+			return;
+		}
+	}
+
+	for (i = 0; i < r->nb_pkts; i++)
+		rte_pktmbuf_free(r->pkts[i]);
+	rte_free(r->pkt_tsc);
+	rte_free(r->pkts);
+	rte_mempool_free(r->pool);
+	r->pkt_tsc = NULL;
+	r->pkts = NULL;
+	r->pool = NULL;
+	r->nb_pkts = 0;
+}
+
 static int
 eth_dev_start(struct rte_eth_dev *dev)
 {
@@ -458,7 +835,8 @@ eth_dev_start(struct rte_eth_dev *dev)
 
 		if (!tx->dumper &&
 				strcmp(tx->type, ETH_PCAP_TX_PCAP_ARG) == 0) {
-			if (open_single_tx_pcap(tx->name, &tx->dumper) < 0)
+			if (open_single_tx_pcap(tx->name, &tx->dumper,
+						&tx->dumper_buf) < 0)
 				return -1;
 		} else if (!tx->pcap &&
 				strcmp(tx->type, ETH_PCAP_TX_IFACE_ARG) == 0) {
@@ -471,6 +849,13 @@ eth_dev_start(struct rte_eth_dev *dev)
 	for (i = 0; i < dev->data->nb_rx_queues; i++) {
 		rx = &internals->rx_queue[i];
 
+		if (rx->replay.conf.preload) {
+			if (rx->replay.pkts != NULL)
+				eth_pcap_rx_rewind(&rx->replay);
+			else if (eth_pcap_rx_preload(dev, rx, i) < 0)
+				return -1;
+		}
+
 		if (rx->pcap != NULL)
 			continue;
 
@@ -515,10 +900,8 @@ eth_dev_stop(struct rte_eth_dev *dev)
 	for (i = 0; i < dev->data->nb_tx_queues; i++) {
 		tx = &internals->tx_queue[i];
 
-		if (tx->dumper != NULL) {
-			pcap_dump_close(tx->dumper);
-			tx->dumper = NULL;
-		}
+		if (tx->dumper != NULL)
+			close_single_tx_pcap(&tx->dumper, &tx->dumper_buf);
 
 		if (tx->pcap != NULL) {
 			pcap_close(tx->pcap);
@@ -557,6 +940,7 @@ eth_dev_info(struct rte_eth_dev *dev,
 	dev_info->max_rx_queues = dev->data->nb_rx_queues;
 	dev_info->max_tx_queues = dev->data->nb_tx_queues;
 	dev_info->min_rx_bufsize = 0;
+	dev_info->tx_offload_capa = RTE_NET_SW_TX_OFFLOAD_CAPA;
 }
 
 static void
@@ -566,6 +950,7 @@ eth_stats_get(struct rte_eth_dev *dev, struct rte_eth_stats *stats)
 	unsigned long rx_packets_total = 0, rx_bytes_total = 0;
 	unsigned long tx_packets_total = 0, tx_bytes_total = 0;
 	unsigned long tx_packets_err_total = 0;
+	unsigned long rx_nombuf_total = 0;
 	const struct pmd_internals *internal = dev->data->dev_private;
 
 	for (i = 0; i < RTE_ETHDEV_QUEUE_STAT_CNTRS &&
@@ -574,6 +959,7 @@ eth_stats_get(struct rte_eth_dev *dev, struct rte_eth_stats *stats)
 		stats->q_ibytes[i] = internal->rx_queue[i].rx_stat.bytes;
 		rx_packets_total += stats->q_ipackets[i];
 		rx_bytes_total += stats->q_ibytes[i];
+		rx_nombuf_total += internal->rx_queue[i].rx_stat.rx_nombuf;
 	}
 
 	for (i = 0; i < RTE_ETHDEV_QUEUE_STAT_CNTRS &&
@@ -588,6 +974,7 @@ eth_stats_get(struct rte_eth_dev *dev, struct rte_eth_stats *stats)
 
 	stats->ipackets = rx_packets_total;
 	stats->ibytes = rx_bytes_total;
+	stats->rx_nombuf = rx_nombuf_total;
 	stats->opackets = tx_packets_total;
 	stats->obytes = tx_bytes_total;
 	stats->oerrors = tx_packets_err_total;
@@ -602,6 +989,7 @@ eth_stats_reset(struct rte_eth_dev *dev)
 	for (i = 0; i < dev->data->nb_rx_queues; i++) {
 		internal->rx_queue[i].rx_stat.pkts = 0;
 		internal->rx_queue[i].rx_stat.bytes = 0;
+		internal->rx_queue[i].rx_stat.rx_nombuf = 0;
 	}
 
 	for (i = 0; i < dev->data->nb_tx_queues; i++) {
@@ -611,9 +999,15 @@ eth_stats_reset(struct rte_eth_dev *dev)
 	}
 }
 
+/* The preloaded files are kept from one start to the next until then */
 static void
-eth_dev_close(struct rte_eth_dev *dev __rte_unused)
+eth_dev_close(struct rte_eth_dev *dev)
 {
+	struct pmd_internals *internals = dev->data->dev_private;
+	unsigned int i;
+
+	for (i = 0; i < dev->data->nb_rx_queues; i++)
+		eth_pcap_rx_unload(&internals->rx_queue[i]);
 }
 
 static void
@@ -712,7 +1106,8 @@ open_tx_pcap(const char *key, const char *value, void *extra_args)
 	pcap_dumper_t *dumper;
 
 	for (i = 0; i < dumpers->num_of_queue; i++) {
-		if (open_single_tx_pcap(pcap_filename, &dumper) < 0)
+		if (open_single_tx_pcap(pcap_filename, &dumper,
+				&dumpers->queue[i].dumper_buf) < 0)
 			return -1;
 
 		dumpers->queue[i].dumper = dumper;
@@ -787,6 +1182,53 @@ open_tx_iface(const char *key, const char *value, void *extra_args)
 	return 0;
 }
 
+static int
+set_preload(const char *key __rte_unused, const char *value,
+		void *extra_args)
+{
+	struct pcap_replay_conf *conf = extra_args;
+
+	conf->preload = (value == NULL) ? 1 : !!atoi(value);
+	return 0;
+}
+
+static int
+set_loop(const char *key __rte_unused, const char *value, void *extra_args)
+{
+	struct pcap_replay_conf *conf = extra_args;
+	char *end;
+
+	if (value == NULL)
+		return -1;
+	conf->loops = strtoull(value, &end, 10);
+	if (*end != '\0')
+		return -1;
+	conf->preload = 1;
+	return 0;
+}
+
+/*
+ * Paces the replay either by the capture timestamps or at a packet rate
+ */
+static int
+set_pace(const char *key __rte_unused, const char *value, void *extra_args)
+{
+	struct pcap_replay_conf *conf = extra_args;
+	char *end;
+
+	if (value == NULL)
+		return -1;
+	if (strcmp(value, ETH_PCAP_PACE_TS) == 0) {
+		conf->pace_ts = 1;
+	} else {
+		conf->rate = strtoull(value, &end, 10);
+		if (*end != '\0' || conf->rate == 0)
+			return -1;
+	}
+	conf->preload = 1;
+	return 0;
+}
+
 static struct rte_vdev_driver pmd_pcap_drv;
 
 static int
@@ -857,6 +1299,7 @@ static int
 eth_from_pcaps_common(const char *name, struct pmd_devargs *rx_queues,
 		const unsigned int nb_rx_queues, struct pmd_devargs *tx_queues,
 		const unsigned int nb_tx_queues, struct rte_kvargs *kvlist,
+		const struct pcap_replay_conf *replay,
 		struct pmd_internals **internals, struct rte_eth_dev **eth_dev)
 {
 	struct rte_kvargs_pair *pair = NULL;
@@ -878,6 +1321,7 @@ eth_from_pcaps_common(const char *name, struct pmd_devargs *rx_queues,
 		struct devargs_queue *queue = &rx_queues->queue[i];
 
 		rx->pcap = queue->pcap;
+		rx->replay.conf = *replay;
 		snprintf(rx->name, sizeof(rx->name), "%s", queue->name);
 		snprintf(rx->type, sizeof(rx->type), "%s", queue->type);
 	}
@@ -887,6 +1331,7 @@ eth_from_pcaps_common(const char *name, struct pmd_devargs *rx_queues,
 		struct devargs_queue *queue = &tx_queues->queue[i];
 
 		tx->dumper = queue->dumper;
+		tx->dumper_buf = queue->dumper_buf;
 		tx->pcap = queue->pcap;
 		snprintf(tx->name, sizeof(tx->name), "%s", queue->name);
 		snprintf(tx->type, sizeof(tx->type), "%s", queue->type);
@@ -910,14 +1355,15 @@ static int
 eth_from_pcaps(const char *name, struct pmd_devargs *rx_queues,
 		const unsigned int nb_rx_queues, struct pmd_devargs *tx_queues,
 		const unsigned int nb_tx_queues, struct rte_kvargs *kvlist,
-		int single_iface, unsigned int using_dumpers)
+		const struct pcap_replay_conf *replay, int single_iface,
+		unsigned int using_dumpers)
 {
 	struct pmd_internals *internals = NULL;
 	struct rte_eth_dev *eth_dev = NULL;
 	int ret;
 
 	ret = eth_from_pcaps_common(name, rx_queues, nb_rx_queues,
-		tx_queues, nb_tx_queues, kvlist, &internals, &eth_dev);
+		tx_queues, nb_tx_queues, kvlist, replay, &internals, &eth_dev);
 
 	if (ret < 0)
 		return ret;
@@ -925,7 +1371,10 @@ eth_from_pcaps(const char *name, struct pmd_devargs *rx_queues,
 	/* store weather we are using a single interface for rx/tx or not */
 	internals->single_iface = single_iface;
 
-	eth_dev->rx_pkt_burst = eth_pcap_rx;
+	if (replay->preload)
+		eth_dev->rx_pkt_burst = eth_pcap_rx_replay;
+	else
+		eth_dev->rx_pkt_burst = eth_pcap_rx;
 
 	if (using_dumpers)
 		eth_dev->tx_pkt_burst = eth_pcap_tx_dumper;
@@ -942,12 +1391,13 @@ pmd_pcap_probe(const char *name, const char *params)
 	struct rte_kvargs *kvlist;
 	struct pmd_devargs pcaps = {0};
 	struct pmd_devargs dumpers = {0};
+	struct pcap_replay_conf replay = { .loops = 1 };
 	int single_iface = 0;
 	int ret;
 
 	RTE_LOG(INFO, PMD, "Initializing pmd_pcap for %s\n", name);
 
-	gettimeofday(&start_time, NULL);
+	clock_gettime(CLOCK_REALTIME, &start_time);
 	start_cycles = rte_get_timer_cycles();
 	hz = rte_get_timer_hz();
 
@@ -1000,6 +1450,26 @@ pmd_pcap_probe(const char *name, const char *params)
 	if (ret < 0)
 		goto free_kvlist;
 
+	/* Replay options only apply to pcap files */
+	ret = rte_kvargs_process(kvlist, ETH_PCAP_PRELOAD_ARG,
+			&set_preload, &replay);
+	if (ret == 0)
+		ret = rte_kvargs_process(kvlist, ETH_PCAP_LOOP_ARG,
+				&set_loop, &replay);
+	if (ret == 0)
+		ret = rte_kvargs_process(kvlist, ETH_PCAP_PACE_ARG,
+				&set_pace, &replay);
+	if (ret < 0) {
+		RTE_LOG(ERR, PMD, "%s: invalid replay arguments\n", name);
+		goto free_kvlist;
+	}
+	if (replay.preload && !is_rx_pcap) {
+		RTE_LOG(ERR, PMD, "%s: replay options need an %s stream\n",
+			name, ETH_PCAP_RX_PCAP_ARG);
+		ret = -1;
+		goto free_kvlist;
+	}
+
 	/*
 	 * We check whether we want to open a TX stream to a real NIC or a
 	 * pcap file
@@ -1026,7 +1496,8 @@ pmd_pcap_probe(const char *name, const char *params)
 
 create_eth:
 	ret = eth_from_pcaps(name, &pcaps, pcaps.num_of_queue, &dumpers,
-		dumpers.num_of_queue, kvlist, single_iface, is_tx_pcap);
+		dumpers.num_of_queue, kvlist, &replay, single_iface,
+		is_tx_pcap);
 
 free_kvlist:
 	rte_kvargs_free(kvlist);
@@ -1050,6 +1521,7 @@ pmd_pcap_remove(const char *name)
 	if (eth_dev == NULL)
 		return -1;
 
+	eth_dev_close(eth_dev);
 	rte_free(eth_dev->data->dev_private);
 	rte_free(eth_dev->data);
 
@@ -1070,4 +1542,7 @@ RTE_PMD_REGISTER_PARAM_STRING(net_pcap,
 	ETH_PCAP_TX_PCAP_ARG "=<string> "
 	ETH_PCAP_RX_IFACE_ARG "=<ifc> "
 	ETH_PCAP_TX_IFACE_ARG "=<ifc> "
-	ETH_PCAP_IFACE_ARG "=<ifc>");
+	ETH_PCAP_IFACE_ARG "=<ifc> "
+	ETH_PCAP_PRELOAD_ARG "=<0|1> "
+	ETH_PCAP_LOOP_ARG "=<int> "
+	ETH_PCAP_PACE_ARG "=<ts|pps>");
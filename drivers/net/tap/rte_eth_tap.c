@@ -36,18 +36,24 @@
 #include <rte_malloc.h>
 #include <rte_vdev.h>
 #include <rte_kvargs.h>
+#include <rte_ip.h>
+#include <rte_tcp.h>
+#include <rte_udp.h>
+#include <rte_net.h>
 
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
+#include <sys/uio.h>
+#include <errno.h>
 #include <unistd.h>
-#include <poll.h>
 #include <arpa/inet.h>
 #include <linux/if.h>
 #include <linux/if_tun.h>
 #include <linux/if_ether.h>
+#include <linux/virtio_net.h>
 #include <fcntl.h>
 
 /* Linux based path to the TUN device */
@@ -59,6 +65,9 @@
 
 #define RTE_PMD_TAP_MAX_QUEUES	16
 
+/* Largest frame the kernel hands over once TSO offloads are negotiated */
+#define TAP_GSO_MAX_FRAME_LEN	(65535 + ETHER_HDR_LEN + 4)
+
 static struct rte_vdev_driver pmd_tap_drv;
 
 static const char *valid_arguments[] = {
@@ -82,6 +91,7 @@ struct pkt_stats {
 	uint64_t obytes;		/* Number of bytes on output */
 	uint64_t ibytes;		/* Number of bytes on input */
 	uint64_t errs;			/* Number of error packets */
+	uint64_t rx_nombuf;		/* Number of mbuf allocation failures */
 };
 
 struct rx_queue {
@@ -89,6 +99,12 @@ struct rx_queue {
 	uint16_t in_port;		/* Port ID */
 	int fd;
 
+	uint16_t nb_segs;		/* Max segments of a received frame */
+	uint16_t seg_len;		/* Data room of each segment */
+	struct virtio_net_hdr hdr;	/* vnet header of the last frame */
+	struct rte_mbuf **bufs;		/* mbufs posted to the next readv() */
+	struct iovec *iovecs;		/* vnet header + one entry per mbuf */
+
 	struct pkt_stats stats;		/* Stats for this RX queue */
 };
 
@@ -123,7 +139,7 @@ tun_alloc(char *name)
 
 	memset(&ifr, 0, sizeof(struct ifreq));
 
-	ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
+	ifr.ifr_flags = IFF_TAP | IFF_NO_PI | IFF_VNET_HDR;
 	if (name && name[0])
 		strncpy(ifr.ifr_name, name, IFNAMSIZ);
 
@@ -140,6 +156,11 @@ tun_alloc(char *name)
 	}
 	RTE_LOG(DEBUG, PMD, "TUN/TAP Features %08x\n", features);
 
+	if (!(features & IFF_VNET_HDR)) {
+		RTE_LOG(ERR, PMD, "TUN/TAP device has no vnet header support\n");
+		goto error;
+	}
+
 	if (!(features & IFF_MULTI_QUEUE) && (RTE_PMD_TAP_MAX_QUEUES > 1)) {
 		RTE_LOG(DEBUG, PMD, "TUN/TAP device only one queue\n");
 		goto error;
@@ -180,37 +201,139 @@ tun_alloc(char *name)
 	return -1;
 }
 
+/* Translate the vnet header the kernel prepended to a received frame into
+ * mbuf offload flags.
+ */
+static int
+tap_rx_offload(struct rte_mbuf *m, struct virtio_net_hdr *hdr)
+{
+	struct rte_net_hdr_lens hdr_lens;
+	uint32_t hdrlen, ptype;
+	int l4_supported = 0;
+
+	/* nothing to do */
+	if (hdr->flags == 0 && hdr->gso_type == VIRTIO_NET_HDR_GSO_NONE)
+		return 0;
+
+	m->ol_flags |= PKT_RX_IP_CKSUM_UNKNOWN;
+
+	ptype = rte_net_get_ptype(m, &hdr_lens, RTE_PTYPE_ALL_MASK);
+	m->packet_type = ptype;
+	if ((ptype & RTE_PTYPE_L4_MASK) == RTE_PTYPE_L4_TCP ||
+	    (ptype & RTE_PTYPE_L4_MASK) == RTE_PTYPE_L4_UDP ||
+	    (ptype & RTE_PTYPE_L4_MASK) == RTE_PTYPE_L4_SCTP)
+		l4_supported = 1;
+
+	if (hdr->flags & VIRTIO_NET_HDR_F_NEEDS_CSUM) {
+		hdrlen = hdr_lens.l2_len + hdr_lens.l3_len + hdr_lens.l4_len;
+		if (hdr->csum_start <= hdrlen && l4_supported) {
+			m->ol_flags |= PKT_RX_L4_CKSUM_NONE;
+		} else {
+			/* Unknown protocol or tunnel, complete the checksum
+			 * in software.
+			 */
+			uint16_t csum, off;
+
+			rte_raw_cksum_mbuf(m, hdr->csum_start,
+				rte_pktmbuf_pkt_len(m) - hdr->csum_start,
+				&csum);
+			if (likely(csum != 0xffff))
+				csum = ~csum;
+			off = hdr->csum_offset + hdr->csum_start;
+			if (rte_pktmbuf_data_len(m) >= off + 1)
+				*rte_pktmbuf_mtod_offset(m, uint16_t *,
+					off) = csum;
+		}
+	} else if (hdr->flags & VIRTIO_NET_HDR_F_DATA_VALID && l4_supported) {
+		m->ol_flags |= PKT_RX_L4_CKSUM_GOOD;
+	}
+
+	/* GSO frame coalesced by the kernel, keep the segment size */
+	if (hdr->gso_type != VIRTIO_NET_HDR_GSO_NONE) {
+		if ((hdr->gso_type & VIRTIO_NET_HDR_GSO_ECN) ||
+		    (hdr->gso_size == 0))
+			return -EINVAL;
+
+		m->tso_segsz = hdr->gso_size;
+		switch (hdr->gso_type) {
+		case VIRTIO_NET_HDR_GSO_TCPV4:
+		case VIRTIO_NET_HDR_GSO_TCPV6:
+			m->ol_flags |= PKT_RX_LRO | PKT_RX_L4_CKSUM_NONE;
+			break;
+		default:
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
 /* Callback to handle the rx burst of packets to the correct interface and
  * file descriptor(s) in a multi-queue setup.
+ *
+ * Each frame is read with a single readv() straight into the mbufs posted
+ * on the queue, which are only replaced once a frame has landed in them.
  */
 static uint16_t
 pmd_rx_burst(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 {
-	int len;
-	struct rte_mbuf *mbuf;
 	struct rx_queue *rxq = queue;
-	uint16_t num_rx;
+	struct rte_mbuf *fresh[rxq->nb_segs];
+	struct rte_mbuf *mbuf, *seg;
+	uint16_t num_rx, nb_segs, i;
 	unsigned long num_rx_bytes = 0;
+	uint32_t remain;
+	int len;
 
 	for (num_rx = 0; num_rx < nb_pkts; ) {
-		/* allocate the next mbuf */
-		mbuf = rte_pktmbuf_alloc(rxq->mp);
-		if (unlikely(!mbuf)) {
-			RTE_LOG(WARNING, PMD, "Unable to allocate mbuf\n");
+		len = readv(rxq->fd, rxq->iovecs, rxq->nb_segs + 1);
+		if (len < (int)sizeof(struct virtio_net_hdr))
 			break;
+		len -= sizeof(struct virtio_net_hdr);
+
+		/* The kernel returns the full length of a frame truncated
+		 * to the posted buffers, drop it.
+		 */
+		if (unlikely((uint32_t)len >
+			     (uint32_t)rxq->nb_segs * rxq->seg_len)) {
+			rxq->stats.errs++;
+			continue;
 		}
 
-		len = read(rxq->fd, rte_pktmbuf_mtod(mbuf, char *),
-			   rte_pktmbuf_tailroom(mbuf));
-		if (len <= 0) {
-			rte_pktmbuf_free(mbuf);
+		nb_segs = (len == 0) ? 1 :
+			(len + rxq->seg_len - 1) / rxq->seg_len;
+
+		/* Replace the buffers the frame was read into, dropping it
+		 * and keeping them posted if the pool has run dry.
+		 */
+		if (unlikely(rte_pktmbuf_alloc_bulk(rxq->mp, fresh,
+						    nb_segs) != 0)) {
+			rxq->stats.rx_nombuf++;
 			break;
 		}
 
-		mbuf->data_len = len;
+		mbuf = rxq->bufs[0];
+		remain = len;
+		for (i = 0; i < nb_segs; i++) {
+			seg = rxq->bufs[i];
+			seg->data_len = RTE_MIN(remain, rxq->seg_len);
+			remain -= seg->data_len;
+			seg->next = (i + 1 < nb_segs) ? rxq->bufs[i + 1] : NULL;
+
+			rxq->bufs[i] = fresh[i];
+			rxq->iovecs[i + 1].iov_base =
+				rte_pktmbuf_mtod(fresh[i], void *);
+		}
+		mbuf->nb_segs = nb_segs;
 		mbuf->pkt_len = len;
 		mbuf->port = rxq->in_port;
 
+		if (unlikely(tap_rx_offload(mbuf, &rxq->hdr) < 0)) {
+			rte_pktmbuf_free(mbuf);
+			rxq->stats.errs++;
+			continue;
+		}
+
 		/* account for the receive frame */
 		bufs[num_rx++] = mbuf;
 		num_rx_bytes += mbuf->pkt_len;
@@ -221,44 +344,136 @@ pmd_rx_burst(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 	return num_rx;
 }
 
+/* When doing TSO, the IP length is not included in the pseudo header
+ * checksum of the packet given to the PMD, but the kernel expects it.
+ */
+static void
+tap_tso_fix_cksum(struct rte_mbuf *m)
+{
+	struct ipv4_hdr *iph;
+	struct ipv6_hdr *ip6h;
+	struct tcp_hdr *th;
+	uint16_t ip_paylen;
+	uint32_t tmp;
+
+	/* the headers must be contiguous for the kernel anyway */
+	if (unlikely(rte_pktmbuf_data_len(m) <
+		     m->l2_len + m->l3_len + m->l4_len))
+		return;
+
+	iph = rte_pktmbuf_mtod_offset(m, struct ipv4_hdr *, m->l2_len);
+	th = RTE_PTR_ADD(iph, m->l3_len);
+	if ((iph->version_ihl >> 4) == 4) {
+		iph->hdr_checksum = 0;
+		iph->hdr_checksum = rte_ipv4_cksum(iph);
+		ip_paylen = rte_cpu_to_be_16(
+			rte_be_to_cpu_16(iph->total_length) - m->l3_len);
+	} else {
+		ip6h = (struct ipv6_hdr *)iph;
+		ip_paylen = ip6h->payload_len;
+	}
+
+	tmp = th->cksum;
+	tmp += ip_paylen;
+	tmp = (tmp & 0xffff) + (tmp >> 16);
+	th->cksum = tmp;
+}
+
+/* Fill the vnet header from the mbuf offload flags. The IPv4 header
+ * checksum has no vnet header equivalent and is computed here.
+ */
+static void
+tap_tx_offload(struct virtio_net_hdr *hdr, struct rte_mbuf *m)
+{
+	struct ipv4_hdr *iph;
+
+	if ((m->ol_flags & PKT_TX_IP_CKSUM) &&
+	    !(m->ol_flags & PKT_TX_TCP_SEG)) {
+		iph = rte_pktmbuf_mtod_offset(m, struct ipv4_hdr *, m->l2_len);
+		iph->hdr_checksum = 0;
+		iph->hdr_checksum = rte_ipv4_cksum(iph);
+	}
+
+	if (m->ol_flags & PKT_TX_TCP_SEG)
+		m->ol_flags |= PKT_TX_TCP_CKSUM;
+
+	switch (m->ol_flags & PKT_TX_L4_MASK) {
+	case PKT_TX_UDP_CKSUM:
+		hdr->csum_start = m->l2_len + m->l3_len;
+		hdr->csum_offset = offsetof(struct udp_hdr, dgram_cksum);
+		hdr->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+		break;
+	case PKT_TX_TCP_CKSUM:
+		hdr->csum_start = m->l2_len + m->l3_len;
+		hdr->csum_offset = offsetof(struct tcp_hdr, cksum);
+		hdr->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+		break;
+	default:
+		break;
+	}
+
+	/* TCP Segmentation Offload */
+	if (m->ol_flags & PKT_TX_TCP_SEG) {
+		tap_tso_fix_cksum(m);
+		hdr->gso_type = (m->ol_flags & PKT_TX_IPV6) ?
+			VIRTIO_NET_HDR_GSO_TCPV6 :
+			VIRTIO_NET_HDR_GSO_TCPV4;
+		hdr->gso_size = m->tso_segsz;
+		hdr->hdr_len = m->l2_len + m->l3_len + m->l4_len;
+	}
+}
+
 /* Callback to handle sending packets from the tap interface
+ *
+ * Every packet goes out in a single writev() carrying its vnet header and
+ * all of its segments. A full kernel queue ends the burst.
  */
 static uint16_t
 pmd_tx_burst(void *queue, struct rte_mbuf **bufs, uint16_t nb_pkts)
 {
-	struct rte_mbuf *mbuf;
+	struct rte_mbuf *mbuf, *seg;
 	struct tx_queue *txq = queue;
-	struct pollfd pfd;
+	struct virtio_net_hdr hdr;
 	uint16_t num_tx = 0;
 	unsigned long num_tx_bytes = 0;
-	int i, n;
+	int i, j, n;
 
 	if (unlikely(nb_pkts == 0))
 		return 0;
 
-	pfd.events = POLLOUT;
-	pfd.fd = txq->fd;
 	for (i = 0; i < nb_pkts; i++) {
-		n = poll(&pfd, 1, 0);
-
-		if (n <= 0)
-			break;
+		struct iovec iovecs[bufs[i]->nb_segs + 1];
+
+		mbuf = bufs[i];
+		memset(&hdr, 0, sizeof(hdr));
+		if (mbuf->ol_flags & (PKT_TX_IP_CKSUM | PKT_TX_L4_MASK |
+				      PKT_TX_TCP_SEG))
+			tap_tx_offload(&hdr, mbuf);
+
+		iovecs[0].iov_base = &hdr;
+		iovecs[0].iov_len = sizeof(hdr);
+		for (j = 1, seg = mbuf; seg; seg = seg->next, j++) {
+			iovecs[j].iov_base = rte_pktmbuf_mtod(seg, void *);
+			iovecs[j].iov_len = rte_pktmbuf_data_len(seg);
+		}
 
-		if (pfd.revents & POLLOUT) {
-			/* copy the tx frame data */
-			mbuf = bufs[num_tx];
-			n = write(pfd.fd, rte_pktmbuf_mtod(mbuf, void*),
-				  rte_pktmbuf_pkt_len(mbuf));
-			if (n <= 0)
+		n = writev(txq->fd, iovecs, j);
+		if (n <= 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
 				break;
-
-			num_tx++;
-			num_tx_bytes += mbuf->pkt_len;
+			/* the kernel refused the frame, drop it */
+			txq->stats.errs++;
 			rte_pktmbuf_free(mbuf);
+			num_tx++;
+			continue;
 		}
+
+		txq->stats.opackets++;
+		num_tx++;
+		num_tx_bytes += mbuf->pkt_len;
+		rte_pktmbuf_free(mbuf);
 	}
 
-	txq->stats.opackets += num_tx;
 	txq->stats.errs += nb_pkts - num_tx;
 	txq->stats.obytes += num_tx_bytes;
 
@@ -274,24 +489,36 @@ tap_dev_start(struct rte_eth_dev *dev)
 	return 0;
 }
 
-/* This function gets called when the current port gets stopped.
+/* This function gets called when the current port gets stopped. The queue
+ * fds stay open so the port can be started again, they are closed on remove.
  */
 static void
 tap_dev_stop(struct rte_eth_dev *dev)
 {
-	int i;
-	struct pmd_internals *internals = dev->data->dev_private;
-
-	for (i = 0; i < internals->nb_queues; i++)
-		if (internals->fds[i] != -1)
-			close(internals->fds[i]);
-
 	dev->data->dev_link.link_status = ETH_LINK_DOWN;
 }
 
+/* Negotiate which offloads the kernel may leave to us on receive. The
+ * setting belongs to the device, so any queue fd will do.
+ */
 static int
-tap_dev_configure(struct rte_eth_dev *dev __rte_unused)
+tap_dev_configure(struct rte_eth_dev *dev)
 {
+	struct pmd_internals *internals = dev->data->dev_private;
+	const struct rte_eth_rxmode *rxmode = &dev->data->dev_conf.rxmode;
+	unsigned int offload = 0;
+
+	if (rxmode->hw_ip_checksum)
+		offload |= TUN_F_CSUM;
+	if (rxmode->enable_lro)
+		offload |= TUN_F_CSUM | TUN_F_TSO4 | TUN_F_TSO6;
+
+	if (ioctl(internals->fds[0], TUNSETOFFLOAD, offload) < 0) {
+		RTE_LOG(ERR, PMD, "%s: Unable to set TUN offloads %x (%s)\n",
+			dev->data->name, offload, strerror(errno));
+		return -1;
+	}
+
 	return 0;
 }
 
@@ -307,6 +534,13 @@ tap_dev_info(struct rte_eth_dev *dev, struct rte_eth_dev_info *dev_info)
 	dev_info->max_tx_queues = internals->nb_queues;
 	dev_info->min_rx_bufsize = 0;
 	dev_info->pci_dev = NULL;
+	dev_info->rx_offload_capa = DEV_RX_OFFLOAD_UDP_CKSUM |
+		DEV_RX_OFFLOAD_TCP_CKSUM |
+		DEV_RX_OFFLOAD_TCP_LRO;
+	dev_info->tx_offload_capa = DEV_TX_OFFLOAD_IPV4_CKSUM |
+		DEV_TX_OFFLOAD_UDP_CKSUM |
+		DEV_TX_OFFLOAD_TCP_CKSUM |
+		DEV_TX_OFFLOAD_TCP_TSO;
 }
 
 static void
@@ -314,6 +548,7 @@ tap_stats_get(struct rte_eth_dev *dev, struct rte_eth_stats *tap_stats)
 {
 	unsigned int i, imax;
 	unsigned long rx_total = 0, tx_total = 0, tx_err_total = 0;
+	unsigned long rx_err_total = 0, rx_nombuf = 0;
 	unsigned long rx_bytes_total = 0, tx_bytes_total = 0;
 	const struct pmd_internals *pmd = dev->data->dev_private;
 
@@ -325,6 +560,8 @@ tap_stats_get(struct rte_eth_dev *dev, struct rte_eth_stats *tap_stats)
 		tap_stats->q_ibytes[i] = pmd->rxq[i].stats.ibytes;
 		rx_total += tap_stats->q_ipackets[i];
 		rx_bytes_total += tap_stats->q_ibytes[i];
+		rx_err_total += pmd->rxq[i].stats.errs;
+		rx_nombuf += pmd->rxq[i].stats.rx_nombuf;
 	}
 
 	for (i = 0; i < imax; i++) {
@@ -338,6 +575,8 @@ tap_stats_get(struct rte_eth_dev *dev, struct rte_eth_stats *tap_stats)
 
 	tap_stats->ipackets = rx_total;
 	tap_stats->ibytes = rx_bytes_total;
+	tap_stats->ierrors = rx_err_total;
+	tap_stats->rx_nombuf = rx_nombuf;
 	tap_stats->opackets = tx_total;
 	tap_stats->oerrors = tx_err_total;
 	tap_stats->obytes = tx_bytes_total;
@@ -352,6 +591,8 @@ tap_stats_reset(struct rte_eth_dev *dev)
 	for (i = 0; i < pmd->nb_queues; i++) {
 		pmd->rxq[i].stats.ipackets = 0;
 		pmd->rxq[i].stats.ibytes = 0;
+		pmd->rxq[i].stats.errs = 0;
+		pmd->rxq[i].stats.rx_nombuf = 0;
 	}
 
 	for (i = 0; i < pmd->nb_queues; i++) {
@@ -366,26 +607,50 @@ tap_dev_close(struct rte_eth_dev *dev __rte_unused)
 {
 }
 
+static void
+tap_rx_queue_free_bufs(struct rx_queue *rxq)
+{
+	uint16_t i;
+
+	if (rxq->bufs) {
+		for (i = 0; i < rxq->nb_segs; i++)
+			rte_pktmbuf_free(rxq->bufs[i]);
+	}
+	rte_free(rxq->bufs);
+	rte_free(rxq->iovecs);
+	rxq->bufs = NULL;
+	rxq->iovecs = NULL;
+	rxq->nb_segs = 0;
+}
+
 static void
 tap_rx_queue_release(void *queue)
 {
 	struct rx_queue *rxq = queue;
 
-	if (rxq && (rxq->fd > 0)) {
-		close(rxq->fd);
-		rxq->fd = -1;
-	}
+	if (!rxq)
+		return;
+
+	tap_rx_queue_free_bufs(rxq);
 }
 
+/* The queue fd is shared by the RX and TX queue of the same index and is
+ * only closed when the device is removed, as the kernel interface goes
+ * away with its last fd.
+ */
 static void
-tap_tx_queue_release(void *queue)
+tap_tx_queue_release(void *queue __rte_unused)
 {
-	struct tx_queue *txq = queue;
+}
 
-	if (txq && (txq->fd > 0)) {
-		close(txq->fd);
-		txq->fd = -1;
-	}
+static int
+tap_rx_queue_fd_get(struct rte_eth_dev *dev, uint16_t rx_queue_id)
+{
+	struct pmd_internals *internals = dev->data->dev_private;
+
+	if (internals->rxq[rx_queue_id].fd < 0)
+		return -EINVAL;
+	return internals->rxq[rx_queue_id].fd;
 }
 
 static int
@@ -423,6 +688,7 @@ tap_setup_queue(struct rte_eth_dev *dev,
 
 	rx->fd = fd;
 	tx->fd = fd;
+	internals->fds[qid] = fd;
 
 	return fd;
 }
@@ -431,12 +697,15 @@ static int
 tap_rx_queue_setup(struct rte_eth_dev *dev,
 		   uint16_t rx_queue_id,
 		   uint16_t nb_rx_desc __rte_unused,
-		   unsigned int socket_id __rte_unused,
+		   unsigned int socket_id,
 		   const struct rte_eth_rxconf *rx_conf __rte_unused,
 		   struct rte_mempool *mp)
 {
 	struct pmd_internals *internals = dev->data->dev_private;
-	uint16_t buf_size;
+	const struct rte_eth_rxmode *rxmode = &dev->data->dev_conf.rxmode;
+	struct rx_queue *rxq;
+	uint32_t max_len;
+	uint16_t buf_size, i;
 	int fd;
 
 	if ((rx_queue_id >= internals->nb_queues) || !mp) {
@@ -445,25 +714,60 @@ tap_rx_queue_setup(struct rte_eth_dev *dev,
 		return -1;
 	}
 
-	internals->rxq[rx_queue_id].mp = mp;
-	internals->rxq[rx_queue_id].in_port = dev->data->port_id;
+	rxq = &internals->rxq[rx_queue_id];
+	rxq->mp = mp;
+	rxq->in_port = dev->data->port_id;
 
-	/* Now get the space available for data in the mbuf */
+	/* Now get the space available for data in the mbuf, frames larger
+	 * than that are read into a chain of mbufs.
+	 */
 	buf_size = (uint16_t)(rte_pktmbuf_data_room_size(mp) -
 				RTE_PKTMBUF_HEADROOM);
+	if (buf_size == 0) {
+		RTE_LOG(ERR, PMD, "%s: mbufs have no data room\n",
+			dev->data->name);
+		return -ENOMEM;
+	}
 
-	if (buf_size < ETH_FRAME_LEN) {
-		RTE_LOG(ERR, PMD,
-			"%s: %d bytes will not fit in mbuf (%d bytes)\n",
-			dev->data->name, ETH_FRAME_LEN, buf_size);
+	if (rxmode->enable_lro)
+		max_len = TAP_GSO_MAX_FRAME_LEN;
+	else if (rxmode->jumbo_frame)
+		max_len = rxmode->max_rx_pkt_len;
+	else
+		max_len = ETHER_MAX_VLAN_FRAME_LEN;
+
+	tap_rx_queue_free_bufs(rxq);
+	rxq->seg_len = buf_size;
+	rxq->nb_segs = (max_len + buf_size - 1) / buf_size;
+	rxq->bufs = rte_zmalloc_socket(dev->data->name,
+				       rxq->nb_segs * sizeof(*rxq->bufs),
+				       0, socket_id);
+	rxq->iovecs = rte_zmalloc_socket(dev->data->name,
+					 (rxq->nb_segs + 1) *
+					 sizeof(*rxq->iovecs),
+					 0, socket_id);
+	if (!rxq->bufs || !rxq->iovecs ||
+	    rte_pktmbuf_alloc_bulk(mp, rxq->bufs, rxq->nb_segs) != 0) {
+		RTE_LOG(ERR, PMD, "%s: Unable to allocate %u RX buffers\n",
+			dev->data->name, rxq->nb_segs);
+		tap_rx_queue_free_bufs(rxq);
 		return -ENOMEM;
 	}
 
+	rxq->iovecs[0].iov_base = &rxq->hdr;
+	rxq->iovecs[0].iov_len = sizeof(rxq->hdr);
+	for (i = 0; i < rxq->nb_segs; i++) {
+		rxq->iovecs[i + 1].iov_base =
+			rte_pktmbuf_mtod(rxq->bufs[i], void *);
+		rxq->iovecs[i + 1].iov_len = buf_size;
+	}
+
 	fd = tap_setup_queue(dev, internals, rx_queue_id);
-	if (fd == -1)
+	if (fd == -1) {
+		tap_rx_queue_free_bufs(rxq);
 		return -1;
+	}
 
-	internals->fds[rx_queue_id] = fd;
 	RTE_LOG(INFO, PMD, "RX TAP device name %s, qid %d on fd %d\n",
 		dev->data->name, rx_queue_id, internals->rxq[rx_queue_id].fd);
 
@@ -503,6 +807,7 @@ static const struct eth_dev_ops ops = {
 	.tx_queue_setup         = tap_tx_queue_setup,
 	.rx_queue_release       = tap_rx_queue_release,
 	.tx_queue_release       = tap_tx_queue_release,
+	.rx_queue_fd_get        = tap_rx_queue_fd_get,
 	.link_update            = tap_link_update,
 	.stats_get              = tap_stats_get,
 	.stats_reset            = tap_stats_reset,
@@ -744,9 +1049,11 @@ rte_pmd_tap_remove(const char *name)
 		return 0;
 
 	internals = eth_dev->data->dev_private;
-	for (i = 0; i < internals->nb_queues; i++)
+	for (i = 0; i < internals->nb_queues; i++) {
+		tap_rx_queue_free_bufs(&internals->rxq[i]);
 		if (internals->fds[i] != -1)
 			close(internals->fds[i]);
+	}
 
 	rte_free(eth_dev->data->dev_private);
 	rte_free(eth_dev->data);
@@ -44,6 +44,8 @@
 #include <rte_vdev.h>
 #include <rte_kvargs.h>
 #include <rte_virtio_net.h>
+#include <rte_vhost_async.h>
+#include <rte_service.h>
 #include <rte_spinlock.h>
 
 #include "rte_eth_vhost.h"
@@ -52,12 +54,17 @@
 #define ETH_VHOST_QUEUES_ARG		"queues"
 #define ETH_VHOST_CLIENT_ARG		"client"
 #define ETH_VHOST_DEQUEUE_ZERO_COPY	"dequeue-zero-copy"
+#define ETH_VHOST_ASYNC_COPY		"async-copy"
+
+/* Completed asynchronous enqueues freed per TX burst */
+#define VHOST_ASYNC_POLL_BURST 64
 
 static const char *valid_arguments[] = {
 	ETH_VHOST_IFACE_ARG,
 	ETH_VHOST_QUEUES_ARG,
 	ETH_VHOST_CLIENT_ARG,
 	ETH_VHOST_DEQUEUE_ZERO_COPY,
+	ETH_VHOST_ASYNC_COPY,
 	NULL
 };
 
@@ -88,6 +95,9 @@ enum vhost_xstats_pkts {
 	VHOST_ERRORS_FRAGMENTED,
 	VHOST_ERRORS_JABBER,
 	VHOST_UNKNOWN_PROTOCOL,
+	VHOST_ZCOPY_PKT,
+	VHOST_ZCOPY_COPY_INFLIGHT_PKT,
+	VHOST_ZCOPY_COPY_RING_LOW_PKT,
 	VHOST_XSTATS_MAX,
 };
 
@@ -106,6 +116,13 @@ struct vhost_queue {
 	struct rte_mempool *mb_pool;
 	uint8_t port;
 	uint16_t virtqueue_id;
+	int async_copy;
+	/* Serializes the asynchronous enqueues with their completions */
+	rte_spinlock_t async_lock;
+	/* TX queue whose completions are also polled by this RX queue */
+	struct vhost_queue *async_txq;
+	/* Dequeue zero copy statistics of the library at the last reset */
+	struct rte_vhost_zcopy_stats zcopy_base;
 	struct vhost_stats stats;
 };
 
@@ -115,6 +132,7 @@ struct pmd_internal {
 	char *iface_name;
 	uint16_t max_queues;
 	rte_atomic32_t started;
+	int async_lcore;	/* service core of the copies, or -1 */
 };
 
 struct internal_list {
@@ -193,6 +211,14 @@ static const struct vhost_xstats_name_off vhost_rxport_stat_strings[] = {
 	 offsetof(struct vhost_queue, stats.xstats[VHOST_ERRORS_JABBER])},
 	{"unknown_protos_packets",
 	 offsetof(struct vhost_queue, stats.xstats[VHOST_UNKNOWN_PROTOCOL])},
+	{"zcopy_packets",
+	 offsetof(struct vhost_queue, stats.xstats[VHOST_ZCOPY_PKT])},
+	{"zcopy_copied_inflight_packets",
+	 offsetof(struct vhost_queue,
+		  stats.xstats[VHOST_ZCOPY_COPY_INFLIGHT_PKT])},
+	{"zcopy_copied_ring_low_packets",
+	 offsetof(struct vhost_queue,
+		  stats.xstats[VHOST_ZCOPY_COPY_RING_LOW_PKT])},
 };
 
 /* [tx]_ is prepended to the name string here */
@@ -235,6 +261,18 @@ static const struct vhost_xstats_name_off vhost_txport_stat_strings[] = {
 #define VHOST_NB_XSTATS_TXPORT (sizeof(vhost_txport_stat_strings) / \
 				sizeof(vhost_txport_stat_strings[0]))
 
+/* Dequeue zero copy statistics of the library, if a device is attached */
+static int
+vhost_get_zcopy_stats(struct vhost_queue *vq,
+		      struct rte_vhost_zcopy_stats *zs)
+{
+	if (vq->internal == NULL ||
+	    rte_atomic32_read(&vq->internal->dev_attached) == 0)
+		return -1;
+
+	return rte_vhost_get_zcopy_stats(vq->vid, vq->virtqueue_id, zs);
+}
+
 static void
 vhost_dev_xstats_reset(struct rte_eth_dev *dev)
 {
@@ -246,6 +284,8 @@ vhost_dev_xstats_reset(struct rte_eth_dev *dev)
 		if (!vq)
 			continue;
 		memset(&vq->stats, 0, sizeof(vq->stats));
+		if (vhost_get_zcopy_stats(vq, &vq->zcopy_base) < 0)
+			memset(&vq->zcopy_base, 0, sizeof(vq->zcopy_base));
 	}
 	for (i = 0; i < dev->data->nb_tx_queues; i++) {
 		vq = dev->data->tx_queues[i];
@@ -281,6 +321,22 @@ vhost_dev_xstats_get_names(struct rte_eth_dev *dev __rte_unused,
 	return count;
 }
 
+static void
+vhost_update_zcopy_xstats(struct vhost_queue *vq)
+{
+	struct rte_vhost_zcopy_stats zs;
+
+	if (vhost_get_zcopy_stats(vq, &zs) < 0)
+		return;
+
+	vq->stats.xstats[VHOST_ZCOPY_PKT] =
+		zs.zcopy_pkts - vq->zcopy_base.zcopy_pkts;
+	vq->stats.xstats[VHOST_ZCOPY_COPY_INFLIGHT_PKT] =
+		zs.copy_inflight_pkts - vq->zcopy_base.copy_inflight_pkts;
+	vq->stats.xstats[VHOST_ZCOPY_COPY_RING_LOW_PKT] =
+		zs.copy_ring_low_pkts - vq->zcopy_base.copy_ring_low_pkts;
+}
+
 static int
 vhost_dev_xstats_get(struct rte_eth_dev *dev, struct rte_eth_xstat *xstats,
 		     unsigned int n)
@@ -301,6 +357,7 @@ vhost_dev_xstats_get(struct rte_eth_dev *dev, struct rte_eth_xstat *xstats,
 		vq->stats.xstats[VHOST_UNICAST_PKT] = vq->stats.pkts
 				- (vq->stats.xstats[VHOST_BROADCAST_PKT]
 				+ vq->stats.xstats[VHOST_MULTICAST_PKT]);
+		vhost_update_zcopy_xstats(vq);
 	}
 	for (i = 0; i < dev->data->nb_tx_queues; i++) {
 		vq = dev->data->tx_queues[i];
@@ -386,6 +443,19 @@ vhost_update_packet_xstats(struct vhost_queue *vq,
 	}
 }
 
+/* Give back the completed asynchronous enqueues, and free their mbufs */
+static inline void
+vhost_async_tx_complete(struct vhost_queue *r)
+{
+	struct rte_mbuf *done[VHOST_ASYNC_POLL_BURST];
+	uint16_t i, nb_done;
+
+	nb_done = rte_vhost_poll_enqueue_completed(r->vid, r->virtqueue_id,
+			done, VHOST_ASYNC_POLL_BURST);
+	for (i = 0; likely(i < nb_done); i++)
+		rte_pktmbuf_free(done[i]);
+}
+
 static uint16_t
 eth_vhost_rx(void *q, struct rte_mbuf **bufs, uint16_t nb_bufs)
 {
@@ -401,8 +471,24 @@ eth_vhost_rx(void *q, struct rte_mbuf **bufs, uint16_t nb_bufs)
 		goto out;
 
 	/* Dequeue packets from guest TX queue */
-	nb_rx = rte_vhost_dequeue_burst(r->vid,
-			r->virtqueue_id, r->mb_pool, bufs, nb_bufs);
+	if (r->async_copy) {
+		nb_rx = rte_vhost_poll_dequeue_completed(r->vid,
+				r->virtqueue_id, bufs, nb_bufs);
+		rte_vhost_submit_dequeue_burst(r->vid, r->virtqueue_id,
+				r->mb_pool, nb_bufs);
+
+		/*
+		 * The guest gets its packets when the TX queue is polled
+		 * again, which might only happen once this queue receives.
+		 */
+		if (r->async_txq &&
+		    rte_spinlock_trylock(&r->async_txq->async_lock)) {
+			vhost_async_tx_complete(r->async_txq);
+			rte_spinlock_unlock(&r->async_txq->async_lock);
+		}
+	} else
+		nb_rx = rte_vhost_dequeue_burst(r->vid,
+				r->virtqueue_id, r->mb_pool, bufs, nb_bufs);
 
 	r->stats.pkts += nb_rx;
 
@@ -434,8 +520,16 @@ eth_vhost_tx(void *q, struct rte_mbuf **bufs, uint16_t nb_bufs)
 		goto out;
 
 	/* Enqueue packets to guest RX queue */
-	nb_tx = rte_vhost_enqueue_burst(r->vid,
-			r->virtqueue_id, bufs, nb_bufs);
+	if (r->async_copy) {
+		rte_spinlock_lock(&r->async_lock);
+		nb_tx = rte_vhost_submit_enqueue_burst(r->vid,
+				r->virtqueue_id, bufs, nb_bufs);
+		/* The submitted mbufs are freed once copied */
+		vhost_async_tx_complete(r);
+		rte_spinlock_unlock(&r->async_lock);
+	} else
+		nb_tx = rte_vhost_enqueue_burst(r->vid,
+				r->virtqueue_id, bufs, nb_bufs);
 
 	r->stats.pkts += nb_tx;
 	r->stats.missed_pkts += nb_bufs - nb_tx;
@@ -452,8 +546,10 @@ eth_vhost_tx(void *q, struct rte_mbuf **bufs, uint16_t nb_bufs)
 	for (i = nb_tx; i < nb_bufs; i++)
 		vhost_count_multicast_broadcast(r, bufs[i]);
 
-	for (i = 0; likely(i < nb_tx); i++)
-		rte_pktmbuf_free(bufs[i]);
+	if (!r->async_copy) {
+		for (i = 0; likely(i < nb_tx); i++)
+			rte_pktmbuf_free(bufs[i]);
+	}
 out:
 	rte_atomic32_set(&r->while_queuing, 0);
 
@@ -526,6 +622,47 @@ update_queuing_status(struct rte_eth_dev *dev)
 	}
 }
 
+/*
+ * Give the software copy engine to a queue, and run the copies on the
+ * service core of the port.
+ */
+static void
+vhost_async_setup(struct pmd_internal *internal, struct vhost_queue *vq)
+{
+	uint32_t id;
+	int ret;
+
+	vq->async_copy = 0;
+	if (internal->async_lcore < 0)
+		return;
+
+	ret = rte_vhost_async_sw_register(vq->vid, vq->virtqueue_id);
+	if (ret < 0) {
+		RTE_LOG(ERR, PMD, "Failed to set up async copies on vring %u: "
+			"%d\n", vq->virtqueue_id, ret);
+		return;
+	}
+
+	if (rte_service_get_by_name(RTE_VHOST_ASYNC_SW_SERVICE_NAME, &id) ||
+	    rte_service_map_lcore_set(id, internal->async_lcore, 1) ||
+	    rte_service_runstate_set(id, 1)) {
+		RTE_LOG(ERR, PMD, "Failed to map the %s service to lcore %d\n",
+			RTE_VHOST_ASYNC_SW_SERVICE_NAME, internal->async_lcore);
+		rte_vhost_async_channel_unregister(vq->vid, vq->virtqueue_id);
+		return;
+	}
+
+	ret = rte_service_lcore_start(internal->async_lcore);
+	if (ret < 0 && ret != -EALREADY) {
+		RTE_LOG(ERR, PMD, "Failed to start service lcore %d\n",
+			internal->async_lcore);
+		rte_vhost_async_channel_unregister(vq->vid, vq->virtqueue_id);
+		return;
+	}
+
+	vq->async_copy = 1;
+}
+
 static int
 new_device(int vid)
 {
@@ -562,6 +699,10 @@ new_device(int vid)
 		vq->vid = vid;
 		vq->internal = internal;
 		vq->port = eth_dev->data->port_id;
+		memset(&vq->zcopy_base, 0, sizeof(vq->zcopy_base));
+		vhost_async_setup(internal, vq);
+		/* the kick fd is new after a reconnection */
+		_rte_eth_rx_wait_fd_changed(vq->port, i);
 	}
 	for (i = 0; i < eth_dev->data->nb_tx_queues; i++) {
 		vq = eth_dev->data->tx_queues[i];
@@ -570,6 +711,18 @@ new_device(int vid)
 		vq->vid = vid;
 		vq->internal = internal;
 		vq->port = eth_dev->data->port_id;
+		vhost_async_setup(internal, vq);
+	}
+	for (i = 0; i < eth_dev->data->nb_rx_queues; i++) {
+		vq = eth_dev->data->rx_queues[i];
+		if (vq == NULL)
+			continue;
+		vq->async_txq = NULL;
+		if (vq->async_copy && i < eth_dev->data->nb_tx_queues &&
+		    eth_dev->data->tx_queues[i] != NULL &&
+		    ((struct vhost_queue *)
+		     eth_dev->data->tx_queues[i])->async_copy)
+			vq->async_txq = eth_dev->data->tx_queues[i];
 	}
 
 	for (i = 0; i < rte_vhost_get_queue_num(vid) * VIRTIO_QNUM; i++)
@@ -662,6 +815,11 @@ vring_state_changed(int vid, uint16_t vring, int enable)
 	state->max_vring = RTE_MAX(vring, state->max_vring);
 	rte_spinlock_unlock(&state->lock);
 
+	if (vring % VIRTIO_QNUM == VIRTIO_TXQ &&
+	    vring / VIRTIO_QNUM < eth_dev->data->nb_rx_queues)
+		_rte_eth_rx_wait_fd_changed(eth_dev->data->port_id,
+					    vring / VIRTIO_QNUM);
+
 	RTE_LOG(INFO, PMD, "vring%u is %s\n",
 			vring, enable ? "enabled" : "disabled");
 
@@ -940,6 +1098,60 @@ eth_link_update(struct rte_eth_dev *dev __rte_unused,
 	return 0;
 }
 
+static struct vhost_queue *
+eth_attached_rx_queue(struct rte_eth_dev *dev, uint16_t rx_queue_id)
+{
+	struct pmd_internal *internal = dev->data->dev_private;
+
+	if (rte_atomic32_read(&internal->dev_attached) == 0)
+		return NULL;
+	return dev->data->rx_queues[rx_queue_id];
+}
+
+static int
+eth_rx_queue_intr_enable(struct rte_eth_dev *dev, uint16_t rx_queue_id)
+{
+	struct vhost_queue *vq = eth_attached_rx_queue(dev, rx_queue_id);
+
+	if (vq == NULL)
+		return -ENODEV;
+	return rte_vhost_enable_guest_notification(vq->vid,
+			vq->virtqueue_id, 1);
+}
+
+static int
+eth_rx_queue_intr_disable(struct rte_eth_dev *dev, uint16_t rx_queue_id)
+{
+	struct vhost_queue *vq = eth_attached_rx_queue(dev, rx_queue_id);
+
+	if (vq == NULL)
+		return -ENODEV;
+	return rte_vhost_enable_guest_notification(vq->vid,
+			vq->virtqueue_id, 0);
+}
+
+static int
+eth_rx_queue_fd_get(struct rte_eth_dev *dev, uint16_t rx_queue_id)
+{
+	struct vhost_queue *vq = eth_attached_rx_queue(dev, rx_queue_id);
+	int fd;
+
+	if (vq == NULL)
+		return -ENODEV;
+	fd = rte_vhost_get_vring_kickfd(vq->vid, vq->virtqueue_id);
+	return fd < 0 ? -EINVAL : fd;
+}
+
+static uint32_t
+eth_rx_queue_count(struct rte_eth_dev *dev, uint16_t rx_queue_id)
+{
+	struct vhost_queue *vq = eth_attached_rx_queue(dev, rx_queue_id);
+
+	if (vq == NULL)
+		return 0;
+	return rte_vhost_avail_entries(vq->vid, vq->virtqueue_id);
+}
+
 /**
  * Disable features in feature_mask. Returns 0 on success.
  */
@@ -974,6 +1186,10 @@ static const struct eth_dev_ops ops = {
 	.tx_queue_setup = eth_tx_queue_setup,
 	.rx_queue_release = eth_queue_release,
 	.tx_queue_release = eth_queue_release,
+	.rx_queue_intr_enable = eth_rx_queue_intr_enable,
+	.rx_queue_intr_disable = eth_rx_queue_intr_disable,
+	.rx_queue_fd_get = eth_rx_queue_fd_get,
+	.rx_queue_count = eth_rx_queue_count,
 	.link_update = eth_link_update,
 	.stats_get = eth_stats_get,
 	.stats_reset = eth_stats_reset,
@@ -986,7 +1202,7 @@ static struct rte_vdev_driver pmd_vhost_drv;
 
 static int
 eth_dev_vhost_create(const char *name, char *iface_name, int16_t queues,
-		     const unsigned numa_node, uint64_t flags)
+		     const unsigned numa_node, uint64_t flags, int async_lcore)
 {
 	struct rte_eth_dev_data *data = NULL;
 	struct pmd_internal *internal = NULL;
@@ -1056,6 +1272,7 @@ eth_dev_vhost_create(const char *name, char *iface_name, int16_t queues,
 	data->nb_rx_queues = queues;
 	data->nb_tx_queues = queues;
 	internal->max_queues = queues;
+	internal->async_lcore = async_lcore;
 	data->dev_link = pmd_link;
 	data->mac_addrs = eth_addr;
 
@@ -1138,6 +1355,8 @@ rte_pmd_vhost_probe(const char *name, const char *params)
 	uint64_t flags = 0;
 	int client_mode = 0;
 	int dequeue_zero_copy = 0;
+	uint16_t async_lcore;
+	int async_copy = -1;
 
 	RTE_LOG(INFO, PMD, "Initializing pmd_vhost for %s\n", name);
 
@@ -1184,7 +1403,25 @@ rte_pmd_vhost_probe(const char *name, const char *params)
 			flags |= RTE_VHOST_USER_DEQUEUE_ZERO_COPY;
 	}
 
-	eth_dev_vhost_create(name, iface_name, queues, rte_socket_id(), flags);
+	if (rte_kvargs_count(kvlist, ETH_VHOST_ASYNC_COPY) == 1) {
+		ret = rte_kvargs_process(kvlist, ETH_VHOST_ASYNC_COPY,
+					 &open_int, &async_lcore);
+		if (ret < 0)
+			goto out_free;
+
+		/* The copies are done on a service core */
+		ret = rte_service_lcore_add(async_lcore);
+		if (ret < 0 && ret != -EALREADY) {
+			RTE_LOG(ERR, PMD, "Invalid service lcore %u\n",
+				async_lcore);
+			goto out_free;
+		}
+		ret = 0;
+		async_copy = async_lcore;
+	}
+
+	eth_dev_vhost_create(name, iface_name, queues, rte_socket_id(), flags,
+			     async_copy);
 
 out_free:
 	rte_kvargs_free(kvlist);
@@ -1255,4 +1492,5 @@ RTE_PMD_REGISTER_VDEV(net_vhost, pmd_vhost_drv);
 RTE_PMD_REGISTER_ALIAS(net_vhost, eth_vhost);
 RTE_PMD_REGISTER_PARAM_STRING(net_vhost,
 	"iface=<ifc> "
-	"queues=<int>");
+	"queues=<int> "
+	"async-copy=<lcore>");
@@ -58,6 +58,9 @@
 #include "virtio_logs.h"
 #include "virtqueue.h"
 #include "virtio_rxtx.h"
+#ifdef RTE_VIRTIO_USER
+#include "virtio_user/virtio_user_dev.h"
+#endif
 
 static int eth_virtio_dev_uninit(struct rte_eth_dev *eth_dev);
 static int  virtio_dev_configure(struct rte_eth_dev *dev);
@@ -154,6 +157,75 @@ static const struct rte_virtio_xstats_name_off rte_virtio_txq_stat_strings[] = {
 
 struct virtio_hw_internal virtio_hw_internal[RTE_MAX_ETHPORTS];
 
+static int
+virtio_send_command_packed(struct virtnet_ctl *cvq, int *dlen, int pkt_num)
+{
+	struct virtqueue *vq = cvq->vq;
+	struct vring_packed_desc *desc = vq->vq_packed.desc;
+	struct virtio_pmd_ctrl *result;
+	uint16_t head, idx, id, head_flags;
+	int k, sum = 0, nb_descs = 0;
+
+	/*
+	 * Same format as with a split ring, on consecutive descriptors:
+	 * the flags of the head are written last to expose the chain.
+	 */
+	head = vq->vq_avail_idx;
+	id = vq->vq_desc_head_idx;
+	vq->vq_desc_head_idx = vq->vq_descx[id].next;
+
+	desc[head].addr = cvq->virtio_net_hdr_mem;
+	desc[head].len = sizeof(struct virtio_net_ctrl_hdr);
+	desc[head].id = id;
+	head_flags = VRING_DESC_F_NEXT | vq->vq_avail_flags;
+	vq_packed_avail_next(vq);
+	nb_descs++;
+
+	for (k = 0; k < pkt_num; k++) {
+		idx = vq->vq_avail_idx;
+		desc[idx].addr = cvq->virtio_net_hdr_mem
+			+ sizeof(struct virtio_net_ctrl_hdr)
+			+ sizeof(virtio_net_ctrl_ack) + sizeof(uint8_t) * sum;
+		desc[idx].len = dlen[k];
+		desc[idx].id = id;
+		desc[idx].flags = VRING_DESC_F_NEXT | vq->vq_avail_flags;
+		sum += dlen[k];
+		vq_packed_avail_next(vq);
+		nb_descs++;
+	}
+
+	idx = vq->vq_avail_idx;
+	desc[idx].addr = cvq->virtio_net_hdr_mem
+		+ sizeof(struct virtio_net_ctrl_hdr);
+	desc[idx].len = sizeof(virtio_net_ctrl_ack);
+	desc[idx].id = id;
+	desc[idx].flags = VRING_DESC_F_WRITE | vq->vq_avail_flags;
+	vq_packed_avail_next(vq);
+	nb_descs++;
+
+	vq->vq_descx[id].ndescs = nb_descs;
+	vq->vq_free_cnt -= nb_descs;
+
+	virtio_wmb();
+	desc[head].flags = head_flags;
+
+	virtqueue_notify(vq);
+
+	while (!desc_is_used(&desc[vq->vq_used_cons_idx],
+			     vq->vq_used_wrap_counter)) {
+		rte_rmb();
+		usleep(100);
+	}
+	virtio_rmb();
+	vq_packed_free_id(vq, desc[vq->vq_used_cons_idx].id);
+
+	PMD_INIT_LOG(DEBUG, "vq->vq_free_cnt=%d vq->vq_avail_idx=%d",
+		     vq->vq_free_cnt, vq->vq_avail_idx);
+
+	result = cvq->virtio_net_hdr_mz->addr;
+	return result->status;
+}
+
 static int
 virtio_send_command(struct virtnet_ctl *cvq, struct virtio_pmd_ctrl *ctrl,
 		int *dlen, int pkt_num)
@@ -183,6 +255,9 @@ virtio_send_command(struct virtnet_ctl *cvq, struct virtio_pmd_ctrl *ctrl,
 	memcpy(cvq->virtio_net_hdr_mz->addr, ctrl,
 		sizeof(struct virtio_pmd_ctrl));
 
+	if (vtpci_packed_queue(vq->hw))
+		return virtio_send_command_packed(cvq, dlen, pkt_num);
+
 	/*
 	 * Format is enforced in qemu code:
 	 * One TX packet for header;
@@ -323,6 +398,24 @@ virtio_init_vring(struct virtqueue *vq)
 	 * Reinitialise since virtio port might have been stopped and restarted
 	 */
 	memset(ring_mem, 0, vq->vq_ring_size);
+
+	if (vtpci_packed_queue(vq->hw)) {
+		vring_packed_init(&vq->vq_packed, size, ring_mem,
+				  VIRTIO_PCI_VRING_ALIGN);
+		vq->vq_used_cons_idx = 0;
+		vq->vq_avail_idx = 0;
+		vq->vq_desc_head_idx = 0;
+		/* both wrap counters start at 1 */
+		vq->vq_avail_flags = VRING_DESC_F_AVAIL;
+		vq->vq_used_wrap_counter = 1;
+		vq->vq_free_cnt = vq->vq_nentries;
+		memset(vq->vq_descx, 0,
+		       sizeof(struct vq_desc_extra) * vq->vq_nentries);
+		vring_packed_id_init(vq->vq_descx, size);
+		virtqueue_disable_intr(vq);
+		return;
+	}
+
 	vring_init(vr, size, ring_mem, VIRTIO_PCI_VRING_ALIGN);
 	vq->vq_used_cons_idx = 0;
 	vq->vq_desc_head_idx = 0;
@@ -406,7 +499,10 @@ virtio_init_queue(struct rte_eth_dev *dev, uint16_t vtpci_queue_idx)
 	/*
 	 * Reserve a memzone for vring elements
 	 */
-	size = vring_size(vq_size, VIRTIO_PCI_VRING_ALIGN);
+	if (vtpci_packed_queue(hw))
+		size = vring_packed_size(vq_size, VIRTIO_PCI_VRING_ALIGN);
+	else
+		size = vring_size(vq_size, VIRTIO_PCI_VRING_ALIGN);
 	vq->vq_ring_size = RTE_ALIGN_CEIL(size, VIRTIO_PCI_VRING_ALIGN);
 	PMD_INIT_LOG(DEBUG, "vring_size: %d, rounded_vring_size: %d",
 		     size, vq->vq_ring_size);
@@ -750,6 +846,33 @@ virtio_dev_rx_queue_intr_disable(struct rte_eth_dev *dev, uint16_t queue_id)
 	return 0;
 }
 
+static int
+virtio_dev_rx_queue_fd_get(struct rte_eth_dev *dev, uint16_t queue_id)
+{
+#ifdef RTE_VIRTIO_USER
+	struct virtio_hw *hw = dev->data->dev_private;
+	struct virtnet_rx *rxvq = dev->data->rx_queues[queue_id];
+	struct virtio_user_dev *vu_dev = hw->virtio_user_dev;
+
+	/* the backend signals the used ring on the call eventfd */
+	if (vu_dev)
+		return vu_dev->callfds[rxvq->vq->vq_queue_index];
+#else
+	RTE_SET_USED(dev);
+	RTE_SET_USED(queue_id);
+#endif
+	return -ENOTSUP;
+}
+
+static uint32_t
+virtio_dev_rx_queue_count(struct rte_eth_dev *dev, uint16_t queue_id)
+{
+	struct virtnet_rx *rxvq = dev->data->rx_queues[queue_id];
+
+	virtio_rmb();
+	return virtqueue_nused(rxvq->vq);
+}
+
 /*
  * dev_ops for virtio, bare necessities for basic operation
  */
@@ -773,6 +896,8 @@ static const struct eth_dev_ops virtio_eth_dev_ops = {
 	.rx_queue_setup          = virtio_dev_rx_queue_setup,
 	.rx_queue_intr_enable    = virtio_dev_rx_queue_intr_enable,
 	.rx_queue_intr_disable   = virtio_dev_rx_queue_intr_disable,
+	.rx_queue_fd_get         = virtio_dev_rx_queue_fd_get,
+	.rx_queue_count          = virtio_dev_rx_queue_count,
 	.rx_queue_release        = virtio_dev_queue_release,
 	.rx_descriptor_done      = virtio_dev_rx_queue_done,
 	.tx_queue_setup          = virtio_dev_tx_queue_setup,
@@ -1163,6 +1288,9 @@ virtio_negotiate_features(struct virtio_hw *hw, uint64_t req_features)
 	 * guest feature bits.
 	 */
 	hw->guest_features = req_features;
+	/* the packed ring layout is only defined for virtio 1.0 devices */
+	if (!(host_features & (1ULL << VIRTIO_F_VERSION_1)))
+		hw->guest_features &= ~(1ULL << VIRTIO_F_RING_PACKED);
 	hw->guest_features = vtpci_negotiate_features(hw, host_features);
 	PMD_INIT_LOG(DEBUG, "features after negotiate = %" PRIx64,
 		hw->guest_features);
@@ -1217,12 +1345,28 @@ static void
 rx_func_get(struct rte_eth_dev *eth_dev)
 {
 	struct virtio_hw *hw = eth_dev->data->dev_private;
-	if (vtpci_with_feature(hw, VIRTIO_NET_F_MRG_RXBUF))
+	if (vtpci_packed_queue(hw)) {
+		if (vtpci_with_feature(hw, VIRTIO_NET_F_MRG_RXBUF))
+			eth_dev->rx_pkt_burst =
+				&virtio_recv_mergeable_pkts_packed;
+		else
+			eth_dev->rx_pkt_burst = &virtio_recv_pkts_packed;
+	} else if (vtpci_with_feature(hw, VIRTIO_NET_F_MRG_RXBUF))
 		eth_dev->rx_pkt_burst = &virtio_recv_mergeable_pkts;
 	else
 		eth_dev->rx_pkt_burst = &virtio_recv_pkts;
 }
 
+static void
+tx_func_get(struct rte_eth_dev *eth_dev)
+{
+	struct virtio_hw *hw = eth_dev->data->dev_private;
+	if (vtpci_packed_queue(hw))
+		eth_dev->tx_pkt_burst = &virtio_xmit_pkts_packed;
+	else
+		eth_dev->tx_pkt_burst = &virtio_xmit_pkts;
+}
+
 /* Only support 1:1 queue/interrupt mapping so far.
  * TODO: support n:1 queue/interrupt mapping when there are limited number of
  * interrupt vectors (<N+1).
@@ -1345,6 +1489,7 @@ virtio_init_device(struct rte_eth_dev *eth_dev, uint64_t req_features)
 		eth_dev->data->dev_flags |= RTE_ETH_DEV_INTR_LSC;
 
 	rx_func_get(eth_dev);
+	tx_func_get(eth_dev);
 
 	/* Setting up rx_header size for the device */
 	if (vtpci_with_feature(hw, VIRTIO_NET_F_MRG_RXBUF) ||
@@ -1502,6 +1647,7 @@ eth_virtio_dev_init(struct rte_eth_dev *eth_dev)
 			eth_dev->rx_pkt_burst = virtio_recv_pkts_vec;
 		} else {
 			rx_func_get(eth_dev);
+			tx_func_get(eth_dev);
 		}
 		return 0;
 	}
@@ -460,6 +460,13 @@ modern_setup_queue(struct virtio_hw *hw, struct virtqueue *vq)
 	used_addr = RTE_ALIGN_CEIL(avail_addr + offsetof(struct vring_avail,
 							 ring[vq->vq_nentries]),
 				   VIRTIO_PCI_VRING_ALIGN);
+	if (vtpci_packed_queue(hw)) {
+		/* driver and device event suppression areas */
+		avail_addr = desc_addr + RTE_PTR_DIFF(vq->vq_packed.driver,
+						      vq->vq_ring_virt_mem);
+		used_addr = desc_addr + RTE_PTR_DIFF(vq->vq_packed.device,
+						     vq->vq_ring_virt_mem);
+	}
 
 	rte_write16(vq->vq_queue_index, &hw->common_cfg->queue_select);
 
@@ -45,6 +45,20 @@
 /* This means the buffer contains a list of buffer descriptors. */
 #define VRING_DESC_F_INDIRECT   4
 
+/*
+ * Packed ring: the driver makes a descriptor available by setting its AVAIL
+ * bit to its wrap counter and its USED bit to the inverse; the device marks
+ * it used by setting both bits to its own wrap counter.
+ */
+#define VRING_DESC_F_AVAIL	(1 << 7)
+#define VRING_DESC_F_USED	(1 << 15)
+#define VRING_DESC_F_AVAIL_USED	(VRING_DESC_F_AVAIL | VRING_DESC_F_USED)
+
+/* Packed ring event suppression flags, in the driver and device areas. */
+#define VRING_EVENT_F_ENABLE	0x0
+#define VRING_EVENT_F_DISABLE	0x1
+#define VRING_EVENT_F_DESC	0x2
+
 /* The Host uses this in used->flags to advise the Guest: don't kick me
  * when you add a buffer.  It's unreliable, so it's simply an
  * optimization.  Guest will still kick if it's out of buffers. */
@@ -90,6 +104,27 @@ struct vring {
 	struct vring_used  *used;
 };
 
+/* Packed ring descriptor: 16 bytes, written back in place by the device. */
+struct vring_packed_desc {
+	uint64_t addr;
+	uint32_t len;
+	uint16_t id;    /* Buffer ID, returned by the device when used. */
+	uint16_t flags;
+};
+
+/* Packed ring event suppression structure. */
+struct vring_packed_desc_event {
+	uint16_t off_wrap;
+	uint16_t flags;
+};
+
+struct vring_packed {
+	unsigned int num;
+	struct vring_packed_desc *desc;
+	struct vring_packed_desc_event *driver; /* written by the driver */
+	struct vring_packed_desc_event *device; /* written by the device */
+};
+
 /* The standard layout for the ring is a continuous chunk of memory which
  * looks like this.  We assume num is a power of 2.
  *
@@ -148,6 +183,34 @@ vring_init(struct vring *vr, unsigned int num, uint8_t *p,
 		RTE_ALIGN_CEIL((uintptr_t)(&vr->avail->ring[num]), align);
 }
 
+/*
+ * The packed ring layout is the descriptor ring, followed by the driver
+ * event suppression area and, on the next align boundary, the device one.
+ */
+static inline size_t
+vring_packed_size(unsigned int num, unsigned long align)
+{
+	size_t size;
+
+	size = num * sizeof(struct vring_packed_desc);
+	size += sizeof(struct vring_packed_desc_event);
+	size = RTE_ALIGN_CEIL(size, align);
+	size += sizeof(struct vring_packed_desc_event);
+	return size;
+}
+
+static inline void
+vring_packed_init(struct vring_packed *vr, unsigned int num, uint8_t *p,
+	unsigned long align)
+{
+	vr->num = num;
+	vr->desc = (struct vring_packed_desc *)p;
+	vr->driver = (struct vring_packed_desc_event *)(p +
+		num * sizeof(struct vring_packed_desc));
+	vr->device = (struct vring_packed_desc_event *)
+		RTE_ALIGN_CEIL((uintptr_t)(vr->driver + 1), align);
+}
+
 /*
  * The following is used with VIRTIO_RING_F_EVENT_IDX.
  * Assuming a given event_idx value from the other size, if we have
@@ -78,7 +78,7 @@ virtio_dev_rx_queue_done(void *rxq, uint16_t offset)
 	struct virtnet_rx *rxvq = rxq;
 	struct virtqueue *vq = rxvq->vq;
 
-	return VIRTQUEUE_NUSED(vq) >= offset;
+	return virtqueue_nused(vq) >= offset;
 }
 
 static void
@@ -149,6 +149,43 @@ virtqueue_dequeue_burst_rx(struct virtqueue *vq, struct rte_mbuf **rx_pkts,
 	return i;
 }
 
+static uint16_t
+virtqueue_dequeue_burst_rx_packed(struct virtqueue *vq,
+				  struct rte_mbuf **rx_pkts,
+				  uint32_t *len, uint16_t num)
+{
+	struct vring_packed_desc *desc = vq->vq_packed.desc;
+	struct rte_mbuf *cookie;
+	uint16_t used_idx, id;
+	uint16_t i;
+
+	for (i = 0; i < num; i++) {
+		used_idx = vq->vq_used_cons_idx;
+		if (!desc_is_used(&desc[used_idx], vq->vq_used_wrap_counter))
+			break;
+		/* read the descriptor only once the device has marked it */
+		virtio_rmb();
+
+		id = desc[used_idx].id;
+		len[i] = desc[used_idx].len;
+		cookie = (struct rte_mbuf *)vq->vq_descx[id].cookie;
+
+		if (unlikely(cookie == NULL)) {
+			PMD_DRV_LOG(ERR, "vring descriptor with no mbuf cookie at %u\n",
+				vq->vq_used_cons_idx);
+			break;
+		}
+
+		rte_prefetch0(cookie);
+		rte_packet_prefetch(rte_pktmbuf_mtod(cookie, void *));
+		rx_pkts[i] = cookie;
+		vq->vq_descx[id].cookie = NULL;
+		vq_packed_free_id(vq, id);
+	}
+
+	return i;
+}
+
 #ifndef DEFAULT_TX_FREE_THRESH
 #define DEFAULT_TX_FREE_THRESH 32
 #endif
@@ -177,6 +214,27 @@ virtio_xmit_cleanup(struct virtqueue *vq, uint16_t num)
 	}
 }
 
+/* Cleanup from completed transmits, on a packed ring. */
+static void
+virtio_xmit_cleanup_packed(struct virtqueue *vq, uint16_t num)
+{
+	struct vring_packed_desc *desc = vq->vq_packed.desc;
+	struct vq_desc_extra *dxp;
+	uint16_t id;
+
+	while (num-- && desc_is_used(&desc[vq->vq_used_cons_idx],
+				     vq->vq_used_wrap_counter)) {
+		virtio_rmb();
+		id = desc[vq->vq_used_cons_idx].id;
+		dxp = &vq->vq_descx[id];
+		vq_packed_free_id(vq, id);
+
+		if (dxp->cookie != NULL) {
+			rte_pktmbuf_free(dxp->cookie);
+			dxp->cookie = NULL;
+		}
+	}
+}
 
 static inline int
 virtqueue_enqueue_recv_refill(struct virtqueue *vq, struct rte_mbuf *cookie)
@@ -218,6 +276,58 @@ virtqueue_enqueue_recv_refill(struct virtqueue *vq, struct rte_mbuf *cookie)
 	return 0;
 }
 
+/*
+ * Make a batch of receive buffers available on a packed ring. The flags of
+ * the first descriptor are written last: the device reads the descriptors
+ * in ring order, so one write barrier publishes the whole batch.
+ */
+static inline int
+virtqueue_enqueue_recv_refill_packed(struct virtqueue *vq,
+				     struct rte_mbuf **cookies, uint16_t num)
+{
+	struct vring_packed_desc *start_dp = vq->vq_packed.desc;
+	struct virtio_hw *hw = vq->hw;
+	struct vq_desc_extra *dxp;
+	uint16_t head_idx = vq->vq_avail_idx;
+	uint16_t head_flags = 0, flags;
+	uint16_t idx, id, i;
+
+	if (unlikely(vq->vq_free_cnt == 0))
+		return -ENOSPC;
+	if (unlikely(vq->vq_free_cnt < num))
+		return -EMSGSIZE;
+
+	for (i = 0; i < num; i++) {
+		idx = vq->vq_avail_idx;
+		id = vq->vq_desc_head_idx;
+		if (unlikely(id >= vq->vq_nentries))
+			return -EFAULT;
+		dxp = &vq->vq_descx[id];
+		vq->vq_desc_head_idx = dxp->next;
+		dxp->cookie = (void *)cookies[i];
+		dxp->ndescs = 1;
+
+		start_dp[idx].addr =
+			VIRTIO_MBUF_ADDR(cookies[i], vq) +
+			RTE_PKTMBUF_HEADROOM - hw->vtnet_hdr_size;
+		start_dp[idx].len = cookies[i]->buf_len -
+			RTE_PKTMBUF_HEADROOM + hw->vtnet_hdr_size;
+		start_dp[idx].id = id;
+		flags = VRING_DESC_F_WRITE | vq->vq_avail_flags;
+		if (i == 0)
+			head_flags = flags;
+		else
+			start_dp[idx].flags = flags;
+		vq_packed_avail_next(vq);
+	}
+	vq->vq_free_cnt = (uint16_t)(vq->vq_free_cnt - num);
+
+	virtio_wmb();
+	start_dp[head_idx].flags = head_flags;
+
+	return 0;
+}
+
 /* When doing TSO, the IP length is not included in the pseudo header
  * checksum of the packet given to the PMD, but for virtio it is
  * expected.
@@ -267,6 +377,51 @@ tx_offload_enabled(struct virtio_hw *hw)
 		vtpci_with_feature(hw, VIRTIO_NET_F_HOST_TSO6);
 }
 
+static inline void
+virtqueue_xmit_offload(struct virtio_net_hdr *hdr, struct rte_mbuf *cookie)
+{
+	if (cookie->ol_flags & PKT_TX_TCP_SEG)
+		cookie->ol_flags |= PKT_TX_TCP_CKSUM;
+
+	switch (cookie->ol_flags & PKT_TX_L4_MASK) {
+	case PKT_TX_UDP_CKSUM:
+		hdr->csum_start = cookie->l2_len + cookie->l3_len;
+		hdr->csum_offset = offsetof(struct udp_hdr,
+			dgram_cksum);
+		hdr->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+		break;
+
+	case PKT_TX_TCP_CKSUM:
+		hdr->csum_start = cookie->l2_len + cookie->l3_len;
+		hdr->csum_offset = offsetof(struct tcp_hdr, cksum);
+		hdr->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+		break;
+
+	default:
+		hdr->csum_start = 0;
+		hdr->csum_offset = 0;
+		hdr->flags = 0;
+		break;
+	}
+
+	/* TCP Segmentation Offload */
+	if (cookie->ol_flags & PKT_TX_TCP_SEG) {
+		virtio_tso_fix_cksum(cookie);
+		hdr->gso_type = (cookie->ol_flags & PKT_TX_IPV6) ?
+			VIRTIO_NET_HDR_GSO_TCPV6 :
+			VIRTIO_NET_HDR_GSO_TCPV4;
+		hdr->gso_size = cookie->tso_segsz;
+		hdr->hdr_len =
+			cookie->l2_len +
+			cookie->l3_len +
+			cookie->l4_len;
+	} else {
+		hdr->gso_type = 0;
+		hdr->gso_size = 0;
+		hdr->hdr_len = 0;
+	}
+}
+
 static inline void
 virtqueue_enqueue_xmit(struct virtnet_tx *txvq, struct rte_mbuf *cookie,
 		       uint16_t needed, int use_indirect, int can_push)
@@ -327,48 +482,8 @@ virtqueue_enqueue_xmit(struct virtnet_tx *txvq, struct rte_mbuf *cookie,
 	}
 
 	/* Checksum Offload / TSO */
-	if (offload) {
-		if (cookie->ol_flags & PKT_TX_TCP_SEG)
-			cookie->ol_flags |= PKT_TX_TCP_CKSUM;
-
-		switch (cookie->ol_flags & PKT_TX_L4_MASK) {
-		case PKT_TX_UDP_CKSUM:
-			hdr->csum_start = cookie->l2_len + cookie->l3_len;
-			hdr->csum_offset = offsetof(struct udp_hdr,
-				dgram_cksum);
-			hdr->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
-			break;
-
-		case PKT_TX_TCP_CKSUM:
-			hdr->csum_start = cookie->l2_len + cookie->l3_len;
-			hdr->csum_offset = offsetof(struct tcp_hdr, cksum);
-			hdr->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
-			break;
-
-		default:
-			hdr->csum_start = 0;
-			hdr->csum_offset = 0;
-			hdr->flags = 0;
-			break;
-		}
-
-		/* TCP Segmentation Offload */
-		if (cookie->ol_flags & PKT_TX_TCP_SEG) {
-			virtio_tso_fix_cksum(cookie);
-			hdr->gso_type = (cookie->ol_flags & PKT_TX_IPV6) ?
-				VIRTIO_NET_HDR_GSO_TCPV6 :
-				VIRTIO_NET_HDR_GSO_TCPV4;
-			hdr->gso_size = cookie->tso_segsz;
-			hdr->hdr_len =
-				cookie->l2_len +
-				cookie->l3_len +
-				cookie->l4_len;
-		} else {
-			hdr->gso_type = 0;
-			hdr->gso_size = 0;
-			hdr->hdr_len = 0;
-		}
-	}
+	if (offload)
+		virtqueue_xmit_offload(hdr, cookie);
 
 	do {
 		start_dp[idx].addr  = VIRTIO_MBUF_DATA_DMA_ADDR(cookie, vq);
@@ -387,6 +502,78 @@ virtqueue_enqueue_xmit(struct virtnet_tx *txvq, struct rte_mbuf *cookie,
 	vq_update_avail_ring(vq, head_idx);
 }
 
+/*
+ * Fill the descriptors of a packet on a packed ring. The flags of the
+ * first descriptor are returned instead of being written, for the caller
+ * to expose the packet, or a whole burst, after a write barrier.
+ */
+static inline uint16_t
+virtqueue_enqueue_xmit_packed(struct virtnet_tx *txvq, struct rte_mbuf *cookie,
+			      uint16_t needed, int can_push)
+{
+	struct virtio_tx_region *txr = txvq->virtio_net_hdr_mz->addr;
+	struct virtqueue *vq = txvq->vq;
+	struct vring_packed_desc *start_dp = vq->vq_packed.desc;
+	struct vq_desc_extra *dxp;
+	uint16_t head_size = vq->hw->vtnet_hdr_size;
+	uint16_t head_flags, flags;
+	uint16_t idx, id;
+	struct virtio_net_hdr *hdr;
+	int offload;
+
+	offload = tx_offload_enabled(vq->hw);
+	id = vq->vq_desc_head_idx;
+	dxp = &vq->vq_descx[id];
+	vq->vq_desc_head_idx = dxp->next;
+	dxp->cookie = (void *)cookie;
+	dxp->ndescs = needed;
+
+	idx = vq->vq_avail_idx;
+	if (can_push) {
+		/* prepend cannot fail, checked by caller */
+		hdr = (struct virtio_net_hdr *)
+			rte_pktmbuf_prepend(cookie, head_size);
+		/* if offload disabled, it is not zeroed below, do it now */
+		if (offload == 0)
+			memset(hdr, 0, head_size);
+
+		start_dp[idx].addr  = VIRTIO_MBUF_DATA_DMA_ADDR(cookie, vq);
+		start_dp[idx].len   = cookie->data_len;
+		head_flags = cookie->next ? VRING_DESC_F_NEXT : 0;
+		cookie = cookie->next;
+	} else {
+		/* first descriptor points to the header stored in the
+		 * reserved region of the buffer ID.
+		 */
+		start_dp[idx].addr  = txvq->virtio_net_hdr_mem +
+			RTE_PTR_DIFF(&txr[id].tx_hdr, txr);
+		start_dp[idx].len   = head_size;
+		head_flags = VRING_DESC_F_NEXT;
+		hdr = (struct virtio_net_hdr *)&txr[id].tx_hdr;
+	}
+	start_dp[idx].id = id;
+	head_flags |= vq->vq_avail_flags;
+	vq_packed_avail_next(vq);
+
+	if (offload)
+		virtqueue_xmit_offload(hdr, dxp->cookie);
+
+	while (cookie != NULL) {
+		idx = vq->vq_avail_idx;
+		start_dp[idx].addr  = VIRTIO_MBUF_DATA_DMA_ADDR(cookie, vq);
+		start_dp[idx].len   = cookie->data_len;
+		start_dp[idx].id    = id;
+		flags = cookie->next ? VRING_DESC_F_NEXT : 0;
+		start_dp[idx].flags = flags | vq->vq_avail_flags;
+		vq_packed_avail_next(vq);
+		cookie = cookie->next;
+	}
+
+	vq->vq_free_cnt = (uint16_t)(vq->vq_free_cnt - needed);
+
+	return head_flags;
+}
+
 void
 virtio_dev_cq_start(struct rte_eth_dev *dev)
 {
@@ -457,6 +644,9 @@ virtio_dev_rx_queue_setup(struct rte_eth_dev *dev,
 		/* Enqueue allocated buffers */
 		if (hw->use_simple_rxtx)
 			error = virtqueue_enqueue_recv_refill_simple(vq, m);
+		else if (vtpci_packed_queue(hw))
+			error = virtqueue_enqueue_recv_refill_packed(vq,
+								     &m, 1);
 		else
 			error = virtqueue_enqueue_recv_refill(vq, m);
 
@@ -467,7 +657,8 @@ virtio_dev_rx_queue_setup(struct rte_eth_dev *dev,
 		nbufs++;
 	}
 
-	vq_update_avail_idx(vq);
+	if (!vtpci_packed_queue(hw))
+		vq_update_avail_idx(vq);
 
 	PMD_INIT_LOG(DEBUG, "Allocated %d bufs", nbufs);
 
@@ -492,6 +683,10 @@ virtio_update_rxtx_handler(struct rte_eth_dev *dev,
 	if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_NEON))
 		use_simple_rxtx = 1;
 #endif
+	/* The vector paths only know the split ring layout */
+	if (vtpci_packed_queue(hw))
+		use_simple_rxtx = 0;
+
 	/* Use simple rx/tx func if single segment and no offloads */
 	if (use_simple_rxtx &&
 	    (tx_conf->txq_flags & VIRTIO_SIMPLE_FLAGS) == VIRTIO_SIMPLE_FLAGS &&
@@ -594,6 +789,18 @@ virtio_discard_rxbuf(struct virtqueue *vq, struct rte_mbuf *m)
 	}
 }
 
+static void
+virtio_discard_rxbuf_packed(struct virtqueue *vq, struct rte_mbuf *m)
+{
+	int error;
+
+	error = virtqueue_enqueue_recv_refill_packed(vq, &m, 1);
+	if (unlikely(error)) {
+		RTE_LOG(ERR, PMD, "cannot requeue discarded mbuf");
+		rte_pktmbuf_free(m);
+	}
+}
+
 static void
 virtio_update_packet_stats(struct virtnet_stats *stats, struct rte_mbuf *mbuf)
 {
@@ -1080,3 +1287,329 @@ virtio_xmit_pkts(void *tx_queue, struct rte_mbuf **tx_pkts, uint16_t nb_pkts)
 
 	return nb_tx;
 }
+
+static inline void
+virtio_rx_refill_packed(struct virtnet_rx *rxvq, uint32_t *nb_enqueued)
+{
+	struct virtqueue *vq = rxvq->vq;
+	struct rte_mbuf *new_pkts[VIRTIO_MBUF_BURST_SZ];
+	uint16_t free_cnt, i;
+
+	/* Allocate and expose the new mbufs in bursts */
+	while (likely(!virtqueue_full(vq))) {
+		free_cnt = RTE_MIN(vq->vq_free_cnt, VIRTIO_MBUF_BURST_SZ);
+		if (unlikely(rte_pktmbuf_alloc_bulk(rxvq->mpool,
+				new_pkts, free_cnt) != 0)) {
+			struct rte_eth_dev *dev
+				= &rte_eth_devices[rxvq->port_id];
+			dev->data->rx_mbuf_alloc_failed += free_cnt;
+			break;
+		}
+		if (unlikely(virtqueue_enqueue_recv_refill_packed(vq,
+				new_pkts, free_cnt))) {
+			for (i = 0; i < free_cnt; i++)
+				rte_pktmbuf_free(new_pkts[i]);
+			break;
+		}
+		*nb_enqueued += free_cnt;
+	}
+
+	if (likely(*nb_enqueued)) {
+		if (unlikely(virtqueue_kick_prepare_packed(vq))) {
+			virtqueue_notify(vq);
+			PMD_RX_LOG(DEBUG, "Notified");
+		}
+	}
+}
+
+uint16_t
+virtio_recv_pkts_packed(void *rx_queue, struct rte_mbuf **rx_pkts,
+			uint16_t nb_pkts)
+{
+	struct virtnet_rx *rxvq = rx_queue;
+	struct virtqueue *vq = rxvq->vq;
+	struct virtio_hw *hw = vq->hw;
+	struct rte_mbuf *rxm;
+	uint16_t num, nb_rx;
+	uint32_t len[VIRTIO_MBUF_BURST_SZ];
+	struct rte_mbuf *rcv_pkts[VIRTIO_MBUF_BURST_SZ];
+	uint32_t i, nb_enqueued;
+	uint32_t hdr_size;
+	int offload;
+	struct virtio_net_hdr *hdr;
+
+	/* the used descriptors are found by their flags, no index to read */
+	num = RTE_MIN(nb_pkts, VIRTIO_MBUF_BURST_SZ);
+	num = virtqueue_dequeue_burst_rx_packed(vq, rcv_pkts, len, num);
+	PMD_RX_LOG(DEBUG, "dequeue:%d", num);
+
+	nb_rx = 0;
+	nb_enqueued = 0;
+	hdr_size = hw->vtnet_hdr_size;
+	offload = rx_offload_enabled(hw);
+
+	for (i = 0; i < num ; i++) {
+		rxm = rcv_pkts[i];
+
+		PMD_RX_LOG(DEBUG, "packet len:%d", len[i]);
+
+		if (unlikely(len[i] < hdr_size + ETHER_HDR_LEN)) {
+			PMD_RX_LOG(ERR, "Packet drop");
+			nb_enqueued++;
+			virtio_discard_rxbuf_packed(vq, rxm);
+			rxvq->stats.errors++;
+			continue;
+		}
+
+		rxm->port = rxvq->port_id;
+		rxm->data_off = RTE_PKTMBUF_HEADROOM;
+		rxm->ol_flags = 0;
+		rxm->vlan_tci = 0;
+
+		rxm->nb_segs = 1;
+		rxm->next = NULL;
+		rxm->pkt_len = (uint32_t)(len[i] - hdr_size);
+		rxm->data_len = (uint16_t)(len[i] - hdr_size);
+
+		hdr = (struct virtio_net_hdr *)((char *)rxm->buf_addr +
+			RTE_PKTMBUF_HEADROOM - hdr_size);
+
+		if (hw->vlan_strip)
+			rte_vlan_strip(rxm);
+
+		if (offload && virtio_rx_offload(rxm, hdr) < 0) {
+			virtio_discard_rxbuf_packed(vq, rxm);
+			rxvq->stats.errors++;
+			continue;
+		}
+
+		VIRTIO_DUMP_PACKET(rxm, rxm->data_len);
+
+		rx_pkts[nb_rx++] = rxm;
+
+		rxvq->stats.bytes += rxm->pkt_len;
+		virtio_update_packet_stats(&rxvq->stats, rxm);
+	}
+
+	rxvq->stats.packets += nb_rx;
+
+	virtio_rx_refill_packed(rxvq, &nb_enqueued);
+
+	return nb_rx;
+}
+
+uint16_t
+virtio_recv_mergeable_pkts_packed(void *rx_queue,
+			struct rte_mbuf **rx_pkts,
+			uint16_t nb_pkts)
+{
+	struct virtnet_rx *rxvq = rx_queue;
+	struct virtqueue *vq = rxvq->vq;
+	struct virtio_hw *hw = vq->hw;
+	struct rte_mbuf *rxm;
+	uint16_t num, nb_rx;
+	uint32_t len[VIRTIO_MBUF_BURST_SZ];
+	struct rte_mbuf *rcv_pkts[VIRTIO_MBUF_BURST_SZ];
+	struct rte_mbuf *prev;
+	uint32_t nb_enqueued;
+	uint32_t seg_num;
+	uint16_t extra_idx;
+	uint32_t seg_res;
+	uint32_t hdr_size;
+	int offload;
+
+	nb_rx = 0;
+	nb_enqueued = 0;
+	hdr_size = hw->vtnet_hdr_size;
+	offload = rx_offload_enabled(hw);
+
+	while (nb_rx < nb_pkts) {
+		struct virtio_net_hdr_mrg_rxbuf *header;
+
+		num = virtqueue_dequeue_burst_rx_packed(vq, rcv_pkts, len, 1);
+		if (num != 1)
+			break;
+
+		PMD_RX_LOG(DEBUG, "packet len:%d", len[0]);
+
+		rxm = rcv_pkts[0];
+
+		if (unlikely(len[0] < hdr_size + ETHER_HDR_LEN)) {
+			PMD_RX_LOG(ERR, "Packet drop");
+			nb_enqueued++;
+			virtio_discard_rxbuf_packed(vq, rxm);
+			rxvq->stats.errors++;
+			continue;
+		}
+
+		header = (struct virtio_net_hdr_mrg_rxbuf *)((char *)rxm->buf_addr +
+			RTE_PKTMBUF_HEADROOM - hdr_size);
+		seg_num = header->num_buffers;
+
+		if (seg_num == 0)
+			seg_num = 1;
+
+		rxm->data_off = RTE_PKTMBUF_HEADROOM;
+		rxm->nb_segs = seg_num;
+		rxm->next = NULL;
+		rxm->ol_flags = 0;
+		rxm->vlan_tci = 0;
+		rxm->pkt_len = (uint32_t)(len[0] - hdr_size);
+		rxm->data_len = (uint16_t)(len[0] - hdr_size);
+
+		rxm->port = rxvq->port_id;
+		rx_pkts[nb_rx] = rxm;
+		prev = rxm;
+
+		if (offload && virtio_rx_offload(rxm, &header->hdr) < 0) {
+			virtio_discard_rxbuf_packed(vq, rxm);
+			rxvq->stats.errors++;
+			continue;
+		}
+
+		seg_res = seg_num - 1;
+
+		while (seg_res != 0) {
+			/*
+			 * Get extra segments for current uncompleted packet.
+			 * The device exposes all the buffers of a packet at
+			 * once, so they must all be there already.
+			 */
+			uint16_t rcv_cnt =
+				RTE_MIN(seg_res, RTE_DIM(rcv_pkts));
+			uint16_t rx_num =
+				virtqueue_dequeue_burst_rx_packed(vq,
+					rcv_pkts, len, rcv_cnt);
+
+			extra_idx = 0;
+
+			while (extra_idx < rx_num) {
+				rxm = rcv_pkts[extra_idx];
+
+				rxm->data_off = RTE_PKTMBUF_HEADROOM - hdr_size;
+				rxm->next = NULL;
+				rxm->pkt_len = (uint32_t)(len[extra_idx]);
+				rxm->data_len = (uint16_t)(len[extra_idx]);
+
+				prev->next = rxm;
+				prev = rxm;
+				rx_pkts[nb_rx]->pkt_len += rxm->pkt_len;
+				extra_idx++;
+			};
+
+			if (unlikely(rx_num != rcv_cnt)) {
+				PMD_RX_LOG(ERR,
+					   "No enough segments for packet.");
+				rte_pktmbuf_free(rx_pkts[nb_rx]);
+				rxvq->stats.errors++;
+				break;
+			}
+			seg_res -= rcv_cnt;
+		}
+		if (unlikely(seg_res != 0))
+			continue;
+
+		if (hw->vlan_strip)
+			rte_vlan_strip(rx_pkts[nb_rx]);
+
+		VIRTIO_DUMP_PACKET(rx_pkts[nb_rx],
+			rx_pkts[nb_rx]->data_len);
+
+		rxvq->stats.bytes += rx_pkts[nb_rx]->pkt_len;
+		virtio_update_packet_stats(&rxvq->stats, rx_pkts[nb_rx]);
+		nb_rx++;
+	}
+
+	rxvq->stats.packets += nb_rx;
+
+	virtio_rx_refill_packed(rxvq, &nb_enqueued);
+
+	return nb_rx;
+}
+
+uint16_t
+virtio_xmit_pkts_packed(void *tx_queue, struct rte_mbuf **tx_pkts,
+			uint16_t nb_pkts)
+{
+	struct virtnet_tx *txvq = tx_queue;
+	struct virtqueue *vq = txvq->vq;
+	struct virtio_hw *hw = vq->hw;
+	uint16_t hdr_size = hw->vtnet_hdr_size;
+	uint16_t head_idx = vq->vq_avail_idx;
+	uint16_t head_flags = 0, flags;
+	uint16_t nb_tx, nb_enqueued = 0, idx;
+	int error;
+
+	if (unlikely(nb_pkts < 1))
+		return nb_pkts;
+
+	PMD_TX_LOG(DEBUG, "%d packets to xmit", nb_pkts);
+
+	if (likely(vq->vq_free_cnt <= vq->vq_free_thresh))
+		virtio_xmit_cleanup_packed(vq, vq->vq_nentries);
+
+	for (nb_tx = 0; nb_tx < nb_pkts; nb_tx++) {
+		struct rte_mbuf *txm = tx_pkts[nb_tx];
+		int can_push = 0, slots, need;
+
+		/* Do VLAN tag insertion */
+		if (unlikely(txm->ol_flags & PKT_TX_VLAN_PKT)) {
+			error = rte_vlan_insert(&txm);
+			if (unlikely(error)) {
+				rte_pktmbuf_free(txm);
+				continue;
+			}
+		}
+
+		/* optimize ring usage */
+		if (rte_mbuf_refcnt_read(txm) == 1 &&
+		    RTE_MBUF_DIRECT(txm) &&
+		    txm->nb_segs == 1 &&
+		    rte_pktmbuf_headroom(txm) >= hdr_size &&
+		    rte_is_aligned(rte_pktmbuf_mtod(txm, char *),
+				   __alignof__(struct virtio_net_hdr_mrg_rxbuf)))
+			can_push = 1;
+
+		/* How many ring entries are needed to this Tx? */
+		slots = txm->nb_segs + !can_push;
+		need = slots - vq->vq_free_cnt;
+
+		/* Positive value indicates it need free vring descriptors */
+		if (unlikely(need > 0)) {
+			virtio_xmit_cleanup_packed(vq, need);
+			need = slots - vq->vq_free_cnt;
+			if (unlikely(need > 0)) {
+				PMD_TX_LOG(ERR,
+					   "No free tx descriptors to transmit");
+				break;
+			}
+		}
+
+		/* Enqueue Packet buffers, the first one is exposed last */
+		idx = vq->vq_avail_idx;
+		flags = virtqueue_enqueue_xmit_packed(txvq, txm, slots,
+						      can_push);
+		if (idx == head_idx)
+			head_flags = flags;
+		else
+			vq->vq_packed.desc[idx].flags = flags;
+		nb_enqueued++;
+
+		txvq->stats.bytes += txm->pkt_len;
+		virtio_update_packet_stats(&txvq->stats, txm);
+	}
+
+	txvq->stats.packets += nb_tx;
+
+	if (likely(nb_enqueued)) {
+		virtio_wmb();
+		vq->vq_packed.desc[head_idx].flags = head_flags;
+
+		if (unlikely(virtqueue_kick_prepare_packed(vq))) {
+			virtqueue_notify(vq);
+			PMD_TX_LOG(DEBUG, "Notified backend after xmit");
+		}
+	}
+
+	return nb_tx;
+}
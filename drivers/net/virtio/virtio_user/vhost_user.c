@@ -194,19 +194,23 @@ get_hugepage_file_info(struct hugepage_file_info huges[], int max)
 		if (tail)
 			*tail = '\0';
 
-		/* Match HUGEFILE_FMT, aka "%s/%smap_%d",
-		 * which is defined in eal_filesystem.h
+		/* Match HUGEFILE_FMT, aka "%s/%smap_%d", and
+		 * DYN_HUGEFILE_FMT, aka "%s/%smap_dyn_%u_%u", of the memory
+		 * added after init, which are defined in eal_filesystem.h
 		 */
 		str_underline = strrchr(tmp, '_');
 		if (!str_underline)
 			continue;
 
 		str_start = str_underline - strlen("map");
-		if (str_start < tmp)
-			continue;
-
-		if (sscanf(str_start, "map_%d", &huge_index) != 1)
-			continue;
+		if (str_start < tmp ||
+		    sscanf(str_start, "map_%d", &huge_index) != 1) {
+			str_start = strstr(tmp, "map_dyn_");
+			if (!str_start ||
+			    sscanf(str_start, "map_dyn_%d_%d", &huge_index,
+				   &huge_index) != 2)
+				continue;
+		}
 
 		if (idx >= max) {
 			PMD_DRV_LOG(ERR, "Exceed maximum of %d", max);
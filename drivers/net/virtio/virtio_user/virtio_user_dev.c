@@ -43,6 +43,8 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <rte_memory.h>
+
 #include "vhost.h"
 #include "virtio_user_dev.h"
 #include "../virtio_ethdev.h"
@@ -89,12 +91,23 @@ virtio_user_kick_queue(struct virtio_user_dev *dev, uint32_t queue_sel)
 		.flags = 0, /* disable log */
 	};
 
+	if (dev->features & (1ULL << VIRTIO_F_RING_PACKED)) {
+		struct vring_packed *pvring = &dev->packed_vrings[queue_sel];
+
+		addr.desc_user_addr = (uint64_t)(uintptr_t)pvring->desc;
+		addr.avail_user_addr = (uint64_t)(uintptr_t)pvring->driver;
+		addr.used_user_addr = (uint64_t)(uintptr_t)pvring->device;
+	}
+
 	state.index = queue_sel;
 	state.num = vring->num;
 	dev->ops->send_request(dev, VHOST_USER_SET_VRING_NUM, &state);
 
 	state.index = queue_sel;
 	state.num = 0; /* no reservation */
+	/* packed ring: the initial wrap counter is 1, in bit 15 */
+	if (dev->features & (1ULL << VIRTIO_F_RING_PACKED))
+		state.num |= (1 << 15);
 	dev->ops->send_request(dev, VHOST_USER_SET_VRING_BASE, &state);
 
 	dev->ops->send_request(dev, VHOST_USER_SET_VRING_ADDR, &addr);
@@ -146,6 +159,8 @@ virtio_user_start_device(struct virtio_user_dev *dev)
 	uint64_t features;
 	int ret;
 
+	pthread_mutex_lock(&dev->mutex);
+
 	/* Step 0: tell vhost to create queues */
 	if (virtio_user_queue_setup(dev, virtio_user_create_queue) < 0)
 		goto error;
@@ -175,9 +190,13 @@ virtio_user_start_device(struct virtio_user_dev *dev)
 	 */
 	dev->ops->enable_qp(dev, 0, 1);
 
+	dev->started = 1;
+	pthread_mutex_unlock(&dev->mutex);
+
 	return 0;
 error:
 	/* TODO: free resource here or caller to check */
+	pthread_mutex_unlock(&dev->mutex);
 	return -1;
 }
 
@@ -185,6 +204,8 @@ int virtio_user_stop_device(struct virtio_user_dev *dev)
 {
 	uint32_t i;
 
+	pthread_mutex_lock(&dev->mutex);
+
 	for (i = 0; i < dev->max_queue_pairs * 2; ++i) {
 		close(dev->callfds[i]);
 		close(dev->kickfds[i]);
@@ -196,9 +217,29 @@ int virtio_user_stop_device(struct virtio_user_dev *dev)
 	free(dev->ifname);
 	dev->ifname = NULL;
 
+	dev->started = 0;
+	pthread_mutex_unlock(&dev->mutex);
+
 	return 0;
 }
 
+/* The memory added or removed after init, in dynamic memory mode, must be
+ * shared with the backend before any buffer in it reaches the queues.
+ */
+static void
+virtio_user_mem_event_cb(enum rte_mem_event event __rte_unused,
+			 const struct rte_memseg *ms __rte_unused,
+			 unsigned int n_memseg __rte_unused, void *arg)
+{
+	struct virtio_user_dev *dev = arg;
+
+	pthread_mutex_lock(&dev->mutex);
+	if (dev->started &&
+	    dev->ops->send_request(dev, VHOST_USER_SET_MEM_TABLE, NULL) < 0)
+		PMD_DRV_LOG(ERR, "failed to update memory table");
+	pthread_mutex_unlock(&dev->mutex);
+}
+
 static inline void
 parse_mac(struct virtio_user_dev *dev, const char *mac)
 {
@@ -268,13 +309,15 @@ virtio_user_dev_setup(struct virtio_user_dev *dev)
 
 int
 virtio_user_dev_init(struct virtio_user_dev *dev, char *path, int queues,
-		     int cq, int queue_size, const char *mac)
+		     int cq, int queue_size, const char *mac, int packed_vq)
 {
 	snprintf(dev->path, PATH_MAX, "%s", path);
 	dev->max_queue_pairs = queues;
 	dev->queue_pairs = 1; /* mq disabled by default */
 	dev->queue_size = queue_size;
 	dev->mac_specified = 0;
+	dev->started = 0;
+	pthread_mutex_init(&dev->mutex, NULL);
 	parse_mac(dev, mac);
 
 	if (virtio_user_dev_setup(dev) < 0) {
@@ -309,6 +352,15 @@ virtio_user_dev_init(struct virtio_user_dev *dev, char *path, int queues,
 		dev->device_features &= ~(1ull << VIRTIO_NET_F_CTRL_MAC_ADDR);
 	}
 
+	if (!packed_vq)
+		dev->device_features &= ~(1ull << VIRTIO_F_RING_PACKED);
+
+	if (rte_mem_event_callback_register(virtio_user_mem_event_cb,
+					    dev) < 0) {
+		PMD_INIT_LOG(ERR, "cannot register memory event callback");
+		return -1;
+	}
+
 	return 0;
 }
 
@@ -317,6 +369,8 @@ virtio_user_dev_uninit(struct virtio_user_dev *dev)
 {
 	uint32_t i;
 
+	rte_mem_event_callback_unregister(virtio_user_mem_event_cb, dev);
+
 	virtio_user_stop_device(dev);
 
 	close(dev->vhostfd);
@@ -341,10 +395,12 @@ virtio_user_handle_mq(struct virtio_user_dev *dev, uint16_t q_pairs)
 		return -1;
 	}
 
+	pthread_mutex_lock(&dev->mutex);
 	for (i = 0; i < q_pairs; ++i)
 		ret |= dev->ops->enable_qp(dev, i, 1);
 	for (i = q_pairs; i < dev->max_queue_pairs; ++i)
 		ret |= dev->ops->enable_qp(dev, i, 0);
+	pthread_mutex_unlock(&dev->mutex);
 
 	dev->queue_pairs = q_pairs;
 
@@ -412,3 +468,82 @@ virtio_user_handle_cq(struct virtio_user_dev *dev, uint16_t queue_idx)
 		vring->used->idx++;
 	}
 }
+
+static inline int
+desc_is_avail(struct vring_packed_desc *desc, uint8_t wrap_counter)
+{
+	uint16_t flags = *((volatile uint16_t *)&desc->flags);
+
+	return !!(flags & VRING_DESC_F_AVAIL) == wrap_counter &&
+		!!(flags & VRING_DESC_F_USED) != wrap_counter;
+}
+
+static uint32_t
+virtio_user_handle_ctrl_msg_packed(struct virtio_user_dev *dev,
+				   struct vring_packed *vring,
+				   uint16_t idx_hdr)
+{
+	struct virtio_net_ctrl_hdr *hdr;
+	virtio_net_ctrl_ack status = ~0;
+	uint16_t idx_data, idx_status;
+	uint32_t n_descs = 0;
+
+	/* the descriptors of a chain take consecutive slots */
+	idx_data = (idx_hdr + 1) & (vring->num - 1);
+	n_descs++;
+
+	idx_status = idx_data;
+	while (vring->desc[idx_status].flags & VRING_DESC_F_NEXT) {
+		idx_status = (idx_status + 1) & (vring->num - 1);
+		n_descs++;
+	}
+	n_descs++;
+
+	hdr = (void *)(uintptr_t)vring->desc[idx_hdr].addr;
+	if (hdr->class == VIRTIO_NET_CTRL_MQ &&
+	    hdr->cmd == VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET) {
+		uint16_t queues;
+
+		queues = *(uint16_t *)(uintptr_t)vring->desc[idx_data].addr;
+		status = virtio_user_handle_mq(dev, queues);
+	}
+
+	/* Update status */
+	*(virtio_net_ctrl_ack *)(uintptr_t)vring->desc[idx_status].addr = status;
+
+	/* the buffer ID of a chain is the one of its last descriptor */
+	vring->desc[idx_hdr].id = vring->desc[idx_status].id;
+
+	return n_descs;
+}
+
+void
+virtio_user_handle_cq_packed(struct virtio_user_dev *dev, uint16_t queue_idx)
+{
+	struct vring_packed *vring = &dev->packed_vrings[queue_idx];
+	uint16_t *used_idx = &dev->packed_queues[queue_idx].used_idx;
+	uint8_t *wrap = &dev->packed_queues[queue_idx].used_wrap_counter;
+	struct vring_packed_desc *desc;
+	uint32_t n_descs;
+	uint16_t flags;
+
+	while (desc_is_avail(&vring->desc[*used_idx], *wrap)) {
+		desc = &vring->desc[*used_idx];
+		rte_rmb();
+
+		n_descs = virtio_user_handle_ctrl_msg_packed(dev, vring,
+							     *used_idx);
+
+		/* Mark the chain used, in its head slot */
+		desc->len = n_descs;
+		flags = *wrap ? VRING_DESC_F_AVAIL | VRING_DESC_F_USED : 0;
+		rte_wmb();
+		desc->flags = flags;
+
+		*used_idx += n_descs;
+		if (*used_idx >= vring->num) {
+			*used_idx -= vring->num;
+			*wrap ^= 1;
+		}
+	}
+}
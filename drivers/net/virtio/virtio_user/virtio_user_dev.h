@@ -35,6 +35,7 @@
 #define _VIRTIO_USER_DEV_H
 
 #include <limits.h>
+#include <pthread.h>
 #include "../virtio_pci.h"
 #include "../virtio_ring.h"
 #include "vhost.h"
@@ -60,16 +61,30 @@ struct virtio_user_dev {
 				   */
 	uint64_t	device_features; /* supported features by device */
 	uint8_t		status;
+	uint8_t		started;
 	uint8_t		mac_addr[ETHER_ADDR_LEN];
 	char		path[PATH_MAX];
-	struct vring	vrings[VIRTIO_MAX_VIRTQUEUES * 2 + 1];
+	union {
+		struct vring		vrings[VIRTIO_MAX_VIRTQUEUES * 2 + 1];
+		struct vring_packed	packed_vrings[VIRTIO_MAX_VIRTQUEUES * 2 + 1];
+	};
+	/* device side state of the packed rings processed here (ctrl queue) */
+	struct {
+		uint16_t used_idx;
+		uint8_t used_wrap_counter;
+	} packed_queues[VIRTIO_MAX_VIRTQUEUES * 2 + 1];
 	struct virtio_user_backend_ops *ops;
+	/* serializes the requests sent on memory changes with the others */
+	pthread_mutex_t	mutex;
 };
 
 int virtio_user_start_device(struct virtio_user_dev *dev);
 int virtio_user_stop_device(struct virtio_user_dev *dev);
 int virtio_user_dev_init(struct virtio_user_dev *dev, char *path, int queues,
-			 int cq, int queue_size, const char *mac);
+			 int cq, int queue_size, const char *mac,
+			 int packed_vq);
 void virtio_user_dev_uninit(struct virtio_user_dev *dev);
 void virtio_user_handle_cq(struct virtio_user_dev *dev, uint16_t queue_idx);
+void virtio_user_handle_cq_packed(struct virtio_user_dev *dev,
+				  uint16_t queue_idx);
 #endif
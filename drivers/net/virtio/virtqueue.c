@@ -59,3 +59,27 @@ virtqueue_detatch_unused(struct virtqueue *vq)
 		}
 	return NULL;
 }
+
+uint16_t
+virtqueue_nused_packed(struct virtqueue *vq)
+{
+	struct vring_packed_desc *desc = vq->vq_packed.desc;
+	uint16_t idx = vq->vq_used_cons_idx;
+	uint8_t wrap = vq->vq_used_wrap_counter;
+	uint16_t nused = 0, ndescs;
+
+	while (nused < vq->vq_nentries && desc_is_used(&desc[idx], wrap)) {
+		virtio_rmb();
+		ndescs = vq->vq_descx[desc[idx].id].ndescs;
+		if (ndescs == 0)
+			break;
+		nused++;
+		idx += ndescs;
+		if (idx >= vq->vq_nentries) {
+			idx -= vq->vq_nentries;
+			wrap ^= 1;
+		}
+	}
+
+	return nused;
+}
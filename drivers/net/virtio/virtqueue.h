@@ -174,20 +174,29 @@ struct virtio_pmd_ctrl {
 struct vq_desc_extra {
 	void *cookie;
 	uint16_t ndescs;
+	uint16_t next; /**< next free buffer ID, packed ring only */
 };
 
 struct virtqueue {
 	struct virtio_hw  *hw; /**< virtio_hw structure pointer. */
-	struct vring vq_ring;  /**< vring keeping desc, used and avail */
+	union {
+		struct vring vq_ring;  /**< vring keeping desc, used and avail */
+		struct vring_packed vq_packed; /**< packed ring */
+	};
 	/**
 	 * Last consumed descriptor in the used table,
 	 * trails vq_ring.used->idx.
+	 * With a packed ring, next descriptor slot to be used by the device.
 	 */
 	uint16_t vq_used_cons_idx;
 	uint16_t vq_nentries;  /**< vring desc numbers */
 	uint16_t vq_free_cnt;  /**< num of desc available */
-	uint16_t vq_avail_idx; /**< sync until needed */
+	uint16_t vq_avail_idx; /**< sync until needed, next slot if packed */
 	uint16_t vq_free_thresh; /**< free threshold */
+	/** AVAIL/USED bits of the descriptors made available, packed ring */
+	uint16_t vq_avail_flags;
+	/** Wrap counter of the used descriptors, packed ring */
+	uint8_t vq_used_wrap_counter;
 
 	void *vq_ring_virt_mem;  /**< linear address of vring*/
 	unsigned int vq_ring_size;
@@ -205,6 +214,7 @@ struct virtqueue {
 	 * Head of the free chain in the descriptor table. If
 	 * there are no free descriptors, this will be set to
 	 * VQ_RING_DESC_CHAIN_END.
+	 * With a packed ring, head of the free buffer ID list.
 	 */
 	uint16_t  vq_desc_head_idx;
 	uint16_t  vq_desc_tail_idx;
@@ -271,13 +281,27 @@ vring_desc_init(struct vring_desc *dp, uint16_t n)
 	dp[i].next = VQ_RING_DESC_CHAIN_END;
 }
 
+/* Chain all the buffer IDs of a packed ring with an END */
+static inline void
+vring_packed_id_init(struct vq_desc_extra *dxp, uint16_t n)
+{
+	uint16_t i;
+
+	for (i = 0; i < n - 1; i++)
+		dxp[i].next = (uint16_t)(i + 1);
+	dxp[i].next = VQ_RING_DESC_CHAIN_END;
+}
+
 /**
  * Tell the backend not to interrupt us.
  */
 static inline void
 virtqueue_disable_intr(struct virtqueue *vq)
 {
-	vq->vq_ring.avail->flags |= VRING_AVAIL_F_NO_INTERRUPT;
+	if (vtpci_packed_queue(vq->hw))
+		vq->vq_packed.driver->flags = VRING_EVENT_F_DISABLE;
+	else
+		vq->vq_ring.avail->flags |= VRING_AVAIL_F_NO_INTERRUPT;
 }
 
 /**
@@ -286,7 +310,10 @@ virtqueue_disable_intr(struct virtqueue *vq)
 static inline void
 virtqueue_enable_intr(struct virtqueue *vq)
 {
-	vq->vq_ring.avail->flags &= (~VRING_AVAIL_F_NO_INTERRUPT);
+	if (vtpci_packed_queue(vq->hw))
+		vq->vq_packed.driver->flags = VRING_EVENT_F_ENABLE;
+	else
+		vq->vq_ring.avail->flags &= (~VRING_AVAIL_F_NO_INTERRUPT);
 }
 
 /**
@@ -306,6 +333,59 @@ virtqueue_full(const struct virtqueue *vq)
 
 #define VIRTQUEUE_NUSED(vq) ((uint16_t)((vq)->vq_ring.used->idx - (vq)->vq_used_cons_idx))
 
+/**
+ *  Count the used buffers of a packed ring, walking the descriptors.
+ */
+uint16_t virtqueue_nused_packed(struct virtqueue *vq);
+
+static inline uint16_t
+virtqueue_nused(struct virtqueue *vq)
+{
+	if (vtpci_packed_queue(vq->hw))
+		return virtqueue_nused_packed(vq);
+	return VIRTQUEUE_NUSED(vq);
+}
+
+/* A packed descriptor is used when its AVAIL and USED bits match wrap. */
+static inline int
+desc_is_used(struct vring_packed_desc *desc, uint8_t wrap)
+{
+	uint16_t flags = *(volatile uint16_t *)&desc->flags;
+
+	return !!(flags & VRING_DESC_F_AVAIL) == wrap &&
+		!!(flags & VRING_DESC_F_USED) == wrap;
+}
+
+/* Move to the next packed descriptor slot to make available. */
+static inline void
+vq_packed_avail_next(struct virtqueue *vq)
+{
+	if (++vq->vq_avail_idx >= vq->vq_nentries) {
+		vq->vq_avail_idx = 0;
+		vq->vq_avail_flags ^= VRING_DESC_F_AVAIL_USED;
+	}
+}
+
+/*
+ * Give back the buffer ID of a used packed chain, and skip the descriptor
+ * slots of the chain: the device writes one used descriptor per buffer.
+ */
+static inline void
+vq_packed_free_id(struct virtqueue *vq, uint16_t id)
+{
+	struct vq_desc_extra *dxp = &vq->vq_descx[id];
+
+	vq->vq_free_cnt = (uint16_t)(vq->vq_free_cnt + dxp->ndescs);
+	vq->vq_used_cons_idx += dxp->ndescs;
+	if (vq->vq_used_cons_idx >= vq->vq_nentries) {
+		vq->vq_used_cons_idx -= vq->vq_nentries;
+		vq->vq_used_wrap_counter ^= 1;
+	}
+	dxp->ndescs = 0;
+	dxp->next = vq->vq_desc_head_idx;
+	vq->vq_desc_head_idx = id;
+}
+
 static inline void
 vq_update_avail_idx(struct virtqueue *vq)
 {
@@ -336,6 +416,15 @@ virtqueue_kick_prepare(struct virtqueue *vq)
 	return !(vq->vq_ring.used->flags & VRING_USED_F_NO_NOTIFY);
 }
 
+static inline int
+virtqueue_kick_prepare_packed(struct virtqueue *vq)
+{
+	/* order the descriptor writes with the read of the device flags */
+	virtio_mb();
+	return *(volatile uint16_t *)&vq->vq_packed.device->flags !=
+		VRING_EVENT_F_DISABLE;
+}
+
 static inline void
 virtqueue_notify(struct virtqueue *vq)
 {
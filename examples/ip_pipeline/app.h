@@ -305,6 +305,11 @@ struct app_thread_pipeline_data {
 	pipeline_be_op_timer f_timer;
 	uint64_t timer_period;
 	uint64_t deadline;
+
+	/* Cycles spent on runs that processed at least one packet since the
+	 * pipeline was enabled on the thread (regular pipelines only) */
+	uint64_t busy_cycles;
+	uint64_t enable_time;
 };
 
 #ifndef APP_MAX_THREAD_PIPELINES
@@ -333,6 +338,13 @@ struct app_thread_data {
 	uint64_t headroom_time;
 	uint64_t headroom_cycles;
 	double headroom_ratio;
+
+	/* Start of the pipeline load measurement */
+	uint64_t load_time;
+
+	/* Cycles spent by the custom pipelines on runs that processed at least
+	 * one packet since the start of the load measurement */
+	uint64_t custom_busy_cycles;
 } __rte_cache_aligned;
 
 #ifndef APP_MAX_LINKS
@@ -491,6 +503,62 @@ struct app_eal_params {
 #define APP_THREAD_HEADROOM_STATS_COLLECT        1
 #endif
 
+/* Headroom and load stats: one out of this many pipeline runs is timed */
+#ifndef APP_THREAD_STATS_SAMPLE_PERIOD
+#define APP_THREAD_STATS_SAMPLE_PERIOD           16
+#endif
+
+/* Thread load balancer: evaluation period (milliseconds) */
+#ifndef APP_THREAD_BALANCE_PERIOD
+#define APP_THREAD_BALANCE_PERIOD                1000
+#endif
+
+/* Thread load balancer: thread load above which pipelines are spread out */
+#ifndef APP_THREAD_BALANCE_LOAD_HIGH
+#define APP_THREAD_BALANCE_LOAD_HIGH             0.85
+#endif
+
+/* Thread load balancer: thread load below which pipelines are packed */
+#ifndef APP_THREAD_BALANCE_LOAD_LOW
+#define APP_THREAD_BALANCE_LOAD_LOW              0.25
+#endif
+
+/* Thread load balancer: number of periods a migrated pipeline stays put */
+#ifndef APP_THREAD_BALANCE_HOLD_PERIODS
+#define APP_THREAD_BALANCE_HOLD_PERIODS          5
+#endif
+
+/*
+ * The thread load counters are never reset, so that each load reader (CLI,
+ * balancer) computes the load since its own previous read.
+ */
+struct app_thread_load_reader {
+	uint64_t thread_time[APP_MAX_THREADS];
+	uint64_t thread_custom_busy_cycles[APP_MAX_THREADS];
+	uint64_t pipeline_time[APP_MAX_PIPELINES];
+	uint64_t pipeline_busy_cycles[APP_MAX_PIPELINES];
+};
+
+struct app_thread_balance {
+	uint32_t enabled;
+	uint64_t period;
+	uint64_t deadline;
+	double load_high;
+	double load_low;
+	uint32_t hold_periods;
+
+	/* Balancer period at which each pipeline can be migrated again */
+	uint64_t n_periods;
+	uint64_t pipeline_hold[APP_MAX_PIPELINES];
+
+	/* Load read by the balancer */
+	struct app_thread_load_reader load;
+	uint32_t load_valid;
+
+	/* Statistics */
+	uint64_t n_migrations;
+};
+
 #define APP_CORE_MASK_SIZE					\
 	(RTE_MAX_LCORE / 64 + ((RTE_MAX_LCORE % 64) ? 1 : 0))
 
@@ -549,6 +617,8 @@ struct app_params {
 	struct pipeline_type pipeline_type[APP_MAX_PIPELINE_TYPES];
 	struct app_pipeline_data pipeline_data[APP_MAX_PIPELINES];
 	struct app_thread_data thread_data[APP_MAX_THREADS];
+	struct app_thread_balance thread_balance;
+	struct app_thread_load_reader thread_load_cli;
 	cmdline_parse_ctx_t cmds[APP_MAX_CMDS + 1];
 
 	int eal_argc;
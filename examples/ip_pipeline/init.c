@@ -1760,6 +1760,8 @@ app_init_threads(struct app_params *app)
 		t->headroom_cycles = 0;
 		t->headroom_time = rte_get_tsc_cycles();
 		t->headroom_ratio = 0.0;
+		t->load_time = t->headroom_time;
+		t->custom_busy_cycles = 0;
 
 		t->msgq_in = app_thread_msgq_in_get(app,
 				params->socket_id,
@@ -1792,6 +1794,8 @@ app_init_threads(struct app_params *app)
 		p->f_timer = ptype->be_ops->f_timer;
 		p->timer_period = data->timer_period;
 		p->deadline = time + data->timer_period;
+		p->busy_cycles = 0;
+		p->enable_time = time;
 
 		data->enabled = 1;
 
@@ -1800,6 +1804,15 @@ app_init_threads(struct app_params *app)
 		else
 			t->n_custom++;
 	}
+
+	/* Thread load balancer, disabled until requested through the CLI */
+	app->thread_balance.enabled = 0;
+	app->thread_balance.period =
+		(rte_get_tsc_hz() * APP_THREAD_BALANCE_PERIOD) / 1000;
+	app->thread_balance.deadline = time + app->thread_balance.period;
+	app->thread_balance.load_high = APP_THREAD_BALANCE_LOAD_HIGH;
+	app->thread_balance.load_low = APP_THREAD_BALANCE_LOAD_LOW;
+	app->thread_balance.hold_periods = APP_THREAD_BALANCE_HOLD_PERIODS;
 }
 
 int app_init(struct app_params *app)
@@ -43,6 +43,7 @@
 #include <cmdline.h>
 
 #include "app.h"
+#include "thread_fe.h"
 #include "pipeline_master_be.h"
 
 struct pipeline_master {
@@ -153,6 +154,9 @@ pipeline_run(void *pipeline)
 		rte_kni_handle_request(app->kni[i]);
 #endif /* RTE_LIBRTE_KNI */
 
+	/* Thread load balancer */
+	app_thread_balance_poll(app);
+
 	return 0;
 }
 
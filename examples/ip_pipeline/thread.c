@@ -41,37 +41,62 @@
 
 #if APP_THREAD_HEADROOM_STATS_COLLECT
 
-#define PIPELINE_RUN_REGULAR(thread, pipeline)		\
+/*
+ * Only the runs of the sampled loop iterations are timed, each of them
+ * accounting for APP_THREAD_STATS_SAMPLE_PERIOD runs.
+ */
+#define PIPELINE_RUN_REGULAR(thread, data, sample)	\
 do {							\
-	uint64_t t0 = rte_rdtsc_precise();		\
-	int n_pkts = rte_pipeline_run(pipeline->p);	\
-							\
-	if (n_pkts == 0) {				\
-		uint64_t t1 = rte_rdtsc_precise();	\
+	struct pipeline *p = data->be;			\
+	uint64_t t0, t1;				\
+	int n_pkts;					\
 							\
-		thread->headroom_cycles += t1 - t0;	\
+	if (!(sample)) {				\
+		rte_pipeline_run(p->p);			\
+		break;					\
 	}						\
+							\
+	t0 = rte_rdtsc_precise();			\
+	n_pkts = rte_pipeline_run(p->p);		\
+	t1 = rte_rdtsc_precise();			\
+							\
+	if (n_pkts == 0)				\
+		thread->headroom_cycles +=		\
+			(t1 - t0) * APP_THREAD_STATS_SAMPLE_PERIOD; \
+	else						\
+		data->busy_cycles +=			\
+			(t1 - t0) * APP_THREAD_STATS_SAMPLE_PERIOD; \
 } while (0)
 
 
-#define PIPELINE_RUN_CUSTOM(thread, data)		\
+#define PIPELINE_RUN_CUSTOM(thread, data, sample)	\
 do {							\
-	uint64_t t0 = rte_rdtsc_precise();		\
-	int n_pkts = data->f_run(data->be);		\
-							\
-	if (n_pkts == 0) {				\
-		uint64_t t1 = rte_rdtsc_precise();	\
+	uint64_t t0, t1;				\
+	int n_pkts;					\
 							\
-		thread->headroom_cycles += t1 - t0;	\
+	if (!(sample)) {				\
+		data->f_run(data->be);			\
+		break;					\
 	}						\
+							\
+	t0 = rte_rdtsc_precise();			\
+	n_pkts = data->f_run(data->be);			\
+	t1 = rte_rdtsc_precise();			\
+							\
+	if (n_pkts == 0)				\
+		thread->headroom_cycles +=		\
+			(t1 - t0) * APP_THREAD_STATS_SAMPLE_PERIOD; \
+	else						\
+		thread->custom_busy_cycles +=		\
+			(t1 - t0) * APP_THREAD_STATS_SAMPLE_PERIOD; \
 } while (0)
 
 #else
 
-#define PIPELINE_RUN_REGULAR(thread, pipeline)		\
-	rte_pipeline_run(pipeline->p)
+#define PIPELINE_RUN_REGULAR(thread, data, sample)	\
+	rte_pipeline_run(((struct pipeline *) data->be)->p)
 
-#define PIPELINE_RUN_CUSTOM(thread, data)		\
+#define PIPELINE_RUN_CUSTOM(thread, data, sample)	\
 	data->f_run(data->be)
 
 #endif
@@ -123,6 +148,8 @@ thread_pipeline_enable(struct app_thread_data *t,
 	p->f_timer = req->f_timer;
 	p->timer_period = req->timer_period;
 	p->deadline = 0;
+	p->busy_cycles = 0;
+	p->enable_time = rte_rdtsc_precise();
 
 	if (req->f_run == NULL)
 		t->n_regular++;
@@ -142,9 +169,16 @@ thread_pipeline_disable(struct app_thread_data *t,
 
 	/* search regular pipelines of current thread */
 	for (i = 0; i < n_regular; i++) {
+		struct pipeline *p;
+
 		if (t->regular[i].pipeline_id != req->pipeline_id)
 			continue;
 
+		/* Push out the packets buffered by the output ports, as the
+		 * pipeline might be resumed later on by a different thread */
+		p = t->regular[i].be;
+		rte_pipeline_flush(p->p);
+
 		if (i < n_regular - 1)
 			memcpy(&t->regular[i],
 			  &t->regular[i+1],
@@ -176,6 +210,33 @@ thread_pipeline_disable(struct app_thread_data *t,
 	return -1;
 }
 
+#if APP_THREAD_HEADROOM_STATS_COLLECT
+
+/* Pipeline load counters, left untouched for the other readers */
+static void
+thread_pipeline_load_read(struct app_thread_data *t,
+	struct thread_pipeline_load_read_msg_rsp *rsp)
+{
+	uint32_t n_regular = RTE_MIN(t->n_regular, RTE_DIM(t->regular));
+	uint32_t i;
+
+	rsp->time = rte_rdtsc_precise();
+	rsp->start_time = t->load_time;
+
+	for (i = 0; i < n_regular; i++) {
+		struct app_thread_pipeline_data *data = &t->regular[i];
+
+		rsp->pipeline_id[i] = data->pipeline_id;
+		rsp->busy_cycles[i] = data->busy_cycles;
+		rsp->enable_time[i] = data->enable_time;
+	}
+	rsp->n_pipelines = n_regular;
+
+	rsp->custom_busy_cycles = t->custom_busy_cycles;
+}
+
+#endif
+
 static int
 thread_msg_req_handle(struct app_thread_data *t)
 {
@@ -213,6 +274,22 @@ thread_msg_req_handle(struct app_thread_data *t)
 			thread_msg_send(t->msgq_out, rsp);
 			break;
 		}
+		case THREAD_MSG_REQ_PIPELINE_LOAD_READ: {
+			struct thread_pipeline_load_read_msg_rsp *rsp =
+				(struct thread_pipeline_load_read_msg_rsp *)
+				req;
+
+#if APP_THREAD_HEADROOM_STATS_COLLECT
+			thread_pipeline_load_read(t, rsp);
+			rsp->status = 0;
+#else
+			/* The load is not measured */
+			rsp->status = -1;
+#endif
+			thread_msg_send(t->msgq_out, rsp);
+			break;
+		}
+
 		default:
 			break;
 		}
@@ -243,19 +320,21 @@ app_thread(void *arg)
 		uint32_t n_regular = RTE_MIN(t->n_regular, RTE_DIM(t->regular));
 		uint32_t n_custom = RTE_MIN(t->n_custom, RTE_DIM(t->custom));
 
+		__rte_unused int sample =
+			(i % APP_THREAD_STATS_SAMPLE_PERIOD) == 0;
+
 		/* Run regular pipelines */
 		for (j = 0; j < n_regular; j++) {
 			struct app_thread_pipeline_data *data = &t->regular[j];
-			struct pipeline *p = data->be;
 
-			PIPELINE_RUN_REGULAR(t, p);
+			PIPELINE_RUN_REGULAR(t, data, sample);
 		}
 
 		/* Run custom pipelines */
 		for (j = 0; j < n_custom; j++) {
 			struct app_thread_pipeline_data *data = &t->custom[j];
 
-			PIPELINE_RUN_CUSTOM(t, data);
+			PIPELINE_RUN_CUSTOM(t, data, sample);
 		}
 
 		/* Timer */
@@ -41,6 +41,7 @@ enum thread_msg_req_type {
 	THREAD_MSG_REQ_PIPELINE_ENABLE = 0,
 	THREAD_MSG_REQ_PIPELINE_DISABLE,
 	THREAD_MSG_REQ_HEADROOM_READ,
+	THREAD_MSG_REQ_PIPELINE_LOAD_READ,
 	THREAD_MSG_REQS
 };
 
@@ -95,4 +96,28 @@ struct thread_headroom_read_msg_rsp {
 	double headroom_ratio;
 };
 
+/*
+ * PIPELINE LOAD
+ */
+struct thread_pipeline_load_read_msg_req {
+	enum thread_msg_req_type type;
+};
+
+struct thread_pipeline_load_read_msg_rsp {
+	int status;
+
+	/* Time of the read and start of the thread load measurement */
+	uint64_t time;
+	uint64_t start_time;
+
+	/* Regular pipelines currently run by the thread */
+	uint32_t n_pipelines;
+	uint32_t pipeline_id[APP_MAX_THREAD_PIPELINES];
+	uint64_t busy_cycles[APP_MAX_THREAD_PIPELINES];
+	uint64_t enable_time[APP_MAX_THREAD_PIPELINES];
+
+	/* Custom pipelines of the thread */
+	uint64_t custom_busy_cycles;
+};
+
 #endif /* THREAD_H_ */
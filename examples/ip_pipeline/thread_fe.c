@@ -214,6 +214,413 @@ app_thread_headroom(struct app_params *app,
 	return 0;
 }
 
+/* Pipeline load measured since the previous read by the same reader */
+struct app_thread_load {
+	uint32_t n_pipelines;
+	uint32_t pipeline_id[APP_MAX_THREAD_PIPELINES];
+	double load_ratio[APP_MAX_THREAD_PIPELINES];
+
+	/* Load of all the pipelines (regular and custom) of the thread */
+	double thread_load_ratio;
+};
+
+static void
+app_thread_load_compute(struct app_thread_load_reader *reader,
+	uint32_t thread_id,
+	struct thread_pipeline_load_read_msg_rsp *rsp,
+	struct app_thread_load *load)
+{
+	uint64_t time, busy_cycles;
+	uint32_t i;
+
+	load->thread_load_ratio = 0.0;
+	load->n_pipelines = 0;
+
+	for (i = 0; i < rsp->n_pipelines; i++) {
+		uint32_t id = rsp->pipeline_id[i];
+
+		if (id >= APP_MAX_PIPELINES)
+			continue;
+
+		/* Pipeline enabled on this thread since the previous read */
+		time = reader->pipeline_time[id];
+		busy_cycles = reader->pipeline_busy_cycles[id];
+		if (time < rsp->enable_time[i]) {
+			time = rsp->enable_time[i];
+			busy_cycles = 0;
+		}
+
+		load->pipeline_id[load->n_pipelines] = id;
+		load->load_ratio[load->n_pipelines] = (rsp->time > time) ?
+			((double) (rsp->busy_cycles[i] - busy_cycles)) /
+			((double) (rsp->time - time)) : 0.0;
+		load->thread_load_ratio +=
+			load->load_ratio[load->n_pipelines];
+		load->n_pipelines++;
+
+		reader->pipeline_time[id] = rsp->time;
+		reader->pipeline_busy_cycles[id] = rsp->busy_cycles[i];
+	}
+
+	time = reader->thread_time[thread_id];
+	busy_cycles = reader->thread_custom_busy_cycles[thread_id];
+	if (time < rsp->start_time) {
+		time = rsp->start_time;
+		busy_cycles = 0;
+	}
+
+	if (rsp->time > time)
+		load->thread_load_ratio +=
+			((double) (rsp->custom_busy_cycles - busy_cycles)) /
+			((double) (rsp->time - time));
+
+	reader->thread_time[thread_id] = rsp->time;
+	reader->thread_custom_busy_cycles[thread_id] = rsp->custom_busy_cycles;
+}
+
+static int
+app_thread_pipeline_load_read(struct app_params *app,
+		struct app_thread_load_reader *reader,
+		uint32_t socket_id,
+		uint32_t core_id,
+		uint32_t hyper_th_id,
+		struct app_thread_load *load)
+{
+	struct thread_pipeline_load_read_msg_req *req;
+	struct thread_pipeline_load_read_msg_rsp *rsp;
+	int thread_id;
+	int status;
+
+	if (app == NULL)
+		return -1;
+
+	thread_id = cpu_core_map_get_lcore_id(app->core_map,
+			socket_id,
+			core_id,
+			hyper_th_id);
+
+	if ((thread_id < 0) || !app_core_is_enabled(app, thread_id))
+		return -1;
+
+	req = app_msg_alloc(app);
+	if (req == NULL)
+		return -1;
+
+	req->type = THREAD_MSG_REQ_PIPELINE_LOAD_READ;
+
+	rsp = thread_msg_send_recv(app,
+		socket_id, core_id, hyper_th_id, req, MSG_TIMEOUT_DEFAULT);
+
+	if (rsp == NULL)
+		return -1;
+
+	status = rsp->status;
+	if (status == 0)
+		app_thread_load_compute(reader, thread_id, rsp, load);
+
+	app_msg_free(app, rsp);
+
+	return (status == 0) ? 0 : -1;
+}
+
+int
+app_thread_pipeline_load(struct app_params *app,
+		uint32_t socket_id,
+		uint32_t core_id,
+		uint32_t hyper_th_id)
+{
+	struct app_thread_load load;
+	uint32_t i;
+
+	if (app_thread_pipeline_load_read(app,
+			&app->thread_load_cli,
+			socket_id,
+			core_id,
+			hyper_th_id,
+			&load) != 0)
+		return -1;
+
+	printf("Thread load: %.3f%%\n", load.thread_load_ratio * 100);
+	for (i = 0; i < load.n_pipelines; i++)
+		printf("\tPIPELINE%" PRIu32 ": %.3f%%\n",
+			load.pipeline_id[i],
+			load.load_ratio[i] * 100);
+
+	return 0;
+}
+
+/*
+ * Thread load balancer
+ *
+ * Periodically reads the load of each regular pipeline, measured by its
+ * thread as the share of cycles spent on runs that processed packets, and
+ * migrates at most one pipeline per period:
+ *    1. Spread: when a thread is above the high load threshold, one of its
+ *       pipelines is moved to the least loaded thread;
+ *    2. Pack: otherwise, when a thread is below the low load threshold, one
+ *       of its pipelines is moved to the busiest thread that can take it.
+ * A migration never takes the destination thread above the middle of the
+ * [low, high] interval, and a migrated pipeline is not migrated again for
+ * a number of periods, which prevents the pipelines from bouncing between
+ * threads.
+ *
+ * Only the threads of the configured pipelines are considered, except for
+ * those running custom pipelines (e.g. the master pipeline).
+ */
+
+struct app_thread_balance_thread {
+	uint32_t socket_id;
+	uint32_t core_id;
+	uint32_t hyper_th_id;
+	uint32_t n_pipelines;
+	double load;
+};
+
+static int
+app_thread_balance_migrate(struct app_params *app,
+	struct app_thread_balance_thread *src,
+	struct app_thread_balance_thread *dst,
+	uint32_t pipeline_id,
+	double pipeline_load)
+{
+	struct app_thread_balance *b = &app->thread_balance;
+	int status;
+
+	/*
+	 * Hitless handover: once the source thread acknowledges the disable
+	 * request, it no longer runs the pipeline and the packets buffered by
+	 * the pipeline output ports have been flushed. The packets arriving in
+	 * the meantime wait in the input queues until the destination thread
+	 * picks up the pipeline.
+	 */
+	status = app_pipeline_disable(app,
+		src->socket_id,
+		src->core_id,
+		src->hyper_th_id,
+		pipeline_id);
+	if (status)
+		return status;
+
+	status = app_pipeline_enable(app,
+		dst->socket_id,
+		dst->core_id,
+		dst->hyper_th_id,
+		pipeline_id);
+	if (status) {
+		/* Resume the pipeline on its previous thread */
+		app_pipeline_enable(app,
+			src->socket_id,
+			src->core_id,
+			src->hyper_th_id,
+			pipeline_id);
+		return status;
+	}
+
+	APP_LOG(app, HIGH, "Balancer: PIPELINE%" PRIu32 " (load %.1f%%) "
+		"moved from s%" PRIu32 "c%" PRIu32 "%s to s%" PRIu32 "c%" PRIu32
+		"%s",
+		pipeline_id, pipeline_load * 100,
+		src->socket_id, src->core_id, (src->hyper_th_id) ? "h" : "",
+		dst->socket_id, dst->core_id, (dst->hyper_th_id) ? "h" : "");
+
+	b->pipeline_hold[pipeline_id] = b->n_periods + b->hold_periods;
+	b->n_migrations++;
+
+	return 0;
+}
+
+int
+app_thread_balance(struct app_params *app)
+{
+	struct app_thread_balance *b = &app->thread_balance;
+	struct app_thread_balance_thread threads[APP_MAX_PIPELINES];
+	uint32_t pipeline_thread[APP_MAX_PIPELINES];
+	double pipeline_load[APP_MAX_PIPELINES];
+	uint8_t thread_listed[RTE_MAX_LCORE];
+	double load_max = (b->load_low + b->load_high) / 2;
+	uint32_t n_threads = 0, src, dst, i;
+	int pipeline_id;
+
+	if (app == NULL)
+		return -1;
+
+	b->n_periods++;
+
+	/* Threads running custom pipelines are left alone */
+	memset(thread_listed, 0, sizeof(thread_listed));
+	for (i = 0; i < app->n_pipelines; i++) {
+		struct app_pipeline_params *params = &app->pipeline_params[i];
+		struct pipeline_type *ptype;
+		int lcore_id;
+
+		lcore_id = cpu_core_map_get_lcore_id(app->core_map,
+			params->socket_id,
+			params->core_id,
+			params->hyper_th_id);
+		ptype = app_pipeline_type_find(app, params->type);
+		if ((lcore_id < 0) || (ptype == NULL))
+			return -1;
+
+		if (ptype->be_ops->f_run != NULL)
+			thread_listed[lcore_id] = 1;
+	}
+
+	/* Threads of the configured pipelines */
+	for (i = 0; i < app->n_pipelines; i++) {
+		struct app_pipeline_params *params = &app->pipeline_params[i];
+		int lcore_id;
+
+		lcore_id = cpu_core_map_get_lcore_id(app->core_map,
+			params->socket_id,
+			params->core_id,
+			params->hyper_th_id);
+		if (thread_listed[lcore_id])
+			continue;
+
+		thread_listed[lcore_id] = 1;
+		threads[n_threads].socket_id = params->socket_id;
+		threads[n_threads].core_id = params->core_id;
+		threads[n_threads].hyper_th_id = params->hyper_th_id;
+		threads[n_threads].n_pipelines = 0;
+		threads[n_threads].load = 0.0;
+		n_threads++;
+	}
+
+	if (n_threads < 2)
+		return 0;
+
+	/* Read the current load */
+	for (i = 0; i < APP_MAX_PIPELINES; i++)
+		pipeline_thread[i] = UINT32_MAX;
+
+	for (i = 0; i < n_threads; i++) {
+		struct app_thread_balance_thread *t = &threads[i];
+		struct app_thread_load load;
+		uint32_t j;
+
+		if (app_thread_pipeline_load_read(app,
+				&b->load,
+				t->socket_id,
+				t->core_id,
+				t->hyper_th_id,
+				&load) != 0)
+			return -1;
+
+		t->n_pipelines = load.n_pipelines;
+		t->load = load.thread_load_ratio;
+
+		for (j = 0; j < load.n_pipelines; j++) {
+			uint32_t id = load.pipeline_id[j];
+
+			if (id >= APP_MAX_PIPELINES)
+				continue;
+
+			pipeline_thread[id] = i;
+			pipeline_load[id] = load.load_ratio[j];
+		}
+	}
+
+	/* The first read after enable covers the time the balancer was off */
+	if (b->load_valid == 0) {
+		b->load_valid = 1;
+		return 0;
+	}
+
+	/* Spread: busiest thread above the high threshold */
+	src = UINT32_MAX;
+	for (i = 0; i < n_threads; i++)
+		if ((threads[i].load > b->load_high) &&
+			(threads[i].n_pipelines > 1) &&
+			((src == UINT32_MAX) ||
+			(threads[i].load > threads[src].load)))
+			src = i;
+
+	if (src != UINT32_MAX) {
+		dst = UINT32_MAX;
+		for (i = 0; i < n_threads; i++)
+			if ((i != src) && ((dst == UINT32_MAX) ||
+				(threads[i].load < threads[dst].load)))
+				dst = i;
+
+		/* Largest pipeline that fits on the destination thread */
+		pipeline_id = -1;
+		for (i = 0; i < APP_MAX_PIPELINES; i++)
+			if ((pipeline_thread[i] == src) &&
+				(b->pipeline_hold[i] <= b->n_periods) &&
+				(threads[dst].load + pipeline_load[i] <=
+				load_max) &&
+				((pipeline_id < 0) ||
+				(pipeline_load[i] > pipeline_load[pipeline_id])))
+				pipeline_id = i;
+
+		if (pipeline_id >= 0)
+			return app_thread_balance_migrate(app,
+				&threads[src],
+				&threads[dst],
+				pipeline_id,
+				pipeline_load[pipeline_id]);
+
+		return 0;
+	}
+
+	/* Pack: least loaded thread below the low threshold */
+	src = UINT32_MAX;
+	for (i = 0; i < n_threads; i++)
+		if ((threads[i].load < b->load_low) &&
+			(threads[i].n_pipelines > 0) &&
+			((src == UINT32_MAX) ||
+			(threads[i].load < threads[src].load)))
+			src = i;
+
+	if (src == UINT32_MAX)
+		return 0;
+
+	for (i = 0; i < APP_MAX_PIPELINES; i++) {
+		uint32_t j;
+
+		if ((pipeline_thread[i] != src) ||
+			(b->pipeline_hold[i] > b->n_periods))
+			continue;
+
+		/* Busiest thread already running pipelines that can take it */
+		dst = UINT32_MAX;
+		for (j = 0; j < n_threads; j++)
+			if ((j != src) &&
+				(threads[j].n_pipelines > 0) &&
+				(threads[j].load + pipeline_load[i] <=
+				load_max) &&
+				((dst == UINT32_MAX) ||
+				(threads[j].load > threads[dst].load)))
+				dst = j;
+
+		if (dst != UINT32_MAX)
+			return app_thread_balance_migrate(app,
+				&threads[src],
+				&threads[dst],
+				i,
+				pipeline_load[i]);
+	}
+
+	return 0;
+}
+
+void
+app_thread_balance_poll(struct app_params *app)
+{
+	struct app_thread_balance *b = &app->thread_balance;
+	uint64_t time;
+
+	if (b->enabled == 0)
+		return;
+
+	time = rte_get_tsc_cycles();
+	if (time < b->deadline)
+		return;
+
+	app_thread_balance(app);
+	b->deadline = rte_get_tsc_cycles() + b->period;
+}
+
 /*
  * pipeline enable
  */
@@ -425,11 +832,142 @@ static cmdline_parse_inst_t cmd_thread_headroom = {
 	},
 };
 
+/*
+ * thread pipeline load
+ */
+
+struct cmd_thread_load_result {
+	cmdline_fixed_string_t t_string;
+	cmdline_fixed_string_t t_id_string;
+	cmdline_fixed_string_t load_string;
+};
+
+static void
+cmd_thread_load_parsed(
+	void *parsed_result,
+	__rte_unused struct cmdline *cl,
+	 void *data)
+{
+	struct cmd_thread_load_result *params = parsed_result;
+	struct app_params *app = data;
+	int status;
+	uint32_t core_id, socket_id, hyper_th_id;
+
+	if (parse_pipeline_core(&socket_id,
+			&core_id,
+			&hyper_th_id,
+			params->t_id_string) != 0) {
+		printf("Command failed\n");
+		return;
+	}
+
+	status = app_thread_pipeline_load(app,
+			socket_id,
+			core_id,
+			hyper_th_id);
+
+	if (status != 0)
+		printf("Command failed\n");
+}
+
+static cmdline_parse_token_string_t cmd_thread_load_t_string =
+	TOKEN_STRING_INITIALIZER(struct cmd_thread_load_result,
+	t_string, "t");
+
+static cmdline_parse_token_string_t cmd_thread_load_t_id_string =
+	TOKEN_STRING_INITIALIZER(struct cmd_thread_load_result,
+	t_id_string, NULL);
+
+static cmdline_parse_token_string_t cmd_thread_load_load_string =
+	TOKEN_STRING_INITIALIZER(struct cmd_thread_load_result,
+		load_string, "load");
+
+static cmdline_parse_inst_t cmd_thread_load = {
+	.f = cmd_thread_load_parsed,
+	.data = NULL,
+	.help_str = "Display thread pipeline load",
+	.tokens = {
+		(void *)&cmd_thread_load_t_string,
+		(void *)&cmd_thread_load_t_id_string,
+		(void *)&cmd_thread_load_load_string,
+		NULL,
+	},
+};
+
+/*
+ * thread balance
+ */
+
+struct cmd_thread_balance_result {
+	cmdline_fixed_string_t t_string;
+	cmdline_fixed_string_t balance_string;
+	cmdline_fixed_string_t action_string;
+};
+
+static void
+cmd_thread_balance_parsed(
+	void *parsed_result,
+	__rte_unused struct cmdline *cl,
+	 void *data)
+{
+	struct cmd_thread_balance_result *params = parsed_result;
+	struct app_params *app = data;
+	struct app_thread_balance *b = &app->thread_balance;
+
+	if (strcmp(params->action_string, "enable") == 0) {
+		if (APP_THREAD_HEADROOM_STATS_COLLECT == 0) {
+			printf("Balancer requires "
+				"APP_THREAD_HEADROOM_STATS_COLLECT\n");
+			return;
+		}
+
+		b->deadline = rte_get_tsc_cycles() + b->period;
+		b->load_valid = 0;
+		b->enabled = 1;
+		return;
+	}
+
+	if (strcmp(params->action_string, "disable") == 0) {
+		b->enabled = 0;
+		return;
+	}
+
+	printf("Balancer %s, %" PRIu64 " migrations\n",
+		(b->enabled) ? "enabled" : "disabled",
+		b->n_migrations);
+}
+
+static cmdline_parse_token_string_t cmd_thread_balance_t_string =
+	TOKEN_STRING_INITIALIZER(struct cmd_thread_balance_result,
+	t_string, "t");
+
+static cmdline_parse_token_string_t cmd_thread_balance_balance_string =
+	TOKEN_STRING_INITIALIZER(struct cmd_thread_balance_result,
+	balance_string, "balance");
+
+static cmdline_parse_token_string_t cmd_thread_balance_action_string =
+	TOKEN_STRING_INITIALIZER(struct cmd_thread_balance_result,
+	action_string, "enable#disable#ls");
+
+static cmdline_parse_inst_t cmd_thread_balance = {
+	.f = cmd_thread_balance_parsed,
+	.data = NULL,
+	.help_str = "Thread load balancer enable, disable or status",
+	.tokens = {
+		(void *)&cmd_thread_balance_t_string,
+		(void *)&cmd_thread_balance_balance_string,
+		(void *)&cmd_thread_balance_action_string,
+		NULL,
+	},
+};
+
 
 static cmdline_parse_ctx_t thread_cmds[] = {
 	(cmdline_parse_inst_t *) &cmd_pipeline_enable,
 	(cmdline_parse_inst_t *) &cmd_pipeline_disable,
 	(cmdline_parse_inst_t *) &cmd_thread_headroom,
+	(cmdline_parse_inst_t *) &cmd_thread_load,
+	(cmdline_parse_inst_t *) &cmd_thread_balance,
 	NULL,
 };
 
@@ -98,4 +98,16 @@ app_thread_headroom(struct app_params *app,
 		uint32_t socket_id,
 		uint32_t hyper_th_id);
 
+int
+app_thread_pipeline_load(struct app_params *app,
+		uint32_t socket_id,
+		uint32_t core_id,
+		uint32_t hyper_th_id);
+
+int
+app_thread_balance(struct app_params *app);
+
+void
+app_thread_balance_poll(struct app_params *app);
+
 #endif /* THREAD_FE_H_ */
@@ -116,11 +116,17 @@ static struct rte_eth_conf port_conf = {
 #define PKT_TX_BURST_MAX                32
 #define TIME_TX_DRAIN                   200000ULL
 
+/* Interval between two throughput reports, in seconds */
+#define TIME_STATS_PERIOD               1
+
 static uint8_t port_rx;
 static uint8_t port_tx;
 static struct rte_mbuf *pkts_rx[PKT_RX_BURST_MAX];
 struct rte_eth_dev_tx_buffer *tx_buffer;
 
+/* Meter the packets of each burst with one bulk call (profile based meters) */
+static int app_bulk;
+
 struct rte_meter_srtcm_params app_srtcm_params[] = {
 	{.cir = 1000000 * 46,  .cbs = 2048, .ebs = 2048},
 };
@@ -133,6 +139,10 @@ struct rte_meter_trtcm_params app_trtcm_params[] = {
 
 FLOW_METER app_flows[APP_FLOWS_MAX];
 
+FLOW_PROFILE app_profiles[RTE_DIM(PARAMS)];
+FLOW_METER_RT app_flows_rt[APP_FLOWS_MAX];
+FLOW_PROFILE *app_flows_profile[APP_FLOWS_MAX];
+
 static int
 app_configure_flow_table(void)
 {
@@ -146,6 +156,20 @@ app_configure_flow_table(void)
 			return ret;
 	}
 
+	for (j = 0; j < RTE_DIM(PARAMS); j++) {
+		ret = FUNC_PROFILE_CONFIG(&app_profiles[j], &PARAMS[j]);
+		if (ret)
+			return ret;
+	}
+
+	for (i = 0, j = 0; i < APP_FLOWS_MAX;
+			i++, j = (j + 1) % RTE_DIM(PARAMS)) {
+		ret = FUNC_RT_CONFIG(&app_flows_rt[i], &app_profiles[j]);
+		if (ret)
+			return ret;
+		app_flows_profile[i] = &app_profiles[j];
+	}
+
 	return 0;
 }
 
@@ -176,14 +200,55 @@ app_pkt_handle(struct rte_mbuf *pkt, uint64_t time)
 	return action;
 }
 
+/* Meter the whole burst with one bulk call, then apply the policer */
+static inline void
+app_pkts_handle_bulk(struct rte_mbuf **pkts, enum policer_action *actions,
+	uint32_t n_pkts, uint64_t time)
+{
+	FLOW_METER_RT *flows[PKT_RX_BURST_MAX];
+	FLOW_PROFILE *profiles[PKT_RX_BURST_MAX];
+	uint32_t pkt_len[PKT_RX_BURST_MAX];
+	enum rte_meter_color input_color[PKT_RX_BURST_MAX];
+	enum rte_meter_color output_color[PKT_RX_BURST_MAX];
+	uint32_t i;
+
+	for (i = 0; i < n_pkts; i++) {
+		uint8_t *pkt_data = rte_pktmbuf_mtod(pkts[i], uint8_t *);
+		uint8_t flow_id = (uint8_t)(pkt_data[APP_PKT_FLOW_POS] &
+			(APP_FLOWS_MAX - 1));
+
+		flows[i] = &app_flows_rt[flow_id];
+		profiles[i] = app_flows_profile[flow_id];
+		pkt_len[i] = rte_pktmbuf_pkt_len(pkts[i]) -
+			sizeof(struct ether_hdr);
+		input_color[i] = (enum rte_meter_color)
+			pkt_data[APP_PKT_COLOR_POS];
+		/* color input is not used for blind modes */
+		output_color[i] = input_color[i];
+	}
+
+	FUNC_METER_BULK(flows, profiles, time, pkt_len, output_color, n_pkts);
+
+	/* Apply policing and set the output color */
+	for (i = 0; i < n_pkts; i++) {
+		actions[i] = policer_table[input_color[i]][output_color[i]];
+		app_set_pkt_color(rte_pktmbuf_mtod(pkts[i], uint8_t *),
+			actions[i]);
+	}
+}
+
 
 static __attribute__((noreturn)) int
 main_loop(__attribute__((unused)) void *dummy)
 {
 	uint64_t current_time, last_time = rte_rdtsc();
+	uint64_t stats_period = rte_get_tsc_hz() * TIME_STATS_PERIOD;
+	uint64_t stats_time = last_time, stats_pkts = 0;
 	uint32_t lcore_id = rte_lcore_id();
+	enum policer_action actions[PKT_RX_BURST_MAX];
 
-	printf("Core %u: port RX = %d, port TX = %d\n", lcore_id, port_rx, port_tx);
+	printf("Core %u: port RX = %d, port TX = %d, %s metering\n", lcore_id,
+		port_rx, port_tx, app_bulk ? "bulk" : "per packet");
 
 	while (1) {
 		uint64_t time_diff;
@@ -198,10 +263,37 @@ main_loop(__attribute__((unused)) void *dummy)
 			last_time = current_time;
 		}
 
+		/* Report the metering throughput */
+		time_diff = current_time - stats_time;
+		if (unlikely(time_diff >= stats_period)) {
+			printf("Core %u: %.3f Mpps (%s metering)\n", lcore_id,
+				(double)stats_pkts * rte_get_tsc_hz() /
+				((double)time_diff * 1000000),
+				app_bulk ? "bulk" : "per packet");
+			stats_time = current_time;
+			stats_pkts = 0;
+		}
+
 		/* Read packet burst from NIC RX */
 		nb_rx = rte_eth_rx_burst(port_rx, NIC_RX_QUEUE, pkts_rx, PKT_RX_BURST_MAX);
 
+		stats_pkts += nb_rx;
+
 		/* Handle packets */
+		if (app_bulk) {
+			app_pkts_handle_bulk(pkts_rx, actions, nb_rx,
+				current_time);
+
+			for (i = 0; i < nb_rx; i++) {
+				if (actions[i] == DROP)
+					rte_pktmbuf_free(pkts_rx[i]);
+				else
+					rte_eth_tx_buffer(port_tx, NIC_TX_QUEUE,
+						tx_buffer, pkts_rx[i]);
+			}
+			continue;
+		}
+
 		for (i = 0; i < nb_rx; i ++) {
 			struct rte_mbuf *pkt = pkts_rx[i];
 
@@ -217,8 +309,9 @@ main_loop(__attribute__((unused)) void *dummy)
 static void
 print_usage(const char *prgname)
 {
-	printf ("%s [EAL options] -- -p PORTMASK\n"
-		"  -p PORTMASK: hexadecimal bitmask of ports to configure\n",
+	printf ("%s [EAL options] -- -p PORTMASK [-b]\n"
+		"  -p PORTMASK: hexadecimal bitmask of ports to configure\n"
+		"  -b: meter each packet burst with one bulk call\n",
 		prgname);
 }
 
@@ -254,7 +347,7 @@ parse_args(int argc, char **argv)
 
 	argvopt = argv;
 
-	while ((opt = getopt_long(argc, argvopt, "p:", lgopts, &option_index)) != EOF) {
+	while ((opt = getopt_long(argc, argvopt, "p:b", lgopts, &option_index)) != EOF) {
 		switch (opt) {
 		case 'p':
 			port_mask = parse_portmask(optarg);
@@ -287,6 +380,10 @@ parse_args(int argc, char **argv)
 			}
 			break;
 
+		case 'b':
+			app_bulk = 1;
+			break;
+
 		default:
 			print_usage(prgname);
 			return -1;
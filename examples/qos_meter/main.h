@@ -54,6 +54,11 @@ enum policer_action policer_table[e_RTE_METER_COLORS][e_RTE_METER_COLORS] =
 #define FUNC_CONFIG(a, b) 0
 #define PARAMS	app_srtcm_params
 #define FLOW_METER int
+#define FUNC_PROFILE_CONFIG(a, b) 0
+#define FUNC_RT_CONFIG(a, b) 0
+#define FUNC_METER_BULK(a, b, c, d, e, f) do { RTE_SET_USED(a); RTE_SET_USED(b); } while (0)
+#define FLOW_PROFILE int
+#define FLOW_METER_RT int
 
 #elif APP_MODE == APP_MODE_SRTCM_COLOR_BLIND
 
@@ -61,6 +66,11 @@ enum policer_action policer_table[e_RTE_METER_COLORS][e_RTE_METER_COLORS] =
 #define FUNC_CONFIG   rte_meter_srtcm_config
 #define PARAMS        app_srtcm_params
 #define FLOW_METER    struct rte_meter_srtcm
+#define FUNC_PROFILE_CONFIG rte_meter_srtcm_profile_config
+#define FUNC_RT_CONFIG      rte_meter_srtcm_rt_config
+#define FUNC_METER_BULK     rte_meter_srtcm_color_blind_check_bulk
+#define FLOW_PROFILE        struct rte_meter_srtcm_profile
+#define FLOW_METER_RT       struct rte_meter_srtcm_rt
 
 #elif (APP_MODE == APP_MODE_SRTCM_COLOR_AWARE)
 
@@ -68,6 +78,11 @@ enum policer_action policer_table[e_RTE_METER_COLORS][e_RTE_METER_COLORS] =
 #define FUNC_CONFIG   rte_meter_srtcm_config
 #define PARAMS        app_srtcm_params
 #define FLOW_METER    struct rte_meter_srtcm
+#define FUNC_PROFILE_CONFIG rte_meter_srtcm_profile_config
+#define FUNC_RT_CONFIG      rte_meter_srtcm_rt_config
+#define FUNC_METER_BULK     rte_meter_srtcm_color_aware_check_bulk
+#define FLOW_PROFILE        struct rte_meter_srtcm_profile
+#define FLOW_METER_RT       struct rte_meter_srtcm_rt
 
 #elif (APP_MODE == APP_MODE_TRTCM_COLOR_BLIND)
 
@@ -75,6 +90,11 @@ enum policer_action policer_table[e_RTE_METER_COLORS][e_RTE_METER_COLORS] =
 #define FUNC_CONFIG  rte_meter_trtcm_config
 #define PARAMS       app_trtcm_params
 #define FLOW_METER   struct rte_meter_trtcm
+#define FUNC_PROFILE_CONFIG rte_meter_trtcm_profile_config
+#define FUNC_RT_CONFIG      rte_meter_trtcm_rt_config
+#define FUNC_METER_BULK     rte_meter_trtcm_color_blind_check_bulk
+#define FLOW_PROFILE        struct rte_meter_trtcm_profile
+#define FLOW_METER_RT       struct rte_meter_trtcm_rt
 
 #elif (APP_MODE == APP_MODE_TRTCM_COLOR_AWARE)
 
@@ -82,6 +102,11 @@ enum policer_action policer_table[e_RTE_METER_COLORS][e_RTE_METER_COLORS] =
 #define FUNC_CONFIG  rte_meter_trtcm_config
 #define PARAMS       app_trtcm_params
 #define FLOW_METER   struct rte_meter_trtcm
+#define FUNC_PROFILE_CONFIG rte_meter_trtcm_profile_config
+#define FUNC_RT_CONFIG      rte_meter_trtcm_rt_config
+#define FUNC_METER_BULK     rte_meter_trtcm_color_aware_check_bulk
+#define FLOW_PROFILE        struct rte_meter_trtcm_profile
+#define FLOW_METER_RT       struct rte_meter_trtcm_rt
 
 #else
 #error Invalid value for APP_MODE
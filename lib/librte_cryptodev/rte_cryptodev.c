@@ -74,6 +74,11 @@ struct rte_cryptodev rte_crypto_devices[RTE_CRYPTO_MAX_DEVS];
 
 struct rte_cryptodev *rte_cryptodevs = &rte_crypto_devices[0];
 
+RTE_TRACE_POINT_DEFINE(rte_cryptodev_trace_enqueue_burst,
+	"lib.cryptodev.enqueue_burst", "dev_id", "qp_id", "nb_ops")
+RTE_TRACE_POINT_DEFINE(rte_cryptodev_trace_dequeue_burst,
+	"lib.cryptodev.dequeue_burst", "dev_id", "qp_id", "nb_ops")
+
 static struct rte_cryptodev_global cryptodev_globals = {
 		.devs			= &rte_crypto_devices[0],
 		.data			= { NULL },
@@ -49,6 +49,7 @@ extern "C" {
 #include "rte_crypto.h"
 #include "rte_dev.h"
 #include <rte_common.h>
+#include <rte_trace.h>
 
 #define CRYPTODEV_NAME_NULL_PMD		crypto_null
 /**< Null crypto PMD device name */
@@ -673,6 +674,12 @@ struct rte_cryptodev_data {
 } __rte_cache_aligned;
 
 extern struct rte_cryptodev *rte_cryptodevs;
+
+/** Tracepoint "lib.cryptodev.enqueue_burst" of the operations enqueued. */
+extern struct rte_trace_point rte_cryptodev_trace_enqueue_burst;
+/** Tracepoint "lib.cryptodev.dequeue_burst" of the operations dequeued. */
+extern struct rte_trace_point rte_cryptodev_trace_dequeue_burst;
+
 /**
  *
  * Dequeue a burst of processed crypto operations from a queue on the crypto
@@ -717,6 +724,8 @@ rte_cryptodev_dequeue_burst(uint8_t dev_id, uint16_t qp_id,
 
 	nb_ops = (*dev->dequeue_burst)
 			(dev->data->queue_pairs[qp_id], ops, nb_ops);
+	rte_trace_point_emit(rte_cryptodev_trace_dequeue_burst,
+			dev_id, qp_id, nb_ops);
 
 	return nb_ops;
 }
@@ -758,8 +767,12 @@ rte_cryptodev_enqueue_burst(uint8_t dev_id, uint16_t qp_id,
 {
 	struct rte_cryptodev *dev = &rte_cryptodevs[dev_id];
 
-	return (*dev->enqueue_burst)(
+	nb_ops = (*dev->enqueue_burst)(
 			dev->data->queue_pairs[qp_id], ops, nb_ops);
+	rte_trace_point_emit(rte_cryptodev_trace_enqueue_burst,
+			dev_id, qp_id, nb_ops);
+
+	return nb_ops;
 }
 
 
@@ -473,6 +473,13 @@ int rte_eal_has_hugepages(void)
 	return !internal_config.no_hugetlbfs;
 }
 
+/* the contigmem memory is always used with physical addresses */
+enum rte_iova_mode
+rte_eal_iova_mode(void)
+{
+	return RTE_IOVA_PA;
+}
+
 /* Abstraction for port I/0 privilege */
 int
 rte_eal_iopl_init(void)
@@ -558,6 +565,12 @@ rte_eal_init(int argc, char **argv)
 	if (rte_eal_intr_init() < 0)
 		rte_panic("Cannot init interrupt-handling thread\n");
 
+	if (eal_log_async_init() < 0)
+		rte_panic("Cannot init asynchronous logging\n");
+
+	if (eal_trace_init() < 0)
+		rte_panic("Cannot init trace buffers\n");
+
 	if (rte_eal_timer_init() < 0)
 		rte_panic("Cannot init HPET or TSC timers\n");
 
@@ -609,6 +622,9 @@ rte_eal_init(int argc, char **argv)
 	rte_eal_mp_remote_launch(sync_func, NULL, SKIP_MASTER);
 	rte_eal_mp_wait_lcore();
 
+	if (eal_service_init() < 0)
+		rte_panic("Cannot init service cores\n");
+
 	/* Probe & Initialize PCI devices */
 	if (rte_eal_pci_probe())
 		rte_panic("Cannot probe PCI\n");
@@ -77,6 +77,8 @@ void __rte_panic(const char *funcname, const char *format, ...)
 {
 	va_list ap;
 
+	/* write the queued messages before the last ones */
+	rte_log_async_flush();
 	rte_log(RTE_LOG_CRIT, RTE_LOGTYPE_EAL, "PANIC in %s():\n", funcname);
 	va_start(ap, format);
 	rte_vlog(RTE_LOG_CRIT, RTE_LOGTYPE_EAL, format, ap);
@@ -95,6 +97,7 @@ rte_exit(int exit_code, const char *format, ...)
 {
 	va_list ap;
 
+	rte_log_async_flush();
 	if (exit_code != 0)
 		RTE_LOG(CRIT, EAL, "Error - exiting with code: %d\n"
 				"  Cause: ", exit_code);
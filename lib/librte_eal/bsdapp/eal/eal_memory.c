@@ -192,3 +192,22 @@ rte_eal_hugepage_attach(void)
 		close(fd_hugepage);
 	return -1;
 }
+
+/* the contigmem memory cannot grow, --dynamic-mem is Linux only */
+int
+eal_memory_grow(int socket_id __rte_unused, size_t len __rte_unused,
+		unsigned *n_memseg __rte_unused)
+{
+	return -1;
+}
+
+int
+eal_memory_shrink(unsigned memseg_id __rte_unused)
+{
+	return -1;
+}
+
+void
+eal_memory_sync(void)
+{
+}
@@ -0,0 +1,112 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+
+#include <rte_cpuflags.h>
+#include <rte_memcpy.h>
+
+#include "rte_memcpy_internal.h"
+
+/* variants used for large copies, until the constructor below runs */
+void *(*rte_memcpy_ptr)(void *dst, const void *src, size_t n) =
+	rte_memcpy_sse;
+void *(*rte_memcpy_nt_ptr)(void *dst, const void *src, size_t n) =
+	rte_memcpy_nt_sse;
+
+static enum rte_memcpy_isa memcpy_isa = RTE_MEMCPY_ISA_SSE;
+
+/* XCR0 state components of the YMM and ZMM registers */
+#define XCR0_AVX     0x06
+#define XCR0_AVX512F 0xe6
+
+/* Check that the OS saves the wide registers on context switches. */
+static int
+memcpy_os_supported(uint64_t xcr0_mask)
+{
+	uint32_t eax, edx;
+
+	if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_OSXSAVE) <= 0)
+		return 0;
+	asm volatile ("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+	return ((((uint64_t)edx << 32) | eax) & xcr0_mask) == xcr0_mask;
+}
+
+int
+rte_memcpy_isa_set(enum rte_memcpy_isa isa)
+{
+	switch (isa) {
+	case RTE_MEMCPY_ISA_SSE:
+		rte_memcpy_ptr = rte_memcpy_sse;
+		rte_memcpy_nt_ptr = rte_memcpy_nt_sse;
+		break;
+#ifdef CC_AVX2_SUPPORT
+	case RTE_MEMCPY_ISA_AVX2:
+		if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX2) <= 0 ||
+		    !memcpy_os_supported(XCR0_AVX))
+			return -ENOTSUP;
+		rte_memcpy_ptr = rte_memcpy_avx2;
+		rte_memcpy_nt_ptr = rte_memcpy_nt_avx2;
+		break;
+#endif
+#ifdef CC_AVX512F_SUPPORT
+	case RTE_MEMCPY_ISA_AVX512F:
+		if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX512F) <= 0 ||
+		    !memcpy_os_supported(XCR0_AVX512F))
+			return -ENOTSUP;
+		rte_memcpy_ptr = rte_memcpy_avx512f;
+		rte_memcpy_nt_ptr = rte_memcpy_nt_avx512f;
+		break;
+#endif
+	default:
+		return -ENOTSUP;
+	}
+
+	memcpy_isa = isa;
+	return 0;
+}
+
+enum rte_memcpy_isa
+rte_memcpy_isa_get(void)
+{
+	return memcpy_isa;
+}
+
+static void __attribute__((constructor))
+rte_memcpy_init(void)
+{
+	if (rte_memcpy_isa_set(RTE_MEMCPY_ISA_AVX512F) == 0)
+		return;
+	if (rte_memcpy_isa_set(RTE_MEMCPY_ISA_AVX2) == 0)
+		return;
+	rte_memcpy_isa_set(RTE_MEMCPY_ISA_SSE);
+}
@@ -0,0 +1,65 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* build the 32-byte variant, whatever the target machine */
+#ifndef RTE_MACHINE_CPUFLAG_AVX2
+#define RTE_MACHINE_CPUFLAG_AVX2
+#endif
+#undef RTE_MACHINE_CPUFLAG_AVX512F
+
+#include <rte_memcpy.h>
+
+static inline void
+rte_mov64_nt(uint8_t *dst, const uint8_t *src)
+{
+	__m256i ymm0, ymm1;
+
+	ymm0 = _mm256_loadu_si256((const __m256i *)src);
+	ymm1 = _mm256_loadu_si256((const __m256i *)(src + 32));
+	_mm256_stream_si256((__m256i *)dst, ymm0);
+	_mm256_stream_si256((__m256i *)(dst + 32), ymm1);
+}
+
+#define RTE_MEMCPY_NT_VARIANT
+#include "rte_memcpy_internal.h"
+
+void *
+rte_memcpy_avx2(void *dst, const void *src, size_t n)
+{
+	return rte_memcpy_internal(dst, src, n);
+}
+
+void *
+rte_memcpy_nt_avx2(void *dst, const void *src, size_t n)
+{
+	return rte_memcpy_nt_internal(dst, src, n);
+}
@@ -0,0 +1,92 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _RTE_MEMCPY_INTERNAL_H_
+#define _RTE_MEMCPY_INTERNAL_H_
+
+/**
+ * @file
+ *
+ * Variants of rte_memcpy() for each instruction set, built in their own
+ * files with the matching compiler flags, and selected at runtime.
+ *
+ * The file of a variant defines rte_mov64_nt() before including this
+ * header, to get rte_memcpy_nt_internal() with its own 64-byte moves.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Copies smaller than this are not worth non-temporal stores. */
+#define RTE_MEMCPY_NT_THRESH 256
+
+void *rte_memcpy_sse(void *dst, const void *src, size_t n);
+void *rte_memcpy_nt_sse(void *dst, const void *src, size_t n);
+void *rte_memcpy_avx2(void *dst, const void *src, size_t n);
+void *rte_memcpy_nt_avx2(void *dst, const void *src, size_t n);
+void *rte_memcpy_avx512f(void *dst, const void *src, size_t n);
+void *rte_memcpy_nt_avx512f(void *dst, const void *src, size_t n);
+
+#ifdef RTE_MEMCPY_NT_VARIANT
+
+static inline void *
+rte_memcpy_nt_internal(void *dst, const void *src, size_t n)
+{
+	uint8_t *d = dst;
+	const uint8_t *s = src;
+	size_t head;
+
+	if (n < RTE_MEMCPY_NT_THRESH)
+		return rte_memcpy_internal(dst, src, n);
+
+	/* align the destination on a cache line, to store full lines */
+	head = -(uintptr_t)d & 63;
+	rte_memcpy_internal(d, s, head);
+	d += head;
+	s += head;
+	n -= head;
+
+	for (; n >= 64; n -= 64) {
+		rte_mov64_nt(d, s);
+		d += 64;
+		s += 64;
+	}
+	/* order the non-temporal stores with the following stores */
+	_mm_sfence();
+
+	rte_memcpy_internal(d, s, n);
+	return dst;
+}
+
+#endif /* RTE_MEMCPY_NT_VARIANT */
+
+#endif /* _RTE_MEMCPY_INTERNAL_H_ */
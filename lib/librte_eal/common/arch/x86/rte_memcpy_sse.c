@@ -0,0 +1,67 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* build the 16-byte variant, whatever the target machine */
+#undef RTE_MACHINE_CPUFLAG_AVX2
+#undef RTE_MACHINE_CPUFLAG_AVX512F
+
+#include <rte_memcpy.h>
+
+static inline void
+rte_mov64_nt(uint8_t *dst, const uint8_t *src)
+{
+	__m128i xmm0, xmm1, xmm2, xmm3;
+
+	xmm0 = _mm_loadu_si128((const __m128i *)src);
+	xmm1 = _mm_loadu_si128((const __m128i *)(src + 16));
+	xmm2 = _mm_loadu_si128((const __m128i *)(src + 32));
+	xmm3 = _mm_loadu_si128((const __m128i *)(src + 48));
+	_mm_stream_si128((__m128i *)dst, xmm0);
+	_mm_stream_si128((__m128i *)(dst + 16), xmm1);
+	_mm_stream_si128((__m128i *)(dst + 32), xmm2);
+	_mm_stream_si128((__m128i *)(dst + 48), xmm3);
+}
+
+#define RTE_MEMCPY_NT_VARIANT
+#include "rte_memcpy_internal.h"
+
+void *
+rte_memcpy_sse(void *dst, const void *src, size_t n)
+{
+	return rte_memcpy_internal(dst, src, n);
+}
+
+void *
+rte_memcpy_nt_sse(void *dst, const void *src, size_t n)
+{
+	return rte_memcpy_nt_internal(dst, src, n);
+}
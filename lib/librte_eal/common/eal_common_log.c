@@ -33,13 +33,27 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <stdarg.h>
 #include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <regex.h>
+#include <time.h>
+#include <pthread.h>
 
+#include <rte_eal.h>
 #include <rte_log.h>
+#include <rte_memory.h>
 #include <rte_per_lcore.h>
+#include <rte_lcore.h>
+#include <rte_atomic.h>
+#include <rte_cycles.h>
+#include <rte_common.h>
+#include <rte_spinlock.h>
 
 #include "eal_private.h"
+#include "eal_internal_cfg.h"
 
 /* global log structure */
 struct rte_logs rte_logs = {
@@ -48,6 +62,21 @@ struct rte_logs rte_logs = {
 	.file = NULL,
 };
 
+/** Name and level of a log type. */
+struct rte_log_dynamic_type {
+	const char *name; /**< NULL for the unused static identifiers */
+	uint32_t loglevel;
+};
+
+/* levels given with rte_log_set_level_regexp(), for the next log types */
+#define LOG_MAX_PATTERNS 16
+static struct {
+	char *pattern;
+	regex_t re;
+	uint32_t level;
+} log_patterns[LOG_MAX_PATTERNS];
+static unsigned log_nb_patterns;
+
 /* Stream to use for logging if rte_logs.file is NULL */
 static FILE *default_log_stream;
 
@@ -63,8 +92,58 @@ struct log_cur_msg {
  /* per core log */
 static RTE_DEFINE_PER_LCORE(struct log_cur_msg, log_cur_msg);
 
+/*
+ * Asynchronous logging: each lcore formats its messages in a record of its
+ * own single producer, single consumer queue, and the logging thread writes
+ * the records of all queues in timestamp order.
+ */
+#define LOG_ASYNC_MSG_SIZE (256 - 2 * sizeof(uint64_t))
+#define LOG_ASYNC_RING_MASK (RTE_LOG_ASYNC_RING_SIZE - 1)
+
+struct log_async_record {
+	uint64_t tsc;      /**< time of the message */
+	uint16_t loglevel;
+	uint16_t logtype;
+	uint32_t len;      /**< length of msg */
+	char msg[LOG_ASYNC_MSG_SIZE];
+};
+
+struct log_async_ring {
+	volatile uint32_t head __rte_cache_aligned; /**< written by lcore */
+	uint64_t queued;
+	uint64_t dropped;
+	volatile uint32_t tail __rte_cache_aligned; /**< written on flush */
+	struct log_async_record *records;
+} __rte_cache_aligned;
+
+static struct log_async_ring log_async_rings[RTE_MAX_LCORE];
+static int log_async_enabled;
+static pthread_t log_async_thread;
+static rte_spinlock_t log_async_lock = RTE_SPINLOCK_INITIALIZER;
+
 /* default logs */
 
+static FILE *
+log_stream(void)
+{
+	FILE *f = rte_logs.file;
+
+	if (f == NULL) {
+		f = default_log_stream;
+		if (f == NULL) {
+			/*
+			 * Grab the current value of stderr here, rather than
+			 * just initializing default_log_stream to stderr. This
+			 * ensures that we will always use the current value
+			 * of stderr, even if the application closes and
+			 * reopens it.
+			 */
+			f = stderr;
+		}
+	}
+	return f;
+}
+
 /* Change the stream that will be used by logging system */
 int
 rte_openlog_stream(FILE *f)
@@ -91,10 +170,16 @@ rte_get_log_level(void)
 void
 rte_set_log_type(uint32_t type, int enable)
 {
-	if (enable)
-		rte_logs.type |= type;
-	else
-		rte_logs.type &= (~type);
+	if (type < RTE_LOGTYPE_FIRST_EXT_ID) {
+		if (enable)
+			rte_logs.type |= 1U << type;
+		else
+			rte_logs.type &= ~(1U << type);
+	} else if (rte_log_set_level(type, enable ? RTE_LOG_DEBUG : 0) < 0) {
+		/* most likely a bit mask of the log types of previous releases */
+		RTE_LOG(ERR, EAL, "Invalid log type %u, log types are no longer "
+			"bit masks\n", type);
+	}
 }
 
 /* Get global log type */
@@ -104,6 +189,199 @@ rte_get_log_type(void)
 	return rte_logs.type;
 }
 
+int
+rte_log_set_level(uint32_t logtype, uint32_t level)
+{
+	if (logtype >= rte_logs.dynamic_types_len)
+		return -EINVAL;
+	if (level > RTE_LOG_DEBUG)
+		return -EINVAL;
+
+	rte_logs.dynamic_types[logtype].loglevel = level;
+	return 0;
+}
+
+int
+rte_log_get_level(uint32_t logtype)
+{
+	if (logtype >= rte_logs.dynamic_types_len)
+		return -EINVAL;
+
+	return rte_logs.dynamic_types[logtype].loglevel;
+}
+
+int
+rte_log_set_level_regexp(const char *pattern, uint32_t level)
+{
+	regex_t re;
+	size_t i;
+
+	if (level > RTE_LOG_DEBUG)
+		return -EINVAL;
+	if (regcomp(&re, pattern, REG_EXTENDED | REG_NOSUB) != 0)
+		return -EINVAL;
+
+	for (i = 0; i < rte_logs.dynamic_types_len; i++) {
+		if (rte_logs.dynamic_types[i].name == NULL)
+			continue;
+		if (regexec(&re, rte_logs.dynamic_types[i].name, 0,
+				NULL, 0) == 0)
+			rte_logs.dynamic_types[i].loglevel = level;
+	}
+
+	/* remember it for the log types registered later */
+	for (i = 0; i < log_nb_patterns; i++) {
+		if (strcmp(log_patterns[i].pattern, pattern) == 0) {
+			regfree(&re);
+			log_patterns[i].level = level;
+			return 0;
+		}
+	}
+	if (log_nb_patterns == LOG_MAX_PATTERNS) {
+		regfree(&re);
+		return -ENOSPC;
+	}
+	log_patterns[log_nb_patterns].pattern = strdup(pattern);
+	if (log_patterns[log_nb_patterns].pattern == NULL) {
+		regfree(&re);
+		return -ENOMEM;
+	}
+	log_patterns[log_nb_patterns].re = re;
+	log_patterns[log_nb_patterns].level = level;
+	log_nb_patterns++;
+
+	return 0;
+}
+
+static int
+log_register(const char *name, uint32_t id)
+{
+	struct rte_log_dynamic_type *types;
+	size_t i, len = rte_logs.dynamic_types_len;
+	char *dup;
+
+	if (id >= len) {
+		types = realloc(rte_logs.dynamic_types,
+			(id + 1) * sizeof(*types));
+		if (types == NULL)
+			return -ENOMEM;
+		memset(&types[len], 0, (id + 1 - len) * sizeof(*types));
+		rte_logs.dynamic_types = types;
+		rte_logs.dynamic_types_len = id + 1;
+	}
+
+	dup = strdup(name);
+	if (dup == NULL)
+		return -ENOMEM;
+	rte_logs.dynamic_types[id].name = dup;
+	rte_logs.dynamic_types[id].loglevel = RTE_LOG_DEBUG;
+
+	/* the last matching pattern wins, as when they are applied */
+	for (i = 0; i < log_nb_patterns; i++) {
+		if (regexec(&log_patterns[i].re, name, 0, NULL, 0) == 0)
+			rte_logs.dynamic_types[id].loglevel =
+				log_patterns[i].level;
+	}
+
+	return id;
+}
+
+int
+rte_log_register(const char *name)
+{
+	size_t i;
+
+	for (i = 0; i < rte_logs.dynamic_types_len; i++) {
+		if (rte_logs.dynamic_types[i].name != NULL &&
+				strcmp(rte_logs.dynamic_types[i].name,
+					name) == 0)
+			return i;
+	}
+
+	return log_register(name, RTE_MAX(rte_logs.dynamic_types_len,
+			(size_t)RTE_LOGTYPE_FIRST_EXT_ID));
+}
+
+/* names of the static log types */
+static const struct {
+	uint32_t id;
+	const char *name;
+} log_static_types[] = {
+	{ RTE_LOGTYPE_EAL, "eal" },
+	{ RTE_LOGTYPE_MALLOC, "malloc" },
+	{ RTE_LOGTYPE_RING, "ring" },
+	{ RTE_LOGTYPE_MEMPOOL, "mempool" },
+	{ RTE_LOGTYPE_TIMER, "timer" },
+	{ RTE_LOGTYPE_PMD, "pmd" },
+	{ RTE_LOGTYPE_HASH, "hash" },
+	{ RTE_LOGTYPE_LPM, "lpm" },
+	{ RTE_LOGTYPE_KNI, "kni" },
+	{ RTE_LOGTYPE_ACL, "acl" },
+	{ RTE_LOGTYPE_POWER, "power" },
+	{ RTE_LOGTYPE_METER, "meter" },
+	{ RTE_LOGTYPE_SCHED, "sched" },
+	{ RTE_LOGTYPE_PORT, "port" },
+	{ RTE_LOGTYPE_TABLE, "table" },
+	{ RTE_LOGTYPE_PIPELINE, "pipeline" },
+	{ RTE_LOGTYPE_MBUF, "mbuf" },
+	{ RTE_LOGTYPE_CRYPTODEV, "cryptodev" },
+	{ RTE_LOGTYPE_EFD, "efd" },
+	{ RTE_LOGTYPE_USER1, "user1" },
+	{ RTE_LOGTYPE_USER2, "user2" },
+	{ RTE_LOGTYPE_USER3, "user3" },
+	{ RTE_LOGTYPE_USER4, "user4" },
+	{ RTE_LOGTYPE_USER5, "user5" },
+	{ RTE_LOGTYPE_USER6, "user6" },
+	{ RTE_LOGTYPE_USER7, "user7" },
+	{ RTE_LOGTYPE_USER8, "user8" },
+};
+
+/* register the static log types before the constructors of the drivers
+ * register theirs */
+static void __attribute__((constructor(101), used))
+rte_log_init(void)
+{
+	unsigned i;
+
+	rte_logs.dynamic_types = calloc(RTE_LOGTYPE_FIRST_EXT_ID,
+		sizeof(struct rte_log_dynamic_type));
+	if (rte_logs.dynamic_types == NULL)
+		return;
+	rte_logs.dynamic_types_len = RTE_LOGTYPE_FIRST_EXT_ID;
+
+	for (i = 0; i < RTE_DIM(log_static_types); i++)
+		log_register(log_static_types[i].name, log_static_types[i].id);
+}
+
+void
+rte_log_dump(FILE *f)
+{
+	struct rte_log_async_stats stats;
+	size_t i;
+
+	fprintf(f, "global log level is %u\n", rte_logs.level);
+
+	for (i = 0; i < rte_logs.dynamic_types_len; i++) {
+		if (rte_logs.dynamic_types[i].name == NULL)
+			continue;
+		fprintf(f, "id %zu: %s, level is %u%s\n", i,
+			rte_logs.dynamic_types[i].name,
+			rte_logs.dynamic_types[i].loglevel,
+			i < RTE_LOGTYPE_FIRST_EXT_ID &&
+			!(rte_logs.type & (1U << i)) ? ", disabled" : "");
+	}
+
+	if (!log_async_enabled)
+		return;
+	for (i = 0; i < RTE_MAX_LCORE; i++) {
+		if (log_async_rings[i].records == NULL)
+			continue;
+		rte_log_async_stats_get(i, &stats);
+		fprintf(f, "lcore %zu: %"PRIu64" async messages, "
+			"%"PRIu64" dropped\n", i, stats.queued, stats.dropped);
+	}
+}
+
 /* get the current loglevel for the message beeing processed */
 int rte_log_cur_msg_loglevel(void)
 {
@@ -116,6 +394,171 @@ int rte_log_cur_msg_logtype(void)
 	return RTE_PER_LCORE(log_cur_msg).logtype;
 }
 
+static void
+log_write(FILE *f, uint32_t level, uint32_t logtype, const char *msg,
+		size_t len)
+{
+	/* save loglevel and logtype in a global per-lcore variable */
+	RTE_PER_LCORE(log_cur_msg).loglevel = level;
+	RTE_PER_LCORE(log_cur_msg).logtype = logtype;
+
+	fwrite(msg, 1, len, f);
+	fflush(f);
+}
+
+/* queue a message for the logging thread, returns -1 if not possible */
+static int
+log_async_enqueue(uint32_t level, uint32_t logtype, const char *format,
+		va_list ap)
+{
+	unsigned lcore_id = rte_lcore_id();
+	struct log_async_ring *r;
+	struct log_async_record *rec;
+	uint32_t head;
+	int len;
+
+	/* the critical messages, such as panics, are written at once */
+	if (level <= RTE_LOG_CRIT || lcore_id >= RTE_MAX_LCORE)
+		return -1;
+	r = &log_async_rings[lcore_id];
+	if (r->records == NULL)
+		return -1;
+
+	head = r->head;
+	if (head - r->tail >= RTE_LOG_ASYNC_RING_SIZE) {
+		r->dropped++;
+		return 0;
+	}
+
+	rec = &r->records[head & LOG_ASYNC_RING_MASK];
+	rec->tsc = rte_rdtsc();
+	rec->loglevel = level;
+	rec->logtype = logtype;
+	len = vsnprintf(rec->msg, sizeof(rec->msg), format, ap);
+	if (len < 0)
+		return len;
+	/* a truncated message still ends the line */
+	if ((size_t)len >= sizeof(rec->msg)) {
+		len = sizeof(rec->msg) - 1;
+		rec->msg[len - 1] = '\n';
+	}
+	rec->len = len;
+
+	rte_smp_wmb();
+	r->head = head + 1;
+	r->queued++;
+
+	return len;
+}
+
+/* write the oldest queued message, returns 0 if there is none */
+static int
+log_async_dequeue(void)
+{
+	struct log_async_ring *r, *oldest = NULL;
+	struct log_async_record *rec;
+	uint64_t tsc = 0;
+	unsigned i;
+
+	for (i = 0; i < RTE_MAX_LCORE; i++) {
+		r = &log_async_rings[i];
+		if (r->records == NULL || r->tail == r->head)
+			continue;
+		rte_smp_rmb();
+		rec = &r->records[r->tail & LOG_ASYNC_RING_MASK];
+		if (oldest == NULL || (int64_t)(rec->tsc - tsc) < 0) {
+			oldest = r;
+			tsc = rec->tsc;
+		}
+	}
+	if (oldest == NULL)
+		return 0;
+
+	rec = &oldest->records[oldest->tail & LOG_ASYNC_RING_MASK];
+	log_write(log_stream(), rec->loglevel, rec->logtype, rec->msg,
+		rec->len);
+
+	/* the record is read before being given back to the lcore */
+	rte_smp_mb();
+	oldest->tail++;
+
+	return 1;
+}
+
+static __attribute__((noreturn)) void *
+log_async_loop(void __rte_unused *arg)
+{
+	const struct timespec wait = { .tv_sec = 0, .tv_nsec = 100000 };
+
+	for (;;) {
+		rte_log_async_flush();
+		nanosleep(&wait, NULL);
+	}
+}
+
+int
+eal_log_async_init(void)
+{
+	char thread_name[RTE_MAX_THREAD_NAME_LEN];
+	unsigned lcore_id;
+
+	RTE_BUILD_BUG_ON(!rte_is_power_of_2(RTE_LOG_ASYNC_RING_SIZE));
+
+	if (!internal_config.log_async)
+		return 0;
+
+	RTE_LCORE_FOREACH(lcore_id) {
+		log_async_rings[lcore_id].records =
+			calloc(RTE_LOG_ASYNC_RING_SIZE,
+				sizeof(struct log_async_record));
+		if (log_async_rings[lcore_id].records == NULL)
+			goto error;
+	}
+
+	if (pthread_create(&log_async_thread, NULL, log_async_loop, NULL))
+		goto error;
+	snprintf(thread_name, sizeof(thread_name), "log-async");
+	rte_thread_setname(log_async_thread, thread_name);
+
+	rte_smp_wmb();
+	log_async_enabled = 1;
+
+	/* the thread is not joined, the messages are written at exit */
+	atexit(rte_log_async_flush);
+	return 0;
+
+error:
+	RTE_LCORE_FOREACH(lcore_id) {
+		free(log_async_rings[lcore_id].records);
+		log_async_rings[lcore_id].records = NULL;
+	}
+	return -1;
+}
+
+int
+rte_log_async_stats_get(unsigned lcore_id, struct rte_log_async_stats *stats)
+{
+	if (lcore_id >= RTE_MAX_LCORE)
+		return -EINVAL;
+
+	stats->queued = log_async_rings[lcore_id].queued;
+	stats->dropped = log_async_rings[lcore_id].dropped;
+	return 0;
+}
+
+void
+rte_log_async_flush(void)
+{
+	if (!log_async_enabled)
+		return;
+
+	/* the logging thread and the exit paths dequeue concurrently */
+	rte_spinlock_lock(&log_async_lock);
+	while (log_async_dequeue())
+		;
+	rte_spinlock_unlock(&log_async_lock);
+}
+
 /*
  * Generates a log message The message will be sent in the stream
  * defined by the previous call to rte_openlog_stream().
@@ -124,23 +567,26 @@ int
 rte_vlog(uint32_t level, uint32_t logtype, const char *format, va_list ap)
 {
 	int ret;
-	FILE *f = rte_logs.file;
-	if (f == NULL) {
-		f = default_log_stream;
-		if (f == NULL) {
-			/*
-			 * Grab the current value of stderr here, rather than
-			 * just initializing default_log_stream to stderr. This
-			 * ensures that we will always use the current value
-			 * of stderr, even if the application closes and
-			 * reopens it.
-			 */
-			f = stderr;
-		}
-	}
+	FILE *f = log_stream();
 
-	if ((level > rte_logs.level) || !(logtype & rte_logs.type))
+	if (level > rte_logs.level)
 		return 0;
+	if (logtype < RTE_LOGTYPE_FIRST_EXT_ID &&
+			!(rte_logs.type & (1U << logtype)))
+		return 0;
+	if (logtype < rte_logs.dynamic_types_len &&
+			level > rte_logs.dynamic_types[logtype].loglevel)
+		return 0;
+
+	if (log_async_enabled) {
+		va_list aq;
+
+		va_copy(aq, ap);
+		ret = log_async_enqueue(level, logtype, format, aq);
+		va_end(aq);
+		if (ret >= 0)
+			return ret;
+	}
 
 	/* save loglevel and logtype in a global per-lcore variable */
 	RTE_PER_LCORE(log_cur_msg).loglevel = level;
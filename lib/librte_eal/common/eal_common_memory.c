@@ -43,6 +43,7 @@
 #include <rte_eal.h>
 #include <rte_eal_memconfig.h>
 #include <rte_log.h>
+#include <rte_rwlock.h>
 
 #include "eal_private.h"
 #include "eal_internal_cfg.h"
@@ -120,6 +121,74 @@ unsigned rte_memory_get_nrank(void)
 	return rte_eal_get_configuration()->mem_config->nrank;
 }
 
+#define MEM_EVENT_CALLBACK_MAX 16
+
+/* functions called on memory layout changes, in this process */
+static struct {
+	rte_mem_event_callback_t cb;
+	void *arg;
+} mem_event_callbacks[MEM_EVENT_CALLBACK_MAX];
+static rte_rwlock_t mem_event_lock = RTE_RWLOCK_INITIALIZER;
+
+int
+rte_mem_event_callback_register(rte_mem_event_callback_t cb, void *arg)
+{
+	unsigned i;
+	int ret = -1;
+
+	if (cb == NULL)
+		return -1;
+
+	rte_rwlock_write_lock(&mem_event_lock);
+	for (i = 0; i < MEM_EVENT_CALLBACK_MAX; i++) {
+		if (mem_event_callbacks[i].cb == NULL) {
+			mem_event_callbacks[i].cb = cb;
+			mem_event_callbacks[i].arg = arg;
+			ret = 0;
+			break;
+		}
+	}
+	rte_rwlock_write_unlock(&mem_event_lock);
+
+	return ret;
+}
+
+int
+rte_mem_event_callback_unregister(rte_mem_event_callback_t cb, void *arg)
+{
+	unsigned i;
+	int ret = -1;
+
+	rte_rwlock_write_lock(&mem_event_lock);
+	for (i = 0; i < MEM_EVENT_CALLBACK_MAX; i++) {
+		if (mem_event_callbacks[i].cb == cb &&
+				mem_event_callbacks[i].arg == arg) {
+			mem_event_callbacks[i].cb = NULL;
+			mem_event_callbacks[i].arg = NULL;
+			ret = 0;
+			break;
+		}
+	}
+	rte_rwlock_write_unlock(&mem_event_lock);
+
+	return ret;
+}
+
+void
+eal_mem_event_notify(enum rte_mem_event event, const struct rte_memseg *ms,
+		unsigned n_memseg)
+{
+	unsigned i;
+
+	rte_rwlock_read_lock(&mem_event_lock);
+	for (i = 0; i < MEM_EVENT_CALLBACK_MAX; i++) {
+		if (mem_event_callbacks[i].cb != NULL)
+			mem_event_callbacks[i].cb(event, ms, n_memseg,
+				mem_event_callbacks[i].arg);
+	}
+	rte_rwlock_read_unlock(&mem_event_lock);
+}
+
 static int
 rte_eal_memdevice_init(void)
 {
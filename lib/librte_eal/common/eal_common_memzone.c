@@ -366,6 +366,10 @@ rte_memzone_lookup(const char *name)
 
 	mcfg = rte_eal_get_configuration()->mem_config;
 
+	/* map the memory the zone may have been reserved in */
+	if (internal_config.dynamic_mem)
+		eal_memory_sync();
+
 	rte_rwlock_read_lock(&mcfg->mlock);
 
 	memzone = memzone_lookup_thread_unsafe(name);
@@ -54,6 +54,7 @@
 #include "eal_internal_cfg.h"
 #include "eal_options.h"
 #include "eal_filesystem.h"
+#include "eal_private.h"
 
 #define BITS_PER_HEX 4
 
@@ -67,6 +68,7 @@ eal_short_options[] =
 	"m:" /* memory size */
 	"n:" /* memory channels */
 	"r:" /* memory ranks */
+	"s:" /* service coremask */
 	"v"  /* version */
 	"w:" /* pci-whitelist */
 	;
@@ -75,11 +77,14 @@ const struct option
 eal_long_options[] = {
 	{OPT_BASE_VIRTADDR,     1, NULL, OPT_BASE_VIRTADDR_NUM    },
 	{OPT_CREATE_UIO_DEV,    0, NULL, OPT_CREATE_UIO_DEV_NUM   },
+	{OPT_DYNAMIC_MEM,       0, NULL, OPT_DYNAMIC_MEM_NUM      },
 	{OPT_FILE_PREFIX,       1, NULL, OPT_FILE_PREFIX_NUM      },
 	{OPT_HELP,              0, NULL, OPT_HELP_NUM             },
 	{OPT_HUGE_DIR,          1, NULL, OPT_HUGE_DIR_NUM         },
 	{OPT_HUGE_UNLINK,       0, NULL, OPT_HUGE_UNLINK_NUM      },
+	{OPT_IOVA_MODE,         1, NULL, OPT_IOVA_MODE_NUM        },
 	{OPT_LCORES,            1, NULL, OPT_LCORES_NUM           },
+	{OPT_LOG_ASYNC,         0, NULL, OPT_LOG_ASYNC_NUM        },
 	{OPT_LOG_LEVEL,         1, NULL, OPT_LOG_LEVEL_NUM        },
 	{OPT_MASTER_LCORE,      1, NULL, OPT_MASTER_LCORE_NUM     },
 	{OPT_NO_HPET,           0, NULL, OPT_NO_HPET_NUM          },
@@ -91,6 +96,8 @@ eal_long_options[] = {
 	{OPT_PROC_TYPE,         1, NULL, OPT_PROC_TYPE_NUM        },
 	{OPT_SOCKET_MEM,        1, NULL, OPT_SOCKET_MEM_NUM       },
 	{OPT_SYSLOG,            1, NULL, OPT_SYSLOG_NUM           },
+	{OPT_TRACE,             1, NULL, OPT_TRACE_NUM            },
+	{OPT_TRACE_DIR,         1, NULL, OPT_TRACE_DIR_NUM        },
 	{OPT_VDEV,              1, NULL, OPT_VDEV_NUM             },
 	{OPT_VFIO_INTR,         1, NULL, OPT_VFIO_INTR_NUM        },
 	{OPT_VMWARE_TSC_MAP,    0, NULL, OPT_VMWARE_TSC_MAP_NUM   },
@@ -139,6 +146,8 @@ eal_reset_internal_config(struct internal_config *internal_cfg)
 	internal_cfg->hugefile_prefix = HUGEFILE_PREFIX_DEFAULT;
 	internal_cfg->hugepage_dir = NULL;
 	internal_cfg->force_sockets = 0;
+	internal_cfg->dynamic_mem = 0;
+	internal_cfg->iova_mode = RTE_IOVA_DC;
 	/* zero out the NUMA config */
 	for (i = 0; i < RTE_MAX_NUMA_NODES; i++)
 		internal_cfg->socket_mem[i] = 0;
@@ -154,6 +163,10 @@ eal_reset_internal_config(struct internal_config *internal_cfg)
 #else
 	internal_cfg->log_level = RTE_LOG_LEVEL;
 #endif
+	internal_cfg->log_async = 0;
+
+	memset(internal_cfg->service_cores, 0,
+		sizeof(internal_cfg->service_cores));
 
 	internal_cfg->xen_dom0_support = 0;
 
@@ -401,6 +414,53 @@ eal_parse_corelist(const char *corelist)
 	return 0;
 }
 
+/*
+ * Parse the service coremask. The lcores are checked and turned into
+ * service cores in eal_adjust_config(), once the lcores are known.
+ */
+static int
+eal_parse_service_coremask(const char *coremask, struct internal_config *conf)
+{
+	int i, j, idx = 0;
+	unsigned count = 0;
+	char c;
+	int val;
+
+	if (coremask == NULL)
+		return -1;
+	while (isblank(*coremask))
+		coremask++;
+	if (coremask[0] == '0' && ((coremask[1] == 'x')
+		|| (coremask[1] == 'X')))
+		coremask += 2;
+	i = strlen(coremask);
+	while ((i > 0) && isblank(coremask[i - 1]))
+		i--;
+	if (i == 0)
+		return -1;
+
+	memset(conf->service_cores, 0, sizeof(conf->service_cores));
+	for (i = i - 1; i >= 0 && idx < RTE_MAX_LCORE; i--) {
+		c = coremask[i];
+		if (isxdigit(c) == 0)
+			return -1;
+		val = xdigit2val(c);
+		for (j = 0; j < BITS_PER_HEX && idx < RTE_MAX_LCORE;
+				j++, idx++) {
+			if ((1 << j) & val) {
+				conf->service_cores[idx] = 1;
+				count++;
+			}
+		}
+	}
+	for (; i >= 0; i--)
+		if (coremask[i] != '0')
+			return -1;
+	if (count == 0)
+		return -1;
+	return 0;
+}
+
 /* Changes the lcore id of the master thread */
 static int
 eal_parse_master_lcore(const char *arg)
@@ -738,12 +798,26 @@ eal_parse_syslog(const char *facility, struct internal_config *conf)
 	return -1;
 }
 
+/*
+ * Parse "level" for the global log level, or "regexp,level" for the log
+ * types matching regexp, whose level is set at once.
+ */
 static int
-eal_parse_log_level(const char *level, uint32_t *log_level)
+eal_parse_log_level(const char *arg, uint32_t *log_level)
 {
-	char *end;
+	char *end, *level, *sep;
+	char pattern[128];
 	unsigned long tmp;
 
+	level = (char *)(uintptr_t)arg;
+	sep = strrchr(arg, ',');
+	if (sep != NULL) {
+		if (sep == arg || (size_t)(sep - arg) >= sizeof(pattern))
+			return -1;
+		snprintf(pattern, sep - arg + 1, "%s", arg);
+		level = sep + 1;
+	}
+
 	errno = 0;
 	tmp = strtoul(level, &end, 0);
 
@@ -756,6 +830,9 @@ eal_parse_log_level(const char *level, uint32_t *log_level)
 	if (tmp >= UINT32_MAX)
 		return -1;
 
+	if (sep != NULL && rte_log_set_level_regexp(pattern, tmp) < 0)
+		return -1;
+
 	*log_level = tmp;
 	return 0;
 }
@@ -832,6 +909,13 @@ eal_parse_common_option(int opt, const char *optarg,
 			return -1;
 		}
 		break;
+	/* service coremask */
+	case 's':
+		if (eal_parse_service_coremask(optarg, conf) < 0) {
+			RTE_LOG(ERR, EAL, "invalid service coremask\n");
+			return -1;
+		}
+		break;
 	/* force loading of external driver */
 	case 'd':
 		if (eal_plugin_add(optarg) == -1)
@@ -906,9 +990,29 @@ eal_parse_common_option(int opt, const char *optarg,
 				OPT_LOG_LEVEL "\n");
 			return -1;
 		}
+		/* the level of some log types only */
+		if (strchr(optarg, ',') != NULL)
+			break;
 		conf->log_level = log;
 		break;
 	}
+	case OPT_LOG_ASYNC_NUM:
+		conf->log_async = 1;
+		break;
+	case OPT_TRACE_NUM:
+		if (eal_trace_pattern_add(optarg) < 0) {
+			RTE_LOG(ERR, EAL, "cannot save --"
+				OPT_TRACE " pattern\n");
+			return -1;
+		}
+		break;
+	case OPT_TRACE_DIR_NUM:
+		if (eal_trace_dir_set(optarg) < 0) {
+			RTE_LOG(ERR, EAL, "cannot save --"
+				OPT_TRACE_DIR " directory\n");
+			return -1;
+		}
+		break;
 	case OPT_LCORES_NUM:
 		if (eal_parse_lcores(optarg) < 0) {
 			RTE_LOG(ERR, EAL, "invalid parameter for --"
@@ -962,9 +1066,40 @@ eal_adjust_config(struct internal_config *internal_cfg)
 	if (internal_config.process_type == RTE_PROC_AUTO)
 		internal_config.process_type = eal_proc_type_detect();
 
-	/* default master lcore is the first one */
-	if (!master_lcore_parsed)
+	/* default master lcore is the first one which is not a service core */
+	if (!master_lcore_parsed) {
 		cfg->master_lcore = rte_get_next_lcore(-1, 0, 0);
+		while (cfg->master_lcore < RTE_MAX_LCORE &&
+				internal_cfg->service_cores[cfg->master_lcore])
+			cfg->master_lcore =
+				rte_get_next_lcore(cfg->master_lcore, 0, 0);
+		if (cfg->master_lcore == RTE_MAX_LCORE) {
+			RTE_LOG(ERR, EAL, "No lcore left for the master "
+				"lcore\n");
+			return -1;
+		}
+	}
+
+	/* the service cores are run by EAL threads, like the slave lcores */
+	for (i = 0; i < RTE_MAX_LCORE; i++) {
+		if (!internal_cfg->service_cores[i])
+			continue;
+		if ((unsigned)i == cfg->master_lcore) {
+			RTE_LOG(ERR, EAL, "Master lcore %d cannot be a "
+				"service core\n", i);
+			return -1;
+		}
+		if (cfg->lcore_role[i] != ROLE_RTE) {
+			if (!lcore_config[i].detected) {
+				RTE_LOG(ERR, EAL, "Service lcore %d "
+					"unavailable\n", i);
+				return -1;
+			}
+			cfg->lcore_role[i] = ROLE_RTE;
+			lcore_config[i].core_index = cfg->lcore_count;
+			cfg->lcore_count++;
+		}
+	}
 
 	/* if no memory amounts were requested, this will result in 0 and
 	 * will be overridden later, right after eal_hugepage_info_init() */
@@ -998,12 +1133,6 @@ eal_check_common_options(struct internal_config *internal_cfg)
 			"be specified at the same time\n");
 		return -1;
 	}
-	if (internal_cfg->no_hugetlbfs && internal_cfg->force_sockets == 1) {
-		RTE_LOG(ERR, EAL, "Option --"OPT_SOCKET_MEM" cannot "
-			"be specified together with --"OPT_NO_HUGE"\n");
-		return -1;
-	}
-
 	if (internal_cfg->no_hugetlbfs && internal_cfg->hugepage_unlink) {
 		RTE_LOG(ERR, EAL, "Option --"OPT_HUGE_UNLINK" cannot "
 			"be specified together with --"OPT_NO_HUGE"\n");
@@ -1038,6 +1167,7 @@ eal_common_usage(void)
 	       "                      '( )' can be omitted for single element group,\n"
 	       "                      '@' can be omitted if cpus and lcores have the same value\n"
 	       "  --"OPT_MASTER_LCORE" ID   Core ID that is used as master\n"
+	       "  -s SERVICE COREMASK Hexadecimal bitmask of cores to be used as service cores\n"
 	       "  -n CHANNELS         Number of memory channels\n"
 	       "  -m MB               Memory to allocate (see also --"OPT_SOCKET_MEM")\n"
 	       "  -r RANKS            Force number of memory ranks (don't detect)\n"
@@ -1057,7 +1187,12 @@ eal_common_usage(void)
 	       "  --"OPT_VMWARE_TSC_MAP"    Use VMware TSC map instead of native RDTSC\n"
 	       "  --"OPT_PROC_TYPE"         Type of this process (primary|secondary|auto)\n"
 	       "  --"OPT_SYSLOG"            Set syslog facility\n"
-	       "  --"OPT_LOG_LEVEL"         Set default log level\n"
+	       "  --"OPT_LOG_LEVEL"         Set default log level, or the level of the\n"
+	       "                      log types matching a regexp with 'regexp,level'\n"
+	       "  --"OPT_LOG_ASYNC"         Write the logs of the lcores from a thread\n"
+	       "  --"OPT_TRACE"=PATTERN     Enable the tracepoints matching a glob pattern\n"
+	       "                      (can be used multiple times)\n"
+	       "  --"OPT_TRACE_DIR"=DIR     Directory of the saved trace\n"
 	       "  -v                  Display version information on startup\n"
 	       "  -h, --help          This help\n"
 	       "\nEAL options for DEBUG use only:\n"
@@ -35,6 +35,7 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <inttypes.h>
+#include <time.h>
 #include <sys/types.h>
 #include <errno.h>
 
@@ -88,6 +89,15 @@ set_tsc_freq(void)
 	eal_tsc_resolution_hz = freq;
 }
 
+uint64_t
+eal_get_time_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
 void rte_delay_us_callback_register(void (*userfunc)(unsigned int))
 {
 	rte_delay_us = userfunc;
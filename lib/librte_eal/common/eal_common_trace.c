@@ -0,0 +1,400 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fnmatch.h>
+#include <limits.h>
+#include <sys/queue.h>
+#include <sys/stat.h>
+
+#include <rte_eal.h>
+#include <rte_log.h>
+#include <rte_lcore.h>
+#include <rte_cycles.h>
+#include <rte_common.h>
+#include <rte_byteorder.h>
+#include <rte_version.h>
+#include <rte_trace.h>
+
+#include "eal_private.h"
+
+/* magic number of the CTF packet header */
+#define TRACE_CTF_MAGIC 0xC1FC1FC1
+
+/* one recorded event, fitting a cache line */
+struct trace_event {
+	uint64_t tsc;
+	uint16_t id;
+	uint16_t nb_args;
+	uint32_t reserved;
+	uint64_t args[RTE_TRACE_ARGS_MAX];
+};
+
+/* events of one lcore, written by this lcore only */
+struct trace_buf {
+	uint64_t head;        /* number of events recorded since reset */
+	struct trace_event *events;
+} __rte_cache_aligned;
+
+/* a pattern given with --trace, applied to the later registrations */
+struct trace_pattern {
+	TAILQ_ENTRY(trace_pattern) next;
+	char pattern[];
+};
+
+static struct trace_buf trace_bufs[RTE_MAX_LCORE];
+
+static struct rte_trace_point *trace_points[RTE_TRACE_POINT_MAX];
+static unsigned int trace_points_count;
+
+static TAILQ_HEAD(, trace_pattern) trace_patterns =
+	TAILQ_HEAD_INITIALIZER(trace_patterns);
+
+static const char *trace_dir;
+
+int
+rte_trace_point_register(struct rte_trace_point *tp)
+{
+	struct trace_pattern *p;
+	unsigned int i;
+
+	for (i = 0; i < trace_points_count; i++)
+		if (strcmp(trace_points[i]->name, tp->name) == 0)
+			return -EEXIST;
+	if (trace_points_count == RTE_TRACE_POINT_MAX)
+		return -ENOSPC;
+
+	for (i = 0; i < RTE_TRACE_ARGS_MAX; i++)
+		if (tp->fields[i] == NULL)
+			break;
+	tp->nb_fields = i;
+	tp->id = trace_points_count;
+	trace_points[trace_points_count++] = tp;
+
+	TAILQ_FOREACH(p, &trace_patterns, next)
+		if (fnmatch(p->pattern, tp->name, 0) == 0)
+			tp->enabled = 1;
+	return 0;
+}
+
+void
+__rte_trace_point_emit(const struct rte_trace_point *tp,
+		const uint64_t *args, unsigned int n)
+{
+	unsigned int lcore_id = rte_lcore_id();
+	struct trace_buf *buf;
+	struct trace_event *ev;
+	unsigned int i;
+
+	if (lcore_id >= RTE_MAX_LCORE)
+		return;
+	buf = &trace_bufs[lcore_id];
+	if (buf->events == NULL)
+		return;
+
+	ev = &buf->events[buf->head & (RTE_TRACE_BUF_SIZE - 1)];
+	ev->tsc = rte_rdtsc();
+	ev->id = tp->id;
+	ev->nb_args = tp->nb_fields;
+	n = RTE_MIN(n, (unsigned int)tp->nb_fields);
+	for (i = 0; i < n; i++)
+		ev->args[i] = args[i];
+	for (; i < tp->nb_fields; i++)
+		ev->args[i] = 0;
+	rte_compiler_barrier();
+	buf->head++;
+}
+
+struct rte_trace_point *
+rte_trace_point_lookup(const char *name)
+{
+	unsigned int i;
+
+	if (name == NULL)
+		return NULL;
+	for (i = 0; i < trace_points_count; i++)
+		if (strcmp(trace_points[i]->name, name) == 0)
+			return trace_points[i];
+	return NULL;
+}
+
+void
+rte_trace_point_enable(struct rte_trace_point *tp)
+{
+	tp->enabled = 1;
+}
+
+void
+rte_trace_point_disable(struct rte_trace_point *tp)
+{
+	tp->enabled = 0;
+}
+
+int
+rte_trace_point_is_enabled(const struct rte_trace_point *tp)
+{
+	return tp->enabled != 0;
+}
+
+int
+rte_trace_pattern(const char *pattern, int enable)
+{
+	unsigned int i;
+	int count = 0;
+
+	for (i = 0; i < trace_points_count; i++) {
+		if (fnmatch(pattern, trace_points[i]->name, 0) != 0)
+			continue;
+		trace_points[i]->enabled = !!enable;
+		count++;
+	}
+	return count;
+}
+
+void
+rte_trace_reset(void)
+{
+	unsigned int lcore_id;
+
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++)
+		trace_bufs[lcore_id].head = 0;
+}
+
+static int
+trace_metadata_save(const char *dir)
+{
+	char path[PATH_MAX];
+	const struct rte_trace_point *tp;
+	unsigned int i, j;
+	FILE *f;
+
+	snprintf(path, sizeof(path), "%s/metadata", dir);
+	f = fopen(path, "w");
+	if (f == NULL)
+		return -errno;
+
+	fprintf(f, "/* CTF 1.8 */\n\n");
+	fprintf(f, "typealias integer { size = 8; align = 8; signed = false; } := uint8_t;\n");
+	fprintf(f, "typealias integer { size = 16; align = 8; signed = false; } := uint16_t;\n");
+	fprintf(f, "typealias integer { size = 32; align = 8; signed = false; } := uint32_t;\n");
+	fprintf(f, "typealias integer { size = 64; align = 8; signed = false; } := uint64_t;\n\n");
+	fprintf(f, "trace {\n"
+		"\tmajor = 1;\n"
+		"\tminor = 8;\n"
+		"\tbyte_order = %s;\n"
+		"\tpacket.header := struct {\n"
+		"\t\tuint32_t magic;\n"
+		"\t};\n"
+		"};\n\n",
+		RTE_BYTE_ORDER == RTE_LITTLE_ENDIAN ? "le" : "be");
+	fprintf(f, "env {\n"
+		"\tdomain = \"dpdk\";\n"
+		"\tversion = \"%s\";\n"
+		"};\n\n", rte_version());
+	fprintf(f, "clock {\n"
+		"\tname = \"tsc\";\n"
+		"\tfreq = %" PRIu64 ";\n"
+		"};\n\n", rte_get_tsc_hz());
+	fprintf(f, "typealias integer {\n"
+		"\tsize = 64; align = 8; signed = false;\n"
+		"\tmap = clock.tsc.value;\n"
+		"} := uint64_clock_t;\n\n");
+	fprintf(f, "stream {\n"
+		"\tpacket.context := struct {\n"
+		"\t\tuint32_t lcore_id;\n"
+		"\t};\n"
+		"\tevent.header := struct {\n"
+		"\t\tuint64_clock_t timestamp;\n"
+		"\t\tuint16_t id;\n"
+		"\t};\n"
+		"};\n");
+
+	for (i = 0; i < trace_points_count; i++) {
+		tp = trace_points[i];
+		fprintf(f, "\nevent {\n"
+			"\tid = %u;\n"
+			"\tname = \"%s\";\n"
+			"\tfields := struct {\n", tp->id, tp->name);
+		for (j = 0; j < tp->nb_fields; j++)
+			fprintf(f, "\t\tuint64_t %s;\n", tp->fields[j]);
+		fprintf(f, "\t};\n};\n");
+	}
+
+	if (fclose(f) != 0)
+		return -errno;
+	return 0;
+}
+
+static int
+trace_stream_save(const char *dir, unsigned int lcore_id)
+{
+	const struct trace_buf *buf = &trace_bufs[lcore_id];
+	const struct trace_event *ev;
+	char path[PATH_MAX];
+	uint32_t header[2];
+	uint64_t head, first;
+	FILE *f;
+	int ret = 0;
+
+	snprintf(path, sizeof(path), "%s/channel0_%u", dir, lcore_id);
+	f = fopen(path, "w");
+	if (f == NULL)
+		return -errno;
+
+	header[0] = TRACE_CTF_MAGIC;
+	header[1] = lcore_id;
+	if (fwrite(header, sizeof(header), 1, f) != 1)
+		ret = -EIO;
+
+	head = buf->head;
+	first = head > RTE_TRACE_BUF_SIZE ? head - RTE_TRACE_BUF_SIZE : 0;
+	for (; ret == 0 && first < head; first++) {
+		ev = &buf->events[first & (RTE_TRACE_BUF_SIZE - 1)];
+		/* the CTF event is packed: timestamp, id, fields */
+		if (fwrite(&ev->tsc, sizeof(ev->tsc), 1, f) != 1 ||
+				fwrite(&ev->id, sizeof(ev->id), 1, f) != 1 ||
+				fwrite(ev->args, sizeof(ev->args[0]),
+					ev->nb_args, f) != ev->nb_args)
+			ret = -EIO;
+	}
+
+	if (fclose(f) != 0 && ret == 0)
+		ret = -errno;
+	return ret;
+}
+
+int
+rte_trace_save(const char *dir)
+{
+	unsigned int lcore_id;
+	int ret;
+
+	if (dir == NULL)
+		dir = trace_dir != NULL ? trace_dir : ".";
+	if (mkdir(dir, 0700) < 0 && errno != EEXIST) {
+		RTE_LOG(ERR, EAL, "Cannot create trace directory %s: %s\n",
+			dir, strerror(errno));
+		return -errno;
+	}
+
+	ret = trace_metadata_save(dir);
+	for (lcore_id = 0; ret == 0 && lcore_id < RTE_MAX_LCORE; lcore_id++)
+		if (trace_bufs[lcore_id].events != NULL)
+			ret = trace_stream_save(dir, lcore_id);
+	if (ret < 0)
+		RTE_LOG(ERR, EAL, "Cannot save trace in %s: %s\n",
+			dir, strerror(-ret));
+	return ret;
+}
+
+void
+rte_trace_dump(FILE *f)
+{
+	const struct rte_trace_point *tp;
+	const struct trace_buf *buf;
+	unsigned int i;
+
+	fprintf(f, "Tracepoints:\n");
+	for (i = 0; i < trace_points_count; i++) {
+		tp = trace_points[i];
+		fprintf(f, "  id:%u\t%-32s %s\n", tp->id, tp->name,
+			tp->enabled ? "enabled" : "disabled");
+	}
+	fprintf(f, "Trace buffers (%u events):\n", RTE_TRACE_BUF_SIZE);
+	for (i = 0; i < RTE_MAX_LCORE; i++) {
+		buf = &trace_bufs[i];
+		if (buf->events == NULL)
+			continue;
+		fprintf(f, "  lcore %u: %" PRIu64 " events, %" PRIu64
+			" overwritten\n", i, buf->head,
+			buf->head > RTE_TRACE_BUF_SIZE ?
+				buf->head - RTE_TRACE_BUF_SIZE : 0);
+	}
+}
+
+int
+eal_trace_pattern_add(const char *pattern)
+{
+	struct trace_pattern *p;
+
+	p = malloc(sizeof(*p) + strlen(pattern) + 1);
+	if (p == NULL)
+		return -1;
+	strcpy(p->pattern, pattern);
+	TAILQ_INSERT_TAIL(&trace_patterns, p, next);
+
+	rte_trace_pattern(pattern, 1);
+	return 0;
+}
+
+int
+eal_trace_dir_set(const char *dir)
+{
+	char *copy = strdup(dir);
+
+	if (copy == NULL)
+		return -1;
+	free((void *)(uintptr_t)trace_dir);
+	trace_dir = copy;
+	return 0;
+}
+
+int
+eal_trace_init(void)
+{
+	struct rte_config *cfg = rte_eal_get_configuration();
+	unsigned int lcore_id;
+
+	RTE_BUILD_BUG_ON(!rte_is_power_of_2(RTE_TRACE_BUF_SIZE));
+
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		if (cfg->lcore_role[lcore_id] == ROLE_OFF)
+			continue;
+		trace_bufs[lcore_id].events = calloc(RTE_TRACE_BUF_SIZE,
+			sizeof(struct trace_event));
+		if (trace_bufs[lcore_id].events == NULL)
+			goto error;
+	}
+	return 0;
+
+error:
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		free(trace_bufs[lcore_id].events);
+		trace_bufs[lcore_id].events = NULL;
+	}
+	return -1;
+}
@@ -84,9 +84,27 @@ eal_hugepage_info_path(void)
 	return buffer;
 }
 
+/** Path of the socket giving the memory fd to the secondary processes. */
+#define MEMFD_SOCKET_FMT "%s/.%s_mem_socket"
+
+static inline const char *
+eal_memfd_socket_path(void)
+{
+	static char buffer[PATH_MAX]; /* static so auto-zeroed */
+	const char *directory = default_config_dir;
+	const char *home_dir = getenv("HOME");
+
+	if (getuid() != 0 && home_dir != NULL)
+		directory = home_dir;
+	snprintf(buffer, sizeof(buffer) - 1, MEMFD_SOCKET_FMT, directory,
+			internal_config.hugefile_prefix);
+	return buffer;
+}
+
 /** String format for hugepage map files. */
 #define HUGEFILE_FMT "%s/%smap_%d"
 #define TEMP_HUGEFILE_FMT "%s/%smap_temp_%d"
+#define DYN_HUGEFILE_FMT "%s/%smap_dyn_%u_%u"
 
 static inline const char *
 eal_get_hugefile_path(char *buffer, size_t buflen, const char *hugedir, int f_id)
@@ -97,6 +115,16 @@ eal_get_hugefile_path(char *buffer, size_t buflen, const char *hugedir, int f_id
 	return buffer;
 }
 
+static inline const char *
+eal_get_dyn_hugefile_path(char *buffer, size_t buflen, const char *hugedir,
+		unsigned id, unsigned page)
+{
+	snprintf(buffer, buflen, DYN_HUGEFILE_FMT, hugedir,
+			internal_config.hugefile_prefix, id, page);
+	buffer[buflen - 1] = '\0';
+	return buffer;
+}
+
 /** define the default filename prefix for the %s values above */
 #define HUGEFILE_PREFIX_DEFAULT "rte"
 
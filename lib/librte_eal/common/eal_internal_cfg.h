@@ -65,6 +65,10 @@ struct internal_config {
 	volatile unsigned force_nrank;    /**< force number of ranks */
 	volatile unsigned no_hugetlbfs;   /**< true to disable hugetlbfs */
 	unsigned hugepage_unlink;         /**< true to unlink backing files */
+	unsigned dynamic_mem;             /**< true to grow memory on demand */
+	/** memory per socket added after init in dynamic memory mode */
+	uint64_t dynamic_socket_mem[RTE_MAX_NUMA_NODES];
+	enum rte_iova_mode iova_mode;     /**< IOVA mode, RTE_IOVA_DC if auto */
 	volatile unsigned xen_dom0_support; /**< support app running on Xen Dom0*/
 	volatile unsigned no_pci;         /**< true to disable PCI */
 	volatile unsigned no_hpet;        /**< true to disable HPET */
@@ -79,6 +83,8 @@ struct internal_config {
 	uintptr_t base_virtaddr;          /**< base address to try and reserve memory from */
 	volatile int syslog_facility;	  /**< facility passed to openlog() */
 	volatile uint32_t log_level;	  /**< default log level */
+	volatile unsigned log_async;      /**< true to log from a thread */
+	uint8_t service_cores[RTE_MAX_LCORE]; /**< lcores given with -s */
 	/** default interrupt mode for VFIO */
 	volatile enum rte_intr_mode vfio_intr_mode;
 	const char *hugefile_prefix;      /**< the base filename of hugetlbfs files */
@@ -35,6 +35,8 @@
 #define _EAL_PRIVATE_H_
 
 #include <stdio.h>
+#include <stdint.h>
+#include <rte_memory.h>
 #include <rte_pci.h>
 
 /**
@@ -59,6 +61,62 @@ int rte_eal_memzone_init(void);
  */
 void eal_log_set_default(FILE *default_log);
 
+/**
+ * Start the asynchronous logging with the --log-async option: allocate
+ * the message queue of each enabled lcore and create the logging thread.
+ *
+ * This function is private to EAL.
+ *
+ * @return
+ *   0 on success, -1 on error.
+ */
+int eal_log_async_init(void);
+
+/**
+ * Allocate the trace buffer of each enabled lcore.
+ *
+ * This function is private to EAL.
+ *
+ * @return
+ *   0 on success, -1 on error.
+ */
+int eal_trace_init(void);
+
+/**
+ * Enable the tracepoints matching a pattern given with the --trace option,
+ * including the tracepoints registered later.
+ *
+ * This function is private to EAL.
+ *
+ * @param pattern
+ *   The glob pattern.
+ * @return
+ *   0 on success, -1 on error.
+ */
+int eal_trace_pattern_add(const char *pattern);
+
+/**
+ * Set the default directory of the trace, given with the --trace-dir option.
+ *
+ * This function is private to EAL.
+ *
+ * @param dir
+ *   The directory.
+ * @return
+ *   0 on success, -1 on error.
+ */
+int eal_trace_dir_set(const char *dir);
+
+/**
+ * Turn the lcores given with the -s option into service cores.
+ *
+ * This function is private to EAL.
+ *
+ * @return
+ *   0 on success, -1 on error.
+ */
+int eal_service_init(void);
+
 /**
  * Fill configuration with number of physical and logical processors
  *
@@ -301,4 +359,103 @@ int rte_eal_hugepage_init(void);
  */
 int rte_eal_hugepage_attach(void);
 
+/**
+ * Map at least len more bytes of hugepages on a socket, in new memsegs
+ * appended to the memseg array. Used in dynamic memory mode only.
+ *
+ * This function is private to the EAL.
+ *
+ * @param socket_id
+ *   Socket of the new memory.
+ * @param len
+ *   Minimum amount of memory to add.
+ * @param n_memseg
+ *   Number of memsegs added.
+ * @return
+ *   Index of the first memseg added, or -1 on error.
+ */
+int eal_memory_grow(int socket_id, size_t len, unsigned *n_memseg);
+
+/**
+ * Unmap the memory added by the last call to eal_memory_grow(), and return
+ * it to the system. Used in dynamic memory mode only.
+ *
+ * This function is private to the EAL.
+ *
+ * @param memseg_id
+ *   Index of the first memseg of the memory to release.
+ * @return
+ *   0 on success, -1 if this memory was not the last one added.
+ */
+int eal_memory_shrink(unsigned memseg_id);
+
+/**
+ * Map the memory added by the other processes and unmap the memory they
+ * released since the last call. Used in dynamic memory mode only.
+ *
+ * This function is private to the EAL.
+ */
+void eal_memory_sync(void);
+
+/**
+ * Register this process as a user of the dynamic memory, map the memory
+ * added so far and start the thread which maps the memory added later by
+ * the other processes. Used in dynamic memory mode only.
+ *
+ * This function is private to the EAL.
+ *
+ * @return
+ *   0 on success, -1 on error.
+ */
+int eal_memory_sync_init(void);
+
+/**
+ * Call the functions registered with rte_mem_event_callback_register().
+ *
+ * This function is private to the EAL.
+ *
+ * @param event
+ *   The change of the memory layout.
+ * @param ms
+ *   A copy of the memsegs added or removed.
+ * @param n_memseg
+ *   The number of memsegs.
+ */
+void eal_mem_event_notify(enum rte_mem_event event,
+		const struct rte_memseg *ms, unsigned n_memseg);
+
+/**
+ * Map the memory of the primary process when it runs without hugetlbfs:
+ * a memfd with one memseg per socket, given to the secondary processes
+ * over a UNIX socket.
+ *
+ * This function is private to the EAL.
+ *
+ * @return
+ *   0 on success, -1 on error.
+ */
+int eal_memfd_init(void);
+
+/**
+ * Map the memfd of a primary process running without hugetlbfs, at the
+ * same address.
+ *
+ * This function is private to the EAL.
+ *
+ * @return
+ *   0 on success, -1 on error.
+ */
+int eal_memfd_attach(void);
+
+/**
+ * Get the time of a monotonic clock in microseconds, usable before the
+ * timers are initialized, to measure the duration of the init phases.
+ *
+ * This function is private to the EAL.
+ *
+ * @return
+ *   Time in microseconds.
+ */
+uint64_t eal_get_time_us(void);
+
 #endif /* _EAL_PRIVATE_H_ */
@@ -326,6 +326,8 @@ rte_memcpy(void *dst, const void *src, size_t n)
 
 #endif /* RTE_ARCH_ARM_NEON_MEMCPY */
 
+#define rte_memcpy_nt(dst, src, n) rte_memcpy((dst), (src), (n))
+
 #ifdef __cplusplus
 }
 #endif
@@ -80,6 +80,8 @@ rte_mov256(uint8_t *dst, const uint8_t *src)
 
 #define rte_memcpy(d, s, n)	memcpy((d), (s), (n))
 
+#define rte_memcpy_nt(d, s, n)	rte_memcpy((d), (s), (n))
+
 #ifdef __cplusplus
 }
 #endif
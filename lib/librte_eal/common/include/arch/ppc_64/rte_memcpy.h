@@ -219,6 +219,8 @@ rte_memcpy_func(void *dst, const void *src, size_t n)
 	return ret;
 }
 
+#define rte_memcpy_nt(dst, src, n) rte_memcpy((dst), (src), (n))
+
 #ifdef __cplusplus
 }
 #endif
@@ -67,6 +67,64 @@ extern "C" {
 static inline void *
 rte_memcpy(void *dst, const void *src, size_t n) __attribute__((always_inline));
 
+/**
+ * Copy bytes from one location to another with non-temporal stores, which
+ * do not pull the destination into the cache. It is meant for large
+ * buffers which are not read again soon. The locations must not overlap.
+ *
+ * @param dst
+ *   Pointer to the destination of the data.
+ * @param src
+ *   Pointer to the source data.
+ * @param n
+ *   Number of bytes to copy.
+ * @return
+ *   Pointer to the destination data.
+ */
+static inline void *
+rte_memcpy_nt(void *dst, const void *src, size_t n);
+
+/**
+ * Instruction set of the rte_memcpy() variants.
+ */
+enum rte_memcpy_isa {
+	RTE_MEMCPY_ISA_SSE,     /**< 16-byte moves. */
+	RTE_MEMCPY_ISA_AVX2,    /**< 32-byte moves. */
+	RTE_MEMCPY_ISA_AVX512F, /**< 64-byte moves. */
+};
+
+/**
+ * Select the variant of rte_memcpy() and rte_memcpy_nt() used for large
+ * copies. The widest variant supported by the CPU is selected at startup.
+ * It must not be called while other threads copy memory.
+ *
+ * @param isa
+ *   The instruction set of the variant.
+ * @return
+ *   0 on success, -ENOTSUP if not supported by the CPU or the build.
+ */
+int rte_memcpy_isa_set(enum rte_memcpy_isa isa);
+
+/**
+ * Get the instruction set of the variant selected for large copies.
+ *
+ * @return
+ *   The instruction set of the variant.
+ */
+enum rte_memcpy_isa rte_memcpy_isa_get(void);
+
+/**
+ * @internal Copies larger than this go through the variant selected at
+ * runtime, and smaller ones are inlined.
+ */
+#define RTE_MEMCPY_DISPATCH_THRESH 128
+
+/** @internal rte_memcpy() variant selected at runtime. */
+extern void *(*rte_memcpy_ptr)(void *dst, const void *src, size_t n);
+
+/** @internal rte_memcpy_nt() variant selected at runtime. */
+extern void *(*rte_memcpy_nt_ptr)(void *dst, const void *src, size_t n);
+
 #ifdef RTE_MACHINE_CPUFLAG_AVX512F
 
 #define ALIGNMENT_MASK 0x3F
@@ -888,7 +946,7 @@ rte_memcpy_aligned(void *dst, const void *src, size_t n)
 }
 
 static inline void *
-rte_memcpy(void *dst, const void *src, size_t n)
+rte_memcpy_internal(void *dst, const void *src, size_t n)
 {
 	if (!(((uintptr_t)dst | (uintptr_t)src) & ALIGNMENT_MASK))
 		return rte_memcpy_aligned(dst, src, n);
@@ -896,6 +954,22 @@ rte_memcpy(void *dst, const void *src, size_t n)
 		return rte_memcpy_generic(dst, src, n);
 }
 
+static inline void *
+rte_memcpy(void *dst, const void *src, size_t n)
+{
+#ifdef RTE_MEMCPY_RUNTIME_DISPATCH
+	if (n > RTE_MEMCPY_DISPATCH_THRESH)
+		return (*rte_memcpy_ptr)(dst, src, n);
+#endif
+	return rte_memcpy_internal(dst, src, n);
+}
+
+static inline void *
+rte_memcpy_nt(void *dst, const void *src, size_t n)
+{
+	return (*rte_memcpy_nt_ptr)(dst, src, n);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -136,6 +136,24 @@ rte_mov256(uint8_t *dst, const uint8_t *src);
 static void *
 rte_memcpy(void *dst, const void *src, size_t n);
 
+/**
+ * Copy bytes from one location to another with non-temporal stores, which
+ * do not pull the destination into the cache, if the architecture has them.
+ * It is meant for large buffers which are not read again soon.
+ * The locations must not overlap.
+ *
+ * @param dst
+ *   Pointer to the destination of the data.
+ * @param src
+ *   Pointer to the source data.
+ * @param n
+ *   Number of bytes to copy.
+ * @return
+ *   Pointer to the destination data.
+ */
+static void *
+rte_memcpy_nt(void *dst, const void *src, size_t n);
+
 #endif /* __DOXYGEN__ */
 
 #endif /* _RTE_MEMCPY_H_ */
@@ -56,11 +56,12 @@ extern "C" {
 #define RTE_MAX_THREAD_NAME_LEN 16
 
 /**
- * The lcore role (used in RTE or not).
+ * The lcore role (used in RTE, as a service core, or not).
  */
 enum rte_lcore_role_t {
 	ROLE_RTE,
 	ROLE_OFF,
+	ROLE_SERVICE,
 };
 
 /**
@@ -234,6 +235,29 @@ rte_set_application_usage_hook(rte_usage_hook_t usage_func);
  */
 int rte_eal_has_hugepages(void);
 
+/**
+ * IO virtual address type, the address devices use for DMA.
+ */
+enum rte_iova_mode {
+	RTE_IOVA_DC = 0, /**< Not set, let the EAL select it */
+	RTE_IOVA_PA,     /**< DMA using physical addresses */
+	RTE_IOVA_VA      /**< DMA using virtual addresses, through an IOMMU */
+};
+
+/**
+ * Get the IO virtual address type used by the memory of the EAL.
+ *
+ * In RTE_IOVA_VA mode, the physical addresses of the memsegs, and the
+ * result of rte_mem_virt2phy(), are the virtual addresses. This mode is
+ * selected, when not forced by the --iova-mode option, if all the devices
+ * are behind an IOMMU (VFIO) and no kernel module uses the physical addresses
+ * of the memory.
+ *
+ * @return
+ *   RTE_IOVA_PA or RTE_IOVA_VA.
+ */
+enum rte_iova_mode rte_eal_iova_mode(void);
+
 /**
  * A wrap API for syscall gettid.
  *
@@ -34,6 +34,8 @@
 #ifndef _RTE_EAL_MEMCONFIG_H_
 #define _RTE_EAL_MEMCONFIG_H_
 
+#include <limits.h>
+
 #include <rte_tailq.h>
 #include <rte_memory.h>
 #include <rte_memzone.h>
@@ -44,6 +46,9 @@
 extern "C" {
 #endif
 
+/** Maximum number of processes using the dynamic memory. */
+#define RTE_DYNMEM_MAX_PROCS 32
+
 /**
  * the structure for the memory configuration for the RTE.
  * Used by the rte_config structure. It is separated out, as for multi-process
@@ -78,6 +83,28 @@ struct rte_mem_config {
 	/* Heaps of Malloc per socket */
 	struct malloc_heap malloc_heaps[RTE_MAX_NUMA_NODES];
 
+	/* dynamic memory, added after init by the --dynamic-mem mode */
+	rte_spinlock_t dynmem_lock;   /**< Lock for dynamic memseg changes. */
+	uint32_t dynmem_first;        /**< First dynamic memseg, 0 if none. */
+	volatile uint32_t dynmem_gen; /**< Incremented on each change. */
+	uint64_t dynmem_page_sz;      /**< Hugepage size of dynamic memory. */
+	char dynmem_dir[PATH_MAX];    /**< Hugetlbfs mount of dynamic memory. */
+	/** First memseg of the mapping each dynamic memseg belongs to. */
+	uint16_t dynmem_map[RTE_MAX_MEMSEG];
+	/** Generation the mapping starting at each memseg was created in. */
+	uint32_t dynmem_id[RTE_MAX_MEMSEG];
+	rte_spinlock_t dynmem_grow_lock; /**< Serializes the memory changes. */
+	uint32_t dynmem_pinned;       /**< First memseg which can be released. */
+	/** Processes using the dynamic memory, and the last dynmem_gen each
+	 * has mapped. */
+	struct {
+		volatile uint32_t pid;
+		volatile uint32_t gen;
+	} dynmem_procs[RTE_DYNMEM_MAX_PROCS];
+
+	uint32_t iova_mode;           /**< See rte_eal_iova_mode(). */
+	uint32_t no_hugetlbfs;        /**< Memory backed by a memfd. */
+
 	/* address of mem_config in primary process. used to map shared config into
 	 * exact same address the primary process maps it.
 	 */
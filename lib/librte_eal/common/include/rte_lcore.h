@@ -167,7 +167,8 @@ rte_lcore_to_socket_id(unsigned lcore_id)
  *   The identifier of the lcore, which MUST be between 0 and
  *   RTE_MAX_LCORE-1.
  * @return
- *   True if the given lcore is enabled; false otherwise.
+ *   True if the given lcore is enabled; false otherwise, or if it is a
+ *   service core.
  */
 static inline int
 rte_lcore_is_enabled(unsigned lcore_id)
@@ -175,7 +176,7 @@ rte_lcore_is_enabled(unsigned lcore_id)
 	struct rte_config *cfg = rte_eal_get_configuration();
 	if (lcore_id >= RTE_MAX_LCORE)
 		return 0;
-	return cfg->lcore_role[lcore_id] != ROLE_OFF;
+	return cfg->lcore_role[lcore_id] == ROLE_RTE;
 }
 
 /**
@@ -50,46 +50,53 @@ extern "C" {
 #include <stdio.h>
 #include <stdarg.h>
 
+struct rte_log_dynamic_type;
+
 /** The rte_log structure. */
 struct rte_logs {
-	uint32_t type;  /**< Bitfield with enabled logs. */
+	uint32_t type;  /**< Bitfield with enabled static logs. */
 	uint32_t level; /**< Log level. */
 	FILE *file;     /**< Output file set by rte_openlog_stream, or NULL. */
+	size_t dynamic_types_len; /**< Number of log types. */
+	struct rte_log_dynamic_type *dynamic_types; /**< Name and level. */
 };
 
 /** Global log informations */
 extern struct rte_logs rte_logs;
 
 /* SDK log type */
-#define RTE_LOGTYPE_EAL     0x00000001 /**< Log related to eal. */
-#define RTE_LOGTYPE_MALLOC  0x00000002 /**< Log related to malloc. */
-#define RTE_LOGTYPE_RING    0x00000004 /**< Log related to ring. */
-#define RTE_LOGTYPE_MEMPOOL 0x00000008 /**< Log related to mempool. */
-#define RTE_LOGTYPE_TIMER   0x00000010 /**< Log related to timers. */
-#define RTE_LOGTYPE_PMD     0x00000020 /**< Log related to poll mode driver. */
-#define RTE_LOGTYPE_HASH    0x00000040 /**< Log related to hash table. */
-#define RTE_LOGTYPE_LPM     0x00000080 /**< Log related to LPM. */
-#define RTE_LOGTYPE_KNI     0x00000100 /**< Log related to KNI. */
-#define RTE_LOGTYPE_ACL     0x00000200 /**< Log related to ACL. */
-#define RTE_LOGTYPE_POWER   0x00000400 /**< Log related to power. */
-#define RTE_LOGTYPE_METER   0x00000800 /**< Log related to QoS meter. */
-#define RTE_LOGTYPE_SCHED   0x00001000 /**< Log related to QoS port scheduler. */
-#define RTE_LOGTYPE_PORT    0x00002000 /**< Log related to port. */
-#define RTE_LOGTYPE_TABLE   0x00004000 /**< Log related to table. */
-#define RTE_LOGTYPE_PIPELINE 0x00008000 /**< Log related to pipeline. */
-#define RTE_LOGTYPE_MBUF    0x00010000 /**< Log related to mbuf. */
-#define RTE_LOGTYPE_CRYPTODEV 0x00020000 /**< Log related to cryptodev. */
-#define RTE_LOGTYPE_EFD     0x00040000 /**< Log related to EFD. */
+#define RTE_LOGTYPE_EAL        0 /**< Log related to eal. */
+#define RTE_LOGTYPE_MALLOC     1 /**< Log related to malloc. */
+#define RTE_LOGTYPE_RING       2 /**< Log related to ring. */
+#define RTE_LOGTYPE_MEMPOOL    3 /**< Log related to mempool. */
+#define RTE_LOGTYPE_TIMER      4 /**< Log related to timers. */
+#define RTE_LOGTYPE_PMD        5 /**< Log related to poll mode driver. */
+#define RTE_LOGTYPE_HASH       6 /**< Log related to hash table. */
+#define RTE_LOGTYPE_LPM        7 /**< Log related to LPM. */
+#define RTE_LOGTYPE_KNI        8 /**< Log related to KNI. */
+#define RTE_LOGTYPE_ACL        9 /**< Log related to ACL. */
+#define RTE_LOGTYPE_POWER     10 /**< Log related to power. */
+#define RTE_LOGTYPE_METER     11 /**< Log related to QoS meter. */
+#define RTE_LOGTYPE_SCHED     12 /**< Log related to QoS port scheduler. */
+#define RTE_LOGTYPE_PORT      13 /**< Log related to port. */
+#define RTE_LOGTYPE_TABLE     14 /**< Log related to table. */
+#define RTE_LOGTYPE_PIPELINE  15 /**< Log related to pipeline. */
+#define RTE_LOGTYPE_MBUF      16 /**< Log related to mbuf. */
+#define RTE_LOGTYPE_CRYPTODEV 17 /**< Log related to cryptodev. */
+#define RTE_LOGTYPE_EFD       18 /**< Log related to EFD. */
 
 /* these log types can be used in an application */
-#define RTE_LOGTYPE_USER1   0x01000000 /**< User-defined log type 1. */
-#define RTE_LOGTYPE_USER2   0x02000000 /**< User-defined log type 2. */
-#define RTE_LOGTYPE_USER3   0x04000000 /**< User-defined log type 3. */
-#define RTE_LOGTYPE_USER4   0x08000000 /**< User-defined log type 4. */
-#define RTE_LOGTYPE_USER5   0x10000000 /**< User-defined log type 5. */
-#define RTE_LOGTYPE_USER6   0x20000000 /**< User-defined log type 6. */
-#define RTE_LOGTYPE_USER7   0x40000000 /**< User-defined log type 7. */
-#define RTE_LOGTYPE_USER8   0x80000000 /**< User-defined log type 8. */
+#define RTE_LOGTYPE_USER1     24 /**< User-defined log type 1. */
+#define RTE_LOGTYPE_USER2     25 /**< User-defined log type 2. */
+#define RTE_LOGTYPE_USER3     26 /**< User-defined log type 3. */
+#define RTE_LOGTYPE_USER4     27 /**< User-defined log type 4. */
+#define RTE_LOGTYPE_USER5     28 /**< User-defined log type 5. */
+#define RTE_LOGTYPE_USER6     29 /**< User-defined log type 6. */
+#define RTE_LOGTYPE_USER7     30 /**< User-defined log type 7. */
+#define RTE_LOGTYPE_USER8     31 /**< User-defined log type 8. */
+
+/** First identifier for log types registered with rte_log_register(). */
+#define RTE_LOGTYPE_FIRST_EXT_ID 32
 
 /* Can't use 0, as it gives compiler warnings */
 #define RTE_LOG_EMERG    1U  /**< System is unusable.               */
@@ -136,7 +143,9 @@ uint32_t rte_get_log_level(void);
  * Enable or disable the log type.
  *
  * @param type
- *   Log type, for example, RTE_LOGTYPE_EAL.
+ *   Log type, for example, RTE_LOGTYPE_EAL, or a type returned by
+ *   rte_log_register(), whose level is then set to RTE_LOG_DEBUG or 0.
+ *   The log types are identifiers, not bit masks, and cannot be combined.
  * @param enable
  *   True for enable; false for disable.
  */
@@ -144,9 +153,109 @@ void rte_set_log_type(uint32_t type, int enable);
 
 /**
  * Get the global log type.
+ *
+ * @return
+ *   The bitfield of the enabled log types below RTE_LOGTYPE_FIRST_EXT_ID.
  */
 uint32_t rte_get_log_type(void);
 
+/**
+ * Register a dynamic log type.
+ *
+ * If a log type with the same name is already registered, its identifier
+ * is returned. The level of a new log type is RTE_LOG_DEBUG, unless a
+ * pattern given to rte_log_set_level_regexp() matches its name, so that
+ * only the global level applies to it.
+ *
+ * This function is not multi-thread safe, it is meant to be called from
+ * constructors or at initialization.
+ *
+ * @param name
+ *   The string identifying the log type, for example "pmd.ixgbe.rx".
+ * @return
+ *   - >=0: the log type identifier, to use with rte_log().
+ *   - (-ENOMEM): cannot allocate memory.
+ */
+int rte_log_register(const char *name);
+
+/**
+ * Set the level of a log type.
+ *
+ * The messages of this type are displayed if their level is lower or equal
+ * than both this level and the global one.
+ *
+ * @param logtype
+ *   The log type identifier.
+ * @param level
+ *   Log level. A value between RTE_LOG_EMERG (1) and RTE_LOG_DEBUG (8).
+ * @return
+ *   0 on success, a negative value if logtype or level is invalid.
+ */
+int rte_log_set_level(uint32_t logtype, uint32_t level);
+
+/**
+ * Set the level of the log types whose name matches a regular expression,
+ * including the ones registered later.
+ *
+ * @param pattern
+ *   POSIX extended regular expression matched against the log type names.
+ * @param level
+ *   Log level. A value between RTE_LOG_EMERG (1) and RTE_LOG_DEBUG (8).
+ * @return
+ *   0 on success, a negative value on error.
+ */
+int rte_log_set_level_regexp(const char *pattern, uint32_t level);
+
+/**
+ * Get the level of a log type.
+ *
+ * @param logtype
+ *   The log type identifier.
+ * @return
+ *   The level, or a negative value if logtype is invalid.
+ */
+int rte_log_get_level(uint32_t logtype);
+
+/**
+ * Dump the log types, their level, and the asynchronous logging counters.
+ *
+ * @param f
+ *   A pointer to a file for output.
+ */
+void rte_log_dump(FILE *f);
+
+/** Counters of the asynchronous logging of an lcore. */
+struct rte_log_async_stats {
+	uint64_t queued;  /**< Messages queued for the logging thread. */
+	uint64_t dropped; /**< Messages dropped as the queue was full. */
+};
+
+/**
+ * Get the counters of the asynchronous logging of an lcore.
+ *
+ * With the --log-async EAL option, the messages logged by the lcores, of
+ * level RTE_LOG_ERR or lower priority, are formatted in a per-lcore queue
+ * and written by a logging thread. They are dropped when the queue is full.
+ *
+ * @param lcore_id
+ *   The lcore identifier.
+ * @param stats
+ *   The counters of this lcore.
+ * @return
+ *   0 on success, -EINVAL if lcore_id is invalid.
+ */
+int rte_log_async_stats_get(unsigned lcore_id,
+		struct rte_log_async_stats *stats);
+
+/**
+ * Write all the queued messages from the calling thread, and return once
+ * they are written. It is called by rte_exit(), rte_panic() and at exit(),
+ * so that the last messages are not lost.
+ *
+ * Does nothing without the --log-async EAL option.
+ */
+void rte_log_async_flush(void);
+
 /**
  * Get the current loglevel for the message being processed.
  *
@@ -58,6 +58,11 @@ struct rte_malloc_socket_stats {
 	unsigned free_count;       /**< Number of free elements on heap */
 	unsigned alloc_count;      /**< Number of allocated elements on heap */
 	size_t heap_allocsz_bytes; /**< Total allocated bytes on heap */
+	uint64_t contention_count; /**< Times the heap lock was found taken */
+	uint64_t cache_hit_count;  /**< Allocations served by lcore caches */
+	uint64_t cache_miss_count; /**< Lcore cache refills from the heap */
+	unsigned cache_count;      /**< Elements held in lcore caches, these are
+	                                counted as allocated on the heap */
 };
 
 /**
@@ -35,6 +35,7 @@
 #define _RTE_MALLOC_HEAP_H_
 
 #include <stddef.h>
+#include <stdint.h>
 #include <sys/queue.h>
 #include <rte_spinlock.h>
 #include <rte_memory.h>
@@ -50,6 +51,7 @@ struct malloc_heap {
 	LIST_HEAD(, malloc_elem) free_head[RTE_HEAP_NUM_FREELISTS];
 	unsigned alloc_count;
 	size_t total_size;
+	uint64_t contention_count; /* times the lock was found taken */
 } __rte_cache_aligned;
 
 #endif /* _RTE_MALLOC_HEAP_H_ */
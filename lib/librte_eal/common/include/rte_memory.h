@@ -195,6 +195,60 @@ unsigned rte_memory_get_nchannel(void);
  */
 unsigned rte_memory_get_nrank(void);
 
+/**
+ * Changes of the memory layout reported to the memory event callbacks.
+ */
+enum rte_mem_event {
+	RTE_MEM_EVENT_ALLOC, /**< Memsegs were added and mapped. */
+	RTE_MEM_EVENT_FREE,  /**< Memsegs were unmapped and removed. */
+};
+
+/**
+ * Function called when memsegs are added or removed after init, which
+ * happens in dynamic memory mode (--dynamic-mem) only.
+ *
+ * It is called in every process using the memory, once the memsegs are
+ * mapped in this process for RTE_MEM_EVENT_ALLOC, and once they are
+ * unmapped for RTE_MEM_EVENT_FREE. It may be called from a thread of the
+ * EAL. It must not allocate or free memory from the DPDK heaps.
+ *
+ * @param event
+ *   The change of the memory layout.
+ * @param ms
+ *   A copy of the memsegs added or removed.
+ * @param n_memseg
+ *   The number of memsegs.
+ * @param arg
+ *   The argument given at registration.
+ */
+typedef void (*rte_mem_event_callback_t)(enum rte_mem_event event,
+		const struct rte_memseg *ms, unsigned int n_memseg, void *arg);
+
+/**
+ * Register a function to call when memsegs are added or removed.
+ *
+ * @param cb
+ *   The function to call.
+ * @param arg
+ *   The argument to give to the function.
+ * @return
+ *   0 on success, -1 if too many functions are registered.
+ */
+int rte_mem_event_callback_register(rte_mem_event_callback_t cb, void *arg);
+
+/**
+ * Unregister a function registered with rte_mem_event_callback_register().
+ * Once this function returns, cb is not running and will not be called.
+ *
+ * @param cb
+ *   The function given at registration.
+ * @param arg
+ *   The argument given at registration.
+ * @return
+ *   0 on success, -1 if the function was not registered.
+ */
+int rte_mem_event_callback_unregister(rte_mem_event_callback_t cb, void *arg);
+
 #ifdef RTE_LIBRTE_XEN_DOM0
 
 /**< Internal use only - should DOM0 memory mapping be used */
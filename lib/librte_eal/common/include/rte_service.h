@@ -0,0 +1,382 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _RTE_SERVICE_H_
+#define _RTE_SERVICE_H_
+
+/**
+ * @file
+ *
+ * RTE Service Cores
+ *
+ * A service is a background task, such as a software scheduler or a timer
+ * manager, registered by a library, a driver or the application. The
+ * services are run by the service cores: lcores which do not run the
+ * application, and which call in a loop the services mapped to them.
+ * Several services can share a service core, and a service which is
+ * multi-thread safe can be mapped to several service cores at once.
+ *
+ * The service cores are given with the -s EAL option, or taken from the
+ * application lcores with rte_service_lcore_add().
+ *
+ * The registration, mapping and start/stop functions are not thread safe,
+ * and must be called from the control path.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdint.h>
+
+/** Maximum number of services. */
+#define RTE_SERVICE_NUM_MAX 64
+
+/** Maximum length of a service name, including the terminating '\0'. */
+#define RTE_SERVICE_NAME_MAX 32
+
+/**
+ * The service can be run on several service cores at the same time.
+ * Otherwise, the service cores mapped to it take turns calling it.
+ */
+#define RTE_SERVICE_CAP_MT_SAFE (1 << 0)
+
+/**
+ * Function run by a service.
+ *
+ * @param args
+ *   The callback_userdata of the service specification.
+ * @return
+ *   0 if some work was done, a negative value otherwise.
+ */
+typedef int32_t (*rte_service_func)(void *args);
+
+/**
+ * Specification of a service, given to rte_service_register().
+ */
+struct rte_service_spec {
+	char name[RTE_SERVICE_NAME_MAX]; /**< Unique name of the service. */
+	rte_service_func callback;       /**< Function run by the service. */
+	void *callback_userdata;         /**< Argument of the callback. */
+	uint32_t capabilities;           /**< RTE_SERVICE_CAP_* flags. */
+	int socket_id;                   /**< Preferred socket, or -1 (any). */
+};
+
+/**
+ * Statistics of a service, summed over the lcores running it.
+ */
+struct rte_service_stats {
+	uint64_t calls;  /**< Number of calls of the callback. */
+	uint64_t cycles; /**< TSC cycles spent in the callback. */
+};
+
+/**
+ * Register a new service. The service is stopped and mapped to no core.
+ *
+ * @param spec
+ *   The specification of the service, copied by the function.
+ * @param service_id
+ *   Filled with the identifier of the service.
+ * @return
+ *   - 0: Success.
+ *   - -EINVAL: Invalid specification, or name already registered.
+ *   - -ENOSPC: No more space for services.
+ */
+int32_t rte_service_register(const struct rte_service_spec *spec,
+		uint32_t *service_id);
+
+/**
+ * Unregister a service, and unmap it from all the service cores.
+ *
+ * @param id
+ *   The identifier of the service.
+ * @return
+ *   - 0: Success.
+ *   - -EINVAL: Invalid service identifier.
+ *   - -EBUSY: The service is running.
+ */
+int32_t rte_service_unregister(uint32_t id);
+
+/**
+ * Get the number of registered services.
+ *
+ * @return
+ *   The number of registered services.
+ */
+uint32_t rte_service_get_count(void);
+
+/**
+ * Get the identifier of a service from its name.
+ *
+ * @param name
+ *   The name of the service.
+ * @param service_id
+ *   Filled with the identifier of the service.
+ * @return
+ *   - 0: Success.
+ *   - -EINVAL: Invalid name.
+ *   - -ENODEV: No service with this name.
+ */
+int32_t rte_service_get_by_name(const char *name, uint32_t *service_id);
+
+/**
+ * Get the name of a service.
+ *
+ * @param id
+ *   The identifier of the service.
+ * @return
+ *   The name of the service, or NULL if the identifier is invalid.
+ */
+const char *rte_service_get_name(uint32_t id);
+
+/**
+ * Check if a service has some capabilities.
+ *
+ * @param id
+ *   The identifier of the service.
+ * @param capability
+ *   The RTE_SERVICE_CAP_* flags to check.
+ * @return
+ *   1 if the service has all the capabilities, 0 otherwise.
+ */
+int32_t rte_service_probe_capability(uint32_t id, uint32_t capability);
+
+/**
+ * Map or unmap a service to a service core.
+ *
+ * @param id
+ *   The identifier of the service.
+ * @param lcore
+ *   The identifier of the service core.
+ * @param enable
+ *   1 to map the service to the core, 0 to unmap it.
+ * @return
+ *   - 0: Success.
+ *   - -EINVAL: Invalid service, or lcore which is not a service core.
+ */
+int32_t rte_service_map_lcore_set(uint32_t id, uint32_t lcore,
+		uint32_t enable);
+
+/**
+ * Check if a service is mapped to a service core.
+ *
+ * @param id
+ *   The identifier of the service.
+ * @param lcore
+ *   The identifier of the service core.
+ * @return
+ *   1 if mapped, 0 if not mapped, -EINVAL on invalid parameters.
+ */
+int32_t rte_service_map_lcore_get(uint32_t id, uint32_t lcore);
+
+/**
+ * Start or stop a service. A started service is run by the started
+ * service cores it is mapped to.
+ *
+ * @param id
+ *   The identifier of the service.
+ * @param runstate
+ *   1 to start the service, 0 to stop it.
+ * @return
+ *   0 on success, -EINVAL if the service is invalid.
+ */
+int32_t rte_service_runstate_set(uint32_t id, uint32_t runstate);
+
+/**
+ * Get the run state of a service.
+ *
+ * @param id
+ *   The identifier of the service.
+ * @return
+ *   1 if the service is started, 0 if it is stopped, -EINVAL if invalid.
+ */
+int32_t rte_service_runstate_get(uint32_t id);
+
+/**
+ * Run a started service once on the calling lcore, for the applications
+ * which call a service from their own loop. A service which is not
+ * multi-thread safe is not run if another core is running it.
+ *
+ * @param id
+ *   The identifier of the service.
+ * @return
+ *   - 0: The service was run.
+ *   - -EINVAL: Invalid service identifier.
+ *   - -ENOEXEC: The service is stopped.
+ *   - -EBUSY: The service is being run by another core.
+ */
+int32_t rte_service_run_iter_on_app_lcore(uint32_t id);
+
+/**
+ * Enable or disable the measure of the cycles spent in a service.
+ * The calls of the services are always counted.
+ *
+ * @param id
+ *   The identifier of the service.
+ * @param enable
+ *   1 to read the TSC around the service calls, 0 otherwise.
+ * @return
+ *   0 on success, -EINVAL if the service is invalid.
+ */
+int32_t rte_service_set_stats_enable(uint32_t id, int32_t enable);
+
+/**
+ * Get the statistics of a service.
+ *
+ * @param id
+ *   The identifier of the service.
+ * @param stats
+ *   Filled with the statistics of the service.
+ * @return
+ *   0 on success, -EINVAL if the service is invalid.
+ */
+int32_t rte_service_stats_get(uint32_t id, struct rte_service_stats *stats);
+
+/**
+ * Reset the statistics of a service.
+ *
+ * @param id
+ *   The identifier of the service.
+ * @return
+ *   0 on success, -EINVAL if the service is invalid.
+ */
+int32_t rte_service_stats_reset(uint32_t id);
+
+/**
+ * Dump the state and statistics of a service, or of all the services
+ * and service cores.
+ *
+ * @param f
+ *   A pointer to a file for output.
+ * @param id
+ *   The identifier of the service, or UINT32_MAX for all of them.
+ * @return
+ *   0 on success, -EINVAL if the service is invalid.
+ */
+int32_t rte_service_dump(FILE *f, uint32_t id);
+
+/**
+ * Map each service to a service core, round-robin among the service cores
+ * of its preferred socket if any, then start all the services and service
+ * cores.
+ *
+ * @return
+ *   0 on success, -ENOTSUP if there is no service core.
+ */
+int32_t rte_service_start_with_defaults(void);
+
+/**
+ * Turn an application lcore into a service core. The lcore must be a
+ * slave lcore waiting for work; it is no longer part of RTE_LCORE_FOREACH()
+ * and rte_lcore_count().
+ *
+ * @param lcore
+ *   The identifier of the lcore.
+ * @return
+ *   - 0: Success.
+ *   - -EINVAL: Invalid lcore, or master lcore.
+ *   - -EALREADY: The lcore is already a service core.
+ *   - -EBUSY: The lcore is running a function.
+ */
+int32_t rte_service_lcore_add(uint32_t lcore);
+
+/**
+ * Give a stopped service core back to the application.
+ *
+ * @param lcore
+ *   The identifier of the service core.
+ * @return
+ *   - 0: Success.
+ *   - -EINVAL: The lcore is not a service core.
+ *   - -EBUSY: The service core is running.
+ */
+int32_t rte_service_lcore_del(uint32_t lcore);
+
+/**
+ * Start a service core: launch the loop running its mapped services.
+ *
+ * @param lcore
+ *   The identifier of the service core.
+ * @return
+ *   - 0: Success.
+ *   - -EINVAL: The lcore is not a service core.
+ *   - -EALREADY: The service core is already running.
+ */
+int32_t rte_service_lcore_start(uint32_t lcore);
+
+/**
+ * Stop a service core, and wait for the end of its loop.
+ *
+ * @param lcore
+ *   The identifier of the service core.
+ * @return
+ *   - 0: Success.
+ *   - -EINVAL: The lcore is not a service core.
+ *   - -EALREADY: The service core is already stopped.
+ */
+int32_t rte_service_lcore_stop(uint32_t lcore);
+
+/**
+ * Stop all the service cores, unmap all the services, and give the
+ * service cores back to the application.
+ *
+ * @return
+ *   0 on success.
+ */
+int32_t rte_service_lcore_reset_all(void);
+
+/**
+ * Get the number of service cores.
+ *
+ * @return
+ *   The number of service cores.
+ */
+int32_t rte_service_lcore_count(void);
+
+/**
+ * Get the list of the service cores.
+ *
+ * @param array
+ *   Filled with the identifiers of the service cores.
+ * @param n
+ *   The size of the array.
+ * @return
+ *   The number of service cores, or -ENOMEM if the array is too small.
+ */
+int32_t rte_service_lcore_list(uint32_t array[], uint32_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RTE_SERVICE_H_ */
@@ -0,0 +1,226 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _RTE_TRACE_H_
+#define _RTE_TRACE_H_
+
+/**
+ * @file
+ *
+ * RTE Trace
+ *
+ * A tracepoint is a named event, with up to RTE_TRACE_ARGS_MAX integer
+ * fields, compiled in the fast path of a library or an application.
+ * A disabled tracepoint costs a load and a predicted branch. When enabled,
+ * each hit records the TSC, the tracepoint identifier and the fields into
+ * a ring buffer private to the calling lcore, which overwrites the oldest
+ * events when it is full. Non-EAL threads are not traced.
+ *
+ * The tracepoints are enabled at runtime by name or by glob pattern, or
+ * with the --trace EAL option, and the buffers are saved in the Common
+ * Trace Format (CTF), which can be read by tools like babeltrace or
+ * Trace Compass.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <rte_common.h>
+#include <rte_branch_prediction.h>
+
+/** Maximum number of fields of a tracepoint. */
+#define RTE_TRACE_ARGS_MAX 6
+
+/** Maximum number of registered tracepoints. */
+#define RTE_TRACE_POINT_MAX 256
+
+/**
+ * A tracepoint. It must be defined with RTE_TRACE_POINT_DEFINE().
+ */
+struct rte_trace_point {
+	volatile int enabled;   /**< Non-zero if the events are recorded. */
+	uint16_t id;            /**< Identifier of the event in the trace. */
+	uint16_t nb_fields;     /**< Number of fields of the event. */
+	const char *name;       /**< Name, like "lib.ring.enqueue". */
+	/** Names of the fields, recorded as 64-bit unsigned integers. */
+	const char *fields[RTE_TRACE_ARGS_MAX];
+};
+
+/**
+ * Define a tracepoint and register it at startup.
+ *
+ * @param tp
+ *   The name of the tracepoint variable.
+ * @param tp_name
+ *   The name of the tracepoint, used to enable it and in the trace.
+ * @param ...
+ *   The names of the fields of the tracepoint, as string literals.
+ */
+#define RTE_TRACE_POINT_DEFINE(tp, tp_name, ...)			\
+struct rte_trace_point tp = {						\
+	.name = tp_name,						\
+	.fields = { __VA_ARGS__ },					\
+};									\
+static void __attribute__((constructor, used))			\
+tp##_register(void)							\
+{									\
+	rte_trace_point_register(&tp);					\
+}
+
+/**
+ * Record an event if the tracepoint is enabled.
+ *
+ * @param tp
+ *   The tracepoint variable.
+ * @param ...
+ *   The values of the fields, as integers, in the order of the definition.
+ */
+#define rte_trace_point_emit(tp, ...) do {				\
+	if (unlikely((tp).enabled)) {					\
+		const uint64_t __args[] = { __VA_ARGS__ };		\
+		__rte_trace_point_emit(&(tp), __args, RTE_DIM(__args));	\
+	}								\
+} while (0)
+
+/**
+ * Register a tracepoint. Called by RTE_TRACE_POINT_DEFINE().
+ *
+ * The tracepoint is enabled if its name matches a pattern given
+ * with the --trace EAL option.
+ *
+ * @param tp
+ *   The tracepoint.
+ * @return
+ *   0 on success, -EEXIST if the name is already registered,
+ *   -ENOSPC if there are too many tracepoints.
+ */
+int rte_trace_point_register(struct rte_trace_point *tp);
+
+/**
+ * Record an event of a tracepoint. Use rte_trace_point_emit() instead.
+ *
+ * @param tp
+ *   The tracepoint.
+ * @param args
+ *   The values of the fields.
+ * @param n
+ *   The number of values; missing fields are recorded as 0.
+ */
+void __rte_trace_point_emit(const struct rte_trace_point *tp,
+		const uint64_t *args, unsigned int n);
+
+/**
+ * Get a tracepoint from its name.
+ *
+ * @param name
+ *   The name of the tracepoint.
+ * @return
+ *   The tracepoint, or NULL if not found.
+ */
+struct rte_trace_point *rte_trace_point_lookup(const char *name);
+
+/**
+ * Enable a tracepoint.
+ *
+ * @param tp
+ *   The tracepoint.
+ */
+void rte_trace_point_enable(struct rte_trace_point *tp);
+
+/**
+ * Disable a tracepoint.
+ *
+ * @param tp
+ *   The tracepoint.
+ */
+void rte_trace_point_disable(struct rte_trace_point *tp);
+
+/**
+ * Check if a tracepoint is enabled.
+ *
+ * @param tp
+ *   The tracepoint.
+ * @return
+ *   1 if enabled, 0 otherwise.
+ */
+int rte_trace_point_is_enabled(const struct rte_trace_point *tp);
+
+/**
+ * Enable or disable the tracepoints whose name matches a glob pattern,
+ * like "lib.ring.*".
+ *
+ * @param pattern
+ *   The glob pattern, as understood by fnmatch(3).
+ * @param enable
+ *   1 to enable the tracepoints, 0 to disable them.
+ * @return
+ *   The number of matching tracepoints.
+ */
+int rte_trace_pattern(const char *pattern, int enable);
+
+/**
+ * Forget the events recorded on all the lcores.
+ * The tracepoints should be disabled or the lcores idle.
+ */
+void rte_trace_reset(void);
+
+/**
+ * Save the events recorded on all the lcores as a CTF trace: a metadata
+ * file and one stream file per lcore. The tracepoints should be disabled
+ * or the lcores idle, otherwise the oldest events may be overwritten
+ * while saved.
+ *
+ * @param dir
+ *   The directory, created if needed, or NULL for the directory given
+ *   with the --trace-dir EAL option, or the current directory.
+ * @return
+ *   0 on success, a negative errno value otherwise.
+ */
+int rte_trace_save(const char *dir);
+
+/**
+ * Dump the tracepoints and the state of the trace buffers.
+ *
+ * @param f
+ *   A pointer to a file for output.
+ */
+void rte_trace_dump(FILE *f);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RTE_TRACE_H_ */
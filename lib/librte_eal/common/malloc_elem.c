@@ -268,13 +268,9 @@ join_elem(struct malloc_elem *elem1, struct malloc_elem *elem2)
  * blocks either immediately before or immediately after newly freed block
  * are also free, the blocks are merged together.
  */
-int
-malloc_elem_free(struct malloc_elem *elem)
+void
+malloc_elem_free_locked(struct malloc_elem *elem)
 {
-	if (!malloc_elem_cookies_ok(elem) || elem->state != ELEM_BUSY)
-		return -1;
-
-	rte_spinlock_lock(&(elem->heap->lock));
 	size_t sz = elem->size - sizeof(*elem);
 	uint8_t *ptr = (uint8_t *)&elem[1];
 	struct malloc_elem *next = RTE_PTR_ADD(elem, elem->size);
@@ -301,8 +297,20 @@ malloc_elem_free(struct malloc_elem *elem)
 	elem->heap->alloc_count--;
 
 	memset(ptr, 0, sz);
+}
+
+int
+malloc_elem_free(struct malloc_elem *elem)
+{
+	struct malloc_heap *heap;
+
+	if (!malloc_elem_cookies_ok(elem) || elem->state != ELEM_BUSY)
+		return -1;
 
-	rte_spinlock_unlock(&(elem->heap->lock));
+	heap = elem->heap;
+	malloc_heap_lock(heap);
+	malloc_elem_free_locked(elem);
+	rte_spinlock_unlock(&heap->lock);
 
 	return 0;
 }
@@ -321,7 +329,7 @@ malloc_elem_resize(struct malloc_elem *elem, size_t size)
 		return 0;
 
 	struct malloc_elem *next = RTE_PTR_ADD(elem, elem->size);
-	rte_spinlock_lock(&elem->heap->lock);
+	malloc_heap_lock(elem->heap);
 	if (next ->state != ELEM_FREE)
 		goto err_return;
 	if (current_size + next->size < new_size)
@@ -31,10 +31,12 @@
  *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #include <stdint.h>
+#include <inttypes.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <string.h>
 #include <errno.h>
 #include <sys/queue.h>
 
@@ -53,6 +55,33 @@
 #include "malloc_elem.h"
 #include "malloc_heap.h"
 
+/*
+ * Per-lcore caches of small elements, sitting in front of the heap free
+ * lists. Cache class i holds elements with a data size of at least
+ * (RTE_CACHE_LINE_SIZE << i) bytes and less than twice that. Refills and
+ * flushes move half a cache at a time, so the heap lock is taken once per
+ * batch of elements.
+ */
+#define MALLOC_CACHE_NUM_CLASSES 4
+#define MALLOC_CACHE_MAX_SIZE \
+	(RTE_CACHE_LINE_SIZE << (MALLOC_CACHE_NUM_CLASSES - 1))
+#define MALLOC_CACHE_BURST ((RTE_MALLOC_CACHE_SIZE + 1) / 2)
+
+struct malloc_cache_class {
+	unsigned len;
+	struct malloc_elem *objs[RTE_MALLOC_CACHE_SIZE];
+};
+
+struct malloc_cache {
+	const struct malloc_heap *heap; /* heap the cache is bound to */
+	uint64_t hit_count;
+	uint64_t miss_count;
+	struct malloc_cache_class classes[MALLOC_CACHE_NUM_CLASSES];
+} __rte_cache_aligned;
+
+/* Process private, as lcore ids are not shared between processes */
+static struct malloc_cache malloc_caches[RTE_MAX_LCORE];
+
 static unsigned
 check_hugepage_sz(unsigned flags, uint64_t hugepage_sz)
 {
@@ -90,6 +119,20 @@ check_hugepage_sz(unsigned flags, uint64_t hugepage_sz)
 	return check_flag & flags;
 }
 
+/*
+ * Size of the free element covering a whole memseg, as set by
+ * malloc_heap_add_memseg().
+ */
+static size_t
+malloc_heap_memseg_elem_size(const struct rte_memseg *ms)
+{
+	struct malloc_elem *end_elem = RTE_PTR_ADD(ms->addr,
+			ms->len - MALLOC_ELEM_OVERHEAD);
+
+	end_elem = RTE_PTR_ALIGN_FLOOR(end_elem, RTE_CACHE_LINE_SIZE);
+	return RTE_PTR_DIFF(end_elem, ms->addr);
+}
+
 /*
  * Expand the heap with a memseg.
  * This reserves the zone and sets a dummy malloc_elem header at the end
@@ -101,10 +144,8 @@ malloc_heap_add_memseg(struct malloc_heap *heap, struct rte_memseg *ms)
 {
 	/* allocate the memory block headers, one at end, one at start */
 	struct malloc_elem *start_elem = (struct malloc_elem *)ms->addr;
-	struct malloc_elem *end_elem = RTE_PTR_ADD(ms->addr,
-			ms->len - MALLOC_ELEM_OVERHEAD);
-	end_elem = RTE_PTR_ALIGN_FLOOR(end_elem, RTE_CACHE_LINE_SIZE);
-	const size_t elem_size = (uintptr_t)end_elem - (uintptr_t)start_elem;
+	const size_t elem_size = malloc_heap_memseg_elem_size(ms);
+	struct malloc_elem *end_elem = RTE_PTR_ADD(start_elem, elem_size);
 
 	malloc_elem_init(start_elem, heap, ms, elem_size);
 	malloc_elem_mkend(end_elem, start_elem);
@@ -145,25 +186,231 @@ find_suitable_element(struct malloc_heap *heap, size_t size,
 	return NULL;
 }
 
+/*
+ * In dynamic memory mode, add at least len bytes of hugepages to the heap.
+ * Called with the heap lock held, which is released while the pages are
+ * populated and mapped in all the processes. Returns 0 on success.
+ */
+static int
+malloc_heap_add_dynmem(struct malloc_heap *heap, size_t len)
+{
+	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
+	unsigned i, n_memseg;
+	int first;
+
+	rte_spinlock_unlock(&heap->lock);
+	first = eal_memory_grow(heap - mcfg->malloc_heaps, len, &n_memseg);
+	rte_spinlock_lock(&heap->lock);
+	if (first < 0)
+		return -1;
+
+	for (i = first; i < first + n_memseg; i++)
+		malloc_heap_add_memseg(heap, &mcfg->memseg[i]);
+
+	return 0;
+}
+
+/*
+ * In dynamic memory mode, add hugepages to the heap for an element of the
+ * given size, alignment and boundary. Called with the heap lock held, see
+ * malloc_heap_add_dynmem(). Returns 0 on success.
+ */
+static int
+malloc_heap_grow(struct malloc_heap *heap, size_t size, unsigned flags,
+		size_t align, size_t bound)
+{
+	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
+
+	if (!internal_config.dynamic_mem)
+		return -1;
+
+	if (!(flags & RTE_MEMZONE_SIZE_HINT_ONLY) &&
+			!check_hugepage_sz(flags, mcfg->dynmem_page_sz))
+		return -1;
+
+	/* a bounded element fits in twice its size, whatever the boundary */
+	if (bound != 0)
+		size *= 2;
+
+	return malloc_heap_add_dynmem(heap,
+		size + align + 3 * MALLOC_ELEM_OVERHEAD);
+}
+
+/*
+ * In dynamic memory mode, give the last hugepages added by
+ * malloc_heap_grow() back to the system, once they belong to this heap and
+ * are entirely free. Only the last ones can be released, as the memsegs are
+ * kept contiguous, and the ones added at init for --socket-mem are kept.
+ * Called with the heap lock held, which is released while the pages are
+ * unmapped.
+ */
+static void
+malloc_heap_shrink(struct malloc_heap *heap)
+{
+	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
+	const int socket_id = heap - mcfg->malloc_heaps;
+	struct malloc_elem *elem;
+	struct rte_memseg *ms;
+	unsigned first, last, i;
+	int ret;
+
+	for (last = mcfg->dynmem_first;
+			last < RTE_MAX_MEMSEG && mcfg->memseg[last].len > 0;
+			last++)
+		;
+	if (last == mcfg->dynmem_first)
+		return;
+	first = mcfg->dynmem_map[last - 1];
+	if (first < mcfg->dynmem_pinned)
+		return;
+
+	/* the memory of other sockets may not be mapped yet, check the
+	 * socket before looking at the elements */
+	for (i = first; i < last; i++) {
+		ms = &mcfg->memseg[i];
+		if (ms->socket_id != socket_id)
+			return;
+		elem = ms->addr;
+		if (elem->heap != heap || elem->state != ELEM_FREE ||
+				elem->size != malloc_heap_memseg_elem_size(ms))
+			return;
+	}
+
+	/* the elements span whole memsegs, nothing merges with them while
+	 * they are out of the free lists */
+	for (i = first; i < last; i++) {
+		elem = mcfg->memseg[i].addr;
+		LIST_REMOVE(elem, free_list);
+		heap->total_size -= elem->size;
+	}
+
+	rte_spinlock_unlock(&heap->lock);
+	ret = eal_memory_shrink(first);
+	rte_spinlock_lock(&heap->lock);
+	if (ret == 0)
+		return;
+
+	/* another process added memory meanwhile, keep this one */
+	for (i = first; i < last; i++) {
+		elem = mcfg->memseg[i].addr;
+		malloc_elem_free_list_insert(elem);
+		heap->total_size += elem->size;
+	}
+}
+
+/*
+ * Get the cache of the calling lcore for the given heap. Each lcore caches
+ * the elements of the first heap it allocates from, which normally is the
+ * heap of its own socket. Returns NULL for non-EAL threads.
+ */
+static inline struct malloc_cache *
+malloc_cache_get(const struct malloc_heap *heap)
+{
+	unsigned lcore_id = rte_lcore_id();
+	struct malloc_cache *cache;
+
+	if (RTE_MALLOC_CACHE_SIZE == 0 || lcore_id >= RTE_MAX_LCORE)
+		return NULL;
+
+	cache = &malloc_caches[lcore_id];
+	if (cache->heap == NULL)
+		cache->heap = heap;
+
+	return cache->heap == heap ? cache : NULL;
+}
+
+/*
+ * Allocate an element from the lcore cache, refilling the cache from the
+ * heap with a single lock/unlock when it is empty.
+ */
+static struct malloc_elem *
+malloc_cache_alloc(struct malloc_heap *heap, struct malloc_cache *cache,
+		size_t size)
+{
+	struct malloc_cache_class *cc;
+	struct malloc_elem *elem;
+	size_t idx, class_size;
+	int grown = 0;
+
+	for (idx = 0, class_size = RTE_CACHE_LINE_SIZE; class_size < size;
+			idx++, class_size <<= 1)
+		;
+	cc = &cache->classes[idx];
+
+	if (cc->len == 0) {
+		cache->miss_count++;
+
+		malloc_heap_lock(heap);
+		while (cc->len < MALLOC_CACHE_BURST) {
+			elem = find_suitable_element(heap, class_size, 0,
+				RTE_CACHE_LINE_SIZE, 0);
+			if (elem == NULL && cc->len == 0 && !grown &&
+					malloc_heap_grow(heap, class_size, 0,
+						RTE_CACHE_LINE_SIZE, 0) == 0) {
+				grown = 1;
+				continue;
+			}
+			if (elem == NULL)
+				break;
+
+			elem = malloc_elem_alloc(elem, class_size,
+				RTE_CACHE_LINE_SIZE, 0);
+			heap->alloc_count++;
+
+			/* padded elements are handed out, but never cached */
+			if (elem->state == ELEM_PAD) {
+				rte_spinlock_unlock(&heap->lock);
+				return elem;
+			}
+
+			elem->state = ELEM_CACHED;
+			cc->objs[cc->len++] = elem;
+		}
+		rte_spinlock_unlock(&heap->lock);
+
+		if (cc->len == 0)
+			return NULL;
+	} else
+		cache->hit_count++;
+
+	elem = cc->objs[--cc->len];
+	elem->state = ELEM_BUSY;
+
+	return elem;
+}
+
 /*
  * Main function to allocate a block of memory from the heap.
- * It locks the free list, scans it, and adds a new memseg if the
- * scan fails. Once the new memseg is added, it re-scans and should return
- * the new element after releasing the lock.
+ * It locks the free list, scans it, and adds new memsegs if the
+ * scan fails in dynamic memory mode. Once the new memsegs are added, it
+ * re-scans and should return the new element after releasing the lock.
  */
 void *
 malloc_heap_alloc(struct malloc_heap *heap,
 		const char *type __attribute__((unused)), size_t size, unsigned flags,
 		size_t align, size_t bound)
 {
+	struct malloc_cache *cache;
 	struct malloc_elem *elem;
 
 	size = RTE_CACHE_LINE_ROUNDUP(size);
 	align = RTE_CACHE_LINE_ROUNDUP(align);
 
-	rte_spinlock_lock(&heap->lock);
+	if (size <= MALLOC_CACHE_MAX_SIZE && align == RTE_CACHE_LINE_SIZE &&
+			flags == 0 && bound == 0) {
+		cache = malloc_cache_get(heap);
+		if (cache != NULL) {
+			elem = malloc_cache_alloc(heap, cache, size);
+			return elem == NULL ? NULL : (void *)(&elem[1]);
+		}
+	}
+
+	malloc_heap_lock(heap);
 
 	elem = find_suitable_element(heap, size, flags, align, bound);
+	if (elem == NULL &&
+			malloc_heap_grow(heap, size, flags, align, bound) == 0)
+		elem = find_suitable_element(heap, size, flags, align, bound);
 	if (elem != NULL) {
 		elem = malloc_elem_alloc(elem, size, align, bound);
 		/* increase heap's count of allocated elements */
@@ -174,6 +421,82 @@ malloc_heap_alloc(struct malloc_heap *heap,
 	return elem == NULL ? NULL : (void *)(&elem[1]);
 }
 
+/*
+ * Free a block of memory to the heap free lists, releasing the dynamic
+ * memory it belongs to when it is now unused.
+ */
+static int
+malloc_heap_free_uncached(struct malloc_elem *elem)
+{
+	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
+	struct malloc_heap *heap = elem->heap;
+	const struct rte_memseg *ms = elem->ms;
+	int ret;
+
+	ret = malloc_elem_free(elem);
+	if (ret == 0 && internal_config.dynamic_mem &&
+			ms >= &mcfg->memseg[mcfg->dynmem_first]) {
+		malloc_heap_lock(heap);
+		malloc_heap_shrink(heap);
+		rte_spinlock_unlock(&heap->lock);
+	}
+
+	return ret;
+}
+
+/*
+ * Free a block of memory, keeping it in the lcore cache when it is small
+ * enough. Half of the cache is returned to the heap, with a single
+ * lock/unlock, when the cache is full.
+ */
+int
+malloc_heap_free(struct malloc_elem *elem)
+{
+	struct malloc_heap *heap;
+	struct malloc_cache *cache;
+	struct malloc_cache_class *cc;
+	size_t idx, data_size;
+	unsigned i;
+
+	if (!malloc_elem_cookies_ok(elem) || elem->state != ELEM_BUSY)
+		return -1;
+
+	heap = elem->heap;
+	data_size = elem->size - MALLOC_ELEM_OVERHEAD;
+	if (elem->pad != 0 || data_size < RTE_CACHE_LINE_SIZE ||
+			data_size >= 2 * MALLOC_CACHE_MAX_SIZE)
+		return malloc_heap_free_uncached(elem);
+
+	cache = malloc_cache_get(heap);
+	if (cache == NULL)
+		return malloc_heap_free_uncached(elem);
+
+	for (idx = 0; (size_t)(RTE_CACHE_LINE_SIZE << (idx + 1)) <= data_size;
+			idx++)
+		;
+	cc = &cache->classes[idx];
+
+	if (cc->len == RTE_MALLOC_CACHE_SIZE) {
+		malloc_heap_lock(heap);
+		for (i = 0; i < MALLOC_CACHE_BURST; i++)
+			malloc_elem_free_locked(cc->objs[i]);
+		if (internal_config.dynamic_mem)
+			malloc_heap_shrink(heap);
+		rte_spinlock_unlock(&heap->lock);
+
+		cc->len -= MALLOC_CACHE_BURST;
+		memmove(&cc->objs[0], &cc->objs[MALLOC_CACHE_BURST],
+			cc->len * sizeof(cc->objs[0]));
+	}
+
+	/* the heap hands out zeroed memory */
+	memset(&elem[1], 0, data_size);
+	elem->state = ELEM_CACHED;
+	cc->objs[cc->len++] = elem;
+
+	return 0;
+}
+
 /*
  * Function to retrieve data for heap on given socket
  */
@@ -182,6 +505,7 @@ malloc_heap_get_stats(const struct malloc_heap *heap,
 		struct rte_malloc_socket_stats *socket_stats)
 {
 	size_t idx;
+	unsigned lcore_id;
 	struct malloc_elem *elem;
 
 	/* Initialise variables for heap */
@@ -205,6 +529,23 @@ malloc_heap_get_stats(const struct malloc_heap *heap,
 	socket_stats->heap_allocsz_bytes = (socket_stats->heap_totalsz_bytes -
 			socket_stats->heap_freesz_bytes);
 	socket_stats->alloc_count = heap->alloc_count;
+	socket_stats->contention_count = heap->contention_count;
+
+	/* Get stats on the lcore caches bound to this heap */
+	socket_stats->cache_hit_count = 0;
+	socket_stats->cache_miss_count = 0;
+	socket_stats->cache_count = 0;
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		const struct malloc_cache *cache = &malloc_caches[lcore_id];
+
+		if (cache->heap != heap)
+			continue;
+
+		socket_stats->cache_hit_count += cache->hit_count;
+		socket_stats->cache_miss_count += cache->miss_count;
+		for (idx = 0; idx < MALLOC_CACHE_NUM_CLASSES; idx++)
+			socket_stats->cache_count += cache->classes[idx].len;
+	}
 	return 0;
 }
 
@@ -212,8 +553,10 @@ int
 rte_eal_malloc_heap_init(void)
 {
 	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
-	unsigned ms_cnt;
+	struct malloc_heap *heap;
+	unsigned ms_cnt, socket_id;
 	struct rte_memseg *ms;
+	int ret;
 
 	if (mcfg == NULL)
 		return -1;
@@ -224,5 +567,30 @@ rte_eal_malloc_heap_init(void)
 		malloc_heap_add_memseg(&mcfg->malloc_heaps[ms->socket_id], ms);
 	}
 
+	/* in dynamic memory mode, add the memory given with --socket-mem,
+	 * which is never released */
+	for (socket_id = 0; internal_config.dynamic_mem &&
+			socket_id < RTE_MAX_NUMA_NODES; socket_id++) {
+		heap = &mcfg->malloc_heaps[socket_id];
+		if (internal_config.dynamic_socket_mem[socket_id] == 0)
+			continue;
+
+		rte_spinlock_lock(&heap->lock);
+		ret = malloc_heap_add_dynmem(heap,
+			internal_config.dynamic_socket_mem[socket_id]);
+		rte_spinlock_unlock(&heap->lock);
+		if (ret < 0) {
+			RTE_LOG(ERR, EAL, "Cannot get %"PRIu64" MB of memory "
+				"on socket %u\n",
+				internal_config.dynamic_socket_mem[socket_id] >> 20,
+				socket_id);
+			return -1;
+		}
+	}
+	for (ms_cnt = 0; ms_cnt < RTE_MAX_MEMSEG &&
+			mcfg->memseg[ms_cnt].len > 0; ms_cnt++)
+		;
+	mcfg->dynmem_pinned = ms_cnt;
+
 	return 0;
 }
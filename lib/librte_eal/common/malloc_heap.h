@@ -37,6 +37,9 @@
 #include <rte_malloc.h>
 #include <rte_malloc_heap.h>
 
+#include "eal_internal_cfg.h"
+#include "eal_private.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -52,10 +55,30 @@ malloc_get_numa_socket(void)
 	return socket_id;
 }
 
+/*
+ * Lock the heap, counting the times the lock was found taken. In dynamic
+ * memory mode, the memory added by other processes is mapped first, so that
+ * the heap elements are all accessible while the lock is held.
+ */
+static inline void
+malloc_heap_lock(struct malloc_heap *heap)
+{
+	if (!rte_spinlock_trylock(&heap->lock)) {
+		rte_spinlock_lock(&heap->lock);
+		heap->contention_count++;
+	}
+
+	if (internal_config.dynamic_mem)
+		eal_memory_sync();
+}
+
 void *
 malloc_heap_alloc(struct malloc_heap *heap,	const char *type, size_t size,
 		unsigned flags, size_t align, size_t bound);
 
+int
+malloc_heap_free(struct malloc_elem *elem);
+
 int
 malloc_heap_get_stats(const struct malloc_heap *heap,
 		struct rte_malloc_socket_stats *socket_stats);
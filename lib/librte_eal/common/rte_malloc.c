@@ -32,6 +32,7 @@
  */
 
 #include <stdint.h>
+#include <inttypes.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
@@ -58,7 +59,7 @@
 void rte_free(void *addr)
 {
 	if (addr == NULL) return;
-	if (malloc_elem_free(malloc_elem_from_data(addr)) < 0)
+	if (malloc_heap_free(malloc_elem_from_data(addr)) < 0)
 		rte_panic("Fatal error: Invalid memory\n");
 }
 
@@ -231,6 +232,13 @@ rte_malloc_dump_stats(FILE *f, __rte_unused const char *type)
 				sock_stats.greatest_free_size);
 		fprintf(f, "\tAlloc_count:%u,\n",sock_stats.alloc_count);
 		fprintf(f, "\tFree_count:%u,\n", sock_stats.free_count);
+		fprintf(f, "\tContention_count:%"PRIu64",\n",
+				sock_stats.contention_count);
+		fprintf(f, "\tCache_hit_count:%"PRIu64",\n",
+				sock_stats.cache_hit_count);
+		fprintf(f, "\tCache_miss_count:%"PRIu64",\n",
+				sock_stats.cache_miss_count);
+		fprintf(f, "\tCache_count:%u,\n", sock_stats.cache_count);
 	}
 	return;
 }
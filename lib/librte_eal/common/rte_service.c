@@ -0,0 +1,596 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+
+#include <rte_common.h>
+#include <rte_memory.h>
+#include <rte_eal.h>
+#include <rte_lcore.h>
+#include <rte_launch.h>
+#include <rte_atomic.h>
+#include <rte_cycles.h>
+#include <rte_log.h>
+#include <rte_service.h>
+
+#include "eal_private.h"
+#include "eal_internal_cfg.h"
+
+#define SERVICE_F_REGISTERED (1 << 0)
+#define SERVICE_F_STATS_ENABLED (1 << 1)
+
+#define RUNSTATE_STOPPED 0
+#define RUNSTATE_RUNNING 1
+
+/* a registered service */
+struct rte_service_spec_impl {
+	struct rte_service_spec spec;
+	/* held by the core running a service which is not MT safe */
+	rte_atomic32_t execute_lock;
+	volatile uint8_t flags;
+	volatile uint8_t runstate;
+	/* number of service cores the service is mapped to */
+	rte_atomic32_t num_mapped_cores;
+} __rte_cache_aligned;
+
+/* the counters of a service on one core, written by this core only */
+struct service_core_stats {
+	uint64_t calls;
+	uint64_t cycles;
+};
+
+/* the state of an lcore, as a service core */
+struct core_state {
+	/* bit i is set if service i is mapped to the core */
+	volatile uint64_t service_mask;
+	volatile uint8_t runstate;
+	uint8_t is_service_core;
+	uint64_t loops;
+	struct service_core_stats stats[RTE_SERVICE_NUM_MAX];
+} __rte_cache_aligned;
+
+static struct rte_service_spec_impl rte_services[RTE_SERVICE_NUM_MAX];
+static struct core_state lcore_states[RTE_MAX_LCORE];
+static uint32_t rte_service_count;
+
+static inline int
+service_valid(uint32_t id)
+{
+	return id < RTE_SERVICE_NUM_MAX &&
+		(rte_services[id].flags & SERVICE_F_REGISTERED);
+}
+
+static inline int
+service_lcore_valid(uint32_t lcore)
+{
+	return lcore < RTE_MAX_LCORE && lcore_states[lcore].is_service_core;
+}
+
+int32_t
+rte_service_register(const struct rte_service_spec *spec,
+		uint32_t *service_id)
+{
+	struct rte_service_spec_impl *s;
+	unsigned lcore_id;
+	uint32_t id;
+
+	if (spec == NULL || spec->callback == NULL || service_id == NULL ||
+			spec->name[0] == '\0' ||
+			memchr(spec->name, '\0', RTE_SERVICE_NAME_MAX) == NULL)
+		return -EINVAL;
+	if (rte_service_get_by_name(spec->name, &id) == 0)
+		return -EINVAL;
+
+	for (id = 0; id < RTE_SERVICE_NUM_MAX; id++) {
+		if (!service_valid(id))
+			break;
+	}
+	if (id == RTE_SERVICE_NUM_MAX)
+		return -ENOSPC;
+
+	s = &rte_services[id];
+	memset(s, 0, sizeof(*s));
+	s->spec = *spec;
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++)
+		memset(&lcore_states[lcore_id].stats[id], 0,
+			sizeof(lcore_states[lcore_id].stats[id]));
+	rte_smp_wmb();
+	s->flags = SERVICE_F_REGISTERED;
+	rte_service_count++;
+
+	*service_id = id;
+	return 0;
+}
+
+int32_t
+rte_service_unregister(uint32_t id)
+{
+	unsigned lcore_id;
+
+	if (!service_valid(id))
+		return -EINVAL;
+	if (rte_services[id].runstate == RUNSTATE_RUNNING)
+		return -EBUSY;
+
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++)
+		lcore_states[lcore_id].service_mask &= ~(UINT64_C(1) << id);
+
+	rte_services[id].flags = 0;
+	rte_service_count--;
+	return 0;
+}
+
+uint32_t
+rte_service_get_count(void)
+{
+	return rte_service_count;
+}
+
+int32_t
+rte_service_get_by_name(const char *name, uint32_t *service_id)
+{
+	uint32_t id;
+
+	if (name == NULL || service_id == NULL)
+		return -EINVAL;
+
+	for (id = 0; id < RTE_SERVICE_NUM_MAX; id++) {
+		if (service_valid(id) && strncmp(name,
+				rte_services[id].spec.name,
+				RTE_SERVICE_NAME_MAX) == 0) {
+			*service_id = id;
+			return 0;
+		}
+	}
+	return -ENODEV;
+}
+
+const char *
+rte_service_get_name(uint32_t id)
+{
+	if (!service_valid(id))
+		return NULL;
+	return rte_services[id].spec.name;
+}
+
+int32_t
+rte_service_probe_capability(uint32_t id, uint32_t capability)
+{
+	if (!service_valid(id))
+		return 0;
+	return (rte_services[id].spec.capabilities & capability) ==
+		capability;
+}
+
+int32_t
+rte_service_map_lcore_set(uint32_t id, uint32_t lcore, uint32_t enable)
+{
+	struct core_state *cs;
+	uint64_t bit = UINT64_C(1) << id;
+
+	if (!service_valid(id) || !service_lcore_valid(lcore))
+		return -EINVAL;
+
+	cs = &lcore_states[lcore];
+	if (enable && !(cs->service_mask & bit)) {
+		rte_atomic32_inc(&rte_services[id].num_mapped_cores);
+		cs->service_mask |= bit;
+	} else if (!enable && (cs->service_mask & bit)) {
+		cs->service_mask &= ~bit;
+		rte_atomic32_dec(&rte_services[id].num_mapped_cores);
+	}
+	return 0;
+}
+
+int32_t
+rte_service_map_lcore_get(uint32_t id, uint32_t lcore)
+{
+	if (!service_valid(id) || !service_lcore_valid(lcore))
+		return -EINVAL;
+	return !!(lcore_states[lcore].service_mask & (UINT64_C(1) << id));
+}
+
+int32_t
+rte_service_runstate_set(uint32_t id, uint32_t runstate)
+{
+	if (!service_valid(id))
+		return -EINVAL;
+	rte_services[id].runstate = runstate ? RUNSTATE_RUNNING :
+		RUNSTATE_STOPPED;
+	rte_smp_wmb();
+	return 0;
+}
+
+int32_t
+rte_service_runstate_get(uint32_t id)
+{
+	if (!service_valid(id))
+		return -EINVAL;
+	return rte_services[id].runstate == RUNSTATE_RUNNING;
+}
+
+/* call the service, counting the call in the stats of the core */
+static inline void
+service_call(struct rte_service_spec_impl *s, struct service_core_stats *st)
+{
+	uint64_t start;
+
+	if (s->flags & SERVICE_F_STATS_ENABLED) {
+		start = rte_rdtsc();
+		s->spec.callback(s->spec.callback_userdata);
+		st->cycles += rte_rdtsc() - start;
+	} else
+		s->spec.callback(s->spec.callback_userdata);
+	st->calls++;
+}
+
+static inline int32_t
+service_run(uint32_t id, struct core_state *cs)
+{
+	struct rte_service_spec_impl *s = &rte_services[id];
+
+	if (s->runstate != RUNSTATE_RUNNING)
+		return -ENOEXEC;
+
+	if (s->spec.capabilities & RTE_SERVICE_CAP_MT_SAFE) {
+		service_call(s, &cs->stats[id]);
+		return 0;
+	}
+
+	/* the other cores skip the service while one is running it */
+	if (!rte_atomic32_test_and_set(&s->execute_lock))
+		return -EBUSY;
+	service_call(s, &cs->stats[id]);
+	rte_atomic32_clear(&s->execute_lock);
+	return 0;
+}
+
+int32_t
+rte_service_run_iter_on_app_lcore(uint32_t id)
+{
+	unsigned lcore_id = rte_lcore_id();
+
+	if (!service_valid(id))
+		return -EINVAL;
+	/* the non-EAL threads share the counters of the master lcore */
+	if (lcore_id >= RTE_MAX_LCORE)
+		lcore_id = rte_get_master_lcore();
+	return service_run(id, &lcore_states[lcore_id]);
+}
+
+/* the loop of a service core, until it is stopped */
+static int32_t
+service_runner_func(void *arg)
+{
+	struct core_state *cs = &lcore_states[rte_lcore_id()];
+	uint64_t service_mask;
+	uint32_t id;
+
+	RTE_SET_USED(arg);
+
+	while (cs->runstate == RUNSTATE_RUNNING) {
+		service_mask = cs->service_mask;
+		while (service_mask != 0) {
+			id = __builtin_ctzll(service_mask);
+			service_mask &= service_mask - 1;
+			service_run(id, cs);
+		}
+		cs->loops++;
+	}
+	return 0;
+}
+
+int32_t
+rte_service_set_stats_enable(uint32_t id, int32_t enable)
+{
+	if (!service_valid(id))
+		return -EINVAL;
+	if (enable)
+		rte_services[id].flags |= SERVICE_F_STATS_ENABLED;
+	else
+		rte_services[id].flags &= ~SERVICE_F_STATS_ENABLED;
+	return 0;
+}
+
+int32_t
+rte_service_stats_get(uint32_t id, struct rte_service_stats *stats)
+{
+	unsigned lcore_id;
+
+	if (!service_valid(id) || stats == NULL)
+		return -EINVAL;
+
+	memset(stats, 0, sizeof(*stats));
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		stats->calls += lcore_states[lcore_id].stats[id].calls;
+		stats->cycles += lcore_states[lcore_id].stats[id].cycles;
+	}
+	return 0;
+}
+
+int32_t
+rte_service_stats_reset(uint32_t id)
+{
+	unsigned lcore_id;
+
+	if (!service_valid(id))
+		return -EINVAL;
+
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++)
+		memset(&lcore_states[lcore_id].stats[id], 0,
+			sizeof(lcore_states[lcore_id].stats[id]));
+	return 0;
+}
+
+static void
+service_dump_one(FILE *f, uint32_t id)
+{
+	struct rte_service_stats stats;
+
+	if (rte_service_stats_get(id, &stats) < 0)
+		return;
+	fprintf(f, "  %s: %s, %d cores, calls %"PRIu64", cycles %"PRIu64
+		", avg %"PRIu64"\n",
+		rte_services[id].spec.name,
+		rte_services[id].runstate == RUNSTATE_RUNNING ?
+		"running" : "stopped",
+		rte_atomic32_read(&rte_services[id].num_mapped_cores),
+		stats.calls, stats.cycles,
+		stats.calls ? stats.cycles / stats.calls : 0);
+}
+
+int32_t
+rte_service_dump(FILE *f, uint32_t id)
+{
+	unsigned lcore_id;
+
+	if (id != UINT32_MAX) {
+		if (!service_valid(id))
+			return -EINVAL;
+		service_dump_one(f, id);
+		return 0;
+	}
+
+	fprintf(f, "Services:\n");
+	for (id = 0; id < RTE_SERVICE_NUM_MAX; id++) {
+		if (service_valid(id))
+			service_dump_one(f, id);
+	}
+
+	fprintf(f, "Service cores:\n");
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		if (!lcore_states[lcore_id].is_service_core)
+			continue;
+		fprintf(f, "  %u: %s, services 0x%"PRIx64", loops %"PRIu64"\n",
+			lcore_id,
+			lcore_states[lcore_id].runstate == RUNSTATE_RUNNING ?
+			"running" : "stopped",
+			lcore_states[lcore_id].service_mask,
+			lcore_states[lcore_id].loops);
+	}
+	return 0;
+}
+
+int32_t
+rte_service_start_with_defaults(void)
+{
+	uint32_t lcores[RTE_MAX_LCORE];
+	uint32_t socket_lcores[RTE_MAX_LCORE];
+	uint32_t id, i, n, count;
+	uint32_t next = 0;
+	int socket_id;
+
+	count = rte_service_lcore_list(lcores, RTE_DIM(lcores));
+	if (count == 0)
+		return -ENOTSUP;
+
+	for (id = 0; id < RTE_SERVICE_NUM_MAX; id++) {
+		if (!service_valid(id))
+			continue;
+
+		n = 0;
+		socket_id = rte_services[id].spec.socket_id;
+		for (i = 0; socket_id != SOCKET_ID_ANY && i < count; i++) {
+			if ((int)rte_lcore_to_socket_id(lcores[i]) ==
+					socket_id)
+				socket_lcores[n++] = lcores[i];
+		}
+
+		if (n != 0)
+			rte_service_map_lcore_set(id,
+				socket_lcores[next % n], 1);
+		else
+			rte_service_map_lcore_set(id, lcores[next % count], 1);
+		next++;
+		rte_service_runstate_set(id, 1);
+	}
+
+	for (i = 0; i < count; i++) {
+		if (lcore_states[lcores[i]].runstate != RUNSTATE_RUNNING)
+			rte_service_lcore_start(lcores[i]);
+	}
+	return 0;
+}
+
+int32_t
+rte_service_lcore_add(uint32_t lcore)
+{
+	struct rte_config *cfg = rte_eal_get_configuration();
+
+	if (lcore >= RTE_MAX_LCORE || lcore == cfg->master_lcore)
+		return -EINVAL;
+	if (lcore_states[lcore].is_service_core)
+		return -EALREADY;
+	if (cfg->lcore_role[lcore] != ROLE_RTE)
+		return -EINVAL;
+	if (rte_eal_get_lcore_state(lcore) != WAIT)
+		return -EBUSY;
+
+	cfg->lcore_role[lcore] = ROLE_SERVICE;
+	cfg->lcore_count--;
+
+	lcore_states[lcore].service_mask = 0;
+	lcore_states[lcore].runstate = RUNSTATE_STOPPED;
+	lcore_states[lcore].is_service_core = 1;
+	return 0;
+}
+
+int32_t
+rte_service_lcore_del(uint32_t lcore)
+{
+	struct rte_config *cfg = rte_eal_get_configuration();
+	struct core_state *cs;
+	uint32_t id;
+
+	if (!service_lcore_valid(lcore))
+		return -EINVAL;
+	cs = &lcore_states[lcore];
+	if (cs->runstate == RUNSTATE_RUNNING)
+		return -EBUSY;
+
+	for (id = 0; id < RTE_SERVICE_NUM_MAX; id++) {
+		if (cs->service_mask & (UINT64_C(1) << id))
+			rte_service_map_lcore_set(id, lcore, 0);
+	}
+	cs->is_service_core = 0;
+
+	cfg->lcore_role[lcore] = ROLE_RTE;
+	cfg->lcore_count++;
+	return 0;
+}
+
+int32_t
+rte_service_lcore_start(uint32_t lcore)
+{
+	struct core_state *cs;
+	int ret;
+
+	if (!service_lcore_valid(lcore))
+		return -EINVAL;
+	cs = &lcore_states[lcore];
+	if (cs->runstate == RUNSTATE_RUNNING)
+		return -EALREADY;
+
+	cs->runstate = RUNSTATE_RUNNING;
+	rte_smp_wmb();
+	ret = rte_eal_remote_launch(service_runner_func, NULL, lcore);
+	if (ret < 0)
+		cs->runstate = RUNSTATE_STOPPED;
+	return ret;
+}
+
+int32_t
+rte_service_lcore_stop(uint32_t lcore)
+{
+	struct core_state *cs;
+
+	if (!service_lcore_valid(lcore))
+		return -EINVAL;
+	cs = &lcore_states[lcore];
+	if (cs->runstate == RUNSTATE_STOPPED)
+		return -EALREADY;
+
+	cs->runstate = RUNSTATE_STOPPED;
+	rte_smp_wmb();
+	rte_eal_wait_lcore(lcore);
+	return 0;
+}
+
+int32_t
+rte_service_lcore_reset_all(void)
+{
+	unsigned lcore_id;
+
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		if (!lcore_states[lcore_id].is_service_core)
+			continue;
+		if (lcore_states[lcore_id].runstate == RUNSTATE_RUNNING)
+			rte_service_lcore_stop(lcore_id);
+		rte_service_lcore_del(lcore_id);
+	}
+	return 0;
+}
+
+int32_t
+rte_service_lcore_count(void)
+{
+	unsigned lcore_id;
+	int32_t count = 0;
+
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++)
+		count += lcore_states[lcore_id].is_service_core;
+	return count;
+}
+
+int32_t
+rte_service_lcore_list(uint32_t array[], uint32_t n)
+{
+	unsigned lcore_id;
+	uint32_t count = 0;
+
+	if (array == NULL)
+		return -EINVAL;
+
+	if ((uint32_t)rte_service_lcore_count() > n)
+		return -ENOMEM;
+
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		if (lcore_states[lcore_id].is_service_core)
+			array[count++] = lcore_id;
+	}
+	return count;
+}
+
+/* turn the lcores of the service coremask into service cores */
+int
+eal_service_init(void)
+{
+	unsigned lcore_id;
+	int ret;
+
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		if (!internal_config.service_cores[lcore_id])
+			continue;
+		ret = rte_service_lcore_add(lcore_id);
+		if (ret < 0) {
+			RTE_LOG(ERR, EAL, "%s(): cannot use lcore %u as "
+				"service core: %s\n", __func__, lcore_id,
+				strerror(-ret));
+			return -1;
+		}
+	}
+	return 0;
+}
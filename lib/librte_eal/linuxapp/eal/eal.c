@@ -35,6 +35,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <string.h>
 #include <stdarg.h>
 #include <unistd.h>
@@ -350,6 +351,8 @@ eal_usage(const char *prgname)
 	       "  --"OPT_SOCKET_MEM"        Memory to allocate on sockets (comma separated values)\n"
 	       "  --"OPT_HUGE_DIR"          Directory where hugetlbfs is mounted\n"
 	       "  --"OPT_FILE_PREFIX"       Prefix for hugepage filenames\n"
+	       "  --"OPT_DYNAMIC_MEM"       Map hugepages on demand, starting with -m/--socket-mem\n"
+	       "  --"OPT_IOVA_MODE"         Addresses used by the devices for DMA (pa|va)\n"
 	       "  --"OPT_BASE_VIRTADDR"     Base virtual address\n"
 	       "  --"OPT_CREATE_UIO_DEV"    Create /dev/uioX (usually done by hotplug)\n"
 	       "  --"OPT_VFIO_INTR"         Interrupt mode for VFIO (legacy|msi|msix)\n"
@@ -476,6 +479,18 @@ eal_parse_vfio_intr(const char *mode)
 	return -1;
 }
 
+static int
+eal_parse_iova_mode(const char *mode)
+{
+	if (!strcmp(mode, "pa"))
+		internal_config.iova_mode = RTE_IOVA_PA;
+	else if (!strcmp(mode, "va"))
+		internal_config.iova_mode = RTE_IOVA_VA;
+	else
+		return -1;
+	return 0;
+}
+
 /* Parse the arguments for --log-level only */
 static void
 eal_log_level_parse(int argc, char **argv)
@@ -587,6 +602,20 @@ eal_parse_args(int argc, char **argv)
 			}
 			break;
 
+		case OPT_DYNAMIC_MEM_NUM:
+			internal_config.dynamic_mem = 1;
+			break;
+
+		case OPT_IOVA_MODE_NUM:
+			if (eal_parse_iova_mode(optarg) < 0) {
+				RTE_LOG(ERR, EAL, "invalid parameter for --"
+						OPT_IOVA_MODE "\n");
+				eal_usage(prgname);
+				ret = -1;
+				goto out;
+			}
+			break;
+
 		case OPT_BASE_VIRTADDR_NUM:
 			if (eal_parse_base_virtaddr(optarg) < 0) {
 				RTE_LOG(ERR, EAL, "invalid parameter for --"
@@ -651,6 +680,32 @@ eal_parse_args(int argc, char **argv)
 		goto out;
 	}
 
+	/* --dynamic-mem grows memory with new hugetlbfs files, which the
+	 * secondary processes open by name */
+	if (internal_config.dynamic_mem &&
+			(internal_config.no_hugetlbfs ||
+			internal_config.hugepage_unlink ||
+			internal_config.xen_dom0_support)) {
+		RTE_LOG(ERR, EAL, "Option --"OPT_DYNAMIC_MEM" cannot be specified "
+			"together with --"OPT_NO_HUGE", --"OPT_HUGE_UNLINK" or "
+			"--"OPT_XEN_DOM0"\n");
+		eal_usage(prgname);
+		ret = -1;
+		goto out;
+	}
+
+	/* in Xen Dom0, the devices are given machine addresses translated
+	 * from the physical ones with rte_xen_mem_phy2mch(), virtual
+	 * addresses cannot be used as IOVA */
+	if (internal_config.iova_mode == RTE_IOVA_VA &&
+			internal_config.xen_dom0_support) {
+		RTE_LOG(ERR, EAL, "Option --"OPT_IOVA_MODE" va cannot be "
+			"specified together with --"OPT_XEN_DOM0"\n");
+		eal_usage(prgname);
+		ret = -1;
+		goto out;
+	}
+
 	if (optind >= 0)
 		argv[optind-1] = prgname;
 	ret = optind-1;
@@ -712,6 +767,105 @@ rte_eal_iopl_init(void)
 	return 0;
 }
 
+/*
+ * Select the addresses the devices use for DMA, once the PCI bus is
+ * scanned. Virtual addresses save looking for the physical address of each
+ * hugepage and sorting them, but they need every device to be behind an
+ * IOMMU, i.e. bound to VFIO without the no-IOMMU mode.
+ */
+static void
+eal_iova_mode_select(void)
+{
+	struct rte_mem_config *mcfg = rte_config.mem_config;
+	struct rte_pci_device *dev;
+	enum rte_iova_mode mode = RTE_IOVA_VA;
+
+	if (rte_config.process_type != RTE_PROC_PRIMARY)
+		return;
+
+	if (internal_config.iova_mode != RTE_IOVA_DC) {
+		mcfg->iova_mode = internal_config.iova_mode;
+		goto out;
+	}
+
+#ifdef RTE_ARCH_PPC_64
+	/* the hugepages are mapped in reverse physical order */
+	mode = RTE_IOVA_PA;
+#endif
+	if (internal_config.xen_dom0_support)
+		mode = RTE_IOVA_PA;
+
+	/* KNI gives the physical address of the mbufs to the kernel */
+	if (rte_eal_check_module("rte_kni") == 1)
+		mode = RTE_IOVA_PA;
+
+	TAILQ_FOREACH(dev, &pci_device_list, next) {
+		if (mode == RTE_IOVA_PA)
+			break;
+		switch (dev->kdrv) {
+		case RTE_KDRV_IGB_UIO:
+		case RTE_KDRV_UIO_GENERIC:
+			mode = RTE_IOVA_PA;
+			break;
+		case RTE_KDRV_VFIO:
+#ifdef VFIO_PRESENT
+			if (vfio_noiommu_is_enabled())
+				mode = RTE_IOVA_PA;
+#endif
+			break;
+		default:
+			break;
+		}
+	}
+	mcfg->iova_mode = mode;
+
+out:
+	RTE_LOG(DEBUG, EAL, "Selected IOVA mode %s\n",
+		mcfg->iova_mode == RTE_IOVA_VA ? "VA" : "PA");
+}
+
+/* duration of the initialization phases, logged once rte_eal_init is done */
+static struct {
+	const char *name;
+	uint64_t us;
+} eal_init_phases[16];
+static unsigned eal_init_nb_phases;
+static uint64_t eal_init_phase_start;
+
+static void
+eal_init_phase(const char *name)
+{
+	uint64_t now = eal_get_time_us();
+
+	if (name != NULL && eal_init_nb_phases < RTE_DIM(eal_init_phases)) {
+		eal_init_phases[eal_init_nb_phases].name = name;
+		eal_init_phases[eal_init_nb_phases].us =
+			now - eal_init_phase_start;
+		eal_init_nb_phases++;
+	}
+	eal_init_phase_start = now;
+}
+
+static void
+eal_init_phases_dump(uint64_t start)
+{
+	char buf[256];
+	unsigned i;
+	int len = 0;
+
+	buf[0] = '\0';
+	for (i = 0; i < eal_init_nb_phases && len < (int)sizeof(buf); i++)
+		len += snprintf(buf + len, sizeof(buf) - len, "%s%s %"PRIu64
+			" ms", i == 0 ? "" : ", ", eal_init_phases[i].name,
+			eal_init_phases[i].us / 1000);
+	if (len >= (int)sizeof(buf))
+		len = sizeof(buf) - 1;
+	buf[len] = '\0';
+
+	RTE_LOG(INFO, EAL, "Init done in %"PRIu64" ms (%s)\n",
+		(eal_get_time_us() - start) / 1000, buf);
+}
+
 #ifdef VFIO_PRESENT
 static int rte_eal_vfio_setup(void)
 {
@@ -749,6 +903,7 @@ rte_eal_init(int argc, char **argv)
 	const char *logid;
 	char cpuset[RTE_CPU_AFFINITY_STR_LEN];
 	char thread_name[RTE_MAX_THREAD_NAME_LEN];
+	uint64_t start;
 
 	/* checks if the machine is adequate */
 	rte_cpu_check_supported();
@@ -756,6 +911,9 @@ rte_eal_init(int argc, char **argv)
 	if (!rte_atomic32_test_and_set(&run_once))
 		return -1;
 
+	start = eal_get_time_us();
+	eal_init_phase(NULL);
+
 	logid = strrchr(argv[0], '/');
 	logid = strdup(logid ? logid + 1: argv[0]);
 
@@ -778,6 +936,7 @@ rte_eal_init(int argc, char **argv)
 			internal_config.xen_dom0_support == 0 &&
 			eal_hugepage_info_init() < 0)
 		rte_panic("Cannot get hugepage information\n");
+	eal_init_phase("hugepage info");
 
 	if (internal_config.memory == 0 && internal_config.force_sockets == 0) {
 		if (internal_config.no_hugetlbfs)
@@ -802,16 +961,22 @@ rte_eal_init(int argc, char **argv)
 	if (rte_eal_log_init(logid, internal_config.syslog_facility) < 0)
 		rte_panic("Cannot init logs\n");
 
+	eal_init_phase(NULL);
 	if (rte_eal_pci_init() < 0)
 		rte_panic("Cannot init PCI\n");
+	eal_init_phase("pci scan");
 
 #ifdef VFIO_PRESENT
 	if (rte_eal_vfio_setup() < 0)
 		rte_panic("Cannot init VFIO\n");
+	eal_init_phase("vfio");
 #endif
 
+	eal_iova_mode_select();
+
 	if (rte_eal_memory_init() < 0)
 		rte_panic("Cannot init memory\n");
+	eal_init_phase("memory");
 
 	/* the directories are locked during eal_hugepage_info_init */
 	eal_hugedirs_unlock();
@@ -819,14 +984,19 @@ rte_eal_init(int argc, char **argv)
 	if (rte_eal_memzone_init() < 0)
 		rte_panic("Cannot init memzone\n");
 
+	if (internal_config.dynamic_mem && eal_memory_sync_init() < 0)
+		rte_panic("Cannot init dynamic memory\n");
+
 	if (rte_eal_tailqs_init() < 0)
 		rte_panic("Cannot init tail queues for objects\n");
+	eal_init_phase("memzones");
 
 	if (rte_eal_alarm_init() < 0)
 		rte_panic("Cannot init interrupt-handling thread\n");
 
 	if (rte_eal_timer_init() < 0)
 		rte_panic("Cannot init HPET or TSC timers\n");
+	eal_init_phase("timer");
 
 	eal_check_mem_on_local_socket();
 
@@ -844,6 +1014,12 @@ rte_eal_init(int argc, char **argv)
 	if (rte_eal_intr_init() < 0)
 		rte_panic("Cannot init interrupt-handling thread\n");
 
+	if (eal_log_async_init() < 0)
+		rte_panic("Cannot init asynchronous logging\n");
+
+	if (eal_trace_init() < 0)
+		rte_panic("Cannot init trace buffers\n");
+
 	RTE_LCORE_FOREACH_SLAVE(i) {
 
 		/*
@@ -880,15 +1056,22 @@ rte_eal_init(int argc, char **argv)
 	rte_eal_mp_remote_launch(sync_func, NULL, SKIP_MASTER);
 	rte_eal_mp_wait_lcore();
 
+	if (eal_service_init() < 0)
+		rte_panic("Cannot init service cores\n");
+	eal_init_phase("threads");
+
 	/* Probe & Initialize PCI devices */
 	if (rte_eal_pci_probe())
 		rte_panic("Cannot probe PCI\n");
 
 	if (rte_eal_dev_init() < 0)
 		rte_panic("Cannot init pmd devices\n");
+	eal_init_phase("probe");
 
 	rte_eal_mcfg_complete();
 
+	eal_init_phases_dump(start);
+
 	return fctret;
 }
 
@@ -910,6 +1093,12 @@ int rte_eal_has_hugepages(void)
 	return ! internal_config.no_hugetlbfs;
 }
 
+enum rte_iova_mode
+rte_eal_iova_mode(void)
+{
+	return rte_config.mem_config->iova_mode;
+}
+
 int
 rte_eal_check_module(const char *module_name)
 {
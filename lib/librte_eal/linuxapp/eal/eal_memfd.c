@@ -0,0 +1,435 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Memory of the EAL without hugetlbfs (--no-huge): a memfd, shared with the
+ * secondary processes by passing its file descriptor over a UNIX socket,
+ * mapped in a single virtual area with one memseg per socket. The memory of
+ * each socket is bound to its NUMA node, and transparent huge pages are
+ * requested for the whole area.
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+
+/* sys/un.h with __USE_MISC uses strlen, which is unsafe */
+#ifdef __USE_MISC
+#define REMOVED_USE_MISC
+#undef __USE_MISC
+#endif
+#include <sys/un.h>
+/* make sure we redefine __USE_MISC only if it was previously undefined */
+#ifdef REMOVED_USE_MISC
+#define __USE_MISC
+#undef REMOVED_USE_MISC
+#endif
+
+#include <rte_log.h>
+#include <rte_memory.h>
+#include <rte_eal.h>
+#include <rte_eal_memconfig.h>
+#include <rte_lcore.h>
+#include <rte_common.h>
+
+#include "eal_private.h"
+#include "eal_internal_cfg.h"
+#include "eal_filesystem.h"
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+#ifndef MPOL_BIND
+#define MPOL_BIND 2
+#endif
+#ifndef MADV_HUGEPAGE
+#define MADV_HUGEPAGE 14
+#endif
+
+/* alignment of the area, so that it can be backed by huge pages */
+#define MEMFD_ALIGN RTE_PGSIZE_2M
+
+#define MEMFD_CMSGLEN (CMSG_LEN(sizeof(int)))
+
+static int memfd = -1;
+static int memfd_socket_fd = -1;
+static pthread_t memfd_thread;
+
+static int
+memfd_create_fd(const char *name)
+{
+#ifdef SYS_memfd_create
+	return syscall(SYS_memfd_create, name, MFD_CLOEXEC);
+#else
+	RTE_SET_USED(name);
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+/* send the memfd in a control message */
+static int
+memfd_send_fd(int socket, int fd)
+{
+	struct msghdr hdr;
+	struct cmsghdr *chdr;
+	char chdr_buf[MEMFD_CMSGLEN];
+	struct iovec iov;
+	int buf = 0;
+
+	chdr = (struct cmsghdr *)chdr_buf;
+	memset(chdr, 0, sizeof(chdr_buf));
+	memset(&hdr, 0, sizeof(hdr));
+
+	hdr.msg_iov = &iov;
+	hdr.msg_iovlen = 1;
+	iov.iov_base = (char *)&buf;
+	iov.iov_len = sizeof(buf);
+	hdr.msg_control = chdr;
+	hdr.msg_controllen = MEMFD_CMSGLEN;
+
+	chdr->cmsg_len = MEMFD_CMSGLEN;
+	chdr->cmsg_level = SOL_SOCKET;
+	chdr->cmsg_type = SCM_RIGHTS;
+	memcpy(CMSG_DATA(chdr), &fd, sizeof(fd));
+
+	if (sendmsg(socket, &hdr, 0) < 0)
+		return -1;
+	return 0;
+}
+
+/* receive the memfd from the primary process, returns -1 on error */
+static int
+memfd_receive_fd(int socket)
+{
+	struct msghdr hdr;
+	struct cmsghdr *chdr;
+	char chdr_buf[MEMFD_CMSGLEN];
+	struct iovec iov;
+	int buf, fd;
+
+	chdr = (struct cmsghdr *)chdr_buf;
+	memset(chdr, 0, sizeof(chdr_buf));
+	memset(&hdr, 0, sizeof(hdr));
+
+	hdr.msg_iov = &iov;
+	hdr.msg_iovlen = 1;
+	iov.iov_base = (char *)&buf;
+	iov.iov_len = sizeof(buf);
+	hdr.msg_control = chdr;
+	hdr.msg_controllen = MEMFD_CMSGLEN;
+
+	if (recvmsg(socket, &hdr, 0) <= 0)
+		return -1;
+	if (hdr.msg_controllen < MEMFD_CMSGLEN ||
+			chdr->cmsg_level != SOL_SOCKET ||
+			chdr->cmsg_type != SCM_RIGHTS)
+		return -1;
+
+	memcpy(&fd, CMSG_DATA(chdr), sizeof(fd));
+	return fd;
+}
+
+/* socket thread of the primary process, giving the memfd to any client */
+static __attribute__((noreturn)) void *
+memfd_sync_thread(void __rte_unused *arg)
+{
+	int conn_sock;
+
+	for (;;) {
+		conn_sock = accept(memfd_socket_fd, NULL, NULL);
+
+		/* just restart on error */
+		if (conn_sock == -1)
+			continue;
+
+		if (memfd_send_fd(conn_sock, memfd) < 0)
+			RTE_LOG(ERR, EAL, "Cannot send memory fd to "
+				"secondary process\n");
+		close(conn_sock);
+	}
+}
+
+static int
+memfd_sync_setup(void)
+{
+	struct sockaddr_un addr;
+	char thread_name[RTE_MAX_THREAD_NAME_LEN];
+
+	memfd_socket_fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+	if (memfd_socket_fd < 0) {
+		RTE_LOG(ERR, EAL, "Failed to create socket!\n");
+		return -1;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	snprintf(addr.sun_path, sizeof(addr.sun_path), "%s",
+		eal_memfd_socket_path());
+	unlink(addr.sun_path);
+
+	if (bind(memfd_socket_fd, (struct sockaddr *)&addr,
+			sizeof(addr)) < 0 ||
+			listen(memfd_socket_fd, 50) < 0) {
+		RTE_LOG(ERR, EAL, "Failed to listen on %s: %s\n",
+			addr.sun_path, strerror(errno));
+		goto error;
+	}
+
+	if (pthread_create(&memfd_thread, NULL, memfd_sync_thread, NULL)) {
+		RTE_LOG(ERR, EAL, "Failed to create thread for "
+			"communication with secondary processes!\n");
+		goto error;
+	}
+
+	snprintf(thread_name, RTE_MAX_THREAD_NAME_LEN, "mem-sync");
+	if (rte_thread_setname(memfd_thread, thread_name))
+		RTE_LOG(DEBUG, EAL, "Failed to set thread name for "
+			"secondary processes!\n");
+
+	return 0;
+
+error:
+	close(memfd_socket_fd);
+	memfd_socket_fd = -1;
+	return -1;
+}
+
+/* reserve a virtual area of len bytes aligned on MEMFD_ALIGN */
+static void *
+memfd_reserve_area(size_t len)
+{
+	void *hint = NULL, *addr, *aligned;
+	size_t map_len = len + MEMFD_ALIGN;
+
+	if (internal_config.base_virtaddr != 0)
+		hint = (void *)(uintptr_t)internal_config.base_virtaddr;
+
+	addr = mmap(hint, map_len, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS,
+		-1, 0);
+	if (addr == MAP_FAILED)
+		return NULL;
+
+	aligned = RTE_PTR_ALIGN_CEIL(addr, MEMFD_ALIGN);
+	if (aligned != addr)
+		munmap(addr, RTE_PTR_DIFF(aligned, addr));
+	munmap(RTE_PTR_ADD(aligned, len),
+		map_len - len - RTE_PTR_DIFF(aligned, addr));
+
+	return aligned;
+}
+
+/* bind the memory of a memseg to its NUMA node, and fault it in */
+static int
+memfd_populate(void *addr, size_t len, int socket_id)
+{
+	char path[PATH_MAX];
+	unsigned long nodemask;
+	size_t off;
+
+	if (socket_id >= (int)(sizeof(nodemask) * CHAR_BIT)) {
+		RTE_LOG(ERR, EAL, "%s(): invalid socket %d\n", __func__,
+			socket_id);
+		return -1;
+	}
+	snprintf(path, sizeof(path), "/sys/devices/system/node/node%d",
+		socket_id);
+	if (socket_id != 0 && access(path, F_OK) != 0) {
+		RTE_LOG(ERR, EAL, "%s(): no NUMA node for socket %d\n",
+			__func__, socket_id);
+		return -1;
+	}
+
+	nodemask = 1UL << socket_id;
+	if (syscall(SYS_mbind, addr, len, MPOL_BIND, &nodemask,
+			sizeof(nodemask) * CHAR_BIT, 0) < 0)
+		RTE_LOG(DEBUG, EAL, "%s(): cannot bind memory to socket %d: "
+			"%s\n", __func__, socket_id, strerror(errno));
+
+	for (off = 0; off < len; off += RTE_PGSIZE_4K)
+		*(volatile char *)RTE_PTR_ADD(addr, off) = 0;
+
+	return 0;
+}
+
+int
+eal_memfd_init(void)
+{
+	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
+	uint64_t socket_mem[RTE_MAX_NUMA_NODES];
+	size_t len = 0, off = 0;
+	int flags = MAP_SHARED | MAP_FIXED;
+	void *addr = NULL;
+	unsigned i, j;
+
+	/* without --socket-mem, all the memory is on the first socket */
+	for (i = 0; i < RTE_MAX_NUMA_NODES; i++) {
+		if (internal_config.force_sockets)
+			socket_mem[i] = internal_config.socket_mem[i];
+		else
+			socket_mem[i] = i == 0 ? internal_config.memory : 0;
+		socket_mem[i] = RTE_ALIGN_CEIL(socket_mem[i], MEMFD_ALIGN);
+		len += socket_mem[i];
+	}
+
+	memfd = memfd_create_fd("rte_mem");
+	if (memfd >= 0 && ftruncate(memfd, len) < 0) {
+		RTE_LOG(ERR, EAL, "%s(): cannot resize memfd: %s\n",
+			__func__, strerror(errno));
+		goto error;
+	}
+	if (memfd < 0) {
+		RTE_LOG(NOTICE, EAL, "memfd not supported, secondary "
+			"processes cannot attach to the memory\n");
+		flags |= MAP_ANONYMOUS;
+	}
+
+	addr = memfd_reserve_area(len);
+	if (addr == NULL) {
+		RTE_LOG(ERR, EAL, "%s(): cannot reserve %zu bytes: %s\n",
+			__func__, len, strerror(errno));
+		goto error;
+	}
+	if (mmap(addr, len, PROT_READ | PROT_WRITE, flags, memfd, 0) != addr) {
+		RTE_LOG(ERR, EAL, "%s(): cannot map %zu bytes: %s\n",
+			__func__, len, strerror(errno));
+		goto error;
+	}
+
+	if (madvise(addr, len, MADV_HUGEPAGE) < 0)
+		RTE_LOG(DEBUG, EAL, "%s(): no transparent huge pages: %s\n",
+			__func__, strerror(errno));
+
+	for (i = 0, j = 0; i < RTE_MAX_NUMA_NODES; i++) {
+		struct rte_memseg *ms = &mcfg->memseg[j];
+		void *ms_addr = RTE_PTR_ADD(addr, off);
+
+		if (socket_mem[i] == 0)
+			continue;
+		if (memfd_populate(ms_addr, socket_mem[i], i) < 0)
+			goto error;
+
+		/* the memory is not physically contiguous */
+		ms->addr = ms_addr;
+		ms->phys_addr = (phys_addr_t)(uintptr_t)ms_addr;
+		ms->len = socket_mem[i];
+		ms->hugepage_sz = RTE_PGSIZE_4K;
+		ms->socket_id = i;
+		off += socket_mem[i];
+		j++;
+	}
+
+	if (memfd >= 0 && memfd_sync_setup() < 0)
+		goto error;
+
+	mcfg->no_hugetlbfs = 1;
+
+	return 0;
+
+error:
+	/* the reserved area is unmapped even when the mmap() failed */
+	if (addr != NULL) {
+		munmap(addr, len);
+		memset(mcfg->memseg, 0, sizeof(mcfg->memseg));
+	}
+	if (memfd >= 0)
+		close(memfd);
+	memfd = -1;
+	return -1;
+}
+
+int
+eal_memfd_attach(void)
+{
+	const struct rte_mem_config *mcfg =
+		rte_eal_get_configuration()->mem_config;
+	struct sockaddr_un addr;
+	size_t len = 0;
+	void *va;
+	int sock, fd, i;
+
+	for (i = 0; i < RTE_MAX_MEMSEG && mcfg->memseg[i].len > 0; i++)
+		len += mcfg->memseg[i].len;
+
+	sock = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+	if (sock < 0) {
+		RTE_LOG(ERR, EAL, "Failed to create socket!\n");
+		return -1;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	snprintf(addr.sun_path, sizeof(addr.sun_path), "%s",
+		eal_memfd_socket_path());
+	if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		RTE_LOG(ERR, EAL, "Cannot connect to primary process on %s: "
+			"%s\n", addr.sun_path, strerror(errno));
+		close(sock);
+		return -1;
+	}
+	fd = memfd_receive_fd(sock);
+	close(sock);
+	if (fd < 0) {
+		RTE_LOG(ERR, EAL, "Cannot get memory fd from primary process\n");
+		return -1;
+	}
+
+	/* all the memsegs are consecutive in the memfd and in the area */
+	va = mmap(mcfg->memseg[0].addr, len, PROT_READ | PROT_WRITE,
+		MAP_SHARED, fd, 0);
+	close(fd);
+	if (va == MAP_FAILED) {
+		RTE_LOG(ERR, EAL, "Cannot map primary process memory: %s\n",
+			strerror(errno));
+		return -1;
+	}
+	if (va != mcfg->memseg[0].addr) {
+		RTE_LOG(ERR, EAL, "Cannot map primary process memory at %p, "
+			"got %p - please use '--base-virtaddr' option\n",
+			mcfg->memseg[0].addr, va);
+		munmap(va, len);
+		return -1;
+	}
+
+	internal_config.no_hugetlbfs = 1;
+
+	return 0;
+}
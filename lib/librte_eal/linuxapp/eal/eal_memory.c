@@ -80,10 +80,15 @@
 #include <errno.h>
 #include <sys/ioctl.h>
 #include <sys/time.h>
+#include <sys/syscall.h>
 #include <signal.h>
 #include <setjmp.h>
+#include <sched.h>
+#include <pthread.h>
+#include <linux/futex.h>
 
 #include <rte_log.h>
+#include <rte_atomic.h>
 #include <rte_memory.h>
 #include <rte_memzone.h>
 #include <rte_launch.h>
@@ -101,6 +106,9 @@
 
 #define PFN_MASK_SIZE	8
 
+/* maximum number of threads faulting the hugepages in at init */
+#define HUGEPAGE_MAP_MAX_THREADS 16
+
 #ifdef RTE_LIBRTE_XEN_DOM0
 int rte_xen_dom0_supported(void)
 {
@@ -189,6 +197,10 @@ rte_mem_virt2phy(const void *virtaddr)
 		return RTE_BAD_PHYS_ADDR;
 	}
 
+	/* the devices use the virtual addresses */
+	if (rte_eal_iova_mode() == RTE_IOVA_VA)
+		return (uintptr_t)virtaddr;
+
 	/* Cannot parse /proc/self/pagemap, no need to log errors everywhere */
 	if (!proc_pagemap_readable)
 		return RTE_BAD_PHYS_ADDR;
@@ -343,11 +355,12 @@ get_virtual_area(size_t *size, size_t hugepage_sz)
 	return addr;
 }
 
-static sigjmp_buf huge_jmpenv;
+/* per thread, as the hugepages are faulted in by several threads */
+static RTE_DEFINE_PER_LCORE(sigjmp_buf, huge_jmpenv);
 
 static void huge_sigbus_handler(int signo __rte_unused)
 {
-	siglongjmp(huge_jmpenv, 1);
+	siglongjmp(RTE_PER_LCORE(huge_jmpenv), 1);
 }
 
 /* Put setjmp into a wrap method to avoid compiling error. Any non-volatile,
@@ -356,7 +369,184 @@ static void huge_sigbus_handler(int signo __rte_unused)
  */
 static int huge_wrap_sigsetjmp(void)
 {
-	return sigsetjmp(huge_jmpenv, 1);
+	return sigsetjmp(RTE_PER_LCORE(huge_jmpenv), 1);
+}
+
+/*
+ * Create the file of a hugepage in hugetlbfs and mmap() it, at addr if not
+ * NULL, faulting the page in. The virtual address is stored in hp->orig_va.
+ * Returns 0 on success.
+ */
+static int
+map_hugepage_orig(struct hugepage_file *hp, uint64_t hugepage_sz, void *addr)
+{
+	void *virtaddr;
+	int fd;
+
+	fd = open(hp->filepath, O_CREAT | O_RDWR, 0600);
+	if (fd < 0) {
+		RTE_LOG(DEBUG, EAL, "%s(): open failed: %s\n", __func__,
+				strerror(errno));
+		return -1;
+	}
+
+	/* map the segment, and populate page tables,
+	 * the kernel fills this segment with zeros */
+	virtaddr = mmap(addr, hugepage_sz, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, fd, 0);
+	if (virtaddr == MAP_FAILED) {
+		RTE_LOG(DEBUG, EAL, "%s(): mmap failed: %s\n", __func__,
+				strerror(errno));
+		close(fd);
+		return -1;
+	}
+
+	/* In linux, hugetlb limitations, like cgroup, are
+	 * enforced at fault time instead of mmap(), even
+	 * with the option of MAP_POPULATE. Kernel will send
+	 * a SIGBUS signal. To avoid to be killed, save stack
+	 * environment here, if SIGBUS happens, we can jump
+	 * back here.
+	 */
+	if (huge_wrap_sigsetjmp()) {
+		RTE_LOG(DEBUG, EAL, "SIGBUS: Cannot mmap more "
+			"hugepages of size %u MB\n",
+			(unsigned)(hugepage_sz / 0x100000));
+		munmap(virtaddr, hugepage_sz);
+		close(fd);
+		unlink(hp->filepath);
+		return -1;
+	}
+	*(int *)virtaddr = 0;
+
+	/* set shared flock on the file. */
+	if (flock(fd, LOCK_SH | LOCK_NB) == -1) {
+		RTE_LOG(DEBUG, EAL, "%s(): Locking file failed:%s \n",
+			__func__, strerror(errno));
+		munmap(virtaddr, hugepage_sz);
+		close(fd);
+		return -1;
+	}
+
+	close(fd);
+
+	hp->orig_va = virtaddr;
+	return 0;
+}
+
+/* the hugepages mapped by one of the threads of map_all_hugepages_orig() */
+struct hugepage_map_share {
+	pthread_t thread;
+	int threaded;     /* share mapped by its own thread */
+	struct hugepage_file *hugepg_tbl;
+	uint64_t hugepage_sz;
+	void *vma_addr;   /* area the pages are mapped in, or NULL */
+	unsigned start;   /* first page of the share */
+	unsigned end;     /* page after the last one */
+};
+
+static void *
+map_hugepage_share(void *arg)
+{
+	struct hugepage_map_share *share = arg;
+	void *addr = NULL;
+	unsigned i;
+
+	for (i = share->start; i < share->end; i++) {
+		if (share->vma_addr != NULL)
+			addr = RTE_PTR_ADD(share->vma_addr,
+				i * share->hugepage_sz);
+		map_hugepage_orig(&share->hugepg_tbl[i], share->hugepage_sz,
+			addr);
+	}
+
+	return NULL;
+}
+
+/*
+ * Mmap all hugepages of hugepage table in their original mapping. Most of
+ * the time is spent by the kernel zeroing the pages, so they are faulted in
+ * by one thread per available cpu, each one mapping a share of the table.
+ * In IOVA VA mode, the pages are mapped in a single virtual area, so that
+ * they may not need a second mapping. The pages which could be mapped are
+ * moved at the beginning of the table, and their number is returned.
+ */
+static unsigned
+map_all_hugepages_orig(struct hugepage_file *hugepg_tbl,
+		struct hugepage_info *hpi)
+{
+	struct hugepage_map_share shares[HUGEPAGE_MAP_MAX_THREADS];
+	const unsigned num_pages = hpi->num_pages[0];
+	unsigned i, j, n_shares = 1;
+	size_t vma_len;
+	void *vma_addr = NULL;
+	cpu_set_t cpuset;
+
+	if (num_pages == 0)
+		return 0;
+
+	for (i = 0; i < num_pages; i++) {
+		hugepg_tbl[i].file_id = i;
+		hugepg_tbl[i].size = hpi->hugepage_sz;
+		eal_get_hugefile_path(hugepg_tbl[i].filepath,
+				sizeof(hugepg_tbl[i].filepath), hpi->hugedir,
+				hugepg_tbl[i].file_id);
+		hugepg_tbl[i].filepath[sizeof(hugepg_tbl[i].filepath) - 1] = '\0';
+	}
+
+	if (rte_eal_iova_mode() == RTE_IOVA_VA) {
+		vma_len = (size_t)num_pages * hpi->hugepage_sz;
+		vma_addr = get_virtual_area(&vma_len, hpi->hugepage_sz);
+		if (vma_len < (size_t)num_pages * hpi->hugepage_sz)
+			vma_addr = NULL;
+	}
+
+	/* the master thread is not pinned yet, use all the cpus it can */
+	if (pthread_getaffinity_np(pthread_self(), sizeof(cpuset),
+			&cpuset) == 0)
+		n_shares = CPU_COUNT(&cpuset);
+	n_shares = RTE_MAX(n_shares, 1U);
+	n_shares = RTE_MIN(n_shares, (unsigned)HUGEPAGE_MAP_MAX_THREADS);
+	n_shares = RTE_MIN(n_shares, num_pages);
+
+	for (i = 0; i < n_shares; i++) {
+		shares[i].threaded = 0;
+		shares[i].hugepg_tbl = hugepg_tbl;
+		shares[i].hugepage_sz = hpi->hugepage_sz;
+		shares[i].vma_addr = vma_addr;
+		shares[i].start = (uint64_t)num_pages * i / n_shares;
+		shares[i].end = (uint64_t)num_pages * (i + 1) / n_shares;
+	}
+
+	/* the first share is mapped by the calling thread, as well as the
+	 * ones no thread could be created for */
+	for (i = 1; i < n_shares; i++) {
+		if (pthread_create(&shares[i].thread, NULL,
+				map_hugepage_share, &shares[i]) == 0)
+			shares[i].threaded = 1;
+		else
+			map_hugepage_share(&shares[i]);
+	}
+	map_hugepage_share(&shares[0]);
+	for (i = 1; i < n_shares; i++) {
+		if (shares[i].threaded)
+			pthread_join(shares[i].thread, NULL);
+	}
+
+	RTE_LOG(DEBUG, EAL, "Mapped %u pages of size %u MB with %u threads\n",
+		num_pages, (unsigned)(hpi->hugepage_sz / 0x100000), n_shares);
+
+	/* keep the pages mapped at the beginning of the table */
+	for (i = 0, j = 0; i < num_pages; i++) {
+		if (hugepg_tbl[i].orig_va == NULL)
+			continue;
+		if (i != j)
+			hugepg_tbl[j] = hugepg_tbl[i];
+		j++;
+	}
+	memset(&hugepg_tbl[j], 0, (num_pages - j) * sizeof(hugepg_tbl[0]));
+
+	return j;
 }
 
 /*
@@ -376,29 +566,24 @@ map_all_hugepages(struct hugepage_file *hugepg_tbl,
 	void *vma_addr = NULL;
 	size_t vma_len = 0;
 
+	if (orig)
+		return map_all_hugepages_orig(hugepg_tbl, hpi);
+
 	for (i = 0; i < hpi->num_pages[0]; i++) {
 		uint64_t hugepage_sz = hpi->hugepage_sz;
 
-		if (orig) {
-			hugepg_tbl[i].file_id = i;
-			hugepg_tbl[i].size = hugepage_sz;
-			eal_get_hugefile_path(hugepg_tbl[i].filepath,
-					sizeof(hugepg_tbl[i].filepath), hpi->hugedir,
-					hugepg_tbl[i].file_id);
-			hugepg_tbl[i].filepath[sizeof(hugepg_tbl[i].filepath) - 1] = '\0';
-		}
 #ifndef RTE_ARCH_64
 		/* for 32-bit systems, don't remap 1G and 16G pages, just reuse
 		 * original map address as final map address.
 		 */
-		else if ((hugepage_sz == RTE_PGSIZE_1G)
+		if ((hugepage_sz == RTE_PGSIZE_1G)
 			|| (hugepage_sz == RTE_PGSIZE_16G)) {
 			hugepg_tbl[i].final_va = hugepg_tbl[i].orig_va;
 			hugepg_tbl[i].orig_va = NULL;
 			continue;
 		}
 #endif
-		else if (vma_len == 0) {
+		if (vma_len == 0) {
 			unsigned j, num_pages;
 
 			/* reserve a virtual area for next contiguous
@@ -436,8 +621,6 @@ map_all_hugepages(struct hugepage_file *hugepg_tbl,
 			return i;
 		}
 
-		/* map the segment, and populate page tables,
-		 * the kernel fills this segment with zeros */
 		virtaddr = mmap(vma_addr, hugepage_sz, PROT_READ | PROT_WRITE,
 				MAP_SHARED | MAP_POPULATE, fd, 0);
 		if (virtaddr == MAP_FAILED) {
@@ -447,33 +630,7 @@ map_all_hugepages(struct hugepage_file *hugepg_tbl,
 			return i;
 		}
 
-		if (orig) {
-			hugepg_tbl[i].orig_va = virtaddr;
-		}
-		else {
-			hugepg_tbl[i].final_va = virtaddr;
-		}
-
-		if (orig) {
-			/* In linux, hugetlb limitations, like cgroup, are
-			 * enforced at fault time instead of mmap(), even
-			 * with the option of MAP_POPULATE. Kernel will send
-			 * a SIGBUS signal. To avoid to be killed, save stack
-			 * environment here, if SIGBUS happens, we can jump
-			 * back here.
-			 */
-			if (huge_wrap_sigsetjmp()) {
-				RTE_LOG(DEBUG, EAL, "SIGBUS: Cannot mmap more "
-					"hugepages of size %u MB\n",
-					(unsigned)(hugepage_sz / 0x100000));
-				munmap(virtaddr, hugepage_sz);
-				close(fd);
-				unlink(hugepg_tbl[i].filepath);
-				return i;
-			}
-			*(int *)virtaddr = 0;
-		}
-
+		hugepg_tbl[i].final_va = virtaddr;
 
 		/* set shared flock on the file. */
 		if (flock(fd, LOCK_SH | LOCK_NB) == -1) {
@@ -506,9 +663,37 @@ unmap_all_hugepages_orig(struct hugepage_file *hugepg_tbl, struct hugepage_info
         return 0;
 }
 
+static int
+cmp_orig_va_ptr(const void *a, const void *b)
+{
+	const struct hugepage_file *p1 = *(struct hugepage_file * const *)a;
+	const struct hugepage_file *p2 = *(struct hugepage_file * const *)b;
+
+	if (p1->orig_va < p2->orig_va)
+		return -1;
+	else if (p1->orig_va > p2->orig_va)
+		return 1;
+	else
+		return 0;
+}
+
+static int
+cmp_va_orig_va_ptr(const void *key, const void *b)
+{
+	const struct hugepage_file *p = *(struct hugepage_file * const *)b;
+
+	if (key < p->orig_va)
+		return -1;
+	else if (key > p->orig_va)
+		return 1;
+	else
+		return 0;
+}
+
 /*
  * Parse /proc/self/numa_maps to get the NUMA socket ID for each huge
- * page.
+ * page. The pages are looked up by their virtual address in a sorted
+ * array of pointers to the table entries.
  */
 static int
 find_numasocket(struct hugepage_file *hugepg_tbl, struct hugepage_info *hpi)
@@ -519,6 +704,7 @@ find_numasocket(struct hugepage_file *hugepg_tbl, struct hugepage_info *hpi)
 	uint64_t virt_addr;
 	char buf[BUFSIZ];
 	char hugedir_str[PATH_MAX];
+	struct hugepage_file **sorted, **hp;
 	FILE *f;
 
 	f = fopen("/proc/self/numa_maps", "r");
@@ -528,6 +714,17 @@ find_numasocket(struct hugepage_file *hugepg_tbl, struct hugepage_info *hpi)
 		return 0;
 	}
 
+	sorted = malloc(hpi->num_pages[0] * sizeof(sorted[0]));
+	if (sorted == NULL) {
+		RTE_LOG(ERR, EAL, "%s(): cannot allocate page index\n",
+			__func__);
+		fclose(f);
+		return -1;
+	}
+	for (i = 0; i < hpi->num_pages[0]; i++)
+		sorted[i] = &hugepg_tbl[i];
+	qsort(sorted, hpi->num_pages[0], sizeof(sorted[0]), cmp_orig_va_ptr);
+
 	snprintf(hugedir_str, sizeof(hugedir_str),
 			"%s/%s", hpi->hugedir, internal_config.hugefile_prefix);
 
@@ -568,22 +765,24 @@ find_numasocket(struct hugepage_file *hugepg_tbl, struct hugepage_info *hpi)
 		}
 
 		/* if we find this page in our mappings, set socket_id */
-		for (i = 0; i < hpi->num_pages[0]; i++) {
-			void *va = (void *)(unsigned long)virt_addr;
-			if (hugepg_tbl[i].orig_va == va) {
-				hugepg_tbl[i].socket_id = socket_id;
-				hp_count++;
-			}
+		hp = bsearch((void *)(unsigned long)virt_addr, sorted,
+			hpi->num_pages[0], sizeof(sorted[0]),
+			cmp_va_orig_va_ptr);
+		if (hp != NULL) {
+			(*hp)->socket_id = socket_id;
+			hp_count++;
 		}
 	}
 
 	if (hp_count < hpi->num_pages[0])
 		goto error;
 
+	free(sorted);
 	fclose(f);
 	return 0;
 
 error:
+	free(sorted);
 	fclose(f);
 	return -1;
 }
@@ -607,6 +806,77 @@ cmp_physaddr(const void *a, const void *b)
 		return 0;
 }
 
+/* sort by socket then virtual address, when physical ones are not used */
+static int
+cmp_socket_orig_va(const void *a, const void *b)
+{
+	const struct hugepage_file *p1 = (const struct hugepage_file *)a;
+	const struct hugepage_file *p2 = (const struct hugepage_file *)b;
+
+	if (p1->socket_id != p2->socket_id)
+		return p1->socket_id < p2->socket_id ? -1 : 1;
+	if (p1->orig_va < p2->orig_va)
+		return -1;
+	else if (p1->orig_va > p2->orig_va)
+		return 1;
+	else
+		return 0;
+}
+
+/*
+ * In IOVA VA mode, the physical addresses are not needed: the pages,
+ * sorted by socket, only have to be virtually contiguous. If they already
+ * are in their original mapping, it is kept as the final one, else they
+ * are remapped in contiguous areas. Their "physical" address is their
+ * virtual one.
+ */
+static int
+remap_hugepages_va(struct hugepage_file *hugepg_tbl,
+		struct hugepage_info *hpi)
+{
+	unsigned i;
+	int contig = 1;
+
+	qsort(hugepg_tbl, hpi->num_pages[0], sizeof(struct hugepage_file),
+		cmp_socket_orig_va);
+
+	for (i = 1; i < hpi->num_pages[0]; i++) {
+		if (hugepg_tbl[i].socket_id == hugepg_tbl[i - 1].socket_id &&
+				RTE_PTR_DIFF(hugepg_tbl[i].orig_va,
+				hugepg_tbl[i - 1].orig_va) != hpi->hugepage_sz) {
+			contig = 0;
+			break;
+		}
+	}
+
+	if (contig) {
+		for (i = 0; i < hpi->num_pages[0]; i++) {
+			hugepg_tbl[i].final_va = hugepg_tbl[i].orig_va;
+			hugepg_tbl[i].orig_va = NULL;
+		}
+	} else {
+		/* make the remapping put all pages of a socket together */
+		for (i = 0; i < hpi->num_pages[0]; i++)
+			hugepg_tbl[i].physaddr = (uint64_t)i * hpi->hugepage_sz;
+
+		if (map_all_hugepages(hugepg_tbl, hpi, 0) !=
+				hpi->num_pages[0])
+			return -1;
+		if (unmap_all_hugepages_orig(hugepg_tbl, hpi) < 0)
+			return -1;
+	}
+
+	for (i = 0; i < hpi->num_pages[0]; i++)
+		hugepg_tbl[i].physaddr =
+			(uint64_t)(uintptr_t)hugepg_tbl[i].final_va;
+
+	RTE_LOG(DEBUG, EAL, "%s %u MB pages for IOVA VA mode\n",
+		contig ? "Kept original mapping of" : "Remapped",
+		(unsigned)(hpi->hugepage_sz / 0x100000));
+
+	return 0;
+}
+
 /*
  * Uses mmap to create a shared memory area for storage of data
  * Used in this file to store the hugepage file map on disk
@@ -937,6 +1207,39 @@ huge_recover_sigbus(void)
  *  6. unmap the first mapping
  *  7. fill memsegs in configuration with contiguous zones
  */
+/*
+ * In dynamic memory mode, only map at init the hugepages of the largest
+ * size needed for the memory given with -m, a single one by default, not
+ * all the hugepages of the system. The memory given per socket with
+ * --socket-mem is added by eal_memory_grow() once the heaps exist, which
+ * takes it from the right socket directly.
+ */
+static void
+dynmem_limit_init_pages(void)
+{
+	struct hugepage_info *hpi = &internal_config.hugepage_info[0];
+	uint64_t n_pages;
+	unsigned i;
+
+	if (internal_config.force_sockets) {
+		for (i = 0; i < RTE_MAX_NUMA_NODES; i++) {
+			internal_config.dynamic_socket_mem[i] =
+				internal_config.socket_mem[i];
+			internal_config.socket_mem[i] = 0;
+		}
+		internal_config.force_sockets = 0;
+		internal_config.memory = 0;
+	}
+	if (internal_config.memory == 0)
+		internal_config.memory = hpi->hugepage_sz;
+
+	n_pages = RTE_ALIGN_CEIL(internal_config.memory, hpi->hugepage_sz) /
+		hpi->hugepage_sz;
+	hpi->num_pages[0] = RTE_MIN(hpi->num_pages[0], n_pages);
+	for (i = 1; i < internal_config.num_hugepage_sizes; i++)
+		internal_config.hugepage_info[i].num_pages[0] = 0;
+}
+
 int
 rte_eal_hugepage_init(void)
 {
@@ -949,9 +1252,11 @@ rte_eal_hugepage_init(void)
 	unsigned hp_offset;
 	int i, j, new_memseg;
 	int nr_hugefiles, nr_hugepages = 0;
-	void *addr;
+	int iova_va = (rte_eal_iova_mode() == RTE_IOVA_VA);
+	uint64_t t_map = 0, t_phys = 0, t_numa = 0, t_remap = 0, tsc;
 
-	test_proc_pagemap_readable();
+	if (!iova_va)
+		test_proc_pagemap_readable();
 
 	memset(used_hp, 0, sizeof(used_hp));
 
@@ -959,21 +1264,8 @@ rte_eal_hugepage_init(void)
 	mcfg = rte_eal_get_configuration()->mem_config;
 
 	/* hugetlbfs can be disabled */
-	if (internal_config.no_hugetlbfs) {
-		addr = mmap(NULL, internal_config.memory, PROT_READ | PROT_WRITE,
-				MAP_PRIVATE | MAP_ANONYMOUS, 0, 0);
-		if (addr == MAP_FAILED) {
-			RTE_LOG(ERR, EAL, "%s: mmap() failed: %s\n", __func__,
-					strerror(errno));
-			return -1;
-		}
-		mcfg->memseg[0].phys_addr = (phys_addr_t)(uintptr_t)addr;
-		mcfg->memseg[0].addr = addr;
-		mcfg->memseg[0].hugepage_sz = RTE_PGSIZE_4K;
-		mcfg->memseg[0].len = internal_config.memory;
-		mcfg->memseg[0].socket_id = 0;
-		return 0;
-	}
+	if (internal_config.no_hugetlbfs)
+		return eal_memfd_init();
 
 /* check if app runs on Xen Dom0 */
 	if (internal_config.xen_dom0_support) {
@@ -986,6 +1278,9 @@ rte_eal_hugepage_init(void)
 #endif
 	}
 
+	if (internal_config.dynamic_mem)
+		dynmem_limit_init_pages();
+
 	/* calculate total number of hugepages available. at this point we haven't
 	 * yet started sorting them so they all are on socket 0 */
 	for (i = 0; i < (int) internal_config.num_hugepage_sizes; i++) {
@@ -1027,8 +1322,10 @@ rte_eal_hugepage_init(void)
 			continue;
 
 		/* map all hugepages available */
+		tsc = eal_get_time_us();
 		pages_old = hpi->num_pages[0];
 		pages_new = map_all_hugepages(&tmp_hp[hp_offset], hpi, 1);
+		t_map += eal_get_time_us() - tsc;
 		if (pages_new < pages_old) {
 			RTE_LOG(DEBUG, EAL,
 				"%d not %d hugepages of size %u MB allocated\n",
@@ -1044,17 +1341,33 @@ rte_eal_hugepage_init(void)
 		}
 
 		/* find physical addresses and sockets for each hugepage */
-		if (find_physaddrs(&tmp_hp[hp_offset], hpi) < 0){
+		tsc = eal_get_time_us();
+		if (!iova_va && find_physaddrs(&tmp_hp[hp_offset], hpi) < 0) {
 			RTE_LOG(DEBUG, EAL, "Failed to find phys addr for %u MB pages\n",
 					(unsigned)(hpi->hugepage_sz / 0x100000));
 			goto fail;
 		}
+		t_phys += eal_get_time_us() - tsc;
 
+		tsc = eal_get_time_us();
 		if (find_numasocket(&tmp_hp[hp_offset], hpi) < 0){
 			RTE_LOG(DEBUG, EAL, "Failed to find NUMA socket for %u MB pages\n",
 					(unsigned)(hpi->hugepage_sz / 0x100000));
 			goto fail;
 		}
+		t_numa += eal_get_time_us() - tsc;
+
+		tsc = eal_get_time_us();
+		if (iova_va) {
+			if (remap_hugepages_va(&tmp_hp[hp_offset], hpi) < 0) {
+				RTE_LOG(ERR, EAL, "Failed to remap %u MB pages\n",
+					(unsigned)(hpi->hugepage_sz / 0x100000));
+				goto fail;
+			}
+			t_remap += eal_get_time_us() - tsc;
+			hp_offset += hpi->num_pages[0];
+			continue;
+		}
 
 		qsort(&tmp_hp[hp_offset], hpi->num_pages[0],
 		      sizeof(struct hugepage_file), cmp_physaddr);
@@ -1070,6 +1383,7 @@ rte_eal_hugepage_init(void)
 		/* unmap original mappings */
 		if (unmap_all_hugepages_orig(&tmp_hp[hp_offset], hpi) < 0)
 			goto fail;
+		t_remap += eal_get_time_us() - tsc;
 
 		/* we have processed a num of hugepages of this size, so inc offset */
 		hp_offset += hpi->num_pages[0];
@@ -1077,6 +1391,10 @@ rte_eal_hugepage_init(void)
 
 	huge_recover_sigbus();
 
+	RTE_LOG(DEBUG, EAL, "Hugepage init: map %"PRIu64" us, physaddr %"
+		PRIu64" us, numa %"PRIu64" us, sort and remap %"PRIu64" us\n",
+		t_map, t_phys, t_numa, t_remap);
+
 	if (internal_config.memory == 0 && internal_config.force_sockets == 0)
 		internal_config.memory = eal_get_hugepage_mem_size();
 
@@ -1240,6 +1558,17 @@ rte_eal_hugepage_init(void)
 		goto fail;
 	}
 
+	/* dynamic memsegs are appended after the ones mapped at init */
+	if (internal_config.dynamic_mem) {
+		for (i = 0; i < RTE_MAX_MEMSEG && mcfg->memseg[i].len > 0; i++)
+			;
+		mcfg->dynmem_first = i;
+		mcfg->dynmem_page_sz =
+			internal_config.hugepage_info[0].hugepage_sz;
+		snprintf(mcfg->dynmem_dir, sizeof(mcfg->dynmem_dir), "%s",
+			internal_config.hugepage_info[0].hugedir);
+	}
+
 	munmap(hugepage, nr_hugefiles * sizeof(struct hugepage_file));
 
 	return 0;
@@ -1279,6 +1608,7 @@ rte_eal_hugepage_attach(void)
 	unsigned num_hp = 0;
 	unsigned i, s = 0; /* s used to track the segment number */
 	unsigned max_seg = RTE_MAX_MEMSEG;
+	unsigned nb_seg = RTE_MAX_MEMSEG;
 	off_t size = 0;
 	int fd, fd_zero = -1, fd_hugepage = -1;
 
@@ -1291,6 +1621,10 @@ rte_eal_hugepage_attach(void)
 
 	test_proc_pagemap_readable();
 
+	/* the primary process runs without hugetlbfs */
+	if (mcfg->no_hugetlbfs)
+		return eal_memfd_attach();
+
 	if (internal_config.xen_dom0_support) {
 #ifdef RTE_LIBRTE_XEN_DOM0
 		if (rte_xen_dom0_memory_attach() < 0) {
@@ -1302,6 +1636,14 @@ rte_eal_hugepage_attach(void)
 #endif
 	}
 
+	/* the dynamic memsegs are not in the hugepage info file, they are
+	 * mapped by eal_memory_sync_init() */
+	if (mcfg->dynmem_first != 0) {
+		internal_config.dynamic_mem = 1;
+		nb_seg = mcfg->dynmem_first;
+		max_seg = nb_seg;
+	}
+
 	fd_zero = open("/dev/zero", O_RDONLY);
 	if (fd_zero < 0) {
 		RTE_LOG(ERR, EAL, "Could not open /dev/zero\n");
@@ -1314,7 +1656,7 @@ rte_eal_hugepage_attach(void)
 	}
 
 	/* map all segments into memory to make sure we get the addrs */
-	for (s = 0; s < RTE_MAX_MEMSEG; ++s) {
+	for (s = 0; s < nb_seg; ++s) {
 		void *base_addr;
 
 		/*
@@ -1369,7 +1711,7 @@ rte_eal_hugepage_attach(void)
 	RTE_LOG(DEBUG, EAL, "Analysing %u files\n", num_hp);
 
 	s = 0;
-	while (s < RTE_MAX_MEMSEG && mcfg->memseg[s].len > 0){
+	while (s < nb_seg && mcfg->memseg[s].len > 0){
 		void *addr, *base_addr;
 		uintptr_t offset = 0;
 		size_t mapping_size;
@@ -1426,3 +1768,722 @@ rte_eal_hugepage_attach(void)
 		close(fd_hugepage);
 	return -1;
 }
+
+/*
+ * Dynamic memory: with --dynamic-mem, the heaps grow after init by mapping
+ * new hugepages. As at init, each page has its own file in hugetlbfs, so
+ * that the pages can be sorted by physical address and remapped in a
+ * contiguous virtual area, which is split in as many memsegs as it has
+ * physically contiguous blocks. The memsegs of each new mapping are
+ * appended after the ones mapped at init, and only the last mapping can be
+ * released, so that the memseg array never has holes.
+ *
+ * Each process using the memory registers in mcfg->dynmem_procs and runs a
+ * thread which maps the new memory as soon as mcfg->dynmem_gen changes.
+ * eal_memory_grow() returns once all the registered processes have mapped
+ * the new memory and run their memory event callbacks, so that a pointer
+ * to it can be followed in any process. The memory released is unmapped by
+ * the other processes in the same way, without waiting for them.
+ *
+ * dynmem_grow_lock serializes the changes, the pages are populated with
+ * this lock only. dynmem_lock protects the memsegs while they are updated
+ * or mapped.
+ */
+
+/* minimum amount of memory added at once */
+#define DYNMEM_MIN_LEN (8ULL << 20)
+
+/* time given to the other processes to map the memory added */
+#define DYNMEM_SYNC_TIMEOUT_MS 5000
+
+/* period of the sync thread when it is not woken up */
+#define DYNMEM_SYNC_PERIOD_MS 1000
+
+/* memory policy values of <numaif.h>, to avoid depending on libnuma */
+#ifndef MPOL_DEFAULT
+#define MPOL_DEFAULT 0
+#endif
+#ifndef MPOL_PREFERRED
+#define MPOL_PREFERRED 1
+#endif
+#ifndef MPOL_F_NODE
+#define MPOL_F_NODE (1 << 0)
+#endif
+#ifndef MPOL_F_ADDR
+#define MPOL_F_ADDR (1 << 1)
+#endif
+
+/* dynamic mappings of this process, indexed by their first memseg */
+static struct {
+	uint32_t id;   /* id of the mapping, 0 if not mapped */
+	void *addr;
+	size_t len;
+	unsigned n_memseg;
+} dynmem_local[RTE_MAX_MEMSEG];
+
+/* copy of the memsegs of the mappings, for the memory event callbacks */
+static struct rte_memseg dynmem_local_ms[RTE_MAX_MEMSEG];
+
+/* value of dynmem_gen when this process was last in sync */
+static volatile uint32_t dynmem_local_gen;
+
+/* protects the above, and orders the memory event callbacks */
+static pthread_mutex_t dynmem_local_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* slot of this process in mcfg->dynmem_procs, -1 if not registered */
+static int dynmem_proc_slot = -1;
+
+/* a page being added by eal_memory_grow() */
+struct dynmem_page {
+	phys_addr_t physaddr;
+	void *addr;
+	unsigned file_id; /* index of its file before sorting */
+};
+
+static int
+cmp_dynmem_page(const void *a, const void *b)
+{
+	const struct dynmem_page *p1 = a;
+	const struct dynmem_page *p2 = b;
+
+	if (p1->physaddr < p2->physaddr)
+		return -1;
+	else if (p1->physaddr > p2->physaddr)
+		return 1;
+	else
+		return 0;
+}
+
+/* length and number of memsegs of the dynamic mapping starting at first */
+static size_t
+dynmem_mapping_len(const struct rte_mem_config *mcfg, unsigned first,
+		unsigned *n_memseg)
+{
+	size_t len = 0;
+	unsigned i;
+
+	for (i = first; i < RTE_MAX_MEMSEG && mcfg->memseg[i].len > 0 &&
+			mcfg->dynmem_map[i] == first; i++)
+		len += mcfg->memseg[i].len;
+	*n_memseg = i - first;
+
+	return len;
+}
+
+/* NUMA node of a mapped address, 0 if the kernel has no NUMA support */
+static int
+dynmem_addr_node(void *addr)
+{
+	int node;
+
+	if (syscall(SYS_get_mempolicy, &node, NULL, 0, addr,
+			MPOL_F_NODE | MPOL_F_ADDR) < 0)
+		return 0;
+
+	return node;
+}
+
+/* map one page file of a dynamic mapping, at the given address if not NULL */
+static void *
+dynmem_map_page(const char *path, void *addr, size_t page_sz, int flags)
+{
+	void *va;
+	int fd;
+
+	fd = open(path, O_RDWR | flags, 0600);
+	if (fd < 0) {
+		RTE_LOG(DEBUG, EAL, "%s(): cannot open %s: %s\n", __func__,
+			path, strerror(errno));
+		return NULL;
+	}
+
+	va = mmap(addr, page_sz, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, fd, 0);
+	if (va == MAP_FAILED || (addr != NULL && va != addr)) {
+		RTE_LOG(DEBUG, EAL, "%s(): cannot mmap %s at [%p]\n",
+			__func__, path, addr);
+		if (va != MAP_FAILED)
+			munmap(va, page_sz);
+		close(fd);
+		return NULL;
+	}
+
+	/* keep the file from being removed by a new primary process */
+	if (addr != NULL)
+		flock(fd, LOCK_SH | LOCK_NB);
+	close(fd);
+
+	return va;
+}
+
+/* wait for dynmem_gen to change from gen, for a sync period at most */
+static void
+dynmem_gen_wait(struct rte_mem_config *mcfg, uint32_t gen)
+{
+	struct timespec ts = {
+		.tv_sec = DYNMEM_SYNC_PERIOD_MS / 1000,
+		.tv_nsec = (DYNMEM_SYNC_PERIOD_MS % 1000) * 1000000,
+	};
+
+	/* the shared config is a shared mapping, the futex is not private */
+	syscall(SYS_futex, &mcfg->dynmem_gen, FUTEX_WAIT, gen, &ts, NULL, 0);
+}
+
+static void
+dynmem_gen_wake(struct rte_mem_config *mcfg)
+{
+	syscall(SYS_futex, &mcfg->dynmem_gen, FUTEX_WAKE, INT_MAX, NULL,
+		NULL, 0);
+}
+
+/* tell the other processes this one is in sync up to dynmem_local_gen */
+static void
+dynmem_proc_ack(struct rte_mem_config *mcfg)
+{
+	if (dynmem_proc_slot >= 0)
+		mcfg->dynmem_procs[dynmem_proc_slot].gen = dynmem_local_gen;
+}
+
+/* a registered process which exited without unregistering */
+static int
+dynmem_proc_dead(uint32_t pid)
+{
+	return kill((pid_t)pid, 0) < 0 && errno == ESRCH;
+}
+
+/*
+ * Wake up the sync threads, and wait for the other registered processes to
+ * be in sync up to generation gen. Returns 0 on success, -1 on timeout.
+ */
+static int
+dynmem_procs_wait(struct rte_mem_config *mcfg, uint32_t gen)
+{
+	const uint64_t deadline = eal_get_time_us() +
+		DYNMEM_SYNC_TIMEOUT_MS * 1000ULL;
+	uint32_t pid, pending;
+	unsigned i;
+
+	dynmem_gen_wake(mcfg);
+
+	for (;;) {
+		pending = 0;
+		for (i = 0; i < RTE_DYNMEM_MAX_PROCS; i++) {
+			pid = mcfg->dynmem_procs[i].pid;
+			if (pid == 0 || (int)i == dynmem_proc_slot ||
+					(int32_t)(mcfg->dynmem_procs[i].gen -
+						gen) >= 0)
+				continue;
+			if (dynmem_proc_dead(pid)) {
+				rte_atomic32_cmpset(&mcfg->dynmem_procs[i].pid,
+					pid, 0);
+				continue;
+			}
+			pending = pid;
+		}
+		if (pending == 0)
+			return 0;
+
+		if (eal_get_time_us() > deadline) {
+			RTE_LOG(ERR, EAL, "Process %u did not map the new "
+				"memory\n", pending);
+			return -1;
+		}
+		usleep(100);
+	}
+}
+
+/* call the memory event callbacks for some mappings of this process */
+static void
+dynmem_notify(enum rte_mem_event event, const unsigned *first, unsigned n)
+{
+	unsigned i;
+
+	for (i = 0; i < n; i++)
+		eal_mem_event_notify(event, &dynmem_local_ms[first[i]],
+			dynmem_local[first[i]].n_memseg);
+}
+
+/*
+ * Unmap the mappings which were released, listing them in freed. Called
+ * with dynmem_lock held. Returns the number of mappings listed.
+ */
+static unsigned
+dynmem_unmap_released(const struct rte_mem_config *mcfg, unsigned *freed)
+{
+	unsigned i, n_freed = 0;
+
+	for (i = mcfg->dynmem_first; i < RTE_MAX_MEMSEG; i++) {
+		if (dynmem_local[i].id == 0)
+			continue;
+		if (mcfg->memseg[i].len > 0 && mcfg->dynmem_map[i] == i &&
+				mcfg->dynmem_id[i] == dynmem_local[i].id)
+			continue;
+
+		munmap(dynmem_local[i].addr, dynmem_local[i].len);
+		dynmem_local[i].id = 0;
+		freed[n_freed++] = i;
+	}
+
+	return n_freed;
+}
+
+/*
+ * Map the new mappings at the address they have in the other processes,
+ * listing them in added. Called with dynmem_lock held. Returns 0 on
+ * success, -1 if a mapping could not be mapped yet.
+ */
+static int
+dynmem_map_added(const struct rte_mem_config *mcfg, unsigned *added,
+		unsigned *n_added)
+{
+	const uint64_t page_sz = mcfg->dynmem_page_sz;
+	char path[PATH_MAX];
+	unsigned i, j, n_pages, n_memseg;
+	size_t len;
+	int ret = 0;
+
+	*n_added = 0;
+	for (i = mcfg->dynmem_first;
+			i < RTE_MAX_MEMSEG && mcfg->memseg[i].len > 0; i++) {
+		if (mcfg->dynmem_map[i] != i ||
+				dynmem_local[i].id == mcfg->dynmem_id[i])
+			continue;
+
+		/* released after dynmem_unmap_released() looked at it */
+		if (dynmem_local[i].id != 0) {
+			ret = -1;
+			continue;
+		}
+
+		len = dynmem_mapping_len(mcfg, i, &n_memseg);
+		n_pages = len / page_sz;
+		for (j = 0; j < n_pages; j++) {
+			eal_get_dyn_hugefile_path(path, sizeof(path),
+				mcfg->dynmem_dir, mcfg->dynmem_id[i], j);
+			if (dynmem_map_page(path,
+					RTE_PTR_ADD(mcfg->memseg[i].addr,
+						j * page_sz), page_sz, 0) == NULL)
+				break;
+		}
+		if (j < n_pages) {
+			RTE_LOG(ERR, EAL, "Could not map dynamic memory at "
+				"[%p]\n", mcfg->memseg[i].addr);
+			if (j > 0)
+				munmap(mcfg->memseg[i].addr, j * page_sz);
+			ret = -1;
+			continue;
+		}
+
+		dynmem_local[i].id = mcfg->dynmem_id[i];
+		dynmem_local[i].addr = mcfg->memseg[i].addr;
+		dynmem_local[i].len = len;
+		dynmem_local[i].n_memseg = n_memseg;
+		memcpy(&dynmem_local_ms[i], &mcfg->memseg[i],
+			n_memseg * sizeof(mcfg->memseg[0]));
+		added[(*n_added)++] = i;
+	}
+
+	return ret;
+}
+
+void
+eal_memory_sync(void)
+{
+	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
+	unsigned changed[RTE_MAX_MEMSEG], n_changed;
+	uint32_t gen;
+	int ret;
+
+	if (likely(dynmem_local_gen == mcfg->dynmem_gen))
+		return;
+
+	pthread_mutex_lock(&dynmem_local_lock);
+
+	/* the callbacks run without dynmem_lock, and the released mappings
+	 * are reported before their memsegs are reused */
+	rte_spinlock_lock(&mcfg->dynmem_lock);
+	gen = mcfg->dynmem_gen;
+	n_changed = dynmem_unmap_released(mcfg, changed);
+	rte_spinlock_unlock(&mcfg->dynmem_lock);
+	dynmem_notify(RTE_MEM_EVENT_FREE, changed, n_changed);
+
+	rte_spinlock_lock(&mcfg->dynmem_lock);
+	ret = dynmem_map_added(mcfg, changed, &n_changed);
+	rte_spinlock_unlock(&mcfg->dynmem_lock);
+	dynmem_notify(RTE_MEM_EVENT_ALLOC, changed, n_changed);
+
+	/* on failure, stay out of sync to retry on the next call */
+	if (ret == 0) {
+		dynmem_local_gen = gen;
+		dynmem_proc_ack(mcfg);
+	}
+
+	pthread_mutex_unlock(&dynmem_local_lock);
+}
+
+static void *
+dynmem_sync_thread(__rte_unused void *arg)
+{
+	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
+	uint32_t gen;
+
+	for (;;) {
+		gen = mcfg->dynmem_gen;
+		eal_memory_sync();
+		dynmem_gen_wait(mcfg, gen);
+	}
+
+	return NULL;
+}
+
+static void
+dynmem_proc_unregister(void)
+{
+	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
+
+	if (dynmem_proc_slot >= 0)
+		mcfg->dynmem_procs[dynmem_proc_slot].pid = 0;
+	dynmem_proc_slot = -1;
+}
+
+int
+eal_memory_sync_init(void)
+{
+	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
+	char thread_name[RTE_MAX_THREAD_NAME_LEN];
+	pthread_t thread;
+	uint32_t pid;
+	unsigned i;
+
+	/* register first, so that the memory added meanwhile is waited for */
+	for (i = 0; i < RTE_DYNMEM_MAX_PROCS; i++) {
+		pid = mcfg->dynmem_procs[i].pid;
+		if (pid != 0 && !dynmem_proc_dead(pid))
+			continue;
+		if (rte_atomic32_cmpset(&mcfg->dynmem_procs[i].pid, pid,
+				getpid())) {
+			mcfg->dynmem_procs[i].gen = 0;
+			dynmem_proc_slot = i;
+			break;
+		}
+	}
+	if (dynmem_proc_slot < 0) {
+		RTE_LOG(ERR, EAL, "More than %d processes use dynamic memory\n",
+			RTE_DYNMEM_MAX_PROCS);
+		return -1;
+	}
+	atexit(dynmem_proc_unregister);
+
+	eal_memory_sync();
+	dynmem_proc_ack(mcfg);
+
+	if (pthread_create(&thread, NULL, dynmem_sync_thread, NULL) != 0) {
+		RTE_LOG(ERR, EAL, "Cannot create dynamic memory thread\n");
+		return -1;
+	}
+	snprintf(thread_name, sizeof(thread_name), "eal-dynmem");
+	rte_thread_setname(thread, thread_name);
+
+	return 0;
+}
+
+/*
+ * Populate the pages of a new mapping, one file per page, preferring the
+ * given socket. The files are named after the final ones, with page indexes
+ * starting at n_pages, so that they can be renamed once the pages are
+ * sorted. Returns the number of pages populated.
+ */
+static unsigned
+dynmem_populate(const struct rte_mem_config *mcfg, struct dynmem_page *pages,
+		unsigned n_pages, uint32_t id, int socket_id)
+{
+	const uint64_t page_sz = mcfg->dynmem_page_sz;
+	unsigned long old_nodes = 0, new_nodes = 1UL << socket_id;
+	char path[PATH_MAX];
+	int old_mode;
+	unsigned i;
+
+	if (syscall(SYS_get_mempolicy, &old_mode, &old_nodes,
+			sizeof(old_nodes) * CHAR_BIT, NULL, 0) < 0)
+		old_mode = -1;
+	if (old_mode >= 0)
+		syscall(SYS_set_mempolicy, MPOL_PREFERRED, &new_nodes,
+			sizeof(new_nodes) * CHAR_BIT);
+
+	/* hugetlb limits are enforced at fault time, see map_all_hugepages() */
+	huge_register_sigbus();
+	for (i = 0; i < n_pages; i++) {
+		eal_get_dyn_hugefile_path(path, sizeof(path), mcfg->dynmem_dir,
+			id, n_pages + i);
+		pages[i].file_id = i;
+		pages[i].addr = dynmem_map_page(path, NULL, page_sz,
+			O_CREAT | O_TRUNC);
+		if (pages[i].addr == NULL) {
+			unlink(path);
+			break;
+		}
+
+		if (huge_wrap_sigsetjmp()) {
+			RTE_LOG(DEBUG, EAL, "SIGBUS: Cannot mmap more "
+				"hugepages of size %u MB\n",
+				(unsigned)(page_sz / 0x100000));
+			munmap(pages[i].addr, page_sz);
+			unlink(path);
+			break;
+		}
+		*(volatile int *)pages[i].addr = 0;
+	}
+	huge_recover_sigbus();
+
+	if (old_mode >= 0)
+		syscall(SYS_set_mempolicy, old_mode,
+			old_mode == MPOL_DEFAULT ? NULL : &old_nodes,
+			sizeof(old_nodes) * CHAR_BIT);
+
+	return i;
+}
+
+/*
+ * Remove the last mapping, starting at memseg first, and unmap it. Called
+ * with dynmem_grow_lock held, once this process is in sync.
+ */
+static void
+dynmem_release(struct rte_mem_config *mcfg, unsigned first)
+{
+	char path[PATH_MAX];
+	unsigned i, n_pages;
+
+	pthread_mutex_lock(&dynmem_local_lock);
+	rte_spinlock_lock(&mcfg->dynmem_lock);
+
+	/* clear the memsegs from the last one, for the same reason as in
+	 * eal_memory_grow() */
+	i = first + dynmem_local[first].n_memseg;
+	while (i-- > first) {
+		mcfg->memseg[i].len = 0;
+		rte_wmb();
+		memset(&mcfg->memseg[i], 0, sizeof(mcfg->memseg[i]));
+	}
+
+	n_pages = dynmem_local[first].len / mcfg->dynmem_page_sz;
+	for (i = 0; i < n_pages; i++) {
+		eal_get_dyn_hugefile_path(path, sizeof(path), mcfg->dynmem_dir,
+			mcfg->dynmem_id[first], i);
+		unlink(path);
+	}
+	mcfg->dynmem_id[first] = 0;
+	rte_wmb();
+	mcfg->dynmem_gen++;
+	dynmem_local_gen = mcfg->dynmem_gen;
+
+	rte_spinlock_unlock(&mcfg->dynmem_lock);
+
+	RTE_LOG(DEBUG, EAL, "Released %zu MB from memseg %u\n",
+		dynmem_local[first].len >> 20, first);
+
+	munmap(dynmem_local[first].addr, dynmem_local[first].len);
+	dynmem_local[first].id = 0;
+	dynmem_notify(RTE_MEM_EVENT_FREE, &first, 1);
+	dynmem_proc_ack(mcfg);
+
+	pthread_mutex_unlock(&dynmem_local_lock);
+
+	dynmem_gen_wake(mcfg);
+}
+
+int
+eal_memory_grow(int socket_id, size_t len, unsigned *n_memseg)
+{
+	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
+	const uint64_t page_sz = mcfg->dynmem_page_sz;
+	struct dynmem_page *pages = NULL;
+	char path[PATH_MAX], tmp_path[PATH_MAX];
+	unsigned i, first, ms_id, n_pages, n_mapped = 0;
+	struct rte_memseg *ms = NULL;
+	size_t vma_len;
+	void *vma_addr;
+	uint32_t id;
+	int ret = -1;
+
+	len = RTE_ALIGN_CEIL(RTE_MAX((uint64_t)len, DYNMEM_MIN_LEN), page_sz);
+	n_pages = len / page_sz;
+
+	/* do not populate pages to find out the socket does not exist */
+	snprintf(path, sizeof(path), "/sys/devices/system/node/node%d",
+		socket_id);
+	if (socket_id != 0 && access(path, F_OK) != 0)
+		return -1;
+
+	pages = calloc(n_pages, sizeof(pages[0]));
+	if (pages == NULL)
+		return -1;
+
+	/* the memsegs only change with this lock held, the ones of this
+	 * process stay in sync until it is released */
+	rte_spinlock_lock(&mcfg->dynmem_grow_lock);
+	eal_memory_sync();
+
+	for (first = mcfg->dynmem_first;
+			first < RTE_MAX_MEMSEG && mcfg->memseg[first].len > 0;
+			first++)
+		;
+	if (first == RTE_MAX_MEMSEG) {
+		RTE_LOG(DEBUG, EAL, "%s(): no free memseg\n", __func__);
+		goto out;
+	}
+
+	id = mcfg->dynmem_gen + 1;
+	n_mapped = dynmem_populate(mcfg, pages, n_pages, id, socket_id);
+	if (n_mapped < n_pages)
+		goto fail;
+
+	for (i = 0; i < n_pages; i++) {
+		/* in IOVA VA mode, the pages will be contiguous once
+		 * remapped, whatever their physical address */
+		if (rte_eal_iova_mode() == RTE_IOVA_VA)
+			pages[i].physaddr = (phys_addr_t)i * page_sz;
+		else
+			pages[i].physaddr = rte_mem_virt2phy(pages[i].addr);
+		if (pages[i].physaddr == RTE_BAD_PHYS_ADDR)
+			goto fail;
+		if (dynmem_addr_node(pages[i].addr) != socket_id) {
+			RTE_LOG(DEBUG, EAL, "%s(): no free hugepage on "
+				"socket %d\n", __func__, socket_id);
+			goto fail;
+		}
+	}
+	qsort(pages, n_pages, sizeof(pages[0]), cmp_dynmem_page);
+
+	/* count the physically contiguous blocks */
+	for (i = 1, ms_id = first; i < n_pages; i++) {
+		if (pages[i].physaddr != pages[i - 1].physaddr + page_sz)
+			ms_id++;
+	}
+	if (ms_id >= RTE_MAX_MEMSEG) {
+		RTE_LOG(DEBUG, EAL, "%s(): not enough free memsegs\n",
+			__func__);
+		goto fail;
+	}
+
+	vma_len = len;
+	vma_addr = get_virtual_area(&vma_len, page_sz);
+	if (vma_addr == NULL || vma_len != len)
+		goto fail;
+
+	/* remap the pages in physical order, under their final file name */
+	for (i = 0; i < n_pages; i++) {
+		void *addr = RTE_PTR_ADD(vma_addr, i * page_sz);
+
+		eal_get_dyn_hugefile_path(tmp_path, sizeof(tmp_path),
+			mcfg->dynmem_dir, id, n_pages + pages[i].file_id);
+		eal_get_dyn_hugefile_path(path, sizeof(path),
+			mcfg->dynmem_dir, id, i);
+		if (rename(tmp_path, path) < 0 ||
+				dynmem_map_page(path, addr, page_sz, 0) == NULL)
+			goto fail;
+
+		munmap(pages[i].addr, page_sz);
+		pages[i].addr = addr;
+		if (rte_eal_iova_mode() == RTE_IOVA_VA)
+			pages[i].physaddr = (uintptr_t)addr;
+	}
+
+	pthread_mutex_lock(&dynmem_local_lock);
+	rte_spinlock_lock(&mcfg->dynmem_lock);
+
+	/* fill the new memsegs, their length is set last as the other
+	 * processes scan the memsegs until the first empty one */
+	mcfg->dynmem_id[first] = id;
+	for (i = 0, ms_id = first - 1; i < n_pages; i++) {
+		if (i == 0 ||
+			pages[i].physaddr != pages[i - 1].physaddr + page_sz) {
+			if (i != 0) {
+				rte_wmb();
+				ms->len = (size_t)i * page_sz -
+					RTE_PTR_DIFF(ms->addr, vma_addr);
+			}
+			ms = &mcfg->memseg[++ms_id];
+			ms->phys_addr = pages[i].physaddr;
+			ms->addr = pages[i].addr;
+			ms->hugepage_sz = page_sz;
+			ms->socket_id = socket_id;
+			mcfg->dynmem_map[ms_id] = first;
+		}
+	}
+	rte_wmb();
+	ms->len = len - RTE_PTR_DIFF(ms->addr, vma_addr);
+	rte_wmb();
+	mcfg->dynmem_gen = id;
+
+	rte_spinlock_unlock(&mcfg->dynmem_lock);
+
+	*n_memseg = ms_id - first + 1;
+	dynmem_local[first].id = id;
+	dynmem_local[first].addr = vma_addr;
+	dynmem_local[first].len = len;
+	dynmem_local[first].n_memseg = *n_memseg;
+	memcpy(&dynmem_local_ms[first], &mcfg->memseg[first],
+		*n_memseg * sizeof(mcfg->memseg[0]));
+	dynmem_local_gen = id;
+	dynmem_notify(RTE_MEM_EVENT_ALLOC, &first, 1);
+	dynmem_proc_ack(mcfg);
+
+	pthread_mutex_unlock(&dynmem_local_lock);
+
+	/* the memory cannot be handed out before all processes map it */
+	if (dynmem_procs_wait(mcfg, id) < 0) {
+		dynmem_release(mcfg, first);
+		goto out;
+	}
+
+	RTE_LOG(DEBUG, EAL, "Added %zu MB on socket %d in memsegs %u-%u\n",
+		len >> 20, socket_id, first, ms_id);
+
+	ret = first;
+	goto out;
+
+fail:
+	for (i = 0; i < n_mapped; i++) {
+		munmap(pages[i].addr, page_sz);
+		eal_get_dyn_hugefile_path(path, sizeof(path),
+			mcfg->dynmem_dir, id, i);
+		unlink(path);
+		eal_get_dyn_hugefile_path(path, sizeof(path),
+			mcfg->dynmem_dir, id, n_pages + i);
+		unlink(path);
+	}
+out:
+	rte_spinlock_unlock(&mcfg->dynmem_grow_lock);
+	free(pages);
+	return ret;
+}
+
+int
+eal_memory_shrink(unsigned memseg_id)
+{
+	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
+	unsigned i;
+	int ret = -1;
+
+	rte_spinlock_lock(&mcfg->dynmem_grow_lock);
+	eal_memory_sync();
+
+	if (memseg_id < mcfg->dynmem_first || memseg_id >= RTE_MAX_MEMSEG ||
+			mcfg->memseg[memseg_id].len == 0 ||
+			mcfg->dynmem_map[memseg_id] != memseg_id ||
+			dynmem_local[memseg_id].id != mcfg->dynmem_id[memseg_id])
+		goto out;
+
+	/* only the last mapping can be released */
+	for (i = memseg_id; i < RTE_MAX_MEMSEG && mcfg->memseg[i].len > 0;
+			i++) {
+		if (mcfg->dynmem_map[i] != memseg_id)
+			goto out;
+	}
+
+	dynmem_release(mcfg, memseg_id);
+	ret = 0;
+out:
+	rte_spinlock_unlock(&mcfg->dynmem_grow_lock);
+	return ret;
+}
@@ -89,6 +89,15 @@ rte_eal_pci_map_device(struct rte_pci_device *dev)
 {
 	int ret = -1;
 
+	/* uio devices do DMA with physical addresses */
+	if (rte_eal_iova_mode() == RTE_IOVA_VA &&
+			(dev->kdrv == RTE_KDRV_IGB_UIO ||
+			dev->kdrv == RTE_KDRV_UIO_GENERIC)) {
+		RTE_LOG(ERR, EAL, "  Device bound to uio cannot be used "
+			"in IOVA VA mode\n");
+		return -1;
+	}
+
 	/* try mapping the NIC resources using VFIO if it exists */
 	switch (dev->kdrv) {
 	case RTE_KDRV_VFIO:
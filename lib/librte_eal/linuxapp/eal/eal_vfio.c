@@ -51,6 +51,8 @@ static struct vfio_config vfio_cfg;
 
 static int vfio_type1_dma_map(int);
 static int vfio_noiommu_dma_map(int);
+static int vfio_type1_dma_mem_map(int vfio_container_fd,
+		const struct rte_memseg *ms, int do_map);
 
 /* IOMMU types we support */
 static const struct vfio_iommu_type iommu_types[] = {
@@ -266,6 +268,7 @@ int vfio_setup_device(const char *sysfs_base, const char *dev_addr,
 					"error %i (%s)\n", dev_addr, errno, strerror(errno));
 			return -1;
 		}
+		vfio_cfg.vfio_iommu_type = t->type_id;
 		vfio_cfg.vfio_container_has_dma = 1;
 	}
 
@@ -292,6 +295,32 @@ int vfio_setup_device(const char *sysfs_base, const char *dev_addr,
 	return 0;
 }
 
+/*
+ * Map the memory added after init for DMA, and unmap the memory released.
+ * The mappings of the container are set up by the primary process only,
+ * which maps the memory added by all processes before it is handed out.
+ */
+static void
+vfio_mem_event_callback(enum rte_mem_event event,
+		const struct rte_memseg *ms, unsigned int n_memseg,
+		void *arg __rte_unused)
+{
+	unsigned int i;
+
+	/* the whole memory is mapped when the first device is set up */
+	if (vfio_cfg.vfio_container_has_dma == 0 ||
+			vfio_cfg.vfio_iommu_type != RTE_VFIO_TYPE1)
+		return;
+
+	for (i = 0; i < n_memseg; i++) {
+		if (vfio_type1_dma_mem_map(vfio_cfg.vfio_container_fd, &ms[i],
+				event == RTE_MEM_EVENT_ALLOC) < 0)
+			RTE_LOG(ERR, EAL, "  cannot %s DMA mapping of [%p]\n",
+				event == RTE_MEM_EVENT_ALLOC ?
+					"set up" : "remove", ms[i].addr);
+	}
+}
+
 int
 vfio_enable(const char *modname)
 {
@@ -329,6 +358,9 @@ vfio_enable(const char *modname)
 	if (vfio_cfg.vfio_container_fd != -1) {
 		RTE_LOG(NOTICE, EAL, "VFIO support initialized\n");
 		vfio_cfg.vfio_enabled = 1;
+		if (internal_config.process_type == RTE_PROC_PRIMARY)
+			rte_mem_event_callback_register(vfio_mem_event_callback,
+				NULL);
 	} else {
 		RTE_LOG(NOTICE, EAL, "VFIO support could not be initialized\n");
 	}
@@ -343,6 +375,21 @@ vfio_is_enabled(const char *modname)
 	return vfio_cfg.vfio_enabled && mod_available;
 }
 
+int
+vfio_noiommu_is_enabled(void)
+{
+	char c;
+	int fd, ret;
+
+	fd = open(VFIO_NOIOMMU_MODE, O_RDONLY);
+	if (fd < 0)
+		return 0;
+	ret = read(fd, &c, 1);
+	close(fd);
+
+	return ret == 1 && c == 'Y';
+}
+
 const struct vfio_iommu_type *
 vfio_set_iommu_type(int vfio_container_fd)
 {
@@ -508,32 +555,55 @@ vfio_get_group_no(const char *sysfs_base,
 }
 
 static int
-vfio_type1_dma_map(int vfio_container_fd)
+vfio_type1_dma_mem_map(int vfio_container_fd, const struct rte_memseg *ms,
+		int do_map)
 {
-	const struct rte_memseg *ms = rte_eal_get_physmem_layout();
-	int i, ret;
-
-	/* map all DPDK segments for DMA. use 1:1 PA to IOVA mapping */
-	for (i = 0; i < RTE_MAX_MEMSEG; i++) {
-		struct vfio_iommu_type1_dma_map dma_map;
-
-		if (ms[i].addr == NULL)
-			break;
+	struct vfio_iommu_type1_dma_unmap dma_unmap;
+	struct vfio_iommu_type1_dma_map dma_map;
+	int ret;
 
+	/* use 1:1 PA to IOVA mapping */
+	if (do_map) {
 		memset(&dma_map, 0, sizeof(dma_map));
 		dma_map.argsz = sizeof(struct vfio_iommu_type1_dma_map);
-		dma_map.vaddr = ms[i].addr_64;
-		dma_map.size = ms[i].len;
-		dma_map.iova = ms[i].phys_addr;
+		dma_map.vaddr = ms->addr_64;
+		dma_map.size = ms->len;
+		dma_map.iova = ms->phys_addr;
 		dma_map.flags = VFIO_DMA_MAP_FLAG_READ | VFIO_DMA_MAP_FLAG_WRITE;
 
 		ret = ioctl(vfio_container_fd, VFIO_IOMMU_MAP_DMA, &dma_map);
+	} else {
+		memset(&dma_unmap, 0, sizeof(dma_unmap));
+		dma_unmap.argsz = sizeof(struct vfio_iommu_type1_dma_unmap);
+		dma_unmap.size = ms->len;
+		dma_unmap.iova = ms->phys_addr;
 
-		if (ret) {
-			RTE_LOG(ERR, EAL, "  cannot set up DMA remapping, "
-					"error %i (%s)\n", errno, strerror(errno));
+		ret = ioctl(vfio_container_fd, VFIO_IOMMU_UNMAP_DMA,
+			&dma_unmap);
+	}
+
+	if (ret) {
+		RTE_LOG(ERR, EAL, "  cannot set up DMA remapping, "
+				"error %i (%s)\n", errno, strerror(errno));
+		return -1;
+	}
+
+	return 0;
+}
+
+static int
+vfio_type1_dma_map(int vfio_container_fd)
+{
+	const struct rte_memseg *ms = rte_eal_get_physmem_layout();
+	int i;
+
+	/* map all DPDK segments for DMA */
+	for (i = 0; i < RTE_MAX_MEMSEG; i++) {
+		if (ms[i].addr == NULL)
+			break;
+
+		if (vfio_type1_dma_mem_map(vfio_container_fd, &ms[i], 1) < 0)
 			return -1;
-		}
 	}
 
 	return 0;
@@ -84,6 +84,7 @@ struct vfio_config {
 	int vfio_enabled;
 	int vfio_container_fd;
 	int vfio_container_has_dma;
+	int vfio_iommu_type; /* type_id of the IOMMU type set up */
 	int vfio_group_idx;
 	struct vfio_group vfio_groups[VFIO_MAX_GROUPS];
 };
@@ -92,6 +93,8 @@ struct vfio_config {
 #define VFIO_CONTAINER_PATH "/dev/vfio/vfio"
 #define VFIO_GROUP_FMT "/dev/vfio/%u"
 #define VFIO_NOIOMMU_GROUP_FMT "/dev/vfio/noiommu-%u"
+#define VFIO_NOIOMMU_MODE \
+	"/sys/module/vfio/parameters/enable_unsafe_noiommu_mode"
 #define VFIO_GET_REGION_ADDR(x) ((uint64_t) x << 40ULL)
 #define VFIO_GET_REGION_IDX(x) (x >> 40)
 
@@ -143,6 +146,9 @@ int vfio_setup_device(const char *sysfs_base, const char *dev_addr,
 int vfio_enable(const char *modname);
 int vfio_is_enabled(const char *modname);
 
+/* returns 1 if the vfio module allows the unsafe no-IOMMU mode */
+int vfio_noiommu_is_enabled(void);
+
 int pci_vfio_enable(void);
 int pci_vfio_is_enabled(void);
 
@@ -42,10 +42,14 @@
 #include <stdint.h>
 #include <inttypes.h>
 #include <netinet/in.h>
+#ifdef RTE_EXEC_ENV_LINUXAPP
+#include <sys/epoll.h>
+#endif
 
 #include <rte_byteorder.h>
 #include <rte_log.h>
 #include <rte_debug.h>
+#include <rte_cycles.h>
 #include <rte_interrupts.h>
 #include <rte_pci.h>
 #include <rte_memory.h>
@@ -74,6 +78,11 @@ static struct rte_eth_dev_data *rte_eth_dev_data;
 static uint8_t eth_dev_last_created_port;
 static uint8_t nb_ports;
 
+RTE_TRACE_POINT_DEFINE(rte_eth_trace_rx_burst, "lib.ethdev.rx_burst",
+	"port_id", "queue_id", "nb_rx")
+RTE_TRACE_POINT_DEFINE(rte_eth_trace_tx_burst, "lib.ethdev.tx_burst",
+	"port_id", "queue_id", "nb_tx")
+
 /* spinlock for eth device callbacks */
 static rte_spinlock_t rte_eth_dev_cb_lock = RTE_SPINLOCK_INITIALIZER;
 
@@ -2647,6 +2656,350 @@ rte_eth_dev_rx_intr_disable(uint8_t port_id,
 	return (*dev->dev_ops->rx_queue_intr_disable)(dev, queue_id);
 }
 
+#ifdef RTE_EXEC_ENV_LINUXAPP
+
+/* Interrupt-mode RX: maximum number of queues waited for by an lcore. */
+#define RX_WAIT_QUEUE_MAX 64
+/* Bounds of the number of empty polls before sleeping. */
+#define RX_WAIT_POLLS_MIN 16U
+#define RX_WAIT_POLLS_MAX 4096U
+/* A sleep ended by packets before this delay was premature. */
+#define RX_WAIT_SHORT_SLEEP_US 100
+
+struct rx_wait_queue {
+	uint8_t used;
+	uint8_t has_fd; /**< Woken up by the driver fd, else by the vector. */
+	volatile uint8_t fd_changed; /**< The driver fd must be fetched again. */
+	uint8_t port_id;
+	uint16_t queue_id;
+	/** Epoll event of the driver fd, must not move while registered. */
+	struct rte_epoll_event ev;
+};
+
+struct rx_wait_lcore {
+	uint16_t nb_queues; /**< Highest used slot + 1. */
+	uint32_t idle_polls; /**< Current number of empty polls. */
+	uint32_t polls_max; /**< Number of empty polls before sleeping. */
+	uint64_t last_tsc; /**< TSC of the previous rte_eth_rx_wait(). */
+	struct rte_eth_rx_wait_stats stats;
+	struct rx_wait_queue queues[RX_WAIT_QUEUE_MAX];
+};
+
+static struct rx_wait_lcore *rx_wait_lcores[RTE_MAX_LCORE];
+
+int
+rte_eth_rx_wait_queue_add(uint8_t port_id, uint16_t queue_id)
+{
+	unsigned int lcore_id = rte_lcore_id();
+	struct rte_eth_dev *dev;
+	struct rx_wait_lcore *w;
+	struct rx_wait_queue *q;
+	int fd = -ENOTSUP;
+	int slot = -1;
+	int ret;
+	uint16_t i;
+
+	RTE_ETH_VALID_PORTID_OR_ERR_RET(port_id, -ENODEV);
+
+	dev = &rte_eth_devices[port_id];
+	if (queue_id >= dev->data->nb_rx_queues) {
+		RTE_PMD_DEBUG_TRACE("Invalid RX queue_id=%u\n", queue_id);
+		return -EINVAL;
+	}
+	if (lcore_id >= RTE_MAX_LCORE)
+		return -EINVAL;
+
+	w = rx_wait_lcores[lcore_id];
+	if (w == NULL) {
+		w = rte_zmalloc_socket("RX_WAIT", sizeof(*w),
+				RTE_CACHE_LINE_SIZE,
+				rte_lcore_to_socket_id(lcore_id));
+		if (w == NULL)
+			return -ENOMEM;
+		w->polls_max = RX_WAIT_POLLS_MIN;
+		rx_wait_lcores[lcore_id] = w;
+	}
+
+	for (i = 0; i < w->nb_queues; i++) {
+		q = &w->queues[i];
+		if (!q->used) {
+			if (slot < 0)
+				slot = i;
+		} else if (q->port_id == port_id && q->queue_id == queue_id)
+			return -EEXIST;
+	}
+	if (slot < 0) {
+		if (w->nb_queues == RX_WAIT_QUEUE_MAX)
+			return -ENOSPC;
+		slot = w->nb_queues;
+	}
+	q = &w->queues[slot];
+	memset(q, 0, sizeof(*q));
+
+	if (dev->dev_ops->rx_queue_fd_get != NULL)
+		fd = (*dev->dev_ops->rx_queue_fd_get)(dev, queue_id);
+	if (fd >= 0) {
+		/*
+		 * Edge triggered: each packet queued on a socket, or write to
+		 * an eventfd, signals the fd again whether it was read or
+		 * not, so the fd does not have to be drained.
+		 */
+		q->ev.epdata.event = EPOLLIN | EPOLLET;
+		if (rte_epoll_ctl(RTE_EPOLL_PER_THREAD, EPOLL_CTL_ADD,
+				  fd, &q->ev) < 0)
+			return -EIO;
+		q->has_fd = 1;
+	} else {
+		ret = rte_eth_dev_rx_intr_ctl_q(port_id, queue_id,
+				RTE_EPOLL_PER_THREAD, RTE_INTR_EVENT_ADD, NULL);
+		if (ret < 0)
+			return ret;
+	}
+
+	q->port_id = port_id;
+	q->queue_id = queue_id;
+	q->used = 1;
+	if (slot == w->nb_queues)
+		w->nb_queues++;
+	return 0;
+}
+
+int
+rte_eth_rx_wait_queue_del(uint8_t port_id, uint16_t queue_id)
+{
+	unsigned int lcore_id = rte_lcore_id();
+	struct rx_wait_lcore *w;
+	struct rx_wait_queue *q;
+	uint16_t i;
+
+	if (lcore_id >= RTE_MAX_LCORE || rx_wait_lcores[lcore_id] == NULL)
+		return -ENOENT;
+	w = rx_wait_lcores[lcore_id];
+
+	for (i = 0; i < w->nb_queues; i++) {
+		q = &w->queues[i];
+		if (q->used && q->port_id == port_id &&
+		    q->queue_id == queue_id)
+			break;
+	}
+	if (i == w->nb_queues)
+		return -ENOENT;
+
+	if (q->has_fd) {
+		if (q->ev.status != RTE_EPOLL_INVALID)
+			rte_epoll_ctl(RTE_EPOLL_PER_THREAD, EPOLL_CTL_DEL,
+				      q->ev.fd, &q->ev);
+	} else
+		rte_eth_dev_rx_intr_ctl_q(port_id, queue_id,
+				RTE_EPOLL_PER_THREAD, RTE_INTR_EVENT_DEL, NULL);
+	q->used = 0;
+
+	while (w->nb_queues > 0 && !w->queues[w->nb_queues - 1].used)
+		w->nb_queues--;
+	return 0;
+}
+
+/*
+ * Replace the driver fd of a queue in the epoll set of the lcore. The old
+ * fd may be closed already, which removed it from the set.
+ */
+static void
+rx_wait_fd_update(struct rx_wait_queue *q)
+{
+	struct rte_eth_dev *dev = &rte_eth_devices[q->port_id];
+	int fd;
+
+	q->fd_changed = 0;
+	rte_smp_mb();
+	if (q->ev.status != RTE_EPOLL_INVALID) {
+		epoll_ctl(rte_intr_tls_epfd(), EPOLL_CTL_DEL, q->ev.fd, NULL);
+		q->ev.status = RTE_EPOLL_INVALID;
+	}
+
+	fd = (*dev->dev_ops->rx_queue_fd_get)(dev, q->queue_id);
+	if (fd < 0)
+		return; /* no fd until the driver changes it again */
+	q->ev.epdata.event = EPOLLIN | EPOLLET;
+	if (rte_epoll_ctl(RTE_EPOLL_PER_THREAD, EPOLL_CTL_ADD, fd, &q->ev) < 0)
+		q->fd_changed = 1;
+}
+
+/*
+ * Arm the interrupts of the queues, then check them once more: a packet
+ * received after the last poll would not raise an interrupt.
+ * Return 1 if a queue has packets pending, with the interrupts disarmed.
+ */
+static int
+rx_wait_arm(struct rx_wait_lcore *w)
+{
+	struct rx_wait_queue *q;
+	uint16_t i;
+
+	for (i = 0; i < w->nb_queues; i++) {
+		q = &w->queues[i];
+		if (q->used && q->has_fd && q->fd_changed)
+			rx_wait_fd_update(q);
+		if (q->used)
+			rte_eth_dev_rx_intr_enable(q->port_id, q->queue_id);
+	}
+	for (i = 0; i < w->nb_queues; i++) {
+		q = &w->queues[i];
+		if (q->used &&
+		    rte_eth_rx_queue_count(q->port_id, q->queue_id) > 0)
+			return 1;
+	}
+	return 0;
+}
+
+static void
+rx_wait_disarm(struct rx_wait_lcore *w)
+{
+	struct rx_wait_queue *q;
+	uint16_t i;
+
+	for (i = 0; i < w->nb_queues; i++) {
+		q = &w->queues[i];
+		if (q->used)
+			rte_eth_dev_rx_intr_disable(q->port_id, q->queue_id);
+	}
+}
+
+int
+rte_eth_rx_wait(uint32_t nb_rx, int timeout)
+{
+	struct rte_epoll_event events[RX_WAIT_QUEUE_MAX];
+	unsigned int lcore_id = rte_lcore_id();
+	struct rx_wait_lcore *w;
+	uint64_t now, end;
+	int n;
+
+	if (lcore_id >= RTE_MAX_LCORE || rx_wait_lcores[lcore_id] == NULL)
+		return 0;
+	w = rx_wait_lcores[lcore_id];
+
+	now = rte_rdtsc();
+	if (w->last_tsc != 0) {
+		if (nb_rx != 0)
+			w->stats.busy_cycles += now - w->last_tsc;
+		else
+			w->stats.idle_cycles += now - w->last_tsc;
+	}
+	w->last_tsc = now;
+
+	if (nb_rx != 0) {
+		w->idle_polls = 0;
+		return 0;
+	}
+	if (++w->idle_polls < w->polls_max || w->nb_queues == 0)
+		return 0;
+	w->idle_polls = 0;
+
+	if (rx_wait_arm(w)) {
+		rx_wait_disarm(w);
+		/* the traffic is not idle, poll longer */
+		w->polls_max = RTE_MIN(w->polls_max * 2, RX_WAIT_POLLS_MAX);
+		return 0;
+	}
+
+	w->stats.sleeps++;
+	n = rte_epoll_wait(RTE_EPOLL_PER_THREAD, events,
+			   RX_WAIT_QUEUE_MAX, timeout);
+	rx_wait_disarm(w);
+
+	end = rte_rdtsc();
+	w->stats.sleep_cycles += end - now;
+	w->last_tsc = end;
+
+	if (n > 0) {
+		w->stats.wakeups++;
+		if (end - now < rte_get_tsc_hz() / 1000000 *
+				RX_WAIT_SHORT_SLEEP_US) {
+			w->polls_max = RTE_MIN(w->polls_max * 2,
+					       RX_WAIT_POLLS_MAX);
+			return n;
+		}
+	} else
+		n = 0;
+	w->polls_max = RTE_MAX(w->polls_max / 2, RX_WAIT_POLLS_MIN);
+	return n;
+}
+
+void
+_rte_eth_rx_wait_fd_changed(uint8_t port_id, uint16_t queue_id)
+{
+	struct rx_wait_lcore *w;
+	struct rx_wait_queue *q;
+	unsigned int lcore_id;
+	uint16_t i;
+
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		w = rx_wait_lcores[lcore_id];
+		if (w == NULL)
+			continue;
+		for (i = 0; i < w->nb_queues; i++) {
+			q = &w->queues[i];
+			if (q->used && q->has_fd && q->port_id == port_id &&
+			    q->queue_id == queue_id)
+				q->fd_changed = 1;
+		}
+	}
+}
+
+int
+rte_eth_rx_wait_stats_get(unsigned int lcore_id,
+			  struct rte_eth_rx_wait_stats *stats)
+{
+	if (lcore_id >= RTE_MAX_LCORE || stats == NULL)
+		return -EINVAL;
+
+	if (rx_wait_lcores[lcore_id] == NULL)
+		memset(stats, 0, sizeof(*stats));
+	else
+		*stats = rx_wait_lcores[lcore_id]->stats;
+	return 0;
+}
+
+#else /* RTE_EXEC_ENV_LINUXAPP */
+
+int
+rte_eth_rx_wait_queue_add(uint8_t port_id __rte_unused,
+			  uint16_t queue_id __rte_unused)
+{
+	return -ENOTSUP;
+}
+
+int
+rte_eth_rx_wait_queue_del(uint8_t port_id __rte_unused,
+			  uint16_t queue_id __rte_unused)
+{
+	return -ENOENT;
+}
+
+int
+rte_eth_rx_wait(uint32_t nb_rx __rte_unused, int timeout __rte_unused)
+{
+	return -ENOTSUP;
+}
+
+void
+_rte_eth_rx_wait_fd_changed(uint8_t port_id __rte_unused,
+			    uint16_t queue_id __rte_unused)
+{
+}
+
+int
+rte_eth_rx_wait_stats_get(unsigned int lcore_id,
+			  struct rte_eth_rx_wait_stats *stats)
+{
+	if (lcore_id >= RTE_MAX_LCORE || stats == NULL)
+		return -EINVAL;
+
+	memset(stats, 0, sizeof(*stats));
+	return 0;
+}
+
+#endif /* RTE_EXEC_ENV_LINUXAPP */
+
 #ifdef RTE_NIC_BYPASS
 int rte_eth_dev_bypass_init(uint8_t port_id)
 {
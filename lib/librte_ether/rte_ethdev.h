@@ -183,12 +183,18 @@ extern "C" {
 #include <rte_dev.h>
 #include <rte_devargs.h>
 #include <rte_errno.h>
+#include <rte_trace.h>
 #include "rte_ether.h"
 #include "rte_eth_ctrl.h"
 #include "rte_dev_info.h"
 
 struct rte_mbuf;
 
+/** Tracepoint "lib.ethdev.rx_burst" of the packets received on a queue. */
+extern struct rte_trace_point rte_eth_trace_rx_burst;
+/** Tracepoint "lib.ethdev.tx_burst" of the packets sent on a queue. */
+extern struct rte_trace_point rte_eth_trace_tx_burst;
+
 /**
  * A structure used to retrieve statistics for an Ethernet port.
  * Not all statistics fields in struct rte_eth_stats are supported
@@ -1169,6 +1175,10 @@ typedef int (*eth_rx_disable_intr_t)(struct rte_eth_dev *dev,
 				    uint16_t rx_queue_id);
 /**< @internal Disable interrupt of a receive queue of an Ethernet device. */
 
+typedef int (*eth_rx_queue_fd_get_t)(struct rte_eth_dev *dev,
+				     uint16_t rx_queue_id);
+/**< @internal Get the file descriptor signalling packets on a receive queue. */
+
 typedef void (*eth_queue_release_t)(void *queue);
 /**< @internal Release memory resources allocated by given RX/TX queue. */
 
@@ -1485,6 +1495,7 @@ struct eth_dev_ops {
 	eth_rx_descriptor_done_t   rx_descriptor_done; /**< Check rxd DD bit. */
 	eth_rx_enable_intr_t       rx_queue_intr_enable;  /**< Enable Rx queue interrupt. */
 	eth_rx_disable_intr_t      rx_queue_intr_disable; /**< Disable Rx queue interrupt. */
+	eth_rx_queue_fd_get_t      rx_queue_fd_get; /**< Get Rx queue event fd. */
 	eth_tx_queue_setup_t       tx_queue_setup;/**< Set up device TX queue. */
 	eth_queue_release_t        tx_queue_release; /**< Release TX queue. */
 
@@ -2719,6 +2730,7 @@ rte_eth_rx_burst(uint8_t port_id, uint16_t queue_id,
 	}
 #endif
 
+	rte_trace_point_emit(rte_eth_trace_rx_burst, port_id, queue_id, nb_rx);
 	return nb_rx;
 }
 
@@ -2855,7 +2867,11 @@ rte_eth_tx_burst(uint8_t port_id, uint16_t queue_id,
 	}
 #endif
 
-	return (*dev->tx_pkt_burst)(dev->data->tx_queues[queue_id], tx_pkts, nb_pkts);
+	nb_pkts = (*dev->tx_pkt_burst)(dev->data->tx_queues[queue_id],
+			tx_pkts, nb_pkts);
+	rte_trace_point_emit(rte_eth_trace_tx_burst, port_id, queue_id,
+			nb_pkts);
+	return nb_pkts;
 }
 
 /**
@@ -3344,6 +3360,103 @@ int rte_eth_dev_rx_intr_ctl(uint8_t port_id, int epfd, int op, void *data);
 int rte_eth_dev_rx_intr_ctl_q(uint8_t port_id, uint16_t queue_id,
 			      int epfd, int op, void *data);
 
+/**
+ * Statistics of the interrupt-mode RX of an lcore, see rte_eth_rx_wait().
+ */
+struct rte_eth_rx_wait_stats {
+	uint64_t busy_cycles;  /**< Cycles between polls returning packets. */
+	uint64_t idle_cycles;  /**< Cycles between empty polls, not sleeping. */
+	uint64_t sleep_cycles; /**< Cycles spent sleeping. */
+	uint64_t sleeps;       /**< Number of sleeps. */
+	uint64_t wakeups;      /**< Sleeps ended by a queue event. */
+};
+
+/**
+ * Add a receive queue to the queues the calling lcore waits for in
+ * rte_eth_rx_wait(). It must be called by the lcore polling the queue.
+ *
+ * The queue is woken up by the file descriptor of the driver if it has
+ * one (tap, af_packet, virtio-user, vhost), or else by its RX interrupt
+ * vector, see rte_eth_dev_rx_intr_ctl_q().
+ *
+ * @param port_id
+ *   The port identifier of the Ethernet device.
+ * @param queue_id
+ *   The index of the receive queue.
+ * @return
+ *   - (0) if successful.
+ *   - (-ENOTSUP) if the queue can not wake up an lcore.
+ *   - (-ENODEV) if *port_id* invalid.
+ *   - (-EINVAL) if *queue_id* invalid, or not called by an EAL thread.
+ *   - (-EEXIST) if the queue is already added.
+ *   - (-ENOSPC) if the lcore waits for too many queues.
+ *   - (-ENOMEM) if the lcore state can not be allocated.
+ */
+int rte_eth_rx_wait_queue_add(uint8_t port_id, uint16_t queue_id);
+
+/**
+ * Remove a receive queue from the queues the calling lcore waits for.
+ *
+ * @param port_id
+ *   The port identifier of the Ethernet device.
+ * @param queue_id
+ *   The index of the receive queue.
+ * @return
+ *   - (0) if successful.
+ *   - (-ENOENT) if the queue was not added by the calling lcore.
+ */
+int rte_eth_rx_wait_queue_del(uint8_t port_id, uint16_t queue_id);
+
+/**
+ * Report the result of an RX poll of the calling lcore, and sleep until a
+ * queue event if the queues added with rte_eth_rx_wait_queue_add() stay
+ * empty for too long.
+ *
+ * It is called once per iteration of the polling loop. The number of
+ * empty polls before a sleep adapts to the traffic: it grows when short
+ * sleeps are ended by packets, and shrinks otherwise. Before sleeping,
+ * the interrupts of the queues are armed and the queues are checked once
+ * more, so a packet received in between is not missed. All the queues of
+ * the lcore are waited for with a single epoll call.
+ *
+ * @param nb_rx
+ *   The number of packets received by the iteration on all the queues.
+ * @param timeout
+ *   The maximum sleep in milliseconds, or -1 to wait for a queue event.
+ * @return
+ *   - (0) if the lcore did not sleep, or slept until the timeout.
+ *   - (>0) the number of queue events which woke the lcore up.
+ *   - (-ENOTSUP) if not supported by the environment.
+ */
+int rte_eth_rx_wait(uint32_t nb_rx, int timeout);
+
+/**
+ * Get the interrupt-mode RX statistics of an lcore.
+ *
+ * @param lcore_id
+ *   The lcore identifier.
+ * @param stats
+ *   Filled with the statistics.
+ * @return
+ *   - (0) if successful.
+ *   - (-EINVAL) if *lcore_id* is invalid or *stats* is NULL.
+ */
+int rte_eth_rx_wait_stats_get(unsigned int lcore_id,
+			      struct rte_eth_rx_wait_stats *stats);
+
+/**
+ * @internal Tell the lcores waiting for a receive queue that the fd given
+ * by the rx_queue_fd_get driver operation changed, for instance because
+ * the device was reconnected. The lcores fetch it again before their next
+ * sleep. It is for use by the drivers only.
+ *
+ * @param port_id
+ *   The port identifier of the Ethernet device.
+ * @param queue_id
+ *   The index of the receive queue.
+ */
+void _rte_eth_rx_wait_fd_changed(uint8_t port_id, uint16_t queue_id);
+
 /**
  * Turn on the LED on the Ethernet device.
  * This function turns on the LED on the Ethernet device.
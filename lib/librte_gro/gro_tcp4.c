@@ -0,0 +1,406 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+
+#include <rte_mbuf.h>
+#include <rte_ip.h>
+#include <rte_tcp.h>
+#include <rte_udp.h>
+#include <rte_jhash.h>
+
+#include "rte_gro.h"
+#include "gro_tcp4.h"
+
+#define TCP_PSH_FLAG 0x08
+
+void
+gro_tcp4_tbl_init(struct gro_tcp4_tbl *tbl,
+	struct gro_tcp4_item *items, uint32_t max_item_num,
+	struct gro_tcp4_flow *flows, uint32_t max_flow_num,
+	uint32_t *buckets, uint32_t nb_buckets, uint32_t max_item_per_flow)
+{
+	uint32_t i;
+
+	tbl->items = items;
+	tbl->flows = flows;
+	tbl->buckets = buckets;
+	tbl->bucket_mask = nb_buckets - 1;
+	tbl->max_item_num = max_item_num;
+	tbl->max_flow_num = max_flow_num;
+	tbl->max_item_per_flow = max_item_per_flow;
+	tbl->item_num = 0;
+	tbl->flow_num = 0;
+	tbl->free_item = GRO_INVALID_INDEX;
+	tbl->free_flow = GRO_INVALID_INDEX;
+	tbl->item_hw = 0;
+	tbl->flow_hw = 0;
+
+	for (i = 0; i < nb_buckets; i++)
+		buckets[i] = GRO_INVALID_INDEX;
+}
+
+static inline uint32_t
+item_alloc(struct gro_tcp4_tbl *tbl)
+{
+	uint32_t i = tbl->free_item;
+
+	if (i != GRO_INVALID_INDEX)
+		tbl->free_item = tbl->items[i].next;
+	else if (tbl->item_hw < tbl->max_item_num)
+		i = tbl->item_hw++;
+	else
+		return GRO_INVALID_INDEX;
+	tbl->item_num++;
+	return i;
+}
+
+static inline void
+item_free(struct gro_tcp4_tbl *tbl, uint32_t i)
+{
+	tbl->items[i].firstseg = NULL;
+	tbl->items[i].next = tbl->free_item;
+	tbl->free_item = i;
+	tbl->item_num--;
+}
+
+static inline uint32_t
+flow_alloc(struct gro_tcp4_tbl *tbl)
+{
+	uint32_t i = tbl->free_flow;
+
+	if (i != GRO_INVALID_INDEX)
+		tbl->free_flow = tbl->flows[i].next;
+	else if (tbl->flow_hw < tbl->max_flow_num)
+		i = tbl->flow_hw++;
+	else
+		return GRO_INVALID_INDEX;
+	tbl->flow_num++;
+	return i;
+}
+
+/* Unlink an empty flow from its bucket and free it */
+static void
+flow_free(struct gro_tcp4_tbl *tbl, uint32_t i)
+{
+	struct gro_tcp4_flow *flow = &tbl->flows[i];
+	uint32_t *prev = &tbl->buckets[flow->hash & tbl->bucket_mask];
+
+	while (*prev != i)
+		prev = &tbl->flows[*prev].next;
+	*prev = flow->next;
+
+	flow->start_index = GRO_INVALID_INDEX;
+	flow->next = tbl->free_flow;
+	tbl->free_flow = i;
+	tbl->flow_num--;
+}
+
+static inline int
+ip_id_follows(uint8_t is_atomic, uint16_t ip_id, uint16_t next_id)
+{
+	return is_atomic || next_id == ip_id;
+}
+
+static inline int
+outer_ip_id_follows(const struct gro_tcp4_item *item, uint16_t ip_id,
+	uint16_t next_id)
+{
+	return item->outer_ip_off == 0 ||
+		ip_id_follows(item->outer_is_atomic, ip_id, next_id);
+}
+
+/*
+ * Check whether a segment can be appended (1) or prepended (-1) to a held
+ * packet of the same flow, or not merged with it (0).
+ */
+static int
+check_neighbor(const struct gro_tcp4_item *item, struct rte_mbuf *pkt,
+	const struct gro_tcp4_seg *seg)
+{
+	uint16_t opt_len;
+	int cmp;
+
+	if (item->hdr_len != seg->hdr_len || item->tcp_off != seg->tcp_off ||
+	    item->is_atomic != seg->is_atomic ||
+	    item->outer_is_atomic != seg->outer_is_atomic)
+		return 0;
+
+	if (item->sent_seq + item->payload_len == seg->sent_seq &&
+	    !(item->tcp_flags & TCP_PSH_FLAG) &&
+	    ip_id_follows(item->is_atomic,
+			  (uint16_t)(item->ip_id + item->nb_merged),
+			  seg->ip_id) &&
+	    outer_ip_id_follows(item,
+				(uint16_t)(item->outer_ip_id + item->nb_merged),
+				seg->outer_ip_id))
+		cmp = 1;
+	else if (seg->sent_seq + seg->payload_len == item->sent_seq &&
+		 !(seg->tcp_flags & TCP_PSH_FLAG) &&
+		 ip_id_follows(item->is_atomic, (uint16_t)(seg->ip_id + 1),
+			       item->ip_id) &&
+		 outer_ip_id_follows(item, (uint16_t)(seg->outer_ip_id + 1),
+				     item->outer_ip_id))
+		cmp = -1;
+	else
+		return 0;
+
+	/* the merged packet must fit in its outer IPv4 header */
+	if (seg->hdr_len - (seg->outer_ip_off ? seg->outer_ip_off :
+			    seg->ip_off) +
+	    item->payload_len + seg->payload_len > RTE_GRO_MAX_PKT_LEN ||
+	    item->firstseg->nb_segs + pkt->nb_segs > UINT8_MAX)
+		return 0;
+
+	/* and the segments must carry the same TCP options */
+	opt_len = seg->hdr_len - seg->tcp_off - sizeof(struct tcp_hdr);
+	if (opt_len != 0 &&
+	    memcmp(rte_pktmbuf_mtod_offset(item->firstseg, char *,
+					   seg->tcp_off + sizeof(struct tcp_hdr)),
+		   rte_pktmbuf_mtod_offset(pkt, char *,
+					   seg->tcp_off + sizeof(struct tcp_hdr)),
+		   opt_len) != 0)
+		return 0;
+
+	return cmp;
+}
+
+/* Chain tail, without its headers, after head */
+static inline void
+chain_pkts(struct rte_mbuf *head, struct rte_mbuf *head_last,
+	struct rte_mbuf *tail, uint16_t hdr_len)
+{
+	uint64_t l4_cksum;
+
+	/* the TCP checksum of the merged packet is not valid, but the data
+	 * is if the segments were checked */
+	l4_cksum = head->ol_flags & PKT_RX_L4_CKSUM_MASK;
+	if ((l4_cksum == PKT_RX_L4_CKSUM_GOOD ||
+	     l4_cksum == PKT_RX_L4_CKSUM_NONE) &&
+	    ((tail->ol_flags & PKT_RX_L4_CKSUM_MASK) == PKT_RX_L4_CKSUM_GOOD ||
+	     (tail->ol_flags & PKT_RX_L4_CKSUM_MASK) == PKT_RX_L4_CKSUM_NONE))
+		l4_cksum = PKT_RX_L4_CKSUM_NONE;
+	else
+		l4_cksum = PKT_RX_L4_CKSUM_UNKNOWN;
+	head->ol_flags = (head->ol_flags & ~PKT_RX_L4_CKSUM_MASK) | l4_cksum;
+
+	rte_pktmbuf_adj(tail, hdr_len);
+	head_last->next = tail;
+	head->nb_segs += tail->nb_segs;
+	head->pkt_len += tail->pkt_len;
+}
+
+static void
+merge_pkt(struct gro_tcp4_item *item, struct rte_mbuf *pkt,
+	const struct gro_tcp4_seg *seg, int cmp)
+{
+	if (cmp > 0) {
+		chain_pkts(item->firstseg, item->lastseg, pkt, seg->hdr_len);
+		item->lastseg = rte_pktmbuf_lastseg(pkt);
+	} else {
+		chain_pkts(pkt, rte_pktmbuf_lastseg(pkt), item->firstseg,
+			   seg->hdr_len);
+		item->firstseg = pkt;
+		item->sent_seq = seg->sent_seq;
+		item->ip_id = seg->ip_id;
+		item->outer_ip_id = seg->outer_ip_id;
+	}
+	item->payload_len += seg->payload_len;
+	item->tcp_flags |= seg->tcp_flags;
+	item->nb_merged++;
+}
+
+int
+gro_tcp4_reassemble(struct gro_tcp4_tbl *tbl, struct rte_mbuf *pkt,
+	const struct gro_tcp4_seg *seg, uint64_t start_time, uint16_t slot)
+{
+	struct gro_tcp4_item *item;
+	struct gro_tcp4_flow *flow = NULL;
+	uint32_t hash, f, i, last = GRO_INVALID_INDEX;
+	int cmp;
+
+	hash = rte_jhash(&seg->key, sizeof(seg->key), 0);
+	for (f = tbl->buckets[hash & tbl->bucket_mask];
+	     f != GRO_INVALID_INDEX; f = tbl->flows[f].next) {
+		if (tbl->flows[f].hash == hash &&
+		    memcmp(&tbl->flows[f].key, &seg->key,
+			   sizeof(seg->key)) == 0) {
+			flow = &tbl->flows[f];
+			break;
+		}
+	}
+
+	if (flow != NULL) {
+		for (i = flow->start_index; i != GRO_INVALID_INDEX;
+		     i = tbl->items[i].next) {
+			cmp = check_neighbor(&tbl->items[i], pkt, seg);
+			if (cmp != 0) {
+				merge_pkt(&tbl->items[i], pkt, seg, cmp);
+				return 1;
+			}
+			last = i;
+		}
+		if (flow->nb_items >= tbl->max_item_per_flow)
+			return -1;
+		i = item_alloc(tbl);
+		if (i == GRO_INVALID_INDEX)
+			return -1;
+		/* keep the items of a flow in arrival order */
+		tbl->items[last].next = i;
+	} else {
+		if (tbl->item_num >= tbl->max_item_num)
+			return -1;
+		f = flow_alloc(tbl);
+		if (f == GRO_INVALID_INDEX)
+			return -1;
+		i = item_alloc(tbl);
+		flow = &tbl->flows[f];
+		flow->key = seg->key;
+		flow->hash = hash;
+		flow->start_index = i;
+		flow->nb_items = 0;
+		flow->next = tbl->buckets[hash & tbl->bucket_mask];
+		tbl->buckets[hash & tbl->bucket_mask] = f;
+	}
+
+	flow->nb_items++;
+	item = &tbl->items[i];
+	item->firstseg = pkt;
+	item->lastseg = rte_pktmbuf_lastseg(pkt);
+	item->start_time = start_time;
+	item->next = GRO_INVALID_INDEX;
+	item->sent_seq = seg->sent_seq;
+	item->payload_len = seg->payload_len;
+	item->hdr_len = seg->hdr_len;
+	item->tcp_off = seg->tcp_off;
+	item->ip_off = seg->ip_off;
+	item->outer_ip_off = seg->outer_ip_off;
+	item->ip_id = seg->ip_id;
+	item->outer_ip_id = seg->outer_ip_id;
+	item->nb_merged = 1;
+	item->slot = slot;
+	item->is_atomic = seg->is_atomic;
+	item->outer_is_atomic = seg->outer_is_atomic;
+	item->tcp_flags = seg->tcp_flags;
+
+	return 0;
+}
+
+static inline void
+update_ipv4_len(struct ipv4_hdr *ip, uint16_t len)
+{
+	ip->total_length = rte_cpu_to_be_16(len);
+	ip->hdr_checksum = 0;
+	ip->hdr_checksum = rte_ipv4_cksum(ip);
+}
+
+/* Write the lengths and flags of a merged packet in its headers */
+static void
+update_header(const struct gro_tcp4_item *item)
+{
+	struct rte_mbuf *pkt = item->firstseg;
+	struct ipv4_hdr *ip;
+	struct udp_hdr *udp;
+	struct tcp_hdr *tcp;
+	uint16_t udp_off;
+
+	if (item->nb_merged == 1)
+		return;
+
+	ip = rte_pktmbuf_mtod_offset(pkt, struct ipv4_hdr *, item->ip_off);
+	update_ipv4_len(ip, item->hdr_len - item->ip_off + item->payload_len);
+	tcp = rte_pktmbuf_mtod_offset(pkt, struct tcp_hdr *, item->tcp_off);
+	tcp->tcp_flags = item->tcp_flags;
+
+	if (item->outer_ip_off == 0)
+		return;
+
+	ip = rte_pktmbuf_mtod_offset(pkt, struct ipv4_hdr *,
+				     item->outer_ip_off);
+	update_ipv4_len(ip, item->hdr_len - item->outer_ip_off +
+			item->payload_len);
+	udp_off = item->outer_ip_off +
+		(ip->version_ihl & IPV4_HDR_IHL_MASK) * IPV4_IHL_MULTIPLIER;
+	udp = rte_pktmbuf_mtod_offset(pkt, struct udp_hdr *, udp_off);
+	udp->dgram_len = rte_cpu_to_be_16(item->hdr_len - udp_off +
+					  item->payload_len);
+	/* the outer UDP checksum is optional over IPv4 */
+	udp->dgram_cksum = 0;
+}
+
+uint16_t
+gro_tcp4_tbl_timeout_flush(struct gro_tcp4_tbl *tbl, uint64_t flush_time,
+	struct rte_mbuf **out, uint16_t nb_out)
+{
+	struct gro_tcp4_flow *flow;
+	uint32_t f, i, next, *prev;
+	uint16_t k = 0;
+
+	for (f = 0; f < tbl->flow_hw && tbl->flow_num != 0; f++) {
+		flow = &tbl->flows[f];
+		if (flow->start_index == GRO_INVALID_INDEX)
+			continue;
+
+		prev = &flow->start_index;
+		for (i = *prev; i != GRO_INVALID_INDEX; i = next) {
+			next = tbl->items[i].next;
+			if (k == nb_out)
+				return k;
+			if (tbl->items[i].start_time > flush_time) {
+				prev = &tbl->items[i].next;
+				continue;
+			}
+			update_header(&tbl->items[i]);
+			out[k++] = tbl->items[i].firstseg;
+			*prev = next;
+			item_free(tbl, i);
+			flow->nb_items--;
+		}
+		if (flow->start_index == GRO_INVALID_INDEX)
+			flow_free(tbl, f);
+	}
+
+	return k;
+}
+
+void
+gro_tcp4_tbl_flush_slots(struct gro_tcp4_tbl *tbl, struct rte_mbuf **out)
+{
+	struct gro_tcp4_item *item;
+	uint32_t i;
+
+	for (i = 0; i < tbl->item_hw; i++) {
+		item = &tbl->items[i];
+		update_header(item);
+		out[item->slot] = item->firstseg;
+	}
+}
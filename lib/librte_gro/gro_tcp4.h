@@ -0,0 +1,166 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _GRO_TCP4_H_
+#define _GRO_TCP4_H_
+
+#include <stdint.h>
+
+#include <rte_ether.h>
+#include <rte_mbuf.h>
+
+#define GRO_INVALID_INDEX UINT32_MAX
+
+/* Max number of packets held by a table */
+#define GRO_TCP4_TBL_MAX_ITEM_NUM (1024U * 1024U)
+
+/*
+ * Identifies a TCP flow. The outer fields are zero for plain TCP/IPv4
+ * packets. Keys are compared as a whole, so they must be zeroed before
+ * being filled.
+ */
+struct gro_tcp4_key {
+	struct ether_addr outer_eth_saddr;
+	struct ether_addr outer_eth_daddr;
+	uint32_t outer_ip_saddr;
+	uint32_t outer_ip_daddr;
+	uint16_t outer_src_port;
+	uint16_t outer_dst_port;
+	uint32_t vxlan_flags;
+	uint32_t vxlan_vni;
+	struct ether_addr eth_saddr;
+	struct ether_addr eth_daddr;
+	uint16_t vlan_tci;
+	uint16_t src_port;
+	uint16_t dst_port;
+	uint32_t ip_saddr;
+	uint32_t ip_daddr;
+	uint32_t recv_ack;
+};
+
+/* A TCP segment as parsed before being merged */
+struct gro_tcp4_seg {
+	struct gro_tcp4_key key;
+	uint32_t sent_seq;
+	uint16_t hdr_len;     /* all the headers, up to the TCP payload */
+	uint16_t payload_len;
+	uint16_t tcp_off;     /* offset of the TCP header */
+	uint16_t ip_off;      /* offset of the inner IPv4 header */
+	uint16_t outer_ip_off; /* offset of the outer IPv4 header, or 0 */
+	uint16_t ip_id;
+	uint16_t outer_ip_id;
+	uint8_t is_atomic;    /* DF is set, the IPv4 ID is not checked */
+	uint8_t outer_is_atomic;
+	uint8_t tcp_flags;
+};
+
+/* A merged packet */
+struct gro_tcp4_item {
+	struct rte_mbuf *firstseg;
+	struct rte_mbuf *lastseg;
+	uint64_t start_time;   /* when the first segment was added */
+	uint32_t next;         /* next item of the flow, or free list link */
+	uint32_t sent_seq;     /* sequence number of the first segment */
+	uint32_t payload_len;
+	uint16_t hdr_len;
+	uint16_t tcp_off;
+	uint16_t ip_off;
+	uint16_t outer_ip_off;
+	uint16_t ip_id;        /* IPv4 IDs of the first segment */
+	uint16_t outer_ip_id;
+	uint16_t nb_merged;
+	uint16_t slot;         /* burst position of the first packet */
+	uint8_t is_atomic;
+	uint8_t outer_is_atomic;
+	uint8_t tcp_flags;
+};
+
+struct gro_tcp4_flow {
+	struct gro_tcp4_key key;
+	uint32_t start_index;  /* first item of the flow */
+	uint32_t next;         /* next flow of the bucket, or free list link */
+	uint32_t hash;
+	uint16_t nb_items;
+};
+
+/*
+ * Table of the flows of one GRO type. Flows are found through buckets of
+ * chained flows, free flows and items are kept in free lists.
+ */
+struct gro_tcp4_tbl {
+	struct gro_tcp4_item *items;
+	struct gro_tcp4_flow *flows;
+	uint32_t *buckets;
+	uint32_t bucket_mask;
+	uint32_t max_item_num;
+	uint32_t max_flow_num;
+	uint32_t max_item_per_flow;
+	uint32_t item_num;
+	uint32_t flow_num;
+	uint32_t free_item;    /* free list heads */
+	uint32_t free_flow;
+	uint32_t item_hw;      /* entries used at least once */
+	uint32_t flow_hw;
+};
+
+/*
+ * Initialize a table over the given arrays. nb_buckets must be a power of
+ * two. The arrays do not need to be zeroed.
+ */
+void gro_tcp4_tbl_init(struct gro_tcp4_tbl *tbl,
+	struct gro_tcp4_item *items, uint32_t max_item_num,
+	struct gro_tcp4_flow *flows, uint32_t max_flow_num,
+	uint32_t *buckets, uint32_t nb_buckets, uint32_t max_item_per_flow);
+
+/*
+ * Merge a parsed segment into the table. Returns 1 if it was merged into
+ * a held packet, 0 if it is now held alone and -1 if it cannot be held.
+ */
+int gro_tcp4_reassemble(struct gro_tcp4_tbl *tbl, struct rte_mbuf *pkt,
+	const struct gro_tcp4_seg *seg, uint64_t start_time, uint16_t slot);
+
+/*
+ * Remove the packets that were added before flush_time from the table
+ * into out, with their headers updated. All the packets are returned
+ * with a flush_time of UINT64_MAX.
+ */
+uint16_t gro_tcp4_tbl_timeout_flush(struct gro_tcp4_tbl *tbl,
+	uint64_t flush_time, struct rte_mbuf **out, uint16_t nb_out);
+
+/*
+ * Remove all the packets from a table that never freed an item, storing
+ * each one at out[item->slot].
+ */
+void gro_tcp4_tbl_flush_slots(struct gro_tcp4_tbl *tbl,
+	struct rte_mbuf **out);
+
+#endif /* _GRO_TCP4_H_ */
@@ -0,0 +1,469 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+
+#include <rte_common.h>
+#include <rte_branch_prediction.h>
+#include <rte_cycles.h>
+#include <rte_errno.h>
+#include <rte_malloc.h>
+#include <rte_mbuf.h>
+#include <rte_ether.h>
+#include <rte_ip.h>
+#include <rte_tcp.h>
+#include <rte_udp.h>
+#include <rte_net.h>
+
+#include "rte_gro.h"
+#include "gro_tcp4.h"
+
+#define GRO_SUPPORTED_TYPES (RTE_GRO_TCP_IPV4 | RTE_GRO_IPV4_VXLAN_TCP_IPV4)
+
+#define TCP_ACK_FLAG 0x10
+#define TCP_PSH_FLAG 0x08
+
+#define VXLAN_FLAG_VNI_VALID 0x08000000
+
+struct rte_gro_ctx {
+	struct rte_gro_param param;
+	uint16_t vxlan_port;      /* network order */
+	struct gro_tcp4_tbl *tbls[RTE_GRO_TYPE_SUPPORT_NUM];
+};
+
+static inline uint16_t
+vxlan_port_be(const struct rte_gro_param *param)
+{
+	return rte_cpu_to_be_16(param->vxlan_port != 0 ? param->vxlan_port :
+				RTE_GRO_VXLAN_DEFAULT_PORT);
+}
+
+/* Parse an IPv4 header, followed by a TCP header at the end of a packet */
+static int
+parse_ipv4_tcp(struct rte_mbuf *pkt, uint32_t ip_off,
+	struct gro_tcp4_seg *seg, uint16_t *ip_len)
+{
+	const struct ipv4_hdr *ip;
+	const struct tcp_hdr *tcp;
+	uint32_t ihl, tcp_hl, total;
+
+	if (unlikely(ip_off + sizeof(*ip) > pkt->data_len))
+		return -1;
+	ip = rte_pktmbuf_mtod_offset(pkt, struct ipv4_hdr *, ip_off);
+	ihl = (ip->version_ihl & IPV4_HDR_IHL_MASK) * IPV4_IHL_MULTIPLIER;
+	if (unlikely((ip->version_ihl >> 4) != 4 ||
+		     ihl < sizeof(struct ipv4_hdr) ||
+		     ip->next_proto_id != IPPROTO_TCP ||
+		     (ip->fragment_offset &
+		      rte_cpu_to_be_16(IPV4_HDR_OFFSET_MASK |
+				       IPV4_HDR_MF_FLAG)) ||
+		     ip_off + ihl + sizeof(struct tcp_hdr) > pkt->data_len))
+		return -1;
+
+	tcp = rte_pktmbuf_mtod_offset(pkt, struct tcp_hdr *, ip_off + ihl);
+	tcp_hl = (tcp->data_off & 0xf0) >> 2;
+	total = rte_be_to_cpu_16(ip->total_length);
+	if (unlikely(tcp_hl < sizeof(struct tcp_hdr) ||
+		     ip_off + ihl + tcp_hl > pkt->data_len ||
+		     total <= ihl + tcp_hl))
+		return -1;
+
+	/* only plain data segments, PSH ending a merged packet */
+	if ((tcp->tcp_flags & ~TCP_PSH_FLAG) != TCP_ACK_FLAG)
+		return -1;
+
+	seg->key.ip_saddr = ip->src_addr;
+	seg->key.ip_daddr = ip->dst_addr;
+	seg->key.src_port = tcp->src_port;
+	seg->key.dst_port = tcp->dst_port;
+	seg->key.recv_ack = tcp->recv_ack;
+	seg->sent_seq = rte_be_to_cpu_32(tcp->sent_seq);
+	seg->ip_off = ip_off;
+	seg->tcp_off = ip_off + ihl;
+	seg->hdr_len = ip_off + ihl + tcp_hl;
+	seg->payload_len = total - ihl - tcp_hl;
+	seg->ip_id = rte_be_to_cpu_16(ip->packet_id);
+	seg->is_atomic = !!(ip->fragment_offset &
+			    rte_cpu_to_be_16(IPV4_HDR_DF_FLAG));
+	seg->tcp_flags = tcp->tcp_flags;
+	*ip_len = total;
+
+	return 0;
+}
+
+/*
+ * Parse a packet to merge, filling its packet type and header lengths.
+ * Returns the index of its GRO type, or -1 if it cannot be merged.
+ */
+static int
+gro_parse(struct rte_mbuf *pkt, uint64_t gro_types, uint16_t vxlan_port,
+	struct gro_tcp4_seg *seg)
+{
+	struct rte_net_hdr_lens hdr_lens;
+	const struct ether_hdr *eth;
+	const struct vlan_hdr *vlan;
+	const struct ipv4_hdr *ip;
+	const struct udp_hdr *udp;
+	const struct vxlan_hdr *vxlan;
+	uint32_t ptype, off, l3_off, l2_len;
+	uint16_t ip_len;
+	int type;
+
+	ptype = rte_net_get_ptype(pkt, &hdr_lens, RTE_PTYPE_L2_MASK |
+				  RTE_PTYPE_L3_MASK | RTE_PTYPE_L4_MASK);
+	if (!RTE_ETH_IS_IPV4_HDR(ptype) ||
+	    (ptype & RTE_PTYPE_L2_MASK) == RTE_PTYPE_L2_ETHER_QINQ)
+		return -1;
+
+	memset(seg, 0, sizeof(*seg));
+	eth = rte_pktmbuf_mtod(pkt, struct ether_hdr *);
+	if ((ptype & RTE_PTYPE_L2_MASK) == RTE_PTYPE_L2_ETHER_VLAN) {
+		vlan = (const struct vlan_hdr *)(eth + 1);
+		seg->key.vlan_tci = vlan->vlan_tci;
+	} else if (pkt->ol_flags & PKT_RX_VLAN_STRIPPED) {
+		seg->key.vlan_tci = pkt->vlan_tci;
+	}
+	l3_off = hdr_lens.l2_len;
+
+	if ((ptype & RTE_PTYPE_L4_MASK) == RTE_PTYPE_L4_TCP) {
+		if (!(gro_types & RTE_GRO_TCP_IPV4))
+			return -1;
+		if (parse_ipv4_tcp(pkt, l3_off, seg, &ip_len) < 0)
+			return -1;
+		ether_addr_copy(&eth->s_addr, &seg->key.eth_saddr);
+		ether_addr_copy(&eth->d_addr, &seg->key.eth_daddr);
+		pkt->packet_type = ptype;
+		pkt->l2_len = hdr_lens.l2_len;
+		pkt->l3_len = seg->tcp_off - l3_off;
+		pkt->l4_len = seg->hdr_len - seg->tcp_off;
+		type = RTE_GRO_TCP_IPV4_INDEX;
+	} else if ((ptype & RTE_PTYPE_L4_MASK) == RTE_PTYPE_L4_UDP) {
+		if (!(gro_types & RTE_GRO_IPV4_VXLAN_TCP_IPV4))
+			return -1;
+		off = l3_off + hdr_lens.l3_len;
+		if (off + sizeof(*udp) + sizeof(*vxlan) + sizeof(*eth) >
+		    pkt->data_len)
+			return -1;
+		udp = rte_pktmbuf_mtod_offset(pkt, struct udp_hdr *, off);
+		vxlan = (const struct vxlan_hdr *)(udp + 1);
+		if (udp->dst_port != vxlan_port ||
+		    !(vxlan->vx_flags &
+		      rte_cpu_to_be_32(VXLAN_FLAG_VNI_VALID)))
+			return -1;
+		eth = (const struct ether_hdr *)(vxlan + 1);
+		if (eth->ether_type != rte_cpu_to_be_16(ETHER_TYPE_IPv4))
+			return -1;
+		off += sizeof(*udp) + sizeof(*vxlan);
+		if (parse_ipv4_tcp(pkt, off + sizeof(*eth), seg, &ip_len) < 0)
+			return -1;
+
+		ip = rte_pktmbuf_mtod_offset(pkt, struct ipv4_hdr *, l3_off);
+		ether_addr_copy(&eth->s_addr, &seg->key.eth_saddr);
+		ether_addr_copy(&eth->d_addr, &seg->key.eth_daddr);
+		eth = rte_pktmbuf_mtod(pkt, struct ether_hdr *);
+		ether_addr_copy(&eth->s_addr, &seg->key.outer_eth_saddr);
+		ether_addr_copy(&eth->d_addr, &seg->key.outer_eth_daddr);
+		seg->key.outer_ip_saddr = ip->src_addr;
+		seg->key.outer_ip_daddr = ip->dst_addr;
+		seg->key.outer_src_port = udp->src_port;
+		seg->key.outer_dst_port = udp->dst_port;
+		seg->key.vxlan_flags = vxlan->vx_flags;
+		seg->key.vxlan_vni = vxlan->vx_vni;
+		seg->outer_ip_off = l3_off;
+		seg->outer_ip_id = rte_be_to_cpu_16(ip->packet_id);
+		seg->outer_is_atomic = !!(ip->fragment_offset &
+					  rte_cpu_to_be_16(IPV4_HDR_DF_FLAG));
+		ip_len = rte_be_to_cpu_16(ip->total_length);
+		if (ip_len != seg->hdr_len - l3_off + seg->payload_len)
+			return -1;
+
+		/* l2_len covers the outer UDP, VXLAN and inner Ethernet
+		 * headers, as for the TX offloads */
+		l2_len = seg->ip_off - l3_off - hdr_lens.l3_len;
+		pkt->packet_type = ptype | RTE_PTYPE_TUNNEL_VXLAN |
+			RTE_PTYPE_INNER_L2_ETHER | RTE_PTYPE_INNER_L3_IPV4 |
+			RTE_PTYPE_INNER_L4_TCP;
+		pkt->outer_l2_len = hdr_lens.l2_len;
+		pkt->outer_l3_len = hdr_lens.l3_len;
+		pkt->l2_len = l2_len;
+		pkt->l3_len = seg->tcp_off - seg->ip_off;
+		pkt->l4_len = seg->hdr_len - seg->tcp_off;
+		type = RTE_GRO_IPV4_VXLAN_TCP_IPV4_INDEX;
+	} else {
+		return -1;
+	}
+
+	/* drop the Ethernet padding, the merged packet length is taken from
+	 * the IPv4 header */
+	if (pkt->pkt_len < l3_off + ip_len)
+		return -1;
+	if (pkt->pkt_len > l3_off + ip_len &&
+	    rte_pktmbuf_trim(pkt, pkt->pkt_len - l3_off - ip_len) < 0)
+		return -1;
+
+	return type;
+}
+
+uint16_t
+rte_gro_reassemble_burst(struct rte_mbuf **pkts, uint16_t nb_pkts,
+	const struct rte_gro_param *param)
+{
+	struct gro_tcp4_tbl tbls[RTE_GRO_TYPE_SUPPORT_NUM];
+	struct gro_tcp4_item
+		items[RTE_GRO_TYPE_SUPPORT_NUM][RTE_GRO_MAX_BURST_ITEM_NUM];
+	struct gro_tcp4_flow
+		flows[RTE_GRO_TYPE_SUPPORT_NUM][RTE_GRO_MAX_BURST_ITEM_NUM];
+	uint32_t
+		buckets[RTE_GRO_TYPE_SUPPORT_NUM][RTE_GRO_MAX_BURST_ITEM_NUM];
+	struct rte_mbuf *slots[RTE_GRO_MAX_BURST_ITEM_NUM];
+	struct gro_tcp4_seg seg;
+	uint16_t vxlan_port = vxlan_port_be(param);
+	uint16_t i, n, nb_out, nb_merged = 0;
+	uint32_t init = 0;
+	int type, ret;
+
+	if (unlikely(nb_pkts < 2 ||
+		     (param->gro_types & GRO_SUPPORTED_TYPES) == 0))
+		return nb_pkts;
+
+	n = RTE_MIN(nb_pkts, RTE_GRO_MAX_BURST_ITEM_NUM);
+	for (i = 0; i < n; i++) {
+		slots[i] = pkts[i];
+		type = gro_parse(pkts[i], param->gro_types, vxlan_port, &seg);
+		if (type < 0)
+			continue;
+
+		/* the tables are set up when first needed */
+		if (!(init & (1 << type))) {
+			gro_tcp4_tbl_init(&tbls[type], items[type], n,
+					  flows[type], n, buckets[type],
+					  RTE_GRO_MAX_BURST_ITEM_NUM, n);
+			init |= 1 << type;
+		}
+
+		ret = gro_tcp4_reassemble(&tbls[type], pkts[i], &seg, 0, i);
+		if (ret >= 0)
+			slots[i] = NULL;
+		if (ret > 0)
+			nb_merged++;
+	}
+
+	if (nb_merged == 0)
+		return nb_pkts;
+
+	/* merged packets take the place of their first packet */
+	for (type = 0; type < RTE_GRO_TYPE_SUPPORT_NUM; type++) {
+		if (init & (1 << type))
+			gro_tcp4_tbl_flush_slots(&tbls[type], slots);
+	}
+
+	nb_out = 0;
+	for (i = 0; i < n; i++) {
+		if (slots[i] != NULL)
+			pkts[nb_out++] = slots[i];
+	}
+	for (; i < nb_pkts; i++)
+		pkts[nb_out++] = pkts[i];
+
+	return nb_out;
+}
+
+struct rte_gro_ctx *
+rte_gro_ctx_create(const struct rte_gro_param *param)
+{
+	struct rte_gro_ctx *ctx;
+	struct gro_tcp4_tbl *tbl;
+	uint32_t max_item_num, nb_buckets;
+	size_t items_size, flows_size, size;
+	char *mem;
+	int type;
+
+	if (param == NULL || param->max_flow_num == 0 ||
+	    param->max_item_per_flow == 0 ||
+	    (param->gro_types & GRO_SUPPORTED_TYPES) == 0 ||
+	    (param->gro_types & ~GRO_SUPPORTED_TYPES) != 0) {
+		rte_errno = EINVAL;
+		return NULL;
+	}
+
+	max_item_num = RTE_MIN((uint32_t)param->max_flow_num *
+			       param->max_item_per_flow,
+			       GRO_TCP4_TBL_MAX_ITEM_NUM);
+	nb_buckets = rte_align32pow2(param->max_flow_num);
+	items_size = RTE_ALIGN_CEIL(max_item_num *
+				    sizeof(struct gro_tcp4_item),
+				    RTE_CACHE_LINE_SIZE);
+	flows_size = RTE_ALIGN_CEIL(param->max_flow_num *
+				    sizeof(struct gro_tcp4_flow),
+				    RTE_CACHE_LINE_SIZE);
+	size = RTE_ALIGN_CEIL(sizeof(struct gro_tcp4_tbl),
+			      RTE_CACHE_LINE_SIZE) +
+		items_size + flows_size + nb_buckets * sizeof(uint32_t);
+
+	ctx = rte_zmalloc_socket("GRO_CTX", sizeof(*ctx), RTE_CACHE_LINE_SIZE,
+				 param->socket_id);
+	if (ctx == NULL) {
+		rte_errno = ENOMEM;
+		return NULL;
+	}
+	ctx->param = *param;
+	ctx->vxlan_port = vxlan_port_be(param);
+
+	for (type = 0; type < RTE_GRO_TYPE_SUPPORT_NUM; type++) {
+		if (!(param->gro_types & (1ULL << type)))
+			continue;
+
+		mem = rte_malloc_socket("GRO_TBL", size, RTE_CACHE_LINE_SIZE,
+					param->socket_id);
+		if (mem == NULL) {
+			rte_gro_ctx_destroy(ctx);
+			rte_errno = ENOMEM;
+			return NULL;
+		}
+		tbl = (struct gro_tcp4_tbl *)mem;
+		mem += RTE_ALIGN_CEIL(sizeof(*tbl), RTE_CACHE_LINE_SIZE);
+		gro_tcp4_tbl_init(tbl, (struct gro_tcp4_item *)mem,
+				  max_item_num,
+				  (struct gro_tcp4_flow *)(mem + items_size),
+				  param->max_flow_num,
+				  (uint32_t *)(mem + items_size + flows_size),
+				  nb_buckets, param->max_item_per_flow);
+		ctx->tbls[type] = tbl;
+	}
+
+	return ctx;
+}
+
+void
+rte_gro_ctx_destroy(struct rte_gro_ctx *ctx)
+{
+	struct rte_mbuf *pkts[RTE_GRO_MAX_BURST_ITEM_NUM];
+	uint16_t i, n;
+	int type;
+
+	if (ctx == NULL)
+		return;
+
+	for (type = 0; type < RTE_GRO_TYPE_SUPPORT_NUM; type++) {
+		if (ctx->tbls[type] == NULL)
+			continue;
+		do {
+			n = gro_tcp4_tbl_timeout_flush(ctx->tbls[type],
+				UINT64_MAX, pkts, RTE_DIM(pkts));
+			for (i = 0; i < n; i++)
+				rte_pktmbuf_free(pkts[i]);
+		} while (n != 0);
+		rte_free(ctx->tbls[type]);
+	}
+	rte_free(ctx);
+}
+
+uint16_t
+rte_gro_reassemble(struct rte_mbuf **pkts, uint16_t nb_pkts,
+	struct rte_gro_ctx *ctx)
+{
+	struct gro_tcp4_seg seg;
+	uint64_t now = rte_rdtsc();
+	uint16_t i, nb_out = 0;
+	int type;
+
+	for (i = 0; i < nb_pkts; i++) {
+		type = gro_parse(pkts[i], ctx->param.gro_types,
+				 ctx->vxlan_port, &seg);
+		if (type < 0 || gro_tcp4_reassemble(ctx->tbls[type], pkts[i],
+						    &seg, now, 0) < 0)
+			pkts[nb_out++] = pkts[i];
+	}
+
+	return nb_out;
+}
+
+uint16_t
+rte_gro_timeout_flush(struct rte_gro_ctx *ctx, uint64_t timeout_cycles,
+	uint64_t gro_types, struct rte_mbuf **out, uint16_t max_nb_out)
+{
+	uint64_t flush_time = UINT64_MAX;
+	uint16_t nb_out = 0;
+	int type;
+
+	if (timeout_cycles != 0)
+		flush_time = rte_rdtsc() - timeout_cycles;
+
+	gro_types &= ctx->param.gro_types;
+	for (type = 0; type < RTE_GRO_TYPE_SUPPORT_NUM; type++) {
+		if (!(gro_types & (1ULL << type)) ||
+		    ctx->tbls[type]->item_num == 0)
+			continue;
+		nb_out += gro_tcp4_tbl_timeout_flush(ctx->tbls[type],
+			flush_time, out + nb_out, max_nb_out - nb_out);
+	}
+
+	return nb_out;
+}
+
+uint64_t
+rte_gro_get_pkt_count(struct rte_gro_ctx *ctx)
+{
+	uint64_t count = 0;
+	int type;
+
+	for (type = 0; type < RTE_GRO_TYPE_SUPPORT_NUM; type++) {
+		if (ctx->tbls[type] != NULL)
+			count += ctx->tbls[type]->item_num;
+	}
+
+	return count;
+}
+
+uint16_t
+rte_gro_rx_burst_cb(uint8_t port __rte_unused, uint16_t queue __rte_unused,
+	struct rte_mbuf **pkts, uint16_t nb_pkts,
+	uint16_t max_pkts __rte_unused, void *user_param)
+{
+	return rte_gro_reassemble_burst(pkts, nb_pkts, user_param);
+}
+
+uint16_t
+rte_gro_rx_ctx_cb(uint8_t port __rte_unused, uint16_t queue __rte_unused,
+	struct rte_mbuf **pkts, uint16_t nb_pkts, uint16_t max_pkts,
+	void *user_param)
+{
+	struct rte_gro_ctx *ctx = user_param;
+
+	nb_pkts = rte_gro_reassemble(pkts, nb_pkts, ctx);
+	if (nb_pkts < max_pkts && rte_gro_get_pkt_count(ctx) != 0)
+		nb_pkts += rte_gro_timeout_flush(ctx,
+			ctx->param.timeout_cycles, ctx->param.gro_types,
+			pkts + nb_pkts, max_pkts - nb_pkts);
+
+	return nb_pkts;
+}
@@ -0,0 +1,249 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _RTE_GRO_H_
+#define _RTE_GRO_H_
+
+/**
+ * @file
+ *
+ * RTE Generic Receive Offload
+ *
+ * The GRO library merges the TCP segments of a flow received in software
+ * into a single large packet, made of the chained mbufs of the segments,
+ * so that the later stages of the application, a vhost queue or the
+ * kernel through a TAP device handle one packet instead of many.
+ *
+ * TCP/IPv4 packets and TCP/IPv4 packets encapsulated in VXLAN over IPv4
+ * are supported. Two segments are merged when they belong to the same
+ * flow, are contiguous in the TCP sequence space, carry the same TCP
+ * options and, unless the IPv4 DF flag is set, consecutive IPv4 IDs. Only
+ * segments with the ACK flag and, for the last one merged, the PSH flag,
+ * are merged.
+ *
+ * Two modes are provided:
+ * - the lightweight mode, rte_gro_reassemble_burst(), merges the packets
+ *   of one burst and returns them all at once;
+ * - the heavyweight mode, rte_gro_reassemble(), keeps the packets in a
+ *   per-lcore context across bursts, until rte_gro_timeout_flush()
+ *   returns them.
+ *
+ * Both modes can be run from an ethdev RX callback, see
+ * rte_gro_rx_burst_cb() and rte_gro_rx_ctx_cb().
+ *
+ * The packets are parsed by the library, the packet_type of the mbufs is
+ * not required, and their headers must be in their first segment. The
+ * packet_type, l2_len, l3_len and l4_len fields (and outer_l2_len,
+ * outer_l3_len for VXLAN) of the TCP packets are set, with l2_len covering
+ * the outer UDP, VXLAN and inner Ethernet headers for VXLAN packets, as
+ * expected by the TX segmentation offload.
+ *
+ * The checksums of the segments are not verified and the TCP checksum of a
+ * merged packet is not updated, its IPv4 header checksums are. A merged
+ * packet is flagged PKT_RX_L4_CKSUM_NONE if all its segments were flagged
+ * PKT_RX_L4_CKSUM_GOOD.
+ */
+
+#include <stdint.h>
+
+#include <rte_mbuf.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Max number of packets merged by one rte_gro_reassemble_burst() call */
+#define RTE_GRO_MAX_BURST_ITEM_NUM 128U
+
+/** Number of supported GRO types */
+#define RTE_GRO_TYPE_SUPPORT_NUM 2
+
+#define RTE_GRO_TCP_IPV4_INDEX 0
+/** TCP/IPv4 packets */
+#define RTE_GRO_TCP_IPV4 (1ULL << RTE_GRO_TCP_IPV4_INDEX)
+#define RTE_GRO_IPV4_VXLAN_TCP_IPV4_INDEX 1
+/** TCP/IPv4 packets encapsulated in VXLAN over IPv4 */
+#define RTE_GRO_IPV4_VXLAN_TCP_IPV4 \
+	(1ULL << RTE_GRO_IPV4_VXLAN_TCP_IPV4_INDEX)
+
+/** Default UDP destination port of VXLAN */
+#define RTE_GRO_VXLAN_DEFAULT_PORT 4789
+
+/** Max length of a merged packet, from its IPv4 header */
+#define RTE_GRO_MAX_PKT_LEN UINT16_MAX
+
+/**
+ * GRO parameters.
+ */
+struct rte_gro_param {
+	uint64_t gro_types;
+	/**< GRO types to perform, RTE_GRO_TCP_IPV4 and so on */
+	uint16_t max_flow_num;
+	/**< Max number of flows in a context */
+	uint16_t max_item_per_flow;
+	/**< Max number of merged packets held per flow in a context */
+	uint16_t socket_id;
+	/**< NUMA socket of the context memory */
+	uint16_t vxlan_port;
+	/**< UDP destination port of VXLAN, 0 for the default port */
+	uint64_t timeout_cycles;
+	/**< Age, in TSC cycles, from which rte_gro_rx_ctx_cb() returns the
+	 * merged packets */
+};
+
+/** Heavyweight mode GRO context */
+struct rte_gro_ctx;
+
+/**
+ * Create a GRO context for the heavyweight mode.
+ *
+ * A context is used by one lcore at a time.
+ *
+ * @param param
+ *   GRO parameters. max_flow_num and max_item_per_flow size the tables of
+ *   each GRO type.
+ * @return
+ *   The context, or NULL on error with rte_errno set:
+ *    - EINVAL - invalid parameters
+ *    - ENOMEM - not enough memory
+ */
+struct rte_gro_ctx *rte_gro_ctx_create(const struct rte_gro_param *param);
+
+/**
+ * Destroy a GRO context.
+ *
+ * The packets still held by the context are freed.
+ *
+ * @param ctx
+ *   Context to destroy, can be NULL.
+ */
+void rte_gro_ctx_destroy(struct rte_gro_ctx *ctx);
+
+/**
+ * Merge the packets of a burst (lightweight mode).
+ *
+ * The merged packets and the packets that cannot be merged are returned
+ * in the order of their first segment. At most
+ * RTE_GRO_MAX_BURST_ITEM_NUM packets are merged, the following packets
+ * are returned as they are.
+ *
+ * @param pkts
+ *   Packets to merge, and merged packets on return.
+ * @param nb_pkts
+ *   Number of packets.
+ * @param param
+ *   GRO parameters. Only gro_types and vxlan_port are used.
+ * @return
+ *   Number of packets in pkts after merging.
+ */
+uint16_t rte_gro_reassemble_burst(struct rte_mbuf **pkts, uint16_t nb_pkts,
+	const struct rte_gro_param *param);
+
+/**
+ * Merge the packets of a burst into a context (heavyweight mode).
+ *
+ * The packets that can be merged are kept in the context until they are
+ * returned by rte_gro_timeout_flush(). The packets that cannot be merged,
+ * including those that do not fit in the context, are returned.
+ *
+ * @param pkts
+ *   Packets to merge, and packets not merged on return.
+ * @param nb_pkts
+ *   Number of packets.
+ * @param ctx
+ *   GRO context.
+ * @return
+ *   Number of packets left in pkts.
+ */
+uint16_t rte_gro_reassemble(struct rte_mbuf **pkts, uint16_t nb_pkts,
+	struct rte_gro_ctx *ctx);
+
+/**
+ * Return the packets held by a context for some time.
+ *
+ * @param ctx
+ *   GRO context.
+ * @param timeout_cycles
+ *   Min age, in TSC cycles, of the packets to return. With 0, all the
+ *   packets are returned.
+ * @param gro_types
+ *   GRO types of the packets to return.
+ * @param out
+ *   Array receiving the packets.
+ * @param max_nb_out
+ *   Size of out.
+ * @return
+ *   Number of packets in out.
+ */
+uint16_t rte_gro_timeout_flush(struct rte_gro_ctx *ctx,
+	uint64_t timeout_cycles, uint64_t gro_types,
+	struct rte_mbuf **out, uint16_t max_nb_out);
+
+/**
+ * Get the number of packets held by a context.
+ *
+ * @param ctx
+ *   GRO context.
+ * @return
+ *   Number of merged packets in the context.
+ */
+uint64_t rte_gro_get_pkt_count(struct rte_gro_ctx *ctx);
+
+/**
+ * RX callback merging each received burst in the lightweight mode.
+ *
+ * To be registered with rte_eth_add_rx_callback(), with a pointer to a
+ * struct rte_gro_param as user parameter. The parameters must stay valid
+ * as long as the callback is registered.
+ */
+uint16_t rte_gro_rx_burst_cb(uint8_t port, uint16_t queue,
+	struct rte_mbuf **pkts, uint16_t nb_pkts, uint16_t max_pkts,
+	void *user_param);
+
+/**
+ * RX callback merging the received packets in the heavyweight mode.
+ *
+ * To be registered with rte_eth_add_rx_callback(), with a context created
+ * for the queue as user parameter. The received packets are merged into
+ * the context, then the packets held for timeout_cycles are returned
+ * along with the packets that cannot be merged, up to the burst size
+ * requested by the application.
+ */
+uint16_t rte_gro_rx_ctx_cb(uint8_t port, uint16_t queue,
+	struct rte_mbuf **pkts, uint16_t nb_pkts, uint16_t max_pkts,
+	void *user_param);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RTE_GRO_H_ */
@@ -68,6 +68,11 @@ static struct rte_tailq_elem rte_mempool_tailq = {
 };
 EAL_REGISTER_TAILQ(rte_mempool_tailq)
 
+RTE_TRACE_POINT_DEFINE(rte_mempool_trace_get, "lib.mempool.get",
+	"mempool", "n")
+RTE_TRACE_POINT_DEFINE(rte_mempool_trace_put, "lib.mempool.put",
+	"mempool", "n")
+
 #define CACHE_FLUSHTHRESH_MULTIPLIER 1.5
 #define CALC_CACHE_FLUSHTHRESH(c)	\
 	((typeof(c))((c) * CACHE_FLUSHTHRESH_MULTIPLIER))
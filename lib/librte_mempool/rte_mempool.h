@@ -76,11 +76,17 @@
 #include <rte_ring.h>
 #include <rte_memcpy.h>
 #include <rte_common.h>
+#include <rte_trace.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/** Tracepoint "lib.mempool.get" of the objects taken from a mempool. */
+extern struct rte_trace_point rte_mempool_trace_get;
+/** Tracepoint "lib.mempool.put" of the objects given back to a mempool. */
+extern struct rte_trace_point rte_mempool_trace_put;
+
 #define RTE_MEMPOOL_HEADER_COOKIE1  0xbadbadbadadd2e55ULL /**< Header cookie. */
 #define RTE_MEMPOOL_HEADER_COOKIE2  0xf2eef2eedadd2e55ULL /**< Header cookie. */
 #define RTE_MEMPOOL_TRAILER_COOKIE  0xadd2e55badbadbadULL /**< Trailer cookie.*/
@@ -1105,6 +1111,7 @@ rte_mempool_generic_put(struct rte_mempool *mp, void * const *obj_table,
 {
 	__mempool_check_cookies(mp, obj_table, n, 0);
 	__mempool_generic_put(mp, obj_table, n, cache);
+	rte_trace_point_emit(rte_mempool_trace_put, (uintptr_t)mp, n);
 }
 
 /**
@@ -1326,8 +1333,10 @@ rte_mempool_generic_get(struct rte_mempool *mp, void **obj_table, unsigned n,
 {
 	int ret;
 	ret = __mempool_generic_get(mp, obj_table, n, cache);
-	if (ret == 0)
+	if (ret == 0) {
 		__mempool_check_cookies(mp, obj_table, n, 1);
+		rte_trace_point_emit(rte_mempool_trace_get, (uintptr_t)mp, n);
+	}
 	return ret;
 }
 
@@ -38,6 +38,7 @@
 #include <rte_common.h>
 #include <rte_log.h>
 #include <rte_cycles.h>
+#include <rte_prefetch.h>
 
 #include "rte_meter.h"
 
@@ -45,6 +46,12 @@
 #define RTE_METER_TB_PERIOD_MIN      100
 #endif
 
+/* Distance (in packets) at which the run-time contexts are prefetched by the
+ * bulk metering methods */
+#ifndef RTE_METER_BULK_PREFETCH_OFFSET
+#define RTE_METER_BULK_PREFETCH_OFFSET 4
+#endif
+
 static void
 rte_meter_get_tb_params(uint64_t hz, uint64_t rate, uint64_t *tb_period, uint64_t *tb_bytes_per_period)
 {
@@ -118,3 +125,196 @@ rte_meter_trtcm_config(struct rte_meter_trtcm *m, struct rte_meter_trtcm_params
 
 	return 0;
 }
+
+int
+rte_meter_srtcm_profile_config(struct rte_meter_srtcm_profile *p,
+	struct rte_meter_srtcm_params *params)
+{
+	uint64_t hz;
+
+	/* Check input parameters */
+	if ((p == NULL) || (params == NULL))
+		return -1;
+
+	if ((params->cir == 0) || ((params->cbs == 0) && (params->ebs == 0)))
+		return -2;
+
+	/* Initialize srTCM profile */
+	hz = rte_get_tsc_hz();
+	p->cbs = params->cbs;
+	p->ebs = params->ebs;
+	rte_meter_get_tb_params(hz, params->cir, &p->cir_period, &p->cir_bytes_per_period);
+
+	RTE_LOG(INFO, METER, "srTCM profile config: \n"
+		"\tCIR period = %" PRIu64 ", CIR bytes per period = %" PRIu64 "\n",
+		p->cir_period, p->cir_bytes_per_period);
+
+	return 0;
+}
+
+int
+rte_meter_trtcm_profile_config(struct rte_meter_trtcm_profile *p,
+	struct rte_meter_trtcm_params *params)
+{
+	uint64_t hz;
+
+	/* Check input parameters */
+	if ((p == NULL) || (params == NULL))
+		return -1;
+
+	if ((params->cir == 0) || (params->pir == 0) || (params->pir < params->cir) ||
+		(params->cbs == 0) || (params->pbs == 0))
+		return -2;
+
+	/* Initialize trTCM profile */
+	hz = rte_get_tsc_hz();
+	p->cbs = params->cbs;
+	p->pbs = params->pbs;
+	rte_meter_get_tb_params(hz, params->cir, &p->cir_period, &p->cir_bytes_per_period);
+	rte_meter_get_tb_params(hz, params->pir, &p->pir_period, &p->pir_bytes_per_period);
+
+	RTE_LOG(INFO, METER, "trTCM profile config: \n"
+		"\tCIR period = %" PRIu64 ", CIR bytes per period = %" PRIu64 "\n"
+		"\tPIR period = %" PRIu64 ", PIR bytes per period = %" PRIu64 "\n",
+		p->cir_period, p->cir_bytes_per_period,
+		p->pir_period, p->pir_bytes_per_period);
+
+	return 0;
+}
+
+int
+rte_meter_srtcm_rt_config(struct rte_meter_srtcm_rt *m,
+	struct rte_meter_srtcm_profile *p)
+{
+	/* Check input parameters */
+	if ((m == NULL) || (p == NULL))
+		return -1;
+
+	/* Initialize srTCM run-time structure */
+	m->time = rte_get_tsc_cycles();
+	m->tc = p->cbs;
+	m->te = p->ebs;
+
+	return 0;
+}
+
+int
+rte_meter_trtcm_rt_config(struct rte_meter_trtcm_rt *m,
+	struct rte_meter_trtcm_profile *p)
+{
+	/* Check input parameters */
+	if ((m == NULL) || (p == NULL))
+		return -1;
+
+	/* Initialize trTCM run-time structure */
+	m->time_tc = m->time_tp = rte_get_tsc_cycles();
+	m->tc = p->cbs;
+	m->tp = p->pbs;
+
+	return 0;
+}
+
+/*
+ * Bulk metering
+ *
+ * The run-time context of each flow is prefetched RTE_METER_BULK_PREFETCH_OFFSET
+ * packets ahead of its update, so the cache misses on the (typically large)
+ * flow table overlap with the token bucket arithmetic of the previous packets.
+ * The profiles are expected to be few and hot in the cache, so they are not
+ * prefetched.
+ *
+ ***/
+
+#define METER_BULK_PREFETCH_HEAD(m, n_pkts)				\
+do {									\
+	uint32_t j;							\
+									\
+	for (j = 0; (j < RTE_METER_BULK_PREFETCH_OFFSET) && (j < (n_pkts)); j++) \
+		rte_prefetch0((m)[j]);					\
+} while (0)
+
+#define METER_BULK_PREFETCH_NEXT(m, i, n_pkts)				\
+do {									\
+	if ((i) + RTE_METER_BULK_PREFETCH_OFFSET < (n_pkts))		\
+		rte_prefetch0((m)[(i) + RTE_METER_BULK_PREFETCH_OFFSET]); \
+} while (0)
+
+void
+rte_meter_srtcm_color_blind_check_bulk(struct rte_meter_srtcm_rt **m,
+	struct rte_meter_srtcm_profile **p,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *color,
+	uint32_t n_pkts)
+{
+	uint32_t i;
+
+	METER_BULK_PREFETCH_HEAD(m, n_pkts);
+
+	for (i = 0; i < n_pkts; i++) {
+		METER_BULK_PREFETCH_NEXT(m, i, n_pkts);
+
+		color[i] = rte_meter_srtcm_rt_color_blind_check(m[i], p[i],
+			time, pkt_len[i]);
+	}
+}
+
+void
+rte_meter_srtcm_color_aware_check_bulk(struct rte_meter_srtcm_rt **m,
+	struct rte_meter_srtcm_profile **p,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *color,
+	uint32_t n_pkts)
+{
+	uint32_t i;
+
+	METER_BULK_PREFETCH_HEAD(m, n_pkts);
+
+	for (i = 0; i < n_pkts; i++) {
+		METER_BULK_PREFETCH_NEXT(m, i, n_pkts);
+
+		color[i] = rte_meter_srtcm_rt_color_aware_check(m[i], p[i],
+			time, pkt_len[i], color[i]);
+	}
+}
+
+void
+rte_meter_trtcm_color_blind_check_bulk(struct rte_meter_trtcm_rt **m,
+	struct rte_meter_trtcm_profile **p,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *color,
+	uint32_t n_pkts)
+{
+	uint32_t i;
+
+	METER_BULK_PREFETCH_HEAD(m, n_pkts);
+
+	for (i = 0; i < n_pkts; i++) {
+		METER_BULK_PREFETCH_NEXT(m, i, n_pkts);
+
+		color[i] = rte_meter_trtcm_rt_color_blind_check(m[i], p[i],
+			time, pkt_len[i]);
+	}
+}
+
+void
+rte_meter_trtcm_color_aware_check_bulk(struct rte_meter_trtcm_rt **m,
+	struct rte_meter_trtcm_profile **p,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *color,
+	uint32_t n_pkts)
+{
+	uint32_t i;
+
+	METER_BULK_PREFETCH_HEAD(m, n_pkts);
+
+	for (i = 0; i < n_pkts; i++) {
+		METER_BULK_PREFETCH_NEXT(m, i, n_pkts);
+
+		color[i] = rte_meter_trtcm_rt_color_aware_check(m[i], p[i],
+			time, pkt_len[i], color[i]);
+	}
+}
@@ -46,6 +46,15 @@ extern "C" {
  *    1. Single Rate Three Color Marker (srTCM): defined by IETF RFC 2697
  *    2. Two Rate Three Color Marker (trTCM): defined by IETF RFC 2698
  *
+ * Each algorithm is available in two flavours:
+ *    1. Self-contained: the run-time context of each metered traffic flow
+ *       stores both the token buckets and the configuration parameters;
+ *    2. Profile based: the configuration parameters are stored in a profile
+ *       that is shared by all the flows using the same parameters, while the
+ *       per flow run-time context is reduced to the token buckets and the
+ *       time stamp of their latest update. This flavour also provides bulk
+ *       methods that meter a burst of packets using a single time stamp.
+ *
  ***/
 
 #include <stdint.h>
@@ -88,6 +97,22 @@ struct rte_meter_srtcm;
 /** Internal data structure storing the trTCM run-time context per metered traffic flow. */
 struct rte_meter_trtcm;
 
+/** Internal data structure storing the srTCM configuration profile. Shared by
+all the metered traffic flows that use the same srTCM parameters. */
+struct rte_meter_srtcm_profile;
+
+/** Internal data structure storing the trTCM configuration profile. Shared by
+all the metered traffic flows that use the same trTCM parameters. */
+struct rte_meter_trtcm_profile;
+
+/** Internal data structure storing the profile based srTCM run-time context per
+metered traffic flow. */
+struct rte_meter_srtcm_rt;
+
+/** Internal data structure storing the profile based trTCM run-time context per
+metered traffic flow. */
+struct rte_meter_trtcm_rt;
+
 /**
  * srTCM configuration per metered traffic flow
  *
@@ -190,6 +215,249 @@ rte_meter_trtcm_color_aware_check(struct rte_meter_trtcm *m,
 	uint32_t pkt_len,
 	enum rte_meter_color pkt_color);
 
+/**
+ * srTCM profile configuration
+ *
+ * @param p
+ *    Pointer to pre-allocated srTCM profile data structure
+ * @param params
+ *    srTCM profile parameters
+ * @return
+ *    0 upon success, error code otherwise
+ */
+int
+rte_meter_srtcm_profile_config(struct rte_meter_srtcm_profile *p,
+	struct rte_meter_srtcm_params *params);
+
+/**
+ * trTCM profile configuration
+ *
+ * @param p
+ *    Pointer to pre-allocated trTCM profile data structure
+ * @param params
+ *    trTCM profile parameters
+ * @return
+ *    0 upon success, error code otherwise
+ */
+int
+rte_meter_trtcm_profile_config(struct rte_meter_trtcm_profile *p,
+	struct rte_meter_trtcm_params *params);
+
+/**
+ * Profile based srTCM configuration per metered traffic flow
+ *
+ * @param m
+ *    Pointer to pre-allocated srTCM run-time data structure
+ * @param p
+ *    srTCM profile. Needs to be valid.
+ * @return
+ *    0 upon success, error code otherwise
+ */
+int
+rte_meter_srtcm_rt_config(struct rte_meter_srtcm_rt *m,
+	struct rte_meter_srtcm_profile *p);
+
+/**
+ * Profile based trTCM configuration per metered traffic flow
+ *
+ * @param m
+ *    Pointer to pre-allocated trTCM run-time data structure
+ * @param p
+ *    trTCM profile. Needs to be valid.
+ * @return
+ *    0 upon success, error code otherwise
+ */
+int
+rte_meter_trtcm_rt_config(struct rte_meter_trtcm_rt *m,
+	struct rte_meter_trtcm_profile *p);
+
+/**
+ * Profile based srTCM color blind traffic metering
+ *
+ * @param m
+ *    Handle to srTCM run-time instance
+ * @param p
+ *    srTCM profile specified at srTCM run-time instance configuration
+ * @param time
+ *    Current CPU time stamp (measured in CPU cycles)
+ * @param pkt_len
+ *    Length of the current IP packet (measured in bytes)
+ * @return
+ *    Color assigned to the current IP packet
+ */
+static inline enum rte_meter_color
+rte_meter_srtcm_rt_color_blind_check(struct rte_meter_srtcm_rt *m,
+	struct rte_meter_srtcm_profile *p,
+	uint64_t time,
+	uint32_t pkt_len);
+
+/**
+ * Profile based srTCM color aware traffic metering
+ *
+ * @param m
+ *    Handle to srTCM run-time instance
+ * @param p
+ *    srTCM profile specified at srTCM run-time instance configuration
+ * @param time
+ *    Current CPU time stamp (measured in CPU cycles)
+ * @param pkt_len
+ *    Length of the current IP packet (measured in bytes)
+ * @param pkt_color
+ *    Input color of the current IP packet
+ * @return
+ *    Color assigned to the current IP packet
+ */
+static inline enum rte_meter_color
+rte_meter_srtcm_rt_color_aware_check(struct rte_meter_srtcm_rt *m,
+	struct rte_meter_srtcm_profile *p,
+	uint64_t time,
+	uint32_t pkt_len,
+	enum rte_meter_color pkt_color);
+
+/**
+ * Profile based trTCM color blind traffic metering
+ *
+ * @param m
+ *    Handle to trTCM run-time instance
+ * @param p
+ *    trTCM profile specified at trTCM run-time instance configuration
+ * @param time
+ *    Current CPU time stamp (measured in CPU cycles)
+ * @param pkt_len
+ *    Length of the current IP packet (measured in bytes)
+ * @return
+ *    Color assigned to the current IP packet
+ */
+static inline enum rte_meter_color
+rte_meter_trtcm_rt_color_blind_check(struct rte_meter_trtcm_rt *m,
+	struct rte_meter_trtcm_profile *p,
+	uint64_t time,
+	uint32_t pkt_len);
+
+/**
+ * Profile based trTCM color aware traffic metering
+ *
+ * @param m
+ *    Handle to trTCM run-time instance
+ * @param p
+ *    trTCM profile specified at trTCM run-time instance configuration
+ * @param time
+ *    Current CPU time stamp (measured in CPU cycles)
+ * @param pkt_len
+ *    Length of the current IP packet (measured in bytes)
+ * @param pkt_color
+ *    Input color of the current IP packet
+ * @return
+ *    Color assigned to the current IP packet
+ */
+static inline enum rte_meter_color
+rte_meter_trtcm_rt_color_aware_check(struct rte_meter_trtcm_rt *m,
+	struct rte_meter_trtcm_profile *p,
+	uint64_t time,
+	uint32_t pkt_len,
+	enum rte_meter_color pkt_color);
+
+/**
+ * srTCM color blind traffic metering for a burst of packets
+ *
+ * All the packets of the burst are metered against the same time stamp. The
+ * run-time contexts of the flows are prefetched ahead of their update. The
+ * same flow may show up several times within the burst, in which case its
+ * packets are metered in array order.
+ *
+ * @param m
+ *    Array of handles to srTCM run-time instances, one per packet
+ * @param p
+ *    Array of srTCM profiles, one per packet
+ * @param time
+ *    Current CPU time stamp (measured in CPU cycles)
+ * @param pkt_len
+ *    Array of IP packet lengths (measured in bytes)
+ * @param color
+ *    Array populated with the color assigned to each packet
+ * @param n_pkts
+ *    Number of packets in the burst
+ */
+void
+rte_meter_srtcm_color_blind_check_bulk(struct rte_meter_srtcm_rt **m,
+	struct rte_meter_srtcm_profile **p,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *color,
+	uint32_t n_pkts);
+
+/**
+ * srTCM color aware traffic metering for a burst of packets
+ *
+ * @param m
+ *    Array of handles to srTCM run-time instances, one per packet
+ * @param p
+ *    Array of srTCM profiles, one per packet
+ * @param time
+ *    Current CPU time stamp (measured in CPU cycles)
+ * @param pkt_len
+ *    Array of IP packet lengths (measured in bytes)
+ * @param color
+ *    Array of packet colors: input color on entry, assigned color on return
+ * @param n_pkts
+ *    Number of packets in the burst
+ */
+void
+rte_meter_srtcm_color_aware_check_bulk(struct rte_meter_srtcm_rt **m,
+	struct rte_meter_srtcm_profile **p,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *color,
+	uint32_t n_pkts);
+
+/**
+ * trTCM color blind traffic metering for a burst of packets
+ *
+ * @param m
+ *    Array of handles to trTCM run-time instances, one per packet
+ * @param p
+ *    Array of trTCM profiles, one per packet
+ * @param time
+ *    Current CPU time stamp (measured in CPU cycles)
+ * @param pkt_len
+ *    Array of IP packet lengths (measured in bytes)
+ * @param color
+ *    Array populated with the color assigned to each packet
+ * @param n_pkts
+ *    Number of packets in the burst
+ */
+void
+rte_meter_trtcm_color_blind_check_bulk(struct rte_meter_trtcm_rt **m,
+	struct rte_meter_trtcm_profile **p,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *color,
+	uint32_t n_pkts);
+
+/**
+ * trTCM color aware traffic metering for a burst of packets
+ *
+ * @param m
+ *    Array of handles to trTCM run-time instances, one per packet
+ * @param p
+ *    Array of trTCM profiles, one per packet
+ * @param time
+ *    Current CPU time stamp (measured in CPU cycles)
+ * @param pkt_len
+ *    Array of IP packet lengths (measured in bytes)
+ * @param color
+ *    Array of packet colors: input color on entry, assigned color on return
+ * @param n_pkts
+ *    Number of packets in the burst
+ */
+void
+rte_meter_trtcm_color_aware_check_bulk(struct rte_meter_trtcm_rt **m,
+	struct rte_meter_trtcm_profile **p,
+	uint64_t time,
+	const uint32_t *pkt_len,
+	enum rte_meter_color *color,
+	uint32_t n_pkts);
+
 /*
  * Inline implementation of run-time methods
  *
@@ -220,6 +488,39 @@ struct rte_meter_trtcm {
 	uint64_t pir_bytes_per_period; /* Number of bytes to add to P token bucket on each update */
 };
 
+/* Internal data structure storing the srTCM configuration profile. */
+struct rte_meter_srtcm_profile {
+	uint64_t cbs;  /* Upper limit for C token bucket */
+	uint64_t ebs;  /* Upper limit for E token bucket */
+	uint64_t cir_period; /* Number of CPU cycles for one update of C and E token buckets */
+	uint64_t cir_bytes_per_period; /* Number of bytes to add to C and E token buckets on each update */
+};
+
+/* Internal data structure storing the trTCM configuration profile. */
+struct rte_meter_trtcm_profile {
+	uint64_t cbs;     /* Upper limit for C token bucket */
+	uint64_t pbs;     /* Upper limit for P token bucket */
+	uint64_t cir_period; /* Number of CPU cycles for one update of C token bucket */
+	uint64_t cir_bytes_per_period; /* Number of bytes to add to C token bucket on each update */
+	uint64_t pir_period; /* Number of CPU cycles for one update of P token bucket */
+	uint64_t pir_bytes_per_period; /* Number of bytes to add to P token bucket on each update */
+};
+
+/* Internal data structure storing the profile based srTCM run-time context per metered traffic flow. */
+struct rte_meter_srtcm_rt {
+	uint64_t time; /* Time of latest update of C and E token buckets */
+	uint64_t tc;   /* Number of bytes currently available in the committed (C) token bucket */
+	uint64_t te;   /* Number of bytes currently available in the excess (E) token bucket */
+};
+
+/* Internal data structure storing the profile based trTCM run-time context per metered traffic flow. */
+struct rte_meter_trtcm_rt {
+	uint64_t time_tc; /* Time of latest update of C token bucket */
+	uint64_t time_tp; /* Time of latest update of P token bucket */
+	uint64_t tc;      /* Number of bytes currently available in the committed (C) token bucket */
+	uint64_t tp;      /* Number of bytes currently available in the peak (P) token bucket */
+};
+
 static inline enum rte_meter_color
 rte_meter_srtcm_color_blind_check(struct rte_meter_srtcm *m,
 	uint64_t time,
@@ -384,6 +685,174 @@ rte_meter_trtcm_color_aware_check(struct rte_meter_trtcm *m,
 	return e_RTE_METER_GREEN;
 }
 
+static inline enum rte_meter_color
+rte_meter_srtcm_rt_color_blind_check(struct rte_meter_srtcm_rt *m,
+	struct rte_meter_srtcm_profile *p,
+	uint64_t time,
+	uint32_t pkt_len)
+{
+	uint64_t time_diff, n_periods, tc, te;
+
+	/* Bucket update */
+	time_diff = time - m->time;
+	n_periods = time_diff / p->cir_period;
+	m->time += n_periods * p->cir_period;
+
+	/* Put the tokens overflowing from tc into te bucket */
+	tc = m->tc + n_periods * p->cir_bytes_per_period;
+	te = m->te;
+	if (tc > p->cbs) {
+		te += (tc - p->cbs);
+		if (te > p->ebs)
+			te = p->ebs;
+		tc = p->cbs;
+	}
+
+	/* Color logic */
+	if (tc >= pkt_len) {
+		m->tc = tc - pkt_len;
+		m->te = te;
+		return e_RTE_METER_GREEN;
+	}
+
+	if (te >= pkt_len) {
+		m->tc = tc;
+		m->te = te - pkt_len;
+		return e_RTE_METER_YELLOW;
+	}
+
+	m->tc = tc;
+	m->te = te;
+	return e_RTE_METER_RED;
+}
+
+static inline enum rte_meter_color
+rte_meter_srtcm_rt_color_aware_check(struct rte_meter_srtcm_rt *m,
+	struct rte_meter_srtcm_profile *p,
+	uint64_t time,
+	uint32_t pkt_len,
+	enum rte_meter_color pkt_color)
+{
+	uint64_t time_diff, n_periods, tc, te;
+
+	/* Bucket update */
+	time_diff = time - m->time;
+	n_periods = time_diff / p->cir_period;
+	m->time += n_periods * p->cir_period;
+
+	/* Put the tokens overflowing from tc into te bucket */
+	tc = m->tc + n_periods * p->cir_bytes_per_period;
+	te = m->te;
+	if (tc > p->cbs) {
+		te += (tc - p->cbs);
+		if (te > p->ebs)
+			te = p->ebs;
+		tc = p->cbs;
+	}
+
+	/* Color logic */
+	if ((pkt_color == e_RTE_METER_GREEN) && (tc >= pkt_len)) {
+		m->tc = tc - pkt_len;
+		m->te = te;
+		return e_RTE_METER_GREEN;
+	}
+
+	if ((pkt_color != e_RTE_METER_RED) && (te >= pkt_len)) {
+		m->tc = tc;
+		m->te = te - pkt_len;
+		return e_RTE_METER_YELLOW;
+	}
+
+	m->tc = tc;
+	m->te = te;
+	return e_RTE_METER_RED;
+}
+
+static inline enum rte_meter_color
+rte_meter_trtcm_rt_color_blind_check(struct rte_meter_trtcm_rt *m,
+	struct rte_meter_trtcm_profile *p,
+	uint64_t time,
+	uint32_t pkt_len)
+{
+	uint64_t time_diff_tc, time_diff_tp, n_periods_tc, n_periods_tp, tc, tp;
+
+	/* Bucket update */
+	time_diff_tc = time - m->time_tc;
+	time_diff_tp = time - m->time_tp;
+	n_periods_tc = time_diff_tc / p->cir_period;
+	n_periods_tp = time_diff_tp / p->pir_period;
+	m->time_tc += n_periods_tc * p->cir_period;
+	m->time_tp += n_periods_tp * p->pir_period;
+
+	tc = m->tc + n_periods_tc * p->cir_bytes_per_period;
+	if (tc > p->cbs)
+		tc = p->cbs;
+
+	tp = m->tp + n_periods_tp * p->pir_bytes_per_period;
+	if (tp > p->pbs)
+		tp = p->pbs;
+
+	/* Color logic */
+	if (tp < pkt_len) {
+		m->tc = tc;
+		m->tp = tp;
+		return e_RTE_METER_RED;
+	}
+
+	if (tc < pkt_len) {
+		m->tc = tc;
+		m->tp = tp - pkt_len;
+		return e_RTE_METER_YELLOW;
+	}
+
+	m->tc = tc - pkt_len;
+	m->tp = tp - pkt_len;
+	return e_RTE_METER_GREEN;
+}
+
+static inline enum rte_meter_color
+rte_meter_trtcm_rt_color_aware_check(struct rte_meter_trtcm_rt *m,
+	struct rte_meter_trtcm_profile *p,
+	uint64_t time,
+	uint32_t pkt_len,
+	enum rte_meter_color pkt_color)
+{
+	uint64_t time_diff_tc, time_diff_tp, n_periods_tc, n_periods_tp, tc, tp;
+
+	/* Bucket update */
+	time_diff_tc = time - m->time_tc;
+	time_diff_tp = time - m->time_tp;
+	n_periods_tc = time_diff_tc / p->cir_period;
+	n_periods_tp = time_diff_tp / p->pir_period;
+	m->time_tc += n_periods_tc * p->cir_period;
+	m->time_tp += n_periods_tp * p->pir_period;
+
+	tc = m->tc + n_periods_tc * p->cir_bytes_per_period;
+	if (tc > p->cbs)
+		tc = p->cbs;
+
+	tp = m->tp + n_periods_tp * p->pir_bytes_per_period;
+	if (tp > p->pbs)
+		tp = p->pbs;
+
+	/* Color logic */
+	if ((pkt_color == e_RTE_METER_RED) || (tp < pkt_len)) {
+		m->tc = tc;
+		m->tp = tp;
+		return e_RTE_METER_RED;
+	}
+
+	if ((pkt_color == e_RTE_METER_YELLOW) || (tc < pkt_len)) {
+		m->tc = tc;
+		m->tp = tp - pkt_len;
+		return e_RTE_METER_YELLOW;
+	}
+
+	m->tc = tc - pkt_len;
+	m->tp = tp - pkt_len;
+	return e_RTE_METER_GREEN;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,401 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <rte_common.h>
+#include <rte_eal.h>
+#include <rte_log.h>
+#include <rte_lcore.h>
+#include <rte_memzone.h>
+#include <rte_spinlock.h>
+#include <rte_atomic.h>
+
+#include "rte_metrics.h"
+
+/* registered metric */
+struct metrics_meta {
+	char name[RTE_METRICS_MAX_NAME_LEN];
+	enum rte_metric_type type;
+};
+
+/* content of the memzone shared by the processes */
+struct metrics_data {
+	rte_spinlock_t lock;       /* protects the registration */
+	uint16_t cnt;              /* number of metrics */
+	struct metrics_meta meta[RTE_METRICS_MAX_METRICS];
+	uint64_t gauges[RTE_METRICS_MAX_METRICS];
+	/* one row per lcore, and one for the non-EAL threads */
+	struct rte_metrics_lcore lcores[RTE_MAX_LCORE + 1];
+};
+
+struct rte_metrics_lcore *rte_metrics_lcores;
+
+static int metrics_logtype = RTE_LOGTYPE_USER1;
+
+#define METRICS_LOG(level, fmt, args...) \
+	rte_log(RTE_LOG_ ## level, metrics_logtype, "METRICS: " fmt, ## args)
+
+static struct metrics_data *metrics;
+
+static int metrics_sock = -1;
+static volatile int metrics_sock_stopping;
+static pthread_t metrics_sock_thread;
+static char metrics_sock_path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+
+static void __attribute__((constructor))
+metrics_log_init(void)
+{
+	int ret = rte_log_register("lib.metrics");
+
+	if (ret >= 0)
+		metrics_logtype = ret;
+}
+
+int
+rte_metrics_init(int socket_id)
+{
+	const struct rte_memzone *mz;
+
+	if (metrics != NULL)
+		return 0;
+
+	mz = rte_memzone_lookup(RTE_METRICS_MZ_NAME);
+	if (mz == NULL) {
+		if (rte_eal_process_type() != RTE_PROC_PRIMARY)
+			return -ENOENT;
+		mz = rte_memzone_reserve(RTE_METRICS_MZ_NAME,
+			sizeof(struct metrics_data), socket_id, 0);
+		if (mz == NULL) {
+			METRICS_LOG(ERR, "Cannot reserve memzone\n");
+			return -ENOMEM;
+		}
+		memset(mz->addr, 0, sizeof(struct metrics_data));
+		rte_spinlock_init(&((struct metrics_data *)mz->addr)->lock);
+	}
+
+	metrics = mz->addr;
+	rte_metrics_lcores = metrics->lcores;
+	return 0;
+}
+
+static int
+metrics_name_valid(const char *name)
+{
+	size_t len;
+	size_t i;
+
+	if (name == NULL)
+		return 0;
+	len = strnlen(name, RTE_METRICS_MAX_NAME_LEN);
+	if (len == 0 || len == RTE_METRICS_MAX_NAME_LEN)
+		return 0;
+	/* the name is written as is in JSON */
+	for (i = 0; i < len; i++)
+		if (name[i] == '"' || name[i] == '\\' ||
+				(unsigned char)name[i] < 0x20)
+			return 0;
+	return 1;
+}
+
+static int
+metrics_lookup(const char *name)
+{
+	uint16_t i;
+
+	for (i = 0; i < metrics->cnt; i++)
+		if (strcmp(metrics->meta[i].name, name) == 0)
+			return i;
+	return -1;
+}
+
+/* register valid names, with the lock held */
+static int
+metrics_reg_names(const char * const *names, uint16_t cnt,
+		enum rte_metric_type type)
+{
+	unsigned int lcore_id;
+	uint16_t i, key;
+
+	if (cnt > RTE_METRICS_MAX_METRICS - metrics->cnt)
+		return -ENOSPC;
+	for (i = 0; i < cnt; i++)
+		if (metrics_lookup(names[i]) >= 0)
+			return -EINVAL;
+
+	key = metrics->cnt;
+	for (i = 0; i < cnt; i++) {
+		snprintf(metrics->meta[key + i].name,
+			sizeof(metrics->meta[key + i].name), "%s", names[i]);
+		metrics->meta[key + i].type = type;
+		metrics->gauges[key + i] = 0;
+		for (lcore_id = 0; lcore_id <= RTE_MAX_LCORE; lcore_id++)
+			metrics->lcores[lcore_id].values[key + i] = 0;
+	}
+	/* the readers see the new metrics once initialized */
+	rte_smp_wmb();
+	metrics->cnt = key + cnt;
+
+	return key;
+}
+
+int
+rte_metrics_reg_name(const char *name, enum rte_metric_type type)
+{
+	int key;
+
+	if (metrics == NULL)
+		return -EIO;
+	if (!metrics_name_valid(name))
+		return -EINVAL;
+
+	rte_spinlock_lock(&metrics->lock);
+	key = metrics_lookup(name);
+	if (key < 0)
+		key = metrics_reg_names(&name, 1, type);
+	else if (metrics->meta[key].type != type)
+		key = -EINVAL;
+	rte_spinlock_unlock(&metrics->lock);
+
+	return key;
+}
+
+int
+rte_metrics_reg_names(const char * const *names, uint16_t cnt,
+		enum rte_metric_type type)
+{
+	uint16_t i;
+	int key;
+
+	if (metrics == NULL)
+		return -EIO;
+	if (names == NULL || cnt == 0)
+		return -EINVAL;
+	for (i = 0; i < cnt; i++)
+		if (!metrics_name_valid(names[i]))
+			return -EINVAL;
+
+	rte_spinlock_lock(&metrics->lock);
+	key = metrics_reg_names(names, cnt, type);
+	rte_spinlock_unlock(&metrics->lock);
+
+	return key;
+}
+
+int
+rte_metrics_gauge_set(uint16_t key, uint64_t value)
+{
+	if (metrics == NULL)
+		return -EIO;
+	if (key >= metrics->cnt || metrics->meta[key].type != RTE_METRIC_GAUGE)
+		return -EINVAL;
+
+	metrics->gauges[key] = value;
+	return 0;
+}
+
+int
+rte_metrics_get_names(struct rte_metric_name *names, uint16_t capacity)
+{
+	uint16_t cnt, i;
+
+	if (metrics == NULL)
+		return -EIO;
+
+	cnt = metrics->cnt;
+	rte_smp_rmb();
+	if (names == NULL || capacity < cnt)
+		return cnt;
+
+	for (i = 0; i < cnt; i++)
+		snprintf(names[i].name, sizeof(names[i].name), "%s",
+			metrics->meta[i].name);
+	return cnt;
+}
+
+static uint64_t
+metrics_value(uint16_t key)
+{
+	unsigned int lcore_id;
+	uint64_t sum = 0;
+
+	if (metrics->meta[key].type == RTE_METRIC_GAUGE)
+		return metrics->gauges[key];
+
+	for (lcore_id = 0; lcore_id <= RTE_MAX_LCORE; lcore_id++)
+		sum += ((volatile uint64_t *)
+			metrics->lcores[lcore_id].values)[key];
+	return sum;
+}
+
+int
+rte_metrics_get_values(struct rte_metric_value *values, uint16_t capacity)
+{
+	uint16_t cnt, i;
+
+	if (metrics == NULL)
+		return -EIO;
+
+	cnt = metrics->cnt;
+	rte_smp_rmb();
+	if (values == NULL || capacity < cnt)
+		return cnt;
+
+	for (i = 0; i < cnt; i++) {
+		values[i].key = i;
+		values[i].value = metrics_value(i);
+	}
+	return cnt;
+}
+
+int
+rte_metrics_json_write(FILE *f)
+{
+	uint16_t cnt, i;
+
+	if (metrics == NULL)
+		return -EIO;
+
+	cnt = metrics->cnt;
+	rte_smp_rmb();
+	fprintf(f, "{");
+	for (i = 0; i < cnt; i++)
+		fprintf(f, "%s\"%s\":%" PRIu64, i == 0 ? "" : ",",
+			metrics->meta[i].name, metrics_value(i));
+	fprintf(f, "}\n");
+
+	return ferror(f) ? -EIO : 0;
+}
+
+/* write the metrics to each client of the socket */
+static void *
+metrics_sock_loop(void *arg __rte_unused)
+{
+	char *buf;
+	size_t len, off;
+	ssize_t ret;
+	FILE *f;
+	int fd;
+
+	while (!metrics_sock_stopping) {
+		fd = accept(metrics_sock, NULL, NULL);
+		if (fd < 0) {
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			break;
+		}
+
+		buf = NULL;
+		len = 0;
+		f = open_memstream(&buf, &len);
+		if (f != NULL) {
+			rte_metrics_json_write(f);
+			fclose(f);
+			for (off = 0; off < len; off += ret) {
+				ret = write(fd, buf + off, len - off);
+				if (ret <= 0)
+					break;
+			}
+			free(buf);
+		}
+		close(fd);
+	}
+	return NULL;
+}
+
+int
+rte_metrics_socket_start(const char *path)
+{
+	struct sockaddr_un addr;
+	int ret;
+
+	if (metrics_sock >= 0)
+		return -EBUSY;
+	if (path == NULL || strlen(path) >= sizeof(addr.sun_path))
+		return -EINVAL;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+
+	metrics_sock = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (metrics_sock < 0)
+		return -errno;
+	metrics_sock_stopping = 0;
+	unlink(path);
+	if (bind(metrics_sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+			listen(metrics_sock, 8) < 0) {
+		ret = -errno;
+		goto error;
+	}
+
+	ret = -pthread_create(&metrics_sock_thread, NULL,
+		metrics_sock_loop, NULL);
+	if (ret < 0) {
+		unlink(path);
+		goto error;
+	}
+	rte_thread_setname(metrics_sock_thread, "metrics-sock");
+	snprintf(metrics_sock_path, sizeof(metrics_sock_path), "%s", path);
+	return 0;
+
+error:
+	METRICS_LOG(ERR, "Cannot serve metrics on %s: %s\n",
+		path, strerror(-ret));
+	close(metrics_sock);
+	metrics_sock = -1;
+	return ret;
+}
+
+void
+rte_metrics_socket_stop(void)
+{
+	if (metrics_sock < 0)
+		return;
+
+	/* wake up the thread blocked in accept(), which then exits */
+	metrics_sock_stopping = 1;
+	shutdown(metrics_sock, SHUT_RDWR);
+	pthread_join(metrics_sock_thread, NULL);
+	close(metrics_sock);
+	metrics_sock = -1;
+	unlink(metrics_sock_path);
+}
@@ -0,0 +1,250 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _RTE_METRICS_H_
+#define _RTE_METRICS_H_
+
+/**
+ * @file
+ *
+ * RTE Metrics
+ *
+ * The libraries, drivers and applications register named metrics, which
+ * are kept in a memzone shared with the secondary processes, so that a
+ * collector like dpdk-procinfo can read them without calling into the
+ * application.
+ *
+ * A metric is either a counter or a gauge. A counter is incremented by the
+ * lcores in the fast path: each lcore adds to its own copy without atomic
+ * operation, and the readers sum the copies. A gauge is set to a value from
+ * the control path.
+ *
+ * The metrics can also be read as a JSON object, written to a stream or
+ * served on a UNIX socket.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <rte_common.h>
+#include <rte_lcore.h>
+#include <rte_branch_prediction.h>
+
+/** Maximum number of metrics. */
+#define RTE_METRICS_MAX_METRICS 256
+
+/** Maximum length of a metric name, including the terminating '\0'. */
+#define RTE_METRICS_MAX_NAME_LEN 64
+
+/** Name of the memzone of the metrics. */
+#define RTE_METRICS_MZ_NAME "RTE_METRICS"
+
+/** Type of a metric. */
+enum rte_metric_type {
+	RTE_METRIC_COUNTER, /**< Sum of per-lcore increments. */
+	RTE_METRIC_GAUGE,   /**< Value set by rte_metrics_gauge_set(). */
+};
+
+/** Name of a metric, returned by rte_metrics_get_names(). */
+struct rte_metric_name {
+	char name[RTE_METRICS_MAX_NAME_LEN]; /**< Name of the metric. */
+};
+
+/** Value of a metric, returned by rte_metrics_get_values(). */
+struct rte_metric_value {
+	uint16_t key;   /**< Key of the metric, index in the names. */
+	uint64_t value; /**< Value of the metric. */
+};
+
+/**
+ * @internal Counters of one lcore. The last row of rte_metrics_lcores is
+ * shared by the non-EAL threads, which update it atomically.
+ */
+struct rte_metrics_lcore {
+	uint64_t values[RTE_METRICS_MAX_METRICS];
+} __rte_cache_aligned;
+
+/** @internal Counters of the lcores, set by rte_metrics_init(). */
+extern struct rte_metrics_lcore *rte_metrics_lcores;
+
+/**
+ * Initialize the metrics. The primary process reserves the memzone
+ * of the metrics, and the secondary processes attach to it.
+ *
+ * @param socket_id
+ *   The socket of the memzone, or SOCKET_ID_ANY.
+ * @return
+ *   - 0: Success.
+ *   - -ENOENT: The primary process has not initialized the metrics.
+ *   - -ENOMEM: The memzone cannot be reserved.
+ */
+int rte_metrics_init(int socket_id);
+
+/**
+ * Register a metric. Registering again the name of a metric of the same
+ * type returns its key.
+ *
+ * @param name
+ *   The name of the metric, without quote, backslash or control character.
+ * @param type
+ *   The type of the metric.
+ * @return
+ *   - >=0: The key of the metric.
+ *   - -EINVAL: Invalid name, or name registered with another type.
+ *   - -ENOSPC: No more space for metrics.
+ *   - -EIO: The metrics are not initialized.
+ */
+int rte_metrics_reg_name(const char *name, enum rte_metric_type type);
+
+/**
+ * Register several metrics of the same type, which get consecutive keys.
+ *
+ * @param names
+ *   The names of the metrics.
+ * @param cnt
+ *   The number of metrics.
+ * @param type
+ *   The type of the metrics.
+ * @return
+ *   - >=0: The key of the first metric.
+ *   - -EINVAL: Invalid name, or one of the names is already registered.
+ *   - -ENOSPC: No more space for metrics.
+ *   - -EIO: The metrics are not initialized.
+ */
+int rte_metrics_reg_names(const char * const *names, uint16_t cnt,
+		enum rte_metric_type type);
+
+/**
+ * Add to a counter. On an EAL lcore, the addition is a plain store in the
+ * copy of the lcore; on other threads, it is atomic.
+ *
+ * The key must be a registered counter.
+ *
+ * @param key
+ *   The key of the counter.
+ * @param n
+ *   The value to add.
+ */
+static inline void
+rte_metrics_counter_add(uint16_t key, uint64_t n)
+{
+	unsigned int lcore_id = rte_lcore_id();
+
+	if (likely(lcore_id < RTE_MAX_LCORE))
+		rte_metrics_lcores[lcore_id].values[key] += n;
+	else
+		__sync_fetch_and_add(
+			&rte_metrics_lcores[RTE_MAX_LCORE].values[key], n);
+}
+
+/**
+ * Set the value of a gauge.
+ *
+ * @param key
+ *   The key of the gauge.
+ * @param value
+ *   The new value.
+ * @return
+ *   0 on success, -EINVAL if the key is not a gauge, -EIO if the metrics
+ *   are not initialized.
+ */
+int rte_metrics_gauge_set(uint16_t key, uint64_t value);
+
+/**
+ * Get the names of the metrics, indexed by key.
+ *
+ * @param names
+ *   An array filled with the names, or NULL to get the number of metrics.
+ * @param capacity
+ *   The size of the array.
+ * @return
+ *   The number of metrics, which is larger than capacity if the array is
+ *   too small and was not filled, or -EIO if the metrics are not
+ *   initialized.
+ */
+int rte_metrics_get_names(struct rte_metric_name *names, uint16_t capacity);
+
+/**
+ * Get the values of the metrics, the counters summed over the lcores.
+ * The values are read without stopping the writers.
+ *
+ * @param values
+ *   An array filled with the values, or NULL to get the number of metrics.
+ * @param capacity
+ *   The size of the array.
+ * @return
+ *   The number of metrics, which is larger than capacity if the array is
+ *   too small and was not filled, or -EIO if the metrics are not
+ *   initialized.
+ */
+int rte_metrics_get_values(struct rte_metric_value *values,
+		uint16_t capacity);
+
+/**
+ * Write the metrics as a JSON object, with a member per metric.
+ *
+ * @param f
+ *   The output stream.
+ * @return
+ *   0 on success, -EIO on error.
+ */
+int rte_metrics_json_write(FILE *f);
+
+/**
+ * Serve the metrics on a UNIX stream socket: a thread writes the JSON
+ * object of the metrics to each client, then closes the connection.
+ * The path is removed and created again.
+ *
+ * @param path
+ *   The path of the socket.
+ * @return
+ *   - 0: Success.
+ *   - -EBUSY: The metrics are already served.
+ *   - -EINVAL: Invalid path.
+ *   - Other negative errno values on socket or thread errors.
+ */
+int rte_metrics_socket_start(const char *path);
+
+/**
+ * Stop serving the metrics on the UNIX socket, and remove it.
+ */
+void rte_metrics_socket_stop(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RTE_METRICS_H_ */
@@ -196,6 +196,64 @@ rte_net_intel_cksum_prepare(struct rte_mbuf *m)
 	return rte_net_intel_cksum_flags_prepare(m, m->ol_flags);
 }
 
+/**
+ * TX offload flags applied by rte_net_sw_tx_offload().
+ */
+#define RTE_NET_SW_TX_OFFLOAD_MASK (PKT_TX_VLAN_PKT | PKT_TX_IP_CKSUM | \
+		PKT_TX_L4_MASK | PKT_TX_TCP_SEG)
+
+/**
+ * The DEV_TX_OFFLOAD_* capabilities a PMD gains by calling
+ * rte_net_sw_tx_offload() from its transmit function. It needs rte_ethdev.h.
+ */
+#define RTE_NET_SW_TX_OFFLOAD_CAPA (DEV_TX_OFFLOAD_VLAN_INSERT | \
+		DEV_TX_OFFLOAD_IPV4_CKSUM | DEV_TX_OFFLOAD_UDP_CKSUM | \
+		DEV_TX_OFFLOAD_TCP_CKSUM | DEV_TX_OFFLOAD_TCP_TSO)
+
+/**
+ * A size for the pkts array of rte_net_sw_tx_offload(), enough for a 64KB
+ * TSO packet with a segment size of 1KB or more.
+ */
+#define RTE_NET_SW_TX_MAX_PKTS 64
+
+/**
+ * Apply the TX offloads requested in a packet in software.
+ *
+ * This function lets a PMD without offload support honour the
+ * PKT_TX_VLAN_PKT, PKT_TX_IP_CKSUM, PKT_TX_TCP_CKSUM, PKT_TX_UDP_CKSUM and
+ * PKT_TX_TCP_SEG flags, using the l2_len, l3_len, l4_len, tso_segsz and
+ * vlan_tci fields of the mbuf as a NIC would. It is meant to be called from
+ * the tx_pkt_burst function on the packets having any
+ * RTE_NET_SW_TX_OFFLOAD_MASK flag set.
+ *
+ * A TSO packet is cut into as many packets as needed. Each of them is made
+ * of a new mbuf holding a copy of the headers, chained to indirect mbufs
+ * pointing to the payload of the original packet. The same split is used
+ * with a single segment when the headers of a packet cannot be modified in
+ * place, because its first segment is indirect or shared. The new mbufs are
+ * allocated from the pool of the packet.
+ *
+ * The headers must be contiguous in the first segment. Tunnel offloads are
+ * not supported.
+ *
+ * @param m
+ *   The packet to process. On success, its reference is passed on to the
+ *   returned packets. On failure, it is left to the caller.
+ * @param pkts
+ *   An array where the packets to send in place of m are stored, with the
+ *   offload flags they were processed for cleared.
+ * @param nb_pkts
+ *   The size of the pkts array.
+ * @return
+ *   - The number of packets stored in pkts, at least 1, on success.
+ *   - -EINVAL if the packet headers do not match the offload request.
+ *   - -ENOTSUP if an offload is not supported.
+ *   - -ENOSPC if pkts is too small for all the TSO segments.
+ *   - -ENOMEM if an mbuf could not be allocated.
+ */
+int rte_net_sw_tx_offload(struct rte_mbuf *m, struct rte_mbuf **pkts,
+	uint16_t nb_pkts);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,297 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <rte_mbuf.h>
+#include <rte_byteorder.h>
+#include <rte_ether.h>
+#include <rte_ip.h>
+#include <rte_tcp.h>
+#include <rte_udp.h>
+#include <rte_net.h>
+
+/* TCP flags a TSO segment inherits only when it is the first or last one */
+#define TCP_FIN_FLAG 0x01
+#define TCP_PSH_FLAG 0x08
+#define TCP_CWR_FLAG 0x80
+
+/* Compute the IPv4 header and the TCP or UDP checksums of a packet whose
+ * headers are in its first segment.
+ */
+static int
+sw_tx_cksum(struct rte_mbuf *m, uint64_t ol_flags)
+{
+	uint64_t l4_cksum = ol_flags & PKT_TX_L4_MASK;
+	uint32_t l4_off = m->l2_len + m->l3_len;
+	struct ipv4_hdr *ip4;
+	struct ipv6_hdr *ip6;
+	uint16_t *cksum, raw;
+	uint32_t l4_len, sum;
+	uint8_t proto;
+
+	ip4 = rte_pktmbuf_mtod_offset(m, struct ipv4_hdr *, m->l2_len);
+	ip6 = (struct ipv6_hdr *)ip4;
+
+	if (ol_flags & PKT_TX_IPV4) {
+		if (ol_flags & PKT_TX_IP_CKSUM) {
+			ip4->hdr_checksum = 0;
+			raw = rte_raw_cksum(ip4, m->l3_len);
+			ip4->hdr_checksum = (raw == 0xffff) ? raw : ~raw;
+		}
+		if (l4_cksum == 0)
+			return 0;
+		l4_len = rte_be_to_cpu_16(ip4->total_length) - m->l3_len;
+		sum = __rte_raw_cksum_reduce(__rte_raw_cksum(&ip4->src_addr,
+				2 * sizeof(uint32_t), 0));
+	} else if (ol_flags & PKT_TX_IPV6) {
+		if (l4_cksum == 0)
+			return 0;
+		l4_len = rte_be_to_cpu_16(ip6->payload_len) +
+			sizeof(struct ipv6_hdr) - m->l3_len;
+		sum = __rte_raw_cksum_reduce(__rte_raw_cksum(ip6->src_addr,
+			sizeof(ip6->src_addr) + sizeof(ip6->dst_addr), 0));
+	} else {
+		return (ol_flags & PKT_TX_IP_CKSUM) || l4_cksum ? -EINVAL : 0;
+	}
+
+	if (unlikely(l4_len > UINT16_MAX ||
+		     l4_off + l4_len > rte_pktmbuf_pkt_len(m)))
+		return -EINVAL;
+
+	if (l4_cksum == PKT_TX_TCP_CKSUM) {
+		cksum = &rte_pktmbuf_mtod_offset(m, struct tcp_hdr *,
+						 l4_off)->cksum;
+		proto = IPPROTO_TCP;
+	} else {
+		cksum = &rte_pktmbuf_mtod_offset(m, struct udp_hdr *,
+						 l4_off)->dgram_cksum;
+		proto = IPPROTO_UDP;
+	}
+
+	/* pseudo header, then the L4 header and payload */
+	sum += rte_cpu_to_be_16((uint16_t)proto);
+	sum += rte_cpu_to_be_16((uint16_t)l4_len);
+	*cksum = 0;
+	rte_raw_cksum_mbuf(m, l4_off, l4_len, &raw);
+	sum = __rte_raw_cksum_reduce(sum + raw);
+	*cksum = (sum == 0xffff) ? sum : (uint16_t)~sum;
+
+	return 0;
+}
+
+/* Rewrite the headers of the i-th of nb TSO segments */
+static void
+sw_tx_tso_fix(struct rte_mbuf *m, uint64_t ol_flags, uint32_t hdr_len,
+	uint16_t i, uint16_t nb)
+{
+	uint32_t payload = rte_pktmbuf_pkt_len(m) - hdr_len;
+	struct ipv4_hdr *ip4;
+	struct ipv6_hdr *ip6;
+	struct tcp_hdr *tcp;
+
+	ip4 = rte_pktmbuf_mtod_offset(m, struct ipv4_hdr *, m->l2_len);
+	ip6 = (struct ipv6_hdr *)ip4;
+	tcp = rte_pktmbuf_mtod_offset(m, struct tcp_hdr *,
+				      m->l2_len + m->l3_len);
+
+	if (ol_flags & PKT_TX_IPV4) {
+		ip4->total_length = rte_cpu_to_be_16(m->l3_len + m->l4_len +
+						     payload);
+		ip4->packet_id = rte_cpu_to_be_16(
+			rte_be_to_cpu_16(ip4->packet_id) + i);
+	} else {
+		ip6->payload_len = rte_cpu_to_be_16(m->l3_len -
+			sizeof(struct ipv6_hdr) + m->l4_len + payload);
+	}
+
+	tcp->sent_seq = rte_cpu_to_be_32(rte_be_to_cpu_32(tcp->sent_seq) +
+					 (uint32_t)i * m->tso_segsz);
+	if (i != nb - 1)
+		tcp->tcp_flags &= ~(TCP_FIN_FLAG | TCP_PSH_FLAG);
+	if (i != 0)
+		tcp->tcp_flags &= ~TCP_CWR_FLAG;
+}
+
+/* Cut a packet into packets of hdr_len bytes of copied headers followed by
+ * up to seg_size bytes of its payload, chained as indirect mbufs. The
+ * packet itself is not released.
+ */
+static int
+sw_tx_split(struct rte_mbuf *m, uint32_t hdr_len, uint32_t seg_size,
+	struct rte_mbuf **pkts, uint16_t nb_pkts)
+{
+	uint32_t payload = rte_pktmbuf_pkt_len(m) - hdr_len;
+	struct rte_mbuf *hdr, *tail, *seg, *mi;
+	uint32_t off, len, piece;
+	uint16_t i, j, nb;
+	char *data;
+
+	nb = (payload == 0) ? 1 : (payload + seg_size - 1) / seg_size;
+	if (nb > nb_pkts)
+		return -ENOSPC;
+
+	for (i = 0; i < nb; i++) {
+		hdr = rte_pktmbuf_alloc(m->pool);
+		pkts[i] = hdr;
+		if (unlikely(hdr == NULL))
+			goto nomem;
+
+		data = rte_pktmbuf_append(hdr, hdr_len);
+		if (unlikely(data == NULL))
+			goto nomem;
+		rte_memcpy(data, rte_pktmbuf_mtod(m, void *), hdr_len);
+		hdr->port = m->port;
+		hdr->vlan_tci = m->vlan_tci;
+		hdr->vlan_tci_outer = m->vlan_tci_outer;
+		hdr->tx_offload = m->tx_offload;
+		hdr->packet_type = m->packet_type;
+		hdr->ol_flags = m->ol_flags;
+
+		/* find where the payload of this segment starts */
+		off = hdr_len + i * seg_size;
+		len = RTE_MIN(seg_size, rte_pktmbuf_pkt_len(m) - off);
+		if (len == 0)
+			continue; /* headers only */
+		for (seg = m; off >= seg->data_len; seg = seg->next)
+			off -= seg->data_len;
+
+		for (tail = hdr; len != 0; seg = seg->next, off = 0) {
+			piece = RTE_MIN(len, seg->data_len - off);
+			if (piece == 0)
+				continue;
+			mi = rte_pktmbuf_alloc(m->pool);
+			if (unlikely(mi == NULL))
+				goto nomem;
+			rte_pktmbuf_attach(mi, seg);
+			mi->data_off += off;
+			mi->data_len = piece;
+			mi->pkt_len = piece;
+			tail->next = mi;
+			tail = mi;
+			hdr->nb_segs++;
+			hdr->pkt_len += piece;
+			len -= piece;
+		}
+	}
+
+	return nb;
+
+nomem:
+	for (j = 0; j <= i; j++)
+		rte_pktmbuf_free(pkts[j]);
+	return -ENOMEM;
+}
+
+int
+rte_net_sw_tx_offload(struct rte_mbuf *m, struct rte_mbuf **pkts,
+	uint16_t nb_pkts)
+{
+	uint64_t ol_flags = m->ol_flags;
+	uint32_t hdr_len = 0, seg_size;
+	int split, nb, i, ret;
+
+	if (unlikely(nb_pkts == 0))
+		return -ENOSPC;
+
+	if (ol_flags & (PKT_TX_TUNNEL_MASK | PKT_TX_OUTER_IP_CKSUM |
+			PKT_TX_QINQ_PKT))
+		return -ENOTSUP;
+	if ((ol_flags & PKT_TX_L4_MASK) == PKT_TX_SCTP_CKSUM)
+		return -ENOTSUP;
+
+	/* TSO implies the TCP and IPv4 checksums */
+	if (ol_flags & PKT_TX_TCP_SEG) {
+		if (unlikely(m->l4_len < sizeof(struct tcp_hdr) ||
+			     m->tso_segsz == 0))
+			return -EINVAL;
+		ol_flags = (ol_flags & ~PKT_TX_L4_MASK) | PKT_TX_TCP_CKSUM;
+		if (ol_flags & PKT_TX_IPV4)
+			ol_flags |= PKT_TX_IP_CKSUM;
+		hdr_len = m->l2_len + m->l3_len + m->l4_len;
+	} else if ((ol_flags & PKT_TX_L4_MASK) == PKT_TX_TCP_CKSUM) {
+		hdr_len = m->l2_len + m->l3_len + sizeof(struct tcp_hdr);
+	} else if ((ol_flags & PKT_TX_L4_MASK) == PKT_TX_UDP_CKSUM) {
+		hdr_len = m->l2_len + m->l3_len + sizeof(struct udp_hdr);
+	} else if (ol_flags & PKT_TX_IP_CKSUM) {
+		hdr_len = m->l2_len + m->l3_len;
+	}
+	if (ol_flags & PKT_TX_VLAN_PKT)
+		hdr_len = RTE_MAX(hdr_len, (uint32_t)sizeof(struct ether_hdr));
+
+	if (unlikely(hdr_len > rte_pktmbuf_data_len(m)))
+		return -EINVAL;
+
+	/* headers are rewritten in new mbufs if they cannot be in place */
+	split = RTE_MBUF_INDIRECT(m) || rte_mbuf_refcnt_read(m) > 1;
+	if ((ol_flags & PKT_TX_TCP_SEG) &&
+	    rte_pktmbuf_pkt_len(m) - hdr_len > m->tso_segsz)
+		split = 1;
+
+	if (split) {
+		seg_size = (ol_flags & PKT_TX_TCP_SEG) ? m->tso_segsz :
+			rte_pktmbuf_pkt_len(m) - hdr_len;
+		nb = sw_tx_split(m, hdr_len, seg_size, pkts, nb_pkts);
+		if (nb < 0)
+			return nb;
+	} else {
+		pkts[0] = m;
+		nb = 1;
+	}
+
+	for (i = 0; i < nb; i++) {
+		if ((ol_flags & PKT_TX_TCP_SEG) && nb > 1)
+			sw_tx_tso_fix(pkts[i], ol_flags, hdr_len, i, nb);
+
+		ret = sw_tx_cksum(pkts[i], ol_flags);
+		if (ret == 0 && (ol_flags & PKT_TX_VLAN_PKT))
+			ret = rte_vlan_insert(&pkts[i]);
+		if (unlikely(ret < 0))
+			goto error;
+
+		pkts[i]->ol_flags &= ~RTE_NET_SW_TX_OFFLOAD_MASK;
+	}
+
+	if (split)
+		rte_pktmbuf_free(m);
+
+	return nb;
+
+error:
+	if (split) {
+		for (i = 0; i < nb; i++)
+			rte_pktmbuf_free(pkts[i]);
+	}
+	return ret;
+}
@@ -119,6 +119,7 @@ struct rte_table {
 
 	uint32_t table_next_id;
 	uint32_t table_next_id_valid;
+	uint32_t lookahead;
 
 	/* Handle to the low-level table object */
 	void *h_table;
@@ -154,12 +155,21 @@ struct rte_pipeline {
 
 	/* Pipeline run structures */
 	struct rte_mbuf *pkts[RTE_PORT_IN_BURST_SIZE_MAX];
-	struct rte_pipeline_table_entry *entries[RTE_PORT_IN_BURST_SIZE_MAX];
+	struct rte_pipeline_table_entry **entries;
 	uint64_t action_mask0[RTE_PIPELINE_ACTIONS];
 	uint64_t action_mask1[RTE_PIPELINE_ACTIONS];
 	uint64_t pkts_mask;
 	uint64_t n_pkts_ah_drop;
 	uint64_t pkts_drop_mask;
+
+	/* Packets of the current burst grouped per output port */
+	uint64_t port_out_pkts_mask[RTE_PIPELINE_PORT_OUT_MAX];
+	uint64_t ports_out_mask;
+
+	/* Lookup results of the next table, when looked up ahead */
+	struct rte_pipeline_table_entry **entries_next;
+	uint64_t lookahead_hit_mask;
+	struct rte_pipeline_table_entry *entries_buf[2][RTE_PORT_IN_BURST_SIZE_MAX];
 } __rte_cache_aligned;
 
 static inline uint32_t
@@ -257,6 +267,8 @@ rte_pipeline_create(struct rte_pipeline_params *params)
 	p->port_in_next = NULL;
 	p->pkts_mask = 0;
 	p->n_pkts_ah_drop = 0;
+	p->entries = p->entries_buf[0];
+	p->entries_next = p->entries_buf[1];
 
 	return p;
 }
@@ -413,6 +425,7 @@ rte_pipeline_table_create(struct rte_pipeline *p,
 	table->h_table = h_table;
 	table->table_next_id = 0;
 	table->table_next_id_valid = 0;
+	table->lookahead = params->lookahead;
 
 	return 0;
 }
@@ -1169,152 +1182,53 @@ rte_pipeline_action_handler_port_bulk(struct rte_pipeline *p,
 			p->pkts_mask);
 }
 
+/*
+ * The packets with action PORT or PORT_META are grouped per output port first,
+ * so each output port runs its user actions and its TX bulk function once per
+ * burst, instead of once per packet.
+ *
+ * The packets with action PORT are grouped right after the lookup of their
+ * table, as p->entries holds the lookup results of another table once the next
+ * table was looked up ahead.
+ */
 static inline void
-rte_pipeline_action_handler_port(struct rte_pipeline *p, uint64_t pkts_mask)
+rte_pipeline_action_port_group(struct rte_pipeline *p, uint64_t pkts_mask)
 {
-	p->pkts_mask = pkts_mask;
-
-	if ((pkts_mask & (pkts_mask + 1)) == 0) {
-		uint64_t n_pkts = __builtin_popcountll(pkts_mask);
-		uint32_t i;
-
-		for (i = 0; i < n_pkts; i++) {
-			struct rte_mbuf *pkt = p->pkts[i];
-			uint32_t port_out_id = p->entries[i]->port_id;
-			struct rte_port_out *port_out =
-				&p->ports_out[port_out_id];
-
-			/* Output port user actions */
-			if (port_out->f_action == NULL) /* Output port TX */
-				port_out->ops.f_tx(port_out->h_port, pkt);
-			else {
-				uint64_t pkt_mask = 1LLU << i;
-
-				port_out->f_action(p,
-					p->pkts,
-					pkt_mask,
-					port_out->arg_ah);
-
-				RTE_PIPELINE_STATS_AH_DROP_READ(p,
-					port_out->n_pkts_dropped_by_ah);
-
-				/* Output port TX */
-				if (pkt_mask & p->pkts_mask)
-					port_out->ops.f_tx(port_out->h_port,
-						pkt);
-			}
-		}
-	} else {
-		uint32_t i;
+	for ( ; pkts_mask != 0; pkts_mask &= pkts_mask - 1) {
+		uint32_t i = __builtin_ctzll(pkts_mask);
+		uint32_t port_out_id = p->entries[i]->port_id;
 
-		for (i = 0;  i < RTE_PORT_IN_BURST_SIZE_MAX; i++) {
-			uint64_t pkt_mask = 1LLU << i;
-			struct rte_mbuf *pkt;
-			struct rte_port_out *port_out;
-			uint32_t port_out_id;
-
-			if ((pkt_mask & pkts_mask) == 0)
-				continue;
-
-			pkt = p->pkts[i];
-			port_out_id = p->entries[i]->port_id;
-			port_out = &p->ports_out[port_out_id];
-
-			/* Output port user actions */
-			if (port_out->f_action == NULL) /* Output port TX */
-				port_out->ops.f_tx(port_out->h_port, pkt);
-			else {
-				port_out->f_action(p,
-					p->pkts,
-					pkt_mask,
-					port_out->arg_ah);
-
-				RTE_PIPELINE_STATS_AH_DROP_READ(p,
-					port_out->n_pkts_dropped_by_ah);
-
-				/* Output port TX */
-				if (pkt_mask & p->pkts_mask)
-					port_out->ops.f_tx(port_out->h_port,
-						pkt);
-			}
-		}
+		p->port_out_pkts_mask[port_out_id] |= 1LLU << i;
+		p->ports_out_mask |= 1LLU << port_out_id;
 	}
 }
 
 static inline void
-rte_pipeline_action_handler_port_meta(struct rte_pipeline *p,
-	uint64_t pkts_mask)
+rte_pipeline_action_handler_port(struct rte_pipeline *p,
+	uint64_t pkts_mask_port_meta)
 {
-	p->pkts_mask = pkts_mask;
-
-	if ((pkts_mask & (pkts_mask + 1)) == 0) {
-		uint64_t n_pkts = __builtin_popcountll(pkts_mask);
-		uint32_t i;
-
-		for (i = 0; i < n_pkts; i++) {
-			struct rte_mbuf *pkt = p->pkts[i];
-			uint32_t port_out_id =
-				RTE_MBUF_METADATA_UINT32(pkt,
-					p->offset_port_id);
-			struct rte_port_out *port_out = &p->ports_out[
-				port_out_id];
-
-			/* Output port user actions */
-			if (port_out->f_action == NULL) /* Output port TX */
-				port_out->ops.f_tx(port_out->h_port, pkt);
-			else {
-				uint64_t pkt_mask = 1LLU << i;
-
-				port_out->f_action(p,
-					p->pkts,
-					pkt_mask,
-					port_out->arg_ah);
-
-				RTE_PIPELINE_STATS_AH_DROP_READ(p,
-					port_out->n_pkts_dropped_by_ah);
-
-				/* Output port TX */
-				if (pkt_mask & p->pkts_mask)
-					port_out->ops.f_tx(port_out->h_port,
-						pkt);
-			}
-		}
-	} else {
-		uint32_t i;
-
-		for (i = 0;  i < RTE_PORT_IN_BURST_SIZE_MAX; i++) {
-			uint64_t pkt_mask = 1LLU << i;
-			struct rte_mbuf *pkt;
-			struct rte_port_out *port_out;
-			uint32_t port_out_id;
-
-			if ((pkt_mask & pkts_mask) == 0)
-				continue;
+	uint64_t ports_mask;
 
-			pkt = p->pkts[i];
-			port_out_id = RTE_MBUF_METADATA_UINT32(pkt,
-				p->offset_port_id);
-			port_out = &p->ports_out[port_out_id];
+	for ( ; pkts_mask_port_meta != 0;
+		pkts_mask_port_meta &= pkts_mask_port_meta - 1) {
+		uint32_t i = __builtin_ctzll(pkts_mask_port_meta);
+		uint32_t port_out_id = RTE_MBUF_METADATA_UINT32(p->pkts[i],
+			p->offset_port_id);
 
-			/* Output port user actions */
-			if (port_out->f_action == NULL) /* Output port TX */
-				port_out->ops.f_tx(port_out->h_port, pkt);
-			else {
-				port_out->f_action(p,
-					p->pkts,
-					pkt_mask,
-					port_out->arg_ah);
+		p->port_out_pkts_mask[port_out_id] |= 1LLU << i;
+		p->ports_out_mask |= 1LLU << port_out_id;
+	}
 
-				RTE_PIPELINE_STATS_AH_DROP_READ(p,
-					port_out->n_pkts_dropped_by_ah);
+	for (ports_mask = p->ports_out_mask; ports_mask != 0;
+		ports_mask &= ports_mask - 1) {
+		uint32_t port_out_id = __builtin_ctzll(ports_mask);
+		uint64_t pkts_mask = p->port_out_pkts_mask[port_out_id];
 
-				/* Output port TX */
-				if (pkt_mask & p->pkts_mask)
-					port_out->ops.f_tx(port_out->h_port,
-						pkt);
-			}
-		}
+		p->port_out_pkts_mask[port_out_id] = 0;
+		rte_pipeline_action_handler_port_bulk(p, pkts_mask,
+			port_out_id);
 	}
+	p->ports_out_mask = 0;
 }
 
 static inline void
@@ -1340,11 +1254,54 @@ rte_pipeline_action_handler_drop(struct rte_pipeline *p, uint64_t pkts_mask)
 	}
 }
 
+/*
+ * The packets sent to the next table are known from the lookup results of the
+ * current table, so when the next table allows it, look them up back to back,
+ * and prefetch the entries found while the actions of the current table run.
+ */
+static inline int
+rte_pipeline_table_lookahead(struct rte_pipeline *p, struct rte_table *table,
+	uint64_t lookup_hit_mask, uint64_t lookup_miss_mask)
+{
+	struct rte_table *table_next;
+	uint64_t pkts_mask = 0, hit_mask;
+
+	if (table->table_next_id_valid == 0)
+		return 0;
+
+	table_next = &p->tables[table->table_next_id];
+	if (table_next->lookahead == 0)
+		return 0;
+
+	if (table->default_entry->action == RTE_PIPELINE_ACTION_TABLE)
+		pkts_mask = lookup_miss_mask;
+
+	for ( ; lookup_hit_mask != 0; lookup_hit_mask &= lookup_hit_mask - 1) {
+		uint32_t i = __builtin_ctzll(lookup_hit_mask);
+
+		if (p->entries[i]->action == RTE_PIPELINE_ACTION_TABLE)
+			pkts_mask |= 1LLU << i;
+	}
+
+	if (pkts_mask == 0)
+		return 0;
+
+	table_next->ops.f_lookup(table_next->h_table, p->pkts, pkts_mask,
+		&p->lookahead_hit_mask, (void **) p->entries_next);
+
+	for (hit_mask = p->lookahead_hit_mask; hit_mask != 0;
+		hit_mask &= hit_mask - 1)
+		rte_prefetch0(p->entries_next[__builtin_ctzll(hit_mask)]);
+
+	return 1;
+}
+
 int
 rte_pipeline_run(struct rte_pipeline *p)
 {
 	struct rte_port_in *port_in = p->port_in_next;
 	uint32_t n_pkts, table_id;
+	int lookahead = 0;
 
 	if (port_in == NULL)
 		return 0;
@@ -1376,12 +1333,20 @@ rte_pipeline_run(struct rte_pipeline *p)
 		struct rte_table *table;
 		uint64_t lookup_hit_mask, lookup_miss_mask;
 
-		/* Lookup */
+		/* Lookup, unless already done ahead */
 		table = &p->tables[table_id];
-		table->ops.f_lookup(table->h_table, p->pkts, p->pkts_mask,
-			&lookup_hit_mask, (void **) p->entries);
+		if (lookahead)
+			lookup_hit_mask = p->lookahead_hit_mask & p->pkts_mask;
+		else
+			table->ops.f_lookup(table->h_table, p->pkts,
+				p->pkts_mask, &lookup_hit_mask,
+				(void **) p->entries);
 		lookup_miss_mask = p->pkts_mask & (~lookup_hit_mask);
 
+		/* Next table lookup */
+		lookahead = rte_pipeline_table_lookahead(p, table,
+			lookup_hit_mask, lookup_miss_mask);
+
 		/* Lookup miss */
 		if (lookup_miss_mask != 0) {
 			struct rte_pipeline_table_entry *default_entry =
@@ -1444,6 +1409,8 @@ rte_pipeline_run(struct rte_pipeline *p)
 			p->action_mask0[RTE_PIPELINE_ACTION_PORT] |=
 				p->action_mask1[
 					RTE_PIPELINE_ACTION_PORT];
+			rte_pipeline_action_port_group(p,
+				p->action_mask1[RTE_PIPELINE_ACTION_PORT]);
 			p->action_mask0[RTE_PIPELINE_ACTION_PORT_META] |=
 				p->action_mask1[
 					RTE_PIPELINE_ACTION_PORT_META];
@@ -1459,14 +1426,16 @@ rte_pipeline_run(struct rte_pipeline *p)
 		p->pkts_mask = p->action_mask0[RTE_PIPELINE_ACTION_TABLE];
 		table_id = table->table_next_id;
 		p->action_mask0[RTE_PIPELINE_ACTION_TABLE] = 0;
+		if (lookahead) {
+			struct rte_pipeline_table_entry **entries = p->entries;
+
+			p->entries = p->entries_next;
+			p->entries_next = entries;
+		}
 	}
 
-	/* Table reserved action PORT */
+	/* Table reserved actions PORT and PORT META */
 	rte_pipeline_action_handler_port(p,
-		p->action_mask0[RTE_PIPELINE_ACTION_PORT]);
-
-	/* Table reserved action PORT META */
-	rte_pipeline_action_handler_port_meta(p,
 		p->action_mask0[RTE_PIPELINE_ACTION_PORT_META]);
 
 	/* Table reserved action DROP */
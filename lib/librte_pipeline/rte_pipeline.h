@@ -351,6 +351,11 @@ struct rte_pipeline_table_params {
 	/** Memory size to be reserved per table entry for storing the user
 	actions and their meta-data */
 	uint32_t action_data_size;
+	/** When non-zero, the packets sent to this table by the previous table
+	are looked up in this table right after the lookup of the previous
+	table, before the user actions of the previous table run. Only valid
+	when the lookup key of this table is not written by these actions. */
+	uint32_t lookahead;
 };
 
 /**
@@ -0,0 +1,625 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+
+#include <rte_mbuf.h>
+#include <rte_malloc.h>
+#include <rte_memcpy.h>
+#include <rte_atomic.h>
+#include <rte_branch_prediction.h>
+
+#include "rte_port_af_packet.h"
+
+/*
+ * AF_PACKET socket with memory mapped ring
+ */
+static int
+af_packet_socket_create(const char *iface, uint16_t protocol, int version,
+	int ring_type, void *req, size_t req_size, size_t ring_size,
+	uint8_t **ring)
+{
+	struct sockaddr_ll addr;
+	unsigned int if_index;
+	int fd, loss = 1;
+	void *addr_ring;
+
+	if_index = if_nametoindex(iface);
+	if (if_index == 0) {
+		RTE_LOG(ERR, PORT, "%s: Invalid interface %s\n",
+			__func__, iface);
+		return -1;
+	}
+
+	fd = socket(AF_PACKET, SOCK_RAW, htons(protocol));
+	if (fd < 0) {
+		RTE_LOG(ERR, PORT, "%s: Cannot open AF_PACKET socket (%s)\n",
+			__func__, strerror(errno));
+		return -1;
+	}
+
+	if (setsockopt(fd, SOL_PACKET, PACKET_VERSION, &version,
+		sizeof(version)) < 0) {
+		RTE_LOG(ERR, PORT, "%s: Cannot set PACKET_VERSION (%s)\n",
+			__func__, strerror(errno));
+		goto error;
+	}
+
+	if ((ring_type == PACKET_TX_RING) &&
+		(setsockopt(fd, SOL_PACKET, PACKET_LOSS, &loss,
+		sizeof(loss)) < 0)) {
+		RTE_LOG(ERR, PORT, "%s: Cannot set PACKET_LOSS (%s)\n",
+			__func__, strerror(errno));
+		goto error;
+	}
+
+	if (setsockopt(fd, SOL_PACKET, ring_type, req, req_size) < 0) {
+		RTE_LOG(ERR, PORT, "%s: Cannot set up the packet ring (%s)\n",
+			__func__, strerror(errno));
+		goto error;
+	}
+
+	addr_ring = mmap(NULL, ring_size, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, fd, 0);
+	if (addr_ring == MAP_FAILED) {
+		RTE_LOG(ERR, PORT, "%s: Cannot map the packet ring (%s)\n",
+			__func__, strerror(errno));
+		goto error;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sll_family = AF_PACKET;
+	addr.sll_protocol = htons(protocol);
+	addr.sll_ifindex = if_index;
+	if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+		RTE_LOG(ERR, PORT, "%s: Cannot bind to interface %s (%s)\n",
+			__func__, iface, strerror(errno));
+		munmap(addr_ring, ring_size);
+		goto error;
+	}
+
+	*ring = addr_ring;
+	return fd;
+
+error:
+	close(fd);
+	return -1;
+}
+
+/*
+ * Port AF_PACKET Reader
+ */
+#ifdef RTE_PORT_STATS_COLLECT
+
+#define RTE_PORT_AF_PACKET_READER_STATS_PKTS_IN_ADD(port, val) \
+	do { port->stats.n_pkts_in += val; } while (0)
+#define RTE_PORT_AF_PACKET_READER_STATS_PKTS_DROP_ADD(port, val) \
+	do { port->stats.n_pkts_drop += val; } while (0)
+
+#else
+
+#define RTE_PORT_AF_PACKET_READER_STATS_PKTS_IN_ADD(port, val)
+#define RTE_PORT_AF_PACKET_READER_STATS_PKTS_DROP_ADD(port, val)
+
+#endif
+
+struct rte_port_af_packet_reader {
+	struct rte_port_in_stats stats;
+
+	/* Current ring block and next packet to read from it */
+	struct tpacket3_hdr *pkt;
+	uint32_t block_n_pkts;
+	uint32_t block_id;
+
+	uint8_t *ring;
+	size_t ring_size;
+	uint32_t block_size;
+	uint32_t n_blocks;
+	uint32_t mtu;
+	int fd;
+	struct rte_mempool *mempool;
+};
+
+static void *
+rte_port_af_packet_reader_create(void *params, int socket_id)
+{
+	struct rte_port_af_packet_reader_params *conf =
+			(struct rte_port_af_packet_reader_params *) params;
+	struct rte_port_af_packet_reader *port;
+	struct tpacket_req3 req;
+	size_t ring_size;
+
+	/* Check input parameters */
+	if (conf == NULL) {
+		RTE_LOG(ERR, PORT, "%s: params is NULL\n", __func__);
+		return NULL;
+	}
+	if (conf->iface == NULL) {
+		RTE_LOG(ERR, PORT, "%s: Invalid interface\n", __func__);
+		return NULL;
+	}
+	if ((conf->block_size == 0) ||
+		(!rte_is_power_of_2(conf->block_size)) ||
+		(conf->block_size % getpagesize())) {
+		RTE_LOG(ERR, PORT, "%s: Invalid block size\n", __func__);
+		return NULL;
+	}
+	if (conf->n_blocks == 0) {
+		RTE_LOG(ERR, PORT, "%s: Invalid number of blocks\n", __func__);
+		return NULL;
+	}
+	if ((conf->frame_size == 0) ||
+		(conf->frame_size > conf->block_size) ||
+		(conf->frame_size % TPACKET_ALIGNMENT)) {
+		RTE_LOG(ERR, PORT, "%s: Invalid frame size\n", __func__);
+		return NULL;
+	}
+	if (conf->mempool == NULL) {
+		RTE_LOG(ERR, PORT, "%s: Invalid mempool\n", __func__);
+		return NULL;
+	}
+
+	/* Memory allocation */
+	port = rte_zmalloc_socket("PORT", sizeof(*port),
+			RTE_CACHE_LINE_SIZE, socket_id);
+	if (port == NULL) {
+		RTE_LOG(ERR, PORT, "%s: Failed to allocate port\n", __func__);
+		return NULL;
+	}
+
+	/* Socket and RX ring */
+	memset(&req, 0, sizeof(req));
+	req.tp_block_size = conf->block_size;
+	req.tp_block_nr = conf->n_blocks;
+	req.tp_frame_size = conf->frame_size;
+	req.tp_frame_nr = (conf->block_size / conf->frame_size) *
+		conf->n_blocks;
+	req.tp_retire_blk_tov = conf->block_timeout;
+	ring_size = (size_t) conf->block_size * conf->n_blocks;
+
+	port->fd = af_packet_socket_create(conf->iface, ETH_P_ALL, TPACKET_V3,
+		PACKET_RX_RING, &req, sizeof(req), ring_size, &port->ring);
+	if (port->fd < 0) {
+		rte_free(port);
+		return NULL;
+	}
+
+	/* Initialization */
+	port->ring_size = ring_size;
+	port->block_size = conf->block_size;
+	port->n_blocks = conf->n_blocks;
+	port->mempool = conf->mempool;
+	port->mtu = rte_pktmbuf_data_room_size(conf->mempool) -
+		RTE_PKTMBUF_HEADROOM;
+
+	return port;
+}
+
+static inline struct tpacket_block_desc *
+af_packet_reader_block(struct rte_port_af_packet_reader *p)
+{
+	return (struct tpacket_block_desc *)
+		&p->ring[(size_t) p->block_id * p->block_size];
+}
+
+/* Returns non-zero when a ring block with packets is owned by the reader */
+static inline int
+af_packet_reader_block_get(struct rte_port_af_packet_reader *p)
+{
+	for ( ; p->block_n_pkts == 0; ) {
+		struct tpacket_block_desc *block = af_packet_reader_block(p);
+
+		if ((block->hdr.bh1.block_status & TP_STATUS_USER) == 0)
+			return 0;
+
+		rte_smp_rmb();
+		p->block_n_pkts = block->hdr.bh1.num_pkts;
+		p->pkt = (struct tpacket3_hdr *) ((uint8_t *) block +
+			block->hdr.bh1.offset_to_first_pkt);
+
+		/* Give empty blocks back to the kernel straight away */
+		if (unlikely(p->block_n_pkts == 0)) {
+			block->hdr.bh1.block_status = TP_STATUS_KERNEL;
+			p->block_id = (p->block_id + 1) % p->n_blocks;
+		}
+	}
+
+	return 1;
+}
+
+static inline void
+af_packet_reader_block_put(struct rte_port_af_packet_reader *p)
+{
+	struct tpacket_block_desc *block = af_packet_reader_block(p);
+
+	/* All the packet reads have to complete before the kernel gets the
+	 * block back.
+	 */
+	rte_smp_mb();
+	block->hdr.bh1.block_status = TP_STATUS_KERNEL;
+	p->block_id = (p->block_id + 1) % p->n_blocks;
+}
+
+static int
+rte_port_af_packet_reader_rx(void *port, struct rte_mbuf **pkts,
+	uint32_t n_pkts)
+{
+	struct rte_port_af_packet_reader *p =
+			(struct rte_port_af_packet_reader *) port;
+	uint32_t i, n_drop = 0;
+
+	if (af_packet_reader_block_get(p) == 0)
+		return 0;
+
+	if (rte_mempool_get_bulk(p->mempool, (void **) pkts, n_pkts) != 0)
+		return 0;
+
+	for (i = 0; (i < n_pkts) && af_packet_reader_block_get(p); ) {
+		struct tpacket3_hdr *hdr = p->pkt;
+		uint32_t n_bytes = hdr->tp_snaplen;
+
+		p->pkt = (struct tpacket3_hdr *) ((uint8_t *) hdr +
+			hdr->tp_next_offset);
+		p->block_n_pkts--;
+
+		if (likely(n_bytes <= p->mtu)) {
+			struct rte_mbuf *pkt = pkts[i++];
+
+			rte_mbuf_refcnt_set(pkt, 1);
+			rte_pktmbuf_reset(pkt);
+			rte_memcpy(rte_pktmbuf_mtod(pkt, void *),
+				(uint8_t *) hdr + hdr->tp_mac, n_bytes);
+			pkt->data_len = n_bytes;
+			pkt->pkt_len = n_bytes;
+		} else
+			n_drop++;
+
+		if (p->block_n_pkts == 0)
+			af_packet_reader_block_put(p);
+	}
+
+	if (i < n_pkts)
+		rte_mempool_put_bulk(p->mempool, (void **) &pkts[i],
+			n_pkts - i);
+
+	RTE_PORT_AF_PACKET_READER_STATS_PKTS_IN_ADD(p, i + n_drop);
+	RTE_PORT_AF_PACKET_READER_STATS_PKTS_DROP_ADD(p, n_drop);
+
+	return i;
+}
+
+static int
+rte_port_af_packet_reader_free(void *port)
+{
+	struct rte_port_af_packet_reader *p =
+			(struct rte_port_af_packet_reader *) port;
+
+	if (port == NULL) {
+		RTE_LOG(ERR, PORT, "%s: port is NULL\n", __func__);
+		return -EINVAL;
+	}
+
+	munmap(p->ring, p->ring_size);
+	close(p->fd);
+	rte_free(port);
+
+	return 0;
+}
+
+static int rte_port_af_packet_reader_stats_read(void *port,
+		struct rte_port_in_stats *stats, int clear)
+{
+	struct rte_port_af_packet_reader *p =
+			(struct rte_port_af_packet_reader *) port;
+
+	if (stats != NULL)
+		memcpy(stats, &p->stats, sizeof(p->stats));
+
+	if (clear)
+		memset(&p->stats, 0, sizeof(p->stats));
+
+	return 0;
+}
+
+/*
+ * Port AF_PACKET Writer
+ */
+#ifdef RTE_PORT_STATS_COLLECT
+
+#define RTE_PORT_AF_PACKET_WRITER_STATS_PKTS_IN_ADD(port, val) \
+	do { port->stats.n_pkts_in += val; } while (0)
+#define RTE_PORT_AF_PACKET_WRITER_STATS_PKTS_DROP_ADD(port, val) \
+	do { port->stats.n_pkts_drop += val; } while (0)
+
+#else
+
+#define RTE_PORT_AF_PACKET_WRITER_STATS_PKTS_IN_ADD(port, val)
+#define RTE_PORT_AF_PACKET_WRITER_STATS_PKTS_DROP_ADD(port, val)
+
+#endif
+
+#define AF_PACKET_WRITER_FRAME_DATA_OFFSET				\
+	(TPACKET2_HDRLEN - sizeof(struct sockaddr_ll))
+
+struct rte_port_af_packet_writer {
+	struct rte_port_out_stats stats;
+
+	struct rte_mbuf *tx_buf[2 * RTE_PORT_IN_BURST_SIZE_MAX];
+	uint32_t tx_burst_sz;
+	uint16_t tx_buf_count;
+
+	uint8_t *ring;
+	size_t ring_size;
+	uint32_t frame_size;
+	uint32_t frame_data_size;
+	uint32_t n_frames;
+	uint32_t frame_id;
+	int fd;
+};
+
+static void *
+rte_port_af_packet_writer_create(void *params, int socket_id)
+{
+	struct rte_port_af_packet_writer_params *conf =
+		(struct rte_port_af_packet_writer_params *) params;
+	struct rte_port_af_packet_writer *port;
+	struct tpacket_req req;
+	uint32_t page_size = getpagesize();
+	size_t ring_size;
+
+	/* Check input parameters */
+	if ((conf == NULL) ||
+		(conf->iface == NULL) ||
+		(conf->frame_size <= AF_PACKET_WRITER_FRAME_DATA_OFFSET) ||
+		(conf->frame_size > page_size) ||
+		(!rte_is_power_of_2(conf->frame_size)) ||
+		(conf->n_frames == 0) ||
+		(conf->tx_burst_sz == 0) ||
+		(conf->tx_burst_sz > RTE_PORT_IN_BURST_SIZE_MAX) ||
+		(!rte_is_power_of_2(conf->tx_burst_sz))) {
+		RTE_LOG(ERR, PORT, "%s: Invalid input parameters\n", __func__);
+		return NULL;
+	}
+
+	/* Memory allocation */
+	port = rte_zmalloc_socket("PORT", sizeof(*port),
+		RTE_CACHE_LINE_SIZE, socket_id);
+	if (port == NULL) {
+		RTE_LOG(ERR, PORT, "%s: Failed to allocate port\n", __func__);
+		return NULL;
+	}
+
+	/* Socket and TX ring: one page per block, so the frames are laid out
+	 * back to back in the ring.
+	 */
+	memset(&req, 0, sizeof(req));
+	req.tp_block_size = page_size;
+	req.tp_block_nr = (conf->n_frames * conf->frame_size + page_size - 1) /
+		page_size;
+	req.tp_frame_size = conf->frame_size;
+	req.tp_frame_nr = req.tp_block_nr * (page_size / conf->frame_size);
+	ring_size = (size_t) req.tp_block_size * req.tp_block_nr;
+
+	port->fd = af_packet_socket_create(conf->iface, 0, TPACKET_V2,
+		PACKET_TX_RING, &req, sizeof(req), ring_size, &port->ring);
+	if (port->fd < 0) {
+		rte_free(port);
+		return NULL;
+	}
+
+	/* Initialization */
+	port->tx_burst_sz = conf->tx_burst_sz;
+	port->tx_buf_count = 0;
+	port->ring_size = ring_size;
+	port->frame_size = conf->frame_size;
+	port->frame_data_size = conf->frame_size -
+		AF_PACKET_WRITER_FRAME_DATA_OFFSET;
+	port->n_frames = req.tp_frame_nr;
+	port->frame_id = 0;
+
+	return port;
+}
+
+static inline void
+send_burst(struct rte_port_af_packet_writer *p)
+{
+	uint32_t i, n_tx = 0;
+
+	for (i = 0; i < p->tx_buf_count; i++) {
+		struct rte_mbuf *pkt = p->tx_buf[i];
+		struct tpacket2_hdr *hdr = (struct tpacket2_hdr *)
+			&p->ring[(size_t) p->frame_id * p->frame_size];
+		uint8_t *frame_data;
+		struct rte_mbuf *seg;
+
+		/* TX ring full */
+		if (hdr->tp_status != TP_STATUS_AVAILABLE)
+			break;
+
+		if (unlikely(pkt->pkt_len > p->frame_data_size))
+			continue;
+
+		frame_data = (uint8_t *) hdr +
+			AF_PACKET_WRITER_FRAME_DATA_OFFSET;
+		for (seg = pkt; seg != NULL; seg = seg->next) {
+			rte_memcpy(frame_data, rte_pktmbuf_mtod(seg, void *),
+				seg->data_len);
+			frame_data += seg->data_len;
+		}
+
+		hdr->tp_len = pkt->pkt_len;
+		rte_smp_wmb();
+		hdr->tp_status = TP_STATUS_SEND_REQUEST;
+
+		p->frame_id++;
+		if (p->frame_id == p->n_frames)
+			p->frame_id = 0;
+		n_tx++;
+	}
+
+	/* One system call per burst to kick the kernel. On failure, the
+	 * frames stay in the ring and get sent on the next kick.
+	 */
+	if (n_tx)
+		sendto(p->fd, NULL, 0, MSG_DONTWAIT, NULL, 0);
+
+	RTE_PORT_AF_PACKET_WRITER_STATS_PKTS_DROP_ADD(p,
+		p->tx_buf_count - n_tx);
+
+	for (i = 0; i < p->tx_buf_count; i++)
+		rte_pktmbuf_free(p->tx_buf[i]);
+
+	p->tx_buf_count = 0;
+}
+
+static int
+rte_port_af_packet_writer_tx(void *port, struct rte_mbuf *pkt)
+{
+	struct rte_port_af_packet_writer *p =
+		(struct rte_port_af_packet_writer *) port;
+
+	p->tx_buf[p->tx_buf_count++] = pkt;
+	RTE_PORT_AF_PACKET_WRITER_STATS_PKTS_IN_ADD(p, 1);
+	if (p->tx_buf_count >= p->tx_burst_sz)
+		send_burst(p);
+
+	return 0;
+}
+
+static int
+rte_port_af_packet_writer_tx_bulk(void *port,
+	struct rte_mbuf **pkts,
+	uint64_t pkts_mask)
+{
+	struct rte_port_af_packet_writer *p =
+		(struct rte_port_af_packet_writer *) port;
+	uint32_t tx_buf_count = p->tx_buf_count;
+
+	if ((pkts_mask & (pkts_mask + 1)) == 0) {
+		uint64_t n_pkts = __builtin_popcountll(pkts_mask);
+		uint32_t i;
+
+		for (i = 0; i < n_pkts; i++)
+			p->tx_buf[tx_buf_count++] = pkts[i];
+		RTE_PORT_AF_PACKET_WRITER_STATS_PKTS_IN_ADD(p, n_pkts);
+	} else
+		for ( ; pkts_mask; ) {
+			uint32_t pkt_index = __builtin_ctzll(pkts_mask);
+			uint64_t pkt_mask = 1LLU << pkt_index;
+			struct rte_mbuf *pkt = pkts[pkt_index];
+
+			p->tx_buf[tx_buf_count++] = pkt;
+			RTE_PORT_AF_PACKET_WRITER_STATS_PKTS_IN_ADD(p, 1);
+			pkts_mask &= ~pkt_mask;
+		}
+
+	p->tx_buf_count = tx_buf_count;
+	if (tx_buf_count >= p->tx_burst_sz)
+		send_burst(p);
+
+	return 0;
+}
+
+static int
+rte_port_af_packet_writer_flush(void *port)
+{
+	struct rte_port_af_packet_writer *p =
+		(struct rte_port_af_packet_writer *) port;
+
+	if (p->tx_buf_count > 0)
+		send_burst(p);
+
+	return 0;
+}
+
+static int
+rte_port_af_packet_writer_free(void *port)
+{
+	struct rte_port_af_packet_writer *p =
+		(struct rte_port_af_packet_writer *) port;
+
+	if (port == NULL) {
+		RTE_LOG(ERR, PORT, "%s: Port is NULL\n", __func__);
+		return -EINVAL;
+	}
+
+	rte_port_af_packet_writer_flush(port);
+	munmap(p->ring, p->ring_size);
+	close(p->fd);
+	rte_free(port);
+
+	return 0;
+}
+
+static int rte_port_af_packet_writer_stats_read(void *port,
+		struct rte_port_out_stats *stats, int clear)
+{
+	struct rte_port_af_packet_writer *p =
+		(struct rte_port_af_packet_writer *) port;
+
+	if (stats != NULL)
+		memcpy(stats, &p->stats, sizeof(p->stats));
+
+	if (clear)
+		memset(&p->stats, 0, sizeof(p->stats));
+
+	return 0;
+}
+
+/*
+ * Summary of port operations
+ */
+struct rte_port_in_ops rte_port_af_packet_reader_ops = {
+	.f_create = rte_port_af_packet_reader_create,
+	.f_free = rte_port_af_packet_reader_free,
+	.f_rx = rte_port_af_packet_reader_rx,
+	.f_stats = rte_port_af_packet_reader_stats_read,
+};
+
+struct rte_port_out_ops rte_port_af_packet_writer_ops = {
+	.f_create = rte_port_af_packet_writer_create,
+	.f_free = rte_port_af_packet_writer_free,
+	.f_tx = rte_port_af_packet_writer_tx,
+	.f_tx_bulk = rte_port_af_packet_writer_tx_bulk,
+	.f_flush = rte_port_af_packet_writer_flush,
+	.f_stats = rte_port_af_packet_writer_stats_read,
+};
@@ -0,0 +1,115 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __INCLUDE_RTE_PORT_AF_PACKET_H__
+#define __INCLUDE_RTE_PORT_AF_PACKET_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file
+ * RTE Port AF_PACKET Device
+ *
+ * af_packet_reader: input port built on top of a Linux AF_PACKET socket
+ * with a memory mapped TPACKET_V3 RX ring
+ * af_packet_writer: output port built on top of a Linux AF_PACKET socket
+ * with a memory mapped TX ring
+ *
+ * Packets are exchanged with the kernel through the rings shared with the
+ * socket, so there is no system call per packet: the reader polls the status
+ * of the ring blocks and the writer kicks the kernel once per burst.
+ *
+ ***/
+
+#include <stdint.h>
+
+#include <rte_mempool.h>
+#include "rte_port.h"
+
+/** af_packet_reader port parameters */
+struct rte_port_af_packet_reader_params {
+	/** Kernel network interface name */
+	const char *iface;
+
+	/** Size of each RX ring block (bytes). Needs to be a power of 2 and a
+	 * multiple of the page size.
+	 */
+	uint32_t block_size;
+
+	/** Number of RX ring blocks */
+	uint32_t n_blocks;
+
+	/** Maximum frame size (bytes), including the TPACKET_V3 header. Needs
+	 * to be a multiple of TPACKET_ALIGNMENT not bigger than block_size.
+	 */
+	uint32_t frame_size;
+
+	/** Block retire timeout (milliseconds), 0 for the kernel default */
+	uint32_t block_timeout;
+
+	/** Pre-initialized buffer pool */
+	struct rte_mempool *mempool;
+};
+
+/** af_packet_reader port operations */
+extern struct rte_port_in_ops rte_port_af_packet_reader_ops;
+
+/** af_packet_writer port parameters */
+struct rte_port_af_packet_writer_params {
+	/** Kernel network interface name */
+	const char *iface;
+
+	/** TX ring frame size (bytes), including the TPACKET_V2 header. Needs
+	 * to be a power of 2 not bigger than the page size.
+	 */
+	uint32_t frame_size;
+
+	/** Number of TX ring frames */
+	uint32_t n_frames;
+
+	/**< Recommended write burst size. The actual burst size can be
+	 * bigger or smaller than this value.
+	 */
+	uint32_t tx_burst_sz;
+};
+
+/** af_packet_writer port operations */
+extern struct rte_port_out_ops rte_port_af_packet_writer_ops;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,547 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include <rte_mbuf.h>
+#include <rte_malloc.h>
+#include <rte_memcpy.h>
+#include <rte_atomic.h>
+#include <rte_cycles.h>
+#include <rte_branch_prediction.h>
+
+#include "rte_port_shm.h"
+
+#define SHM_SLOT(hdr, slot_size, mask, index)				\
+	((struct rte_port_shm_slot *)					\
+	&(hdr)->slots[(size_t) ((index) & (mask)) * (slot_size)])
+
+/* Time given to the other end to complete the ring initialization (ms) */
+#define SHM_RING_INIT_TIMEOUT_MS				1000
+
+/*
+ * Shared memory ring
+ */
+static struct rte_port_shm_hdr *
+shm_ring_map(int fd, uint32_t n_slots, uint32_t slot_size, size_t *size)
+{
+	struct rte_port_shm_hdr *hdr;
+	struct stat st;
+	size_t ring_size;
+
+	ring_size = sizeof(struct rte_port_shm_hdr) +
+		(size_t) n_slots * slot_size;
+
+	if (fstat(fd, &st) < 0) {
+		RTE_LOG(ERR, PORT, "%s: Cannot stat file descriptor (%s)\n",
+			__func__, strerror(errno));
+		return NULL;
+	}
+
+	if (((size_t) st.st_size < ring_size) &&
+		(ftruncate(fd, ring_size) < 0)) {
+		RTE_LOG(ERR, PORT, "%s: Cannot resize shared memory file (%s)\n",
+			__func__, strerror(errno));
+		return NULL;
+	}
+
+	hdr = mmap(NULL, ring_size, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, fd, 0);
+	if (hdr == MAP_FAILED) {
+		RTE_LOG(ERR, PORT, "%s: Cannot map shared memory file (%s)\n",
+			__func__, strerror(errno));
+		return NULL;
+	}
+
+	/*
+	 * The end which moves the initialization state from 0 to 1 initializes
+	 * the ring and publishes the magic last, the other end waits for the
+	 * magic before reading the header.
+	 */
+	if (rte_atomic32_cmpset(&hdr->init_state, 0, 1)) {
+		hdr->n_slots = n_slots;
+		hdr->slot_size = slot_size;
+		hdr->prod = 0;
+		hdr->cons = 0;
+		rte_smp_wmb();
+		hdr->magic = RTE_PORT_SHM_MAGIC;
+		rte_smp_wmb();
+	} else {
+		uint64_t deadline = rte_get_timer_cycles() +
+			rte_get_timer_hz() * SHM_RING_INIT_TIMEOUT_MS / 1000;
+
+		while (hdr->magic != RTE_PORT_SHM_MAGIC) {
+			if (rte_get_timer_cycles() > deadline) {
+				RTE_LOG(ERR, PORT, "%s: Shared memory ring "
+					"not initialized by the other end\n",
+					__func__);
+				munmap(hdr, ring_size);
+				return NULL;
+			}
+			rte_pause();
+		}
+		rte_smp_rmb();
+	}
+
+	if ((hdr->n_slots != n_slots) || (hdr->slot_size != slot_size)) {
+		RTE_LOG(ERR, PORT, "%s: Shared memory ring geometry mismatch "
+			"(%u x %u bytes instead of %u x %u bytes)\n", __func__,
+			hdr->n_slots, hdr->slot_size, n_slots, slot_size);
+		munmap(hdr, ring_size);
+		return NULL;
+	}
+
+	*size = ring_size;
+	return hdr;
+}
+
+static int
+shm_ring_check_params(int fd, uint32_t n_slots, uint32_t slot_size)
+{
+	if (fd < 0) {
+		RTE_LOG(ERR, PORT, "%s: Invalid file descriptor\n", __func__);
+		return -EINVAL;
+	}
+	if ((n_slots == 0) || (!rte_is_power_of_2(n_slots))) {
+		RTE_LOG(ERR, PORT, "%s: Invalid number of slots\n", __func__);
+		return -EINVAL;
+	}
+	if ((slot_size == 0) || (slot_size % RTE_CACHE_LINE_SIZE)) {
+		RTE_LOG(ERR, PORT, "%s: Invalid slot size\n", __func__);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/*
+ * Port SHM Reader
+ */
+#ifdef RTE_PORT_STATS_COLLECT
+
+#define RTE_PORT_SHM_READER_STATS_PKTS_IN_ADD(port, val) \
+	do { port->stats.n_pkts_in += val; } while (0)
+#define RTE_PORT_SHM_READER_STATS_PKTS_DROP_ADD(port, val) \
+	do { port->stats.n_pkts_drop += val; } while (0)
+
+#else
+
+#define RTE_PORT_SHM_READER_STATS_PKTS_IN_ADD(port, val)
+#define RTE_PORT_SHM_READER_STATS_PKTS_DROP_ADD(port, val)
+
+#endif
+
+struct rte_port_shm_reader {
+	struct rte_port_in_stats stats;
+
+	struct rte_port_shm_hdr *hdr;
+	size_t ring_size;
+	uint32_t cons;
+	uint32_t mask;
+	uint32_t slot_size;
+	uint32_t mtu;
+	struct rte_mempool *mempool;
+};
+
+static void *
+rte_port_shm_reader_create(void *params, int socket_id)
+{
+	struct rte_port_shm_reader_params *conf =
+			(struct rte_port_shm_reader_params *) params;
+	struct rte_port_shm_reader *port;
+
+	/* Check input parameters */
+	if (conf == NULL) {
+		RTE_LOG(ERR, PORT, "%s: params is NULL\n", __func__);
+		return NULL;
+	}
+	if (shm_ring_check_params(conf->fd, conf->n_slots,
+		conf->slot_size) != 0)
+		return NULL;
+	if (conf->mempool == NULL) {
+		RTE_LOG(ERR, PORT, "%s: Invalid mempool\n", __func__);
+		return NULL;
+	}
+
+	/* Memory allocation */
+	port = rte_zmalloc_socket("PORT", sizeof(*port),
+			RTE_CACHE_LINE_SIZE, socket_id);
+	if (port == NULL) {
+		RTE_LOG(ERR, PORT, "%s: Failed to allocate port\n", __func__);
+		return NULL;
+	}
+
+	port->hdr = shm_ring_map(conf->fd, conf->n_slots, conf->slot_size,
+		&port->ring_size);
+	if (port->hdr == NULL) {
+		rte_free(port);
+		return NULL;
+	}
+
+	/* Initialization */
+	port->cons = port->hdr->cons;
+	port->mask = conf->n_slots - 1;
+	port->slot_size = conf->slot_size;
+	port->mempool = conf->mempool;
+	port->mtu = RTE_MIN((uint32_t) (rte_pktmbuf_data_room_size(
+		conf->mempool) - RTE_PKTMBUF_HEADROOM),
+		(uint32_t) (conf->slot_size -
+		sizeof(struct rte_port_shm_slot)));
+
+	return port;
+}
+
+static int
+rte_port_shm_reader_rx(void *port, struct rte_mbuf **pkts, uint32_t n_pkts)
+{
+	struct rte_port_shm_reader *p = (struct rte_port_shm_reader *) port;
+	struct rte_port_shm_hdr *hdr = p->hdr;
+	uint32_t cons = p->cons;
+	uint32_t n_slots, n_drop, i, j;
+
+	n_slots = hdr->prod - cons;
+	if (n_slots == 0)
+		return 0;
+	if (n_slots > n_pkts)
+		n_slots = n_pkts;
+
+	/* Slot reads cannot start before the producer index is read */
+	rte_smp_rmb();
+
+	if (rte_mempool_get_bulk(p->mempool, (void **) pkts, n_slots) != 0)
+		return 0;
+
+	for (i = 0, j = 0; i < n_slots; i++) {
+		struct rte_port_shm_slot *slot =
+			SHM_SLOT(hdr, p->slot_size, p->mask, cons + i);
+		struct rte_mbuf *pkt = pkts[j];
+		uint32_t n_bytes = slot->len;
+
+		if (unlikely(n_bytes > p->mtu))
+			continue;
+
+		rte_mbuf_refcnt_set(pkt, 1);
+		rte_pktmbuf_reset(pkt);
+		rte_memcpy(rte_pktmbuf_mtod(pkt, void *), slot->data, n_bytes);
+		pkt->data_len = n_bytes;
+		pkt->pkt_len = n_bytes;
+		j++;
+	}
+
+	/* Slot reads have to complete before the slots are given back */
+	rte_smp_rmb();
+	p->cons = cons + n_slots;
+	hdr->cons = p->cons;
+
+	n_drop = n_slots - j;
+	if (unlikely(n_drop))
+		rte_mempool_put_bulk(p->mempool, (void **) &pkts[j], n_drop);
+
+	RTE_PORT_SHM_READER_STATS_PKTS_IN_ADD(p, n_slots);
+	RTE_PORT_SHM_READER_STATS_PKTS_DROP_ADD(p, n_drop);
+
+	return j;
+}
+
+static int
+rte_port_shm_reader_free(void *port)
+{
+	struct rte_port_shm_reader *p = (struct rte_port_shm_reader *) port;
+
+	if (port == NULL) {
+		RTE_LOG(ERR, PORT, "%s: port is NULL\n", __func__);
+		return -EINVAL;
+	}
+
+	munmap(p->hdr, p->ring_size);
+	rte_free(port);
+
+	return 0;
+}
+
+static int rte_port_shm_reader_stats_read(void *port,
+		struct rte_port_in_stats *stats, int clear)
+{
+	struct rte_port_shm_reader *p =
+			(struct rte_port_shm_reader *) port;
+
+	if (stats != NULL)
+		memcpy(stats, &p->stats, sizeof(p->stats));
+
+	if (clear)
+		memset(&p->stats, 0, sizeof(p->stats));
+
+	return 0;
+}
+
+/*
+ * Port SHM Writer
+ */
+#ifdef RTE_PORT_STATS_COLLECT
+
+#define RTE_PORT_SHM_WRITER_STATS_PKTS_IN_ADD(port, val) \
+	do { port->stats.n_pkts_in += val; } while (0)
+#define RTE_PORT_SHM_WRITER_STATS_PKTS_DROP_ADD(port, val) \
+	do { port->stats.n_pkts_drop += val; } while (0)
+
+#else
+
+#define RTE_PORT_SHM_WRITER_STATS_PKTS_IN_ADD(port, val)
+#define RTE_PORT_SHM_WRITER_STATS_PKTS_DROP_ADD(port, val)
+
+#endif
+
+struct rte_port_shm_writer {
+	struct rte_port_out_stats stats;
+
+	struct rte_mbuf *tx_buf[2 * RTE_PORT_IN_BURST_SIZE_MAX];
+	uint32_t tx_burst_sz;
+	uint16_t tx_buf_count;
+
+	struct rte_port_shm_hdr *hdr;
+	size_t ring_size;
+	uint32_t prod;
+	uint32_t n_slots;
+	uint32_t mask;
+	uint32_t slot_size;
+	uint32_t slot_data_size;
+};
+
+static void *
+rte_port_shm_writer_create(void *params, int socket_id)
+{
+	struct rte_port_shm_writer_params *conf =
+		(struct rte_port_shm_writer_params *) params;
+	struct rte_port_shm_writer *port;
+
+	/* Check input parameters */
+	if ((conf == NULL) ||
+		(conf->tx_burst_sz == 0) ||
+		(conf->tx_burst_sz > RTE_PORT_IN_BURST_SIZE_MAX) ||
+		(!rte_is_power_of_2(conf->tx_burst_sz))) {
+		RTE_LOG(ERR, PORT, "%s: Invalid input parameters\n", __func__);
+		return NULL;
+	}
+	if (shm_ring_check_params(conf->fd, conf->n_slots,
+		conf->slot_size) != 0)
+		return NULL;
+
+	/* Memory allocation */
+	port = rte_zmalloc_socket("PORT", sizeof(*port),
+		RTE_CACHE_LINE_SIZE, socket_id);
+	if (port == NULL) {
+		RTE_LOG(ERR, PORT, "%s: Failed to allocate port\n", __func__);
+		return NULL;
+	}
+
+	port->hdr = shm_ring_map(conf->fd, conf->n_slots, conf->slot_size,
+		&port->ring_size);
+	if (port->hdr == NULL) {
+		rte_free(port);
+		return NULL;
+	}
+
+	/* Initialization */
+	port->tx_burst_sz = conf->tx_burst_sz;
+	port->tx_buf_count = 0;
+	port->prod = port->hdr->prod;
+	port->n_slots = conf->n_slots;
+	port->mask = conf->n_slots - 1;
+	port->slot_size = conf->slot_size;
+	port->slot_data_size = conf->slot_size -
+		sizeof(struct rte_port_shm_slot);
+
+	return port;
+}
+
+static inline void
+send_burst(struct rte_port_shm_writer *p)
+{
+	struct rte_port_shm_hdr *hdr = p->hdr;
+	uint32_t prod = p->prod;
+	uint32_t n_free, i;
+
+	n_free = p->n_slots - (prod - hdr->cons);
+
+	for (i = 0; (i < p->tx_buf_count) && n_free; i++) {
+		struct rte_mbuf *pkt = p->tx_buf[i];
+		struct rte_port_shm_slot *slot;
+		struct rte_mbuf *seg;
+		uint8_t *data;
+
+		if (unlikely(pkt->pkt_len > p->slot_data_size))
+			continue;
+
+		slot = SHM_SLOT(hdr, p->slot_size, p->mask, prod);
+		data = slot->data;
+		for (seg = pkt; seg != NULL; seg = seg->next) {
+			rte_memcpy(data, rte_pktmbuf_mtod(seg, void *),
+				seg->data_len);
+			data += seg->data_len;
+		}
+		slot->len = pkt->pkt_len;
+
+		prod++;
+		n_free--;
+	}
+
+	/* Slot writes have to be visible before the producer index */
+	rte_smp_wmb();
+	hdr->prod = prod;
+
+	RTE_PORT_SHM_WRITER_STATS_PKTS_DROP_ADD(p,
+		p->tx_buf_count - (prod - p->prod));
+	p->prod = prod;
+
+	for (i = 0; i < p->tx_buf_count; i++)
+		rte_pktmbuf_free(p->tx_buf[i]);
+
+	p->tx_buf_count = 0;
+}
+
+static int
+rte_port_shm_writer_tx(void *port, struct rte_mbuf *pkt)
+{
+	struct rte_port_shm_writer *p =
+		(struct rte_port_shm_writer *) port;
+
+	p->tx_buf[p->tx_buf_count++] = pkt;
+	RTE_PORT_SHM_WRITER_STATS_PKTS_IN_ADD(p, 1);
+	if (p->tx_buf_count >= p->tx_burst_sz)
+		send_burst(p);
+
+	return 0;
+}
+
+static int
+rte_port_shm_writer_tx_bulk(void *port,
+	struct rte_mbuf **pkts,
+	uint64_t pkts_mask)
+{
+	struct rte_port_shm_writer *p =
+		(struct rte_port_shm_writer *) port;
+	uint32_t tx_buf_count = p->tx_buf_count;
+
+	if ((pkts_mask & (pkts_mask + 1)) == 0) {
+		uint64_t n_pkts = __builtin_popcountll(pkts_mask);
+		uint32_t i;
+
+		for (i = 0; i < n_pkts; i++)
+			p->tx_buf[tx_buf_count++] = pkts[i];
+		RTE_PORT_SHM_WRITER_STATS_PKTS_IN_ADD(p, n_pkts);
+	} else
+		for ( ; pkts_mask; ) {
+			uint32_t pkt_index = __builtin_ctzll(pkts_mask);
+			uint64_t pkt_mask = 1LLU << pkt_index;
+			struct rte_mbuf *pkt = pkts[pkt_index];
+
+			p->tx_buf[tx_buf_count++] = pkt;
+			RTE_PORT_SHM_WRITER_STATS_PKTS_IN_ADD(p, 1);
+			pkts_mask &= ~pkt_mask;
+		}
+
+	p->tx_buf_count = tx_buf_count;
+	if (tx_buf_count >= p->tx_burst_sz)
+		send_burst(p);
+
+	return 0;
+}
+
+static int
+rte_port_shm_writer_flush(void *port)
+{
+	struct rte_port_shm_writer *p =
+		(struct rte_port_shm_writer *) port;
+
+	if (p->tx_buf_count > 0)
+		send_burst(p);
+
+	return 0;
+}
+
+static int
+rte_port_shm_writer_free(void *port)
+{
+	struct rte_port_shm_writer *p =
+		(struct rte_port_shm_writer *) port;
+
+	if (port == NULL) {
+		RTE_LOG(ERR, PORT, "%s: Port is NULL\n", __func__);
+		return -EINVAL;
+	}
+
+	rte_port_shm_writer_flush(port);
+	munmap(p->hdr, p->ring_size);
+	rte_free(port);
+
+	return 0;
+}
+
+static int rte_port_shm_writer_stats_read(void *port,
+		struct rte_port_out_stats *stats, int clear)
+{
+	struct rte_port_shm_writer *p =
+		(struct rte_port_shm_writer *) port;
+
+	if (stats != NULL)
+		memcpy(stats, &p->stats, sizeof(p->stats));
+
+	if (clear)
+		memset(&p->stats, 0, sizeof(p->stats));
+
+	return 0;
+}
+
+/*
+ * Summary of port operations
+ */
+struct rte_port_in_ops rte_port_shm_reader_ops = {
+	.f_create = rte_port_shm_reader_create,
+	.f_free = rte_port_shm_reader_free,
+	.f_rx = rte_port_shm_reader_rx,
+	.f_stats = rte_port_shm_reader_stats_read,
+};
+
+struct rte_port_out_ops rte_port_shm_writer_ops = {
+	.f_create = rte_port_shm_writer_create,
+	.f_free = rte_port_shm_writer_free,
+	.f_tx = rte_port_shm_writer_tx,
+	.f_tx_bulk = rte_port_shm_writer_tx_bulk,
+	.f_flush = rte_port_shm_writer_flush,
+	.f_stats = rte_port_shm_writer_stats_read,
+};
@@ -0,0 +1,139 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __INCLUDE_RTE_PORT_SHM_H__
+#define __INCLUDE_RTE_PORT_SHM_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file
+ * RTE Port Shared Memory
+ *
+ * shm_reader: input port built on top of a single consumer packet ring
+ * located in a shared memory file
+ * shm_writer: output port built on top of a single producer packet ring
+ * located in a shared memory file
+ *
+ * The file descriptor (e.g. a file in /dev/shm, a memfd or a file passed by
+ * another process over a UNIX socket) is mapped by the port, so the packets
+ * are exchanged with the process at the other end of the ring without any
+ * system call. The ring is created by whichever of the two ends opens it
+ * first; its layout is described below so that it can be used by non-DPDK
+ * processes as well.
+ *
+ ***/
+
+#include <stdint.h>
+
+#include <rte_memory.h>
+#include <rte_mempool.h>
+#include "rte_port.h"
+
+/** Value of the magic field once the ring is initialized */
+#define RTE_PORT_SHM_MAGIC				0x52534850
+
+/** Shared memory ring header, located at offset 0 of the file. The header is
+ * followed by n_slots slots of slot_size bytes each, every slot starting
+ * with a struct rte_port_shm_slot.
+ */
+struct rte_port_shm_hdr {
+	/** RTE_PORT_SHM_MAGIC once initialized, written last */
+	volatile uint32_t magic;
+	uint32_t n_slots;   /**< Number of slots, power of 2 */
+	uint32_t slot_size; /**< Slot size (bytes), header included */
+	/** Set to 1 by the end which initializes the ring */
+	volatile uint32_t init_state;
+
+	/** Number of slots written so far by the producer (free running) */
+	volatile uint32_t prod __rte_cache_aligned;
+
+	/** Number of slots read so far by the consumer (free running) */
+	volatile uint32_t cons __rte_cache_aligned;
+
+	/** Packet slots */
+	uint8_t slots[0] __rte_cache_aligned;
+};
+
+/** Shared memory ring slot */
+struct rte_port_shm_slot {
+	uint32_t len;       /**< Packet length (bytes) */
+	uint32_t reserved;
+	uint8_t data[0];    /**< Packet data */
+};
+
+/** shm_reader port parameters */
+struct rte_port_shm_reader_params {
+	/** File descriptor of the shared memory file */
+	int fd;
+
+	/** Number of ring slots. Needs to be a power of 2. */
+	uint32_t n_slots;
+
+	/** Slot size (bytes). Needs to be a multiple of the cache line size. */
+	uint32_t slot_size;
+
+	/** Pre-initialized buffer pool */
+	struct rte_mempool *mempool;
+};
+
+/** shm_reader port operations */
+extern struct rte_port_in_ops rte_port_shm_reader_ops;
+
+/** shm_writer port parameters */
+struct rte_port_shm_writer_params {
+	/** File descriptor of the shared memory file */
+	int fd;
+
+	/** Number of ring slots. Needs to be a power of 2. */
+	uint32_t n_slots;
+
+	/** Slot size (bytes). Needs to be a multiple of the cache line size. */
+	uint32_t slot_size;
+
+	/**< Recommended write burst size. The actual burst size can be
+	 * bigger or smaller than this value.
+	 */
+	uint32_t tx_burst_sz;
+};
+
+/** shm_writer port operations */
+extern struct rte_port_out_ops rte_port_shm_writer_ops;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -101,6 +101,7 @@ extern "C" {
 #include <rte_atomic.h>
 #include <rte_branch_prediction.h>
 #include <rte_memzone.h>
+#include <rte_trace.h>
 
 #define RTE_TAILQ_RING_NAME "RTE_RING"
 
@@ -137,6 +138,11 @@ struct rte_ring_debug_stats {
                                     *   if RTE_RING_PAUSE_REP not defined. */
 #endif
 
+/** Tracepoint "lib.ring.enqueue" of the objects enqueued on a ring. */
+extern struct rte_trace_point rte_ring_trace_enqueue;
+/** Tracepoint "lib.ring.dequeue" of the objects dequeued from a ring. */
+extern struct rte_trace_point rte_ring_trace_dequeue;
+
 struct rte_memzone; /* forward declaration, so as not to require memzone.h */
 
 /**
@@ -511,6 +517,7 @@ __rte_ring_mp_do_enqueue(struct rte_ring *r, void * const *obj_table,
 		}
 	}
 	r->prod.tail = prod_next;
+	rte_trace_point_emit(rte_ring_trace_enqueue, (uintptr_t)r, n);
 	return ret;
 }
 
@@ -590,6 +597,7 @@ __rte_ring_sp_do_enqueue(struct rte_ring *r, void * const *obj_table,
 	}
 
 	r->prod.tail = prod_next;
+	rte_trace_point_emit(rte_ring_trace_enqueue, (uintptr_t)r, n);
 	return ret;
 }
 
@@ -692,6 +700,7 @@ __rte_ring_mc_do_dequeue(struct rte_ring *r, void **obj_table,
 	}
 	__RING_STAT_ADD(r, deq_success, n);
 	r->cons.tail = cons_next;
+	rte_trace_point_emit(rte_ring_trace_dequeue, (uintptr_t)r, n);
 
 	return behavior == RTE_RING_QUEUE_FIXED ? 0 : n;
 }
@@ -760,6 +769,7 @@ __rte_ring_sc_do_dequeue(struct rte_ring *r, void **obj_table,
 
 	__RING_STAT_ADD(r, deq_success, n);
 	r->cons.tail = cons_next;
+	rte_trace_point_emit(rte_ring_trace_dequeue, (uintptr_t)r, n);
 	return behavior == RTE_RING_QUEUE_FIXED ? 0 : n;
 }
 
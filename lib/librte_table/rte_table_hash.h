@@ -363,6 +363,72 @@ struct rte_table_hash_key32_ext_params {
 /** Extendible bucket hash table operations */
 extern struct rte_table_ops rte_table_hash_key32_ext_ops;
 
+/**
+ * Configurable key size hash tables
+ *
+ * Same bucket layout and lookup pipeline as the 8/16/32-byte key tables, with
+ * the key size set on table creation. Keys shorter than a multiple of 8 bytes
+ * must be zero-padded by the application.
+ */
+/** Maximum key size (number of bytes) for the configurable key size tables */
+#define RTE_TABLE_HASH_KEY_SIZE_MAX				64
+
+/** LRU hash table parameters */
+struct rte_table_hash_key_lru_params {
+	/** Key size (number of bytes). Needs to be a non-zero multiple of 8,
+	not bigger than RTE_TABLE_HASH_KEY_SIZE_MAX. */
+	uint32_t key_size;
+
+	/** Maximum number of entries (and keys) in the table */
+	uint32_t n_entries;
+
+	/** Hash function */
+	rte_table_hash_op_hash f_hash;
+
+	/** Seed for the hash function */
+	uint64_t seed;
+
+	/** Byte offset within packet meta-data where the 4-byte key signature
+	is located */
+	uint32_t signature_offset;
+
+	/** Byte offset within packet meta-data where the key is located */
+	uint32_t key_offset;
+};
+
+/** LRU hash table operations for pre-computed key signature */
+extern struct rte_table_ops rte_table_hash_key_lru_ops;
+
+/** Extendible bucket hash table parameters */
+struct rte_table_hash_key_ext_params {
+	/** Key size (number of bytes). Needs to be a non-zero multiple of 8,
+	not bigger than RTE_TABLE_HASH_KEY_SIZE_MAX. */
+	uint32_t key_size;
+
+	/** Maximum number of entries (and keys) in the table */
+	uint32_t n_entries;
+
+	/** Number of entries (and keys) for hash table bucket extensions. Each
+	bucket is extended in increments of 4 keys. */
+	uint32_t n_entries_ext;
+
+	/** Hash function */
+	rte_table_hash_op_hash f_hash;
+
+	/** Seed for the hash function */
+	uint64_t seed;
+
+	/** Byte offset within packet meta-data where the 4-byte key signature
+	is located */
+	uint32_t signature_offset;
+
+	/** Byte offset within packet meta-data where the key is located */
+	uint32_t key_offset;
+};
+
+/** Extendible bucket hash table operations for pre-computed key signature */
+extern struct rte_table_ops rte_table_hash_key_ext_ops;
+
 /** Cuckoo hash table parameters */
 struct rte_table_hash_cuckoo_params {
     /** Key size (number of bytes */
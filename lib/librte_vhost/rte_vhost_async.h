@@ -0,0 +1,249 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _RTE_VHOST_ASYNC_H_
+#define _RTE_VHOST_ASYNC_H_
+
+/**
+ * @file
+ * Asynchronous copies in the vhost data path
+ *
+ * A virtqueue can be given a copy engine, to which the copies of the
+ * packet payloads between the mbufs and the guest buffers are submitted,
+ * instead of being done by the lcore calling the vhost burst functions.
+ * The guest is given back its buffers, in order, when the engine reports
+ * the copies completed.
+ *
+ * On such a virtqueue, the packets are submitted with
+ * rte_vhost_submit_enqueue_burst() or rte_vhost_submit_dequeue_burst(),
+ * and the completed ones are returned by rte_vhost_poll_enqueue_completed()
+ * or rte_vhost_poll_dequeue_completed(). rte_vhost_enqueue_burst() and
+ * rte_vhost_dequeue_burst() are not allowed on it.
+ *
+ * Only split virtqueues are supported, without dequeue zero copy.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <rte_mbuf.h>
+#include <rte_mempool.h>
+
+/**
+ * A contiguous copy.
+ */
+struct rte_vhost_iov {
+	void *src;  /**< Source address. */
+	void *dst;  /**< Destination address. */
+	size_t len; /**< Number of bytes to copy. */
+};
+
+/**
+ * The copies of one packet, which can be done in any order.
+ */
+struct rte_vhost_async_job {
+	struct rte_vhost_iov *iov; /**< Array of copies. */
+	uint16_t nr_iov;           /**< Number of copies. */
+};
+
+/**
+ * Copy engine of a virtqueue.
+ */
+struct rte_vhost_async_channel_ops {
+	/**
+	 * Submit the copy jobs of several packets. The jobs and their iov
+	 * arrays are only valid during the call.
+	 *
+	 * @param priv
+	 *   The private data given at registration.
+	 * @param jobs
+	 *   The array of jobs, one per packet.
+	 * @param count
+	 *   The number of jobs.
+	 * @return
+	 *   The number of jobs accepted, from the first one, or a negative
+	 *   value on error.
+	 */
+	int32_t (*transfer_data)(void *priv, struct rte_vhost_async_job *jobs,
+			uint16_t count);
+	/**
+	 * Get the number of jobs completed since the previous call. The jobs
+	 * are reported in the order they were submitted.
+	 *
+	 * @param priv
+	 *   The private data given at registration.
+	 * @param max_count
+	 *   The maximum number of completed jobs to report.
+	 * @return
+	 *   The number of completed jobs, or a negative value on error.
+	 */
+	int32_t (*check_completed_copies)(void *priv, uint16_t max_count);
+	/**
+	 * Optional, called when the channel is unregistered, or when the
+	 * device is destroyed, with no copy in flight. If the copies of a
+	 * stopped virtqueue are not completed within 5 seconds, their
+	 * packets are dropped and the function is called anyway: the
+	 * engine must not access their buffers anymore.
+	 *
+	 * @param priv
+	 *   The private data given at registration.
+	 */
+	void (*release)(void *priv);
+};
+
+/**
+ * Give a copy engine to a virtqueue. It is typically called from the
+ * new_device() callback.
+ *
+ * @param vid
+ *   The vhost device ID.
+ * @param queue_id
+ *   The virtqueue index.
+ * @param ops
+ *   The copy engine functions, copied by the function.
+ * @param priv
+ *   Private data given to the copy engine functions.
+ * @return
+ *   - 0: Success.
+ *   - -EINVAL: Invalid parameters, or the virtqueue is not set up.
+ *   - -EEXIST: The virtqueue already has a copy engine.
+ *   - -ENOTSUP: Packed virtqueue, or dequeue zero copy.
+ *   - -ENOMEM: Allocation failure.
+ */
+int rte_vhost_async_channel_register(int vid, uint16_t queue_id,
+		const struct rte_vhost_async_channel_ops *ops, void *priv);
+
+/**
+ * Remove the copy engine of a virtqueue.
+ *
+ * @param vid
+ *   The vhost device ID.
+ * @param queue_id
+ *   The virtqueue index.
+ * @return
+ *   - 0: Success.
+ *   - -EINVAL: Invalid parameters, or no copy engine.
+ *   - -EBUSY: Some packets are still in flight.
+ */
+int rte_vhost_async_channel_unregister(int vid, uint16_t queue_id);
+
+/**
+ * Submit packets to the guest RX virtqueue. The guest buffers are reserved
+ * and the copies submitted to the copy engine. The submitted mbufs belong
+ * to the library until they are returned by
+ * rte_vhost_poll_enqueue_completed().
+ *
+ * @param vid
+ *   The vhost device ID.
+ * @param queue_id
+ *   The virtqueue index.
+ * @param pkts
+ *   The packets to enqueue.
+ * @param count
+ *   The number of packets.
+ * @return
+ *   The number of packets submitted.
+ */
+uint16_t rte_vhost_submit_enqueue_burst(int vid, uint16_t queue_id,
+		struct rte_mbuf **pkts, uint16_t count);
+
+/**
+ * Give back to the guest the buffers whose copies are completed, and
+ * return the mbufs of the packets, to be freed by the caller.
+ *
+ * @param vid
+ *   The vhost device ID.
+ * @param queue_id
+ *   The virtqueue index.
+ * @param pkts
+ *   Filled with the completed packets.
+ * @param count
+ *   The size of the array.
+ * @return
+ *   The number of completed packets.
+ */
+uint16_t rte_vhost_poll_enqueue_completed(int vid, uint16_t queue_id,
+		struct rte_mbuf **pkts, uint16_t count);
+
+/**
+ * Submit the copies of the packets of the guest TX virtqueue into mbufs.
+ *
+ * @param vid
+ *   The vhost device ID.
+ * @param queue_id
+ *   The virtqueue index.
+ * @param mbuf_pool
+ *   The pool of the mbufs to allocate.
+ * @param count
+ *   The maximum number of packets to submit.
+ * @return
+ *   The number of packets submitted.
+ */
+uint16_t rte_vhost_submit_dequeue_burst(int vid, uint16_t queue_id,
+		struct rte_mempool *mbuf_pool, uint16_t count);
+
+/**
+ * Give back to the guest the buffers whose copies are completed, and
+ * return the received packets.
+ *
+ * @param vid
+ *   The vhost device ID.
+ * @param queue_id
+ *   The virtqueue index.
+ * @param pkts
+ *   Filled with the received packets.
+ * @param count
+ *   The size of the array.
+ * @return
+ *   The number of received packets.
+ */
+uint16_t rte_vhost_poll_dequeue_completed(int vid, uint16_t queue_id,
+		struct rte_mbuf **pkts, uint16_t count);
+
+/** Name of the service running the software copy engine. */
+#define RTE_VHOST_ASYNC_SW_SERVICE_NAME "vhost_async_sw"
+
+/**
+ * Give a software copy engine to a virtqueue. The copies are done by the
+ * service RTE_VHOST_ASYNC_SW_SERVICE_NAME, registered on the first call,
+ * which must be mapped to a service core and started by the application.
+ *
+ * @param vid
+ *   The vhost device ID.
+ * @param queue_id
+ *   The virtqueue index.
+ * @return
+ *   0 on success, a negative errno value otherwise.
+ */
+int rte_vhost_async_sw_register(int vid, uint16_t queue_id);
+
+#endif /* _RTE_VHOST_ASYNC_H_ */
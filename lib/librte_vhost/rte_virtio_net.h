@@ -83,6 +83,21 @@ int rte_vhost_feature_enable(uint64_t feature_mask);
 /* Returns currently supported vhost features */
 uint64_t rte_vhost_feature_get(void);
 
+/**
+ * Enable or disable the notifications of the guest when it adds buffers
+ * to a virtqueue. The notifications are written to the kick eventfd of
+ * the virtqueue, see rte_vhost_get_vring_kickfd().
+ *
+ * @param vid
+ *  virtio-net device ID
+ * @param queue_id
+ *  virtio queue index
+ * @param enable
+ *  1 to enable the notifications, 0 to disable them
+ *
+ * @return
+ *  0 on success, -1 on failure
+ */
 int rte_vhost_enable_guest_notification(int vid, uint16_t queue_id, int enable);
 
 /**
@@ -151,6 +166,49 @@ int rte_vhost_get_ifname(int vid, char *buf, size_t len);
  */
 uint16_t rte_vhost_avail_entries(int vid, uint16_t queue_id);
 
+/**
+ * Get the kick eventfd of a virtqueue, written by the guest when it adds
+ * buffers and the notifications are enabled. The caller may wait for the
+ * eventfd but must not read nor close it.
+ *
+ * @param vid
+ *  virtio-net device ID
+ * @param queue_id
+ *  virtio queue index
+ *
+ * @return
+ *  The eventfd, -1 on failure
+ */
+int rte_vhost_get_vring_kickfd(int vid, uint16_t queue_id);
+
+/**
+ * Statistics of the dequeue zero copy of a virtqueue. With zero copy, the
+ * guest buffers are held until the mbufs are freed, so packets are copied
+ * instead when too many buffers are held, or when the guest is about to
+ * run out of free buffers.
+ */
+struct rte_vhost_zcopy_stats {
+	uint64_t zcopy_pkts;        /**< Packets dequeued in zero copy. */
+	uint64_t copy_inflight_pkts; /**< Copied, too many buffers held. */
+	uint64_t copy_ring_low_pkts; /**< Copied, few free guest buffers. */
+};
+
+/**
+ * Get the dequeue zero copy statistics of a virtqueue.
+ *
+ * @param vid
+ *  virtio-net device ID
+ * @param queue_id
+ *  virtio queue index
+ * @param stats
+ *  Filled with the statistics.
+ *
+ * @return
+ *  0 on success, -1 on failure or if dequeue zero copy is disabled
+ */
+int rte_vhost_get_zcopy_stats(int vid, uint16_t queue_id,
+		struct rte_vhost_zcopy_stats *stats);
+
 /**
  * This function adds buffers to the virtio devices RX virtqueue. Buffers can
  * be received from the physical port or from another virtual device. A packet
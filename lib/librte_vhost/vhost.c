@@ -33,6 +33,7 @@
 
 #include <linux/vhost.h>
 #include <linux/virtio_net.h>
+#include <errno.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -66,7 +67,8 @@
 				(1ULL << VIRTIO_NET_F_GUEST_CSUM) | \
 				(1ULL << VIRTIO_NET_F_GUEST_TSO4) | \
 				(1ULL << VIRTIO_NET_F_GUEST_TSO6) | \
-				(1ULL << VIRTIO_RING_F_INDIRECT_DESC))
+				(1ULL << VIRTIO_RING_F_INDIRECT_DESC) | \
+				(1ULL << VIRTIO_F_RING_PACKED))
 
 uint64_t VHOST_FEATURES = VHOST_SUPPORTED_FEATURES;
 
@@ -104,8 +106,18 @@ cleanup_vq(struct vhost_virtqueue *vq, int destroy)
 void
 cleanup_device(struct virtio_net *dev, int destroy)
 {
+	struct vhost_virtqueue *vq;
 	uint32_t i;
 
+	/* The copies in flight must be done before unmapping the memory */
+	for (i = 0; i < dev->virt_qp_nb * VIRTIO_QNUM; i++) {
+		vq = dev->virtqueue[i];
+		if (vq->async) {
+			vhost_async_drain(dev, vq);
+			vhost_async_free(vq);
+		}
+	}
+
 	vhost_backend_cleanup(dev);
 
 	for (i = 0; i < dev->virt_qp_nb; i++) {
@@ -129,6 +141,8 @@ free_device(struct virtio_net *dev)
 
 		rte_free(rxq->shadow_used_ring);
 		rte_free(txq->shadow_used_ring);
+		vhost_async_free(rxq);
+		vhost_async_free(txq);
 
 		/* rxq and txq are allocated together as queue-pair */
 		rte_free(rxq);
@@ -170,6 +184,7 @@ reset_vring_queue(struct vhost_virtqueue *vq, int qp_idx)
 	int callfd;
 
 	callfd = vq->callfd;
+	vhost_async_free(vq);
 	init_vring_queue(vq, qp_idx);
 	vq->callfd = callfd;
 }
@@ -378,6 +393,26 @@ rte_vhost_avail_entries(int vid, uint16_t queue_id)
 	if (!vq->enabled)
 		return 0;
 
+	if (vq_is_packed(dev)) {
+		uint16_t idx = vq->last_avail_idx;
+		uint8_t wrap = vq->avail_wrap_counter;
+		uint16_t flags, count = 0;
+
+		/* count the available descriptors from the next avail slot */
+		while (count < vq->size) {
+			flags = *(volatile uint16_t *)&vq->desc_packed[idx].flags;
+			if (!!(flags & VRING_DESC_F_AVAIL) != wrap ||
+			    !!(flags & VRING_DESC_F_USED) == wrap)
+				break;
+			count++;
+			if (++idx >= vq->size) {
+				idx = 0;
+				wrap ^= 1;
+			}
+		}
+		return count;
+	}
+
 	return *(volatile uint16_t *)&vq->avail->idx - vq->last_used_idx;
 }
 
@@ -389,13 +424,139 @@ rte_vhost_enable_guest_notification(int vid, uint16_t queue_id, int enable)
 	if (dev == NULL)
 		return -1;
 
+	if (vq_is_packed(dev)) {
+		dev->virtqueue[queue_id]->device_event->flags = enable ?
+			VRING_EVENT_F_ENABLE : VRING_EVENT_F_DISABLE;
+		if (enable)
+			rte_smp_mb();
+		return 0;
+	}
+
 	if (enable) {
-		RTE_LOG(ERR, VHOST_CONFIG,
-			"guest notification isn't supported.\n");
+		dev->virtqueue[queue_id]->used->flags &=
+			~VRING_USED_F_NO_NOTIFY;
+		/* order the flag update with the next read of the avail ring */
+		rte_smp_mb();
+	} else
+		dev->virtqueue[queue_id]->used->flags |=
+			VRING_USED_F_NO_NOTIFY;
+	return 0;
+}
+
+int
+rte_vhost_get_vring_kickfd(int vid, uint16_t queue_id)
+{
+	struct virtio_net *dev = get_device(vid);
+
+	if (dev == NULL || queue_id >= dev->virt_qp_nb * VIRTIO_QNUM ||
+	    dev->virtqueue[queue_id] == NULL ||
+	    dev->virtqueue[queue_id]->kickfd < 0)
 		return -1;
+
+	return dev->virtqueue[queue_id]->kickfd;
+}
+
+void
+vhost_async_free(struct vhost_virtqueue *vq)
+{
+	struct vhost_async *async = vq->async;
+
+	if (async == NULL)
+		return;
+
+	if (async->ops.release)
+		async->ops.release(async->priv);
+
+	rte_free(async->pkts);
+	rte_free(async->hdrs);
+	rte_free(async->pkts_nr_used);
+	rte_free(async->used);
+	rte_free(async);
+	vq->async = NULL;
+}
+
+int
+rte_vhost_async_channel_register(int vid, uint16_t queue_id,
+		const struct rte_vhost_async_channel_ops *ops, void *priv)
+{
+	struct virtio_net *dev = get_device(vid);
+	struct vhost_virtqueue *vq;
+	struct vhost_async *async;
+
+	if (dev == NULL || ops == NULL || ops->transfer_data == NULL ||
+	    ops->check_completed_copies == NULL ||
+	    queue_id >= dev->virt_qp_nb * VIRTIO_QNUM)
+		return -EINVAL;
+
+	vq = dev->virtqueue[queue_id];
+	if (vq == NULL || vq->size == 0)
+		return -EINVAL;
+	if (vq->async != NULL)
+		return -EEXIST;
+	if (vq_is_packed(dev) || dev->dequeue_zero_copy)
+		return -ENOTSUP;
+
+	async = rte_zmalloc(NULL, sizeof(*async), RTE_CACHE_LINE_SIZE);
+	if (async == NULL)
+		return -ENOMEM;
+
+	async->pkts = rte_malloc(NULL, vq->size * sizeof(*async->pkts), 0);
+	async->hdrs = rte_malloc(NULL, vq->size * sizeof(*async->hdrs), 0);
+	async->pkts_nr_used = rte_malloc(NULL,
+			vq->size * sizeof(*async->pkts_nr_used), 0);
+	async->used = rte_malloc(NULL, vq->size * sizeof(*async->used), 0);
+	if (async->pkts == NULL || async->hdrs == NULL ||
+	    async->pkts_nr_used == NULL || async->used == NULL) {
+		rte_free(async->pkts);
+		rte_free(async->hdrs);
+		rte_free(async->pkts_nr_used);
+		rte_free(async->used);
+		rte_free(async);
+		return -ENOMEM;
 	}
 
-	dev->virtqueue[queue_id]->used->flags = VRING_USED_F_NO_NOTIFY;
+	async->ops = *ops;
+	async->priv = priv;
+	async->size = vq->size;
+	vq->async = async;
+
+	RTE_LOG(INFO, VHOST_CONFIG,
+		"(%d) copy engine registered on vring %u\n", vid, queue_id);
+
+	return 0;
+}
+
+int
+rte_vhost_async_channel_unregister(int vid, uint16_t queue_id)
+{
+	struct virtio_net *dev = get_device(vid);
+	struct vhost_virtqueue *vq;
+
+	if (dev == NULL || queue_id >= dev->virt_qp_nb * VIRTIO_QNUM)
+		return -EINVAL;
+
+	vq = dev->virtqueue[queue_id];
+	if (vq == NULL || vq->async == NULL)
+		return -EINVAL;
+	if (vq->async->pkts_inflight != 0)
+		return -EBUSY;
+
+	vhost_async_free(vq);
+
+	return 0;
+}
+
+int
+rte_vhost_get_zcopy_stats(int vid, uint16_t queue_id,
+		struct rte_vhost_zcopy_stats *stats)
+{
+	struct virtio_net *dev = get_device(vid);
+
+	if (dev == NULL || stats == NULL || !dev->dequeue_zero_copy ||
+	    queue_id >= dev->virt_qp_nb * VIRTIO_QNUM)
+		return -1;
+
+	*stats = dev->virtqueue[queue_id]->zcopy_stats;
 	return 0;
 }
 
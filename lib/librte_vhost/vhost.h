@@ -43,6 +43,7 @@
 #include <rte_log.h>
 
 #include "rte_virtio_net.h"
+#include "rte_vhost_async.h"
 
 /* Used to indicate that the device is running on a data core */
 #define VIRTIO_DEV_RUNNING 1
@@ -75,13 +76,90 @@ struct zcopy_mbuf {
 };
 TAILQ_HEAD(zcopy_mbuf_list, zcopy_mbuf);
 
+/*
+ * Packed virtqueue layout, from the virtio 1.1 specification, for the
+ * kernels which do not define it.
+ */
+#ifndef VIRTIO_F_RING_PACKED
+ #define VIRTIO_F_RING_PACKED 34
+#endif
+
+#ifndef VRING_PACKED_DESC_F_AVAIL
+struct vring_packed_desc {
+	uint64_t addr;
+	uint32_t len;
+	uint16_t id;
+	uint16_t flags;
+};
+
+struct vring_packed_desc_event {
+	uint16_t off_wrap;
+	uint16_t flags;
+};
+#endif
+
+/* Descriptor flags masks, the kernel only defines the bit numbers */
+#define VRING_DESC_F_AVAIL	(1 << 7)
+#define VRING_DESC_F_USED	(1 << 15)
+
+#define VRING_EVENT_F_ENABLE	0x0
+#define VRING_EVENT_F_DISABLE	0x1
+#define VRING_EVENT_F_DESC	0x2
+
+/*
+ * Used element of a packed ring, written back in the slot of the first
+ * descriptor of the chain; count is the number of descriptors of the chain.
+ */
+struct vring_used_elem_packed {
+	uint16_t id;
+	uint32_t len;
+	uint32_t count;
+};
+
+/* Maximum number of copies of a burst submitted to a copy engine */
+#define VHOST_ASYNC_IOV_MAX 2048
+/* Maximum wait for the copies in flight of a stopped virtqueue */
+#define VHOST_ASYNC_DRAIN_TIMEOUT_MS 5000
+
+/*
+ * Copies in flight on a virtqueue with a copy engine. The packets and
+ * their used elements are kept in submission order, in rings of the
+ * virtqueue size, until the engine reports them completed.
+ */
+struct vhost_async {
+	struct rte_vhost_async_channel_ops ops;
+	void *priv;
+
+	uint16_t size;
+	uint16_t pkts_idx;	/* oldest packet in flight */
+	uint16_t pkts_inflight;
+	uint16_t used_idx;	/* oldest used element in flight */
+	uint16_t used_inflight;
+
+	struct rte_mbuf **pkts;
+	struct virtio_net_hdr **hdrs;	/* dequeue offload headers */
+	uint16_t *pkts_nr_used;		/* used elements of each packet */
+	struct vring_used_elem *used;
+
+	struct rte_vhost_iov iov[VHOST_ASYNC_IOV_MAX];
+};
+
 /**
  * Structure contains variables relevant to RX/TX virtqueues.
  */
 struct vhost_virtqueue {
-	struct vring_desc	*desc;
-	struct vring_avail	*avail;
-	struct vring_used	*used;
+	union {
+		struct vring_desc	*desc;
+		struct vring_packed_desc *desc_packed;
+	};
+	union {
+		struct vring_avail	*avail;
+		struct vring_packed_desc_event *driver_event;
+	};
+	union {
+		struct vring_used	*used;
+		struct vring_packed_desc_event *device_event;
+	};
 	uint32_t		size;
 
 	uint16_t		last_avail_idx;
@@ -105,9 +183,20 @@ struct vhost_virtqueue {
 	uint16_t		last_zmbuf_idx;
 	struct zcopy_mbuf	*zmbufs;
 	struct zcopy_mbuf_list	zmbuf_list;
+	struct rte_vhost_zcopy_stats zcopy_stats;
 
-	struct vring_used_elem  *shadow_used_ring;
+	union {
+		struct vring_used_elem  *shadow_used_ring;
+		struct vring_used_elem_packed *shadow_used_packed;
+	};
 	uint16_t                shadow_used_idx;
+
+	/* Packed ring wrap counters, of the next avail and used slots */
+	uint8_t			avail_wrap_counter;
+	uint8_t			used_wrap_counter;
+
+	/* Copy engine, NULL if the copies are synchronous */
+	struct vhost_async	*async;
 } __rte_cache_aligned;
 
 /* Old kernels have no such macro defined */
@@ -172,6 +261,12 @@ struct virtio_net {
 	struct guest_page       *guest_pages;
 } __rte_cache_aligned;
 
+static inline int
+vq_is_packed(struct virtio_net *dev)
+{
+	return !!(dev->features & (1ULL << VIRTIO_F_RING_PACKED));
+}
+
 /**
  * Information relating to memory regions including offsets to
  * addresses in QEMUs memory file.
@@ -250,6 +345,38 @@ gpa_to_vva(struct virtio_net *dev, uint64_t gpa)
 	return 0;
 }
 
+/*
+ * Convert a guest buffer to host virtual address, trying first the region
+ * of the previous conversion. Returns 0 if the buffer is not contained in
+ * a single region.
+ */
+static inline uint64_t __attribute__((always_inline))
+gpa_to_vva_cached(struct virtio_net *dev, struct virtio_memory_region **last,
+		  uint64_t gpa, uint64_t len)
+{
+	struct virtio_memory_region *reg = *last;
+	uint32_t i;
+
+	if (unlikely(gpa + len < gpa))
+		return 0;
+
+	if (likely(reg != NULL && gpa >= reg->guest_phys_addr &&
+		   gpa + len <= reg->guest_phys_addr + reg->size))
+		return gpa - reg->guest_phys_addr + reg->host_user_addr;
+
+	for (i = 0; i < dev->mem->nregions; i++) {
+		reg = &dev->mem->regions[i];
+		if (gpa >= reg->guest_phys_addr &&
+		    gpa + len <= reg->guest_phys_addr + reg->size) {
+			*last = reg;
+			return gpa - reg->guest_phys_addr +
+			       reg->host_user_addr;
+		}
+	}
+
+	return 0;
+}
+
 /* Convert guest physical address to host physical address */
 static inline phys_addr_t __attribute__((always_inline))
 gpa_to_hpa(struct virtio_net *dev, uint64_t gpa, uint64_t size)
@@ -290,4 +417,7 @@ void vhost_enable_dequeue_zero_copy(int vid);
  */
 void vhost_backend_cleanup(struct virtio_net *dev);
 
+int vhost_async_drain(struct virtio_net *dev, struct vhost_virtqueue *vq);
+void vhost_async_free(struct vhost_virtqueue *vq);
+
 #endif /* _VHOST_NET_CDEV_H_ */
@@ -0,0 +1,273 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2017 Intel Corporation. All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Software copy engine of the vhost asynchronous data path.
+ *
+ * Each virtqueue is given a channel: a single producer, single consumer
+ * ring of jobs, filled by the lcore calling the vhost burst functions and
+ * emptied by a service, which does the copies on a service core.
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include <rte_common.h>
+#include <rte_log.h>
+#include <rte_malloc.h>
+#include <rte_memcpy.h>
+#include <rte_lcore.h>
+#include <rte_service.h>
+
+#include "vhost.h"
+
+#define ASYNC_SW_CHANNELS_MAX	64
+#define ASYNC_SW_NB_JOBS	1024
+#define ASYNC_SW_NB_IOVS	4096
+/* Jobs copied by the service per channel and call */
+#define ASYNC_SW_BURST		64
+
+struct async_sw_job {
+	uint32_t iov_start;
+	uint32_t iov_end;	/* iov_tail once the job is done */
+	uint16_t nr_iov;
+};
+
+struct async_sw_channel {
+	/* Written by the vhost data path */
+	volatile uint32_t job_head;
+	uint32_t iov_head;
+	uint32_t reported;
+	volatile int released;
+
+	/* Written by the service */
+	volatile uint32_t job_tail __rte_cache_aligned;
+	volatile uint32_t iov_tail;
+
+	struct async_sw_job jobs[ASYNC_SW_NB_JOBS] __rte_cache_aligned;
+	struct rte_vhost_iov iov[ASYNC_SW_NB_IOVS];
+};
+
+static struct async_sw_channel *volatile async_sw_channels[ASYNC_SW_CHANNELS_MAX];
+static int async_sw_service_registered;
+
+static int32_t
+async_sw_transfer_data(void *priv, struct rte_vhost_async_job *jobs,
+		       uint16_t count)
+{
+	struct async_sw_channel *ch = priv;
+	struct async_sw_job *job;
+	uint32_t job_head = ch->job_head;
+	uint32_t iov_head = ch->iov_head;
+	uint32_t pos, pad;
+	uint16_t i;
+
+	for (i = 0; i < count; i++) {
+		if (job_head - ch->job_tail == ASYNC_SW_NB_JOBS)
+			break;
+
+		/* Keep the copies of a job contiguous */
+		pos = iov_head % ASYNC_SW_NB_IOVS;
+		pad = 0;
+		if (pos + jobs[i].nr_iov > ASYNC_SW_NB_IOVS) {
+			pad = ASYNC_SW_NB_IOVS - pos;
+			pos = 0;
+		}
+		if (iov_head + pad + jobs[i].nr_iov - ch->iov_tail >
+				ASYNC_SW_NB_IOVS)
+			break;
+
+		memcpy(&ch->iov[pos], jobs[i].iov,
+		       jobs[i].nr_iov * sizeof(struct rte_vhost_iov));
+		iov_head += pad + jobs[i].nr_iov;
+
+		job = &ch->jobs[job_head % ASYNC_SW_NB_JOBS];
+		job->iov_start = pos;
+		job->iov_end = iov_head;
+		job->nr_iov = jobs[i].nr_iov;
+		job_head++;
+	}
+
+	/* Publish the jobs once written */
+	rte_smp_wmb();
+	ch->job_head = job_head;
+	ch->iov_head = iov_head;
+
+	return i;
+}
+
+static int32_t
+async_sw_check_completed_copies(void *priv, uint16_t max_count)
+{
+	struct async_sw_channel *ch = priv;
+	uint32_t n;
+
+	n = RTE_MIN(ch->job_tail - ch->reported, (uint32_t)max_count);
+	/* Read the copied data after the completion */
+	rte_smp_rmb();
+	ch->reported += n;
+
+	return n;
+}
+
+static void
+async_sw_release(void *priv)
+{
+	struct async_sw_channel *ch = priv;
+
+	/* Freed by the service, which may still be looking at it */
+	ch->released = 1;
+}
+
+static const struct rte_vhost_async_channel_ops async_sw_ops = {
+	.transfer_data = async_sw_transfer_data,
+	.check_completed_copies = async_sw_check_completed_copies,
+	.release = async_sw_release,
+};
+
+static int
+async_sw_channel_run(struct async_sw_channel *ch)
+{
+	struct async_sw_job *job;
+	struct rte_vhost_iov *iov;
+	uint32_t job_tail = ch->job_tail;
+	uint32_t job_head = ch->job_head;
+	uint16_t nb = 0;
+	uint16_t i;
+
+	/* Read the jobs after their publication */
+	rte_smp_rmb();
+
+	while (job_tail != job_head && nb < ASYNC_SW_BURST) {
+		job = &ch->jobs[job_tail % ASYNC_SW_NB_JOBS];
+		iov = &ch->iov[job->iov_start];
+		for (i = 0; i < job->nr_iov; i++)
+			rte_memcpy(iov[i].dst, iov[i].src, iov[i].len);
+
+		/* Complete the job once copied */
+		rte_smp_wmb();
+		ch->iov_tail = job->iov_end;
+		ch->job_tail = ++job_tail;
+		nb++;
+	}
+
+	return nb;
+}
+
+static int32_t
+async_sw_service_run(void *args __rte_unused)
+{
+	struct async_sw_channel *ch;
+	int done = 0;
+	int i;
+
+	for (i = 0; i < ASYNC_SW_CHANNELS_MAX; i++) {
+		ch = async_sw_channels[i];
+		if (ch == NULL)
+			continue;
+
+		if (ch->released) {
+			async_sw_channels[i] = NULL;
+			rte_free(ch);
+			continue;
+		}
+
+		done += async_sw_channel_run(ch);
+	}
+
+	return done ? 0 : -EAGAIN;
+}
+
+static int
+async_sw_service_register(void)
+{
+	struct rte_service_spec spec;
+	uint32_t id;
+	int ret;
+
+	if (async_sw_service_registered)
+		return 0;
+
+	memset(&spec, 0, sizeof(spec));
+	snprintf(spec.name, sizeof(spec.name), "%s",
+		 RTE_VHOST_ASYNC_SW_SERVICE_NAME);
+	spec.callback = async_sw_service_run;
+	spec.socket_id = SOCKET_ID_ANY;
+
+	ret = rte_service_register(&spec, &id);
+	if (ret < 0) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"failed to register the %s service\n", spec.name);
+		return ret;
+	}
+
+	async_sw_service_registered = 1;
+
+	return 0;
+}
+
+int
+rte_vhost_async_sw_register(int vid, uint16_t queue_id)
+{
+	struct async_sw_channel *ch;
+	int ret;
+	int i;
+
+	ret = async_sw_service_register();
+	if (ret < 0)
+		return ret;
+
+	for (i = 0; i < ASYNC_SW_CHANNELS_MAX; i++)
+		if (async_sw_channels[i] == NULL)
+			break;
+	if (i == ASYNC_SW_CHANNELS_MAX)
+		return -ENOSPC;
+
+	ch = rte_zmalloc_socket("vhost_async_sw", sizeof(*ch),
+				RTE_CACHE_LINE_SIZE,
+				rte_vhost_get_numa_node(vid));
+	if (ch == NULL)
+		return -ENOMEM;
+
+	ret = rte_vhost_async_channel_register(vid, queue_id,
+					       &async_sw_ops, ch);
+	if (ret < 0) {
+		rte_free(ch);
+		return ret;
+	}
+
+	/* Hand the channel to the service */
+	rte_smp_wmb();
+	async_sw_channels[i] = ch;
+
+	return 0;
+}
@@ -170,6 +170,13 @@ vhost_user_set_features(struct virtio_net *dev, uint64_t features)
 		(dev->features & (1 << VIRTIO_NET_F_MRG_RXBUF)) ? "on" : "off",
 		(dev->features & (1ULL << VIRTIO_F_VERSION_1)) ? "on" : "off");
 
+	if (vq_is_packed(dev) && dev->dequeue_zero_copy) {
+		RTE_LOG(WARNING, VHOST_CONFIG,
+			"(%d) dequeue zero copy is not supported with packed "
+			"virtqueues; zero copy is force disabled\n", dev->vid);
+		dev->dequeue_zero_copy = 0;
+	}
+
 	return 0;
 }
 
@@ -198,7 +205,12 @@ vhost_user_set_vring_num(struct virtio_net *dev,
 		}
 	}
 
-	vq->shadow_used_ring = rte_malloc(NULL,
+	if (vq_is_packed(dev))
+		vq->shadow_used_packed = rte_malloc(NULL,
+				vq->size * sizeof(struct vring_used_elem_packed),
+				RTE_CACHE_LINE_SIZE);
+	else
+		vq->shadow_used_ring = rte_malloc(NULL,
 				vq->size * sizeof(struct vring_used_elem),
 				RTE_CACHE_LINE_SIZE);
 	if (!vq->shadow_used_ring) {
@@ -363,7 +375,7 @@ vhost_user_set_vring_addr(struct virtio_net *dev, struct vhost_vring_addr *addr)
 		return -1;
 	}
 
-	if (vq->last_used_idx != vq->used->idx) {
+	if (!vq_is_packed(dev) && vq->last_used_idx != vq->used->idx) {
 		RTE_LOG(WARNING, VHOST_CONFIG,
 			"last_used_idx (%u) and vq->used->idx (%u) mismatches; "
 			"some packets maybe resent for Tx and dropped for Rx\n",
@@ -393,8 +405,19 @@ static int
 vhost_user_set_vring_base(struct virtio_net *dev,
 			  struct vhost_vring_state *state)
 {
-	dev->virtqueue[state->index]->last_used_idx  = state->num;
-	dev->virtqueue[state->index]->last_avail_idx = state->num;
+	struct vhost_virtqueue *vq = dev->virtqueue[state->index];
+
+	if (vq_is_packed(dev)) {
+		/* the wrap counter is given in bit 15 of the index */
+		vq->last_used_idx = state->num & 0x7fff;
+		vq->last_avail_idx = state->num & 0x7fff;
+		vq->used_wrap_counter = !!(state->num & (1 << 15));
+		vq->avail_wrap_counter = !!(state->num & (1 << 15));
+		return 0;
+	}
+
+	vq->last_used_idx  = state->num;
+	vq->last_avail_idx = state->num;
 
 	return 0;
 }
@@ -728,8 +751,16 @@ vhost_user_get_vring_base(struct virtio_net *dev,
 		notify_ops->destroy_device(dev->vid);
 	}
 
+	/* Give back to the guest the buffers of the copies in flight */
+	if (vq->async) {
+		vhost_async_drain(dev, vq);
+		vhost_async_free(vq);
+	}
+
 	/* Here we are safe to get the last used index */
 	state->num = vq->last_used_idx;
+	if (vq_is_packed(dev))
+		state->num |= vq->used_wrap_counter << 15;
 
 	RTE_LOG(INFO, VHOST_CONFIG,
 		"vring base idx:%d file:%d\n", state->index, state->num);
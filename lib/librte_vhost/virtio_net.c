@@ -37,6 +37,7 @@
 
 #include <rte_mbuf.h>
 #include <rte_memcpy.h>
+#include <rte_cycles.h>
 #include <rte_ether.h>
 #include <rte_ip.h>
 #include <rte_virtio_net.h>
@@ -48,6 +49,12 @@
 #include "vhost.h"
 
 #define MAX_PKT_BURST 32
+/* Guest buffers held at most by dequeue zero copy */
+#define VHOST_ZCOPY_MAX_INFLIGHT(vq) ((vq)->size / 2)
+/* Free guest buffers below which dequeue zero copy is not used */
+#define VHOST_ZCOPY_RING_LOW(vq) ((vq)->size / 8)
+/* Packets enqueued at once when each fits in a single descriptor */
+#define VHOST_RX_BATCH 4
 #define VHOST_LOG_PAGE	4096
 
 static inline void __attribute__((always_inline))
@@ -141,6 +148,33 @@ update_shadow_used_ring(struct vhost_virtqueue *vq,
 	vq->shadow_used_ring[i].len = len;
 }
 
+/*
+ * Copies of a burst collected for a copy engine, instead of being done
+ * by the copy functions.
+ */
+struct async_iov_iter {
+	struct rte_vhost_iov *iov;
+	uint16_t nr_iov;
+	uint16_t max_iov;
+	struct virtio_net_hdr *hdr;	/* dequeue offload header */
+};
+
+static inline int __attribute__((always_inline))
+async_iov_add(struct async_iov_iter *it, void *dst, void *src, size_t len)
+{
+	struct rte_vhost_iov *iov;
+
+	if (unlikely(it->nr_iov >= it->max_iov))
+		return -1;
+
+	iov = &it->iov[it->nr_iov++];
+	iov->src = src;
+	iov->dst = dst;
+	iov->len = len;
+
+	return 0;
+}
+
 static void
 virtio_enqueue_offload(struct rte_mbuf *m_buf, struct virtio_net_hdr *net_hdr)
 {
@@ -288,7 +322,7 @@ virtio_dev_rx(struct virtio_net *dev, uint16_t queue_id,
 	}
 
 	vq = dev->virtqueue[queue_id];
-	if (unlikely(vq->enabled == 0))
+	if (unlikely(vq->enabled == 0 || vq->async != NULL))
 		return 0;
 
 	avail_idx = *((volatile uint16_t *)&vq->avail->idx);
@@ -457,7 +491,8 @@ reserve_avail_buf_mergeable(struct virtio_net *dev, struct vhost_virtqueue *vq,
 
 static inline int __attribute__((always_inline))
 copy_mbuf_to_desc_mergeable(struct virtio_net *dev, struct rte_mbuf *m,
-			    struct buf_vector *buf_vec, uint16_t num_buffers)
+			    struct buf_vector *buf_vec, uint16_t num_buffers,
+			    struct async_iov_iter *it)
 {
 	struct virtio_net_hdr_mrg_rxbuf virtio_hdr = {{0, 0, 0, 0, 0, 0}, 0};
 	uint32_t vec_idx = 0;
@@ -522,13 +557,22 @@ copy_mbuf_to_desc_mergeable(struct virtio_net *dev, struct rte_mbuf *m,
 		}
 
 		cpy_len = RTE_MIN(desc_avail, mbuf_avail);
-		rte_memcpy((void *)((uintptr_t)(desc_addr + desc_offset)),
-			rte_pktmbuf_mtod_offset(m, void *, mbuf_offset),
-			cpy_len);
+		if (it) {
+			if (unlikely(async_iov_add(it,
+				(void *)((uintptr_t)(desc_addr + desc_offset)),
+				rte_pktmbuf_mtod_offset(m, void *, mbuf_offset),
+				cpy_len) < 0))
+				return -1;
+		} else {
+			rte_memcpy((void *)((uintptr_t)(desc_addr +
+							desc_offset)),
+				rte_pktmbuf_mtod_offset(m, void *, mbuf_offset),
+				cpy_len);
+			PRINT_PACKET(dev, (uintptr_t)(desc_addr + desc_offset),
+				cpy_len, 0);
+		}
 		vhost_log_write(dev, buf_vec[vec_idx].buf_addr + desc_offset,
 			cpy_len);
-		PRINT_PACKET(dev, (uintptr_t)(desc_addr + desc_offset),
-			cpy_len, 0);
 
 		mbuf_avail  -= cpy_len;
 		mbuf_offset += cpy_len;
@@ -539,6 +583,72 @@ copy_mbuf_to_desc_mergeable(struct virtio_net *dev, struct rte_mbuf *m,
 	return 0;
 }
 
+/*
+ * Enqueue VHOST_RX_BATCH single-segment packets into as many available
+ * buffers made of one descriptor each, which is the common case for small
+ * packets. The descriptors are all checked before anything is written, so
+ * that on failure the caller can fall back to the generic path.
+ */
+static inline int __attribute__((always_inline))
+virtio_dev_rx_batch(struct virtio_net *dev, struct vhost_virtqueue *vq,
+		    struct rte_mbuf **pkts,
+		    struct virtio_memory_region **last_reg)
+{
+	uint16_t mask = vq->size - 1;
+	uint16_t desc_idx[VHOST_RX_BATCH];
+	uint64_t desc_addr[VHOST_RX_BATCH];
+	uint32_t pkt_len[VHOST_RX_BATCH];
+	struct vring_desc desc[VHOST_RX_BATCH];
+	uint16_t i;
+
+	for (i = 0; i < VHOST_RX_BATCH; i++) {
+		desc_idx[i] = vq->avail->ring[(vq->last_avail_idx + i) & mask];
+		if (unlikely(desc_idx[i] >= vq->size))
+			return -1;
+		rte_prefetch0(&vq->desc[desc_idx[i]]);
+	}
+
+	/*
+	 * The descriptors are read once: the guest may change them while
+	 * they are used.
+	 */
+	for (i = 0; i < VHOST_RX_BATCH; i++) {
+		desc[i] = *(volatile struct vring_desc *)&vq->desc[desc_idx[i]];
+		pkt_len[i] = pkts[i]->pkt_len + dev->vhost_hlen;
+		if (unlikely(pkts[i]->nb_segs != 1 ||
+			     (desc[i].flags & (VRING_DESC_F_NEXT |
+					       VRING_DESC_F_INDIRECT)) ||
+			     desc[i].len < pkt_len[i]))
+			return -1;
+
+		desc_addr[i] = gpa_to_vva_cached(dev, last_reg, desc[i].addr,
+						 pkt_len[i]);
+		if (unlikely(!desc_addr[i]))
+			return -1;
+
+		rte_prefetch0((void *)(uintptr_t)desc_addr[i]);
+	}
+
+	for (i = 0; i < VHOST_RX_BATCH; i++) {
+		struct virtio_net_hdr_mrg_rxbuf virtio_hdr = {
+			{0, 0, 0, 0, 0, 0}, 1};
+
+		virtio_enqueue_offload(pkts[i], &virtio_hdr.hdr);
+		copy_virtio_net_hdr(dev, desc_addr[i], virtio_hdr);
+		rte_memcpy((void *)((uintptr_t)(desc_addr[i] +
+						dev->vhost_hlen)),
+			rte_pktmbuf_mtod(pkts[i], void *),
+			pkt_len[i] - dev->vhost_hlen);
+		vhost_log_write(dev, desc[i].addr, pkt_len[i]);
+		PRINT_PACKET(dev, (uintptr_t)desc_addr[i], pkt_len[i], 0);
+
+		update_shadow_used_ring(vq, desc_idx[i], pkt_len[i]);
+	}
+	vq->last_avail_idx += VHOST_RX_BATCH;
+
+	return 0;
+}
+
 static inline uint32_t __attribute__((always_inline))
 virtio_dev_merge_rx(struct virtio_net *dev, uint16_t queue_id,
 	struct rte_mbuf **pkts, uint32_t count)
@@ -548,6 +658,7 @@ virtio_dev_merge_rx(struct virtio_net *dev, uint16_t queue_id,
 	uint16_t num_buffers;
 	struct buf_vector buf_vec[BUF_VECTOR_MAX];
 	uint16_t avail_head;
+	struct virtio_memory_region *last_reg = NULL;
 
 	LOG_DEBUG(VHOST_DATA, "(%d) %s\n", dev->vid, __func__);
 	if (unlikely(!is_valid_virt_queue_idx(queue_id, 0, dev->virt_qp_nb))) {
@@ -557,7 +668,7 @@ virtio_dev_merge_rx(struct virtio_net *dev, uint16_t queue_id,
 	}
 
 	vq = dev->virtqueue[queue_id];
-	if (unlikely(vq->enabled == 0))
+	if (unlikely(vq->enabled == 0 || vq->async != NULL))
 		return 0;
 
 	count = RTE_MIN((uint32_t)MAX_PKT_BURST, count);
@@ -571,6 +682,15 @@ virtio_dev_merge_rx(struct virtio_net *dev, uint16_t queue_id,
 	for (pkt_idx = 0; pkt_idx < count; pkt_idx++) {
 		uint32_t pkt_len = pkts[pkt_idx]->pkt_len + dev->vhost_hlen;
 
+		if (count - pkt_idx >= VHOST_RX_BATCH &&
+		    (uint16_t)(avail_head - vq->last_avail_idx) >=
+				VHOST_RX_BATCH &&
+		    virtio_dev_rx_batch(dev, vq, &pkts[pkt_idx],
+					&last_reg) == 0) {
+			pkt_idx += VHOST_RX_BATCH - 1;
+			continue;
+		}
+
 		if (unlikely(reserve_avail_buf_mergeable(dev, vq,
 						pkt_len, buf_vec, &num_buffers,
 						avail_head) < 0)) {
@@ -586,7 +706,7 @@ virtio_dev_merge_rx(struct virtio_net *dev, uint16_t queue_id,
 			vq->last_avail_idx + num_buffers);
 
 		if (copy_mbuf_to_desc_mergeable(dev, pkts[pkt_idx],
-						buf_vec, num_buffers) < 0) {
+						buf_vec, num_buffers, NULL) < 0) {
 			vq->shadow_used_idx -= num_buffers;
 			break;
 		}
@@ -609,6 +729,230 @@ virtio_dev_merge_rx(struct virtio_net *dev, uint16_t queue_id,
 	return pkt_idx;
 }
 
+static inline int __attribute__((always_inline))
+desc_is_avail(struct vring_packed_desc *desc, uint8_t wrap_counter)
+{
+	uint16_t flags = *((volatile uint16_t *)&desc->flags);
+
+	return !!(flags & VRING_DESC_F_AVAIL) == wrap_counter &&
+		!!(flags & VRING_DESC_F_USED) != wrap_counter;
+}
+
+/*
+ * Gather the descriptor chain starting at a packed ring slot into a split
+ * style descriptor table, chained by next, for the copy functions. The
+ * buffer ID of the chain is the one of its last descriptor.
+ */
+static inline int __attribute__((always_inline))
+fetch_packed_chain(struct virtio_net *dev, struct vhost_virtqueue *vq,
+		   uint16_t avail_idx, struct vring_desc *descs,
+		   uint16_t *nr_descs, uint16_t *nr_slots, uint16_t *buf_id)
+{
+	struct vring_packed_desc *ring = vq->desc_packed;
+	struct vring_packed_desc *idesc;
+	uint16_t n = 0, slots = 0;
+	uint16_t flags, i, nr_idesc;
+
+	do {
+		if (unlikely(slots >= vq->size))
+			return -1;
+
+		flags = ring[avail_idx].flags;
+		if (flags & VRING_DESC_F_INDIRECT) {
+			idesc = (struct vring_packed_desc *)(uintptr_t)
+				gpa_to_vva(dev, ring[avail_idx].addr);
+			if (unlikely(!idesc))
+				return -1;
+
+			nr_idesc = ring[avail_idx].len / sizeof(*idesc);
+			for (i = 0; i < nr_idesc; i++, n++) {
+				if (unlikely(n >= BUF_VECTOR_MAX))
+					return -1;
+				descs[n].addr = idesc[i].addr;
+				descs[n].len = idesc[i].len;
+				descs[n].flags = idesc[i].flags &
+					VRING_DESC_F_WRITE;
+				descs[n].next = n + 1;
+			}
+		} else {
+			if (unlikely(n >= BUF_VECTOR_MAX))
+				return -1;
+			descs[n].addr = ring[avail_idx].addr;
+			descs[n].len = ring[avail_idx].len;
+			descs[n].flags = flags & VRING_DESC_F_WRITE;
+			descs[n].next = n + 1;
+			n++;
+		}
+
+		*buf_id = ring[avail_idx].id;
+		slots++;
+		if (++avail_idx >= vq->size)
+			avail_idx = 0;
+	} while (flags & VRING_DESC_F_NEXT);
+
+	if (unlikely(n == 0))
+		return -1;
+	for (i = 0; i + 1 < n; i++)
+		descs[i].flags |= VRING_DESC_F_NEXT;
+
+	*nr_descs = n;
+	*nr_slots = slots;
+
+	return 0;
+}
+
+/*
+ * Write the used elements back in the descriptor ring. The driver polls
+ * the flags of the next slot only, so the flags of the first element are
+ * written last to expose the whole batch at once.
+ */
+static inline void __attribute__((always_inline))
+flush_shadow_used_ring_packed(struct vhost_virtqueue *vq)
+{
+	struct vring_packed_desc *ring = vq->desc_packed;
+	struct vring_used_elem_packed *elem;
+	uint16_t head_idx = vq->last_used_idx;
+	uint16_t used_idx = head_idx;
+	uint16_t head_flags = 0, flags;
+	uint16_t i;
+
+	for (i = 0; i < vq->shadow_used_idx; i++) {
+		elem = &vq->shadow_used_packed[i];
+
+		flags = elem->len ? VRING_DESC_F_WRITE : 0;
+		if (vq->used_wrap_counter)
+			flags |= VRING_DESC_F_AVAIL | VRING_DESC_F_USED;
+
+		ring[used_idx].id = elem->id;
+		ring[used_idx].len = elem->len;
+		if (i == 0)
+			head_flags = flags;
+		else
+			ring[used_idx].flags = flags;
+
+		used_idx += elem->count;
+		if (used_idx >= vq->size) {
+			used_idx -= vq->size;
+			vq->used_wrap_counter ^= 1;
+		}
+	}
+	vq->last_used_idx = used_idx;
+
+	rte_smp_wmb();
+	ring[head_idx].flags = head_flags;
+}
+
+static inline void __attribute__((always_inline))
+vhost_vring_call_packed(struct vhost_virtqueue *vq)
+{
+	/* flush the used descriptors before we read the driver flags */
+	rte_mb();
+
+	if (vq->driver_event->flags != VRING_EVENT_F_DISABLE &&
+	    vq->callfd >= 0)
+		eventfd_write(vq->callfd, (eventfd_t)1);
+}
+
+static inline uint32_t __attribute__((always_inline))
+virtio_dev_rx_packed(struct virtio_net *dev, uint16_t queue_id,
+	struct rte_mbuf **pkts, uint32_t count)
+{
+	struct vhost_virtqueue *vq;
+	struct vring_used_elem_packed *elem;
+	struct buf_vector buf_vec[BUF_VECTOR_MAX];
+	struct vring_desc descs[BUF_VECTOR_MAX];
+	uint16_t nr_descs, nr_slots, buf_id, num_buffers;
+	uint16_t avail_idx, i;
+	uint32_t pkt_idx, vec_idx, size, len;
+	uint8_t wrap;
+	int mergeable;
+
+	LOG_DEBUG(VHOST_DATA, "(%d) %s\n", dev->vid, __func__);
+	if (unlikely(!is_valid_virt_queue_idx(queue_id, 0, dev->virt_qp_nb))) {
+		RTE_LOG(ERR, VHOST_DATA, "(%d) %s: invalid virtqueue idx %d.\n",
+			dev->vid, __func__, queue_id);
+		return 0;
+	}
+
+	vq = dev->virtqueue[queue_id];
+	if (unlikely(vq->enabled == 0))
+		return 0;
+
+	count = RTE_MIN((uint32_t)MAX_PKT_BURST, count);
+	if (count == 0)
+		return 0;
+
+	mergeable = !!(dev->features & (1 << VIRTIO_NET_F_MRG_RXBUF));
+	vq->shadow_used_idx = 0;
+	for (pkt_idx = 0; pkt_idx < count; pkt_idx++) {
+		size = pkts[pkt_idx]->pkt_len + dev->vhost_hlen;
+		avail_idx = vq->last_avail_idx;
+		wrap = vq->avail_wrap_counter;
+		num_buffers = 0;
+		vec_idx = 0;
+
+		/* reserve the buffers, one unless mergeable */
+		while (size > 0) {
+			if (!desc_is_avail(&vq->desc_packed[avail_idx], wrap) ||
+			    (num_buffers > 0 && !mergeable) ||
+			    num_buffers >= vq->size)
+				goto rollback;
+			rte_smp_rmb();
+
+			if (unlikely(fetch_packed_chain(dev, vq, avail_idx,
+					descs, &nr_descs, &nr_slots,
+					&buf_id) < 0))
+				goto rollback;
+
+			len = 0;
+			for (i = 0; i < nr_descs; i++, vec_idx++) {
+				if (unlikely(vec_idx >= BUF_VECTOR_MAX))
+					goto rollback;
+				buf_vec[vec_idx].buf_addr = descs[i].addr;
+				buf_vec[vec_idx].buf_len = descs[i].len;
+				buf_vec[vec_idx].desc_idx = i;
+				len += descs[i].len;
+			}
+			len = RTE_MIN(len, size);
+
+			elem = &vq->shadow_used_packed[vq->shadow_used_idx++];
+			elem->id = buf_id;
+			elem->len = len;
+			elem->count = nr_slots;
+			num_buffers++;
+			size -= len;
+
+			avail_idx += nr_slots;
+			if (avail_idx >= vq->size) {
+				avail_idx -= vq->size;
+				wrap ^= 1;
+			}
+		}
+
+		if (copy_mbuf_to_desc_mergeable(dev, pkts[pkt_idx],
+						buf_vec, num_buffers, NULL) < 0)
+			goto rollback;
+
+		vq->last_avail_idx = avail_idx;
+		vq->avail_wrap_counter = wrap;
+		continue;
+
+rollback:
+		LOG_DEBUG(VHOST_DATA,
+			"(%d) failed to get enough desc from vring\n",
+			dev->vid);
+		vq->shadow_used_idx -= num_buffers;
+		break;
+	}
+
+	if (likely(vq->shadow_used_idx)) {
+		flush_shadow_used_ring_packed(vq);
+		vhost_vring_call_packed(vq);
+	}
+
+	return pkt_idx;
+}
+
 uint16_t
 rte_vhost_enqueue_burst(int vid, uint16_t queue_id,
 	struct rte_mbuf **pkts, uint16_t count)
@@ -618,7 +962,9 @@ rte_vhost_enqueue_burst(int vid, uint16_t queue_id,
 	if (!dev)
 		return 0;
 
-	if (dev->features & (1 << VIRTIO_NET_F_MRG_RXBUF))
+	if (vq_is_packed(dev))
+		return virtio_dev_rx_packed(dev, queue_id, pkts, count);
+	else if (dev->features & (1 << VIRTIO_NET_F_MRG_RXBUF))
 		return virtio_dev_merge_rx(dev, queue_id, pkts, count);
 	else
 		return virtio_dev_rx(dev, queue_id, pkts, count);
@@ -778,7 +1124,8 @@ put_zmbuf(struct zcopy_mbuf *zmbuf)
 static inline int __attribute__((always_inline))
 copy_desc_to_mbuf(struct virtio_net *dev, struct vring_desc *descs,
 		  uint16_t max_desc, struct rte_mbuf *m, uint16_t desc_idx,
-		  struct rte_mempool *mbuf_pool)
+		  struct rte_mempool *mbuf_pool, int zero_copy,
+		  struct async_iov_iter *it)
 {
 	struct vring_desc *desc;
 	uint64_t desc_addr;
@@ -843,7 +1190,7 @@ copy_desc_to_mbuf(struct virtio_net *dev, struct vring_desc *descs,
 		 * not continuous. In such case (gpa_to_hpa returns 0), data
 		 * will be copied even though zero copy is enabled.
 		 */
-		if (unlikely(dev->dequeue_zero_copy && (hpa = gpa_to_hpa(dev,
+		if (unlikely(zero_copy && (hpa = gpa_to_hpa(dev,
 					desc->addr + desc_offset, cpy_len)))) {
 			cur->data_len = cpy_len;
 			cur->data_off = 0;
@@ -855,6 +1202,13 @@ copy_desc_to_mbuf(struct virtio_net *dev, struct vring_desc *descs,
 			 * for one or partial of one desc buff.
 			 */
 			mbuf_avail = cpy_len;
+		} else if (it) {
+			if (unlikely(async_iov_add(it,
+				rte_pktmbuf_mtod_offset(cur, void *,
+							mbuf_offset),
+				(void *)((uintptr_t)(desc_addr + desc_offset)),
+				cpy_len) < 0))
+				return -1;
 		} else {
 			rte_memcpy(rte_pktmbuf_mtod_offset(cur, void *,
 							   mbuf_offset),
@@ -917,7 +1271,10 @@ copy_desc_to_mbuf(struct virtio_net *dev, struct vring_desc *descs,
 	prev->data_len = mbuf_offset;
 	m->pkt_len    += mbuf_offset;
 
-	if (hdr)
+	/* The offload parses the packet, once the copies are completed */
+	if (it)
+		it->hdr = hdr;
+	else if (hdr)
 		vhost_dequeue_offload(hdr, m);
 
 	return 0;
@@ -997,6 +1354,62 @@ mbuf_is_consumed(struct rte_mbuf *m)
 	return true;
 }
 
+static inline uint16_t __attribute__((always_inline))
+virtio_dev_tx_packed(struct virtio_net *dev, struct vhost_virtqueue *vq,
+	struct rte_mempool *mbuf_pool, struct rte_mbuf **pkts, uint16_t count)
+{
+	struct vring_used_elem_packed *elem;
+	struct vring_desc descs[BUF_VECTOR_MAX];
+	uint16_t nr_descs, nr_slots, buf_id;
+	uint16_t i;
+	int err;
+
+	count = RTE_MIN(count, MAX_PKT_BURST);
+	vq->shadow_used_idx = 0;
+	for (i = 0; i < count; i++) {
+		if (!desc_is_avail(&vq->desc_packed[vq->last_avail_idx],
+				   vq->avail_wrap_counter))
+			break;
+		rte_smp_rmb();
+
+		if (unlikely(fetch_packed_chain(dev, vq, vq->last_avail_idx,
+				descs, &nr_descs, &nr_slots, &buf_id) < 0))
+			break;
+
+		pkts[i] = rte_pktmbuf_alloc(mbuf_pool);
+		if (unlikely(pkts[i] == NULL)) {
+			RTE_LOG(ERR, VHOST_DATA,
+				"Failed to allocate memory for mbuf.\n");
+			break;
+		}
+
+		err = copy_desc_to_mbuf(dev, descs, nr_descs, pkts[i], 0,
+					mbuf_pool, 0, NULL);
+		if (unlikely(err)) {
+			rte_pktmbuf_free(pkts[i]);
+			break;
+		}
+
+		elem = &vq->shadow_used_packed[vq->shadow_used_idx++];
+		elem->id = buf_id;
+		elem->len = 0;
+		elem->count = nr_slots;
+
+		vq->last_avail_idx += nr_slots;
+		if (vq->last_avail_idx >= vq->size) {
+			vq->last_avail_idx -= vq->size;
+			vq->avail_wrap_counter ^= 1;
+		}
+	}
+
+	if (likely(vq->shadow_used_idx)) {
+		flush_shadow_used_ring_packed(vq);
+		vhost_vring_call_packed(vq);
+	}
+
+	return i;
+}
+
 uint16_t
 rte_vhost_dequeue_burst(int vid, uint16_t queue_id,
 	struct rte_mempool *mbuf_pool, struct rte_mbuf **pkts, uint16_t count)
@@ -1009,6 +1422,9 @@ rte_vhost_dequeue_burst(int vid, uint16_t queue_id,
 	uint32_t i = 0;
 	uint16_t free_entries;
 	uint16_t avail_idx;
+	uint16_t nr_copied = 0;
+	int ring_low = 0;
+	int zero_copy;
 
 	dev = get_device(vid);
 	if (!dev)
@@ -1021,7 +1437,7 @@ rte_vhost_dequeue_burst(int vid, uint16_t queue_id,
 	}
 
 	vq = dev->virtqueue[queue_id];
-	if (unlikely(vq->enabled == 0))
+	if (unlikely(vq->enabled == 0 || vq->async != NULL))
 		return 0;
 
 	if (unlikely(dev->dequeue_zero_copy)) {
@@ -1071,6 +1487,11 @@ rte_vhost_dequeue_burst(int vid, uint16_t queue_id,
 		}
 	}
 
+	if (vq_is_packed(dev)) {
+		i = virtio_dev_tx_packed(dev, vq, mbuf_pool, pkts, count);
+		goto out;
+	}
+
 	free_entries = *((volatile uint16_t *)&vq->avail->idx) -
 			vq->last_avail_idx;
 	if (free_entries == 0)
@@ -1089,6 +1510,15 @@ rte_vhost_dequeue_burst(int vid, uint16_t queue_id,
 	LOG_DEBUG(VHOST_DATA, "(%d) about to dequeue %u buffers\n",
 			dev->vid, count);
 
+	/*
+	 * The guest buffers held by zero copy are not available to the
+	 * guest: copy instead if it is about to run out of free buffers.
+	 */
+	if (unlikely(dev->dequeue_zero_copy))
+		ring_low = vq->nr_zmbuf != 0 && vq->size - free_entries -
+			(uint16_t)(vq->last_avail_idx - vq->last_used_idx) <
+			VHOST_ZCOPY_RING_LOW(vq);
+
 	/* Retrieve all of the head indexes first to avoid caching issues. */
 	for (i = 0; i < count; i++) {
 		avail_idx = (vq->last_avail_idx + i) & (vq->size - 1);
@@ -1131,13 +1561,26 @@ rte_vhost_dequeue_burst(int vid, uint16_t queue_id,
 			break;
 		}
 
-		err = copy_desc_to_mbuf(dev, desc, sz, pkts[i], idx, mbuf_pool);
+		zero_copy = unlikely(dev->dequeue_zero_copy) && !ring_low &&
+			vq->nr_zmbuf < VHOST_ZCOPY_MAX_INFLIGHT(vq);
+
+		err = copy_desc_to_mbuf(dev, desc, sz, pkts[i], idx, mbuf_pool,
+					zero_copy, NULL);
 		if (unlikely(err)) {
 			rte_pktmbuf_free(pkts[i]);
 			break;
 		}
 
-		if (unlikely(dev->dequeue_zero_copy)) {
+		if (unlikely(dev->dequeue_zero_copy && !zero_copy)) {
+			/* copied: give the buffer back at once */
+			used_idx = vq->last_used_idx++ & (vq->size - 1);
+			update_used_ring(dev, vq, used_idx, desc_indexes[i]);
+			nr_copied++;
+			if (ring_low)
+				vq->zcopy_stats.copy_ring_low_pkts++;
+			else
+				vq->zcopy_stats.copy_inflight_pkts++;
+		} else if (unlikely(dev->dequeue_zero_copy)) {
 			struct zcopy_mbuf *zmbuf;
 
 			zmbuf = get_zmbuf(vq);
@@ -1158,6 +1601,7 @@ rte_vhost_dequeue_burst(int vid, uint16_t queue_id,
 
 			vq->nr_zmbuf += 1;
 			TAILQ_INSERT_TAIL(&vq->zmbuf_list, zmbuf, next);
+			vq->zcopy_stats.zcopy_pkts++;
 		}
 	}
 	vq->last_avail_idx += i;
@@ -1165,6 +1609,8 @@ rte_vhost_dequeue_burst(int vid, uint16_t queue_id,
 	if (likely(dev->dequeue_zero_copy == 0)) {
 		vq->last_used_idx += i;
 		update_used_idx(dev, vq, i);
+	} else {
+		update_used_idx(dev, vq, nr_copied);
 	}
 
 out:
@@ -1180,3 +1626,397 @@ rte_vhost_dequeue_burst(int vid, uint16_t queue_id,
 
 	return i;
 }
+
+/*
+ * Asynchronous copies: the guest buffers are reserved and their copies
+ * submitted to the copy engine of the virtqueue, while the used elements
+ * wait in the async rings until the engine reports the copies completed.
+ */
+
+static inline struct vhost_virtqueue *
+async_get_vq(struct virtio_net *dev, uint16_t queue_id, int is_tx,
+	     const char *func)
+{
+	struct vhost_virtqueue *vq;
+
+	if (unlikely(!is_valid_virt_queue_idx(queue_id, is_tx,
+					      dev->virt_qp_nb))) {
+		RTE_LOG(ERR, VHOST_DATA, "(%d) %s: invalid virtqueue idx %d.\n",
+			dev->vid, func, queue_id);
+		return NULL;
+	}
+
+	vq = dev->virtqueue[queue_id];
+	if (unlikely(vq->enabled == 0 || vq->async == NULL))
+		return NULL;
+
+	return vq;
+}
+
+/* Push the submitted packets, and the used elements of the burst. */
+static inline void
+async_push(struct vhost_virtqueue *vq, struct rte_mbuf **pkts,
+	   struct virtio_net_hdr **hdrs, uint16_t *nr_used, uint16_t count)
+{
+	struct vhost_async *async = vq->async;
+	uint16_t mask = async->size - 1;
+	uint16_t slot;
+	uint16_t i;
+
+	for (i = 0; i < count; i++) {
+		slot = (async->pkts_idx + async->pkts_inflight + i) & mask;
+		async->pkts[slot] = pkts[i];
+		async->hdrs[slot] = hdrs ? hdrs[i] : NULL;
+		async->pkts_nr_used[slot] = nr_used[i];
+	}
+	async->pkts_inflight += count;
+
+	for (i = 0; i < vq->shadow_used_idx; i++) {
+		slot = (async->used_idx + async->used_inflight + i) & mask;
+		async->used[slot] = vq->shadow_used_ring[i];
+	}
+	async->used_inflight += vq->shadow_used_idx;
+}
+
+/*
+ * Pop the packets whose copies are completed, and give their buffers back
+ * to the guest, in order.
+ */
+static uint16_t
+async_poll_completed(struct virtio_net *dev, struct vhost_virtqueue *vq,
+		     struct rte_mbuf **pkts, uint16_t count)
+{
+	struct vhost_async *async = vq->async;
+	uint16_t mask = async->size - 1;
+	uint16_t nr_used = 0;
+	uint16_t from, to;
+	uint16_t i;
+	int32_t n;
+
+	count = RTE_MIN(count, async->pkts_inflight);
+	if (count == 0)
+		return 0;
+
+	n = async->ops.check_completed_copies(async->priv, count);
+	if (n <= 0)
+		return 0;
+	n = RTE_MIN(n, count);
+
+	for (i = 0; i < n; i++) {
+		from = (async->pkts_idx + i) & mask;
+		pkts[i] = async->pkts[from];
+		nr_used += async->pkts_nr_used[from];
+		if (async->hdrs[from])
+			vhost_dequeue_offload(async->hdrs[from], pkts[i]);
+	}
+	async->pkts_idx += n;
+	async->pkts_inflight -= n;
+
+	for (i = 0; i < nr_used; i++) {
+		from = (async->used_idx + i) & mask;
+		to = (vq->last_used_idx + i) & mask;
+		vq->used->ring[to] = async->used[from];
+		vhost_log_used_vring(dev, vq,
+				offsetof(struct vring_used, ring[to]),
+				sizeof(vq->used->ring[to]));
+	}
+	async->used_idx += nr_used;
+	async->used_inflight -= nr_used;
+	vq->last_used_idx += nr_used;
+
+	rte_smp_wmb();
+
+	*(volatile uint16_t *)&vq->used->idx += nr_used;
+	vhost_log_used_vring(dev, vq, offsetof(struct vring_used, idx),
+		sizeof(vq->used->idx));
+
+	/* flush used->idx update before we read avail->flags. */
+	rte_mb();
+
+	/* Kick the guest if necessary. */
+	if (!(vq->avail->flags & VRING_AVAIL_F_NO_INTERRUPT)
+			&& (vq->callfd >= 0))
+		eventfd_write(vq->callfd, (eventfd_t)1);
+
+	return n;
+}
+
+uint16_t
+rte_vhost_submit_enqueue_burst(int vid, uint16_t queue_id,
+	struct rte_mbuf **pkts, uint16_t count)
+{
+	struct virtio_net *dev = get_device(vid);
+	struct vhost_virtqueue *vq;
+	struct vhost_async *async;
+	struct buf_vector buf_vec[BUF_VECTOR_MAX];
+	struct rte_vhost_async_job jobs[MAX_PKT_BURST];
+	uint16_t nr_used[MAX_PKT_BURST];
+	struct async_iov_iter it;
+	uint16_t num_buffers;
+	uint16_t avail_head;
+	uint16_t pkt_idx;
+	uint16_t start;
+	int mergeable;
+	int32_t n;
+
+	if (!dev)
+		return 0;
+
+	vq = async_get_vq(dev, queue_id, 0, __func__);
+	if (vq == NULL)
+		return 0;
+	async = vq->async;
+
+	count = RTE_MIN((uint16_t)MAX_PKT_BURST, count);
+	count = RTE_MIN(count, (uint16_t)(async->size - async->pkts_inflight));
+	if (count == 0)
+		return 0;
+
+	mergeable = !!(dev->features & (1 << VIRTIO_NET_F_MRG_RXBUF));
+	it.iov = async->iov;
+	it.nr_iov = 0;
+	it.max_iov = VHOST_ASYNC_IOV_MAX;
+
+	rte_prefetch0(&vq->avail->ring[vq->last_avail_idx & (vq->size - 1)]);
+
+	vq->shadow_used_idx = 0;
+	avail_head = *((volatile uint16_t *)&vq->avail->idx);
+	for (pkt_idx = 0; pkt_idx < count; pkt_idx++) {
+		uint32_t pkt_len = pkts[pkt_idx]->pkt_len + dev->vhost_hlen;
+
+		if (unlikely(reserve_avail_buf_mergeable(dev, vq,
+						pkt_len, buf_vec, &num_buffers,
+						avail_head) < 0 ||
+			     (!mergeable && num_buffers > 1))) {
+			vq->shadow_used_idx -= num_buffers;
+			break;
+		}
+
+		start = it.nr_iov;
+		if (copy_mbuf_to_desc_mergeable(dev, pkts[pkt_idx], buf_vec,
+						num_buffers, &it) < 0) {
+			vq->shadow_used_idx -= num_buffers;
+			it.nr_iov = start;
+			break;
+		}
+
+		jobs[pkt_idx].iov = &it.iov[start];
+		jobs[pkt_idx].nr_iov = it.nr_iov - start;
+		nr_used[pkt_idx] = num_buffers;
+		vq->last_avail_idx += num_buffers;
+	}
+
+	if (pkt_idx == 0)
+		return 0;
+
+	n = async->ops.transfer_data(async->priv, jobs, pkt_idx);
+	if (unlikely(n < 0))
+		n = 0;
+	n = RTE_MIN(n, pkt_idx);
+
+	/* Give back the buffers of the jobs the engine did not accept */
+	while (pkt_idx > n) {
+		pkt_idx--;
+		vq->last_avail_idx -= nr_used[pkt_idx];
+		vq->shadow_used_idx -= nr_used[pkt_idx];
+	}
+
+	async_push(vq, pkts, NULL, nr_used, n);
+
+	return n;
+}
+
+uint16_t
+rte_vhost_poll_enqueue_completed(int vid, uint16_t queue_id,
+	struct rte_mbuf **pkts, uint16_t count)
+{
+	struct virtio_net *dev = get_device(vid);
+	struct vhost_virtqueue *vq;
+
+	if (!dev)
+		return 0;
+
+	vq = async_get_vq(dev, queue_id, 0, __func__);
+	if (vq == NULL)
+		return 0;
+
+	return async_poll_completed(dev, vq, pkts, count);
+}
+
+uint16_t
+rte_vhost_submit_dequeue_burst(int vid, uint16_t queue_id,
+	struct rte_mempool *mbuf_pool, uint16_t count)
+{
+	struct virtio_net *dev = get_device(vid);
+	struct vhost_virtqueue *vq;
+	struct vhost_async *async;
+	struct rte_mbuf *pkts[MAX_PKT_BURST];
+	struct virtio_net_hdr *hdrs[MAX_PKT_BURST];
+	struct rte_vhost_async_job jobs[MAX_PKT_BURST];
+	uint16_t nr_used[MAX_PKT_BURST];
+	struct async_iov_iter it;
+	uint16_t free_entries;
+	uint16_t head_idx;
+	uint16_t start;
+	uint16_t i;
+	int32_t n;
+
+	if (!dev)
+		return 0;
+
+	vq = async_get_vq(dev, queue_id, 1, __func__);
+	if (vq == NULL)
+		return 0;
+	async = vq->async;
+
+	free_entries = *((volatile uint16_t *)&vq->avail->idx) -
+			vq->last_avail_idx;
+	count = RTE_MIN(count, (uint16_t)MAX_PKT_BURST);
+	count = RTE_MIN(count, free_entries);
+	count = RTE_MIN(count, (uint16_t)(async->size - async->pkts_inflight));
+	if (count == 0)
+		return 0;
+
+	it.iov = async->iov;
+	it.nr_iov = 0;
+	it.max_iov = VHOST_ASYNC_IOV_MAX;
+
+	vq->shadow_used_idx = 0;
+	for (i = 0; i < count; i++) {
+		struct vring_desc *desc;
+		uint16_t sz, idx;
+		int err;
+
+		head_idx = vq->avail->ring[(vq->last_avail_idx + i) &
+					   (vq->size - 1)];
+		if (vq->desc[head_idx].flags & VRING_DESC_F_INDIRECT) {
+			desc = (struct vring_desc *)(uintptr_t)gpa_to_vva(dev,
+					vq->desc[head_idx].addr);
+			if (unlikely(!desc))
+				break;
+
+			rte_prefetch0(desc);
+			sz = vq->desc[head_idx].len / sizeof(*desc);
+			idx = 0;
+		} else {
+			desc = vq->desc;
+			sz = vq->size;
+			idx = head_idx;
+		}
+
+		pkts[i] = rte_pktmbuf_alloc(mbuf_pool);
+		if (unlikely(pkts[i] == NULL)) {
+			RTE_LOG(ERR, VHOST_DATA,
+				"Failed to allocate memory for mbuf.\n");
+			break;
+		}
+
+		start = it.nr_iov;
+		err = copy_desc_to_mbuf(dev, desc, sz, pkts[i], idx, mbuf_pool,
+					0, &it);
+		if (unlikely(err)) {
+			rte_pktmbuf_free(pkts[i]);
+			it.nr_iov = start;
+			break;
+		}
+
+		jobs[i].iov = &it.iov[start];
+		jobs[i].nr_iov = it.nr_iov - start;
+		hdrs[i] = it.hdr;
+		nr_used[i] = 1;
+		update_shadow_used_ring(vq, head_idx, 0);
+	}
+
+	if (i == 0)
+		return 0;
+
+	n = async->ops.transfer_data(async->priv, jobs, i);
+	if (unlikely(n < 0))
+		n = 0;
+	n = RTE_MIN(n, i);
+
+	/* Drop the packets the engine did not accept */
+	while (i > n) {
+		i--;
+		rte_pktmbuf_free(pkts[i]);
+		vq->shadow_used_idx--;
+	}
+
+	vq->last_avail_idx += n;
+	async_push(vq, pkts, hdrs, nr_used, n);
+
+	return n;
+}
+
+uint16_t
+rte_vhost_poll_dequeue_completed(int vid, uint16_t queue_id,
+	struct rte_mbuf **pkts, uint16_t count)
+{
+	struct virtio_net *dev = get_device(vid);
+	struct vhost_virtqueue *vq;
+
+	if (!dev)
+		return 0;
+
+	vq = async_get_vq(dev, queue_id, 1, __func__);
+	if (vq == NULL)
+		return 0;
+
+	return async_poll_completed(dev, vq, pkts, count);
+}
+
+/*
+ * Wait for the copies in flight on a stopped virtqueue, and give their
+ * buffers back to the guest. The mbufs of the packets are freed.
+ * If the copy engine does not complete them in time, the packets in flight
+ * are dropped: their mbufs are freed and their guest buffers are left
+ * unused, to be made available again from the vring base. Return -1 then.
+ */
+int
+vhost_async_drain(struct virtio_net *dev, struct vhost_virtqueue *vq)
+{
+	struct vhost_async *async = vq->async;
+	struct rte_mbuf *pkts[MAX_PKT_BURST];
+	uint64_t hz = rte_get_timer_hz();
+	uint64_t start = rte_get_timer_cycles();
+	uint64_t now;
+	uint16_t mask = async->size - 1;
+	uint16_t n, i;
+	int warned = 0;
+
+	while (async->pkts_inflight) {
+		n = async_poll_completed(dev, vq, pkts, MAX_PKT_BURST);
+		for (i = 0; i < n; i++)
+			rte_pktmbuf_free(pkts[i]);
+
+		if (n != 0)
+			continue;
+
+		now = rte_get_timer_cycles();
+		if (now - start > hz * VHOST_ASYNC_DRAIN_TIMEOUT_MS / 1000)
+			break;
+		if (!warned && now - start > hz) {
+			RTE_LOG(WARNING, VHOST_DATA,
+				"(%d) waiting for %u copies in flight\n",
+				dev->vid, async->pkts_inflight);
+			warned = 1;
+		}
+		rte_pause();
+	}
+
+	if (async->pkts_inflight == 0)
+		return 0;
+
+	RTE_LOG(ERR, VHOST_DATA,
+		"(%d) copy engine stalled, dropping %u packets in flight\n",
+		dev->vid, async->pkts_inflight);
+	for (i = 0; i < async->pkts_inflight; i++)
+		rte_pktmbuf_free(async->pkts[(async->pkts_idx + i) & mask]);
+	async->pkts_idx += async->pkts_inflight;
+	async->pkts_inflight = 0;
+	vq->last_avail_idx -= async->used_inflight;
+	async->used_idx += async->used_inflight;
+	async->used_inflight = 0;
+
+	return -1;
+}